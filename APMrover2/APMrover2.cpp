@@ -38,40 +38,37 @@ Rover rover;
 #define SCHED_TASK(func, _interval_ticks, _max_time_micros) SCHED_TASK_CLASS(Rover, &rover, func, _interval_ticks, _max_time_micros)
 
 /*
-  scheduler table - all regular tasks should be listed here, along
-  with how often they should be called (in 20ms units) and the maximum
-  time they are expected to take (in microseconds)
+  scheduler table - all regular tasks apart from the fast_loop()
+  should be listed here, along with how often they should be called
+  (in hz) and the maximum time they are expected to take (in
+  microseconds)
 */
 const AP_Scheduler::Task Rover::scheduler_tasks[] = {
-    SCHED_TASK(read_radio,             50,   1000),
-    SCHED_TASK(ahrs_update,            50,   6400),
-    SCHED_TASK(read_sonars,            50,   2000),
-    SCHED_TASK(update_current_mode,    50,   1500),
-    SCHED_TASK(set_servos,             50,   1500),
-    SCHED_TASK(update_GPS_50Hz,        50,   2500),
-    SCHED_TASK(update_GPS_10Hz,        10,   2500),
-    SCHED_TASK(update_alt,             10,   3400),
-    SCHED_TASK(navigate,               10,   1600),
-    SCHED_TASK(update_compass,         10,   2000),
-    SCHED_TASK(update_commands,        10,   1000),
-    SCHED_TASK(update_logging1,        10,   1000),
-    SCHED_TASK(update_logging2,        10,   1000),
-    SCHED_TASK(gcs_retry_deferred,     50,   1000),
-    SCHED_TASK(gcs_update,             50,   1700),
-    SCHED_TASK(gcs_data_stream_send,   50,   3000),
-    SCHED_TASK(read_control_switch,     7,   1000),
-    SCHED_TASK(read_trim_switch,       10,   1000),
-    SCHED_TASK(read_battery,           10,   1000),
-    SCHED_TASK(read_receiver_rssi,     10,   1000),
-    SCHED_TASK(update_events,          50,   1000),
-    SCHED_TASK(check_usb_mux,           3,   1000),
-    SCHED_TASK(mount_update,           50,    600),
-    SCHED_TASK(update_trigger,         50,    600),
-    SCHED_TASK(gcs_failsafe_check,     10,    600),
-    SCHED_TASK(compass_accumulate,     50,    900),
-    SCHED_TASK(update_notify,          50,    300),
-    SCHED_TASK(one_second_loop,         1,   3000),
-    SCHED_TASK(compass_cal_update,     50,    100), 
+    SCHED_TASK(read_radio,             50,    200),
+    SCHED_TASK(read_sonars,            50,    200),
+    SCHED_TASK(update_GPS_50Hz,        50,    300),
+    SCHED_TASK(update_GPS_10Hz,        10,    300),
+    SCHED_TASK(update_alt,             10,    200),
+    SCHED_TASK(navigate,               10,    600),
+    SCHED_TASK(update_compass,         10,    200),
+    SCHED_TASK(update_commands,        10,    200),
+    SCHED_TASK(update_logging1,        10,    300),
+    SCHED_TASK(update_logging2,        10,    300),
+    SCHED_TASK(gcs_retry_deferred,     50,    550),
+    SCHED_TASK(gcs_update,             50,    500),
+    SCHED_TASK(gcs_data_stream_send,   50,    550),
+    SCHED_TASK(read_control_switch,     7,    100),
+    SCHED_TASK(read_trim_switch,       10,    100),
+    SCHED_TASK(read_battery,           10,    100),
+    SCHED_TASK(read_receiver_rssi,     10,    100),
+    SCHED_TASK(update_events,          50,    100),
+    SCHED_TASK(check_usb_mux,           3,    100),
+    SCHED_TASK(mount_update,           50,     75),
+    SCHED_TASK(update_trigger,         50,     75),
+    SCHED_TASK(gcs_failsafe_check,     10,     75),
+    SCHED_TASK(update_notify,          50,     90),
+    SCHED_TASK(one_second_loop,         1,   1500),
+    SCHED_TASK(compass_cal_update,     50,    100),
     SCHED_TASK(accel_cal_update,       10,    100),
     SCHED_TASK(dataflash_periodic,     50,    300),
     SCHED_TASK(button_update,          5,     100),
@@ -104,6 +101,13 @@ void Rover::setup()
  */
 void Rover::loop()
 {
+    // follow the scheduler when it adapts the loop rate to the load
+    if (ins.get_sample_rate() != scheduler.get_loop_rate_hz()) {
+        update_loop_rate();
+    }
+
+    const uint32_t loop_us = 1000000UL / scheduler.get_loop_rate_hz();
+
     // wait for an INS sample
     ins.wait_for_sample();
 
@@ -118,6 +122,9 @@ void Rover::loop()
 
     mainLoop_count++;
 
+    // run the steering and throttle control at the full loop rate
+    fast_loop();
+
     // tell the scheduler one tick has passed
     scheduler.tick();
 
@@ -126,13 +133,31 @@ void Rover::loop()
     // in multiples of the main loop tick. So if they don't run on
     // the first call to the scheduler they won't run on a later
     // call until scheduler.tick() is called again
-    uint32_t remaining = (timer + 20000) - micros();
-    if (remaining > 19500) {
-        remaining = 19500;
+    uint32_t remaining = (timer + loop_us) - micros();
+    if (remaining > loop_us - 500) {
+        remaining = loop_us - 500;
     }
     scheduler.run(remaining);
 }
 
+// the scheduler has changed the main loop rate, take IMU samples at the new rate
+void Rover::update_loop_rate(void)
+{
+    ins.set_loop_rate(scheduler.get_loop_rate_hz());
+}
+
+/*
+  main loop stages which run on every IMU sample. SCHED_LOOP_RATE
+  sets the rate, so a Linux rover can steer at 200 to 400Hz while
+  the rest of the tasks keep their rates
+ */
+void Rover::fast_loop()
+{
+    ahrs_update();
+    update_current_mode();
+    set_servos();
+}
+
 // update AHRS system
 void Rover::ahrs_update()
 {
@@ -183,10 +208,13 @@ void Rover::update_trigger(void)
 {
 #if CAMERA == ENABLED
     camera.trigger_pic_cleanup();
+    if (camera.check_scheduled_trigger(ahrs, current_loc)) {
+        log_picture();
+    }
     if (camera.check_trigger_pin()) {
         gcs_send_message(MSG_CAMERA_FEEDBACK);
         if (should_log(MASK_LOG_CAMERA)) {
-            DataFlash.Log_Write_Camera(ahrs, gps, current_loc);
+            DataFlash.Log_Write_Camera(ahrs, gps, camera.feedback_location(ahrs, current_loc));
         }
     } 
 #endif
@@ -210,16 +238,6 @@ void Rover::gcs_failsafe_check(void)
     }
 }
 
-/*
-  if the compass is enabled then try to accumulate a reading
- */
-void Rover::compass_accumulate(void)
-{
-    if (g.compass_enabled) {
-        compass.accumulate();
-    }
-}
-
 /*
   check for new compass data - 10Hz
  */
@@ -315,10 +333,15 @@ void Rover::one_second_loop(void)
         if (scheduler.debug() != 0) {
             hal.console->printf("G_Dt_max=%lu\n", (unsigned long)G_Dt_max);
         }
-        if (should_log(MASK_LOG_PM))
+        if (should_log(MASK_LOG_PM)) {
             Log_Write_Performance();
+            DataFlash.Log_Write_Scheduler(scheduler);
+            DataFlash.Log_Write_Perf_Counters();
+            DataFlash.Log_Write_Thread_Stats();
+        }
         G_Dt_max = 0;
         resetPerfData();
+        scheduler.reset_task_stats();
     }
 
     // save compass offsets once a minute
@@ -197,7 +197,7 @@ void Rover::send_extended_status1(mavlink_channel_t chan)
         control_sensors_present,
         control_sensors_enabled,
         control_sensors_health,
-        (uint16_t)(scheduler.load_average(20000) * 1000),
+        (uint16_t)(scheduler.load_average(1000000UL / scheduler.get_loop_rate_hz()) * 1000),
         battery.voltage() * 1000, // mV
         battery_current,        // in 10mA units
         battery_remaining,      // in %
@@ -898,6 +898,10 @@ void GCS_MAVLINK_Rover::handleMessage(mavlink_message_t* msg)
                 result = handle_rc_bind(packet);
                 break;
 
+            case MAV_CMD_SET_MESSAGE_INTERVAL:
+                result = handle_command_set_message_interval(packet);
+                break;
+
             case MAV_CMD_NAV_RETURN_TO_LAUNCH:
                 rover.set_mode(RTL);
                 result = MAV_RESULT_ACCEPTED;
@@ -1518,6 +1522,10 @@ void GCS_MAVLINK_Rover::handleMessage(mavlink_message_t* msg)
         handle_serial_control(msg, rover.gps);
         break;
 
+    case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
+        handle_file_transfer_protocol(msg);
+        break;
+
     case MAVLINK_MSG_ID_GPS_INJECT_DATA:
         handle_gps_inject(msg, rover.gps);
         break;
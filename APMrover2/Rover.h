@@ -384,12 +384,13 @@ private:
 
 private:
     // private member functions
+    void fast_loop();
+    void update_loop_rate(void);
     void ahrs_update();
     void mount_update(void);
     void update_trigger(void);    
     void update_alt();
     void gcs_failsafe_check(void);
-    void compass_accumulate(void);
     void compass_cal_update(void);
     void update_compass(void);
     void update_logging1(void);
@@ -440,11 +440,11 @@ void Rover::log_picture()
     if (!camera.using_feedback_pin()) {
         gcs_send_message(MSG_CAMERA_FEEDBACK);
         if (should_log(MASK_LOG_CAMERA)) {
-            DataFlash.Log_Write_Camera(ahrs, gps, current_loc);
+            DataFlash.Log_Write_Camera(ahrs, gps, camera.trigger_location(ahrs, current_loc));
         }
     } else {
         if (should_log(MASK_LOG_CAMERA)) {
-            DataFlash.Log_Write_Trigger(ahrs, gps, current_loc);
+            DataFlash.Log_Write_Trigger(ahrs, gps, camera.trigger_location(ahrs, current_loc));
         }      
     }
 }
@@ -37,8 +37,6 @@ const AP_Scheduler::Task Tracker::scheduler_tasks[] = {
     SCHED_TASK(update_barometer,       10,   1500),
     SCHED_TASK(gcs_update,             50,   1700),
     SCHED_TASK(gcs_data_stream_send,   50,   3000),
-    SCHED_TASK(compass_accumulate,     50,   1500),
-    SCHED_TASK(barometer_accumulate,   50,    900),
     SCHED_TASK(ten_hz_logging_loop,    10,    300),
     SCHED_TASK(dataflash_periodic,     50,    300),
     SCHED_TASK(update_notify,          50,    100),
@@ -857,6 +857,10 @@ mission_failed:
         handle_serial_control(msg, tracker.gps);
         break;
 
+    case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
+        handle_file_transfer_protocol(msg);
+        break;
+
     case MAVLINK_MSG_ID_GPS_INJECT_DATA:
         handle_gps_inject(msg, tracker.gps);
         break;
@@ -66,6 +66,7 @@
 #include "defines.h"
 
 #include "Parameters.h"
+#include "target_estimator.h"
 #include "GCS_Mavlink.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -157,6 +158,9 @@ private:
         int32_t relative_alt;	// the vehicle's relative altitude in meters * 100
     } vehicle;
 
+    // predicts the vehicle position between telemetry updates
+    TargetEstimator target_estimator;
+
     // Navigation controller state
     struct {
         float bearing;                  // bearing to vehicle in centi-degrees
@@ -217,9 +221,7 @@ private:
     void update_barometer(void);
     void update_ahrs();
     void update_compass(void);
-    void compass_accumulate(void);
     void accel_cal_update(void);
-    void barometer_accumulate(void);
     void update_GPS(void);
     void init_servos();
     void update_pitch_servo(float pitch);
@@ -5,7 +5,6 @@
 void Tracker::read_radio()
 {
     if (hal.rcin->new_input()) {
-        channel_yaw.set_pwm(hal.rcin->read(CH_YAW));
-        channel_pitch.set_pwm(hal.rcin->read(CH_PITCH));
+        RC_Channel::set_pwm_all();
     }
 }
@@ -46,24 +46,6 @@ void Tracker::update_compass(void)
     }
 }
 
-/*
-  if the compass is enabled then try to accumulate a reading
- */
-void Tracker::compass_accumulate(void)
-{
-    if (g.compass_enabled) {
-        compass.accumulate();
-    }    
-}
-
-/*
-  try to accumulate a baro reading
- */
-void Tracker::barometer_accumulate(void)
-{
-    barometer.accumulate();
-}
-
 /*
  calibrate compass
 */
@@ -0,0 +1,140 @@
+#include "target_estimator.h"
+#include "config.h"
+
+// white jerk noise density of the target in (m/s^3)^2/Hz
+#define TARGET_EST_JERK_NOISE   10.0f
+// variance of the reported position (m^2) and velocity ((m/s)^2)
+#define TARGET_EST_POS_VAR      1.0f
+#define TARGET_EST_VEL_VAR      0.1f
+// initial acceleration variance in (m/s/s)^2
+#define TARGET_EST_ACCEL_VAR    4.0f
+// longest the acceleration is extrapolated for, in seconds
+#define TARGET_EST_ACCEL_TIME   1.0f
+// allowed rate at which the two clocks drift apart, ms per report
+#define TARGET_EST_CLOCK_DRIFT  1
+// a clock offset change larger than this means the vehicle rebooted
+#define TARGET_EST_CLOCK_RESET_MS 5000
+
+void TargetEstimator::reset()
+{
+    initialised = false;
+    state_time_us = 0;
+    min_clock_offset_ms = 0;
+    jitter_ms = 0;
+}
+
+/*
+  move one axis forward by dt seconds
+ */
+void TargetEstimator::predict_axis(struct axis &a, float dt) const
+{
+    const float dt2 = dt * dt;
+    const Matrix3f F(1, dt, 0.5f * dt2,
+                     0, 1,  dt,
+                     0, 0,  1);
+    a.x = F * a.x;
+
+    const float q = TARGET_EST_JERK_NOISE;
+    const float dt3 = dt2 * dt;
+    const float dt4 = dt3 * dt;
+    const float dt5 = dt4 * dt;
+    const Matrix3f Q(q * dt5 / 20, q * dt4 / 8, q * dt3 / 6,
+                     q * dt4 / 8,  q * dt3 / 3, q * dt2 / 2,
+                     q * dt3 / 6,  q * dt2 / 2, q * dt);
+    a.P = F * a.P * F.transposed() + Q;
+}
+
+/*
+  fuse a measurement of state idx with variance R
+ */
+void TargetEstimator::fuse(struct axis &a, uint8_t idx, float z, float R) const
+{
+    const float S = a.P[idx][idx] + R;
+    if (S <= 0) {
+        return;
+    }
+    const Vector3f K = Vector3f(a.P[0][idx], a.P[1][idx], a.P[2][idx]) / S;
+    const float innovation = z - a.x[idx];
+    a.x += K * innovation;
+
+    const Vector3f Prow = Vector3f(a.P[idx][0], a.P[idx][1], a.P[idx][2]);
+    for (uint8_t i=0; i<3; i++) {
+        a.P[i] -= Prow * K[i];
+    }
+}
+
+void TargetEstimator::update(const Location &loc, const Vector3f &vel_ned,
+                             uint32_t time_boot_ms, uint32_t now_us)
+{
+    // the report with the shortest link delay gives the smallest
+    // clock offset. Let the minimum creep up slowly so clock drift
+    // does not build up into a false delay
+    const int64_t clock_offset_ms = (int64_t)(now_us / 1000) - time_boot_ms;
+    if (!initialised ||
+        llabs(clock_offset_ms - min_clock_offset_ms) > TARGET_EST_CLOCK_RESET_MS) {
+        min_clock_offset_ms = clock_offset_ms;
+    } else {
+        min_clock_offset_ms = MIN(min_clock_offset_ms + TARGET_EST_CLOCK_DRIFT, clock_offset_ms);
+    }
+    jitter_ms = clock_offset_ms - min_clock_offset_ms;
+
+    // the time the report was valid at, on the local clock
+    const uint32_t report_time_us = now_us - jitter_ms * 1000;
+    const float dt = (int32_t)(report_time_us - state_time_us) * 1.0e-6f;
+
+    if (initialised && dt > TRACKING_TIMEOUT_SEC) {
+        initialised = false;
+    }
+
+    if (!initialised) {
+        origin = loc;
+        for (uint8_t i=0; i<3; i++) {
+            axes[i].x = Vector3f(0, vel_ned[i], 0);
+            axes[i].P = Matrix3f(TARGET_EST_POS_VAR, 0, 0,
+                                 0, TARGET_EST_VEL_VAR, 0,
+                                 0, 0, TARGET_EST_ACCEL_VAR);
+        }
+        state_time_us = report_time_us;
+        initialised = true;
+        return;
+    }
+
+    const Vector2f ne = location_diff(origin, loc);
+    const Vector3f pos_ned(ne.x, ne.y, (origin.alt - loc.alt) * 0.01f);
+
+    for (uint8_t i=0; i<3; i++) {
+        if (dt > 0) {
+            predict_axis(axes[i], dt);
+        }
+        fuse(axes[i], 0, pos_ned[i], TARGET_EST_POS_VAR);
+        fuse(axes[i], 1, vel_ned[i], TARGET_EST_VEL_VAR);
+    }
+    if (dt > 0) {
+        state_time_us = report_time_us;
+    }
+}
+
+bool TargetEstimator::predict(uint32_t now_us, Location &loc) const
+{
+    if (!initialised) {
+        return false;
+    }
+    const float dt = MAX((int32_t)(now_us - state_time_us) * 1.0e-6f, 0.0f);
+    if (dt > TRACKING_TIMEOUT_SEC) {
+        return false;
+    }
+
+    // hold the acceleration for a limited time, then coast at the
+    // velocity it reached
+    const float dt_accel = MIN(dt, TARGET_EST_ACCEL_TIME);
+    Vector3f pos_ned;
+    for (uint8_t i=0; i<3; i++) {
+        const Vector3f &x = axes[i].x;
+        pos_ned[i] = x[0] + x[1] * dt + x[2] * dt_accel * (dt - 0.5f * dt_accel);
+    }
+
+    loc = origin;
+    location_offset(loc, pos_ned.x, pos_ned.y);
+    loc.alt = origin.alt - pos_ned.z * 100.0f;
+    return true;
+}
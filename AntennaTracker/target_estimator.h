@@ -0,0 +1,49 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+  estimate of the tracked vehicle's position between telemetry
+  updates. Each NED axis has a constant acceleration Kalman filter
+  fusing the position and velocity the vehicle reports. Link jitter is
+  removed by timing each report against the vehicle's boot clock, so
+  that the 50Hz tracking loop can extrapolate the target to the
+  present instead of stepping at the telemetry rate
+ */
+class TargetEstimator {
+public:
+    TargetEstimator() { reset(); }
+
+    void reset();
+
+    // fuse a position report. vel_ned is in m/s, time_boot_ms is the
+    // vehicle's timestamp and now_us the local time it was received
+    void update(const Location &loc, const Vector3f &vel_ned,
+                uint32_t time_boot_ms, uint32_t now_us);
+
+    // predict the target location at now_us, returning false if there
+    // is no recent report
+    bool predict(uint32_t now_us, Location &loc) const;
+
+    // current estimate of the extra delay of the last report in ms
+    uint32_t get_jitter_ms() const { return jitter_ms; }
+
+private:
+    struct axis {
+        Vector3f x;             // position, velocity, acceleration
+        Matrix3f P;
+    } axes[3];
+
+    bool initialised;
+    Location origin;            // location axes are relative to
+    uint32_t state_time_us;     // local time the state is valid for
+
+    // smallest difference between local and vehicle clocks seen,
+    // taken as the report with the least link delay
+    int64_t min_clock_offset_ms;
+    uint32_t jitter_ms;
+
+    void predict_axis(struct axis &a, float dt) const;
+    void fuse(struct axis &a, uint8_t idx, float z, float R) const;
+};
@@ -6,17 +6,9 @@
  */
 void Tracker::update_vehicle_pos_estimate()
 {
-    // calculate time since last actual position update
-    float dt = (AP_HAL::micros() - vehicle.last_update_us) * 1.0e-6f;
-
-    // if less than 5 seconds since last position update estimate the position
-    if (dt < TRACKING_TIMEOUT_SEC) {
-        // project the vehicle position to take account of lost radio packets
-        vehicle.location_estimate = vehicle.location;
-        float north_offset = vehicle.vel.x * dt;
-        float east_offset = vehicle.vel.y * dt;
-        location_offset(vehicle.location_estimate, north_offset, east_offset);
-    	vehicle.location_estimate.alt += vehicle.vel.z * 100.0f * dt;
+    // if less than 5 seconds since last position update predict the
+    // position now, allowing for link delay and lost radio packets
+    if (target_estimator.predict(AP_HAL::micros(), vehicle.location_estimate)) {
         // set valid_location flag
         vehicle.location_valid = true;
     } else {
@@ -134,6 +126,7 @@ void Tracker::tracking_update_position(const mavlink_global_position_int_t &msg)
     vehicle.vel = Vector3f(msg.vx/100.0f, msg.vy/100.0f, msg.vz/100.0f);
     vehicle.last_update_us = AP_HAL::micros();
     vehicle.last_update_ms = AP_HAL::millis();
+    target_estimator.update(vehicle.location, vehicle.vel, msg.time_boot_ms, vehicle.last_update_us);
     // log vehicle as GPS2
     if (should_log(MASK_LOG_GPS)) {
         Log_Write_Vehicle_Pos(vehicle.location.lat, vehicle.location.lng, vehicle.location.alt, vehicle.vel);
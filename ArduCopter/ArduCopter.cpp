@@ -74,11 +74,14 @@
 #include "Copter.h"
 
 #define SCHED_TASK(func, rate_hz, max_time_micros) SCHED_TASK_CLASS(Copter, &copter, func, rate_hz, max_time_micros)
+#define SCHED_TASK_WORKER(func, rate_hz, max_time_micros) SCHED_TASK_CLASS_WORKER(Copter, &copter, func, rate_hz, max_time_micros)
 
 /*
   scheduler table for fast CPUs - all regular tasks apart from the fast_loop()
   should be listed here, along with how often they should be called (in hz)
-  and the maximum time they are expected to take (in microseconds)
+  and the maximum time they are expected to take (in microseconds).
+  Tasks listed with SCHED_TASK_WORKER may be run from a worker thread
+  when SCHED_WORKER is enabled
  */
 const AP_Scheduler::Task Copter::scheduler_tasks[] = {
     SCHED_TASK(rc_loop,              100,    130),
@@ -98,8 +101,9 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] = {
     SCHED_TASK(run_nav_updates,       50,    100),
     SCHED_TASK(update_throttle_hover,100,     90),
     SCHED_TASK(three_hz_loop,          3,     75),
-    SCHED_TASK(compass_accumulate,   100,    100),
-    SCHED_TASK(barometer_accumulate,  50,     90),
+#if AUTOTUNE_ENABLED == ENABLED
+    SCHED_TASK_WORKER(autotune_analysis,    100,    150),
+#endif
 #if PRECISION_LANDING == ENABLED
     SCHED_TASK(update_precland,      400,     50),
 #endif
@@ -107,7 +111,7 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] = {
     SCHED_TASK(check_dynamic_flight,  50,     75),
 #endif
     SCHED_TASK(update_notify,         50,     90),
-    SCHED_TASK(one_hz_loop,            1,    100),
+    SCHED_TASK_WORKER(one_hz_loop,            1,    100),
     SCHED_TASK(ekf_check,             10,     75),
     SCHED_TASK(landinggear_update,    10,     75),
     SCHED_TASK(lost_vehicle_check,    10,     50),
@@ -117,13 +121,13 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] = {
     SCHED_TASK(gcs_data_stream_send,  50,    550),
     SCHED_TASK(update_mount,          50,     75),
     SCHED_TASK(update_trigger,        50,     75),
-    SCHED_TASK(ten_hz_logging_loop,   10,    350),
-    SCHED_TASK(twentyfive_hz_logging, 25,    110),
+    SCHED_TASK_WORKER(ten_hz_logging_loop,   10,    350),
+    SCHED_TASK_WORKER(twentyfive_hz_logging, 25,    110),
     SCHED_TASK(dataflash_periodic,    400,    300),
     SCHED_TASK(perf_update,           0.1,    75),
     SCHED_TASK(read_receiver_rssi,    10,     75),
     SCHED_TASK(rpm_update,            10,    200),
-    SCHED_TASK(compass_cal_update,   100,    100),
+    SCHED_TASK_WORKER(compass_cal_update,   100,    100),
     SCHED_TASK(accel_cal_update,      10,    100),
 #if ADSB_ENABLED == ENABLED
     SCHED_TASK(avoidance_adsb_update, 10,    100),
@@ -131,7 +135,7 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] = {
 #if ADVANCED_FAILSAFE == ENABLED
     SCHED_TASK(afs_fs_check,          10,    100),
 #endif
-    SCHED_TASK(terrain_update,        10,    100),
+    SCHED_TASK_WORKER(terrain_update,        10,    100),
 #if EPM_ENABLED == ENABLED
     SCHED_TASK(epm_update,            10,     75),
 #endif
@@ -154,6 +158,25 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] = {
 };
 
 
+#if FAST_LOOP_TRACE == ENABLED
+// names of the traced main loop stages, in FastLoopSpan order
+static const char * const fast_loop_span_names[FAST_LOOP_SPAN_COUNT] = {
+    "fl_ahrs",
+    "fl_rate_ctrl",
+    "fl_heli",
+    "fl_motors",
+    "fl_notch",
+    "fl_inertia",
+    "fl_ekf_reset",
+    "fl_mode",
+    "fl_home",
+    "fl_land",
+    "fl_mount",
+    "fl_health",
+    "fl_sched",
+};
+#endif
+
 void Copter::setup() 
 {
     cliSerial = hal.console;
@@ -171,38 +194,43 @@ void Copter::setup()
 
     // setup initial performance counters
     perf_info_reset();
+#if FAST_LOOP_TRACE == ENABLED
+    loop_trace.init(fast_loop_span_names, FAST_LOOP_SPAN_COUNT);
+#endif
     fast_loopTimer = AP_HAL::micros();
 }
 
-/*
-  if the compass is enabled then try to accumulate a reading
- */
-void Copter::compass_accumulate(void)
-{
-    if (g.compass_enabled) {
-        compass.accumulate();
-    }
-}
-
-/*
-  try to accumulate a baro reading
- */
-void Copter::barometer_accumulate(void)
-{
-    barometer.accumulate();
-}
-
 void Copter::perf_update(void)
 {
-    if (should_log(MASK_LOG_PM))
+    if (should_log(MASK_LOG_PM)) {
         Log_Write_Performance();
+        DataFlash.Log_Write_Scheduler(scheduler);
+        DataFlash.Log_Write_Perf_Counters();
+        DataFlash.Log_Write_Thread_Stats();
+    }
     if (scheduler.debug()) {
         gcs_send_text_fmt(MAV_SEVERITY_WARNING, "PERF: %u/%u %lu %lu\n",
                           (unsigned)perf_info_get_num_long_running(),
                           (unsigned)perf_info_get_num_loops(),
                           (unsigned long)perf_info_get_max_time(),
                           (unsigned long)perf_info_get_min_time());
+        // report tasks which blew their time budget or were skipped
+        for (uint8_t i=0; i<scheduler.get_num_tasks(); i++) {
+            const AP_Scheduler::TaskStats *stats = scheduler.task_stats(i);
+            if (stats == nullptr || (stats->overruns == 0 && stats->skipped == 0)) {
+                continue;
+            }
+            gcs_send_text_fmt(MAV_SEVERITY_WARNING, "SCHED %s %u/%u/%u/%u o%u s%u",
+                              scheduler.task_name(i),
+                              (unsigned)scheduler.task_percentile_us(i, 50),
+                              (unsigned)scheduler.task_percentile_us(i, 99),
+                              (unsigned)stats->max_time_us,
+                              (unsigned)scheduler.task_budget_us(i),
+                              (unsigned)stats->overruns,
+                              (unsigned)stats->skipped);
+        }
     }
+    scheduler.reset_task_stats();
     perf_info_reset();
     pmTest1 = 0;
 }
@@ -212,6 +240,16 @@ void Copter::loop()
     // wait for an INS sample
     ins.wait_for_sample();
 
+    // keep worker tasks off the vehicle state until the scheduler has run
+    scheduler.worker_pause();
+
+    // the flight modes, failsafes, arming and logging below all change
+    // the rate controller and motors, so the rate thread only runs
+    // while the main loop waits for the next sample
+    if (rate_thread_sem != nullptr) {
+        rate_thread_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER);
+    }
+
     uint32_t timer = micros();
 
     // check loop time
@@ -237,52 +275,116 @@ void Copter::loop()
     // the first call to the scheduler they won't run on a later
     // call until scheduler.tick() is called again
     uint32_t time_available = (timer + MAIN_LOOP_MICROS) - micros();
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_SCHEDULER);
     scheduler.run(time_available > MAIN_LOOP_MICROS ? 0u : time_available);
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_SCHEDULER);
+
+    if (rate_thread_sem != nullptr) {
+        rate_thread_sem->give();
+    }
+
+    // let worker tasks use what is left of this loop
+    time_available = (timer + MAIN_LOOP_MICROS) - micros();
+    scheduler.worker_resume(time_available > MAIN_LOOP_MICROS ? 0u : time_available);
 }
 
 
 // Main loop - 400hz
 void Copter::fast_loop()
 {
+    // the rate thread runs the rate controller and motors itself
+    const bool rate_loop_first = g2.rate_loop_first && !rate_thread_active;
+    // only read the gyro ahead of the AHRS when the rate loop runs ahead of it
+    attitude_control.use_gyro_latest(rate_loop_first || rate_thread_active);
+
+    if (rate_loop_first) {
+        // take the new gyro sample now and leave the EKF until the
+        // motors have been written
+        ins.update();
+    } else {
+        // IMU DCM Algorithm
+        // --------------------
+        FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_AHRS);
+        read_AHRS();
+        FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_AHRS);
+    }
 
-    // IMU DCM Algorithm
-    // --------------------
-    read_AHRS();
-
-    // run low level rate controllers that only require IMU data
-    attitude_control.rate_controller_run();
+    if (!rate_thread_active) {
+        // run low level rate controllers that only require IMU data
+        FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_RATE_CONTROLLER);
+        attitude_control.rate_controller_run();
+        FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_RATE_CONTROLLER);
+    }
     
 #if FRAME_CONFIG == HELI_FRAME
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_HELI_DYNAMICS);
     update_heli_control_dynamics();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_HELI_DYNAMICS);
 #endif //HELI_FRAME
 
     // send outputs to the motors library
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_MOTORS);
     motors_output();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_MOTORS);
+
+    if (rate_loop_first) {
+        // the attitude controllers below need the EKF's new attitude
+        FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_AHRS);
+        read_AHRS(true);
+        FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_AHRS);
+    }
+
+    // move the gyro harmonic notch with the motor speed
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_NOTCH);
+    update_dynamic_notch();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_NOTCH);
 
     // Inertial Nav
     // --------------------
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_INERTIA);
     read_inertia();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_INERTIA);
 
     // check if ekf has reset target heading or position
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_EKF_RESET);
     check_ekf_reset();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_EKF_RESET);
 
     // run the attitude controllers
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_FLIGHT_MODE);
     update_flight_mode();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_FLIGHT_MODE);
+
+    if (rate_thread_active) {
+        // throttle mixing and control monitoring; the rate thread picks
+        // up the new rate targets once this loop is done
+        FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_RATE_CONTROLLER);
+        attitude_control.rate_controller_run();
+        FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_RATE_CONTROLLER);
+    }
 
     // update home from EKF if necessary
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_HOME);
     update_home_from_EKF();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_HOME);
 
     // check if we've landed or crashed
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_LAND_DETECTOR);
     update_land_and_crash_detectors();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_LAND_DETECTOR);
 
 #if MOUNT == ENABLED
     // camera mount's fast update
+    FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_MOUNT);
     camera_mount.update_fast();
+    FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_MOUNT);
 #endif
 
     // log sensor health
     if (should_log(MASK_LOG_ANY)) {
+        FAST_LOOP_TRACE_BEGIN(FAST_LOOP_SPAN_SENSOR_HEALTH);
         Log_Sensor_Health();
+        FAST_LOOP_TRACE_END(FAST_LOOP_SPAN_SENSOR_HEALTH);
     }
 }
 
@@ -333,10 +435,13 @@ void Copter::update_trigger(void)
 {
 #if CAMERA == ENABLED
     camera.trigger_pic_cleanup();
+    if (camera.check_scheduled_trigger(ahrs, current_loc)) {
+        log_picture();
+    }
     if (camera.check_trigger_pin()) {
         gcs_send_message(MSG_CAMERA_FEEDBACK);
         if (should_log(MASK_LOG_CAMERA)) {
-            DataFlash.Log_Write_Camera(ahrs, gps, current_loc);
+            DataFlash.Log_Write_Camera(ahrs, gps, camera.feedback_location(ahrs, current_loc));
         }
     }    
 #endif
@@ -375,6 +480,7 @@ void Copter::ten_hz_logging_loop()
             DataFlash.Log_Write_PID(LOG_PIDA_MSG, g.pid_accel_z.get_pid_info() );
         }
     }
+    log_trigger_check();
     if (should_log(MASK_LOG_MOTBATT)) {
         Log_Write_MotBatt();
     }
@@ -392,6 +498,9 @@ void Copter::ten_hz_logging_loop()
     }
     if (should_log(MASK_LOG_IMU) || should_log(MASK_LOG_IMU_FAST) || should_log(MASK_LOG_IMU_RAW)) {
         DataFlash.Log_Write_Vibration(ins);
+#if HAL_INS_FFT_ENABLED
+        DataFlash.Log_Write_GyroFFT(ins);
+#endif
     }
     if (should_log(MASK_LOG_CTUN)) {
         attitude_control.control_monitor_log();
@@ -400,6 +509,11 @@ void Copter::ten_hz_logging_loop()
 #if FRAME_CONFIG == HELI_FRAME
     Log_Write_Heli();
 #endif
+#if FAST_LOOP_TRACE == ENABLED
+    if (should_log(MASK_LOG_PM)) {
+        Log_Write_Loop_Trace();
+    }
+#endif
 }
 
 // twentyfive_hz_logging - should be run at 25hz
@@ -420,11 +534,20 @@ void Copter::twentyfive_hz_logging()
             DataFlash.Log_Write_PID(LOG_PIDY_MSG, attitude_control.get_rate_yaw_pid().get_pid_info());
             DataFlash.Log_Write_PID(LOG_PIDA_MSG, g.pid_accel_z.get_pid_info() );
         }
+    } else if (DataFlash.pretrigger_enabled(DATAFLASH_PRETRIGGER_ATTITUDE)) {
+        // keep attitude and EKF data at this rate for the log trigger
+        DataFlash.set_pretrigger_capture(true);
+        Log_Write_Attitude();
+        DataFlash.set_pretrigger_capture(false);
     }
 
     // log IMU data if we're not already logging at the higher rate
     if (should_log(MASK_LOG_IMU) && !should_log(MASK_LOG_IMU_RAW)) {
         DataFlash.Log_Write_IMU(ins);
+    } else if (!should_log(MASK_LOG_IMU) && DataFlash.pretrigger_enabled(DATAFLASH_PRETRIGGER_IMU)) {
+        DataFlash.set_pretrigger_capture(true);
+        DataFlash.Log_Write_IMU(ins);
+        DataFlash.set_pretrigger_capture(false);
     }
 #endif
 
@@ -453,6 +576,11 @@ void Copter::three_hz_loop()
     fence_check();
 #endif // AC_FENCE_ENABLED
 
+#if AC_RALLY == ENABLED
+    // keep the nearest rally point ready for RTL
+    rally.update(current_loc);
+#endif
+
 #if SPRAYER == ENABLED
     sprayer.update();
 #endif
@@ -603,7 +731,7 @@ void Copter::update_super_simple_bearing(bool force_update)
     }
 }
 
-void Copter::read_AHRS(void)
+void Copter::read_AHRS(bool skip_ins_update)
 {
     // Perform IMU calculations and get attitude info
     //-----------------------------------------------
@@ -612,7 +740,7 @@ void Copter::read_AHRS(void)
     gcs_check_input();
 #endif
 
-    ahrs.update();
+    ahrs.update(skip_ins_update);
 }
 
 // read baro and rangefinder altitude at 10hz
@@ -29,6 +29,7 @@
 
 // Common dependencies
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/AP_Alloc.h>
 #include <AP_Common/Location.h>
 #include <AP_Menu/AP_Menu.h>
 #include <AP_Param/AP_Param.h>
@@ -118,6 +119,15 @@
 #include "afs_copter.h"
 #endif
 
+#if FAST_LOOP_TRACE == ENABLED
+#include <AP_Scheduler/AP_LoopTrace.h>
+ # define FAST_LOOP_TRACE_BEGIN(span) loop_trace.begin(span)
+ # define FAST_LOOP_TRACE_END(span) loop_trace.end(span)
+#else
+ # define FAST_LOOP_TRACE_BEGIN(span)
+ # define FAST_LOOP_TRACE_END(span)
+#endif
+
 // Local modules
 #include "Parameters.h"
 #include "avoidance_adsb.h"
@@ -169,6 +179,9 @@ private:
     // has a log download started?
     bool in_log_download;
 
+    // accelerometer clipping seen by the log trigger check
+    uint32_t log_trigger_clip_count;
+
     // primary input control channels
     RC_Channel *channel_roll;
     RC_Channel *channel_pitch;
@@ -457,6 +470,15 @@ private:
     float baro_climbrate;        // barometer climbrate in cm/s
     LowPassFilterVector3f land_accel_ef_filter; // accelerations for land and crash detector tests
 
+    // windowed statistics of the signals shared by the land and crash
+    // detectors, updated once per main loop
+    typedef WindowStats<DETECTOR_STATS_BLOCKS> DetectorWindow;
+    struct {
+        DetectorWindow accel;       // 1hz filtered earth frame acceleration magnitude (m/s/s)
+        DetectorWindow att_error;   // attitude error angle (deg)
+        DetectorWindow climb_rate;  // absolute inertial climb rate (cm/s)
+    } detector_stats;
+
     // filtered pilot's throttle input used to cancel landing if throttle held high
     LowPassFilterFloat rc_throttle_control_in_filter;
 
@@ -509,6 +531,10 @@ private:
 
     // Performance monitoring
     int16_t pmTest1;
+#if FAST_LOOP_TRACE == ENABLED
+    // time spent in each stage of the main loop
+    AP_LoopTrace loop_trace;
+#endif
 
     // System Timers
     // --------------
@@ -521,6 +547,16 @@ private:
     // arm_time_ms - Records when vehicle was armed. Will be Zero if we are disarmed.
     uint32_t arm_time_ms;
 
+    // rate controller and motor outputs run from their own thread at RATE_THREAD_HZ
+    bool rate_thread_active;
+    // set by motors_output() when the rate thread may write the motors
+    volatile bool rate_thread_output;
+    // held by the main loop while it runs, and by the rate thread while
+    // it runs the rate controller and motors. nullptr without the thread
+    AP_HAL::Semaphore *rate_thread_sem;
+    uint32_t rate_thread_last_us;
+    float rate_thread_dt;
+
     // Used to exit the roll and pitch auto trim function
     uint8_t auto_trim_counter;
 
@@ -634,9 +670,7 @@ private:
     static const AP_Param::Info var_info[];
     static const struct LogStructure log_structure[];
 
-    void compass_accumulate(void);
     void compass_cal_update(void);
-    void barometer_accumulate(void);
     void perf_update(void);
     void fast_loop();
     void rc_loop();
@@ -652,7 +686,7 @@ private:
     void init_simple_bearing();
     void update_simple_mode(void);
     void update_super_simple_bearing(bool force_update);
-    void read_AHRS(void);
+    void read_AHRS(bool skip_ins_update=false);
     void update_altitude();
     void set_home_state(enum HomeState new_home_state);
     bool home_is_set();
@@ -709,6 +743,7 @@ private:
     void send_rangefinder(mavlink_channel_t chan);
     void send_rpm(mavlink_channel_t chan);
     void rpm_update();
+    void update_dynamic_notch();
     void button_update();
     void init_proximity();
     void update_proximity();
@@ -720,12 +755,15 @@ private:
     void gcs_send_text(MAV_SEVERITY severity, const char *str);
     void do_erase_logs(void);
     void Log_Write_AutoTune(uint8_t axis, uint8_t tune_step, float meas_target, float meas_min, float meas_max, float new_gain_rp, float new_gain_rd, float new_gain_sp, float new_ddt);
-    void Log_Write_AutoTuneDetails(float angle_cd, float rate_cds);
+    void Log_Write_AutoTuneDetails(uint64_t time_us, float angle_cd, float rate_cds);
     void Log_Write_Current();
     void Log_Write_Optflow();
     void Log_Write_Nav_Tuning();
     void Log_Write_Control_Tuning();
     void Log_Write_Performance();
+#if FAST_LOOP_TRACE == ENABLED
+    void Log_Write_Loop_Trace();
+#endif
     void Log_Write_Attitude();
     void Log_Write_MotBatt();
     void Log_Write_Event(uint8_t id);
@@ -814,6 +852,8 @@ private:
     bool autotune_start(bool ignore_checks);
     void autotune_run();
     void autotune_attitude_control();
+    void autotune_analysis();
+    void autotune_update_gains();
     void autotune_backup_gains_and_initialise();
     void autotune_load_orig_gains();
     void autotune_load_tuned_gains();
@@ -830,7 +870,7 @@ private:
     void autotune_updating_p_down(float &tune_p, float tune_p_min, float tune_p_step_ratio, float target, float measurement_max);
     void autotune_updating_p_up(float &tune_p, float tune_p_max, float tune_p_step_ratio, float target, float measurement_max);
     void autotune_updating_p_up_d_down(float &tune_d, float tune_d_min, float tune_d_step_ratio, float &tune_p, float tune_p_min, float tune_p_max, float tune_p_step_ratio, float target, float measurement_min, float measurement_max);
-    void autotune_twitching_measure_acceleration(float &rate_of_change, float rate_measurement, float &rate_measurement_max);
+    void autotune_twitching_measure_acceleration(float &rate_of_change, float rate_measurement, float &rate_measurement_max, uint32_t step_ms);
     void avoidance_adsb_update(void);
 #if ADVANCED_FAILSAFE == ENABLED
     void afs_fs_check(void);
@@ -969,6 +1009,9 @@ private:
     void read_inertia();
     bool land_complete_maybe();
     void update_land_and_crash_detectors();
+    void update_detector_stats();
+    uint8_t detector_stats_blocks(float seconds) const;
+    bool land_detector_stationary(float seconds) const;
     void update_land_detector();
     void update_throttle_thr_mix();
     void update_ground_effect_detector(void);
@@ -991,6 +1034,8 @@ private:
     bool arm_checks(bool display_failure, bool arming_from_gcs);
     void init_disarm_motors();
     void motors_output();
+    void init_rate_thread();
+    void rate_thread_update();
     void lost_vehicle_check();
     void run_nav_updates(void);
     void calc_distance_and_bearing();
@@ -1086,6 +1131,7 @@ private:
     bool do_guided(const AP_Mission::Mission_Command& cmd);
     void do_takeoff(const AP_Mission::Mission_Command& cmd);
     void do_nav_wp(const AP_Mission::Mission_Command& cmd);
+    void do_nav_wp_lookahead(const AP_Mission::Mission_Command& cmd, const Location_Class& target_loc);
     void do_land(const AP_Mission::Mission_Command& cmd);
     void do_loiter_unlimited(const AP_Mission::Mission_Command& cmd);
     void do_circle(const AP_Mission::Mission_Command& cmd);
@@ -1124,6 +1170,7 @@ private:
     void auto_spline_start(const Location_Class& destination, bool stopped_at_start, AC_WPNav::spline_segment_end_type seg_end_type, const Location_Class& next_destination);
     void print_flight_mode(AP_HAL::BetterStream *port, uint8_t mode);
     void log_init(void);
+    void log_trigger_check(void);
     void run_cli(AP_HAL::UARTDriver *port);
     void init_capabilities(void);
     void dataflash_periodic(void);
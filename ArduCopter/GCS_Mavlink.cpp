@@ -1206,6 +1206,10 @@ void GCS_MAVLINK_Copter::handleMessage(mavlink_message_t* msg)
             result = handle_rc_bind(packet);
             break;
 
+        case MAV_CMD_SET_MESSAGE_INTERVAL:
+            result = handle_command_set_message_interval(packet);
+            break;
+
         case MAV_CMD_NAV_TAKEOFF: {
             // param3 : horizontal navigation by pilot acceptable
             // param4 : yaw angle   (not supported)
@@ -1974,6 +1978,10 @@ void GCS_MAVLINK_Copter::handleMessage(mavlink_message_t* msg)
         handle_serial_control(msg, copter.gps);
         break;
 
+    case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
+        handle_file_transfer_protocol(msg);
+        break;
+
     case MAVLINK_MSG_ID_GPS_INJECT_DATA:
         handle_gps_inject(msg, copter.gps);
         result = MAV_RESULT_ACCEPTED;
@@ -199,11 +199,11 @@ struct PACKED log_AutoTuneDetails {
 };
 
 // Write an Autotune data packet
-void Copter::Log_Write_AutoTuneDetails(float angle_cd, float rate_cds)
+void Copter::Log_Write_AutoTuneDetails(uint64_t time_us, float angle_cd, float rate_cds)
 {
     struct log_AutoTuneDetails pkt = {
         LOG_PACKET_HEADER_INIT(LOG_AUTOTUNEDETAILS_MSG),
-        time_us     : AP_HAL::micros64(),
+        time_us     : time_us,
         angle_cd    : angle_cd,
         rate_cds    : rate_cds
     };
@@ -794,6 +794,30 @@ void Copter::Log_Write_Proximity()
 #endif
 }
 
+#if FAST_LOOP_TRACE == ENABLED
+struct PACKED log_Loop_Trace {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t loop_us;
+    uint16_t span_us[FAST_LOOP_SPAN_COUNT];
+};
+
+// Write the stage timings of main loops that overran
+void Copter::Log_Write_Loop_Trace()
+{
+    AP_LoopTrace::Frame frame;
+    while (loop_trace.pop(frame)) {
+        struct log_Loop_Trace pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_LOOP_TRACE_MSG),
+            time_us         : frame.start_us,
+            loop_us         : frame.loop_us,
+        };
+        memcpy(pkt.span_us, frame.span_us, sizeof(pkt.span_us));
+        DataFlash.WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+#endif
+
 const struct LogStructure Copter::log_structure[] = {
     LOG_COMMON_STRUCTURES,
 #if AUTOTUNE_ENABLED == ENABLED
@@ -838,6 +862,10 @@ const struct LogStructure Copter::log_structure[] = {
       "THRO",  "QBffffbbbb",  "TimeUS,Stage,Vel,VelZ,Acc,AccEfZ,Throw,AttOk,HgtOk,PosOk" },
     { LOG_PROXIMITY_MSG, sizeof(log_Proximity),
       "PRX",   "QBffffffff",  "TimeUS,Health,D0,D45,D90,D135,D180,D225,D270,D315" },
+#if FAST_LOOP_TRACE == ENABLED
+    { LOG_LOOP_TRACE_MSG, sizeof(log_Loop_Trace),
+      "LTRC",  "QIHHHHHHHHHHHHH", "TimeUS,Loop,Ahr,Rat,Hel,Mot,Nch,Nav,Ekf,Mod,Hom,Lnd,Mnt,Hlt,Sch" },
+#endif
 };
 
 #if CLI_ENABLED == ENABLED
@@ -901,6 +929,22 @@ void Copter::log_init(void)
     }
 }
 
+/*
+  trigger the log when an accelerometer clips, the other triggers are
+  where the event is detected. Called at 10Hz
+ */
+void Copter::log_trigger_check(void)
+{
+    uint32_t clip_count = 0;
+    for (uint8_t i=0; i<ins.get_accel_count(); i++) {
+        clip_count += ins.get_accel_clip_count(i);
+    }
+    if (clip_count > log_trigger_clip_count) {
+        DataFlash.trigger("accel clipping");
+    }
+    log_trigger_clip_count = clip_count;
+}
+
 #else // LOGGING_ENABLED
 
 #if CLI_ENABLED == ENABLED
@@ -916,11 +960,14 @@ void Copter::do_erase_logs(void) {}
 void Copter::Log_Write_AutoTune(uint8_t axis, uint8_t tune_step, float meas_target, \
                                 float meas_min, float meas_max, float new_gain_rp, \
                                 float new_gain_rd, float new_gain_sp, float new_ddt) {}
-void Copter::Log_Write_AutoTuneDetails(float angle_cd, float rate_cds) {}
+void Copter::Log_Write_AutoTuneDetails(uint64_t time_us, float angle_cd, float rate_cds) {}
 void Copter::Log_Write_Current() {}
 void Copter::Log_Write_Nav_Tuning() {}
 void Copter::Log_Write_Control_Tuning() {}
 void Copter::Log_Write_Performance() {}
+#if FAST_LOOP_TRACE == ENABLED
+void Copter::Log_Write_Loop_Trace() {}
+#endif
 void Copter::Log_Write_Attitude(void) {}
 void Copter::Log_Write_MotBatt() {}
 void Copter::Log_Write_Event(uint8_t id) {}
@@ -946,5 +993,6 @@ void Copter::Log_Write_Optflow() {}
 
 void Copter::start_logging() {}
 void Copter::log_init(void) {}
+void Copter::log_trigger_check(void) {}
 
 #endif // LOGGING_ENABLED
@@ -576,6 +576,12 @@ public:
     // acro exponent parameters
     AP_Float acro_y_expo;
     AP_Float acro_thr_mid;
+
+    // run the rate controller before the EKF update
+    AP_Int8 rate_loop_first;
+
+    // rate of the rate controller thread, 0 to run it from the main loop
+    AP_Int16 rate_thread_hz;
 };
 
 extern const AP_Param::Info        var_info[];
@@ -58,6 +58,15 @@ bool Copter::pre_arm_checks(bool display_failure)
         return false;
     }
 
+    // digital ESCs ignore the PWM the motors fall back to when the
+    // board can't produce the MOT_PWM_TYPE output
+    if (motors.pwm_type_unsupported()) {
+        if (display_failure) {
+            gcs_send_text(MAV_SEVERITY_CRITICAL,"PreArm: MOT_PWM_TYPE not supported by board");
+        }
+        return false;
+    }
+
     // exit immediately if we've already successfully performed the pre-arm check
     if (ap.pre_arm_check) {
         // run gps checks because results may change and affect LED colour
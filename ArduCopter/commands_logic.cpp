@@ -331,9 +331,84 @@ void Copter::do_nav_wp(const AP_Mission::Mission_Command& cmd)
     // if no delay set the waypoint as "fast"
     if (loiter_time_max == 0 ) {
         wp_nav.set_fast_waypoint(true);
+        do_nav_wp_lookahead(cmd, target_loc);
     }
 }
 
+// do_nav_wp_lookahead - pass the waypoints following a fast waypoint to the waypoint controller so it can plan the speed through it
+void Copter::do_nav_wp_lookahead(const AP_Mission::Mission_Command& cmd, const Location_Class& target_loc)
+{
+    Location_Class next_locs[WPNAV_LOOKAHEAD_POINTS];
+    uint8_t count = 0;
+    bool stop_at_end = true;
+    Location_Class prev_loc = target_loc;
+    AP_Mission::Mission_Command temp_cmd;
+    uint16_t index = cmd.index+1;
+
+    while (mission.get_next_nav_cmd(index, temp_cmd)) {
+        const bool has_location = temp_cmd.content.location.lat != 0 || temp_cmd.content.location.lng != 0;
+        bool stops_here = false;
+        switch (temp_cmd.id) {
+        case MAV_CMD_NAV_WAYPOINT:
+            stops_here = temp_cmd.p1 != 0;
+            break;
+        case MAV_CMD_NAV_LOITER_UNLIM:
+        case MAV_CMD_NAV_LOITER_TIME:
+        case MAV_CMD_NAV_LAND:
+            if (!has_location) {
+                // these start from the previous waypoint, so the vehicle stops there
+                wp_nav.set_wp_lookahead(next_locs, count, true);
+                return;
+            }
+            // flown to in a straight line and stopped at
+            stops_here = true;
+            break;
+        case MAV_CMD_NAV_RETURN_TO_LAUNCH:
+            // climbs or turns for home from the previous waypoint's stopping point
+            wp_nav.set_wp_lookahead(next_locs, count, true);
+            return;
+        default:
+            // the path to anything else, such as a spline or circle, isn't a
+            // straight leg. Plan up to the previous waypoint and stop there, or if
+            // that is the destination leave it a plain fast waypoint
+            if (count > 0) {
+                wp_nav.set_wp_lookahead(next_locs, count, true);
+            }
+            return;
+        }
+
+        Location_Class next_loc(temp_cmd.content.location);
+        // default lat, lon and alt to the previous waypoint's as do_nav_wp will
+        if (!has_location) {
+            next_loc.lat = prev_loc.lat;
+            next_loc.lng = prev_loc.lng;
+        }
+        if (next_loc.alt == 0 || temp_cmd.id == MAV_CMD_NAV_LAND) {
+            // do_land flies to its location at the current altitude
+            int32_t next_alt;
+            if (prev_loc.get_alt_cm(next_loc.get_alt_frame(), next_alt)) {
+                next_loc.set_alt_cm(next_alt, next_loc.get_alt_frame());
+            } else {
+                next_loc.set_alt_cm(prev_loc.alt, prev_loc.get_alt_frame());
+            }
+        }
+        next_locs[count++] = next_loc;
+        if (stops_here) {
+            // vehicle stops at this waypoint
+            break;
+        }
+        if (count >= WPNAV_LOOKAHEAD_POINTS) {
+            // more waypoints follow
+            stop_at_end = false;
+            break;
+        }
+        prev_loc = next_loc;
+        index = temp_cmd.index+1;
+    }
+
+    wp_nav.set_wp_lookahead(next_locs, count, stop_at_end);
+}
+
 // do_land - initiate landing procedure
 void Copter::do_land(const AP_Mission::Mission_Command& cmd)
 {
@@ -952,11 +1027,11 @@ void Copter::log_picture()
     if (!camera.using_feedback_pin()) {
         gcs_send_message(MSG_CAMERA_FEEDBACK);
         if (should_log(MASK_LOG_CAMERA)) {
-            DataFlash.Log_Write_Camera(ahrs, gps, current_loc);
+            DataFlash.Log_Write_Camera(ahrs, gps, camera.trigger_location(ahrs, current_loc));
         }
     } else {
         if (should_log(MASK_LOG_CAMERA)) {
-            DataFlash.Log_Write_Trigger(ahrs, gps, current_loc);
+            DataFlash.Log_Write_Trigger(ahrs, gps, camera.trigger_location(ahrs, current_loc));
         }      
     }
 }
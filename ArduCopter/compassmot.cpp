@@ -31,6 +31,8 @@ MAV_RESULT Copter::mavlink_compassmot(mavlink_channel_t chan)
         return MAV_RESULT_TEMPORARILY_REJECTED;
     }else{
         ap.compass_mot = true;
+        // compassmot drives the motors itself
+        rate_thread_output = false;
     }
 
     // initialise output
@@ -117,11 +119,8 @@ MAV_RESULT Copter::mavlink_compassmot(mavlink_channel_t chan)
         compass.set_motor_compensation(i, Vector3f(0,0,0));
     }
 
-    // get initial compass readings
-    last_run_time = millis();
-    while ( millis() - last_run_time < 500 ) {
-        compass.accumulate();
-    }
+    // get initial compass readings, accumulated by the compass drivers
+    hal.scheduler->delay(500);
     compass.read();
 
     // store initial x,y,z compass values
@@ -144,8 +143,6 @@ MAV_RESULT Copter::mavlink_compassmot(mavlink_channel_t chan)
     while (command_ack_start == command_ack_counter && compass.healthy(compass.get_primary()) && motors.armed()) {
         // 50hz loop
         if (millis() - last_run_time < 20) {
-            // grab some compass values
-            compass.accumulate();
             hal.scheduler->delay(5);
             continue;
         }
@@ -401,6 +401,15 @@
 #ifndef LAND_DETECTOR_ACCEL_MAX
 # define LAND_DETECTOR_ACCEL_MAX            1.0f    // vehicle acceleration must be under 1m/s/s
 #endif
+#ifndef LAND_DETECTOR_CLIMB_RATE_MAX
+# define LAND_DETECTOR_CLIMB_RATE_MAX       100.0f  // vertical speed must be within 1m/s of zero
+#endif
+#ifndef DETECTOR_STATS_BLOCK_HZ
+# define DETECTOR_STATS_BLOCK_HZ            10      // land and crash detector statistics are summarised in 0.1 second blocks
+#endif
+#ifndef DETECTOR_STATS_BLOCKS
+# define DETECTOR_STATS_BLOCKS              20      // number of blocks kept, must cover the 2 second crash check
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // CAMERA TRIGGER AND CONTROL
@@ -692,3 +701,8 @@
 #ifndef ADVANCED_FAILSAFE
 # define ADVANCED_FAILSAFE DISABLED
 #endif
+
+// time each stage of the fast loop so overruns can be attributed
+#ifndef FAST_LOOP_TRACE
+# define FAST_LOOP_TRACE ENABLED
+#endif
@@ -35,6 +35,11 @@
  *      i) increases stab P until the maximum angle becomes greater than 110% of the requested angle (20deg)
  *      j) decreases stab P by 25%
  *
+ * The flight mode only runs the checks that end a twitch. Each sample is
+ * queued for autotune_analysis(), a worker task which logs the samples,
+ * measures the acceleration and updates the gains once the twitch is over
+ * while the vehicle holds level.
+ *
  */
 
 #define AUTOTUNE_AXIS_BITMASK_ROLL            1
@@ -70,6 +75,7 @@
 #define AUTOTUNE_SP_BACKOFF                0.9f     // Stab P gains are reduced to 90% of their maximum value discovered during tuning
 #define AUTOTUNE_ACCEL_RP_BACKOFF          1.0f     // back off from maximum acceleration
 #define AUTOTUNE_ACCEL_Y_BACKOFF           1.0f     // back off from maximum acceleration
+#define AUTOTUNE_SAMPLES_MAX    (AUTOTUNE_TESTING_STEP_TIMEOUT_MS*MAIN_LOOP_RATE/1000 + 16)  // twitch samples queued for analysis, enough for the longest twitch
 
 // roll and pitch axes
 #define AUTOTUNE_TARGET_ANGLE_RLLPIT_CD     2000    // target angle during TESTING_RATE step that will cause us to move to next step
@@ -146,6 +152,17 @@ static float    rate_max, autotune_test_accel_max;              // maximum accel
 
 LowPassFilterFloat  rotation_rate_filt;                         // filtered rotation rate in radians/second
 
+// one control loop's measurements during a twitch
+struct autotune_sample {
+    uint32_t time_us;                                           // AP_HAL::micros() when captured
+    uint32_t step_ms;                                           // time since the start of the twitch
+    float    lean_angle;                                        // lean angle from the start of the twitch in centi-degrees
+    float    rotation_rate;                                     // filtered rotation rate in centi-degrees/second
+};
+
+// samples handed from the flight mode to autotune_analysis(), allocated on first use
+static ObjectBuffer<autotune_sample> *autotune_samples;
+
 // backup of currently being tuned parameter values
 static float    orig_roll_rp = 0, orig_roll_ri, orig_roll_rd, orig_roll_sp, orig_roll_accel;
 static float    orig_pitch_rp = 0, orig_pitch_ri, orig_pitch_rd, orig_pitch_sp, orig_pitch_accel;
@@ -239,6 +256,14 @@ bool Copter::autotune_start(bool ignore_checks)
         return false;
     }
 
+    // buffer for the twitch analysis
+    if (autotune_samples == nullptr) {
+        autotune_samples = new ObjectBuffer<autotune_sample>(AUTOTUNE_SAMPLES_MAX);
+    }
+    if (autotune_samples == nullptr || autotune_samples->space() < AUTOTUNE_SAMPLES_MAX) {
+        return false;
+    }
+
     // initialize vertical speeds and leash lengths
     pos_control.set_speed_z(-g.pilot_velocity_z_max, g.pilot_velocity_z_max);
     pos_control.set_accel_z(g.pilot_accel_z);
@@ -505,14 +530,12 @@ void Copter::autotune_attitude_control()
         case AUTOTUNE_TYPE_RD_UP:
         case AUTOTUNE_TYPE_RD_DOWN:
             autotune_twitching_test(rotation_rate, autotune_target_rate, autotune_test_min, autotune_test_max);
-            autotune_twitching_measure_acceleration(autotune_test_accel_max, rotation_rate, rate_max);
             if (lean_angle >= autotune_target_angle) {
                 autotune_state.step = AUTOTUNE_STEP_UPDATE_GAINS;
             }
             break;
         case AUTOTUNE_TYPE_RP_UP:
             autotune_twitching_test(rotation_rate, autotune_target_rate*(1+0.5f*g.autotune_aggressiveness), autotune_test_min, autotune_test_max);
-            autotune_twitching_measure_acceleration(autotune_test_accel_max, rotation_rate, rate_max);
             if (lean_angle >= autotune_target_angle) {
                 autotune_state.step = AUTOTUNE_STEP_UPDATE_GAINS;
             }
@@ -520,12 +543,14 @@ void Copter::autotune_attitude_control()
         case AUTOTUNE_TYPE_SP_DOWN:
         case AUTOTUNE_TYPE_SP_UP:
             autotune_twitching_test(lean_angle, autotune_target_angle*(1+0.5f*g.autotune_aggressiveness), autotune_test_min, autotune_test_max);
-            autotune_twitching_measure_acceleration(autotune_test_accel_max, rotation_rate - direction_sign * autotune_start_rate, rate_max);
             break;
         }
 
-        // log this iterations lean angle and rotation rate
-        Log_Write_AutoTuneDetails(lean_angle, rotation_rate);
+        // queue this iteration's lean angle and rotation rate for autotune_analysis()
+        {
+            const autotune_sample sample { AP_HAL::micros(), millis() - autotune_step_start_time, lean_angle, rotation_rate };
+            autotune_samples->push(sample);
+        }
         DataFlash.Log_Write_Rate(ahrs, motors, attitude_control, pos_control);
         break;
 
@@ -534,214 +559,255 @@ void Copter::autotune_attitude_control()
         // re-enable rate limits
         attitude_control.use_ff_and_input_shaping(true);
 
-        // log the latest gains
-        if ((autotune_state.tune_type == AUTOTUNE_TYPE_SP_DOWN) || (autotune_state.tune_type == AUTOTUNE_TYPE_SP_UP)) {
-            switch (autotune_state.axis) {
-            case AUTOTUNE_AXIS_ROLL:
-                Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_angle, autotune_test_min, autotune_test_max, tune_roll_rp, tune_roll_rd, tune_roll_sp, autotune_test_accel_max);
-                break;
-            case AUTOTUNE_AXIS_PITCH:
-                Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_angle, autotune_test_min, autotune_test_max, tune_pitch_rp, tune_pitch_rd, tune_pitch_sp, autotune_test_accel_max);
-                break;
-            case AUTOTUNE_AXIS_YAW:
-                Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_angle, autotune_test_min, autotune_test_max, tune_yaw_rp, tune_yaw_rLPF, tune_yaw_sp, autotune_test_accel_max);
-                break;
-            }
+        // hold level until autotune_analysis() has updated the gains
+        attitude_control.input_euler_angle_roll_pitch_euler_rate_yaw( 0.0f, 0.0f, 0.0f, get_smoothing_gain());
+        break;
+    }
+}
+
+// autotune_analysis - logs and measures the samples queued by the flight mode
+//  and updates the gains at the end of each twitch. Run as a worker task, so
+//  outside the control loop
+void Copter::autotune_analysis()
+{
+    if (autotune_samples == nullptr) {
+        return;
+    }
+
+    const uint64_t now_us = AP_HAL::micros64();
+    const bool measuring = (autotune_state.step != AUTOTUNE_STEP_WAITING_FOR_LEVEL);
+    const float direction_sign = autotune_state.positive_direction ? 1.0f : -1.0f;
+    const bool angle_test = (autotune_state.tune_type == AUTOTUNE_TYPE_SP_DOWN) || (autotune_state.tune_type == AUTOTUNE_TYPE_SP_UP);
+    autotune_sample sample;
+    while (autotune_samples->pop(sample)) {
+        Log_Write_AutoTuneDetails(now_us - (uint32_t)((uint32_t)now_us - sample.time_us), sample.lean_angle, sample.rotation_rate);
+        if (!measuring) {
+            // left over from an abandoned twitch
+            continue;
+        }
+        if (angle_test) {
+            autotune_twitching_measure_acceleration(autotune_test_accel_max, sample.rotation_rate - direction_sign * autotune_start_rate, rate_max, sample.step_ms);
         } else {
-            switch (autotune_state.axis) {
-            case AUTOTUNE_AXIS_ROLL:
-                Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_rate, autotune_test_min, autotune_test_max, tune_roll_rp, tune_roll_rd, tune_roll_sp, autotune_test_accel_max);
-                break;
-            case AUTOTUNE_AXIS_PITCH:
-                Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_rate, autotune_test_min, autotune_test_max, tune_pitch_rp, tune_pitch_rd, tune_pitch_sp, autotune_test_accel_max);
-                break;
-            case AUTOTUNE_AXIS_YAW:
-                Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_rate, autotune_test_min, autotune_test_max, tune_yaw_rp, tune_yaw_rLPF, tune_yaw_sp, autotune_test_accel_max);
-                break;
-            }
+            autotune_twitching_measure_acceleration(autotune_test_accel_max, sample.rotation_rate, rate_max, sample.step_ms);
         }
+    }
+
+    if (control_mode == AUTOTUNE && autotune_state.mode == AUTOTUNE_MODE_TUNING &&
+        !autotune_state.pilot_override && autotune_state.step == AUTOTUNE_STEP_UPDATE_GAINS) {
+        autotune_update_gains();
+    }
+}
 
-        // Check results after mini-step to increase rate D gain
+// autotune_update_gains - adjusts the gains being tuned from the results of the last twitch
+//  and sets up the next one
+void Copter::autotune_update_gains()
+{
+    // log the latest gains
+    if ((autotune_state.tune_type == AUTOTUNE_TYPE_SP_DOWN) || (autotune_state.tune_type == AUTOTUNE_TYPE_SP_UP)) {
+        switch (autotune_state.axis) {
+        case AUTOTUNE_AXIS_ROLL:
+            Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_angle, autotune_test_min, autotune_test_max, tune_roll_rp, tune_roll_rd, tune_roll_sp, autotune_test_accel_max);
+            break;
+        case AUTOTUNE_AXIS_PITCH:
+            Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_angle, autotune_test_min, autotune_test_max, tune_pitch_rp, tune_pitch_rd, tune_pitch_sp, autotune_test_accel_max);
+            break;
+        case AUTOTUNE_AXIS_YAW:
+            Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_angle, autotune_test_min, autotune_test_max, tune_yaw_rp, tune_yaw_rLPF, tune_yaw_sp, autotune_test_accel_max);
+            break;
+        }
+    } else {
+        switch (autotune_state.axis) {
+        case AUTOTUNE_AXIS_ROLL:
+            Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_rate, autotune_test_min, autotune_test_max, tune_roll_rp, tune_roll_rd, tune_roll_sp, autotune_test_accel_max);
+            break;
+        case AUTOTUNE_AXIS_PITCH:
+            Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_rate, autotune_test_min, autotune_test_max, tune_pitch_rp, tune_pitch_rd, tune_pitch_sp, autotune_test_accel_max);
+            break;
+        case AUTOTUNE_AXIS_YAW:
+            Log_Write_AutoTune(autotune_state.axis, autotune_state.tune_type, autotune_target_rate, autotune_test_min, autotune_test_max, tune_yaw_rp, tune_yaw_rLPF, tune_yaw_sp, autotune_test_accel_max);
+            break;
+        }
+    }
+
+    // Check results after mini-step to increase rate D gain
+    switch (autotune_state.tune_type) {
+    case AUTOTUNE_TYPE_RD_UP:
+        switch (autotune_state.axis) {
+        case AUTOTUNE_AXIS_ROLL:
+            autotune_updating_d_up(tune_roll_rd, g.autotune_min_d, AUTOTUNE_RD_MAX, AUTOTUNE_RD_STEP, tune_roll_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_PITCH:
+            autotune_updating_d_up(tune_pitch_rd, g.autotune_min_d, AUTOTUNE_RD_MAX, AUTOTUNE_RD_STEP, tune_pitch_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_YAW:
+            autotune_updating_d_up(tune_yaw_rLPF, AUTOTUNE_RLPF_MIN, AUTOTUNE_RLPF_MAX, AUTOTUNE_RD_STEP, tune_yaw_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        }
+        break;
+    // Check results after mini-step to decrease rate D gain
+    case AUTOTUNE_TYPE_RD_DOWN:
+        switch (autotune_state.axis) {
+        case AUTOTUNE_AXIS_ROLL:
+            autotune_updating_d_down(tune_roll_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_roll_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_PITCH:
+            autotune_updating_d_down(tune_pitch_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_pitch_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_YAW:
+            autotune_updating_d_down(tune_yaw_rLPF, AUTOTUNE_RLPF_MIN, AUTOTUNE_RD_STEP, tune_yaw_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        }
+        break;
+    // Check results after mini-step to increase rate P gain
+    case AUTOTUNE_TYPE_RP_UP:
+        switch (autotune_state.axis) {
+        case AUTOTUNE_AXIS_ROLL:
+            autotune_updating_p_up_d_down(tune_roll_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_roll_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_PITCH:
+            autotune_updating_p_up_d_down(tune_pitch_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_pitch_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_YAW:
+            autotune_updating_p_up_d_down(tune_yaw_rLPF, AUTOTUNE_RLPF_MIN, AUTOTUNE_RD_STEP, tune_yaw_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+            break;
+        }
+        break;
+    // Check results after mini-step to increase stabilize P gain
+    case AUTOTUNE_TYPE_SP_DOWN:
+        switch (autotune_state.axis) {
+        case AUTOTUNE_AXIS_ROLL:
+            autotune_updating_p_down(tune_roll_sp, AUTOTUNE_SP_MIN, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_PITCH:
+            autotune_updating_p_down(tune_pitch_sp, AUTOTUNE_SP_MIN, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_YAW:
+            autotune_updating_p_down(tune_yaw_sp, AUTOTUNE_SP_MIN, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+            break;
+        }
+        break;
+    // Check results after mini-step to increase stabilize P gain
+    case AUTOTUNE_TYPE_SP_UP:
+        switch (autotune_state.axis) {
+        case AUTOTUNE_AXIS_ROLL:
+            autotune_updating_p_up(tune_roll_sp, AUTOTUNE_SP_MAX, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_PITCH:
+            autotune_updating_p_up(tune_pitch_sp, AUTOTUNE_SP_MAX, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+            break;
+        case AUTOTUNE_AXIS_YAW:
+            autotune_updating_p_up(tune_yaw_sp, AUTOTUNE_SP_MAX, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+            break;
+        }
+        break;
+    }
+
+    // we've complete this step, finalize pids and move to next step
+    if (autotune_counter >= AUTOTUNE_SUCCESS_COUNT) {
+
+        // reset counter
+        autotune_counter = 0;
+
+        // move to the next tuning type
         switch (autotune_state.tune_type) {
         case AUTOTUNE_TYPE_RD_UP:
-            switch (autotune_state.axis) {
-            case AUTOTUNE_AXIS_ROLL:
-                autotune_updating_d_up(tune_roll_rd, g.autotune_min_d, AUTOTUNE_RD_MAX, AUTOTUNE_RD_STEP, tune_roll_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
-                break;
-            case AUTOTUNE_AXIS_PITCH:
-                autotune_updating_d_up(tune_pitch_rd, g.autotune_min_d, AUTOTUNE_RD_MAX, AUTOTUNE_RD_STEP, tune_pitch_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
-                break;
-            case AUTOTUNE_AXIS_YAW:
-                autotune_updating_d_up(tune_yaw_rLPF, AUTOTUNE_RLPF_MIN, AUTOTUNE_RLPF_MAX, AUTOTUNE_RD_STEP, tune_yaw_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
-                break;
-            }
+            autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
             break;
-        // Check results after mini-step to decrease rate D gain
         case AUTOTUNE_TYPE_RD_DOWN:
+            autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
             switch (autotune_state.axis) {
             case AUTOTUNE_AXIS_ROLL:
-                autotune_updating_d_down(tune_roll_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_roll_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+                tune_roll_rd = MAX(g.autotune_min_d, tune_roll_rd * AUTOTUNE_RD_BACKOFF);
+                tune_roll_rp = MAX(AUTOTUNE_RP_MIN, tune_roll_rp * AUTOTUNE_RD_BACKOFF);
                 break;
             case AUTOTUNE_AXIS_PITCH:
-                autotune_updating_d_down(tune_pitch_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_pitch_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+                tune_pitch_rd = MAX(g.autotune_min_d, tune_pitch_rd * AUTOTUNE_RD_BACKOFF);
+                tune_pitch_rp = MAX(AUTOTUNE_RP_MIN, tune_pitch_rp * AUTOTUNE_RD_BACKOFF);
                 break;
             case AUTOTUNE_AXIS_YAW:
-                autotune_updating_d_down(tune_yaw_rLPF, AUTOTUNE_RLPF_MIN, AUTOTUNE_RD_STEP, tune_yaw_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+                tune_yaw_rLPF = MAX(AUTOTUNE_RLPF_MIN, tune_yaw_rLPF * AUTOTUNE_RD_BACKOFF);
+                tune_yaw_rp = MAX(AUTOTUNE_RP_MIN, tune_yaw_rp * AUTOTUNE_RD_BACKOFF);
                 break;
             }
             break;
-        // Check results after mini-step to increase rate P gain
         case AUTOTUNE_TYPE_RP_UP:
+            autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
             switch (autotune_state.axis) {
             case AUTOTUNE_AXIS_ROLL:
-                autotune_updating_p_up_d_down(tune_roll_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_roll_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+                tune_roll_rp = MAX(AUTOTUNE_RP_MIN, tune_roll_rp * AUTOTUNE_RP_BACKOFF);
                 break;
             case AUTOTUNE_AXIS_PITCH:
-                autotune_updating_p_up_d_down(tune_pitch_rd, g.autotune_min_d, AUTOTUNE_RD_STEP, tune_pitch_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+                tune_pitch_rp = MAX(AUTOTUNE_RP_MIN, tune_pitch_rp * AUTOTUNE_RP_BACKOFF);
                 break;
             case AUTOTUNE_AXIS_YAW:
-                autotune_updating_p_up_d_down(tune_yaw_rLPF, AUTOTUNE_RLPF_MIN, AUTOTUNE_RD_STEP, tune_yaw_rp, AUTOTUNE_RP_MIN, AUTOTUNE_RP_MAX, AUTOTUNE_RP_STEP, autotune_target_rate, autotune_test_min, autotune_test_max);
+                tune_yaw_rp = MAX(AUTOTUNE_RP_MIN, tune_yaw_rp * AUTOTUNE_RP_BACKOFF);
                 break;
             }
             break;
-        // Check results after mini-step to increase stabilize P gain
         case AUTOTUNE_TYPE_SP_DOWN:
-            switch (autotune_state.axis) {
-            case AUTOTUNE_AXIS_ROLL:
-                autotune_updating_p_down(tune_roll_sp, AUTOTUNE_SP_MIN, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
-                break;
-            case AUTOTUNE_AXIS_PITCH:
-                autotune_updating_p_down(tune_pitch_sp, AUTOTUNE_SP_MIN, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
-                break;
-            case AUTOTUNE_AXIS_YAW:
-                autotune_updating_p_down(tune_yaw_sp, AUTOTUNE_SP_MIN, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
-                break;
-            }
+            autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
             break;
-        // Check results after mini-step to increase stabilize P gain
         case AUTOTUNE_TYPE_SP_UP:
+            // we've reached the end of a D-up-down PI-up-down tune type cycle
+            autotune_state.tune_type = AUTOTUNE_TYPE_RD_UP;
+
+            // advance to the next axis
+            bool autotune_complete = false;
             switch (autotune_state.axis) {
             case AUTOTUNE_AXIS_ROLL:
-                autotune_updating_p_up(tune_roll_sp, AUTOTUNE_SP_MAX, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+                tune_roll_sp = MAX(AUTOTUNE_SP_MIN, tune_roll_sp * AUTOTUNE_SP_BACKOFF);
+                tune_roll_accel = MAX(AUTOTUNE_RP_ACCEL_MIN, autotune_test_accel_max * AUTOTUNE_ACCEL_RP_BACKOFF);
+                if (autotune_pitch_enabled()) {
+                    autotune_state.axis = AUTOTUNE_AXIS_PITCH;
+                } else if (autotune_yaw_enabled()) {
+                    autotune_state.axis = AUTOTUNE_AXIS_YAW;
+                } else {
+                    autotune_complete = true;
+                }
                 break;
             case AUTOTUNE_AXIS_PITCH:
-                autotune_updating_p_up(tune_pitch_sp, AUTOTUNE_SP_MAX, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+                tune_pitch_sp = MAX(AUTOTUNE_SP_MIN, tune_pitch_sp * AUTOTUNE_SP_BACKOFF);
+                tune_pitch_accel = MAX(AUTOTUNE_RP_ACCEL_MIN, autotune_test_accel_max * AUTOTUNE_ACCEL_RP_BACKOFF);
+                if (autotune_yaw_enabled()) {
+                    autotune_state.axis = AUTOTUNE_AXIS_YAW;
+                } else {
+                    autotune_complete = true;
+                }
                 break;
             case AUTOTUNE_AXIS_YAW:
-                autotune_updating_p_up(tune_yaw_sp, AUTOTUNE_SP_MAX, AUTOTUNE_SP_STEP, autotune_target_angle, autotune_test_max);
+                tune_yaw_sp = MAX(AUTOTUNE_SP_MIN, tune_yaw_sp * AUTOTUNE_SP_BACKOFF);
+                tune_yaw_accel = MAX(AUTOTUNE_Y_ACCEL_MIN, autotune_test_accel_max * AUTOTUNE_ACCEL_Y_BACKOFF);
+                autotune_complete = true;
                 break;
             }
-            break;
-        }
 
-        // we've complete this step, finalize pids and move to next step
-        if (autotune_counter >= AUTOTUNE_SUCCESS_COUNT) {
-
-            // reset counter
-            autotune_counter = 0;
-
-            // move to the next tuning type
-            switch (autotune_state.tune_type) {
-            case AUTOTUNE_TYPE_RD_UP:
-                autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
-                break;
-            case AUTOTUNE_TYPE_RD_DOWN:
-                autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
-                switch (autotune_state.axis) {
-                case AUTOTUNE_AXIS_ROLL:
-                    tune_roll_rd = MAX(g.autotune_min_d, tune_roll_rd * AUTOTUNE_RD_BACKOFF);
-                    tune_roll_rp = MAX(AUTOTUNE_RP_MIN, tune_roll_rp * AUTOTUNE_RD_BACKOFF);
-                    break;
-                case AUTOTUNE_AXIS_PITCH:
-                    tune_pitch_rd = MAX(g.autotune_min_d, tune_pitch_rd * AUTOTUNE_RD_BACKOFF);
-                    tune_pitch_rp = MAX(AUTOTUNE_RP_MIN, tune_pitch_rp * AUTOTUNE_RD_BACKOFF);
-                    break;
-                case AUTOTUNE_AXIS_YAW:
-                    tune_yaw_rLPF = MAX(AUTOTUNE_RLPF_MIN, tune_yaw_rLPF * AUTOTUNE_RD_BACKOFF);
-                    tune_yaw_rp = MAX(AUTOTUNE_RP_MIN, tune_yaw_rp * AUTOTUNE_RD_BACKOFF);
-                    break;
-                }
-                break;
-            case AUTOTUNE_TYPE_RP_UP:
-                autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
-                switch (autotune_state.axis) {
-                case AUTOTUNE_AXIS_ROLL:
-                    tune_roll_rp = MAX(AUTOTUNE_RP_MIN, tune_roll_rp * AUTOTUNE_RP_BACKOFF);
-                    break;
-                case AUTOTUNE_AXIS_PITCH:
-                    tune_pitch_rp = MAX(AUTOTUNE_RP_MIN, tune_pitch_rp * AUTOTUNE_RP_BACKOFF);
-                    break;
-                case AUTOTUNE_AXIS_YAW:
-                    tune_yaw_rp = MAX(AUTOTUNE_RP_MIN, tune_yaw_rp * AUTOTUNE_RP_BACKOFF);
-                    break;
-                }
-                break;
-            case AUTOTUNE_TYPE_SP_DOWN:
-                autotune_state.tune_type = AutoTuneTuneType(autotune_state.tune_type + 1);
-                break;
-            case AUTOTUNE_TYPE_SP_UP:
-                // we've reached the end of a D-up-down PI-up-down tune type cycle
-                autotune_state.tune_type = AUTOTUNE_TYPE_RD_UP;
-
-                // advance to the next axis
-                bool autotune_complete = false;
-                switch (autotune_state.axis) {
-                case AUTOTUNE_AXIS_ROLL:
-                    tune_roll_sp = MAX(AUTOTUNE_SP_MIN, tune_roll_sp * AUTOTUNE_SP_BACKOFF);
-                    tune_roll_accel = MAX(AUTOTUNE_RP_ACCEL_MIN, autotune_test_accel_max * AUTOTUNE_ACCEL_RP_BACKOFF);
-                    if (autotune_pitch_enabled()) {
-                        autotune_state.axis = AUTOTUNE_AXIS_PITCH;
-                    } else if (autotune_yaw_enabled()) {
-                        autotune_state.axis = AUTOTUNE_AXIS_YAW;
-                    } else {
-                        autotune_complete = true;
-                    }
-                    break;
-                case AUTOTUNE_AXIS_PITCH:
-                    tune_pitch_sp = MAX(AUTOTUNE_SP_MIN, tune_pitch_sp * AUTOTUNE_SP_BACKOFF);
-                    tune_pitch_accel = MAX(AUTOTUNE_RP_ACCEL_MIN, autotune_test_accel_max * AUTOTUNE_ACCEL_RP_BACKOFF);
-                    if (autotune_yaw_enabled()) {
-                        autotune_state.axis = AUTOTUNE_AXIS_YAW;
-                    } else {
-                        autotune_complete = true;
-                    }
-                    break;
-                case AUTOTUNE_AXIS_YAW:
-                    tune_yaw_sp = MAX(AUTOTUNE_SP_MIN, tune_yaw_sp * AUTOTUNE_SP_BACKOFF);
-                    tune_yaw_accel = MAX(AUTOTUNE_Y_ACCEL_MIN, autotune_test_accel_max * AUTOTUNE_ACCEL_Y_BACKOFF);
-                    autotune_complete = true;
-                    break;
-                }
-
-                // if we've just completed all axes we have successfully completed the autotune
-                    // change to TESTING mode to allow user to fly with new gains
-                if (autotune_complete) {
-                    autotune_state.mode = AUTOTUNE_MODE_SUCCESS;
-                    autotune_update_gcs(AUTOTUNE_MESSAGE_SUCCESS);
-                    Log_Write_Event(DATA_AUTOTUNE_SUCCESS);
-                    AP_Notify::events.autotune_complete = 1;
-                } else {
-                    AP_Notify::events.autotune_next_axis = 1;
-                }
-                break;
+            // if we've just completed all axes we have successfully completed the autotune
+                // change to TESTING mode to allow user to fly with new gains
+            if (autotune_complete) {
+                autotune_state.mode = AUTOTUNE_MODE_SUCCESS;
+                autotune_update_gcs(AUTOTUNE_MESSAGE_SUCCESS);
+                Log_Write_Event(DATA_AUTOTUNE_SUCCESS);
+                AP_Notify::events.autotune_complete = 1;
+            } else {
+                AP_Notify::events.autotune_next_axis = 1;
             }
+            break;
         }
+    }
 
-        // reverse direction
-        autotune_state.positive_direction = !autotune_state.positive_direction;
+    // reverse direction
+    autotune_state.positive_direction = !autotune_state.positive_direction;
 
-        if (autotune_state.axis == AUTOTUNE_AXIS_YAW) {
-            attitude_control.input_euler_angle_roll_pitch_yaw( 0.0f, 0.0f, ahrs.yaw_sensor, false, get_smoothing_gain());
-        }
+    if (autotune_state.axis == AUTOTUNE_AXIS_YAW) {
+        attitude_control.input_euler_angle_roll_pitch_yaw( 0.0f, 0.0f, ahrs.yaw_sensor, false, get_smoothing_gain());
+    }
 
-        // set gains to their intra-test values (which are very close to the original gains)
-        autotune_load_intra_test_gains();
+    // set gains to their intra-test values (which are very close to the original gains)
+    autotune_load_intra_test_gains();
 
-        // reset testing step
-        autotune_state.step = AUTOTUNE_STEP_WAITING_FOR_LEVEL;
-        autotune_step_start_time = millis();
-        break;
-    }
+    // reset testing step
+    autotune_state.step = AUTOTUNE_STEP_WAITING_FOR_LEVEL;
+    autotune_step_start_time = millis();
 }
 
 // autotune_backup_gains_and_initialise - store current gains as originals
@@ -1310,11 +1376,11 @@ void Copter::autotune_updating_p_up_d_down(float &tune_d, float tune_d_min, floa
 }
 
 // autotune_twitching_measure_acceleration - measure rate of change of measurement
-void Copter::autotune_twitching_measure_acceleration(float &rate_of_change, float rate_measurement, float &rate_measurement_max)
+void Copter::autotune_twitching_measure_acceleration(float &rate_of_change, float rate_measurement, float &rate_measurement_max, uint32_t step_ms)
 {
     if (rate_measurement_max < rate_measurement) {
         rate_measurement_max = rate_measurement;
-        rate_of_change = (1000.0f*rate_measurement_max)/(millis() - autotune_step_start_time);
+        rate_of_change = (1000.0f*rate_measurement_max)/step_ms;
     }
 }
 
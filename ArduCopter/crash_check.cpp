@@ -10,7 +10,7 @@
 // called at MAIN_LOOP_RATE
 void Copter::crash_check()
 {
-    static uint16_t crash_counter;  // number of iterations vehicle may have been crashed
+    static uint16_t crash_counter;  // number of iterations the crash check has been active
 
     // return immediately if disarmed, or crash checking disabled
     if (!motors.armed() || ap.land_complete || g.fs_crash_check == 0) {
@@ -24,26 +24,28 @@ void Copter::crash_check()
         return;
     }
 
-    // vehicle not crashed if 1hz filtered acceleration is more than 3m/s (1G on Z-axis has been subtracted)
-    if (land_accel_ef_filter.get().length() >= CRASH_CHECK_ACCEL_MAX) {
-        crash_counter = 0;
+    // the checks must have been active for the whole trigger period
+    if (crash_counter < (CRASH_CHECK_TRIGGER_SEC * scheduler.get_loop_rate_hz())) {
+        crash_counter++;
         return;
     }
 
-    // check for angle error over 30 degrees
-    const float angle_error = attitude_control.get_att_error_angle_deg();
-    if (angle_error <= CRASH_CHECK_ANGLE_DEVIATION_DEG) {
-        crash_counter = 0;
+    const uint8_t blocks = detector_stats_blocks(CRASH_CHECK_TRIGGER_SEC);
+    DetectorWindow::Stats accel, att_error;
+    if (!detector_stats.accel.get(blocks, accel) || !detector_stats.att_error.get(blocks, att_error)) {
         return;
     }
 
-    // we may be crashing
-    crash_counter++;
+    // vehicle not crashed if 1hz filtered acceleration has been more than 3m/s (1G on Z-axis has been subtracted)
+    if (accel.max >= CRASH_CHECK_ACCEL_MAX) {
+        return;
+    }
 
-    // check if crashing for 2 seconds
-    if (crash_counter >= (CRASH_CHECK_TRIGGER_SEC * scheduler.get_loop_rate_hz())) {
+    // check if angle error has been over 30 degrees for 2 seconds
+    if (att_error.min > CRASH_CHECK_ANGLE_DEVIATION_DEG) {
         // log an error in the dataflash
         Log_Write_Error(ERROR_SUBSYSTEM_CRASH_CHECK, ERROR_CODE_CRASH_CHECK_CRASH);
+        DataFlash.trigger("crash");
         // send message to gcs
         gcs_send_text(MAV_SEVERITY_EMERGENCY,"Crash: Disarming");
         // disarm motors
@@ -97,7 +99,7 @@ void Copter::parachute_check()
     }
 
     // check for angle error over 30 degrees
-    const float angle_error = attitude_control.get_att_error_angle_deg();
+    const float angle_error = detector_stats.att_error.last();
     if (angle_error <= CRASH_CHECK_ANGLE_DEVIATION_DEG) {
         if (control_loss_count > 0) {
             control_loss_count--;
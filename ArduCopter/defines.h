@@ -68,6 +68,7 @@ enum aux_sw_func {
     AUXSW_RELAY4 =              36, // Relay4 pin on/off (in Mission planner set CH10_OPT = 36)
     AUXSW_THROW =               37,  // change to THROW flight mode
     AUXSW_AVOID_ADSB =          38,  // enable AP_Avoidance library
+    AUXSW_LOG_TRIGGER =         39,  // write out the pre-trigger log buffer
     AUXSW_SWITCH_MAX,
 };
 
@@ -281,6 +282,24 @@ enum DevOptions {
     DevOptionADSBMAVLink = 1,
 };
 
+// stages of the main loop timed by the loop tracer
+enum FastLoopSpan {
+    FAST_LOOP_SPAN_AHRS = 0,
+    FAST_LOOP_SPAN_RATE_CONTROLLER,
+    FAST_LOOP_SPAN_HELI_DYNAMICS,
+    FAST_LOOP_SPAN_MOTORS,
+    FAST_LOOP_SPAN_NOTCH,
+    FAST_LOOP_SPAN_INERTIA,
+    FAST_LOOP_SPAN_EKF_RESET,
+    FAST_LOOP_SPAN_FLIGHT_MODE,
+    FAST_LOOP_SPAN_HOME,
+    FAST_LOOP_SPAN_LAND_DETECTOR,
+    FAST_LOOP_SPAN_MOUNT,
+    FAST_LOOP_SPAN_SENSOR_HEALTH,
+    FAST_LOOP_SPAN_SCHEDULER,
+    FAST_LOOP_SPAN_COUNT
+};
+
 //  Logging parameters
 #define TYPE_AIRSTART_MSG               0x00
 #define TYPE_GROUNDSTART_MSG            0x01
@@ -307,6 +326,7 @@ enum DevOptions {
 #define LOG_GUIDEDTARGET_MSG            0x22
 #define LOG_THROW_MSG                   0x23
 #define LOG_PROXIMITY_MSG               0x24
+#define LOG_LOOP_TRACE_MSG              0x25
 
 #define MASK_LOG_ATTITUDE_FAST          (1<<0)
 #define MASK_LOG_ATTITUDE_MED           (1<<1)
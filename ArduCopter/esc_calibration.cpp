@@ -19,6 +19,14 @@ enum ESCCalibrationModes {
 void Copter::esc_calibration_startup_check()
 {
 #if FRAME_CONFIG != HELI_FRAME
+    // digital ESCs have a fixed throttle range and need no calibration
+    if (hal.rcout->get_output_mode() >= AP_HAL::RCOutput::MODE_DSHOT150) {
+        if ((g.esc_calibrate != ESCCAL_NONE) && (g.esc_calibrate != ESCCAL_DISABLED)) {
+            g.esc_calibrate.set_and_save(ESCCAL_NONE);
+        }
+        return;
+    }
+
     // exit immediately if pre-arm rc checks fail
     pre_arm_rc_checks();
     if (!ap.pre_arm_rc_check) {
@@ -52,10 +52,18 @@ void Copter::failsafe_check()
         // main loop ran. That means we're in trouble and should
         // disarm the motors.
         in_failsafe = true;
+        // stop the rate thread overwriting the outputs, and wait for a
+        // run in progress. If the stalled main loop holds the semaphore
+        // the rate thread can't be running
+        rate_thread_output = false;
+        const bool have_sem = rate_thread_sem != nullptr && rate_thread_sem->take(1);
         // reduce motors to minimum (we do not immediately disarm because we want to log the failure)
         if (motors.armed()) {
             motors.output_min();
         }
+        if (have_sem) {
+            rate_thread_sem->give();
+        }
         // log an error
         Log_Write_Error(ERROR_SUBSYSTEM_CPU,ERROR_CODE_FAILSAFE_OCCURRED);
     }
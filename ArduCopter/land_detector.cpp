@@ -18,6 +18,8 @@ void Copter::update_land_and_crash_detectors()
     accel_ef.z += GRAVITY_MSS;
     land_accel_ef_filter.apply(accel_ef, MAIN_LOOP_SECONDS);
 
+    update_detector_stats();
+
     update_land_detector();
 
 #if PARACHUTE == ENABLED
@@ -28,6 +30,45 @@ void Copter::update_land_and_crash_detectors()
     crash_check();
 }
 
+// update_detector_stats - adds this loop's samples to the windows shared by the land and crash detectors
+// called at MAIN_LOOP_RATE
+void Copter::update_detector_stats()
+{
+    const uint16_t block_samples = scheduler.get_loop_rate_hz() / DETECTOR_STATS_BLOCK_HZ;
+    detector_stats.accel.set_block_samples(block_samples);
+    detector_stats.att_error.set_block_samples(block_samples);
+    detector_stats.climb_rate.set_block_samples(block_samples);
+
+    detector_stats.accel.apply(land_accel_ef_filter.get().length());
+    detector_stats.att_error.apply(attitude_control.get_att_error_angle_deg());
+    detector_stats.climb_rate.apply(fabsf(inertial_nav.get_velocity_z()));
+}
+
+// detector_stats_blocks - number of statistics blocks covering the given period
+uint8_t Copter::detector_stats_blocks(float seconds) const
+{
+    return constrain_int16(ceilf(seconds * DETECTOR_STATS_BLOCK_HZ), 0, DETECTOR_STATS_BLOCKS);
+}
+
+// land_detector_stationary - true if the airframe has not been accelerating and the vertical
+// speed has been near zero for the whole of the given period
+bool Copter::land_detector_stationary(float seconds) const
+{
+    const uint8_t blocks = detector_stats_blocks(seconds);
+    DetectorWindow::Stats accel, climb;
+    if (!detector_stats.accel.get(blocks, accel) || !detector_stats.climb_rate.get(blocks, climb)) {
+        return false;
+    }
+
+    // check that the airframe is not accelerating (not falling or breaking after fast forward flight)
+    bool accel_stationary = (accel.max <= LAND_DETECTOR_ACCEL_MAX);
+
+    // check that vertical speed is within 1m/s of zero
+    bool descent_rate_low = (climb.max < LAND_DETECTOR_CLIMB_RATE_MAX);
+
+    return accel_stationary && descent_rate_low;
+}
+
 // update_land_detector - checks if we have landed and updates the ap.land_complete flag
 // called at MAIN_LOOP_RATE
 void Copter::update_land_detector()
@@ -63,29 +104,27 @@ void Copter::update_land_detector()
         bool motor_at_lower_limit = motors.limit.throttle_lower && attitude_control.is_throttle_mix_min();
 #endif
 
-        // check that the airframe is not accelerating (not falling or breaking after fast forward flight)
-        bool accel_stationary = (land_accel_ef_filter.get().length() <= LAND_DETECTOR_ACCEL_MAX);
-
-        // check that vertical speed is within 1m/s of zero
-        bool descent_rate_low = fabsf(inertial_nav.get_velocity_z()) < 100;
-
         // if we have a healthy rangefinder only allow landing detection below 2 meters
         bool rangefinder_check = (!rangefinder_alt_ok() || rangefinder_state.alt_cm_filt.get() < LAND_RANGEFINDER_MIN_ALT_CM);
 
-        if (motor_at_lower_limit && accel_stationary && descent_rate_low && rangefinder_check) {
-            // landed criteria met - increment the counter and check if we've triggered
-            if( land_detector_count < ((float)LAND_DETECTOR_TRIGGER_SEC)*scheduler.get_loop_rate_hz()) {
+        // the counter covers the motor and rangefinder checks, the
+        // acceleration and descent rate are checked over the same period
+        // from the detector statistics window
+        if (motor_at_lower_limit && rangefinder_check) {
+            if (land_detector_count < ((float)LAND_DETECTOR_TRIGGER_SEC)*scheduler.get_loop_rate_hz()) {
                 land_detector_count++;
-            } else {
+            } else if (land_detector_stationary(LAND_DETECTOR_TRIGGER_SEC)) {
+                // landed criteria met for the whole trigger period
                 set_land_complete(true);
             }
         } else {
-            // we've sensed movement up or down so reset land_detector
             land_detector_count = 0;
         }
     }
 
-    set_land_complete_maybe(ap.land_complete || (land_detector_count >= LAND_DETECTOR_MAYBE_TRIGGER_SEC*scheduler.get_loop_rate_hz()));
+    set_land_complete_maybe(ap.land_complete ||
+                            (land_detector_count >= LAND_DETECTOR_MAYBE_TRIGGER_SEC*scheduler.get_loop_rate_hz() &&
+                             land_detector_stationary(LAND_DETECTOR_MAYBE_TRIGGER_SEC)));
 }
 
 // set land_complete flag and disarm motors if disarm-on-land is configured
@@ -153,7 +192,7 @@ void Copter::update_throttle_thr_mix()
         bool large_angle_request = (norm(angle_target.x, angle_target.y) > LAND_CHECK_LARGE_ANGLE_CD);
 
         // check for large external disturbance - angle error over 30 degrees
-        const float angle_error = attitude_control.get_att_error_angle_deg();
+        const float angle_error = detector_stats.att_error.last();
         bool large_angle_error = (angle_error > LAND_CHECK_ANGLE_ERROR_DEG);
 
         // check for large acceleration - falling or high turbulence
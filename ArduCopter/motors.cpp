@@ -206,6 +206,9 @@ bool Copter::init_arm_motors(bool arming_from_gcs)
     // Start the arming delay
     ap.in_arming_delay = true;
 
+    // first arming marks the end of boot time allocation
+    AP_Alloc::freeze();
+
     // return success
     return true;
 }
@@ -265,6 +268,9 @@ void Copter::init_disarm_motors()
 // motors_output - send output to motors library which will adjust and send to ESCs and servos
 void Copter::motors_output()
 {
+    // only the normal output below is left to the rate thread
+    rate_thread_output = false;
+
 #if ADVANCED_FAILSAFE == ENABLED
     // this is to allow the failsafe module to deliberately crash 
     // the vehicle. Only used in extreme circumstances to meet the
@@ -293,9 +299,54 @@ void Copter::motors_output()
             Log_Write_Event(DATA_MOTORS_INTERLOCK_DISABLED);
         }
 
-        // send output signals to motors
+        if (rate_thread_active) {
+            // the rate thread sends the outputs with each rate controller run
+            rate_thread_output = true;
+        } else {
+            // send output signals to motors
+            motors.output();
+        }
+    }
+}
+
+// start the rate controller thread if RATE_THREAD_HZ is set
+void Copter::init_rate_thread()
+{
+#if FRAME_CONFIG != HELI_FRAME
+    if (g2.rate_thread_hz <= 0) {
+        return;
+    }
+    AP_HAL::Semaphore *sem = hal.util->new_semaphore();
+    if (sem == nullptr ||
+        !hal.scheduler->register_rate_process(FUNCTOR_BIND_MEMBER(&Copter::rate_thread_update, void),
+                                              g2.rate_thread_hz)) {
+        gcs_send_text(MAV_SEVERITY_WARNING, "Rate thread not supported");
+        return;
+    }
+    rate_thread_sem = sem;
+    attitude_control.enable_rate_thread(g2.rate_thread_hz);
+    rate_thread_dt = 1.0f / g2.rate_thread_hz;
+    rate_thread_active = true;
+#endif
+}
+
+// run the rate controller and send outputs to the motors, called from the rate thread
+void Copter::rate_thread_update()
+{
+    if (rate_thread_sem == nullptr || !rate_thread_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+    // the main loop may have taken the outputs back while we waited
+    const uint32_t now = AP_HAL::micros();
+    if (rate_thread_output) {
+        // a run waits for the main loop, so it can come late
+        const float dt = constrain_float((now - rate_thread_last_us) * 1.0e-6f,
+                                         rate_thread_dt * 0.5f, MAIN_LOOP_SECONDS * 2);
+        attitude_control.rate_controller_run_thread(dt);
         motors.output();
     }
+    rate_thread_last_us = now;
+    rate_thread_sem->give();
 }
 
 // check for pilot stick input to trigger lost vehicle alarm
@@ -40,9 +40,17 @@ void Copter::perf_info_check_loop_time(uint32_t time_in_micros)
     // exit if this loop should be ignored
     if (perf_ignore_loop) {
         perf_ignore_loop = false;
+#if FAST_LOOP_TRACE == ENABLED
+        loop_trace.new_loop(time_in_micros, false);
+#endif
         return;
     }
 
+#if FAST_LOOP_TRACE == ENABLED
+    // keep the stage timings of loops that overran
+    loop_trace.new_loop(time_in_micros, time_in_micros > PERF_INFO_OVERTIME_THRESHOLD_MICROS);
+#endif
+
     if( time_in_micros > perf_info_max_time) {
         perf_info_max_time = time_in_micros;
     }
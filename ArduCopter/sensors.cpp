@@ -92,6 +92,41 @@ void Copter::rpm_update(void)
     }
 }
 
+// update_dynamic_notch - set the gyro harmonic notch center frequency to follow the motor noise
+void Copter::update_dynamic_notch()
+{
+    const HarmonicNotchFilterParams &notch = ins.get_gyro_harmonic_notch_params();
+    if (!notch.enabled()) {
+        return;
+    }
+    const float ref_freq = notch.center_freq_hz();
+
+    switch (notch.mode()) {
+    case HarmonicNotchFilterParams::TRACK_THROTTLE: {
+        // motor speed, and so the noise frequency, goes as the square
+        // root of thrust. Never go below the base frequency
+        float ref_throttle = notch.reference();
+        if (ref_throttle <= 0.0f) {
+            ref_throttle = motors.get_throttle_hover();
+        }
+        const float throttle = motors.get_throttle();
+        ins.update_harmonic_notch_freq_hz(ref_freq * MAX(1.0f, safe_sqrt(throttle / ref_throttle)));
+        break;
+    }
+
+    case HarmonicNotchFilterParams::TRACK_RPM: {
+        const float rpm = rpm_sensor.get_rpm(0);
+        ins.update_harmonic_notch_freq_hz(MAX(ref_freq, rpm / 60.0f));
+        break;
+    }
+
+    case HarmonicNotchFilterParams::TRACK_FIXED:
+    default:
+        ins.update_harmonic_notch_freq_hz(ref_freq);
+        break;
+    }
+}
+
 // initialise compass
 void Copter::init_compass()
 {
@@ -588,6 +588,13 @@ void Copter::do_aux_switch_function(int8_t ch_function, uint8_t ch_flag)
                 Log_Write_Event(DATA_AVOIDANCE_ADSB_DISABLE);
             }
             break;
+
+        case AUXSW_LOG_TRIGGER:
+            // log the data leading up to now, see LOG_PRETRIG_SECS
+            if (ch_flag == AUX_SWITCH_HIGH) {
+                DataFlash.trigger("switch");
+            }
+            break;
     }
 }
 
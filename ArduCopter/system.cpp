@@ -139,8 +139,14 @@ void Copter::init_ardupilot()
 
     // Init RSSI
     rssi.init();
-    
-    barometer.init();
+
+    // probe the barometers on a thread of their own where the HAL
+    // allows, overlapping with the serial port setup below. The device
+    // managers and timer registration aren't thread safe, so the probe
+    // is waited for before anything else touches them
+    if (!hal.scheduler->run_startup_task(FUNCTOR_BIND(&barometer, &AP_Baro::init, void))) {
+        barometer.init();
+    }
 
     // we start by assuming USB connected, as we initialed the serial
     // port with SERIAL0_BAUD. check_usb_mux() fixes this if need be.
@@ -152,6 +158,8 @@ void Copter::init_ardupilot()
         gcs[i].setup_uart(serial_manager, AP_SerialManager::SerialProtocol_MAVLink, i);
     }
 
+    hal.scheduler->wait_startup_tasks();
+
 #if FRSKY_TELEM_ENABLED == ENABLED
     // setup frsky, and pass a number of parameters to the library
     frsky_telemetry.init(serial_manager, FIRMWARE_STRING " " FRAME_CONFIG_STRING,
@@ -281,6 +289,9 @@ void Copter::init_ardupilot()
     // ready to fly
     serial_manager.set_blocking_writes_all(false);
 
+    // start the rate controller thread before the failsafe watches the main loop
+    init_rate_thread();
+
     // enable CPU failsafe
     failsafe_enable();
 
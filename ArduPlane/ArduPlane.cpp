@@ -23,6 +23,7 @@
 #include "Plane.h"
 
 #define SCHED_TASK(func, rate_hz, max_time_micros) SCHED_TASK_CLASS(Plane, &plane, func, rate_hz, max_time_micros)
+#define SCHED_TASK_SHED(func, rate_hz, max_time_micros) SCHED_TASK_CLASS_SHED(Plane, &plane, func, rate_hz, max_time_micros)
 
 
 /*
@@ -54,9 +55,7 @@ const AP_Scheduler::Task Plane::scheduler_tasks[] = {
     SCHED_TASK(update_events,          50,    150),
     SCHED_TASK(check_usb_mux,          10,    100),
     SCHED_TASK(read_battery,           10,    300),
-    SCHED_TASK(compass_accumulate,     50,    200),
-    SCHED_TASK(barometer_accumulate,   50,    150),
-    SCHED_TASK(update_notify,          50,    300),
+    SCHED_TASK_SHED(update_notify,     50,    300),
     SCHED_TASK(read_rangefinder,       50,    100),
     SCHED_TASK(ice_update,             10,    100),
     SCHED_TASK(compass_cal_update,     50,    50),
@@ -66,16 +65,17 @@ const AP_Scheduler::Task Plane::scheduler_tasks[] = {
 #endif
     SCHED_TASK(one_second_loop,         1,    400),
     SCHED_TASK(check_long_failsafe,     3,    400),
+    SCHED_TASK(rally_update,            3,    100),
     SCHED_TASK(read_receiver_rssi,     10,    100),
     SCHED_TASK(rpm_update,             10,    100),
     SCHED_TASK(airspeed_ratio_update,   1,    100),
-    SCHED_TASK(update_mount,           50,    100),
-    SCHED_TASK(update_trigger,         50,    100),
+    SCHED_TASK_SHED(update_mount,      50,    100),
+    SCHED_TASK_SHED(update_trigger,    50,    100),
     SCHED_TASK(log_perf_info,         0.2,    100),
     SCHED_TASK(compass_save,          0.1,    200),
-    SCHED_TASK(Log_Write_Fast,         25,    300),
-    SCHED_TASK(update_logging1,        10,    300),
-    SCHED_TASK(update_logging2,        10,    300),
+    SCHED_TASK_SHED(Log_Write_Fast,    25,    300),
+    SCHED_TASK_SHED(update_logging1,   10,    300),
+    SCHED_TASK_SHED(update_logging2,   10,    300),
     SCHED_TASK(parachute_check,        10,    200),
     SCHED_TASK(terrain_update,         10,    200),
     SCHED_TASK(update_is_flying_5Hz,    5,    100),
@@ -105,6 +105,11 @@ void Plane::setup()
 
 void Plane::loop()
 {
+    // follow the scheduler when it adapts the loop rate to the load
+    if (ins.get_sample_rate() != scheduler.get_loop_rate_hz()) {
+        update_loop_rate();
+    }
+
     uint32_t loop_us = 1000000UL / scheduler.get_loop_rate_hz();
 
     // wait for an INS sample
@@ -141,6 +146,17 @@ void Plane::loop()
     scheduler.run(loop_us);
 }
 
+/*
+  the scheduler has changed the main loop rate. Take IMU samples at
+  the new rate and give the quadplane controllers the new time step
+ */
+void Plane::update_loop_rate(void)
+{
+    const uint16_t loop_rate_hz = scheduler.get_loop_rate_hz();
+    ins.set_loop_rate(loop_rate_hz);
+    quadplane.set_loop_rate(loop_rate_hz);
+}
+
 // update AHRS system
 void Plane::ahrs_update()
 {
@@ -205,10 +221,13 @@ void Plane::update_trigger(void)
 {
 #if CAMERA == ENABLED
     camera.trigger_pic_cleanup();
+    if (camera.check_scheduled_trigger(ahrs, current_loc)) {
+        log_picture();
+    }
     if (camera.check_trigger_pin()) {
         gcs_send_message(MSG_CAMERA_FEEDBACK);
         if (should_log(MASK_LOG_CAMERA)) {
-            DataFlash.Log_Write_Camera(ahrs, gps, current_loc);
+            DataFlash.Log_Write_Camera(ahrs, gps, camera.feedback_location(ahrs, current_loc));
         }
     }    
 #endif
@@ -230,24 +249,6 @@ void Plane::update_compass(void)
     }
 }
 
-/*
-  if the compass is enabled then try to accumulate a reading
- */
-void Plane::compass_accumulate(void)
-{
-    if (g.compass_enabled) {
-        compass.accumulate();
-    }    
-}
-
-/*
-  try to accumulate a baro reading
- */
-void Plane::barometer_accumulate(void)
-{
-    barometer.accumulate();
-}
-
 /*
   do 10Hz logging
  */
@@ -290,6 +291,14 @@ void Plane::afs_fs_check(void)
 }
 
 
+/*
+  keep the nearest rally point ready for RTL and fence breaches
+ */
+void Plane::rally_update(void)
+{
+    rally.update(current_loc);
+}
+
 /*
   update aux servo mappings
  */
@@ -362,9 +371,13 @@ void Plane::log_perf_info()
 
     if (should_log(MASK_LOG_PM)) {
         Log_Write_Performance();
+        if (quadplane.available()) {
+            quadplane.Log_Write_QPerf();
+        }
     }
 
     resetPerfData();
+    quadplane.reset_perf();
 }
 
 void Plane::compass_save()
@@ -1277,6 +1277,10 @@ void GCS_MAVLINK_Plane::handleMessage(mavlink_message_t* msg)
             result = handle_rc_bind(packet);
             break;
 
+        case MAV_CMD_SET_MESSAGE_INTERVAL:
+            result = handle_command_set_message_interval(packet);
+            break;
+
         case MAV_CMD_NAV_LOITER_UNLIM:
             plane.set_mode(LOITER, MODE_REASON_GCS_COMMAND);
             result = MAV_RESULT_ACCEPTED;
@@ -2096,6 +2100,10 @@ void GCS_MAVLINK_Plane::handleMessage(mavlink_message_t* msg)
         handle_serial_control(msg, plane.gps);
         break;
 
+    case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
+        handle_file_transfer_protocol(msg);
+        break;
+
     case MAVLINK_MSG_ID_GPS_INJECT_DATA:
         handle_gps_inject(msg, plane.gps);
         break;
@@ -940,6 +940,7 @@ private:
     bool geofence_set_floor_enabled(bool floor_enable);
     bool geofence_check_minalt(void);
     bool geofence_check_maxalt(void);
+    bool geofence_outside(const struct Location &loc);
     void geofence_check(bool altitude_check_only);
     bool geofence_stickmixing(void);
     void geofence_send_status(mavlink_channel_t chan);
@@ -1002,6 +1003,7 @@ private:
     bool mavlink_set_mode(uint8_t mode);
     void exit_mode(enum FlightMode mode);
     void check_long_failsafe();
+    void rally_update(void);
     void check_short_failsafe();
     void startup_INS_ground(void);
     void update_notify();
@@ -1028,15 +1030,14 @@ private:
     void update_compass(void);
     void update_alt(void);
     void afs_fs_check(void);
-    void compass_accumulate(void);
     void compass_cal_update();
-    void barometer_accumulate(void);
     void update_optical_flow(void);
     void one_second_loop(void);
     void airspeed_ratio_update(void);
     void update_mount(void);
     void update_trigger(void);    
     void log_perf_info(void);
+    void update_loop_rate(void);
     void compass_save(void);
     void update_logging1(void);
     void update_logging2(void);
@@ -27,7 +27,7 @@ bool AP_Arming_Plane::pre_arm_checks(bool report)
     bool ret = AP_Arming::pre_arm_checks(report);
 
     // Check airspeed sensor
-    ret &= AP_Arming::airspeed_checks(report);
+    ret &= run_check(CHECK_ID_AIRSPEED, &AP_Arming_Plane::airspeed_checks, report);
 
     if (plane.aparm.roll_limit_cd < 300) {
         if (report) {
@@ -67,6 +67,13 @@ bool AP_Arming_Plane::pre_arm_checks(bool report)
         ret = false;
     }
 
+    if (plane.quadplane.available() && plane.quadplane.motors->pwm_type_unsupported()) {
+        if (report) {
+            GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_CRITICAL, "PreArm: Q_M_PWM_TYPE not supported by board");
+        }
+        ret = false;
+    }
+
     if (plane.control_mode == AUTO && plane.mission.num_commands() <= 1) {
         if (report) {
             GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_CRITICAL, "PreArm: No mission loaded");
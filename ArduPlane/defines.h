@@ -135,7 +135,8 @@ enum log_messages {
     LOG_STATUS_MSG,
     LOG_OPTFLOW_MSG,
     LOG_QTUN_MSG,
-    LOG_PARAMTUNE_MSG
+    LOG_PARAMTUNE_MSG,
+    LOG_QPRF_MSG
 };
 
 #define MASK_LOG_ATTITUDE_FAST          (1<<0)
@@ -7,6 +7,8 @@
 
 #if GEOFENCE_ENABLED == ENABLED
 
+#include <AC_Fence/AC_PolyFence_index.h>
+
 #define MIN_GEOFENCE_POINTS 5 // 3 to define a minimal polygon (triangle)
                               // + 1 for return point and +1 for last
                               // pt (same as first)
@@ -38,6 +40,11 @@ static struct GeofenceState {
     int32_t guided_lng;
     /* point 0 is the return point */
     Vector2l *boundary;
+    /* boundary relative to the return point, for the index. The
+       index is only allocated if there is memory to spare, and the
+       boundary test falls back to the linear check without it */
+    Vector2f *boundary_rel;
+    AC_PolyFence_index *index;
 } *geofence_state;
 
 
@@ -112,6 +119,13 @@ void Plane::geofence_load(void)
         }
         
         geofence_state->old_switch_position = 254;
+
+        if (hal.util->available_memory() >= 100 + boundary_size + sizeof(AC_PolyFence_index)) {
+            geofence_state->boundary_rel = (Vector2f *)calloc(max_fencepoints(), sizeof(Vector2f));
+            if (geofence_state->boundary_rel != NULL) {
+                geofence_state->index = new AC_PolyFence_index;
+            }
+        }
     }
 
     if (g.fence_total <= 0) {
@@ -133,6 +147,21 @@ void Plane::geofence_load(void)
         goto failed;
     }
 
+    if (geofence_state->index != NULL) {
+        // index the boundary so the breach test usually costs a lookup
+        const Vector2l &origin = geofence_state->boundary[0];
+        for (i=1; i<geofence_state->num_points; i++) {
+            const Vector2l &p = geofence_state->boundary[i];
+            geofence_state->boundary_rel[i-1] = Vector2f((int64_t)p.x - origin.x, (int64_t)p.y - origin.y);
+        }
+        if (geofence_state->index->build(geofence_state->boundary_rel, geofence_state->num_points-1) &&
+            geofence_state->index->num_rings() != 1) {
+            // a repeat of the first point part way round; keep the
+            // single polygon meaning of the linear check
+            geofence_state->index->clear();
+        }
+    }
+
     geofence_state->boundary_uptodate = true;
     geofence_state->fence_triggered = false;
 
@@ -273,6 +302,22 @@ bool Plane::geofence_check_maxalt(void)
     return (adjusted_altitude_cm() > (g.fence_maxalt*100.0f) + home.alt);
 }
 
+/*
+ *  return true if a location is outside the fence boundary
+ */
+bool Plane::geofence_outside(const struct Location &loc)
+{
+    if (geofence_state->index != NULL && geofence_state->index->valid()) {
+        const Vector2l &origin = geofence_state->boundary[0];
+        const Vector2f location((int64_t)loc.lat - origin.x, (int64_t)loc.lng - origin.y);
+        return geofence_state->index->breached(location);
+    }
+    Vector2l location;
+    location.x = loc.lat;
+    location.y = loc.lng;
+    return Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+}
+
 
 /*
  *  check if we have breached the geo-fence
@@ -321,10 +366,7 @@ void Plane::geofence_check(bool altitude_check_only)
         outside = true;
         breach_type = FENCE_BREACH_MAXALT;
     } else if (!altitude_check_only && ahrs.get_position(loc)) {
-        Vector2l location;
-        location.x = loc.lat;
-        location.y = loc.lng;
-        outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+        outside = geofence_outside(loc);
         if (outside) {
             breach_type = FENCE_BREACH_BOUNDARY;
         }
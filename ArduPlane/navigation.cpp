@@ -149,10 +149,8 @@ void Plane::calc_gndspeed_undershoot()
  	// Use the component of ground speed in the forward direction
 	// This prevents flyaway if wind takes plane backwards
     if (gps.status() >= AP_GPS::GPS_OK_FIX_2D) {
-	    Vector2f gndVel = ahrs.groundspeed_vector();
-		const Matrix3f &rotMat = ahrs.get_rotation_body_to_ned();
-		Vector2f yawVect = Vector2f(rotMat.a.x,rotMat.b.x);
-		yawVect.normalize();
+	    const Vector2f &gndVel = ahrs.get_nav_context().groundspeed_vector;
+		Vector2f yawVect = Vector2f(ahrs.cos_yaw(), ahrs.sin_yaw());
 		float gndSpdFwd = yawVect * gndVel;
         groundspeed_undershoot = (g.min_gndspeed_cm > 0) ? (g.min_gndspeed_cm - gndSpdFwd*100) : 0;
     }
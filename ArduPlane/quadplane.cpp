@@ -328,6 +328,14 @@ const AP_Param::GroupInfo QuadPlane::var_info[] = {
     // @User: Standard
     AP_GROUPINFO("ASSIST_ANGLE", 45, QuadPlane, assist_angle, 30),
 
+    // @Param: SHED_DIV
+    // @DisplayName: Quadplane transition load shedding
+    // @Description: While the fixed wing and VTOL controllers are both running, during a transition or VTOL assistance, non-essential tasks such as logging, notify and mount control are run at 1/SHED_DIV of their normal rate to leave time for the controllers. Set to 0 or 1 to always run them at their normal rate.
+    // @Range: 0 10
+    // @Increment: 1
+    // @User: Advanced
+    AP_GROUPINFO("SHED_DIV", 46, QuadPlane, shed_divisor, 2),
+
     AP_GROUPEND
 };
 
@@ -1064,6 +1072,64 @@ void QuadPlane::run_rate_controller(void)
   update motor output for quadplane
  */
 void QuadPlane::update(void)
+{
+    const uint32_t start_us = AP_HAL::micros();
+
+    update_control();
+    update_load_shedding();
+
+    const uint32_t dt_us = MIN(AP_HAL::micros() - start_us, UINT16_MAX);
+    if (perf.num_updates < UINT16_MAX) {
+        perf.num_updates++;
+        perf.total_us += dt_us;
+        perf.max_us = MAX(perf.max_us, dt_us);
+        if (in_transition()) {
+            perf.num_transition++;
+            perf.transition_total_us += dt_us;
+            perf.transition_max_us = MAX(perf.transition_max_us, dt_us);
+        }
+        if (plane.scheduler.shedding()) {
+            perf.num_shed++;
+        }
+    }
+}
+
+/*
+  while both sets of controllers run the 400Hz tasks are close to
+  their budget, so slow down the tasks the scheduler table marks as
+  sheddable. Only done when armed, as on the ground there is no hurry
+ */
+void QuadPlane::update_load_shedding(void)
+{
+    if (in_transition() && hal.util->get_soft_armed() && shed_divisor > 1) {
+        plane.scheduler.set_shed_divisor(shed_divisor);
+    } else {
+        plane.scheduler.set_shed_divisor(1);
+    }
+}
+
+/*
+  the scheduler has changed the main loop rate, so give the
+  controllers the new time step. They only exist once setup() has run
+ */
+void QuadPlane::set_loop_rate(uint16_t loop_rate_hz)
+{
+    if (!initialised) {
+        return;
+    }
+    const float loop_delta_t = 1.0f / loop_rate_hz;
+    motors->set_loop_rate(loop_rate_hz);
+    attitude_control->set_dt(loop_delta_t);
+    pid_accel_z.set_dt(loop_delta_t);
+    pos_control->set_dt(loop_delta_t);
+}
+
+void QuadPlane::reset_perf(void)
+{
+    memset(&perf, 0, sizeof(perf));
+}
+
+void QuadPlane::update_control(void)
 {
     if (!setup()) {
         return;
@@ -1884,6 +1950,23 @@ void QuadPlane::Log_Write_QControl_Tuning()
     plane.DataFlash.WriteBlock(&pkt, sizeof(pkt));
 }
 
+// Write a packet with the update() timing since the last reset_perf()
+void QuadPlane::Log_Write_QPerf()
+{
+    struct log_QPerf pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_QPRF_MSG),
+        time_us             : AP_HAL::micros64(),
+        num_updates         : perf.num_updates,
+        avg_us              : (uint16_t)(perf.num_updates ? perf.total_us / perf.num_updates : 0),
+        max_us              : perf.max_us,
+        num_transition      : perf.num_transition,
+        transition_avg_us   : (uint16_t)(perf.num_transition ? perf.transition_total_us / perf.num_transition : 0),
+        transition_max_us   : perf.transition_max_us,
+        num_shed            : perf.num_shed,
+    };
+    plane.DataFlash.WriteBlock(&pkt, sizeof(pkt));
+}
+
 
 /*
   calculate the forward throttle percentage. The forward throttle can
@@ -36,6 +36,7 @@ public:
     friend class AP_Tuning_Plane;
     friend class GCS_MAVLINK_Plane;
     friend class AP_AdvancedFailsafe_Plane;
+    friend class AP_Arming_Plane;
     
     QuadPlane(AP_AHRS_NavEKF &_ahrs);
 
@@ -68,6 +69,12 @@ public:
     bool in_assisted_flight(void) const {
         return available() && assisted_flight;
     }
+
+    // are both the fixed wing and VTOL controllers running, either
+    // during a transition or while assisting?
+    bool in_transition(void) const {
+        return available() && (assisted_flight || transition_state < TRANSITION_DONE);
+    }
     
     bool handle_do_vtol_transition(enum MAV_VTOL_STATE state);
 
@@ -108,6 +115,18 @@ public:
         float    dax;
         float    day;
     };
+
+    struct PACKED log_QPerf {
+        LOG_PACKET_HEADER;
+        uint64_t time_us;
+        uint16_t num_updates;
+        uint16_t avg_us;
+        uint16_t max_us;
+        uint16_t num_transition;
+        uint16_t transition_avg_us;
+        uint16_t transition_max_us;
+        uint16_t num_shed;
+    };
         
 private:
     AP_AHRS_NavEKF &ahrs;
@@ -143,6 +162,15 @@ private:
     // update transition handling
     void update_transition(void);
 
+    // run the VTOL motors and controllers for this loop
+    void update_control(void);
+
+    // slow down non-essential tasks while in transition
+    void update_load_shedding(void);
+
+    // follow a change of the main loop rate
+    void set_loop_rate(uint16_t loop_rate_hz);
+
     // hold hover (for transition)
     void hold_hover(float target_climb_rate);    
 
@@ -185,6 +213,10 @@ private:
     bool should_relax(void);
     void motors_output(void);
     void Log_Write_QControl_Tuning();
+    void Log_Write_QPerf();
+
+    // clear the update() timing statistics
+    void reset_perf(void);
     float landing_descent_rate_cms(float height_above_ground);
     
     // setup correct aux channels for frame class
@@ -327,6 +359,20 @@ private:
 
     // time of last control log message
     uint32_t last_ctrl_log_ms;
+
+    // rate divisor for non-essential tasks while in transition
+    AP_Int8 shed_divisor;
+
+    // timing of update() since the last reset_perf()
+    struct {
+        uint32_t total_us;
+        uint32_t transition_total_us;
+        uint16_t num_updates;
+        uint16_t max_us;
+        uint16_t num_transition;
+        uint16_t transition_max_us;
+        uint16_t num_shed;
+    } perf;
     
     // tiltrotor control variables
     struct {
@@ -1,66 +1,504 @@
 #include "DataFlashFileReader.h"
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <unistd.h>
 
+#define LOGINDEX_MAGIC   "APIX"
+#define LOGINDEX_VERSION 1
+
+DataFlashFileReader::~DataFlashFileReader()
+{
+    if (map != nullptr) {
+        munmap(map, map_len);
+    }
+    free(idx_fmt);
+    free(idx_time);
+    if (fd != -1) {
+        ::close(fd);
+    }
+}
+
 bool DataFlashFileReader::open_log(const char *logfile)
 {
     fd = ::open(logfile, O_RDONLY);
     if (fd == -1) {
         return false;
     }
+
+    // compressed logs start with a magic string
+    char magic[DATAFLASH_LZ_FILE_MAGIC_LEN];
+    if (::read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+        memcmp(magic, DATAFLASH_LZ_FILE_MAGIC, sizeof(magic)) == 0) {
+        compressed = true;
+        ::printf("Reading compressed log\n");
+        return true;
+    }
+    if (::lseek(fd, 0, SEEK_SET) == (off_t)-1) {
+        return false;
+    }
+    if (!map_log(logfile)) {
+        // fall back to reading the file
+        ::printf("Unable to map log; reading sequentially\n");
+    }
     return true;
 }
 
-bool DataFlashFileReader::update(char type[5])
+/*
+  map the log into memory and load or build its index
+ */
+bool DataFlashFileReader::map_log(const char *logfile)
 {
-    uint8_t hdr[3];
-    if (::read(fd, hdr, 3) != 3) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
         return false;
     }
-    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
-        printf("bad log header\n");
+    void *p = mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
         return false;
     }
+    map = (uint8_t *)p;
+    map_len = st.st_size;
+    map_pos = 0;
+    // we mostly stream through the log once
+    madvise(map, map_len, MADV_SEQUENTIAL);
 
-    if (hdr[2] == LOG_FORMAT_MSG) {
-        struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (::read(fd, &f.type, sizeof(f)-3) != sizeof(f)-3) {
+    char *idxfile = nullptr;
+    if (asprintf(&idxfile, "%s.idx", logfile) == -1) {
+        idxfile = nullptr;
+    }
+    if (idxfile == nullptr || !load_index(idxfile, st.st_mtime)) {
+        if (!build_index()) {
+            munmap(map, map_len);
+            map = nullptr;
+            free(idxfile);
             return false;
         }
-        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
-        strncpy(type, "FMT", 3);
-        type[3] = 0;
+        idx_hdr.log_mtime = st.st_mtime;
+        if (idxfile != nullptr) {
+            save_index(idxfile);
+        }
+    }
+    free(idxfile);
+    return true;
+}
 
-        return handle_log_format_msg(f);
+/*
+  work out where a message format keeps its timestamp. Returns 0 for
+  none, 1 for a leading TimeUS and 2 for a leading TimeMS field
+ */
+static uint8_t timestamp_kind(const struct log_Format &f)
+{
+    if (f.format[0] == 'Q' && strncmp(f.labels, "TimeUS", 6) == 0 &&
+        (f.labels[6] == ',' || f.labels[6] == 0)) {
+        return 1;
     }
+    if (f.format[0] == 'I' && strncmp(f.labels, "TimeMS", 6) == 0 &&
+        (f.labels[6] == ',' || f.labels[6] == 0)) {
+        return 2;
+    }
+    return 0;
+}
 
-    if (!done_format_msgs) {
-        done_format_msgs = true;
-        end_format_msgs();
+static bool message_time(uint8_t kind, const uint8_t *msg, uint64_t &time_us)
+{
+    switch (kind) {
+    case 1:
+        memcpy(&time_us, &msg[3], sizeof(time_us));
+        return true;
+    case 2: {
+        uint32_t time_ms;
+        memcpy(&time_ms, &msg[3], sizeof(time_ms));
+        time_us = time_ms * 1000ULL;
+        return true;
     }
+    }
+    return false;
+}
+
+/*
+  scan the mapped log once, building the message index
+ */
+bool DataFlashFileReader::build_index(void)
+{
+    ::printf("Indexing log\n");
+
+    uint8_t length[256] {};
+    uint8_t tkind[256] {};
+    uint32_t fmt_size = 0;
+    uint32_t time_size = 0;
+
+    memset(&idx_hdr, 0, sizeof(idx_hdr));
+    memcpy(idx_hdr.magic, LOGINDEX_MAGIC, sizeof(idx_hdr.magic));
+    idx_hdr.version = LOGINDEX_VERSION;
+    idx_hdr.log_size = map_len;
 
-    const struct log_Format &f = formats[hdr[2]];
-    if (f.length == 0) {
-        // can't just throw these away as the format specifies the
-        // number of bytes in the message
-        ::printf("No format defined for type (%d)\n", hdr[2]);
-        exit(1);
+    uint64_t next_stride = 0;
+    uint64_t ofs = 0;
+    while (map_len - ofs >= 3) {
+        const uint8_t *msg = &map[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            // the readers stop here too
+            break;
+        }
+        const uint8_t type = msg[2];
+        uint16_t len;
+        if (type == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            if (map_len - ofs < sizeof(f)) {
+                break;
+            }
+            memcpy(&f, msg, sizeof(f));
+            length[f.type] = f.length;
+            tkind[f.type] = timestamp_kind(f);
+            if (idx_hdr.num_fmt == fmt_size) {
+                fmt_size = fmt_size ? fmt_size * 2 : 256;
+                idx_fmt = (uint64_t *)realloc(idx_fmt, fmt_size * sizeof(idx_fmt[0]));
+                if (idx_fmt == nullptr) {
+                    return false;
+                }
+            }
+            idx_fmt[idx_hdr.num_fmt++] = ofs;
+            len = sizeof(f);
+        } else {
+            len = length[type];
+            if (len == 0 || map_len - ofs < len) {
+                break;
+            }
+            uint64_t time_us;
+            if (ofs >= next_stride && message_time(tkind[type], msg, time_us)) {
+                if (idx_hdr.num_time == time_size) {
+                    time_size = time_size ? time_size * 2 : 1024;
+                    idx_time = (struct index_time *)realloc(idx_time, time_size * sizeof(idx_time[0]));
+                    if (idx_time == nullptr) {
+                        return false;
+                    }
+                }
+                idx_time[idx_hdr.num_time].offset = ofs;
+                idx_time[idx_hdr.num_time].time_us = time_us;
+                idx_hdr.num_time++;
+                next_stride = ofs - (ofs % LOGINDEX_STRIDE) + LOGINDEX_STRIDE;
+            }
+        }
+        idx_hdr.counts[type]++;
+        ofs += len;
     }
+    return true;
+}
 
-    uint8_t msg[f.length];
+/*
+  load a cached index if it matches the log
+ */
+bool DataFlashFileReader::load_index(const char *idxfile, int64_t mtime)
+{
+    int ifd = ::open(idxfile, O_RDONLY);
+    if (ifd == -1) {
+        return false;
+    }
+    bool ok = false;
+    if (::read(ifd, &idx_hdr, sizeof(idx_hdr)) == sizeof(idx_hdr) &&
+        memcmp(idx_hdr.magic, LOGINDEX_MAGIC, sizeof(idx_hdr.magic)) == 0 &&
+        idx_hdr.version == LOGINDEX_VERSION &&
+        idx_hdr.log_size == map_len &&
+        idx_hdr.log_mtime == mtime) {
+        const ssize_t fmt_len = idx_hdr.num_fmt * sizeof(idx_fmt[0]);
+        const ssize_t time_len = idx_hdr.num_time * sizeof(idx_time[0]);
+        idx_fmt = (uint64_t *)malloc(fmt_len + 1);
+        idx_time = (struct index_time *)malloc(time_len + 1);
+        ok = idx_fmt != nullptr && idx_time != nullptr &&
+            ::read(ifd, idx_fmt, fmt_len) == fmt_len &&
+            ::read(ifd, idx_time, time_len) == time_len;
+        if (!ok) {
+            free(idx_fmt);
+            free(idx_time);
+            idx_fmt = nullptr;
+            idx_time = nullptr;
+        }
+    }
+    ::close(ifd);
+    return ok;
+}
+
+/*
+  cache the index next to the log. Failure (e.g. a read-only
+  directory) just means the index is rebuilt next time
+ */
+void DataFlashFileReader::save_index(const char *idxfile) const
+{
+    int ifd = ::open(idxfile, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (ifd == -1) {
+        return;
+    }
+    const ssize_t fmt_len = idx_hdr.num_fmt * sizeof(idx_fmt[0]);
+    const ssize_t time_len = idx_hdr.num_time * sizeof(idx_time[0]);
+    if (::write(ifd, &idx_hdr, sizeof(idx_hdr)) != sizeof(idx_hdr) ||
+        ::write(ifd, idx_fmt, fmt_len) != fmt_len ||
+        ::write(ifd, idx_time, time_len) != time_len) {
+        ::close(ifd);
+        unlink(idxfile);
+        return;
+    }
+    ::close(ifd);
+}
+
+bool DataFlashFileReader::message_count(const char *name, uint32_t &count) const
+{
+    if (map == nullptr) {
+        return false;
+    }
+    count = 0;
+    for (uint32_t i=0; i<idx_hdr.num_fmt; i++) {
+        const struct log_Format *f = (const struct log_Format *)&map[idx_fmt[i]];
+        if (strncmp(f->name, name, sizeof(f->name)) == 0) {
+            count = idx_hdr.counts[f->type];
+            break;
+        }
+    }
+    return true;
+}
+
+bool DataFlashFileReader::seek_time(uint64_t time_us)
+{
+    if (map == nullptr) {
+        return false;
+    }
+
+    // find the last index entry before the target time
+    uint32_t lo = 0, hi = idx_hdr.num_time;
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (idx_time[mid].time_us < time_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    uint64_t target = lo > 0 ? idx_time[lo-1].offset : 0;
+
+    char type[5];
+    if (target > map_pos) {
+        // don't lose format messages we are skipping over
+        for (uint32_t i=0; i<idx_hdr.num_fmt; i++) {
+            if (idx_fmt[i] >= map_pos && idx_fmt[i] < target) {
+                struct log_Format f;
+                memcpy(&f, &map[idx_fmt[i]], sizeof(f));
+                handle_format(f, type);
+            }
+        }
+    }
+    map_pos = target;
+
+    // step forward to the first message at or after the target time
+    while (map_len - map_pos >= 3) {
+        const uint8_t *msg = &map[map_pos];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            return false;
+        }
+        if (msg[2] == LOG_FORMAT_MSG) {
+            if (map_len - map_pos < sizeof(struct log_Format)) {
+                return false;
+            }
+            struct log_Format f;
+            memcpy(&f, msg, sizeof(f));
+            handle_format(f, type);
+            map_pos += sizeof(f);
+            continue;
+        }
+        const struct log_Format &f = formats[msg[2]];
+        if (f.length == 0) {
+            return false;
+        }
+        uint64_t t;
+        if (message_time(timestamp_kind(f), msg, t) && t >= time_us) {
+            break;
+        }
+        map_pos += f.length;
+    }
+    return true;
+}
 
-    memcpy(msg, hdr, 3);
-    if (::read(fd, &msg[3], f.length-3) != f.length-3) {
+/*
+  read and decompress the next block of a compressed log
+ */
+bool DataFlashFileReader::read_block(void)
+{
+    uint8_t hdr[DATAFLASH_LZ_HEADER_LEN];
+    if (::read(fd, hdr, sizeof(hdr)) != sizeof(hdr)) {
         return false;
     }
+    uint16_t raw_len, stored_len;
+    DataFlash_LZ::unpack_header(hdr, raw_len, stored_len);
+    if (stored_len > raw_len) {
+        ::printf("bad compressed block header\n");
+        return false;
+    }
+    if (stored_len == raw_len) {
+        if (::read(fd, block, raw_len) != raw_len) {
+            return false;
+        }
+    } else {
+        if (::read(fd, block_in, stored_len) != stored_len) {
+            return false;
+        }
+        if (DataFlash_LZ::decompress(block_in, stored_len, block, sizeof(block)) != raw_len) {
+            ::printf("corrupt compressed block\n");
+            return false;
+        }
+    }
+    block_len = raw_len;
+    block_ofs = 0;
+    return true;
+}
 
-    strncpy(type, f.name, 4);
-    type[4] = 0;
+bool DataFlashFileReader::read_input(void *buf, uint32_t len)
+{
+    if (!compressed) {
+        return ::read(fd, buf, len) == (ssize_t)len;
+    }
+    // messages may span block boundaries
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        if (block_ofs == block_len && !read_block()) {
+            return false;
+        }
+        const uint16_t n = MIN(len, (uint32_t)(block_len - block_ofs));
+        memcpy(p, &block[block_ofs], n);
+        block_ofs += n;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
 
-    return handle_msg(f,msg);
+bool DataFlashFileReader::handle_format(const struct log_Format &f, char type[5])
+{
+    memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+    filtered[f.type] = false;
+    if (type_filter != nullptr) {
+        filtered[f.type] = true;
+        for (uint8_t i=0; type_filter[i] != nullptr; i++) {
+            if (strncmp(f.name, type_filter[i], sizeof(f.name)) == 0) {
+                filtered[f.type] = false;
+                break;
+            }
+        }
+    }
+    strncpy(type, "FMT", 3);
+    type[3] = 0;
+
+    return handle_log_format_msg(f);
+}
+
+/*
+  return the next message straight from the mapped log
+ */
+bool DataFlashFileReader::update_mapped(char type[5])
+{
+    while (true) {
+        if (map_len - map_pos < 3) {
+            return false;
+        }
+        uint8_t *msg = &map[map_pos];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            printf("bad log header\n");
+            return false;
+        }
+
+        if (msg[2] == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            if (map_len - map_pos < sizeof(f)) {
+                return false;
+            }
+            memcpy(&f, msg, sizeof(f));
+            map_pos += sizeof(f);
+            return handle_format(f, type);
+        }
+
+        if (!done_format_msgs) {
+            done_format_msgs = true;
+            end_format_msgs();
+        }
+
+        const struct log_Format &f = formats[msg[2]];
+        if (f.length == 0) {
+            // can't just throw these away as the format specifies the
+            // number of bytes in the message
+            ::printf("No format defined for type (%d)\n", msg[2]);
+            exit(1);
+        }
+        if (map_len - map_pos < f.length) {
+            return false;
+        }
+        map_pos += f.length;
+
+        if (filtered[msg[2]]) {
+            continue;
+        }
+
+        strncpy(type, f.name, 4);
+        type[4] = 0;
+
+        return handle_msg(f, msg);
+    }
+}
+
+bool DataFlashFileReader::update(char type[5])
+{
+    if (map != nullptr) {
+        return update_mapped(type);
+    }
+
+    while (true) {
+        uint8_t hdr[3];
+        if (!read_input(hdr, 3)) {
+            return false;
+        }
+        if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+            printf("bad log header\n");
+            return false;
+        }
+
+        if (hdr[2] == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            memcpy(&f, hdr, 3);
+            if (!read_input(&f.type, sizeof(f)-3)) {
+                return false;
+            }
+            return handle_format(f, type);
+        }
+
+        if (!done_format_msgs) {
+            done_format_msgs = true;
+            end_format_msgs();
+        }
+
+        const struct log_Format &f = formats[hdr[2]];
+        if (f.length == 0) {
+            // can't just throw these away as the format specifies the
+            // number of bytes in the message
+            ::printf("No format defined for type (%d)\n", hdr[2]);
+            exit(1);
+        }
+
+        uint8_t msg[f.length];
+
+        memcpy(msg, hdr, 3);
+        if (!read_input(&msg[3], f.length-3)) {
+            return false;
+        }
+
+        if (filtered[hdr[2]]) {
+            continue;
+        }
+
+        strncpy(type, f.name, 4);
+        type[4] = 0;
+
+        return handle_msg(f,msg);
+    }
 }
@@ -1,16 +1,39 @@
 #pragma once
 
 #include <DataFlash/DataFlash.h>
+#include <DataFlash/DataFlash_LZ.h>
 
 class DataFlashFileReader
 {
 public:
+    virtual ~DataFlashFileReader();
+
     bool open_log(const char *logfile);
     bool update(char type[5]);
 
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
+    /*
+      the following use the message index, which is only available
+      for uncompressed logs (which are memory mapped)
+     */
+    bool indexed(void) const { return map != nullptr; }
+
+    // number of messages of the named type in the log. Returns
+    // false if there is no index
+    bool message_count(const char *name, uint32_t &count) const;
+
+    // seek so that the next message returned is at or shortly
+    // before the first one with a timestamp of at least time_us.
+    // FMT messages passed over are still handled
+    bool seek_time(uint64_t time_us);
+
+    // only pass messages of the listed types (and FMT messages) on
+    // to handle_msg. The list is NULL-terminated and must outlive
+    // the reader. NULL passes all messages
+    void set_type_filter(const char **types) { type_filter = types; }
+
 protected:
     int fd = -1;
     bool done_format_msgs = false;
@@ -18,4 +41,57 @@ protected:
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
+
+    // read len bytes of log data, decompressing if needed
+    bool read_input(void *buf, uint32_t len);
+
+private:
+    bool handle_format(const struct log_Format &f, char type[5]);
+    bool update_mapped(char type[5]);
+
+    const char **type_filter = nullptr;
+    bool filtered[256] {};
+
+    // state for logs written with LOG_FILE_COMPRESS
+    bool compressed = false;
+    bool read_block(void);
+    uint8_t block[DATAFLASH_LZ_MAX_BLOCK];
+    uint8_t block_in[DATAFLASH_LZ_MAX_BLOCK];
+    uint16_t block_len = 0;
+    uint16_t block_ofs = 0;
+
+    // memory mapped log. The mapping is private and writable so
+    // handlers may modify messages in place without touching the file
+    uint8_t *map = nullptr;
+    uint64_t map_len = 0;
+    uint64_t map_pos = 0;
+
+    /*
+      message index, cached in a "<log>.idx" sidecar file. Holds the
+      per-type message counts, the offsets of all FMT messages, and
+      the offset and timestamp of the first timestamped message in
+      each LOGINDEX_STRIDE bytes of the log
+     */
+#define LOGINDEX_STRIDE 65536
+    struct PACKED index_header {
+        char magic[4];
+        uint32_t version;
+        uint64_t log_size;
+        int64_t log_mtime;
+        uint32_t num_fmt;
+        uint32_t num_time;
+        uint32_t counts[256];
+    };
+    struct PACKED index_time {
+        uint64_t offset;
+        uint64_t time_us;
+    };
+    struct index_header idx_hdr;
+    uint64_t *idx_fmt = nullptr;
+    struct index_time *idx_time = nullptr;
+
+    bool map_log(const char *logfile);
+    bool build_index(void);
+    bool load_index(const char *idxfile, int64_t mtime);
+    void save_index(const char *idxfile) const;
 };
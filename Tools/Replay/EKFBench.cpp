@@ -0,0 +1,257 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  timing of the replayed EKF2, see --bench
+ */
+
+#include "EKFBench.h"
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <AP_Math/AP_Math.h>
+
+extern const AP_HAL::HAL &hal;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_nsec + ts.tv_sec * 1000000000ULL;
+}
+
+EKFBench::~EKFBench()
+{
+    for (uint8_t i=0; i<HW_NUM; i++) {
+        if (hw_fd[i] != -1) {
+            close(hw_fd[i]);
+        }
+    }
+    free(passes);
+}
+
+/*
+  open the hardware counters as one group, so a single read returns
+  them all. Kernel time is excluded, which also lets this work with
+  the default perf_event_paranoid setting
+ */
+void EKFBench::start(void)
+{
+    static const uint64_t configs[HW_NUM] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+    };
+
+    start_ns = now_ns();
+
+    for (uint8_t i=0; i<HW_NUM; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = (i == 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        hw_fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : hw_fd[0], 0);
+        if (hw_fd[i] == -1) {
+            ::fprintf(stderr, "No hardware counters: %s\n", strerror(errno));
+            for (uint8_t j=0; j<i; j++) {
+                close(hw_fd[j]);
+                hw_fd[j] = -1;
+            }
+            return;
+        }
+    }
+
+    ioctl(hw_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(hw_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    result.have_hw = 1;
+}
+
+bool EKFBench::read_hw(uint64_t values[HW_NUM]) const
+{
+    struct {
+        uint64_t nr;
+        uint64_t values[HW_NUM];
+    } buf;
+
+    if (read(hw_fd[0], &buf, sizeof(buf)) != sizeof(buf) || buf.nr != HW_NUM) {
+        return false;
+    }
+    memcpy(values, buf.values, sizeof(buf.values));
+    return true;
+}
+
+void EKFBench::begin_update(void)
+{
+    hw_started = result.have_hw && read_hw(hw_start);
+}
+
+void EKFBench::end_update(void)
+{
+    uint64_t values[HW_NUM];
+    if (!hw_started || !read_hw(values)) {
+        return;
+    }
+    for (uint8_t i=0; i<HW_NUM; i++) {
+        result.hw[i] += values[i] - hw_start[i];
+    }
+    result.hw_updates++;
+}
+
+/*
+  gather the EK2_* elapsed counters. Each core has its own set with
+  the same names, so they are merged: the counts add up, the mean is
+  weighted by count, and the percentiles are those of the worst core
+ */
+void EKFBench::collect_stages(void)
+{
+    AP_HAL::Util::perf_counter_info info;
+    for (uint16_t i=0; hal.util->perf_get_info(i, info); i++) {
+        if (info.count == 0 || strncmp(info.name, "EK2_", 4) != 0) {
+            continue;
+        }
+        struct stage_result *stage = nullptr;
+        for (uint8_t s=0; s<result.num_stages; s++) {
+            if (strncmp(result.stages[s].name, info.name, sizeof(stage->name)) == 0) {
+                stage = &result.stages[s];
+                break;
+            }
+        }
+        if (stage == nullptr) {
+            if (result.num_stages == MAX_STAGES) {
+                continue;
+            }
+            stage = &result.stages[result.num_stages++];
+            strncpy(stage->name, info.name, sizeof(stage->name) - 1);
+        }
+        const uint32_t count = stage->count + info.count;
+        stage->avg_us = (stage->avg_us * stage->count + info.avg_us * info.count) / count;
+        stage->count = count;
+        stage->p50_us = MAX(stage->p50_us, info.p50_us);
+        stage->p99_us = MAX(stage->p99_us, info.p99_us);
+        stage->max_us = MAX(stage->max_us, info.max_us);
+    }
+}
+
+bool EKFBench::send_results(int fd)
+{
+    result.wall_s = (now_ns() - start_ns) * 1.0e-9f;
+    collect_stages();
+    return write(fd, &result, sizeof(result)) == sizeof(result);
+}
+
+bool EKFBench::receive_results(int fd)
+{
+    struct pass_result pass;
+    if (read(fd, &pass, sizeof(pass)) != sizeof(pass)) {
+        return false;
+    }
+    struct pass_result *p = (struct pass_result *)realloc(passes, (num_passes+1) * sizeof(passes[0]));
+    if (p == nullptr) {
+        return false;
+    }
+    passes = p;
+    passes[num_passes++] = pass;
+    return true;
+}
+
+const struct EKFBench::stage_result *EKFBench::find_stage(const struct pass_result &pass, const char *name) const
+{
+    for (uint8_t s=0; s<pass.num_stages; s++) {
+        if (strncmp(pass.stages[s].name, name, sizeof(pass.stages[s].name)) == 0) {
+            return &pass.stages[s];
+        }
+    }
+    return nullptr;
+}
+
+/*
+  per stage: calls per pass, the mean time per call with its spread
+  over the passes, and the worst percentiles of any pass
+ */
+void EKFBench::report(void) const
+{
+    if (num_passes == 0) {
+        return;
+    }
+
+    float wall_s = 0;
+    for (uint16_t i=0; i<num_passes; i++) {
+        wall_s += passes[i].wall_s;
+    }
+    ::printf("\n%u passes, %.2f s per pass\n", (unsigned)num_passes, wall_s / num_passes);
+    ::printf("%-26s %10s %9s %9s %7s %7s %7s\n",
+             "stage (us per call)", "calls", "mean", "stddev", "p50", "p99", "max");
+
+    for (uint8_t s=0; s<passes[0].num_stages; s++) {
+        const char *name = passes[0].stages[s].name;
+        float sum = 0;
+        float sum_sq = 0;
+        uint64_t calls = 0;
+        uint16_t n = 0;
+        uint32_t p50 = 0, p99 = 0, max_us = 0;
+        for (uint16_t i=0; i<num_passes; i++) {
+            const struct stage_result *stage = find_stage(passes[i], name);
+            if (stage == nullptr) {
+                continue;
+            }
+            sum += stage->avg_us;
+            sum_sq += sq(stage->avg_us);
+            calls += stage->count;
+            p50 = MAX(p50, stage->p50_us);
+            p99 = MAX(p99, stage->p99_us);
+            max_us = MAX(max_us, stage->max_us);
+            n++;
+        }
+        const float mean = sum / n;
+        const float stddev = sqrtf(MAX(sum_sq / n - sq(mean), 0));
+        ::printf("%-26.24s %10llu %9.2f %9.2f %7u %7u %7u\n",
+                 name, (unsigned long long)(calls / n), mean, stddev,
+                 (unsigned)p50, (unsigned)p99, (unsigned)max_us);
+    }
+
+    uint64_t hw[HW_NUM] {};
+    uint64_t updates = 0;
+    for (uint16_t i=0; i<num_passes; i++) {
+        if (!passes[i].have_hw) {
+            continue;
+        }
+        for (uint8_t h=0; h<HW_NUM; h++) {
+            hw[h] += passes[i].hw[h];
+        }
+        updates += passes[i].hw_updates;
+    }
+    if (updates == 0) {
+        ::printf("No hardware counters\n");
+        return;
+    }
+    ::printf("per UpdateFilter() call: %.0f cycles, %.0f instructions (%.2f IPC), %.1f cache misses\n",
+             (double)hw[HW_CYCLES] / updates,
+             (double)hw[HW_INSTRUCTIONS] / updates,
+             hw[HW_CYCLES] ? (double)hw[HW_INSTRUCTIONS] / hw[HW_CYCLES] : 0.0,
+             (double)hw[HW_CACHE_MISSES] / updates);
+}
@@ -0,0 +1,93 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/AP_HAL.h>
+
+/*
+  CPU cost of EKF2 over a replayed log, for --bench. Each pass runs in
+  its own forked worker, which sends its results back to the parent
+  through a pipe. The parent reports the spread over all passes.
+
+  Stage times come from the EK2_* HAL perf counters, merged over the
+  cores. The worker also reads the cycle, instruction and cache miss
+  counters with perf_event around each UpdateFilter() call, if the
+  kernel allows it. Only the calling thread is counted, so the cores
+  run on worker threads (EK2_THREADS) are not included
+*/
+class EKFBench {
+public:
+    ~EKFBench();
+
+    // in the worker: open the hardware counters
+    void start(void);
+
+    // in the worker: wrap each NavEKF2::UpdateFilter() call
+    void begin_update(void);
+    void end_update(void);
+
+    // in the worker: send the results of this pass
+    bool send_results(int fd);
+
+    // in the parent: read the results of one pass
+    bool receive_results(int fd);
+
+    // in the parent: print the statistics over all passes
+    void report(void) const;
+
+private:
+    static const uint8_t MAX_STAGES = 24;
+
+    enum hw_counter {
+        HW_CYCLES,
+        HW_INSTRUCTIONS,
+        HW_CACHE_MISSES,
+        HW_NUM
+    };
+
+    struct PACKED stage_result {
+        char name[24];
+        uint32_t count;
+        float avg_us;
+        uint32_t p50_us;
+        uint32_t p99_us;
+        uint32_t max_us;
+    };
+
+    struct PACKED pass_result {
+        float wall_s;
+        uint8_t num_stages;
+        uint8_t have_hw;
+        uint32_t hw_updates;
+        uint64_t hw[HW_NUM];
+        struct stage_result stages[MAX_STAGES];
+    };
+
+    // state of the worker
+    int hw_fd[HW_NUM] = { -1, -1, -1 };
+    uint64_t hw_start[HW_NUM];
+    bool hw_started = false;
+    struct pass_result result {};
+    uint64_t start_ns;
+
+    // results gathered by the parent
+    struct pass_result *passes = nullptr;
+    uint16_t num_passes = 0;
+
+    bool read_hw(uint64_t values[HW_NUM]) const;
+    void collect_stages(void);
+    const struct stage_result *find_stage(const struct pass_result &pass, const char *name) const;
+};
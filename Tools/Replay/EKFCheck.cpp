@@ -0,0 +1,315 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  compare logged NKF records with the replayed EKF2
+ */
+
+#include "EKFCheck.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ANGLE(label)    { label, CHECK_ANGLE, 0 }
+#define YAW(label)      { label, CHECK_YAW,   0 }
+#define POS(label)      { label, CHECK_POS,   0 }
+#define VEL(label)      { label, CHECK_VEL,   0 }
+#define FIXED(label, t) { label, CHECK_FIXED, t }
+
+/*
+  fields checked in each record, in the order replayed_values() fills
+  them. Fixed tolerances are in logged units, see Log_Write_EKF2()
+ */
+const struct EKFCheck::field_check EKFCheck::nkf1_fields[] = {
+    ANGLE("Roll"), ANGLE("Pitch"), YAW("Yaw"),
+    VEL("VN"), VEL("VE"), VEL("VD"),
+    POS("PN"), POS("PE"), POS("PD"),
+    // gyro bias, cdeg/s
+    FIXED("GX", 50), FIXED("GY", 50), FIXED("GZ", 50),
+};
+
+const struct EKFCheck::field_check EKFCheck::nkf2_fields[] = {
+    // cm/s/s
+    FIXED("AZbias", 20),
+    // wind, cm/s
+    FIXED("VWN", 100), FIXED("VWE", 100),
+    // earth and body field, milligauss
+    FIXED("MN", 50), FIXED("ME", 50), FIXED("MD", 50),
+    FIXED("MX", 50), FIXED("MY", 50), FIXED("MZ", 50),
+};
+
+const struct EKFCheck::field_check EKFCheck::nkf3_fields[] = {
+    // velocity and position innovations, cm/s and cm
+    FIXED("IVN", 100), FIXED("IVE", 100), FIXED("IVD", 100),
+    FIXED("IPN", 200), FIXED("IPE", 200), FIXED("IPD", 200),
+    // milligauss
+    FIXED("IMX", 50), FIXED("IMY", 50), FIXED("IMZ", 50),
+};
+
+const struct EKFCheck::field_check EKFCheck::nkf4_fields[] = {
+    // innovation test ratios, times 100
+    FIXED("SV", 30), FIXED("SP", 30), FIXED("SH", 30), FIXED("SM", 30),
+    // radians
+    FIXED("errRP", 0.05f),
+};
+
+const struct EKFCheck::field_check EKFCheck::nkf5_fields[] = {
+    // cm
+    FIXED("HAGL", 100), FIXED("offset", 100),
+    // output predictor tracking errors, rad, m/s and m
+    FIXED("eAng", 0.05f), FIXED("eVel", 0.5f), FIXED("ePos", 0.5f),
+};
+
+const struct EKFCheck::kind_info EKFCheck::kinds[NUM_KINDS] = {
+    { nkf1_fields, ARRAY_SIZE(nkf1_fields) },
+    { nkf2_fields, ARRAY_SIZE(nkf2_fields) },
+    { nkf3_fields, ARRAY_SIZE(nkf3_fields) },
+    { nkf4_fields, ARRAY_SIZE(nkf4_fields) },
+    { nkf5_fields, ARRAY_SIZE(nkf5_fields) },
+};
+
+float EKFCheck::tolerance_for(const struct field_check &field) const
+{
+    switch (field.type) {
+    case CHECK_ANGLE:
+    case CHECK_YAW:
+        return tolerance_euler * 100;
+    case CHECK_POS:
+        return tolerance_pos;
+    case CHECK_VEL:
+        return tolerance_vel;
+    case CHECK_FIXED:
+        break;
+    }
+    return field.tolerance;
+}
+
+/*
+  fill values with the replayed state for a record, scaled as
+  Log_Write_EKF2() scales it
+ */
+bool EKFCheck::replayed_values(uint8_t kind, int8_t core, float values[MAX_CHECK_FIELDS])
+{
+    switch (kind) {
+    case 0: {
+        Vector3f euler, velNED, gyroBias;
+        Vector2f posNE;
+        float posD = 0;
+        ekf.getEulerAngles(core, euler);
+        ekf.getVelNED(core, velNED);
+        ekf.getPosNE(core, posNE);
+        ekf.getPosD(core, posD);
+        ekf.getGyroBias(core, gyroBias);
+        values[0] = (int16_t)(100*degrees(euler.x));
+        values[1] = (int16_t)(100*degrees(euler.y));
+        values[2] = (uint16_t)wrap_360_cd(100*degrees(euler.z));
+        values[3] = velNED.x;
+        values[4] = velNED.y;
+        values[5] = velNED.z;
+        values[6] = posNE.x;
+        values[7] = posNE.y;
+        values[8] = posD;
+        values[9] = (int16_t)(100*degrees(gyroBias.x));
+        values[10] = (int16_t)(100*degrees(gyroBias.y));
+        values[11] = (int16_t)(100*degrees(gyroBias.z));
+        return true;
+    }
+    case 1: {
+        float azbias = 0;
+        Vector3f wind, magNED, magXYZ;
+        ekf.getAccelZBias(core, azbias);
+        ekf.getWind(core, wind);
+        ekf.getMagNED(core, magNED);
+        ekf.getMagXYZ(core, magXYZ);
+        values[0] = (int8_t)(100*azbias);
+        values[1] = (int16_t)(100*wind.x);
+        values[2] = (int16_t)(100*wind.y);
+        values[3] = (int16_t)magNED.x;
+        values[4] = (int16_t)magNED.y;
+        values[5] = (int16_t)magNED.z;
+        values[6] = (int16_t)magXYZ.x;
+        values[7] = (int16_t)magXYZ.y;
+        values[8] = (int16_t)magXYZ.z;
+        return true;
+    }
+    case 2: {
+        Vector3f velInnov, posInnov, magInnov;
+        float tasInnov = 0, yawInnov = 0;
+        ekf.getInnovations(core, velInnov, posInnov, magInnov, tasInnov, yawInnov);
+        values[0] = (int16_t)(100*velInnov.x);
+        values[1] = (int16_t)(100*velInnov.y);
+        values[2] = (int16_t)(100*velInnov.z);
+        values[3] = (int16_t)(100*posInnov.x);
+        values[4] = (int16_t)(100*posInnov.y);
+        values[5] = (int16_t)(100*posInnov.z);
+        values[6] = (int16_t)magInnov.x;
+        values[7] = (int16_t)magInnov.y;
+        values[8] = (int16_t)magInnov.z;
+        return true;
+    }
+    case 3: {
+        float velVar = 0, posVar = 0, hgtVar = 0, tasVar = 0, tiltError = 0;
+        Vector3f magVar;
+        Vector2f offset;
+        ekf.getVariances(core, velVar, posVar, hgtVar, magVar, tasVar, offset);
+        ekf.getTiltError(core, tiltError);
+        values[0] = (int16_t)(100*velVar);
+        values[1] = (int16_t)(100*posVar);
+        values[2] = (int16_t)(100*hgtVar);
+        values[3] = (int16_t)(100*fmaxf(fmaxf(magVar.x,magVar.y),magVar.z));
+        values[4] = tiltError;
+        return true;
+    }
+    case 4: {
+        float normInnov=0, gndOffset=0, flowInnovX=0, flowInnovY=0, auxFlowInnov=0;
+        float HAGL=0, rngInnov=0, range=0, gndOffsetErr=0;
+        Vector3f predictorErrors;
+        ekf.getFlowDebug(core, normInnov, gndOffset, flowInnovX, flowInnovY, auxFlowInnov,
+                         HAGL, rngInnov, range, gndOffsetErr);
+        ekf.getOutputTrackingError(core, predictorErrors);
+        values[0] = (int16_t)(100*HAGL);
+        values[1] = (int16_t)(100*gndOffset);
+        values[2] = predictorErrors.x;
+        values[3] = predictorErrors.y;
+        values[4] = predictorErrors.z;
+        return true;
+    }
+    }
+    return false;
+}
+
+/*
+  check one logged NKF record. The logged record was written just
+  after the onboard filter consumed the IMU sample before it in the
+  log, which is where replay has got to when the record is read
+ */
+void EKFCheck::check_message(const char *name, MsgHandler &handler, uint8_t *msg)
+{
+    // NKF1 to NKF5 are the first core (NKF5 from the primary core),
+    // NKF6 to NKF9 the second
+    const long num = strtol(&name[3], nullptr, 10);
+    if (num < 1 || num > 9) {
+        return;
+    }
+    const uint8_t kind = (num - 1) % NUM_KINDS;
+    const uint8_t core = (num - 1) / NUM_KINDS;
+    if (core >= ekf.activeCores()) {
+        // the replayed filter hasn't started this core
+        return;
+    }
+    const int8_t instance = (kind == 4) ? -1 : core;
+
+    const struct kind_info &info = kinds[kind];
+    float logged[MAX_CHECK_FIELDS];
+    bool have_field[MAX_CHECK_FIELDS];
+    for (uint8_t i=0; i<info.num_fields; i++) {
+        // older logs may lack some fields
+        have_field[i] = handler.field_value(msg, info.fields[i].label, logged[i]);
+    }
+    uint64_t time_us = 0;
+    handler.field_value(msg, "TimeUS", time_us);
+
+    float replayed[MAX_CHECK_FIELDS];
+    if (!replayed_values(kind, instance, replayed)) {
+        return;
+    }
+    records_checked++;
+
+    bool record_diverged = false;
+    for (uint8_t i=0; i<info.num_fields; i++) {
+        if (!have_field[i]) {
+            continue;
+        }
+        const struct field_check &field = info.fields[i];
+        float error;
+        if (field.type == CHECK_YAW) {
+            error = fabsf(wrap_180_cd(logged[i] - replayed[i]));
+        } else {
+            error = fabsf(logged[i] - replayed[i]);
+        }
+        struct field_state &st = state[core][kind][i];
+        st.max_error = MAX(st.max_error, error);
+        if (error > tolerance_for(field)) {
+            if (st.divergences++ == 0) {
+                st.first_divergence_us = time_us;
+            }
+            record_diverged = true;
+        }
+    }
+
+    if (record_diverged && !diverged) {
+        diverged = true;
+        show_divergence(name, core, time_us, info, have_field, logged, replayed);
+    }
+}
+
+/*
+  show the whole record where replay first diverged from the log
+ */
+void EKFCheck::show_divergence(const char *name, uint8_t core, uint64_t time_us,
+                               const struct kind_info &info, const bool have_field[],
+                               const float logged[], const float replayed[]) const
+{
+    ::printf("EKF diverged from log at %.3fs in %s (core %u, record %u)\n",
+             time_us*1.0e-6, name, (unsigned)core, (unsigned)records_checked);
+    ::printf("\t%-8s %12s %12s %12s\n", "field", "logged", "replayed", "tolerance");
+    for (uint8_t i=0; i<info.num_fields; i++) {
+        if (!have_field[i]) {
+            continue;
+        }
+        const struct field_check &field = info.fields[i];
+        const float tolerance = tolerance_for(field);
+        float error = fabsf(logged[i] - replayed[i]);
+        if (field.type == CHECK_YAW) {
+            error = fabsf(wrap_180_cd(logged[i] - replayed[i]));
+        }
+        ::printf("\t%-8s %12.3f %12.3f %12.3f%s\n",
+                 field.label, logged[i], replayed[i], tolerance,
+                 error > tolerance ? " *" : "");
+    }
+}
+
+/*
+  report the fields which diverged
+ */
+bool EKFCheck::report(const char *log_filename, FILE *results)
+{
+    uint16_t num_diverged = 0;
+    for (uint8_t core=0; core<MAX_CORES; core++) {
+        for (uint8_t kind=0; kind<NUM_KINDS; kind++) {
+            const struct kind_info &info = kinds[kind];
+            for (uint8_t i=0; i<info.num_fields; i++) {
+                const struct field_state &st = state[core][kind][i];
+                if (st.divergences == 0) {
+                    continue;
+                }
+                num_diverged++;
+                const unsigned msgnum = kind + 1 + core*NUM_KINDS;
+                ::printf("NKF%u.%s:\tmax error %.3f > %.3f, %u records from %.3fs\n",
+                         msgnum, info.fields[i].label,
+                         st.max_error, tolerance_for(info.fields[i]),
+                         (unsigned)st.divergences, st.first_divergence_us*1.0e-6);
+                if (results != nullptr) {
+                    fprintf(results, "%s\tNKF%u.%s\t%.3f\t%u\t%llu\n",
+                            log_filename, msgnum, info.fields[i].label,
+                            st.max_error, (unsigned)st.divergences,
+                            (unsigned long long)st.first_divergence_us);
+                }
+            }
+        }
+    }
+    ::printf("Checked %u EKF records, %u fields diverged\n",
+             (unsigned)records_checked, (unsigned)num_diverged);
+    return num_diverged != 0;
+}
@@ -0,0 +1,96 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_NavEKF2/AP_NavEKF2.h>
+
+#include "MsgHandler.h"
+
+/*
+  compare each NKF record in the log with the replayed EKF2 as the log
+  is read, recording the first divergence of each field and its
+  largest error. Values are compared in the units they are logged in
+*/
+class EKFCheck {
+public:
+    EKFCheck(NavEKF2 &_ekf) : ekf(_ekf) { }
+
+    void set_tolerances(float euler_deg, float pos_m, float vel_ms) {
+        tolerance_euler = euler_deg;
+        tolerance_pos = pos_m;
+        tolerance_vel = vel_ms;
+    }
+
+    // check a logged NKF record against the current replayed state
+    void check_message(const char *name, MsgHandler &handler, uint8_t *msg);
+
+    // print the results, append them to results (if not nullptr) and
+    // return true if any field diverged
+    bool report(const char *log_filename, FILE *results);
+
+private:
+    NavEKF2 &ekf;
+
+    float tolerance_euler = 3;
+    float tolerance_pos = 2;
+    float tolerance_vel = 2;
+
+    enum check_type {
+        CHECK_ANGLE,   // centi-degrees
+        CHECK_YAW,     // centi-degrees, wrapped
+        CHECK_POS,     // metres
+        CHECK_VEL,     // metres/second
+        CHECK_FIXED,   // tolerance in logged units
+    };
+
+    struct field_check {
+        const char *label;
+        enum check_type type;
+        float tolerance;
+    };
+
+    // NKF1 to NKF5. NKF6 to NKF9 are the same for the second core
+    static const uint8_t NUM_KINDS = 5;
+    static const uint8_t MAX_CHECK_FIELDS = 12;
+    static const uint8_t MAX_CORES = 2;
+
+    struct kind_info {
+        const struct field_check *fields;
+        uint8_t num_fields;
+    };
+    static const struct field_check nkf1_fields[];
+    static const struct field_check nkf2_fields[];
+    static const struct field_check nkf3_fields[];
+    static const struct field_check nkf4_fields[];
+    static const struct field_check nkf5_fields[];
+    static const struct kind_info kinds[NUM_KINDS];
+
+    struct field_state {
+        float max_error;
+        uint64_t first_divergence_us;
+        uint32_t divergences;
+    };
+    struct field_state state[MAX_CORES][NUM_KINDS][MAX_CHECK_FIELDS] {};
+    uint32_t records_checked = 0;
+
+    // first divergence seen, reported in full when it happens
+    bool diverged = false;
+
+    float tolerance_for(const struct field_check &field) const;
+    bool replayed_values(uint8_t kind, int8_t core, float values[MAX_CHECK_FIELDS]);
+    void show_divergence(const char *name, uint8_t core, uint64_t time_us,
+                         const struct kind_info &info, const bool have_field[],
+                         const float logged[], const float replayed[]) const;
+};
@@ -1,6 +1,7 @@
 #include "LR_MsgHandler.h"
 #include "LogReader.h"
 #include "Replay.h"
+#include "EKFCheck.h"
 
 extern const AP_HAL::HAL& hal;
 
@@ -73,9 +74,14 @@ void LR_MsgHandler_ARSP::process_message(uint8_t *msg)
 		    require_field_float(msg, "Temp"));
 }
 
-void LR_MsgHandler_NKF1::process_message(uint8_t *msg)
+void LR_MsgHandler_NKF::process_message(uint8_t *msg)
 {
     wait_timestamp_from_msg(msg);
+    if (ekf_check != nullptr) {
+        char name[5] {};
+        memcpy(name, f.name, 4);
+        ekf_check->check_message(name, *this, msg);
+    }
 }
 
 
@@ -2,6 +2,8 @@
 
 #include "MsgHandler.h"
 
+class EKFCheck;
+
 class LR_MsgHandler : public MsgHandler {
 public:
     LR_MsgHandler(struct log_Format &f,
@@ -69,14 +71,19 @@ private:
     AP_Airspeed &airspeed;
 };
 
-class LR_MsgHandler_NKF1 : public LR_MsgHandler
+class LR_MsgHandler_NKF : public LR_MsgHandler
 {
 public:
-    LR_MsgHandler_NKF1(log_Format &_f, DataFlash_Class &_dataflash,
-		    uint64_t &_last_timestamp_usec) :
-	LR_MsgHandler(_f, _dataflash, _last_timestamp_usec) { };
+    LR_MsgHandler_NKF(log_Format &_f, DataFlash_Class &_dataflash,
+                      uint64_t &_last_timestamp_usec, EKFCheck *_ekf_check) :
+	LR_MsgHandler(_f, _dataflash, _last_timestamp_usec),
+        ekf_check(_ekf_check) { };
 
     virtual void process_message(uint8_t *msg);
+
+private:
+    // compare the record with replay, if not nullptr
+    EKFCheck *ekf_check;
 };
 
 
@@ -152,7 +152,7 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	memcpy(name, f.name, 4);
 	debug("Defining log format for type (%d) (%s)\n", f.type, name);
 
-        if (save_message_type(name)) {
+        if (output && save_message_type(name)) {
             /* 
                any messages which we won't be generating internally in
                replay should get the original FMT header
@@ -259,9 +259,11 @@ bool LogReader::handle_log_format_msg(const struct log_Format &f)
 	    msgparser[f.type] = new LR_MsgHandler_ARSP(formats[f.type], dataflash,
                                                     last_timestamp_usec,
                                                     airspeed);
-	} else if (streq(name, "NKF1")) {
-	    msgparser[f.type] = new LR_MsgHandler_NKF1(formats[f.type], dataflash,
-                                                       last_timestamp_usec);
+	} else if (streq(name, "NKF1") ||
+                   (ekf_check != nullptr && strncmp(name, "NKF", 3) == 0)) {
+	    msgparser[f.type] = new LR_MsgHandler_NKF(formats[f.type], dataflash,
+                                                      last_timestamp_usec,
+                                                      ekf_check);
 	} else if (streq(name, "CHEK")) {
 	  msgparser[f.type] = new LR_MsgHandler_CHEK(formats[f.type], dataflash,
                                                      last_timestamp_usec,
@@ -286,9 +288,13 @@ bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
             printf("Unknown msgid %u\n", (unsigned)msg[2]);
             exit(1);
         }
-        msg[2] = mapped_msgid[msg[2]];
-        if (!in_list(name, nottypes)) {
-            dataflash.WriteBlock(msg, f.length);        
+        if (output && !in_list(name, nottypes)) {
+            // write a remapped copy; msg may point into the mapped
+            // log and modifying it would dirty that page
+            uint8_t out[f.length];
+            memcpy(out, msg, f.length);
+            out[2] = mapped_msgid[msg[2]];
+            dataflash.WriteBlock(out, f.length);
         }
         // a MsgHandler would probably have found a timestamp and
         // caled stop_clock.  This runs IO, clearing dataflash's
@@ -310,6 +316,11 @@ bool LogReader::handle_msg(const struct log_Format &f, uint8_t *msg) {
 
 bool LogReader::wait_type(const char *wtype)
 {
+    uint32_t count;
+    if (message_count(wtype, count) && count == 0) {
+        // the index says it never comes; don't scan the whole log
+        return false;
+    }
     while (true) {
         char type[5];
         if (!update(type)) {
@@ -337,6 +348,9 @@ bool LogReader::set_parameter(const char *name, float value)
  */
 void LogReader::end_format_msgs(void)
 {
+    if (!output) {
+        return;
+    }
     // write out any formats we will be producing
     for (uint8_t i=0; generated_names[i]; i++) {
         for (uint8_t n=0; n<ARRAY_SIZE(log_structure); n++) {
@@ -24,6 +24,8 @@ public:
     void set_gyro_mask(uint8_t mask) { gyro_mask = mask; }
     void set_use_imt(bool _use_imt) { use_imt = _use_imt; }
     void set_save_chek_messages(bool _save_chek_messages) { save_chek_messages = _save_chek_messages; }
+    void set_ekf_check(EKFCheck *_ekf_check) { ekf_check = _ekf_check; }
+    void set_output(bool _output) { output = _output; }
 
     uint64_t last_timestamp_us(void) const { return last_timestamp_usec; }
     virtual bool handle_log_format_msg(const struct log_Format &f);
@@ -71,6 +73,12 @@ private:
 
     bool save_chek_messages;
 
+    // compares logged NKF records with replay when set
+    EKFCheck *ekf_check = nullptr;
+
+    // copy log messages to the output log
+    bool output = true;
+
     void maybe_install_vehicle_specific_parsers();
 
     uint8_t map_fmt_type(const char *name, uint8_t intype);
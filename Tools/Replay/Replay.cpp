@@ -27,6 +27,11 @@
 #include "DataFlashFileReader.h"
 #include "Replay.h"
 
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
 #include <SITL/SITL.h>
 #endif
@@ -145,6 +150,8 @@ void Replay::usage(void)
     ::printf("\t--no-imt           don't use IMT data\n");
     ::printf("\t--check-generate   generate CHEK messages in output\n");
     ::printf("\t--check            check solution against CHEK messages\n");
+    ::printf("\t--check-ekf        check replayed EKF2 against every NKF message\n");
+    ::printf("\t--lean             run only EKF2, with no output log or plot files\n");
     ::printf("\t--tolerance-euler  tolerance for euler angles in degrees\n");
     ::printf("\t--tolerance-pos    tolerance for position in meters\n");
     ::printf("\t--tolerance-vel    tolerance for velocity in meters/second\n");
@@ -153,12 +160,18 @@ void Replay::usage(void)
     ::printf("\t--logmatch         match logging rate to source\n");
     ::printf("\t--no-params        don't use parameters from the log\n");
     ::printf("\t--no-fpe           do not generate floating point exceptions\n");
+    ::printf("\t--batch FILE       replay each \"LOG [NAME=VALUE...]\" line of FILE with --check,\n");
+    ::printf("\t                   or --check-ekf with --lean\n");
+    ::printf("\t--jobs N           number of parallel batch workers\n");
+    ::printf("\t--bench N          time EKF2 over N --lean replays of the log\n");
 }
 
 
 enum {
     OPT_CHECK = 128,
     OPT_CHECK_GENERATE,
+    OPT_CHECK_EKF,
+    OPT_LEAN,
     OPT_TOLERANCE_EULER,
     OPT_TOLERANCE_POS,
     OPT_TOLERANCE_VEL,
@@ -168,6 +181,9 @@ enum {
     OPT_NOPARAMS,
     OPT_PARAM_FILE,
     OPT_NO_FPE,
+    OPT_BATCH,
+    OPT_JOBS,
+    OPT_BENCH,
 };
 
 void Replay::flush_dataflash(void) {
@@ -216,6 +232,8 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"no-imt",          false,  0, 'n'},
         {"check-generate",  false,  0, OPT_CHECK_GENERATE},
         {"check",           false,  0, OPT_CHECK},
+        {"check-ekf",       false,  0, OPT_CHECK_EKF},
+        {"lean",            false,  0, OPT_LEAN},
         {"tolerance-euler", true,   0, OPT_TOLERANCE_EULER},
         {"tolerance-pos",   true,   0, OPT_TOLERANCE_POS},
         {"tolerance-vel",   true,   0, OPT_TOLERANCE_VEL},
@@ -224,6 +242,9 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"logmatch",        false,  0, OPT_LOGMATCH},
         {"no-params",       false,  0, OPT_NOPARAMS},
         {"no-fpe",          false,  0, OPT_NO_FPE},
+        {"batch",           true,   0, OPT_BATCH},
+        {"jobs",            true,   0, OPT_JOBS},
+        {"bench",           true,   0, OPT_BENCH},
         {0, false, 0, 0}
     };
 
@@ -249,19 +270,12 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             logreader.set_use_imt(use_imt);
             break;
 
-        case 'p': {
-            const char *eq = strchr(gopt.optarg, '=');
-            if (eq == NULL) {
+        case 'p':
+            if (!add_user_parameter(gopt.optarg)) {
                 ::printf("Usage: -p NAME=VALUE\n");
                 exit(1);
             }
-            struct user_parameter *u = new user_parameter;
-            strncpy(u->name, gopt.optarg, eq-gopt.optarg);
-            u->value = atof(eq+1);
-            u->next = user_parameters;
-            user_parameters = u;
             break;
-        }
 
         case OPT_CHECK_GENERATE:
             check_generate = true;
@@ -271,6 +285,14 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             check_solution = true;
             break;
 
+        case OPT_CHECK_EKF:
+            check_ekf = true;
+            break;
+
+        case OPT_LEAN:
+            lean = true;
+            break;
+
         case OPT_TOLERANCE_EULER:
             tolerance_euler = atof(gopt.optarg);
             break;
@@ -307,6 +329,19 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             generate_fpe = false;
             break;
 
+        case OPT_BATCH:
+            batch_file = gopt.optarg;
+            break;
+
+        case OPT_JOBS:
+            batch_jobs = MAX(atoi(gopt.optarg), 1);
+            break;
+
+        case OPT_BENCH:
+            bench_passes = MAX(atoi(gopt.optarg), 1);
+            lean = true;
+            break;
+
         case 'h':
         default:
             usage();
@@ -378,6 +413,8 @@ bool IMUCounter::handle_msg(const struct log_Format &f, uint8_t *msg) {
 bool Replay::find_log_info(struct log_information &info) 
 {
     IMUCounter reader;
+    static const char *wanted_types[] = { "IMU", "IMU2", "IMT", "IMT2", "PARM", nullptr };
+    reader.set_type_filter(wanted_types);
     if (!reader.open_log(filename)) {
         perror(filename);
         exit(1);
@@ -493,10 +530,28 @@ void Replay::setup()
 
     _parse_command_line(argc, argv);
 
+    if (batch_file != nullptr) {
+        // only returns in a worker process, set up for one run
+        run_batch();
+    }
+
     if (!check_generate) {
         logreader.set_save_chek_messages(true);
     }
 
+    if (lean) {
+        if (check_solution || check_generate) {
+            ::printf("--lean doesn't run EKF1, use --check-ekf\n");
+            exit(1);
+        }
+        logreader.set_output(false);
+    }
+
+    if (check_ekf) {
+        ekf_check.set_tolerances(tolerance_euler, tolerance_pos, tolerance_vel);
+        logreader.set_ekf_check(&ekf_check);
+    }
+
     set_signal_handlers();
 
     hal.console->printf("Processing log %s\n", filename);
@@ -516,6 +571,11 @@ void Replay::setup()
         exit(1);
     }
 
+    if (bench_passes > 0) {
+        // only returns in a worker process, set up for one pass
+        run_bench();
+    }
+
     _vehicle.setup();
 
     inhibit_gyro_cal();
@@ -532,6 +592,10 @@ void Replay::setup()
     
     set_ins_update_rate(log_info.update_rate);
 
+    if (lean) {
+        return;
+    }
+
     plotf = fopen("plot.dat", "w");
     plotf2 = fopen("plot2.dat", "w");
     ekf1f = fopen("EKF1.dat", "w");
@@ -624,6 +688,28 @@ void Replay::write_ekf_logs(void)
     }
 }
 
+/*
+  lean mode: EKF2 reads the sensor frontends the log handlers have
+  filled, so skip everything else AHRS runs (DCM, EKF1, inertial nav)
+  and step EKF2 directly. Nothing is written to the output log
+ */
+void Replay::update_lean(void)
+{
+    _vehicle.ins.update();
+    if (!lean_ekf2_started) {
+        // no DCM to wait for, start as soon as the sensors allow
+        lean_ekf2_started = _vehicle.EKF2.InitialiseFilter();
+        return;
+    }
+    if (bench_fd != -1) {
+        ekf_bench.begin_update();
+    }
+    _vehicle.EKF2.UpdateFilter();
+    if (bench_fd != -1) {
+        ekf_bench.end_update();
+    }
+}
+
 void Replay::read_sensors(const char *type)
 {
     if (!done_parameters && !streq(type,"FMT") && !streq(type,"PARM")) {
@@ -688,7 +774,9 @@ void Replay::read_sensors(const char *type)
         run_ahrs = streq(type, "CHEK");
     }
     
-    if (run_ahrs) {
+    if (run_ahrs && lean) {
+        update_lean();
+    } else if (run_ahrs) {
         _vehicle.ahrs.update();
         if (_vehicle.ahrs.get_home().lat != 0) {
             _vehicle.inertial_nav.update(_vehicle.ins.get_delta_time());
@@ -709,7 +797,7 @@ void Replay::read_sensors(const char *type)
         }
     }
     
-    if (logmatch && streq(type, "NKF1")) {
+    if (logmatch && !lean && streq(type, "NKF1")) {
         write_ekf_logs();
     }
 }
@@ -789,7 +877,9 @@ void Replay::loop()
 
         if (!logreader.update(type)) {
             ::printf("End of log at %.1f seconds\n", AP_HAL::millis()*0.001f);
-            fclose(plotf);
+            if (plotf != NULL) {
+                fclose(plotf);
+            }
             break;
         }
 
@@ -804,7 +894,7 @@ void Replay::loop()
 
         read_sensors(type);
 
-        if (streq(type,"ATT")) {
+        if (streq(type,"ATT") && !lean) {
             Vector3f ekf_euler;
             Vector3f velNED;
             Vector2f posNE;
@@ -1016,10 +1106,21 @@ void Replay::loop()
 
     flush_dataflash();
 
+    bool ekf_failed = false;
+    if (check_ekf) {
+        FILE *f = fopen("ekf_results.txt", "a");
+        ekf_failed = ekf_check.report(log_filename, f);
+        if (f != NULL) {
+            fclose(f);
+        }
+    }
     if (check_solution) {
         report_checks();
     }
-    exit(0);
+    if (bench_fd != -1 && !ekf_bench.send_results(bench_fd)) {
+        exit(1);
+    }
+    exit(ekf_failed ? 1 : 0);
 }
 
 
@@ -1120,6 +1221,267 @@ void Replay::load_param_file(const char *pfilename)
     fclose(f);
 }
 
+/*
+  add a NAME=VALUE user parameter
+ */
+bool Replay::add_user_parameter(const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq == NULL || eq == arg || eq - arg >= (ptrdiff_t)sizeof(user_parameter::name)) {
+        return false;
+    }
+    struct user_parameter *u = new user_parameter;
+    memset(u->name, 0, sizeof(u->name));
+    strncpy(u->name, arg, eq-arg);
+    u->value = atof(eq+1);
+    u->next = user_parameters;
+    user_parameters = u;
+    return true;
+}
+
+/*
+  a reader which just opens logs, so their index gets built and cached
+  once before the batch workers start
+ */
+class LogIndexer : public DataFlashFileReader {
+public:
+    bool handle_log_format_msg(const struct log_Format &f) override { return true; }
+    bool handle_msg(const struct log_Format &f, uint8_t *msg) override { return true; }
+};
+
+/*
+  run a batch of replays. Each line of the batch file names a log
+  followed by optional NAME=VALUE parameter overrides. Every run is
+  replayed with --check in its own forked worker, with up to
+  batch_jobs workers at once, in its own directory batch/NNN. Workers
+  share the logs through the page cache and the cached log index.
+  When all runs are complete a table of the check results is written
+  to batch/summary.txt. With --check-ekf each run also compares the
+  NKF messages, and a divergence fails the run
+
+  Replay state (parameters, the HAL clock, the vehicle) is global, so
+  workers are processes rather than threads
+ */
+void Replay::run_batch(void)
+{
+    FILE *f = fopen(batch_file, "r");
+    if (f == nullptr) {
+        perror(batch_file);
+        exit(1);
+    }
+    struct batch_run *runs = nullptr;
+    uint16_t num_runs = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        char *saveptr = nullptr;
+        char *logfile = strtok_r(line, " \t\r\n", &saveptr);
+        if (logfile == nullptr || logfile[0] == '#') {
+            continue;
+        }
+        char *params = strtok_r(nullptr, "\r\n", &saveptr);
+        runs = (struct batch_run *)realloc(runs, (num_runs+1) * sizeof(runs[0]));
+        if (runs == nullptr) {
+            ::printf("Out of memory\n");
+            exit(1);
+        }
+        struct batch_run &run = runs[num_runs++];
+        memset(&run, 0, sizeof(run));
+        run.logfile = strdup(logfile);
+        run.params = strdup(params ? params : "");
+    }
+    fclose(f);
+    if (num_runs == 0) {
+        ::printf("No runs in %s\n", batch_file);
+        exit(1);
+    }
+
+    if (mkdir("batch", 0755) != 0 && errno != EEXIST) {
+        perror("batch");
+        exit(1);
+    }
+
+    for (uint16_t i=0; i<num_runs; i++) {
+        LogIndexer indexer;
+        if (!indexer.open_log(runs[i].logfile)) {
+            perror(runs[i].logfile);
+            exit(1);
+        }
+    }
+
+    ::printf("Running %u replays with %u workers\n", (unsigned)num_runs, (unsigned)batch_jobs);
+    fflush(stdout);
+
+    uint16_t next = 0;
+    uint16_t running = 0;
+    while (next < num_runs || running > 0) {
+        while (running < batch_jobs && next < num_runs) {
+            pid_t pid = fork();
+            if (pid == -1) {
+                perror("fork");
+                exit(1);
+            }
+            if (pid == 0) {
+                batch_child(runs[next], next);
+                return;
+            }
+            runs[next].pid = pid;
+            next++;
+            running++;
+        }
+        int status;
+        pid_t pid = wait(&status);
+        if (pid == -1) {
+            perror("wait");
+            exit(1);
+        }
+        for (uint16_t i=0; i<next; i++) {
+            if (runs[i].pid == pid) {
+                runs[i].status = status;
+                ::printf("Run %03u finished\n", (unsigned)i);
+                break;
+            }
+        }
+        running--;
+    }
+
+    batch_summary(runs, num_runs);
+    exit(0);
+}
+
+/*
+  replay the log bench_passes times, one pass after another so they
+  don't compete for the CPU, and report the EKF2 stage timings over
+  all of them. The log is opened and mapped once, before the
+  workers are forked, so every pass starts from the same fresh
+  vehicle and filter state with the log already loaded
+ */
+void Replay::run_bench(void)
+{
+    ::printf("Timing EKF2 over %u passes of %s\n", (unsigned)bench_passes, filename);
+
+    for (uint16_t i=0; i<bench_passes; i++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            exit(1);
+        }
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(1);
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            if (freopen("/dev/null", "w", stdout) == nullptr) {
+                exit(1);
+            }
+            bench_fd = fds[1];
+            ekf_bench.start();
+            return;
+        }
+        close(fds[1]);
+        const bool have_results = ekf_bench.receive_results(fds[0]);
+        close(fds[0]);
+        int status;
+        if (waitpid(pid, &status, 0) == -1 ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0 || !have_results) {
+            ::printf("Pass %u failed\n", (unsigned)i);
+            exit(1);
+        }
+    }
+
+    ekf_bench.report();
+    exit(0);
+}
+
+/*
+  set up a forked worker for one batch run
+ */
+void Replay::batch_child(const struct batch_run &run, uint16_t idx)
+{
+    char *logpath = realpath(run.logfile, nullptr);
+    if (logpath == nullptr) {
+        perror(run.logfile);
+        exit(1);
+    }
+    char dir[32];
+    snprintf(dir, sizeof(dir), "batch/%03u", (unsigned)idx);
+    if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || chdir(dir) != 0) {
+        perror(dir);
+        exit(1);
+    }
+    // results of an earlier batch would be appended to
+    unlink("replay_results.txt");
+    unlink("ekf_results.txt");
+    if (freopen("replay.out", "w", stdout) == nullptr) {
+        exit(1);
+    }
+
+    char *params = strdup(run.params);
+    char *saveptr = nullptr;
+    for (char *p=strtok_r(params, " \t", &saveptr); p; p=strtok_r(nullptr, " \t", &saveptr)) {
+        if (!add_user_parameter(p)) {
+            ::printf("Bad parameter %s\n", p);
+            exit(1);
+        }
+    }
+    free(params);
+
+    filename = logpath;
+    if (lean) {
+        check_ekf = true;
+    } else {
+        check_solution = true;
+    }
+}
+
+/*
+  write a table of the check results of all runs
+ */
+void Replay::batch_summary(const struct batch_run *runs, uint16_t num_runs)
+{
+    FILE *out = fopen("batch/summary.txt", "w");
+    if (out == nullptr) {
+        perror("batch/summary.txt");
+        exit(1);
+    }
+    fprintf(out, "run\tstatus\troll\tpitch\tyaw\tpos\tvel\tlog\tparams\n");
+    for (uint16_t i=0; i<num_runs; i++) {
+        const struct batch_run &run = runs[i];
+        const char *status;
+        if (WIFEXITED(run.status)) {
+            status = WEXITSTATUS(run.status) == 0 ? "pass" : "fail";
+        } else {
+            status = "crash";
+        }
+        float err[5] {};
+        char results[32];
+        snprintf(results, sizeof(results), "batch/%03u/replay_results.txt", (unsigned)i);
+        FILE *f = fopen(results, "r");
+        if (f != nullptr) {
+            char line[1024];
+            if (fgets(line, sizeof(line), f)) {
+                // the log name comes first and may contain spaces
+                const char *tab = strchr(line, '\t');
+                if (tab == nullptr ||
+                    sscanf(tab, "%f %f %f %f %f", &err[0], &err[1], &err[2], &err[3], &err[4]) != 5) {
+                    status = "error";
+                }
+            }
+            fclose(f);
+        } else if (strcmp(status, "pass") == 0 && !lean) {
+            status = "no-results";
+        }
+        fprintf(out, "%03u\t%s\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\t%s\t%s\n",
+                (unsigned)i, status,
+                err[0], err[1], err[2], err[3], err[4],
+                run.logfile, run.params);
+    }
+    fclose(out);
+    ::printf("Results in batch/summary.txt\n");
+}
+
 /*
   see if a user parameter is set
  */
@@ -53,6 +53,9 @@
 #include <AP_HAL/utility/getopt_cpp.h>
 #include <AP_SerialManager/AP_SerialManager.h>
 
+#include "EKFBench.h"
+#include "EKFCheck.h"
+
 class ReplayVehicle {
 public:
     void setup();
@@ -119,6 +122,10 @@ private:
     SITL::SITL sitl;
 #endif
 
+    // compare logged NKF records with the replayed EKF2, see --check-ekf
+    bool check_ekf = false;
+    EKFCheck ekf_check{_vehicle.EKF2};
+
     LogReader logreader{_vehicle.ahrs, _vehicle.ins, _vehicle.barometer, _vehicle.compass, _vehicle.gps, _vehicle.airspeed, _vehicle.dataflash, nottypes};
 
     FILE *plotf;
@@ -135,6 +142,9 @@ private:
     bool ahrs_healthy;
     bool use_imt = true;
     bool check_generate = false;
+    // run EKF2 alone with no output, see update_lean()
+    bool lean = false;
+    bool lean_ekf2_started = false;
     float tolerance_euler = 3;
     float tolerance_pos = 2;
     float tolerance_vel = 2;
@@ -154,6 +164,28 @@ private:
 
     void _parse_command_line(uint8_t argc, char * const argv[]);
 
+    // batch mode: replay many (log, parameter set) runs in parallel
+    // worker processes, see run_batch()
+    const char *batch_file = nullptr;
+    uint16_t batch_jobs = 1;
+    struct batch_run {
+        char *logfile;
+        char *params;
+        pid_t pid;
+        int status;
+    };
+    void run_batch(void);
+    void batch_child(const struct batch_run &run, uint16_t idx);
+    void batch_summary(const struct batch_run *runs, uint16_t num_runs);
+
+    // benchmark mode: time EKF2 over bench_passes lean replays of the
+    // log, each in a forked worker, see run_bench()
+    uint16_t bench_passes = 0;
+    int bench_fd = -1;
+    EKFBench ekf_bench;
+    void run_bench(void);
+    bool add_user_parameter(const char *arg);
+
     struct user_parameter {
         struct user_parameter *next;
         char name[17];
@@ -167,6 +199,7 @@ private:
     void set_user_parameters(void);
     void read_sensors(const char *type);
     void write_ekf_logs(void);
+    void update_lean(void);
     void log_check_generate();
     void log_check_solution();
     bool show_error(const char *text, float max_error, float tolerance);
@@ -66,6 +66,12 @@ class Board:
         # make easy to override them. Convert back to list before consumption.
         env.DEFINES = {}
 
+        # drivers left out of the build
+        for driver in cfg.options.disable_drivers.split(','):
+            driver = driver.strip().upper()
+            if driver:
+                env.DEFINES['AP_%s_ENABLED' % driver] = 0
+
         env.CFLAGS += [
             '-ffunction-sections',
             '-fdata-sections',
@@ -203,6 +209,7 @@ class sitl(Board):
         ]
 
         cfg.check_librt(env)
+        cfg.check_libdl(env)
 
         env.LINKFLAGS += ['-pthread',]
         env.AP_LIBRARIES += [
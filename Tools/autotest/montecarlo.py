@@ -0,0 +1,369 @@
+#!/usr/bin/env python
+"""
+ Run many SITL flights of one mission with randomised simulation
+ parameters, and print a table of per-run metrics.
+
+ Each run is its own SITL process in lockstep mode, in its own
+ directory, so runs don't share parameters or logs. Up to --jobs runs
+ fly at once, using SITL instances 0 to jobs-1 for their ports.
+
+ Parameters are randomised with --param NAME=MIN:MAX (uniform) or
+ --param NAME=A,B,C (choice), or fixed with --param NAME=VALUE.
+ Faults can be injected part way through a flight with
+ --event SECONDS:NAME=VALUE, which sets a parameter at that simulated
+ time after takeoff.
+
+ Example:
+   montecarlo.py --vehicle copter --runs 200 --jobs 8 \\
+       --param SIM_WIND_SPD=0:10 --param SIM_WIND_DIR=0:360 \\
+       --event 60:SIM_GPS_GLITCH_X=0.0005 --csv results.csv
+"""
+
+from __future__ import print_function
+
+import math
+import optparse
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+from pymavlink import mavutil, mavwp
+
+from pysim import util
+
+testdir = os.path.dirname(os.path.realpath(__file__))
+
+HOME = "-35.362938,149.165085,584,270"
+
+# per vehicle defaults
+VEHICLES = {
+    'copter': {
+        'binary': 'build/sitl/bin/arducopter-quad',
+        'model': '+',
+        'defaults': 'default_params/copter.parm',
+        'mission': 'copter_mission.txt',
+    },
+    'plane': {
+        'binary': 'build/sitl/bin/arduplane',
+        'model': 'plane',
+        'defaults': 'default_params/plane.parm',
+        'mission': 'ArduPlane-Missions/CMAC-toff-loop.txt',
+    },
+    'quadplane': {
+        'binary': 'build/sitl/bin/arduplane',
+        'model': 'quadplane',
+        'defaults': 'default_params/quadplane.parm',
+        'mission': 'ArduPlane-Missions/CMAC-VTOL-ccw.txt',
+    },
+}
+
+# metric columns, in table order
+METRICS = ['result', 'sim_s', 'wp', 'max_roll', 'max_pitch', 'max_xtrack',
+           'max_speed', 'min_alt', 'failsafes']
+
+
+def parse_param_spec(spec):
+    """Parse NAME=MIN:MAX, NAME=A,B,C or NAME=VALUE into a sampler."""
+    name, value = spec.split('=', 1)
+    if ':' in value:
+        lo, hi = [float(v) for v in value.split(':', 1)]
+        return name, lambda rng: rng.uniform(lo, hi)
+    if ',' in value:
+        choices = [float(v) for v in value.split(',')]
+        return name, lambda rng: rng.choice(choices)
+    fixed = float(value)
+    return name, lambda rng: fixed
+
+
+def parse_event_spec(spec):
+    """Parse SECONDS:NAME=VALUE."""
+    t, rest = spec.split(':', 1)
+    name, value = rest.split('=', 1)
+    return (float(t), name, float(value))
+
+
+def upload_mission(mav, filename, timeout=30):
+    """Send a mission file to the vehicle."""
+    wp = mavwp.MAVWPLoader(target_system=mav.target_system,
+                           target_component=mav.target_component)
+    wp.load(filename)
+    mav.waypoint_clear_all_send()
+    mav.waypoint_count_send(wp.count())
+    tstart = time.time()
+    while time.time() - tstart < timeout:
+        m = mav.recv_match(type=['MISSION_REQUEST', 'MISSION_ACK'], blocking=True, timeout=1)
+        if m is None:
+            continue
+        if m.get_type() == 'MISSION_ACK':
+            if m.type == 0 and m.get_srcSystem() == mav.target_system:
+                return wp.count()
+            continue
+        mav.mav.send(wp.wp(m.seq))
+    raise RuntimeError("mission upload timed out")
+
+
+def set_mode(mav, mode, timeout=30):
+    mode_id = mav.mode_mapping()[mode]
+    tstart = time.time()
+    while mav.flightmode != mode:
+        if time.time() - tstart > timeout:
+            raise RuntimeError("failed to set mode %s" % mode)
+        mav.set_mode(mode_id)
+        mav.recv_match(type='HEARTBEAT', blocking=True, timeout=1)
+
+
+def arm(mav, timeout=120):
+    """Arm, retrying until the pre-arm checks pass."""
+    tstart = time.time()
+    while not mav.motors_armed():
+        if time.time() - tstart > timeout:
+            raise RuntimeError("failed to arm")
+        mav.arducopter_arm()
+        mav.recv_match(type='HEARTBEAT', blocking=True, timeout=1)
+
+
+class Run(object):
+    """One simulated flight."""
+
+    def __init__(self, index, opts, params, events):
+        self.index = index
+        self.opts = opts
+        self.params = params
+        self.events = sorted(events)
+        self.metrics = dict((m, None) for m in METRICS)
+
+    def write_defaults(self, path):
+        f = open(path, 'w')
+        f.write(open(self.opts.defaults).read())
+        f.write('\n')
+        for name in sorted(self.params.keys()):
+            f.write('%s %f\n' % (name, self.params[name]))
+        f.close()
+
+    def execute(self, instance):
+        rundir = tempfile.mkdtemp(prefix='montecarlo-%u-' % self.index)
+        sitl = None
+        try:
+            defaults = os.path.join(rundir, 'defaults.parm')
+            self.write_defaults(defaults)
+            cmd = [self.opts.binary, '-S', '--lockstep', '-w',
+                   '--instance', str(instance),
+                   '--model', self.opts.model,
+                   '--home', self.opts.home,
+                   '--defaults', defaults]
+            log = open(os.path.join(rundir, 'sitl.log'), 'w')
+            sitl = subprocess.Popen(cmd, cwd=rundir, stdout=log, stderr=subprocess.STDOUT)
+            port = 5760 + 10 * instance
+            mav = None
+            tstart = time.time()
+            while mav is None:
+                try:
+                    mav = mavutil.mavlink_connection('tcp:127.0.0.1:%u' % port, robust_parsing=True)
+                except Exception:
+                    if time.time() - tstart > 30:
+                        raise
+                    time.sleep(0.2)
+            mav.wait_heartbeat()
+            self.fly(mav)
+            mav.close()
+        except Exception as e:
+            self.metrics['result'] = 'error: %s' % e
+        finally:
+            if sitl is not None:
+                sitl.terminate()
+                sitl.wait()
+            if self.opts.keep:
+                print("run %u kept in %s" % (self.index, rundir))
+            else:
+                shutil.rmtree(rundir, ignore_errors=True)
+
+    def start_flight(self, mav):
+        if self.opts.vehicle == 'copter':
+            # the mission starts once armed in AUTO with throttle up
+            set_mode(mav, 'GUIDED')
+            arm(mav)
+            mav.mav.rc_channels_override_send(mav.target_system, mav.target_component,
+                                              0, 0, 1500, 0, 0, 0, 0, 0)
+            set_mode(mav, 'AUTO')
+        else:
+            set_mode(mav, 'AUTO')
+            arm(mav)
+
+    def fly(self, mav):
+        mav.mav.request_data_stream_send(mav.target_system, mav.target_component,
+                                         mavutil.mavlink.MAV_DATA_STREAM_ALL, 10, 1)
+        num_wp = upload_mission(mav, self.opts.mission)
+        self.start_flight(mav)
+
+        m = self.metrics
+        m.update(max_roll=0.0, max_pitch=0.0, max_xtrack=0.0, max_speed=0.0,
+                 min_alt=None, wp=0, failsafes=0)
+        events = list(self.events)
+        t0 = None
+        t = 0.0
+        result = 'timeout'
+        wall_start = time.time()
+        while True:
+            if time.time() - wall_start > self.opts.wall_timeout:
+                result = 'wall timeout'
+                break
+            msg = mav.recv_match(blocking=True, timeout=5)
+            if msg is None:
+                result = 'no data'
+                break
+            mtype = msg.get_type()
+            if hasattr(msg, 'time_boot_ms'):
+                if t0 is None:
+                    t0 = msg.time_boot_ms
+                t = (msg.time_boot_ms - t0) * 0.001
+            while events and t >= events[0][0]:
+                _, name, value = events.pop(0)
+                mav.param_set_send(name, value)
+            if mtype == 'ATTITUDE':
+                m['max_roll'] = max(m['max_roll'], abs(math.degrees(msg.roll)))
+                m['max_pitch'] = max(m['max_pitch'], abs(math.degrees(msg.pitch)))
+            elif mtype == 'GLOBAL_POSITION_INT':
+                alt = msg.relative_alt * 0.001
+                speed = math.sqrt(msg.vx ** 2 + msg.vy ** 2) * 0.01
+                m['max_speed'] = max(m['max_speed'], speed)
+                if m['wp'] >= 1:
+                    # only once airborne and on the mission
+                    m['min_alt'] = alt if m['min_alt'] is None else min(m['min_alt'], alt)
+            elif mtype == 'NAV_CONTROLLER_OUTPUT':
+                m['max_xtrack'] = max(m['max_xtrack'], abs(msg.xtrack_error))
+            elif mtype == 'MISSION_ITEM_REACHED':
+                m['wp'] = max(m['wp'], msg.seq)
+            elif mtype == 'STATUSTEXT':
+                text = msg.text.lower()
+                if 'crash' in text:
+                    result = 'crash'
+                    break
+                if 'failsafe' in text:
+                    m['failsafes'] += 1
+            elif mtype == 'HEARTBEAT' and m['wp'] >= num_wp - 1 and not mav.motors_armed():
+                result = 'complete'
+                break
+            if m['wp'] >= num_wp - 1 and self.opts.vehicle != 'copter':
+                # planes loop or loiter at the end of their mission
+                result = 'complete'
+                break
+            if t > self.opts.duration:
+                break
+        m['result'] = result
+        m['sim_s'] = t
+
+
+def worker(queue, lock, instance, done):
+    while True:
+        with lock:
+            if not queue:
+                return
+            run = queue.pop(0)
+        run.execute(instance)
+        with lock:
+            done.append(run)
+            print("run %u: %s" % (run.index, run.metrics['result']))
+
+
+def format_value(v):
+    if v is None:
+        return '-'
+    if isinstance(v, float):
+        return '%.2f' % v
+    return str(v)
+
+
+def print_table(runs, param_names, out=sys.stdout, sep=None):
+    header = ['run'] + param_names + METRICS
+    rows = []
+    for run in runs:
+        rows.append([str(run.index)] +
+                    [format_value(run.params[p]) for p in param_names] +
+                    [format_value(run.metrics[k]) for k in METRICS])
+    if sep is not None:
+        out.write(sep.join(header) + '\n')
+        for r in rows:
+            out.write(sep.join(r) + '\n')
+        return
+    widths = [max(len(h), max([len(r[i]) for r in rows] + [0])) for i, h in enumerate(header)]
+    out.write('  '.join(h.rjust(w) for h, w in zip(header, widths)) + '\n')
+    for r in rows:
+        out.write('  '.join(c.rjust(w) for c, w in zip(r, widths)) + '\n')
+
+
+def main():
+    parser = optparse.OptionParser("montecarlo.py [options]")
+    parser.add_option("--vehicle", default='copter', choices=list(VEHICLES.keys()), help="copter, plane or quadplane")
+    parser.add_option("--binary", default=None, help="SITL binary")
+    parser.add_option("--model", default=None, help="simulation model")
+    parser.add_option("--defaults", default=None, help="default parameter file")
+    parser.add_option("--mission", default=None, help="mission to fly")
+    parser.add_option("--home", default=HOME, help="home location")
+    parser.add_option("--runs", type='int', default=10, help="number of runs")
+    parser.add_option("--jobs", type='int', default=4, help="runs to fly at once")
+    parser.add_option("--seed", type='int', default=1, help="random seed for parameter sampling")
+    parser.add_option("--param", action='append', default=[], help="NAME=MIN:MAX, NAME=A,B,C or NAME=VALUE")
+    parser.add_option("--event", action='append', default=[], help="SECONDS:NAME=VALUE")
+    parser.add_option("--duration", type='float', default=600, help="simulated seconds before a run times out")
+    parser.add_option("--wall-timeout", type='float', default=600, help="wall clock seconds before a run is abandoned")
+    parser.add_option("--csv", default=None, help="also write the results to a CSV file")
+    parser.add_option("--keep", action='store_true', default=False, help="keep run directories")
+    opts, args = parser.parse_args()
+
+    v = VEHICLES[opts.vehicle]
+    if opts.binary is None:
+        opts.binary = util.reltopdir(v['binary'])
+    if opts.model is None:
+        opts.model = v['model']
+    if opts.defaults is None:
+        opts.defaults = os.path.join(testdir, v['defaults'])
+    if opts.mission is None:
+        opts.mission = os.path.join(testdir, v['mission'])
+    opts.binary = os.path.abspath(opts.binary)
+    opts.defaults = os.path.abspath(opts.defaults)
+    opts.mission = os.path.abspath(opts.mission)
+
+    samplers = [parse_param_spec(p) for p in opts.param]
+    param_names = [name for name, _ in samplers]
+    events = [parse_event_spec(e) for e in opts.event]
+
+    # sample every run up front so results only depend on the seed
+    rng = random.Random(opts.seed)
+    runs = []
+    for i in range(opts.runs):
+        params = dict((name, sampler(rng)) for name, sampler in samplers)
+        runs.append(Run(i, opts, params, events))
+
+    queue = list(runs)
+    lock = threading.Lock()
+    done = []
+    threads = []
+    tstart = time.time()
+    for instance in range(min(opts.jobs, opts.runs)):
+        t = threading.Thread(target=worker, args=(queue, lock, instance, done))
+        t.daemon = True
+        t.start()
+        threads.append(t)
+    for t in threads:
+        t.join()
+
+    print("%u runs in %.0f seconds" % (len(runs), time.time() - tstart))
+    print_table(runs, param_names)
+    if opts.csv is not None:
+        f = open(opts.csv, 'w')
+        print_table(runs, param_names, out=f, sep=',')
+        f.close()
+
+    counts = {}
+    for run in runs:
+        counts[run.metrics['result']] = counts.get(run.metrics['result'], 0) + 1
+    print(', '.join('%s: %u' % (k, counts[k]) for k in sorted(counts.keys())))
+
+
+if __name__ == '__main__':
+    main()
@@ -107,6 +107,15 @@ void AC_AttitudeControl::set_throttle_out_unstabilized(float throttle_in, bool r
     _angle_boost = 0.0f;
 }
 
+// set_dt - sets time delta in seconds for the attitude controller and rate PIDs
+void AC_AttitudeControl::set_dt(float dt)
+{
+    _dt = dt;
+    get_rate_roll_pid().set_dt(dt);
+    get_rate_pitch_pid().set_dt(dt);
+    get_rate_yaw_pid().set_dt(dt);
+}
+
 // Ensure attitude controller have zero errors to relax rate controller output
 void AC_AttitudeControl::relax_attitude_controllers()
 {
@@ -588,7 +597,7 @@ Vector3f AC_AttitudeControl::update_ang_vel_target_from_att_error(Vector3f attit
 // Run the roll angular velocity PID controller and return the output
 float AC_AttitudeControl::rate_target_to_motor_roll(float rate_target_rads)
 {
-    float current_rate_rads = _ahrs.get_gyro().x;
+    float current_rate_rads = get_rate_gyro().x;
     float rate_error_rads = rate_target_rads - current_rate_rads;
 
     // pass error to PID controller
@@ -612,7 +621,7 @@ float AC_AttitudeControl::rate_target_to_motor_roll(float rate_target_rads)
 // Run the pitch angular velocity PID controller and return the output
 float AC_AttitudeControl::rate_target_to_motor_pitch(float rate_target_rads)
 {
-    float current_rate_rads = _ahrs.get_gyro().y;
+    float current_rate_rads = get_rate_gyro().y;
     float rate_error_rads = rate_target_rads - current_rate_rads;
 
     // pass error to PID controller
@@ -636,7 +645,7 @@ float AC_AttitudeControl::rate_target_to_motor_pitch(float rate_target_rads)
 // Run the yaw angular velocity PID controller and return the output
 float AC_AttitudeControl::rate_target_to_motor_yaw(float rate_target_rads)
 {
-    float current_rate_rads = _ahrs.get_gyro().z;
+    float current_rate_rads = get_rate_gyro().z;
     float rate_error_rads = rate_target_rads - current_rate_rads;
 
     // pass error to PID controller
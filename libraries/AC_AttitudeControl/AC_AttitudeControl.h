@@ -53,6 +53,7 @@ public:
         _dt(dt),
         _angle_boost(0),
         _use_ff_and_input_shaping(true),
+        _use_gyro_latest(false),
         _throttle_rpy_mix_desired(AC_ATTITUDE_CONTROL_THR_MIX_DEFAULT),
         _throttle_rpy_mix(AC_ATTITUDE_CONTROL_THR_MIX_DEFAULT),
         _ahrs(ahrs),
@@ -73,6 +74,10 @@ public:
     virtual AC_PID& get_rate_pitch_pid() = 0;
     virtual AC_PID& get_rate_yaw_pid() = 0;
 
+    // set_dt - sets time delta in seconds for the attitude controller
+    //  and rate PIDs, for when the main loop rate changes
+    virtual void set_dt(float dt);
+
     // Gets the roll acceleration limit in centidegrees/s/s
     float get_accel_roll_max() { return _accel_roll_max; }
 
@@ -140,6 +145,10 @@ public:
     // Configures whether the attitude controller should limit the rate demand to constrain angular acceleration
     void use_ff_and_input_shaping(bool use_shaping) { _use_ff_and_input_shaping = use_shaping; }
 
+    // Configures whether the rate controller reads the newest gyro sample, for when it runs before the
+    // AHRS update or from its own thread, rather than the gyro from the last AHRS update
+    void use_gyro_latest(bool use_latest) { _use_gyro_latest = use_latest; }
+
     // Return 321-intrinsic euler angles in centidegrees representing the rotation from NED earth frame to the
     // attitude controller's target attitude.
     // **NOTE** Using vector3f*deg(100) is more efficient than deg(vector3f)*100 or deg(vector3d*100) because it gives the
@@ -243,6 +252,9 @@ public:
 
 protected:
 
+    // Return the body-frame gyro rates in radians/s used by the rate controller
+    Vector3f get_rate_gyro() const { return _use_gyro_latest ? _ahrs.get_gyro_latest() : _ahrs.get_gyro(); }
+
     // Update rate_target_ang_vel using attitude_error_rot_vec_rad
     Vector3f update_ang_vel_target_from_att_error(Vector3f attitude_error_rot_vec_rad);
 
@@ -338,6 +350,9 @@ protected:
     // Specifies whether the attitude controller should use the input shaping and feedforward
     bool                _use_ff_and_input_shaping;
 
+    // Specifies whether the rate controller should use the newest gyro sample rather than the AHRS gyro
+    bool                _use_gyro_latest;
+
     // Filtered Alt_Hold lean angle max - used to limit lean angle when throttle is saturated using Alt_Hold
     float               _althold_lean_angle_max = 0.0f;
 
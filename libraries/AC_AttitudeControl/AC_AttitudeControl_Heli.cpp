@@ -264,7 +264,7 @@ void AC_AttitudeControl_Heli::rate_bf_to_motor_roll_pitch(float rate_roll_target
     float pitch_pd, pitch_i, pitch_ff;          // used to capture pid values
     float rate_roll_error_rads, rate_pitch_error_rads;    // simply target_rate - current_rate
     float roll_out, pitch_out;
-    const Vector3f& gyro = _ahrs.get_gyro();     // get current rates
+    const Vector3f gyro = get_rate_gyro();     // get current rates
 
     // calculate error
     rate_roll_error_rads = rate_roll_target_rads - gyro.x;
@@ -365,7 +365,7 @@ float AC_AttitudeControl_Heli::rate_target_to_motor_yaw(float rate_target_rads)
 
     // get current rate
     // To-Do: make getting gyro rates more efficient?
-    current_rate_rads = _ahrs.get_gyro().z;
+    current_rate_rads = get_rate_gyro().z;
 
     // calculate error and call pid controller
     rate_error_rads  = rate_target_rads - current_rate_rads;
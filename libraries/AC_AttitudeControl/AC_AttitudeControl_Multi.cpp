@@ -132,6 +132,13 @@ const AP_Param::GroupInfo AC_AttitudeControl_Multi::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("THR_MIX_MAX", 5, AC_AttitudeControl_Multi, _thr_mix_max, AC_ATTITUDE_CONTROL_MAX_DEFAULT),
 
+    // @Param: RAT_FUSED
+    // @DisplayName: Fused rate controller
+    // @Description: Runs the roll, pitch and yaw rate PIDs together in one pass. Uses the same gains and gives the same output as the separate controllers at a lower CPU cost
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("RAT_FUSED", 6, AC_AttitudeControl_Multi, _rate_fused, 0),
+
     AP_GROUPEND
 };
 
@@ -224,13 +231,77 @@ void AC_AttitudeControl_Multi::rate_controller_run()
     // move throttle vs attitude mixing towards desired (called from here because this is conveniently called on every iteration)
     update_throttle_rpy_mix();
 
-    _motors.set_roll(rate_target_to_motor_roll(_rate_target_ang_vel.x));
-    _motors.set_pitch(rate_target_to_motor_pitch(_rate_target_ang_vel.y));
-    _motors.set_yaw(rate_target_to_motor_yaw(_rate_target_ang_vel.z));
+    if (!_rate_thread_enabled) {
+        rate_pids_run(_rate_target_ang_vel);
+    }
 
     control_monitor_update();
 }
 
+// enable_rate_thread - leave the rate PIDs to rate_controller_run_thread(),
+//  run from a thread at rate_hz
+void AC_AttitudeControl_Multi::enable_rate_thread(uint16_t rate_hz)
+{
+    const float dt = 1.0f / rate_hz;
+    _pid_rate_roll.set_dt(dt);
+    _pid_rate_pitch.set_dt(dt);
+    _pid_rate_yaw.set_dt(dt);
+    // the thread runs between AHRS updates
+    _use_gyro_latest = true;
+    _rate_thread_enabled = true;
+}
+
+// set_dt - sets time delta in seconds for the attitude controller and,
+//  unless they run from the rate thread, the rate PIDs
+void AC_AttitudeControl_Multi::set_dt(float dt)
+{
+    if (_rate_thread_enabled) {
+        _dt = dt;
+        return;
+    }
+    AC_AttitudeControl::set_dt(dt);
+}
+
+// rate_controller_run_thread - run the rate PIDs on the current targets
+//  and send the outputs to the motors
+void AC_AttitudeControl_Multi::rate_controller_run_thread(float dt)
+{
+    _pid_rate_roll.set_dt(dt);
+    _pid_rate_pitch.set_dt(dt);
+    _pid_rate_yaw.set_dt(dt);
+    rate_pids_run(_rate_target_ang_vel);
+}
+
+// run the rate PIDs on the given targets and pass their outputs to the motors
+void AC_AttitudeControl_Multi::rate_pids_run(const Vector3f &rate_target_rads)
+{
+    if (_rate_fused) {
+        rate_controller_run_fused(rate_target_rads);
+    } else {
+        _motors.set_roll(rate_target_to_motor_roll(rate_target_rads.x));
+        _motors.set_pitch(rate_target_to_motor_pitch(rate_target_rads.y));
+        _motors.set_yaw(rate_target_to_motor_yaw(rate_target_rads.z));
+    }
+}
+
+// run the three rate PIDs in one pass, matching rate_target_to_motor_roll, _pitch and _yaw
+void AC_AttitudeControl_Multi::rate_controller_run_fused(const Vector3f &rate_target_rads)
+{
+    AC_PID *const pid[3] = { &_pid_rate_roll, &_pid_rate_pitch, &_pid_rate_yaw };
+    const Vector3f gyro = get_rate_gyro();
+    const float target[3] = { rate_target_rads.x, rate_target_rads.y, rate_target_rads.z };
+    const float error[3] = { target[0] - gyro.x, target[1] - gyro.y, target[2] - gyro.z };
+    const bool i_hold[3] = { _motors.limit.roll_pitch, _motors.limit.roll_pitch, _motors.limit.yaw };
+    float output[3];
+
+    // the yaw rate input is fully filtered, roll and pitch only filter the D term
+    AC_PID::rate_update_axes(pid, target, error, i_hold, 1U<<2, output, 3);
+
+    _motors.set_roll(output[0]);
+    _motors.set_pitch(output[1]);
+    _motors.set_yaw(output[2]);
+}
+
 // sanity check parameters.  should be called once before takeoff
 void AC_AttitudeControl_Multi::parameter_sanity_check()
 {
@@ -71,8 +71,21 @@ public:
     bool is_throttle_mix_min() const { return (_throttle_rpy_mix < 1.25f*_thr_mix_min); }
 
     // run lowest level body-frame rate controller and send outputs to the motors
+    //  once the rate thread is enabled the thread runs the rate PIDs instead
     void rate_controller_run();
 
+    // run the rate PIDs from a thread at rate_hz instead of from rate_controller_run()
+    void enable_rate_thread(uint16_t rate_hz);
+
+    // set_dt - sets time delta in seconds. The rate PIDs keep the
+    //  thread's time step once the rate thread is enabled
+    void set_dt(float dt) override;
+
+    // run the rate PIDs on the current rate targets, called from the rate
+    //  thread dt seconds after its last run. The caller keeps the main
+    //  loop off the controller and motors while this runs
+    void rate_controller_run_thread(float dt);
+
     // sanity check parameters.  should be called once before take-off
     void parameter_sanity_check();
 
@@ -84,6 +97,12 @@ protected:
     // update_throttle_rpy_mix - updates thr_low_comp value towards the target
     void update_throttle_rpy_mix();
 
+    // run the rate PIDs on the given targets and pass their outputs to the motors
+    void rate_pids_run(const Vector3f &rate_target_rads);
+
+    // run the roll, pitch and yaw rate controllers in one pass
+    void rate_controller_run_fused(const Vector3f &rate_target_rads);
+
     // get maximum value throttle can be raised to based on throttle vs attitude prioritisation
     float get_throttle_avg_max(float throttle_in);
 
@@ -94,4 +113,7 @@ protected:
 
     AP_Float              _thr_mix_min;     // throttle vs attitude control prioritisation used when landing (higher values mean we prioritise attitude control over throttle)
     AP_Float              _thr_mix_max;     // throttle vs attitude control prioritisation used during active flight (higher values mean we prioritise attitude control over throttle)
+    AP_Int8               _rate_fused;      // 1 to run the rate PIDs through AC_PID::rate_update_axes
+
+    bool                  _rate_thread_enabled = false;
 };
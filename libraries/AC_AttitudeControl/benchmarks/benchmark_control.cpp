@@ -0,0 +1,189 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_InertialNav/AP_InertialNav.h>
+#include <AP_Motors/AP_Motors.h>
+#include <AP_Vehicle/AP_Vehicle.h>
+#include <AC_AttitudeControl/AC_AttitudeControl_Multi.h>
+#include <AC_AttitudeControl/AC_PosControl.h>
+
+/*
+  per call cost of the multicopter attitude and position controllers.
+  Each iteration is one step of a fixed input trace at the main loop
+  rate, so the controllers see changing targets without the benchmark
+  allocating or reading sensors
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define BM_LOOP_RATE_HZ     400
+#define BM_DT               (1.0f / BM_LOOP_RATE_HZ)
+// one second of inputs
+#define BM_TRACE_LENGTH     BM_LOOP_RATE_HZ
+
+struct bm_input {
+    float roll_cd;
+    float pitch_cd;
+    float yaw_rate_cds;
+    float throttle;
+    Vector3f position;
+    Vector3f velocity;
+};
+
+static bm_input trace[BM_TRACE_LENGTH];
+
+// stick sweeps and a position circling a 10m loiter target
+static void make_trace()
+{
+    for (uint16_t i = 0; i < BM_TRACE_LENGTH; i++) {
+        const float t = i * BM_DT;
+        bm_input &in = trace[i];
+        in.roll_cd = 2000.0f * sinf(2 * M_PI * 1.3f * t);
+        in.pitch_cd = 1500.0f * sinf(2 * M_PI * 0.7f * t + 1.0f);
+        in.yaw_rate_cds = 4500.0f * sinf(2 * M_PI * 0.4f * t);
+        in.throttle = 0.5f + 0.1f * sinf(2 * M_PI * 2.1f * t);
+        in.position = Vector3f(1000.0f * cosf(2 * M_PI * t), 1000.0f * sinf(2 * M_PI * t), 1000.0f + 50.0f * t);
+        in.velocity = Vector3f(-2000.0f * M_PI * sinf(2 * M_PI * t), 2000.0f * M_PI * cosf(2 * M_PI * t), 50.0f);
+    }
+}
+
+// inertial nav replaying the trace position and velocity
+class BM_InertialNav : public AP_InertialNav {
+public:
+    void update(float dt) override {}
+    nav_filter_status get_filter_status() const override {
+        nav_filter_status status {};
+        return status;
+    }
+    struct Location get_origin() const override {
+        struct Location loc {};
+        return loc;
+    }
+    const Vector3f& get_position() const override { return position; }
+    bool get_location(struct Location &loc) const override { return false; }
+    int32_t get_latitude() const override { return 0; }
+    int32_t get_longitude() const override { return 0; }
+    const Vector3f& get_velocity() const override { return velocity; }
+    float get_velocity_xy() const override { return norm(velocity.x, velocity.y); }
+    float get_altitude() const override { return position.z; }
+    float get_velocity_z() const override { return velocity.z; }
+
+    Vector3f position;
+    Vector3f velocity;
+};
+
+static AP_InertialSensor ins;
+static AP_Baro baro;
+static AP_GPS gps;
+static AP_AHRS_DCM ahrs(ins, baro, gps);
+static BM_InertialNav inav;
+static AP_MotorsQuad motors(BM_LOOP_RATE_HZ);
+static AP_Vehicle::MultiCopter aparm;
+
+// lets the benchmark pick the rate controller implementation
+class BM_AttitudeControl : public AC_AttitudeControl_Multi {
+public:
+    using AC_AttitudeControl_Multi::AC_AttitudeControl_Multi;
+    void set_rate_fused(bool fused) { _rate_fused.set(fused); }
+};
+
+static BM_AttitudeControl attitude_control(ahrs, aparm, motors, BM_DT);
+
+// gains as ArduCopter's defaults
+static AC_P p_pos_z(1.0f);
+static AC_P p_vel_z(5.0f);
+static AC_PID pid_accel_z(0.5f, 1.0f, 0.0f, 800.0f, 20.0f, BM_DT);
+static AC_P p_pos_xy(1.0f);
+static AC_PI_2D pi_vel_xy(1.0f, 0.5f, 1000.0f, 5.0f, 0.0025f);
+static AC_PosControl pos_control(ahrs, inav, motors, attitude_control,
+                                 p_pos_z, p_vel_z, pid_accel_z,
+                                 p_pos_xy, pi_vel_xy);
+
+static void setup_once()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    make_trace();
+    aparm.angle_max.set(3000);
+    motors.set_update_rate(490);
+    motors.set_frame_orientation(AP_MOTORS_X_FRAME);
+    motors.Init();
+    motors.armed(true);
+    attitude_control.set_throttle_mix_max();
+    pos_control.set_dt(BM_DT);
+    pos_control.init_xy_controller();
+}
+
+// rate controller alone, targets stepping through the trace. The
+// argument selects the fused three axis controller
+static void BM_RateControllerRun(benchmark::State& state)
+{
+    setup_once();
+    attitude_control.set_rate_fused(state.range(0) != 0);
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        const bm_input &in = trace[i];
+        attitude_control.input_rate_bf_roll_pitch_yaw(in.roll_cd, in.pitch_cd, in.yaw_rate_cds);
+        attitude_control.rate_controller_run();
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+    attitude_control.set_rate_fused(false);
+}
+
+// stabilize mode: angle input and throttle, then the rate controller
+static void BM_AttitudeStabilize(benchmark::State& state)
+{
+    setup_once();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        const bm_input &in = trace[i];
+        attitude_control.input_euler_angle_roll_pitch_euler_rate_yaw(in.roll_cd, in.pitch_cd, in.yaw_rate_cds, 7.0f);
+        attitude_control.set_throttle_out(in.throttle, true, 2.0f);
+        attitude_control.rate_controller_run();
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+}
+
+static void BM_PosControlUpdateZ(benchmark::State& state)
+{
+    setup_once();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        const bm_input &in = trace[i];
+        inav.position = in.position;
+        inav.velocity = in.velocity;
+        pos_control.set_alt_target(1000.0f);
+        pos_control.update_z_controller();
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+}
+
+/*
+  loiter style update. The controller computes dt from the system
+  clock, so at benchmark speeds most calls see dt == 0; the same code
+  runs apart from the feed forward and pilot input integration
+ */
+static void BM_PosControlUpdateXY(benchmark::State& state)
+{
+    setup_once();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        const bm_input &in = trace[i];
+        inav.position = in.position;
+        inav.velocity = in.velocity;
+        pos_control.set_xy_target(0.0f, 0.0f);
+        pos_control.update_xy_controller(AC_PosControl::XY_MODE_POS_LIMITED_AND_VEL_FF, 1.0f, false);
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+}
+
+BENCHMARK(BM_RateControllerRun)->Arg(0)->Arg(1);
+BENCHMARK(BM_AttitudeStabilize);
+BENCHMARK(BM_PosControlUpdateZ);
+BENCHMARK(BM_PosControlUpdateXY);
+
+BENCHMARK_MAIN()
@@ -131,23 +131,31 @@ void AC_Avoid::adjust_velocity_poly(const float kP, const float accel_cmss, Vect
     // e.g. if we are exactly on the boundary.
     Vector2f safe_vel(desired_vel);
 
+    const AC_PolyFence_index &index = _fence.get_polygon_index();
+    if (index.valid() && kP > 0.0f && accel_cmss > 0.0f) {
+        // an edge further than the stopping distance at the desired
+        // speed (plus margin) can't limit the velocity, so only the
+        // edges the index finds within that radius are checked
+        const float radius = get_margin() + get_stopping_distance(kP, accel_cmss, desired_vel.length()) * 1.05f + 10.0f;
+        uint8_t edges[AC_POLYFENCE_INDEX_MAX_EDGES/8+1];
+        index.edges_near(position_xy, radius, edges);
+        for (uint8_t e = 0; e < index.num_edges(); e++) {
+            if ((edges[e/8] & (1U << (e%8))) == 0) {
+                continue;
+            }
+            Vector2f start, end;
+            index.get_edge(e, start, end);
+            if (!limit_velocity_edge(kP, accel_cmss, safe_vel, position_xy, start, end)) {
+                return;
+            }
+        }
+        desired_vel = safe_vel;
+        return;
+    }
+
     uint16_t i, j;
     for (i = 1, j = num_points-1; i < num_points; j = i++) {
-        // end points of current edge
-        Vector2f start = boundary[j];
-        Vector2f end = boundary[i];
-        // vector from current position to closest point on current edge
-        Vector2f limit_direction = Vector2f::closest_point(position_xy, start, end) - position_xy;
-        // distance to closest point
-        const float limit_distance = limit_direction.length();
-        if (!is_zero(limit_distance)) {
-            // We are strictly inside the given edge.
-            // Adjust velocity to not violate this edge.
-            limit_direction /= limit_distance;
-            limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance - get_margin(),0.0f));
-        } else {
-            // We are exactly on the edge - treat this as a fence breach.
-            // i.e. do not adjust velocity.
+        if (!limit_velocity_edge(kP, accel_cmss, safe_vel, position_xy, boundary[j], boundary[i])) {
             return;
         }
     }
@@ -155,6 +163,28 @@ void AC_Avoid::adjust_velocity_poly(const float kP, const float accel_cmss, Vect
     desired_vel = safe_vel;
 }
 
+/*
+ * Limits the velocity so the vehicle can stop before the given fence edge.
+ * Returns false if the vehicle is exactly on the edge.
+ */
+bool AC_Avoid::limit_velocity_edge(const float kP, const float accel_cmss, Vector2f &safe_vel, const Vector2f &position_xy, const Vector2f &start, const Vector2f &end) const
+{
+    // vector from current position to closest point on current edge
+    Vector2f limit_direction = Vector2f::closest_point(position_xy, start, end) - position_xy;
+    // distance to closest point
+    const float limit_distance = limit_direction.length();
+    if (is_zero(limit_distance)) {
+        // We are exactly on the edge - treat this as a fence breach.
+        // i.e. do not adjust velocity.
+        return false;
+    }
+    // We are strictly inside the given edge.
+    // Adjust velocity to not violate this edge.
+    limit_direction /= limit_distance;
+    limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance - get_margin(),0.0f));
+    return true;
+}
+
 /*
  * Adjusts the desired velocity based on output from the proximity sensor
  */
@@ -170,19 +200,22 @@ void AC_Avoid::adjust_velocity_proximity(const float kP, const float accel_cmss,
         return;
     }
 
-    // normalise desired velocity vector
-    Vector2f vel_dir = desired_vel.normalized();
-
-    // get angle of desired velocity
-    float heading_rad = atan2f(vel_dir.y, vel_dir.x);
-
-    // rotate desired velocity angle into body-frame angle
-    float heading_bf_rad = wrap_PI(heading_rad - _ahrs.yaw);
-
-    // get nearest object using body-frame angle and shorten desired velocity (which must remain in earth-frame)
-    float distance_m;
-    if (_proximity.get_horizontal_distance(degrees(heading_bf_rad), distance_m)) {
-        limit_velocity(kP, accel_cmss, desired_vel, vel_dir, MAX(distance_m*100.0f - 200.0f, 0.0f));
+    // read the closest obstacle around us from all sensors at once
+    float distance_m[PROXIMITY_MAP_SECTORS];
+    const uint8_t valid = _proximity.get_map().get_horizontal_distances(distance_m);
+
+    // limit the velocity towards each sector holding an obstacle. The
+    // earth-frame direction of each sector is stepped round clockwise
+    // from the nose
+    const float step_cos = cosf(radians(PROXIMITY_MAP_SECTOR_WIDTH_DEG));
+    const float step_sin = sinf(radians(PROXIMITY_MAP_SECTOR_WIDTH_DEG));
+    Vector2f limit_direction(_ahrs.cos_yaw(), _ahrs.sin_yaw());
+    for (uint8_t i=0; i<PROXIMITY_MAP_SECTORS; i++) {
+        if (valid & (1U<<i)) {
+            limit_velocity(kP, accel_cmss, desired_vel, limit_direction, MAX(distance_m[i]*100.0f - 200.0f, 0.0f));
+        }
+        limit_direction = Vector2f(limit_direction.x * step_cos - limit_direction.y * step_sin,
+                                   limit_direction.x * step_sin + limit_direction.y * step_cos);
     }
 }
 
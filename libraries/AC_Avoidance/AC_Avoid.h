@@ -63,6 +63,12 @@ private:
      */
     void limit_velocity(const float kP, const float accel_cmss, Vector2f &desired_vel, const Vector2f limit_direction, const float limit_distance) const;
 
+    /*
+     * Limits safe_vel so the vehicle can stop before the fence edge from start to end.
+     * Returns false if the vehicle is exactly on the edge.
+     */
+    bool limit_velocity_edge(const float kP, const float accel_cmss, Vector2f &safe_vel, const Vector2f &position_xy, const Vector2f &start, const Vector2f &end) const;
+
     /*
      * Gets the current position, relative to home (not relative to EKF origin)
      */
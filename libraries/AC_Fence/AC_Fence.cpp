@@ -212,7 +212,7 @@ uint8_t AC_Fence::check_fence(float curr_alt)
         } else if (_boundary_valid) {
             // check if vehicle is outside the polygon fence
             const Vector3f& position = _inav.get_position();
-            if (_poly_loader.boundary_breached(Vector2f(position.x, position.y), _boundary_num_points, _boundary, true)) {
+            if (polygon_breached(Vector2f(position.x, position.y))) {
                 // check if this is a new breach
                 if ((_breached_fences & AC_FENCE_TYPE_POLYGON) == 0) {
                     // record that we have breached the polygon
@@ -259,7 +259,7 @@ bool AC_Fence::check_destination_within_fence(const Location_Class& loc)
         if (_inav.get_location(temp_loc)) {
             const struct Location &ekf_origin = _inav.get_origin();
             Vector2f position = location_diff(ekf_origin, loc) * 100.0f;
-            if (_poly_loader.boundary_breached(position, _boundary_num_points, _boundary, true)) {
+            if (polygon_breached(position)) {
                 return false;
             }
         }
@@ -338,9 +338,21 @@ Vector2f* AC_Fence::get_polygon_points(uint16_t& num_points) const
 /// returns true if we've breached the polygon boundary.  simple passthrough to underlying _poly_loader object
 bool AC_Fence::boundary_breached(const Vector2f& location, uint16_t num_points, const Vector2f* points) const
 {
+    if (points == _boundary && num_points == _boundary_num_points) {
+        return polygon_breached(location);
+    }
     return _poly_loader.boundary_breached(location, num_points, points, true);
 }
 
+/// returns true if location is outside the loaded polygon fence, or inside one of its exclusion zones
+bool AC_Fence::polygon_breached(const Vector2f& location) const
+{
+    if (_poly_index.valid()) {
+        return _poly_index.breached(location);
+    }
+    return _poly_loader.boundary_breached(location, _boundary_num_points, _boundary, true);
+}
+
 /// handler for polygon fence messages with GCS
 void AC_Fence::handle_msg(mavlink_channel_t chan, mavlink_message_t* msg)
 {
@@ -432,8 +444,15 @@ bool AC_Fence::load_polygon_from_eeprom(bool force_reload)
     _boundary_num_points = _total;
     _boundary_loaded = true;
 
-    // update validity of polygon
-    _boundary_valid = _poly_loader.boundary_valid(_boundary_num_points, _boundary, true);
+    // index the edges, which also accepts exclusion zones as extra
+    // closed rings after the inclusion polygon
+    if (_boundary_num_points > 1 && _poly_index.build(&_boundary[1], _boundary_num_points-1)) {
+        // return point must be inside the fence
+        _boundary_valid = !_poly_index.breached(_boundary[0]);
+    } else {
+        // update validity of polygon
+        _boundary_valid = _poly_loader.boundary_valid(_boundary_num_points, _boundary, true);
+    }
 
     return true;
 }
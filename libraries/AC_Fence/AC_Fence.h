@@ -8,6 +8,7 @@
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_InertialNav/AP_InertialNav.h>     // Inertial Navigation library
 #include <AC_Fence/AC_PolyFence_loader.h>
+#include <AC_Fence/AC_PolyFence_index.h>
 #include <AP_Common/Location.h>
 
 // bit masks for enabled fence types.  Used for TYPE parameter
@@ -107,6 +108,12 @@ public:
     /// returns true if we've breached the polygon boundary.  simple passthrough to underlying _poly_loader object
     bool boundary_breached(const Vector2f& location, uint16_t num_points, const Vector2f* points) const;
 
+    /// returns true if location is outside the loaded polygon fence, or inside one of its exclusion zones
+    bool polygon_breached(const Vector2f& location) const;
+
+    /// spatial index over the loaded polygon fence edges, check valid() before use
+    const AC_PolyFence_index& get_polygon_index() const { return _poly_index; }
+
     /// handler for polygon fence messages with GCS
     void handle_msg(mavlink_channel_t chan, mavlink_message_t* msg);
 
@@ -156,6 +163,7 @@ private:
 
     // polygon fence variables
     AC_PolyFence_loader _poly_loader;               // helper for loading/saving polygon points
+    AC_PolyFence_index _poly_index;                 // spatial index over the boundary edges
     Vector2f        *_boundary = NULL;              // array of boundary points.  Note: point 0 is the return point
     uint8_t         _boundary_num_points = 0;       // number of points in the boundary array (should equal _total parameter after load has completed)
     bool            _boundary_create_attempted = false; // true if we have attempted to create the boundary array
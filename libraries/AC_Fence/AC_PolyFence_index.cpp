@@ -0,0 +1,259 @@
+#include "AC_PolyFence_index.h"
+
+extern const AP_HAL::HAL& hal;
+
+AC_PolyFence_index::~AC_PolyFence_index()
+{
+    clear();
+}
+
+void AC_PolyFence_index::clear()
+{
+    free(_band_edges);
+    free(_cell_edges);
+    _band_edges = nullptr;
+    _cell_edges = nullptr;
+    _num_edges = 0;
+    _num_rings = 0;
+    _points = nullptr;
+}
+
+// band indexes covering [ymin, ymax], clamped to the index
+void AC_PolyFence_index::band_range(float ymin, float ymax, uint8_t& first, uint8_t& last) const
+{
+    first = constrain_int16((ymin - _min.y) * _band_inv_height, 0, AC_POLYFENCE_INDEX_BANDS-1);
+    last = constrain_int16((ymax - _min.y) * _band_inv_height, 0, AC_POLYFENCE_INDEX_BANDS-1);
+}
+
+// cell indexes along one axis covering [min, max], clamped to the grid
+void AC_PolyFence_index::cell_range(float min, float max, float origin, float inv_size, uint8_t& first, uint8_t& last) const
+{
+    first = constrain_int16((min - origin) * inv_size, 0, AC_POLYFENCE_INDEX_GRID-1);
+    last = constrain_int16((max - origin) * inv_size, 0, AC_POLYFENCE_INDEX_GRID-1);
+}
+
+// grid cell holding a location within the bounding box
+uint16_t AC_PolyFence_index::cell_index(const Vector2f& location) const
+{
+    uint8_t x, y, unused;
+    cell_range(location.x, location.x, _min.x, _cell_inv_size.x, x, unused);
+    cell_range(location.y, location.y, _min.y, _cell_inv_size.y, y, unused);
+    return y*AC_POLYFENCE_INDEX_GRID+x;
+}
+
+bool AC_PolyFence_index::build(const Vector2f *points, uint16_t num_points)
+{
+    clear();
+
+    if (points == nullptr || num_points < 4 || num_points > AC_POLYFENCE_INDEX_MAX_EDGES) {
+        return false;
+    }
+
+    // split the points into closed rings, each at least a triangle
+    uint8_t num_edges = 0;
+    uint8_t num_rings = 0;
+    uint16_t ring_first = 0;
+    for (uint16_t i = 1; i < num_points; i++) {
+        _edge_start[num_edges] = i - 1;
+        _edge_ring[num_edges] = num_rings;
+        num_edges++;
+        if (i - ring_first >= 3 && points[i] == points[ring_first]) {
+            // ring closed
+            if (++num_rings > AC_POLYFENCE_INDEX_MAX_RINGS) {
+                return false;
+            }
+            ring_first = ++i;
+        }
+    }
+    if (ring_first != num_points || num_rings == 0) {
+        // last ring not closed
+        return false;
+    }
+
+    // bounding box
+    _min = _max = points[0];
+    for (uint16_t i = 1; i < num_points; i++) {
+        _min.x = MIN(_min.x, points[i].x);
+        _min.y = MIN(_min.y, points[i].y);
+        _max.x = MAX(_max.x, points[i].x);
+        _max.y = MAX(_max.y, points[i].y);
+    }
+    // at least 1cm per cell so a degenerate fence can't divide by zero
+    _band_inv_height = AC_POLYFENCE_INDEX_BANDS / MAX(_max.y - _min.y, (float)AC_POLYFENCE_INDEX_BANDS);
+    _cell_inv_size.x = AC_POLYFENCE_INDEX_GRID / MAX(_max.x - _min.x, (float)AC_POLYFENCE_INDEX_GRID);
+    _cell_inv_size.y = AC_POLYFENCE_INDEX_GRID / MAX(_max.y - _min.y, (float)AC_POLYFENCE_INDEX_GRID);
+
+    // count the entries of each band and cell
+    uint16_t band_count[AC_POLYFENCE_INDEX_BANDS] {};
+    uint16_t cell_count[AC_POLYFENCE_INDEX_GRID*AC_POLYFENCE_INDEX_GRID] {};
+    uint16_t band_total = 0;
+    uint16_t cell_total = 0;
+    for (uint8_t e = 0; e < num_edges; e++) {
+        const Vector2f &a = points[_edge_start[e]];
+        const Vector2f &b = points[_edge_start[e]+1];
+        uint8_t b0, b1, x0, x1, y0, y1;
+        band_range(MIN(a.y, b.y), MAX(a.y, b.y), b0, b1);
+        for (uint8_t k = b0; k <= b1; k++) {
+            band_count[k]++;
+            band_total++;
+        }
+        cell_range(MIN(a.x, b.x), MAX(a.x, b.x), _min.x, _cell_inv_size.x, x0, x1);
+        cell_range(MIN(a.y, b.y), MAX(a.y, b.y), _min.y, _cell_inv_size.y, y0, y1);
+        for (uint8_t y = y0; y <= y1; y++) {
+            for (uint8_t x = x0; x <= x1; x++) {
+                cell_count[y*AC_POLYFENCE_INDEX_GRID+x]++;
+                cell_total++;
+            }
+        }
+    }
+
+    if (hal.util->available_memory() < 100U + band_total + cell_total) {
+        // too risky, leave the fence to the linear checks
+        return false;
+    }
+    _band_edges = (uint8_t *)calloc(band_total, 1);
+    _cell_edges = (uint8_t *)calloc(cell_total, 1);
+    if (_band_edges == nullptr || _cell_edges == nullptr) {
+        clear();
+        return false;
+    }
+
+    // turn counts into start offsets, then fill in edge order
+    _band_start[0] = 0;
+    for (uint8_t k = 0; k < AC_POLYFENCE_INDEX_BANDS; k++) {
+        _band_start[k+1] = _band_start[k] + band_count[k];
+        band_count[k] = _band_start[k];
+    }
+    _cell_start[0] = 0;
+    for (uint16_t c = 0; c < AC_POLYFENCE_INDEX_GRID*AC_POLYFENCE_INDEX_GRID; c++) {
+        _cell_start[c+1] = _cell_start[c] + cell_count[c];
+        cell_count[c] = _cell_start[c];
+    }
+    for (uint8_t e = 0; e < num_edges; e++) {
+        const Vector2f &a = points[_edge_start[e]];
+        const Vector2f &b = points[_edge_start[e]+1];
+        uint8_t b0, b1, x0, x1, y0, y1;
+        band_range(MIN(a.y, b.y), MAX(a.y, b.y), b0, b1);
+        for (uint8_t k = b0; k <= b1; k++) {
+            _band_edges[band_count[k]++] = e;
+        }
+        cell_range(MIN(a.x, b.x), MAX(a.x, b.x), _min.x, _cell_inv_size.x, x0, x1);
+        cell_range(MIN(a.y, b.y), MAX(a.y, b.y), _min.y, _cell_inv_size.y, y0, y1);
+        for (uint8_t y = y0; y <= y1; y++) {
+            for (uint8_t x = x0; x <= x1; x++) {
+                const uint16_t c = y*AC_POLYFENCE_INDEX_GRID+x;
+                _cell_edges[cell_count[c]++] = e;
+            }
+        }
+    }
+
+    _points = points;
+    _num_rings = num_rings;
+    _num_edges = num_edges;
+
+    classify_cells();
+    return true;
+}
+
+// work out the state of each cell no edge passes through. Every point
+// mapping to such a cell is on the same side of every edge, so testing
+// the cell's centre gives the answer for the whole cell
+void AC_PolyFence_index::classify_cells()
+{
+    memset(_cell_known, 0, sizeof(_cell_known));
+    memset(_cell_breached, 0, sizeof(_cell_breached));
+    for (uint8_t y = 0; y < AC_POLYFENCE_INDEX_GRID; y++) {
+        for (uint8_t x = 0; x < AC_POLYFENCE_INDEX_GRID; x++) {
+            const uint16_t c = y*AC_POLYFENCE_INDEX_GRID+x;
+            if (_cell_start[c] != _cell_start[c+1]) {
+                continue;
+            }
+            const Vector2f centre(_min.x + (x + 0.5f) / _cell_inv_size.x,
+                                  _min.y + (y + 0.5f) / _cell_inv_size.y);
+            if (centre.x > _max.x || centre.y > _max.y || cell_index(centre) != c) {
+                // rounding put the centre elsewhere, leave the cell to
+                // the edge test
+                continue;
+            }
+            _cell_known[c/8] |= 1U << (c%8);
+            if (breached_crossings(centre)) {
+                _cell_breached[c/8] |= 1U << (c%8);
+            }
+        }
+    }
+}
+
+// returns true if location is outside the inclusion ring or inside
+// any exclusion ring
+bool AC_PolyFence_index::breached(const Vector2f& location) const
+{
+    if (!valid()) {
+        return false;
+    }
+    if (location.y < _min.y || location.y > _max.y ||
+        location.x < _min.x || location.x > _max.x) {
+        // outside every ring
+        return true;
+    }
+
+    // away from the edges the answer was worked out at build time
+    const uint16_t c = cell_index(location);
+    if (_cell_known[c/8] & (1U << (c%8))) {
+        return (_cell_breached[c/8] & (1U << (c%8))) != 0;
+    }
+
+    return breached_crossings(location);
+}
+
+// breach test counting the edge crossings of a horizontal ray from a
+// location within the bounding box
+bool AC_PolyFence_index::breached_crossings(const Vector2f& location) const
+{
+    // only edges spanning the location's band can cross a horizontal
+    // ray from it, so the crossing count over the band matches the
+    // count over the whole polygon
+    uint8_t band, unused;
+    band_range(location.y, location.y, band, unused);
+    uint8_t inside = 0;
+    for (uint16_t k = _band_start[band]; k < _band_start[band+1]; k++) {
+        const uint8_t e = _band_edges[k];
+        const Vector2f &a = _points[_edge_start[e]];
+        const Vector2f &b = _points[_edge_start[e]+1];
+        if (Polygon_edge_crossed(location, b, a)) {
+            inside ^= 1U << _edge_ring[e];
+        }
+    }
+
+    // outside the inclusion ring, or inside an exclusion ring
+    return inside != 1;
+}
+
+void AC_PolyFence_index::edges_near(const Vector2f& location, float radius, uint8_t edges[AC_POLYFENCE_INDEX_MAX_EDGES/8+1]) const
+{
+    memset(edges, 0, AC_POLYFENCE_INDEX_MAX_EDGES/8+1);
+    if (!valid()) {
+        return;
+    }
+    if (location.x + radius < _min.x || location.x - radius > _max.x ||
+        location.y + radius < _min.y || location.y - radius > _max.y) {
+        return;
+    }
+    uint8_t x0, x1, y0, y1;
+    cell_range(location.x - radius, location.x + radius, _min.x, _cell_inv_size.x, x0, x1);
+    cell_range(location.y - radius, location.y + radius, _min.y, _cell_inv_size.y, y0, y1);
+    for (uint8_t y = y0; y <= y1; y++) {
+        for (uint8_t x = x0; x <= x1; x++) {
+            const uint16_t c = y*AC_POLYFENCE_INDEX_GRID+x;
+            for (uint16_t k = _cell_start[c]; k < _cell_start[c+1]; k++) {
+                const uint8_t e = _cell_edges[k];
+                edges[e/8] |= 1U << (e%8);
+            }
+        }
+    }
+}
+
+void AC_PolyFence_index::get_edge(uint8_t edge, Vector2f& start, Vector2f& end) const
+{
+    start = _points[_edge_start[edge]];
+    end = _points[_edge_start[edge]+1];
+}
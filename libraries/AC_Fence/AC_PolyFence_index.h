@@ -0,0 +1,92 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+// number of horizontal bands used for breach tests
+#define AC_POLYFENCE_INDEX_BANDS        32
+// number of grid cells along each side used for nearby edge queries
+#define AC_POLYFENCE_INDEX_GRID         16
+// maximum number of closed rings: the inclusion polygon plus exclusion zones
+#define AC_POLYFENCE_INDEX_MAX_RINGS    8
+// maximum number of edges, limited by the 255 fence points
+#define AC_POLYFENCE_INDEX_MAX_EDGES    255
+
+/*
+  spatial index over the edges of a polygon fence, built once when
+  the fence is loaded so that breach tests and nearby edge queries
+  only look at the edges close to the vehicle.
+
+  The fence points (after the return point) hold one or more closed
+  rings, each ending with a repeat of its first point. The first ring
+  is the inclusion fence and any further rings are exclusion zones.
+
+  Grid cells crossed by no edge are wholly inside or wholly outside
+  the fence, so their state is worked out at build time and a breach
+  test from one of them is a table lookup.
+ */
+class AC_PolyFence_index
+{
+
+public:
+    ~AC_PolyFence_index();
+
+    // build the index over points, which must stay valid while the
+    // index is used. Returns false if the rings are not closed or
+    // memory is short, in which case the index is left empty
+    bool build(const Vector2f *points, uint16_t num_points);
+
+    // release the index
+    void clear();
+
+    // true if build() succeeded
+    bool valid() const { return _num_edges > 0; }
+
+    uint8_t num_rings() const { return _num_rings; }
+    uint8_t num_edges() const { return _num_edges; }
+
+    // returns true if location is outside the inclusion ring or
+    // inside any exclusion ring
+    bool breached(const Vector2f& location) const;
+
+    // mark in edges (a bitmask of num_edges() bits) every edge that
+    // could be within radius of location. Edges further away may be
+    // included, but no closer edge is left out
+    void edges_near(const Vector2f& location, float radius, uint8_t edges[AC_POLYFENCE_INDEX_MAX_EDGES/8+1]) const;
+
+    // end points of an edge
+    void get_edge(uint8_t edge, Vector2f& start, Vector2f& end) const;
+
+private:
+    void band_range(float ymin, float ymax, uint8_t& first, uint8_t& last) const;
+    void cell_range(float min, float max, float origin, float inv_size, uint8_t& first, uint8_t& last) const;
+    uint16_t cell_index(const Vector2f& location) const;
+    bool breached_crossings(const Vector2f& location) const;
+    void classify_cells();
+
+    const Vector2f *_points = nullptr;
+
+    // edge i runs from _points[_edge_start[i]] to the following point
+    uint8_t _edge_start[AC_POLYFENCE_INDEX_MAX_EDGES];
+    uint8_t _edge_ring[AC_POLYFENCE_INDEX_MAX_EDGES];
+    uint8_t _num_edges = 0;
+    uint8_t _num_rings = 0;
+
+    // bounding box of all edges
+    Vector2f _min;
+    Vector2f _max;
+    float _band_inv_height;
+    Vector2f _cell_inv_size;
+
+    // edges overlapping each band and each cell, as index ranges into
+    // one allocated list of edge numbers
+    uint16_t _band_start[AC_POLYFENCE_INDEX_BANDS+1];
+    uint16_t _cell_start[AC_POLYFENCE_INDEX_GRID*AC_POLYFENCE_INDEX_GRID+1];
+    uint8_t *_band_edges = nullptr;
+    uint8_t *_cell_edges = nullptr;
+
+    // bitmasks over the cells: state known without an edge test, and
+    // that state
+    uint8_t _cell_known[AC_POLYFENCE_INDEX_GRID*AC_POLYFENCE_INDEX_GRID/8];
+    uint8_t _cell_breached[AC_POLYFENCE_INDEX_GRID*AC_POLYFENCE_INDEX_GRID/8];
+};
@@ -199,6 +199,82 @@ void AC_PID::operator() (float p, float i, float d, float imaxval, float input_f
     _dt = dt;
 }
 
+/*
+  rate_update_axes - the per axis state is gathered into arrays so the
+  filter, P, I and D steps each run as one loop across the axes, with
+  clamping instead of branches for the integrator limit
+ */
+void AC_PID::rate_update_axes(AC_PID *const pid[], const float target[], const float error[], const bool i_hold[],
+                              uint8_t filter_all_mask, float output[], uint8_t num_axes)
+{
+    num_axes = MIN(num_axes, RATE_AXES_MAX);
+
+    float input[RATE_AXES_MAX];
+    float derivative[RATE_AXES_MAX];
+    float integrator[RATE_AXES_MAX];
+    float alpha[RATE_AXES_MAX];
+    for (uint8_t i=0; i<num_axes; i++) {
+        input[i] = pid[i]->_input;
+        derivative[i] = pid[i]->_derivative;
+        integrator[i] = pid[i]->_integrator;
+        alpha[i] = pid[i]->get_filt_alpha();
+    }
+
+    // input filter and derivative
+    for (uint8_t i=0; i<num_axes; i++) {
+        AC_PID &p = *pid[i];
+        // don't process inf or NaN
+        if (!isfinite(error[i])) {
+            continue;
+        }
+        const bool filter_all = (filter_all_mask & (1U<<i)) != 0;
+        if (p._flags._reset_filter) {
+            p._flags._reset_filter = false;
+            derivative[i] = 0.0f;
+            if (filter_all) {
+                input[i] = error[i];
+            }
+        }
+        if (filter_all) {
+            const float input_filt_change = alpha[i] * (error[i] - input[i]);
+            input[i] += input_filt_change;
+            if (p._dt > 0.0f) {
+                derivative[i] = input_filt_change / p._dt;
+            }
+        } else {
+            if (p._dt > 0.0f) {
+                derivative[i] += alpha[i] * ((error[i] - input[i]) / p._dt - derivative[i]);
+            }
+            input[i] = error[i];
+        }
+    }
+
+    // P, I and D terms
+    for (uint8_t i=0; i<num_axes; i++) {
+        AC_PID &p = *pid[i];
+        float i_term = integrator[i];
+        // integrator can only be reduced while held
+        const bool i_update = !i_hold[i] || (integrator[i] * error[i] < 0.0f);
+        if (i_update) {
+            if (is_zero(p._ki) || is_zero(p._dt)) {
+                i_term = 0.0f;
+            } else {
+                integrator[i] = constrain_float(integrator[i] + input[i] * p._ki * p._dt, -p._imax, p._imax);
+                i_term = integrator[i];
+                p._pid_info.I = i_term;
+            }
+        }
+        p._pid_info.desired = target[i];
+        p._pid_info.P = input[i] * p._kp;
+        p._pid_info.D = p._kd * derivative[i];
+        output[i] = constrain_float(p._pid_info.P + i_term + p._pid_info.D, -1.0f, 1.0f);
+
+        p._input = input[i];
+        p._derivative = derivative[i];
+        p._integrator = integrator[i];
+    }
+}
+
 // calc_filt_alpha - recalculate the input filter alpha
 float AC_PID::get_filt_alpha() const
 {
@@ -78,6 +78,15 @@ public:
 
     const       DataFlash_Class::PID_Info& get_pid_info(void) const { return _pid_info; }
 
+    // rate_update_axes - run one step of a rate controller on num_axes
+    //  controllers together. For each axis this matches set_input_filter_d
+    //  (or set_input_filter_all if its bit is set in filter_all_mask),
+    //  set_desired_rate, get_p, get_d and get_i, where the integrator is
+    //  only moved if i_hold is false or the error would shrink it. Outputs
+    //  are P+I+D constrained to +-1
+    static void rate_update_axes(AC_PID *const pid[], const float target[], const float error[], const bool i_hold[],
+                                 uint8_t filter_all_mask, float output[], uint8_t num_axes);
+
     // parameter var table
     static const struct AP_Param::GroupInfo        var_info[];
 
@@ -90,6 +99,9 @@ protected:
     AP_Float        _imax;
     AP_Float        _filt_hz;                   // PID Input filter frequency in Hz
 
+    // largest number of axes rate_update_axes can run together
+    static const uint8_t RATE_AXES_MAX = 3;
+
     // flags
     struct ac_pid_flags {
         bool        _reset_filter : 1;    // true when input filter should be reset during next call to set_input
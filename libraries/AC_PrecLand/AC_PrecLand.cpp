@@ -48,6 +48,24 @@ const AP_Param::GroupInfo AC_PrecLand::var_info[] = {
     // @Units: Centimeters
     AP_GROUPINFO("LAND_OFS_Y",    4, AC_PrecLand, _land_ofs_cm_y, 0),
 
+    // @Param: LAG
+    // @DisplayName: Sensor lag
+    // @Description: Time from the sensor seeing the target to the measurement arriving. Measurements are fused against the estimate from this long ago
+    // @Range: 0 0.25
+    // @Increment: 0.01
+    // @User: Advanced
+    // @Units: Seconds
+    AP_GROUPINFO("LAG",    5, AC_PrecLand, _lag, 0.02f),
+
+    // @Param: EST_RATE
+    // @DisplayName: Estimator rate
+    // @Description: Rate the target estimator is predicted forward at. Inertial data in between is accumulated
+    // @Range: 10 400
+    // @Increment: 10
+    // @User: Advanced
+    // @Units: Hz
+    AP_GROUPINFO("EST_RATE",    6, AC_PrecLand, _est_rate, 100),
+
     AP_GROUPEND
 };
 
@@ -60,6 +78,9 @@ AC_PrecLand::AC_PrecLand(const AP_AHRS& ahrs, const AP_InertialNav& inav) :
     _inav(inav),
     _last_update_ms(0),
     _last_backend_los_meas_ms(0),
+    _outlier_reject_count(0),
+    _history_head(0),
+    _history_count(0),
     _backend(NULL)
 {
     // set parameters to defaults
@@ -67,6 +88,7 @@ AC_PrecLand::AC_PrecLand(const AP_AHRS& ahrs, const AP_InertialNav& inav) :
 
     // other initialisation
     _backend_state.healthy = false;
+    memset(&_accum, 0, sizeof(_accum));
 }
 
 
@@ -109,78 +131,154 @@ void AC_PrecLand::init()
 // update - give chance to driver to get updates from sensor
 void AC_PrecLand::update(float rangefinder_alt_cm, bool rangefinder_alt_valid)
 {
-    _attitude_history.push_back(_ahrs.get_rotation_body_to_ned());
-    
     // run backend update
-    if (_backend != NULL && _enabled) {
-        // read from sensor
-        _backend->update();
+    if (_backend == NULL || !_enabled) {
+        return;
+    }
 
-        Vector3f vehicleVelocityNED = _inav.get_velocity()*0.01f;
-        vehicleVelocityNED.z = -vehicleVelocityNED.z;
+    // read from sensor
+    _backend->update();
+
+    // accumulate the target's change in velocity relative to the vehicle
+    float dt;
+    Vector3f delVel;
+    _ahrs.getCorrectedDeltaVelocityNED(delVel, dt);
+    _accum.dt += dt;
+    _accum.dt_sq += sq(dt);
+    _accum.targetDelVel.x -= delVel.x;
+    _accum.targetDelVel.y -= delVel.y;
+
+    const float step_dt = 1.0f / constrain_int16(_est_rate, 10, 400);
+    if (_accum.dt >= 0.9f*step_dt) {
+        run_estimator_step();
+    }
+
+    if (_backend->have_los_meas() && _backend->los_meas_time_ms() != _last_backend_los_meas_ms) {
+        // we have a new, unique los measurement
+        _last_backend_los_meas_ms = _backend->los_meas_time_ms();
+        fuse_los_measurement(rangefinder_alt_cm, rangefinder_alt_valid);
+    }
+}
 
-        if (target_acquired()) {
-            // EKF prediction step
-            float dt;
-            Vector3f targetDelVel;
-            _ahrs.getCorrectedDeltaVelocityNED(targetDelVel, dt);
-            targetDelVel = -targetDelVel;
+/*
+  predict the estimator over the inertial data accumulated since the
+  last step, and record the step so a delayed measurement can be
+  fused at the time it was taken
+ */
+void AC_PrecLand::run_estimator_step()
+{
+    _history_head = (_history_head + 1) % AC_PRECLAND_HISTORY_LEN;
+    if (_history_count < AC_PRECLAND_HISTORY_LEN) {
+        _history_count++;
+    }
+    inertial_step &step = _history[_history_head];
+    step.time_ms = AP_HAL::millis();
+    step.dt = _accum.dt;
+    step.targetDelVel = _accum.targetDelVel;
+    // noise of the summed delta velocities, matching one predict per sample
+    step.dVelNoise = 0.5f*sqrtf(_accum.dt_sq);
+    step.Tbn = _ahrs.get_rotation_body_to_ned();
+    step.ekf_valid = target_acquired();
+
+    if (step.ekf_valid) {
+        // EKF prediction step
+        _ekf_x.predict(step.dt, step.targetDelVel.x, step.dVelNoise);
+        _ekf_y.predict(step.dt, step.targetDelVel.y, step.dVelNoise);
+        step.ekf_x = _ekf_x;
+        step.ekf_y = _ekf_y;
+    }
 
-            _ekf_x.predict(dt, targetDelVel.x, 0.5f*dt);
-            _ekf_y.predict(dt, targetDelVel.y, 0.5f*dt);
-        }
+    memset(&_accum, 0, sizeof(_accum));
+}
+
+/*
+  fuse the backend's line of sight measurement. The estimator is wound
+  back to the step the measurement was taken in, the measurement fused
+  there and the later steps predicted again
+ */
+void AC_PrecLand::fuse_los_measurement(float rangefinder_alt_cm, bool rangefinder_alt_valid)
+{
+    // find the newest step no later than the measurement
+    const uint32_t meas_time_ms = _last_backend_los_meas_ms - (uint32_t)(constrain_float(_lag, 0.0f, 0.25f)*1000.0f);
+    int16_t n = (int16_t)_history_count - 1;
+    while (n > 0 && (int32_t)(_history[history_index(n)].time_ms - meas_time_ms) > 0) {
+        n--;
+    }
+    inertial_step *step = (n >= 0) ? &_history[history_index(n)] : NULL;
+
+    Vector3f target_vec_unit_body;
+    _backend->get_los_body(target_vec_unit_body);
+
+    // Apply sensor yaw alignment rotation
+    float sin_yaw_align = sinf(radians(_yaw_align*0.01f));
+    float cos_yaw_align = cosf(radians(_yaw_align*0.01f));
+    Matrix3f Rz = Matrix3f(
+        cos_yaw_align, -sin_yaw_align, 0,
+        sin_yaw_align, cos_yaw_align, 0,
+        0, 0, 1
+    );
+
+    const Matrix3f &Tbn = (step != NULL) ? step->Tbn : _ahrs.get_rotation_body_to_ned();
+    Vector3f target_vec_unit_ned = Tbn * Rz * target_vec_unit_body;
+
+    bool target_vec_valid = target_vec_unit_ned.z > 0.0f;
+
+    if (!target_vec_valid || !rangefinder_alt_valid || rangefinder_alt_cm <= 0.0f) {
+        return;
+    }
+
+    float alt = MAX(rangefinder_alt_cm*0.01f, 0.0f);
+    float dist = alt/target_vec_unit_ned.z;
+    Vector3f targetPosRelMeasNED = Vector3f(target_vec_unit_ned.x*dist, target_vec_unit_ned.y*dist, alt);
 
-        if (_backend->have_los_meas() && _backend->los_meas_time_ms() != _last_backend_los_meas_ms) {
-            // we have a new, unique los measurement
-            _last_backend_los_meas_ms = _backend->los_meas_time_ms();
-
-            Vector3f target_vec_unit_body;
-            _backend->get_los_body(target_vec_unit_body);
-
-            // Apply sensor yaw alignment rotation
-            float sin_yaw_align = sinf(radians(_yaw_align*0.01f));
-            float cos_yaw_align = cosf(radians(_yaw_align*0.01f));
-            Matrix3f Rz = Matrix3f(
-                cos_yaw_align, -sin_yaw_align, 0,
-                sin_yaw_align, cos_yaw_align, 0,
-                0, 0, 1
-            );
-
-            Vector3f target_vec_unit_ned = _attitude_history.front() * Rz * target_vec_unit_body;
-
-            bool target_vec_valid = target_vec_unit_ned.z > 0.0f;
-
-            if (target_vec_valid && rangefinder_alt_valid && rangefinder_alt_cm > 0.0f) {
-                float alt = MAX(rangefinder_alt_cm*0.01f, 0.0f);
-                float dist = alt/target_vec_unit_ned.z;
-                Vector3f targetPosRelMeasNED = Vector3f(target_vec_unit_ned.x*dist, target_vec_unit_ned.y*dist, alt);
-
-                float xy_pos_var = sq(targetPosRelMeasNED.z*(0.01f + 0.01f*_ahrs.get_gyro().length()) + 0.02f);
-                if (!target_acquired()) {
-                    // reset filter state
-                    if (_inav.get_filter_status().flags.horiz_pos_rel) {
-                        _ekf_x.init(targetPosRelMeasNED.x, xy_pos_var, -vehicleVelocityNED.x, sq(2.0f));
-                        _ekf_y.init(targetPosRelMeasNED.y, xy_pos_var, -vehicleVelocityNED.y, sq(2.0f));
-                    } else {
-                        _ekf_x.init(targetPosRelMeasNED.x, xy_pos_var, 0.0f, sq(10.0f));
-                        _ekf_y.init(targetPosRelMeasNED.y, xy_pos_var, 0.0f, sq(10.0f));
-                    }
-                    _last_update_ms = AP_HAL::millis();
-                } else {
-                    float NIS_x = _ekf_x.getPosNIS(targetPosRelMeasNED.x, xy_pos_var);
-                    float NIS_y = _ekf_y.getPosNIS(targetPosRelMeasNED.y, xy_pos_var);
-                    if (MAX(NIS_x, NIS_y) < 3.0f || _outlier_reject_count >= 3) {
-                        _outlier_reject_count = 0;
-                        _ekf_x.fusePos(targetPosRelMeasNED.x, xy_pos_var);
-                        _ekf_y.fusePos(targetPosRelMeasNED.y, xy_pos_var);
-                        _last_update_ms = AP_HAL::millis();
-                    } else {
-                        _outlier_reject_count++;
-                    }
-                }
-            }
+    float xy_pos_var = sq(targetPosRelMeasNED.z*(0.01f + 0.01f*_ahrs.get_gyro().length()) + 0.02f);
+
+    PosVelEKF ekf_x = _ekf_x;
+    PosVelEKF ekf_y = _ekf_y;
+    if (!target_acquired()) {
+        // reset filter state
+        Vector3f vehicleVelocityNED = _inav.get_velocity()*0.01f;
+        vehicleVelocityNED.z = -vehicleVelocityNED.z;
+        if (_inav.get_filter_status().flags.horiz_pos_rel) {
+            ekf_x.init(targetPosRelMeasNED.x, xy_pos_var, -vehicleVelocityNED.x, sq(2.0f));
+            ekf_y.init(targetPosRelMeasNED.y, xy_pos_var, -vehicleVelocityNED.y, sq(2.0f));
+        } else {
+            ekf_x.init(targetPosRelMeasNED.x, xy_pos_var, 0.0f, sq(10.0f));
+            ekf_y.init(targetPosRelMeasNED.y, xy_pos_var, 0.0f, sq(10.0f));
+        }
+    } else {
+        if (step != NULL && step->ekf_valid) {
+            ekf_x = step->ekf_x;
+            ekf_y = step->ekf_y;
+        }
+        float NIS_x = ekf_x.getPosNIS(targetPosRelMeasNED.x, xy_pos_var);
+        float NIS_y = ekf_y.getPosNIS(targetPosRelMeasNED.y, xy_pos_var);
+        if (MAX(NIS_x, NIS_y) >= 3.0f && _outlier_reject_count < 3) {
+            _outlier_reject_count++;
+            return;
+        }
+        _outlier_reject_count = 0;
+        ekf_x.fusePos(targetPosRelMeasNED.x, xy_pos_var);
+        ekf_y.fusePos(targetPosRelMeasNED.y, xy_pos_var);
+    }
+    _last_update_ms = AP_HAL::millis();
+
+    // bring the corrected estimate forward to now
+    if (step != NULL) {
+        step->ekf_x = ekf_x;
+        step->ekf_y = ekf_y;
+        step->ekf_valid = true;
+        for (uint8_t i=n+1; i<_history_count; i++) {
+            inertial_step &later = _history[history_index(i)];
+            ekf_x.predict(later.dt, later.targetDelVel.x, later.dVelNoise);
+            ekf_y.predict(later.dt, later.targetDelVel.y, later.dVelNoise);
+            later.ekf_x = ekf_x;
+            later.ekf_y = ekf_y;
+            later.ekf_valid = true;
         }
     }
+    _ekf_x = ekf_x;
+    _ekf_y = ekf_y;
 }
 
 bool AC_PrecLand::target_acquired() const
@@ -6,7 +6,10 @@
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <stdint.h>
 #include "PosVelEKF.h"
-#include <AP_Buffer/AP_Buffer.h>
+
+// number of estimator steps held for fusing delayed measurements. At
+// the default PRECLAND_EST_RATE this covers 320ms of sensor lag
+#define AC_PRECLAND_HISTORY_LEN 32
 
 // declare backend classes
 class AC_PrecLand_Backend;
@@ -73,6 +76,29 @@ public:
     static const struct AP_Param::GroupInfo var_info[];
 
 private:
+    // inertial data for one estimator step, and the estimator state
+    // after it was applied
+    struct inertial_step {
+        uint32_t    time_ms;
+        float       dt;
+        Vector2f    targetDelVel;
+        float       dVelNoise;
+        Matrix3f    Tbn;            // body to NED rotation at the end of the step
+        bool        ekf_valid;
+        PosVelEKF   ekf_x, ekf_y;
+    };
+
+    // run an estimator prediction step over the accumulated inertial data
+    void run_estimator_step();
+
+    // fuse a new line of sight measurement at the time it was taken
+    void fuse_los_measurement(float rangefinder_alt_cm, bool rangefinder_alt_valid);
+
+    // index into _history of the n'th oldest step
+    uint8_t history_index(uint8_t n) const {
+        return (_history_head + AC_PRECLAND_HISTORY_LEN - _history_count + 1 + n) % AC_PRECLAND_HISTORY_LEN;
+    }
+
     // returns enabled parameter as an behaviour
     enum PrecLandBehaviour get_behaviour() const { return (enum PrecLandBehaviour)(_enabled.get()); }
 
@@ -86,14 +112,26 @@ private:
     AP_Float                    _yaw_align;         // Yaw angle from body x-axis to sensor x-axis.
     AP_Float                    _land_ofs_cm_x;     // Desired landing position of the camera forward of the target in vehicle body frame
     AP_Float                    _land_ofs_cm_y;     // Desired landing position of the camera right of the target in vehicle body frame
+    AP_Float                    _lag;               // sensor latency in seconds
+    AP_Int16                    _est_rate;          // estimator prediction rate in Hz
 
     uint32_t                    _last_update_ms;      // epoch time in millisecond when update is called
     uint32_t                    _last_backend_los_meas_ms;
 
     PosVelEKF                   _ekf_x, _ekf_y;
     uint32_t                    _outlier_reject_count;
-    
-    AP_Buffer<Matrix3f,8>       _attitude_history;
+
+    // inertial data gathered since the last estimator step
+    struct {
+        float       dt;
+        float       dt_sq;
+        Vector2f    targetDelVel;
+    } _accum;
+
+    // recent estimator steps, _history_head is the newest
+    inertial_step               _history[AC_PRECLAND_HISTORY_LEN];
+    uint8_t                     _history_head;
+    uint8_t                     _history_count;
 
     // backend state
     struct precland_state {
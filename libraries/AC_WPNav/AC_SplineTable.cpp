@@ -0,0 +1,61 @@
+#include "AC_SplineTable.h"
+
+// speed along the spline at a given spline time
+static float spline_speed(const Vector3f solution[4], float t)
+{
+    const Vector3f vel = solution[1] + solution[2] * (2.0f * t) + solution[3] * (3.0f * t * t);
+    return vel.length();
+}
+
+/*
+  integrate the speed over each interval with Simpson's rule. The
+  speed of a cubic is smooth, so this is accurate to well under a
+  centimetre on any realistic segment
+ */
+void AC_SplineTable::update(const Vector3f solution[4])
+{
+    const float step = 1.0f / (num_points - 1);
+    float speed0 = spline_speed(solution, 0.0f);
+    _dist[0] = 0.0f;
+    for (uint8_t i=1; i<num_points; i++) {
+        const float t1 = i * step;
+        const float speed_mid = spline_speed(solution, t1 - 0.5f * step);
+        const float speed1 = spline_speed(solution, t1);
+        _dist[i] = _dist[i-1] + (speed0 + 4.0f * speed_mid + speed1) * step / 6.0f;
+        speed0 = speed1;
+    }
+    _cursor = 0;
+}
+
+float AC_SplineTable::distance_at(float spline_time) const
+{
+    const float pos = constrain_float(spline_time, 0.0f, 1.0f) * (num_points - 1);
+    const uint8_t i = MIN((uint8_t)pos, num_points - 2);
+    return _dist[i] + (_dist[i+1] - _dist[i]) * (pos - i);
+}
+
+float AC_SplineTable::time_at(float dist)
+{
+    const float step = 1.0f / (num_points - 1);
+    if (dist <= 0.0f) {
+        _cursor = 0;
+        return 0.0f;
+    }
+
+    // move the cursor to the interval holding dist. Along a track the
+    // distance only grows by a fraction of an interval each call
+    while (_cursor > 0 && _dist[_cursor] > dist) {
+        _cursor--;
+    }
+    while (_cursor < num_points - 2 && _dist[_cursor+1] < dist) {
+        _cursor++;
+    }
+
+    const float interval = _dist[_cursor+1] - _dist[_cursor];
+    if (interval <= 0.0f) {
+        // zero length segment
+        return (_cursor + 1) * step;
+    }
+    // past the end this extrapolates along the last interval
+    return (_cursor + (dist - _dist[_cursor]) / interval) * step;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+/*
+  arc length table for a cubic Hermite spline segment, stored as the
+  coefficient array used by AC_WPNav. Built once per segment so the
+  spline time for a distance along the path can be found by table
+  interpolation, giving an even speed along the whole curve
+ */
+class AC_SplineTable {
+public:
+    // number of samples of spline time, uniformly spaced from 0 to 1
+    static const uint8_t num_points = 17;
+
+    // rebuild the table from hermite coefficients
+    void update(const Vector3f solution[4]);
+
+    // total length of the segment
+    float length() const { return _dist[num_points-1]; }
+
+    // distance along the segment at a spline time
+    float distance_at(float spline_time) const;
+
+    // spline time at a distance along the segment. Distances past the
+    // end extrapolate beyond 1. Successive calls with increasing
+    // distance cost constant time
+    float time_at(float dist);
+
+private:
+    // cumulative arc length at each sample
+    float _dist[num_points];
+
+    // sample at or before the last distance looked up
+    uint8_t _cursor;
+};
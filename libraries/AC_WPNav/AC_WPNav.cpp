@@ -128,8 +128,9 @@ AC_WPNav::AC_WPNav(const AP_InertialNav& inav, const AP_AHRS& ahrs, AC_PosContro
     _track_speed(0.0f),
     _track_leash_length(0.0f),
     _slow_down_dist(0.0f),
+    _wp_exit_speed_cms(-1.0f),
     _spline_time(0.0f),
-    _spline_time_scale(0.0f),
+    _spline_dist(0.0f),
     _spline_vel_scaler(0.0f),
     _yaw(0.0f)
 {
@@ -522,6 +523,7 @@ bool AC_WPNav::set_wp_origin_and_destination(const Vector3f& origin, const Vecto
     _flags.fast_waypoint = false;   // default waypoint back to slow
     _flags.slowing_down = false;    // target is not slowing down yet
     _flags.segment_type = SEGMENT_STRAIGHT;
+    _wp_exit_speed_cms = -1.0f;     // no speed planned through the destination
     _flags.new_wp_destination = true;   // flag new waypoint so we can freeze the pos controller's feed forward and smooth the transition
 
     // initialise the limited speed to current speed along the track
@@ -655,6 +657,10 @@ bool AC_WPNav::advance_wp_target_along_track(float dt)
             if (_flags.slowing_down) {
                 _limited_speed_xy_cms = MIN(_limited_speed_xy_cms, get_slow_down_speed(dist_to_dest, _track_accel));
             }
+        } else if (_wp_exit_speed_cms >= 0.0f) {
+            // slow down only as far as the planned speed through the waypoint
+            float dist_to_dest = MAX(_track_length - _track_desired, 0.0f);
+            _limited_speed_xy_cms = MIN(_limited_speed_xy_cms, safe_sqrt(sq(_wp_exit_speed_cms) + dist_to_dest * 4.0f * _track_accel));
         }
 
         // if our current velocity is within the linear velocity range limit the intermediate point's velocity to be no more than the linear_velocity above or below our current velocity
@@ -1046,6 +1052,11 @@ void AC_WPNav::update_spline_solution(const Vector3f& origin, const Vector3f& de
     _hermite_spline_solution[1] = origin_vel;
     _hermite_spline_solution[2] = -origin*3.0f -origin_vel*2.0f + dest*3.0f - dest_vel;
     _hermite_spline_solution[3] = origin*2.0f + origin_vel -dest*2.0f + dest_vel;
+
+    // build the arc length table and start at the distance matching
+    // the current spline time, which may carry over from the last segment
+    _spline_table.update(_hermite_spline_solution);
+    _spline_dist = _spline_table.distance_at(_spline_time);
  }
 
 /// advance_spline_target_along_track - move target location along track from origin to destination
@@ -1112,12 +1123,6 @@ bool AC_WPNav::advance_spline_target_along_track(float dt)
         // constrain target velocity
         _spline_vel_scaler = constrain_float(_spline_vel_scaler, 0.0f, vel_limit);
 
-        // scale the spline_time by the velocity we've calculated vs the velocity that came out of the spline calculator
-        float target_vel_length = target_vel.length();
-        if (!is_zero(target_vel_length)) {
-            _spline_time_scale = _spline_vel_scaler/target_vel_length;
-        }
-
         // update target position
         target_pos.z += terr_offset;
         _pos_control.set_pos_target(target_pos);
@@ -1125,8 +1130,10 @@ bool AC_WPNav::advance_spline_target_along_track(float dt)
         // update the yaw
         _yaw = RadiansToCentiDegrees(atan2f(target_vel.y,target_vel.x));
 
-        // advance spline time to next step
-        _spline_time += _spline_time_scale*dt;
+        // advance along the track at the velocity we've calculated and
+        // look up the matching spline time
+        _spline_dist += _spline_vel_scaler*dt;
+        _spline_time = _spline_table.time_at(_spline_dist);
 
         // we will reach the next waypoint in the next step so set reached_destination flag
         // To-Do: is this one step too early?
@@ -1241,6 +1248,62 @@ void AC_WPNav::calc_slow_down_distance(float speed_cms, float accel_cmss)
     _slow_down_dist = speed_cms * speed_cms / (4.0f*accel_cmss);
 }
 
+/// set_wp_lookahead - plan the speed at which to pass through a fast waypoint from the waypoints that follow it
+///     each corner is limited to the speed at which it can be turned within the waypoint radius, and each
+///     waypoint to the speed from which the next one can still be reached at its own limit.  This runs once
+///     per waypoint, the fast loop only applies the result
+void AC_WPNav::set_wp_lookahead(const Location_Class *next, uint8_t count, bool stop_at_end)
+{
+    // points[0] is the origin, points[1] the destination and the rest follow it
+    Vector3f points[WPNAV_LOOKAHEAD_POINTS+2];
+    points[0] = _origin;
+    points[1] = _destination;
+    uint8_t num_points = 2;
+    for (uint8_t i=0; i<count && i<WPNAV_LOOKAHEAD_POINTS; i++) {
+        Vector3f vec;
+        bool terrain_alt;
+        if (!get_vector_NEU(next[i], vec, terrain_alt) || terrain_alt != _terrain_alt) {
+            // cannot plan past a point in a different altitude frame so assume we stop there
+            stop_at_end = true;
+            break;
+        }
+        points[num_points++] = vec;
+    }
+
+    // speed at the last point, then work backwards to the destination
+    float speed = stop_at_end ? 0.0f : _wp_speed_cms.get();
+    for (uint8_t i=num_points-2; i>=1; i--) {
+        const Vector3f leg_out = points[i+1] - points[i];
+        // fastest speed at point i from which point i+1 can be reached at its planned speed
+        speed = safe_sqrt(sq(speed) + leg_out.length() * 4.0f * _wp_accel_cms);
+        speed = MIN(speed, get_corner_speed(points[i] - points[i-1], leg_out));
+    }
+    _wp_exit_speed_cms = MIN(speed, _wp_speed_cms.get());
+}
+
+/// get_corner_speed - returns the highest speed at which the corner between two legs can be turned while staying within the waypoint radius
+///     the turn is modelled as an arc tangent to both legs whose closest point to the corner is the waypoint radius away
+float AC_WPNav::get_corner_speed(const Vector3f &leg_in, const Vector3f &leg_out) const
+{
+    const float len_in = leg_in.length();
+    const float len_out = leg_out.length();
+    if (is_zero(len_in) || is_zero(len_out)) {
+        return 0.0f;
+    }
+    // sine of half the angle between the legs, 1 when flying straight on and 0 when reversing
+    const float cos_turn = constrain_float((leg_in * leg_out) / (len_in * len_out), -1.0f, 1.0f);
+    const float sin_half = safe_sqrt((1.0f - cos_turn) * 0.5f);
+    if (sin_half >= 1.0f) {
+        return 0.0f;
+    }
+    const float sin_half_interior = safe_sqrt(1.0f - sq(sin_half));
+    if (sin_half_interior >= 1.0f) {
+        return _wp_speed_cms;
+    }
+    const float radius = _wp_radius_cm * sin_half_interior / (1.0f - sin_half_interior);
+    return MIN(safe_sqrt(_wp_accel_cms * radius), _wp_speed_cms.get());
+}
+
 /// get_slow_down_speed - returns target speed of target point based on distance from the destination (in cm)
 float AC_WPNav::get_slow_down_speed(float dist_from_dest_cm, float accel_cmss)
 {
@@ -9,6 +9,7 @@
 #include <AC_AttitudeControl/AC_AttitudeControl.h> // Attitude control library
 #include <AP_Terrain/AP_Terrain.h>
 #include <AC_Avoidance/AC_Avoid.h>                 // Stop at fence library
+#include "AC_SplineTable.h"                         // spline arc length table
 
 // loiter maximum velocities and accelerations
 #define WPNAV_ACCELERATION              100.0f      // defines the default velocity vs distant curve.  maximum acceleration in cm/s/s that position controller asks for from acceleration controller
@@ -34,6 +35,8 @@
 
 #define WPNAV_WP_FAST_OVERSHOOT_MAX     200.0f      // 2m overshoot is allowed during fast waypoints to allow for smooth transitions to next waypoint
 
+#define WPNAV_LOOKAHEAD_POINTS               4      // maximum number of waypoints after the destination used to plan the speed through fast waypoints
+
 #define WPNAV_LOITER_UPDATE_TIME        0.020f      // 50hz update rate for loiter
 
 #define WPNAV_LOITER_ACTIVE_TIMEOUT_MS     200      // loiter controller is considered active if it has been called within the past 200ms (0.2 seconds)
@@ -176,6 +179,12 @@ public:
     /// set_fast_waypoint - set to true to ignore the waypoint radius and consider the waypoint 'reached' the moment the intermediate point reaches it
     void set_fast_waypoint(bool fast) { _flags.fast_waypoint = fast; }
 
+    /// set_wp_lookahead - plan the speed at which to pass through a fast waypoint from the waypoints that follow it
+    ///     next should hold up to WPNAV_LOOKAHEAD_POINTS waypoints after the destination, in order
+    ///     stop_at_end should be true if the vehicle stops at the last of them (i.e. the mission ends or it has a delay)
+    ///     relies on set_wp_destination or set_wp_origin_and_destination having been called first
+    void set_wp_lookahead(const Location_Class *next, uint8_t count, bool stop_at_end);
+
     /// update_wpnav - run the wp controller - should be called at 100hz or higher
     bool update_wpnav();
 
@@ -284,6 +293,9 @@ protected:
     /// get_slow_down_speed - returns target speed of target point based on distance from the destination (in cm)
     float get_slow_down_speed(float dist_from_dest_cm, float accel_cmss);
 
+    /// get_corner_speed - returns the highest speed at which the corner between two legs can be turned while staying within the waypoint radius
+    float get_corner_speed(const Vector3f &leg_in, const Vector3f &leg_out) const;
+
     /// initialise and check for ekf position reset and adjust loiter or brake target position
     void init_ekf_position_reset();
     void check_for_ekf_position_reset();
@@ -348,10 +360,12 @@ protected:
     float       _track_speed;           // speed in cm/s along track
     float       _track_leash_length;    // leash length along track
     float       _slow_down_dist;        // vehicle should begin to slow down once it is within this distance from the destination
+    float       _wp_exit_speed_cms;     // planned speed in cm/s through a fast waypoint, negative if not planned
 
     // spline variables
     float       _spline_time;           // current spline time between origin and destination
-    float       _spline_time_scale;     // current spline time between origin and destination
+    float       _spline_dist;           // distance travelled along the spline segment in cm
+    AC_SplineTable _spline_table;       // arc length table for the spline segment
     Vector3f    _spline_origin_vel;     // the target velocity vector at the origin of the spline segment
     Vector3f    _spline_destination_vel;// the target velocity vector at the destination point of the spline segment
     Vector3f    _hermite_spline_solution[4]; // array describing spline path between origin and destination
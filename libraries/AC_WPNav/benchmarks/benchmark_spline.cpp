@@ -0,0 +1,95 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AC_WPNav/AC_SplineTable.h>
+
+/*
+  compare stepping a target along a spline segment by retuning the
+  spline time from the speed at each step, as AC_WPNav used to, with
+  looking the spline time up in the arc length table
+ */
+
+#define BM_SPLINE_DT 0.0025f
+#define BM_SPLINE_SPEED 500.0f
+
+// a 100m segment bending through 90 degrees, in cm
+static void spline_solution(Vector3f solution[4])
+{
+    const Vector3f origin(0, 0, 1000);
+    const Vector3f dest(10000, 10000, 1500);
+    const Vector3f origin_vel(14000, 0, 0);
+    const Vector3f dest_vel(0, 14000, 0);
+    solution[0] = origin;
+    solution[1] = origin_vel;
+    solution[2] = -origin*3.0f -origin_vel*2.0f + dest*3.0f - dest_vel;
+    solution[3] = origin*2.0f + origin_vel -dest*2.0f + dest_vel;
+}
+
+static void spline_pos_vel(const Vector3f solution[4], float t, Vector3f &pos, Vector3f &vel)
+{
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    pos = solution[0] + solution[1] * t + solution[2] * t2 + solution[3] * t3;
+    vel = solution[1] + solution[2] * 2.0f * t + solution[3] * 3.0f * t2;
+}
+
+static void BM_SplineTimeScale(benchmark::State& state)
+{
+    Vector3f solution[4];
+    spline_solution(solution);
+    float t = 0.0f;
+    float time_scale = 0.0f;
+
+    while (state.KeepRunning()) {
+        Vector3f pos, vel;
+        spline_pos_vel(solution, t, pos, vel);
+        const float vel_length = vel.length();
+        if (!is_zero(vel_length)) {
+            time_scale = BM_SPLINE_SPEED / vel_length;
+        }
+        t += time_scale * BM_SPLINE_DT;
+        if (t >= 1.0f) {
+            t = 0.0f;
+        }
+        gbenchmark_escape(&pos);
+    }
+}
+
+static void BM_SplineTable(benchmark::State& state)
+{
+    Vector3f solution[4];
+    spline_solution(solution);
+    AC_SplineTable table;
+    table.update(solution);
+    float dist = 0.0f;
+
+    while (state.KeepRunning()) {
+        Vector3f pos, vel;
+        const float t = table.time_at(dist);
+        spline_pos_vel(solution, t, pos, vel);
+        dist += BM_SPLINE_SPEED * BM_SPLINE_DT;
+        if (t >= 1.0f) {
+            dist = 0.0f;
+        }
+        gbenchmark_escape(&pos);
+    }
+}
+
+// cost of building the table, paid once per segment
+static void BM_SplineTableUpdate(benchmark::State& state)
+{
+    Vector3f solution[4];
+    spline_solution(solution);
+    AC_SplineTable table;
+
+    while (state.KeepRunning()) {
+        table.update(solution);
+        gbenchmark_escape(&table);
+    }
+}
+
+BENCHMARK(BM_SplineTimeScale);
+BENCHMARK(BM_SplineTable);
+BENCHMARK(BM_SplineTableUpdate);
+
+BENCHMARK_MAIN()
@@ -21,6 +21,7 @@
 */
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Alloc.h>
 #include "AP_ADSB.h"
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <stdio.h>  // for sprintf
@@ -122,6 +123,7 @@ void AP_ADSB::init(void)
     // in_state
     in_state.vehicle_count = 0;
     if (in_state.vehicle_list == nullptr) {
+        AP_Alloc::Tag alloc_tag("ADSB");
         if (in_state.list_size_param != constrain_int16(in_state.list_size_param, 1, ADSB_VEHICLE_LIST_SIZE_MAX)) {
             in_state.list_size_param.set_and_notify(ADSB_VEHICLE_LIST_SIZE_DEFAULT);
             in_state.list_size_param.save();
@@ -129,11 +131,21 @@ void AP_ADSB::init(void)
         in_state.list_size = in_state.list_size_param;
         in_state.vehicle_list = new adsb_vehicle_t[in_state.list_size];
 
-        if (in_state.vehicle_list == nullptr) {
+        uint16_t index_size = 2;
+        while (index_size < 2 * in_state.list_size) {
+            index_size *= 2;
+        }
+        in_state.index_mask = index_size - 1;
+        in_state.vehicle_index = new uint8_t[index_size];
+
+        if (in_state.vehicle_list == nullptr || in_state.vehicle_index == nullptr) {
             // dynamic RAM allocation of _vehicle_list[] failed, disable gracefully
             hal.console->printf("Unable to initialize ADS-B vehicle list\n");
+            deinit();
             _enabled.set_and_notify(0);
+            return;
         }
+        memset(in_state.vehicle_index, 0, index_size);
     }
 
     furthest_vehicle_distance = 0;
@@ -153,6 +165,10 @@ void AP_ADSB::deinit(void)
         delete [] in_state.vehicle_list;
         in_state.vehicle_list = nullptr;
     }
+    if (in_state.vehicle_index != nullptr) {
+        delete [] in_state.vehicle_index;
+        in_state.vehicle_index = nullptr;
+    }
 }
 
 /*
@@ -163,6 +179,8 @@ void AP_ADSB::update(void)
     // update _my_loc
     if (!_ahrs.get_position(_my_loc)) {
         _my_loc.zero();
+    } else {
+        _projector.set_origin(_my_loc);
     }
 
     if (!_enabled) {
@@ -258,7 +276,8 @@ void AP_ADSB::determine_furthest_aircraft(void)
     uint16_t max_distance_index = 0;
 
     for (uint16_t index = 0; index < in_state.vehicle_count; index++) {
-        float distance = _my_loc.get_distance(get_location(in_state.vehicle_list[index]));
+        const adsb_vehicle_t &vehicle = in_state.vehicle_list[index];
+        float distance = _projector.project(vehicle.info.lat, vehicle.info.lon).length();
         if (max_distance < distance || index == 0) {
             max_distance = distance;
             max_distance_index = index;
@@ -295,7 +314,9 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
             furthest_vehicle_distance = 0;
             furthest_vehicle_index = 0;
         }
+        index_remove(index);
         if (index != (in_state.vehicle_count-1)) {
+            index_moved(in_state.vehicle_count-1, index);
             in_state.vehicle_list[index] = in_state.vehicle_list[in_state.vehicle_count-1];
         }
         // TODO: is memset needed? When we decrement the index we essentially forget about it
@@ -311,7 +332,10 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
  */
 bool AP_ADSB::find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const
 {
-    for (uint16_t i = 0; i < in_state.vehicle_count; i++) {
+    for (uint8_t slot = index_home(vehicle.info.ICAO_address);
+         in_state.vehicle_index[slot] != 0;
+         slot = (slot + 1) & in_state.index_mask) {
+        const uint16_t i = in_state.vehicle_index[slot] - 1;
         if (in_state.vehicle_list[i].info.ICAO_address == vehicle.info.ICAO_address) {
             *index = i;
             return true;
@@ -320,6 +344,65 @@ bool AP_ADSB::find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const
     return false;
 }
 
+/*
+ * Add the vehicle at index in _vehicle_list to the hash
+ */
+void AP_ADSB::index_add(const uint16_t index)
+{
+    uint8_t slot = index_home(in_state.vehicle_list[index].info.ICAO_address);
+    while (in_state.vehicle_index[slot] != 0) {
+        slot = (slot + 1) & in_state.index_mask;
+    }
+    in_state.vehicle_index[slot] = index + 1;
+}
+
+/*
+ * Remove the vehicle at index in _vehicle_list from the hash. Entries
+ * further along the probe sequence are shifted back so that lookups
+ * never stop early at the freed slot
+ */
+void AP_ADSB::index_remove(const uint16_t index)
+{
+    uint8_t slot = index_home(in_state.vehicle_list[index].info.ICAO_address);
+    while (in_state.vehicle_index[slot] != index + 1) {
+        if (in_state.vehicle_index[slot] == 0) {
+            // not in the hash
+            return;
+        }
+        slot = (slot + 1) & in_state.index_mask;
+    }
+
+    uint8_t hole = slot;
+    in_state.vehicle_index[hole] = 0;
+    for (slot = (slot + 1) & in_state.index_mask;
+         in_state.vehicle_index[slot] != 0;
+         slot = (slot + 1) & in_state.index_mask) {
+        const uint8_t home = index_home(in_state.vehicle_list[in_state.vehicle_index[slot] - 1].info.ICAO_address);
+        // an entry may fill the hole unless its home lies after the hole
+        if (((slot - home) & in_state.index_mask) >= ((slot - hole) & in_state.index_mask)) {
+            in_state.vehicle_index[hole] = in_state.vehicle_index[slot];
+            in_state.vehicle_index[slot] = 0;
+            hole = slot;
+        }
+    }
+}
+
+/*
+ * Point the hash entry of the vehicle at from in _vehicle_list to to,
+ * before the vehicle is copied there
+ */
+void AP_ADSB::index_moved(const uint16_t from, const uint16_t to)
+{
+    for (uint8_t slot = index_home(in_state.vehicle_list[from].info.ICAO_address);
+         in_state.vehicle_index[slot] != 0;
+         slot = (slot + 1) & in_state.index_mask) {
+        if (in_state.vehicle_index[slot] == from + 1) {
+            in_state.vehicle_index[slot] = to + 1;
+            return;
+        }
+    }
+}
+
 /*
  * Update the vehicle list. If the vehicle is already in the
  * list then it will update it, otherwise it will be added.
@@ -336,7 +419,7 @@ void AP_ADSB::handle_vehicle(const mavlink_message_t* packet)
     mavlink_msg_adsb_vehicle_decode(packet, &vehicle.info);
     Location_Class vehicle_loc = Location_Class(AP_ADSB::get_location(vehicle));
     bool my_loc_is_zero = _my_loc.is_zero();
-    float my_loc_distance_to_vehicle = _my_loc.get_distance(vehicle_loc);
+    float my_loc_distance_to_vehicle = _projector.get_distance(vehicle_loc);
     bool out_of_range = in_state.list_radius > 0 && !my_loc_is_zero && my_loc_distance_to_vehicle > in_state.list_radius;
     bool is_tracked_in_list = find_index(vehicle, &index);
     uint32_t now = AP_HAL::millis();
@@ -414,7 +497,17 @@ void AP_ADSB::handle_vehicle(const mavlink_message_t* packet)
 void AP_ADSB::set_vehicle(const uint16_t index, const adsb_vehicle_t &vehicle)
 {
     if (index < in_state.list_size) {
+        const bool in_list = index < in_state.vehicle_count;
+        if (in_list && in_state.vehicle_list[index].info.ICAO_address == vehicle.info.ICAO_address) {
+            // same vehicle, the hash is unchanged
+            in_state.vehicle_list[index] = vehicle;
+            return;
+        }
+        if (in_list) {
+            index_remove(index);
+        }
         in_state.vehicle_list[index] = vehicle;
+        index_add(index);
     }
 }
 
@@ -88,6 +88,14 @@ private:
     // return index of given vehicle if ICAO_ADDRESS matches. return -1 if no match
     bool find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const;
 
+    // maintain the ICAO address hash over vehicle_list
+    uint8_t index_home(uint32_t ICAO_address) const {
+        return ((ICAO_address * 2654435761U) >> 16) & in_state.index_mask;
+    }
+    void index_add(const uint16_t index);
+    void index_remove(const uint16_t index);
+    void index_moved(const uint16_t from, const uint16_t to);
+
     // remove a vehicle from the list
     void delete_vehicle(const uint16_t index);
 
@@ -117,6 +125,8 @@ private:
 
     Location_Class  _my_loc;
 
+    // projects vehicle locations around _my_loc
+    Location_Projector _projector;
 
     // ADSB-IN state. Maintains list of external vehicles
     struct {
@@ -125,6 +135,11 @@ private:
         uint16_t    list_size = 1; // start with tiny list, then change to param-defined size. This ensures it doesn't fail on start
         adsb_vehicle_t *vehicle_list = nullptr;
         uint16_t    vehicle_count;
+
+        // open addressed hash of ICAO address to vehicle_list index + 1,
+        // zero for an empty slot. Sized to keep it at most half full
+        uint8_t     *vehicle_index = nullptr;
+        uint8_t     index_mask;
         AP_Int32    list_radius;
 
         // streamrate stuff
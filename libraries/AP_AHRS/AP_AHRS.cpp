@@ -120,6 +120,14 @@ const AP_Param::GroupInfo AP_AHRS::var_info[] = {
     // @Values: 0:Disabled,1:Enabled,2:Enable EKF2
     // @User: Advanced
     AP_GROUPINFO("EKF_TYPE",  14, AP_AHRS, _ekf_type, 2),
+
+    // @Param: DCM_DIV
+    // @DisplayName: DCM rate divisor while the EKF is healthy
+    // @Description: While the EKF is in use and healthy the backup DCM attitude estimate is only updated on one in this many main loops, with the gyro data of the skipped loops integrated on the next update. DCM is always updated every loop when it is in use or a fall back to it may be needed. 1 updates DCM every loop
+    // @Range: 1 10
+    // @Increment: 1
+    // @User: Advanced
+    AP_GROUPINFO("DCM_DIV",  15, AP_AHRS, _dcm_div, 1),
 #endif
 
     AP_GROUPEND
@@ -204,9 +212,14 @@ Vector2f AP_AHRS::groundspeed_vector(void)
         // Tau = cross-over time constant (nominal 2 seconds)
         // More lag on GPS requires Tau to be bigger, less lag allows it to be smaller
         // To-Do - set Tau as a function of GPS lag.
-        const float alpha = 1.0f - beta;
+        // beta is scaled by the time since the last step so the time
+        // constant stays 0.1/beta however often this is called
+        const uint32_t now_ms = AP_HAL::millis();
+        const float step_beta = constrain_float(beta * (now_ms - _gnd_vel_filter_ms) * 0.01f, 0.0f, 1.0f);
+        _gnd_vel_filter_ms = now_ms;
+        const float alpha = 1.0f - step_beta;
         // Run LP filters
-        _lp = gndVelGPS * beta  + _lp * alpha;
+        _lp = gndVelGPS * step_beta  + _lp * alpha;
         // Run HP filters
         _hp = (gndVelADS - _lastGndVelADS) + _hp * alpha;
         // Save the current ADS ground vector for the next time step
@@ -225,6 +238,24 @@ Vector2f AP_AHRS::groundspeed_vector(void)
     return Vector2f(0.0f, 0.0f);
 }
 
+// return the navigation values for this update, working them out if
+// this is the first call since the update
+const struct AP_AHRS::nav_context &AP_AHRS::get_nav_context(void)
+{
+    if (!_nav_context_valid) {
+        _nav_context.have_velocity_ned = get_velocity_NED(_nav_context.velocity_ned);
+        _nav_context.groundspeed_vector = groundspeed_vector();
+        _nav_context.groundspeed = _nav_context.groundspeed_vector.length();
+        _nav_context.EAS2TAS = get_EAS2TAS();
+        _nav_context.have_location = get_position(_nav_context.location);
+        _nav_context.have_relative_position_ned = get_relative_position_NED(_nav_context.relative_position_ned);
+        _nav_context.have_relative_position_ne = get_relative_position_NE(_nav_context.relative_position_ne);
+        _nav_context.have_relative_position_d = get_relative_position_D(_nav_context.relative_position_d);
+        _nav_context_valid = true;
+    }
+    return _nav_context;
+}
+
 // update_trig - recalculates _cos_roll, _cos_pitch, etc based on latest attitude
 //      should be called after _dcm_matrix is updated
 void AP_AHRS::update_trig(void)
@@ -61,6 +61,8 @@ public:
         _ins(ins),
         _baro(baro),
         _gps(gps),
+        _gnd_vel_filter_ms(0),
+        _nav_context_valid(false),
         _cos_roll(1.0f),
         _cos_pitch(1.0f),
         _cos_yaw(1.0f),
@@ -193,8 +195,9 @@ public:
         return get_gyro() * get_rotation_body_to_ned().c;
     }
 
-    // Methods
-    virtual void update(void) = 0;
+    // Methods. skip_ins_update is for callers that have already
+    // called update() on the INS for this sample
+    virtual void update(bool skip_ins_update=false) = 0;
 
     // report any reason for why the backend is refusing to initialise
     virtual const char *prearm_failure_reason(void) const {
@@ -222,6 +225,14 @@ public:
     // return the current estimate of the gyro drift
     virtual const Vector3f &get_gyro_drift(void) const = 0;
 
+    // return the newest gyro sample corrected with the last drift
+    // estimate. Unlike get_gyro() this doesn't wait for update(), and it
+    // follows the raw sample rate of the INS when called between INS
+    // updates, such as from a rate thread
+    Vector3f get_gyro_latest(void) const {
+        return _ins.get_gyro_latest(get_primary_gyro_index()) + get_gyro_drift();
+    }
+
     // reset the current gyro drift estimate
     //  should be called if gyro offsets are recalculated
     virtual void reset_gyro_drift(void) = 0;
@@ -284,6 +295,27 @@ public:
     // return a ground vector estimate in meters/second, in North/East order
     virtual Vector2f groundspeed_vector(void);
 
+    // navigation values used by the vehicle's navigation and
+    // speed/height controllers, worked out on first use after each
+    // update() so the controllers share them rather than each asking
+    // the estimator again
+    struct nav_context {
+        Vector3f velocity_ned;          // m/s, only valid if have_velocity_ned
+        bool have_velocity_ned;
+        Vector2f groundspeed_vector;    // m/s, North/East
+        float groundspeed;              // m/s
+        float EAS2TAS;
+        struct Location location;       // only valid if have_location
+        bool have_location;
+        Vector3f relative_position_ned; // m from the origin, only valid if have_relative_position_ned
+        bool have_relative_position_ned;
+        Vector2f relative_position_ne;  // m from the origin, only valid if have_relative_position_ne
+        bool have_relative_position_ne;
+        float relative_position_d;      // m from the origin, only valid if have_relative_position_d
+        bool have_relative_position_d;
+    };
+    const struct nav_context &get_nav_context(void);
+
     // return a ground velocity in meters/second, North/East/Down
     // order. This will only be accurate if have_inertial_nav() is
     // true
@@ -482,6 +514,7 @@ protected:
     AP_Int8 _gps_minsats;
     AP_Int8 _gps_delay;
     AP_Int8 _ekf_type;
+    AP_Int8 _dcm_div;
 
     // flags structure
     struct ahrs_flags {
@@ -498,6 +531,10 @@ protected:
     // update roll_sensor, pitch_sensor and yaw_sensor
     void update_cd_values(void);
 
+    // called by update() so the next get_nav_context() works the
+    // values out again
+    void invalidate_nav_context(void) { _nav_context_valid = false; }
+
     // pointer to compass object, if available
     Compass         * _compass;
 
@@ -537,6 +574,11 @@ protected:
     Vector2f _lp; // ground vector low-pass filter
     Vector2f _hp; // ground vector high-pass filter
     Vector2f _lastGndVelADS; // previous HPF input
+    uint32_t _gnd_vel_filter_ms; // time of the last filter step
+
+    // values returned by get_nav_context()
+    struct nav_context _nav_context;
+    bool _nav_context_valid;
 
     // reference position for NED positions
     struct Location _home;
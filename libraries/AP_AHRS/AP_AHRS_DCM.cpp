@@ -47,19 +47,25 @@ AP_AHRS_DCM::reset_gyro_drift(void)
 
 // run a full DCM update round
 void
-AP_AHRS_DCM::update(void)
+AP_AHRS_DCM::update(bool skip_ins_update)
 {
     float delta_t;
 
+    // the navigation values are about to go stale
+    invalidate_nav_context();
+
     if (_last_startup_ms == 0) {
         _last_startup_ms = AP_HAL::millis();
     }
 
-    // tell the IMU to grab some data
-    _ins.update();
+    if (!skip_ins_update) {
+        // tell the IMU to grab some data
+        _ins.update();
+    }
 
-    // ask the IMU how much time this sensor reading represents
-    delta_t = _ins.get_delta_time();
+    // ask the IMU how much time this sensor reading represents,
+    // including any loops we skipped
+    delta_t = _ins.get_delta_time() + _skipped_dt;
 
     // if the update call took more than 0.2 seconds then discard it,
     // otherwise we may move too far. This happens when arming motors
@@ -67,6 +73,8 @@ AP_AHRS_DCM::update(void)
     if (delta_t > 0.2f) {
         memset(&_ra_sum[0], 0, sizeof(_ra_sum));
         _ra_deltat = 0;
+        _skipped_delta_angle.zero();
+        _skipped_dt = 0;
         return;
     }
 
@@ -89,23 +97,46 @@ AP_AHRS_DCM::update(void)
     update_trig();
 }
 
-// update the DCM matrix using only the gyros
+/*
+  keep the gyro data of a loop that the attitude is not updated on, for
+  when DCM is only a backup to another estimator. The next update()
+  integrates the skipped delta angles with its own, and runs the drift
+  correction over the whole interval
+ */
 void
-AP_AHRS_DCM::matrix_update(float _G_Dt)
+AP_AHRS_DCM::update_skipped(bool skip_ins_update)
 {
-    // note that we do not include the P terms in _omega. This is
-    // because the spin_rate is calculated from _omega.length(),
-    // and including the P terms would give positive feedback into
-    // the _P_gain() calculation, which can lead to a very large P
-    // value
-    _omega.zero();
+    // the navigation values are about to go stale
+    invalidate_nav_context();
+
+    if (!skip_ins_update) {
+        // tell the IMU to grab some data
+        _ins.update();
+    }
+
+    const float delta_t = _ins.get_delta_time();
+    if (delta_t > 0.2f) {
+        // discarded by update() anyway
+        _skipped_delta_angle.zero();
+        _skipped_dt = 0;
+        return;
+    }
 
-    // average across first two healthy gyros. This reduces noise on
-    // systems with more than one gyro. We don't use the 3rd gyro
-    // unless another is unhealthy as 3rd gyro on PH2 has a lot more
-    // noise
-    uint8_t healthy_count = 0;
     Vector3f delta_angle;
+    get_delta_angle(delta_angle);
+    _skipped_delta_angle += delta_angle;
+    _skipped_dt += delta_t;
+}
+
+// average the delta angle across first two healthy gyros. This
+// reduces noise on systems with more than one gyro. We don't use the
+// 3rd gyro unless another is unhealthy as 3rd gyro on PH2 has a lot
+// more noise
+void
+AP_AHRS_DCM::get_delta_angle(Vector3f &delta_angle) const
+{
+    uint8_t healthy_count = 0;
+    delta_angle.zero();
     for (uint8_t i=0; i<_ins.get_gyro_count(); i++) {
         if (_ins.get_gyro_health(i) && healthy_count < 2) {
             Vector3f dangle;
@@ -118,6 +149,27 @@ AP_AHRS_DCM::matrix_update(float _G_Dt)
     if (healthy_count > 1) {
         delta_angle /= healthy_count;
     }
+}
+
+// update the DCM matrix using only the gyros
+void
+AP_AHRS_DCM::matrix_update(float _G_Dt)
+{
+    // note that we do not include the P terms in _omega. This is
+    // because the spin_rate is calculated from _omega.length(),
+    // and including the P terms would give positive feedback into
+    // the _P_gain() calculation, which can lead to a very large P
+    // value
+    _omega.zero();
+
+    Vector3f delta_angle;
+    get_delta_angle(delta_angle);
+
+    // catch up on the loops skipped by update_skipped()
+    delta_angle += _skipped_delta_angle;
+    _skipped_delta_angle.zero();
+    _skipped_dt = 0;
+
     if (_G_Dt > 0) {
         _omega = delta_angle / _G_Dt;
         _omega += _omega_I;
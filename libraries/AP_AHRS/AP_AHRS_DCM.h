@@ -28,6 +28,7 @@ public:
     AP_AHRS_DCM(AP_InertialSensor &ins, AP_Baro &baro, AP_GPS &gps) :
         AP_AHRS(ins, baro, gps),
         _omega_I_sum_time(0.0f),
+        _skipped_dt(0.0f),
         _renorm_val_sum(0.0f),
         _renorm_val_count(0),
         _error_rp(1.0f),
@@ -78,9 +79,13 @@ public:
     void reset_gyro_drift(void);
 
     // Methods
-    void            update(void);
+    void            update(bool skip_ins_update=false);
     void            reset(bool recover_eulers = false);
 
+    // gather the IMU data of a loop that the attitude is not updated
+    // on. The gyro delta angles are integrated on the next update()
+    void            update_skipped(bool skip_ins_update=false);
+
     // reset the current attitude, used on new IMU calibration
     void reset_attitude(const float &roll, const float &pitch, const float &yaw);
 
@@ -121,6 +126,7 @@ private:
 
     // Methods
     void            matrix_update(float _G_Dt);
+    void            get_delta_angle(Vector3f &delta_angle) const;
     void            normalize(void);
     void            check_matrix(void);
     bool            renorm(Vector3f const &a, Vector3f &result);
@@ -144,6 +150,10 @@ private:
     float _omega_I_sum_time;
     Vector3f _omega;                            // Corrected Gyro_Vector data
 
+    // gyro delta angle and time of loops skipped by update_skipped()
+    Vector3f _skipped_delta_angle;
+    float _skipped_dt;
+
     // variables to cope with delaying the GA sum to match GPS lag
     Vector3f ra_delayed(uint8_t instance, const Vector3f &ra);
     Vector3f _ra_delay_buffer[INS_MAX_INSTANCES];
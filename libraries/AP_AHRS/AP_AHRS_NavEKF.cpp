@@ -34,7 +34,8 @@ AP_AHRS_NavEKF::AP_AHRS_NavEKF(AP_InertialSensor &ins, AP_Baro &baro, AP_GPS &gp
     AP_AHRS_DCM(ins, baro, gps),
     EKF1(_EKF1),
     EKF2(_EKF2),
-    _ekf_flags(flags)
+    _ekf_flags(flags),
+    _dcm_skip_count(0)
 {
     _dcm_matrix.identity();
 }
@@ -76,14 +77,14 @@ void AP_AHRS_NavEKF::reset_gyro_drift(void)
     EKF2.resetGyroBias();
 }
 
-void AP_AHRS_NavEKF::update(void)
+void AP_AHRS_NavEKF::update(bool skip_ins_update)
 {
 #if !AP_AHRS_WITH_EKF1
     if (_ekf_type == 1) {
         _ekf_type.set(2);
     }
 #endif
-    update_DCM();
+    update_DCM(skip_ins_update);
 #if AP_AHRS_WITH_EKF1
     update_EKF1();
 #endif
@@ -92,12 +93,60 @@ void AP_AHRS_NavEKF::update(void)
     update_SITL();
 #endif
 
+    // the DCM update invalidated the navigation values, but anything
+    // looked at while the EKFs were updating would be stale now
+    invalidate_nav_context();
+
     // call AHRS_update hook if any
     AP_Module::call_hook_AHRS_update(*this);
 }
 
-void AP_AHRS_NavEKF::update_DCM(void)
+/*
+  DCM is only a backup while an EKF is in use, so it can be updated at
+  a lower rate provided it is brought up to full rate before it may be
+  needed
+ */
+bool AP_AHRS_NavEKF::dcm_full_rate_needed(void) const
 {
+    if (_dcm_div <= 1) {
+        return true;
+    }
+
+    switch (active_EKF_type()) {
+    case EKF_TYPE_NONE:
+        return true;
+
+#if AP_AHRS_WITH_EKF1
+    case EKF_TYPE1: {
+        uint16_t ekf_faults;
+        EKF1.getFilterFaults(ekf_faults);
+        return !EKF1.healthy() || ekf_faults != 0;
+    }
+#endif
+
+    case EKF_TYPE2: {
+        uint16_t ekf2_faults;
+        EKF2.getFilterFaults(-1,ekf2_faults);
+        return !EKF2.healthy() || ekf2_faults != 0;
+    }
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    case EKF_TYPE_SITL:
+        break;
+#endif
+    }
+
+    return false;
+}
+
+void AP_AHRS_NavEKF::update_DCM(bool skip_ins_update)
+{
+    if (!dcm_full_rate_needed() && ++_dcm_skip_count < _dcm_div) {
+        AP_AHRS_DCM::update_skipped(skip_ins_update);
+        return;
+    }
+    _dcm_skip_count = 0;
+
     // we need to restore the old DCM attitude values as these are
     // used internally in DCM to calculate error values for gyro drift
     // correction
@@ -106,7 +155,7 @@ void AP_AHRS_NavEKF::update_DCM(void)
     yaw = _dcm_attitude.z;
     update_cd_values();
 
-    AP_AHRS_DCM::update();
+    AP_AHRS_DCM::update(skip_ins_update);
 
     // keep DCM attitude available for get_secondary_attitude()
     _dcm_attitude(roll, pitch, yaw);
@@ -115,6 +164,12 @@ void AP_AHRS_NavEKF::update_DCM(void)
 void AP_AHRS_NavEKF::update_EKF1(void)
 {
 #if AP_AHRS_WITH_EKF1
+    if (ekf1_started && !EKF1.enabled() && !hal.util->get_soft_armed()) {
+        // EK_ENABLE has been cleared, give the memory of the core
+        // back until it is set again
+        EKF1.release_core();
+        ekf1_started = false;
+    }
     if (!ekf1_started) {
         // wait 1 second for DCM to output a valid tilt error estimate
         if (start_time_ms == 0) {
@@ -190,6 +245,12 @@ void AP_AHRS_NavEKF::update_EKF1(void)
 
 void AP_AHRS_NavEKF::update_EKF2(void)
 {
+    if (ekf2_started && !EKF2.enabled() && !hal.util->get_soft_armed() &&
+        EKF2.release_cores()) {
+        // EK2_ENABLE has been cleared, the memory of the cores is
+        // free until it is set again
+        ekf2_started = false;
+    }
     if (!ekf2_started) {
         // wait 1 second for DCM to output a valid tilt error estimate
         if (start_time_ms == 0) {
@@ -72,7 +72,7 @@ public:
     //  should be called if gyro offsets are recalculated
     void reset_gyro_drift(void);
 
-    void            update(void);
+    void            update(bool skip_ins_update=false);
     void            reset(bool recover_eulers = false);
 
     // reset the current attitude, used on new IMU calibration
@@ -273,7 +273,12 @@ private:
     Flags _ekf_flags;
 
     uint8_t ekf_type(void) const;
-    void update_DCM(void);
+    void update_DCM(bool skip_ins_update);
+
+    // true if DCM should be updated every loop as it is in use, or
+    // a fall back to it may be needed soon
+    bool dcm_full_rate_needed(void) const;
+    uint8_t _dcm_skip_count;
     void update_EKF1(void);
     void update_EKF2(void);
 
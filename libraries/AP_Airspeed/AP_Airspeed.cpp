@@ -279,7 +279,14 @@ void AP_Airspeed::read(void)
     _last_pressure          = airspeed_pressure;
     _raw_airspeed           = sqrtf(airspeed_pressure * _ratio);
     _airspeed               = 0.7f * _airspeed  +  0.3f * _raw_airspeed;
-    _last_update_ms         = AP_HAL::millis();
+
+    // timestamp with when the pressure was measured if the backend
+    // knows, so the EKF fuses it at the right time
+    uint32_t sample_ms = 0;
+    if (!_hil_set && _pin == AP_AIRSPEED_I2C_PIN) {
+        sample_ms = digital.get_sample_time_ms();
+    }
+    _last_update_ms         = sample_ms != 0 ? sample_ms : AP_HAL::millis();
 }
 
 void AP_Airspeed::setHIL(float airspeed, float diff_pressure, float temperature)
@@ -31,4 +31,9 @@ public:
 
     // return the current temperature in degrees C, if available
     virtual bool get_temperature(float &temperature) = 0;
+
+    // return the time in ms the last pressure returned by
+    // get_differential_pressure() was measured, or 0 if the backend
+    // samples when it is asked
+    virtual uint32_t get_sample_time_ms(void) const { return 0; }
 };
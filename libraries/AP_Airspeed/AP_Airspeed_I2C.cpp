@@ -23,6 +23,7 @@
 #include <AP_HAL/I2CDevice.h>
 #include <AP_Math/AP_Math.h>
 #include <stdio.h>
+#include <string.h>
 #include <utility>
 
 extern const AP_HAL::HAL &hal;
@@ -35,6 +36,12 @@ extern const AP_HAL::HAL &hal;
 #define MS4525D0_I2C_BUS 1
 #endif
 
+// the sensor needs up to 10ms to complete a conversion
+#define MS4525D0_MEASURE_PERIOD_US 10000
+
+// limit on the number of samples averaged between reads
+#define MS4525D0_MAX_ACCUM 100
+
 AP_Airspeed_I2C::AP_Airspeed_I2C(const AP_Float &psi_range) :
     _psi_range(psi_range)
 {
@@ -45,6 +52,12 @@ bool AP_Airspeed_I2C::init()
 {
     _dev = hal.i2c_mgr->get_device(MS4525D0_I2C_BUS, MS4525D0_I2C_ADDR);
 
+    _sem = hal.util->new_semaphore();
+    if (!_sem) {
+        return false;
+    }
+    memset(&_accum, 0, sizeof(_accum));
+
     // take i2c bus sempahore
     if (!_dev || !_dev->get_semaphore()->take(200)) {
         return false;
@@ -56,7 +69,8 @@ bool AP_Airspeed_I2C::init()
     _dev->get_semaphore()->give();
 
     if (_last_sample_time_ms != 0) {
-        hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Airspeed_I2C::_timer, void));
+        _dev->register_periodic_callback(MS4525D0_MEASURE_PERIOD_US,
+                                         FUNCTOR_BIND_MEMBER(&AP_Airspeed_I2C::_timer, bool));
         return true;
     }
     return false;
@@ -107,38 +121,61 @@ void AP_Airspeed_I2C::_collect()
      */
     float diff_press_PSI = -((dp_raw - 0.1f*16383) * (P_max-P_min)/(0.8f*16383) + P_min);
 
-    _pressure = diff_press_PSI * PSI_to_Pa;
-    _temperature = ((200.0f * dT_raw) / 2047) - 50;
+    const float press = diff_press_PSI * PSI_to_Pa;
+    const float temp = ((200.0f * dT_raw) / 2047) - 50;
+    const uint32_t now = AP_HAL::millis();
+
+    if (_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        if (_accum.count == 0) {
+            _accum.first_ms = now;
+        } else if (_accum.count == MS4525D0_MAX_ACCUM) {
+            // nobody is reading, keep the average of the most recent half
+            _accum.pressure_sum *= 0.5f;
+            _accum.temperature_sum *= 0.5f;
+            _accum.count /= 2;
+            _accum.first_ms += (now - _accum.first_ms) / 2;
+        }
+        _accum.pressure_sum += press;
+        _accum.temperature_sum += temp;
+        _accum.count++;
+        _accum.last_ms = now;
+        _sem->give();
+    }
 
-    _last_sample_time_ms = AP_HAL::millis();
+    _last_sample_time_ms = now;
 }
 
-// 1kHz timer
-void AP_Airspeed_I2C::_timer()
+// called from the bus thread with the bus semaphore taken
+bool AP_Airspeed_I2C::_timer()
 {
-    if (!_dev->get_semaphore()->take_nonblocking()) {
-        return;
-    }
-
-    if (_measurement_started_ms == 0) {
-        _measure();
-        _dev->get_semaphore()->give();
-        return;
-    }
-    if ((AP_HAL::millis() - _measurement_started_ms) > 10) {
+    if (_measurement_started_ms != 0) {
         _collect();
-        // start a new measurement
-        _measure();
     }
-    _dev->get_semaphore()->give();
+    // start the next conversion straight away so the sensor is
+    // sampled at its own rate
+    _measure();
+    return true;
 }
 
 // return the current differential_pressure in Pascal
 bool AP_Airspeed_I2C::get_differential_pressure(float &pressure)
 {
-    if ((AP_HAL::millis() - _last_sample_time_ms) > 100) {
+    if (!_sem || (AP_HAL::millis() - _last_sample_time_ms) > 100) {
         return false;
     }
+
+    // average everything sampled since the last call, keeping the
+    // previous value if the sensor hasn't produced a new sample yet
+    if (_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        if (_accum.count != 0) {
+            _pressure = _accum.pressure_sum / _accum.count;
+            _temperature = _accum.temperature_sum / _accum.count;
+            _sample_time_ms = _accum.first_ms + (_accum.last_ms - _accum.first_ms) / 2;
+            memset(&_accum, 0, sizeof(_accum));
+        }
+        _sem->give();
+    }
+
     pressure = _pressure;
     return true;
 }
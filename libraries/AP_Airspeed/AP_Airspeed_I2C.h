@@ -42,14 +42,32 @@ public:
     // return the current temperature in degrees C, if available
     bool get_temperature(float &temperature);
 
+    // return the time in ms the last returned pressure was measured
+    uint32_t get_sample_time_ms(void) const { return _sample_time_ms; }
+
 private:
     void _measure();
     void _collect();
-    void _timer();
+    bool _timer();
     float _temperature;
     float _pressure;
+    uint32_t _sample_time_ms;
     uint32_t _last_sample_time_ms;
     uint32_t _measurement_started_ms;
+
+    /*
+     * samples taken by the bus thread since the last
+     * get_differential_pressure(), protected by _sem
+     */
+    struct {
+        float pressure_sum;
+        float temperature_sum;
+        uint16_t count;
+        uint32_t first_ms;
+        uint32_t last_ms;
+    } _accum;
+    AP_HAL::Semaphore *_sem;
+
     AP_HAL::OwnPtr<AP_HAL::I2CDevice> _dev;
     const AP_Float &_psi_range;
 };
@@ -14,6 +14,7 @@
  */
 
 #include "AP_Arming.h"
+#include <AP_Common/AP_Alloc.h>
 #include <AP_Notify/AP_Notify.h>
 #include <GCS_MAVLink/GCS.h>
 
@@ -27,6 +28,9 @@
 #define AP_ARMING_BOARD_VOLTAGE_MAX     5.8f
 #define AP_ARMING_ACCEL_ERROR_THRESHOLD 0.75f
 
+// longest a passing check with unchanged inputs is trusted for
+#define AP_ARMING_CACHE_MAX_AGE_MS      5000
+
 extern const AP_HAL::HAL& hal;
 
 const AP_Param::GroupInfo AP_Arming::var_info[] = {
@@ -88,6 +92,7 @@ AP_Arming::AP_Arming(const AP_AHRS &ahrs_ref, const AP_Baro &baro, Compass &comp
     AP_Param::setup_object_defaults(this, var_info);
     memset(last_accel_pass_ms, 0, sizeof(last_accel_pass_ms));
     memset(last_gyro_pass_ms, 0, sizeof(last_gyro_pass_ms));
+    memset(check_states, 0, sizeof(check_states));
 }
 
 bool AP_Arming::is_armed()
@@ -105,6 +110,101 @@ void AP_Arming::set_enabled_checks(uint16_t ap)
     checks_to_perform = ap;
 }
 
+// fold a value into an input signature
+static void add_input(uint32_t &inputs, uint32_t value)
+{
+    inputs = (inputs ^ value) * 16777619U;
+}
+
+bool AP_Arming::check_inputs(enum ArmingCheckId id, uint32_t &inputs)
+{
+    inputs = 2166136261U;
+    add_input(inputs, checks_to_perform);
+
+    switch (id) {
+    case CHECK_ID_INS: {
+        // the sensor consistency checks depend on live data, which
+        // the maximum cache age covers
+        const AP_InertialSensor &ins = ahrs.get_ins();
+        add_input(inputs, ins.get_gyro_health_all());
+        add_input(inputs, ins.gyro_calibrated_ok_all());
+        add_input(inputs, ins.get_accel_health_all());
+        add_input(inputs, ins.accel_calibrated_ok_all());
+        add_input(inputs, ins.accel_cal_requires_reboot());
+        add_input(inputs, ins.get_gyro_count());
+        add_input(inputs, ins.get_accel_count());
+        add_input(inputs, ahrs.healthy());
+        return true;
+    }
+
+    case CHECK_ID_COMPASS:
+        add_input(inputs, _compass.use_for_yaw());
+        add_input(inputs, _compass.healthy());
+        add_input(inputs, _compass.learn_offsets_enabled());
+        add_input(inputs, _compass.configured());
+        add_input(inputs, _compass.is_calibrating());
+        add_input(inputs, _compass.compass_cal_requires_reboot());
+        add_input(inputs, _compass.get_count());
+        return true;
+
+    default:
+        // cheap checks, run every time
+        return false;
+    }
+}
+
+bool AP_Arming::run_check(enum ArmingCheckId id, check_fn fn, bool report)
+{
+    struct check_state &state = check_states[id];
+    const uint32_t now_ms = AP_HAL::millis();
+
+    uint32_t inputs = 0;
+    const bool cacheable = check_inputs(id, inputs);
+    if (!report && cacheable && state.valid && state.passed &&
+        state.inputs == inputs &&
+        now_ms - state.last_run_ms < AP_ARMING_CACHE_MAX_AGE_MS) {
+        state.cache_hits++;
+        return true;
+    }
+
+    const uint32_t start_us = AP_HAL::micros();
+    const bool passed = (this->*fn)(report);
+    const uint32_t elapsed_us = AP_HAL::micros() - start_us;
+
+    state.inputs = inputs;
+    state.last_run_ms = now_ms;
+    state.runs++;
+    state.last_time_us = MIN(elapsed_us, UINT16_MAX);
+    state.max_time_us = MAX(state.max_time_us, state.last_time_us);
+    state.valid = cacheable;
+    state.passed = passed;
+
+    return passed;
+}
+
+void AP_Arming::log_check_timing() const
+{
+    DataFlash_Class *dataflash = DataFlash_Class::instance();
+    if (dataflash == nullptr) {
+        return;
+    }
+    const uint64_t now = AP_HAL::micros64();
+    for (uint8_t i=0; i<CHECK_ID_COUNT; i++) {
+        const struct check_state &state = check_states[i];
+        if (state.runs == 0) {
+            continue;
+        }
+        dataflash->Log_Write("ARMC", "TimeUS,Id,Pass,Runs,Hits,Last,Max", "QBBIIHH",
+                             now,
+                             i,
+                             (uint8_t)state.passed,
+                             state.runs,
+                             state.cache_hits,
+                             state.last_time_us,
+                             state.max_time_us);
+    }
+}
+
 bool AP_Arming::barometer_checks(bool report)
 {
     if ((checks_to_perform & ARMING_CHECK_ALL) ||
@@ -447,15 +547,15 @@ bool AP_Arming::pre_arm_checks(bool report)
         return true;
     }
 
-    ret &= hardware_safety_check(report);
-    ret &= barometer_checks(report);
-    ret &= ins_checks(report);
-    ret &= compass_checks(report);
-    ret &= gps_checks(report);
-    ret &= battery_checks(report);
-    ret &= logging_checks(report);
-    ret &= manual_transmitter_checks(report);
-    ret &= board_voltage_checks(report);
+    ret &= run_check(CHECK_ID_SAFETY, &AP_Arming::hardware_safety_check, report);
+    ret &= run_check(CHECK_ID_BARO, &AP_Arming::barometer_checks, report);
+    ret &= run_check(CHECK_ID_INS, &AP_Arming::ins_checks, report);
+    ret &= run_check(CHECK_ID_COMPASS, &AP_Arming::compass_checks, report);
+    ret &= run_check(CHECK_ID_GPS, &AP_Arming::gps_checks, report);
+    ret &= run_check(CHECK_ID_BATTERY, &AP_Arming::battery_checks, report);
+    ret &= run_check(CHECK_ID_LOGGING, &AP_Arming::logging_checks, report);
+    ret &= run_check(CHECK_ID_RC, &AP_Arming::manual_transmitter_checks, report);
+    ret &= run_check(CHECK_ID_VOLTAGE, &AP_Arming::board_voltage_checks, report);
 
     return ret;
 }
@@ -472,10 +572,14 @@ bool AP_Arming::arm(uint8_t method)
         armed = true;
         arming_method = NONE;
         GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_INFO, "Throttle armed");
+        AP_Alloc::freeze();
         return true;
     }
 
-    if (pre_arm_checks(true)) {
+    const bool checks_passed = pre_arm_checks(true);
+    log_check_timing();
+
+    if (checks_passed) {
         armed = true;
         arming_method = method;
 
@@ -489,6 +593,11 @@ bool AP_Arming::arm(uint8_t method)
         arming_method = NONE;
     }
 
+    if (armed) {
+        // first arming marks the end of boot time allocation
+        AP_Alloc::freeze();
+    }
+
     return armed;
 }
 
@@ -61,6 +61,9 @@ public:
 
     void set_logging_available(bool set) { logging_available = set; }
 
+    // log the run count and timing of each pre-arm check
+    void log_check_timing() const;
+
     static const struct AP_Param::GroupInfo        var_info[];
 
 protected:
@@ -85,6 +88,45 @@ protected:
     uint32_t                last_accel_pass_ms[INS_MAX_INSTANCES];
     uint32_t                last_gyro_pass_ms[INS_MAX_INSTANCES];
 
+    /*
+      each pre-arm check goes through run_check(). A check that
+      declares its inputs in check_inputs() keeps its last passing
+      result until those inputs change or the result is older than
+      AP_ARMING_CACHE_MAX_AGE_MS. Failing checks and reported checks
+      are always re-run
+     */
+    enum ArmingCheckId {
+        CHECK_ID_SAFETY = 0,
+        CHECK_ID_BARO,
+        CHECK_ID_INS,
+        CHECK_ID_COMPASS,
+        CHECK_ID_GPS,
+        CHECK_ID_BATTERY,
+        CHECK_ID_LOGGING,
+        CHECK_ID_RC,
+        CHECK_ID_VOLTAGE,
+        CHECK_ID_AIRSPEED,
+        CHECK_ID_COUNT
+    };
+
+    struct check_state {
+        uint32_t inputs;        // signature of the inputs for the cached result
+        uint32_t last_run_ms;
+        uint32_t runs;
+        uint32_t cache_hits;
+        uint16_t last_time_us;
+        uint16_t max_time_us;
+        bool valid:1;
+        bool passed:1;
+    } check_states[CHECK_ID_COUNT];
+
+    typedef bool (AP_Arming::*check_fn)(bool report);
+    bool run_check(enum ArmingCheckId id, check_fn fn, bool report);
+
+    // fill in a signature of the state a check depends on, returning
+    // false if the check has to be run on every call
+    virtual bool check_inputs(enum ArmingCheckId id, uint32_t &inputs);
+
     void set_enabled_checks(uint16_t);
 
     bool barometer_checks(bool report);
@@ -4,6 +4,7 @@ extern const AP_HAL::HAL& hal;
 
 #include <limits>
 #include <GCS_MAVLink/GCS.h>
+#include <AP_Common/AP_Alloc.h>
 
 #define AVOIDANCE_DEBUGGING 0
 
@@ -126,6 +127,7 @@ void AP_Avoidance::init(void)
 {
     debug("ADSB initialisation: %d obstacles", _obstacles_max.get());
     if (_obstacles == NULL) {
+        AP_Alloc::Tag alloc_tag("Avoidance");
         _obstacles = new AP_Avoidance::Obstacle[_obstacles_max];
 
         if (_obstacles == NULL) {
@@ -259,15 +261,13 @@ void AP_Avoidance::get_adsb_samples()
     }
 }
 
-float closest_approach_xy(const Location &my_loc,
+float closest_approach_xy(const Vector2f &delta_pos_ne,
                           const Vector3f &my_vel,
-                          const Location &obstacle_loc,
                           const Vector3f &obstacle_vel,
                           const uint8_t time_horizon)
 {
 
     Vector2f delta_vel_ne = Vector2f(obstacle_vel[0] - my_vel[0], obstacle_vel[1] - my_vel[1]);
-    Vector2f delta_pos_ne = location_diff(obstacle_loc, my_loc);
 
     Vector2f line_segment_ne = delta_vel_ne * time_horizon;
 
@@ -312,57 +312,97 @@ float closest_approach_z(const Location &my_loc,
     return ret/100.0f;
 }
 
-void AP_Avoidance::update_threat_level(const Location &my_loc,
-                                       const Vector3f &my_vel,
-                                       AP_Avoidance::Obstacle &obstacle)
+// closest horizontal approach within the time horizon for a batch of
+// obstacles, as closest_approach_xy() works it out for one
+static void closest_approach_xy_batch(const float pos_n[], const float pos_e[],
+                                      const float vel_n[], const float vel_e[],
+                                      const float age_s[], const uint8_t time_horizon,
+                                      float closest[], const uint8_t count)
 {
-
-    Location &obstacle_loc = obstacle._location;
-    Vector3f &obstacle_vel = obstacle._velocity;
-
-    obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
-
-    const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
-    float closest_xy = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, _fail_time_horizon + obstacle_age/1000);
-    if (closest_xy < _fail_distance_xy) {
-        obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_HIGH;
-    } else {
-        closest_xy = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, _warn_time_horizon + obstacle_age/1000);
-        if (closest_xy < _warn_distance_xy) {
-            obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
+    for (uint8_t k=0; k<count; k++) {
+        const float t_horizon = time_horizon + age_s[k];
+        const float seg_n = vel_n[k] * t_horizon;
+        const float seg_e = vel_e[k] * t_horizon;
+        const float l2 = seg_n*seg_n + seg_e*seg_e;
+        float t = 0.0f;
+        if (l2 >= FLT_EPSILON) {
+            t = constrain_float((pos_n[k]*seg_n + pos_e[k]*seg_e) / l2, 0.0f, 1.0f);
         }
+        const float d_n = seg_n * t - pos_n[k];
+        const float d_e = seg_e * t - pos_e[k];
+        closest[k] = sqrtf(d_n*d_n + d_e*d_e);
     }
+}
 
-    // check for vertical separation; our threat level is the minimum
-    // of vertical and horizontal threat levels
-    float closest_z = closest_approach_z(my_loc, my_vel, obstacle_loc, obstacle_vel, _warn_time_horizon + obstacle_age/1000);
-    if (obstacle.threat_level != MAV_COLLISION_THREAT_LEVEL_NONE) {
-        if (closest_z > _warn_distance_z) {
-            obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+void AP_Avoidance::update_threat_levels(const Location &my_loc,
+                                        const Vector3f &my_vel,
+                                        AP_Avoidance::Obstacle *obstacles,
+                                        const uint8_t count,
+                                        const uint32_t now)
+{
+    // our position and the obstacle's velocity relative to each
+    // obstacle, laid out so the closest approaches are straight loops
+    float pos_n[AP_AVOIDANCE_THREAT_BATCH];
+    float pos_e[AP_AVOIDANCE_THREAT_BATCH];
+    float vel_n[AP_AVOIDANCE_THREAT_BATCH];
+    float vel_e[AP_AVOIDANCE_THREAT_BATCH];
+    float age_s[AP_AVOIDANCE_THREAT_BATCH];
+    float closest_fail[AP_AVOIDANCE_THREAT_BATCH];
+    float closest_warn[AP_AVOIDANCE_THREAT_BATCH];
+
+    for (uint8_t k=0; k<count; k++) {
+        const AP_Avoidance::Obstacle &obstacle = obstacles[k];
+        const Vector2f ne = _projector.project(obstacle._location);
+        pos_n[k] = -ne.x;
+        pos_e[k] = -ne.y;
+        vel_n[k] = obstacle._velocity.x - my_vel.x;
+        vel_e[k] = obstacle._velocity.y - my_vel.y;
+        // the horizon is extended by whole seconds of obstacle age
+        age_s[k] = (now - obstacle.timestamp_ms) / 1000;
+    }
+
+    closest_approach_xy_batch(pos_n, pos_e, vel_n, vel_e, age_s, _fail_time_horizon, closest_fail, count);
+    closest_approach_xy_batch(pos_n, pos_e, vel_n, vel_e, age_s, _warn_time_horizon, closest_warn, count);
+
+    for (uint8_t k=0; k<count; k++) {
+        AP_Avoidance::Obstacle &obstacle = obstacles[k];
+        const uint8_t age = age_s[k];
+
+        float closest_xy;
+        if (closest_fail[k] < _fail_distance_xy) {
+            obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_HIGH;
+            closest_xy = closest_fail[k];
         } else {
-            closest_z = closest_approach_z(my_loc, my_vel, obstacle_loc, obstacle_vel, _fail_time_horizon + obstacle_age/1000);
-            if (closest_z > _fail_distance_z) {
-                obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
-            }
+            closest_xy = closest_warn[k];
+            obstacle.threat_level = (closest_xy < _warn_distance_xy) ? MAV_COLLISION_THREAT_LEVEL_LOW : MAV_COLLISION_THREAT_LEVEL_NONE;
         }
-    }
 
-    // If we haven't heard from a vehicle then assume it is no threat
-    if (obstacle_age > MAX_OBSTACLE_AGE_MS) {
-        obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
-    }
+        // check for vertical separation; our threat level is the minimum
+        // of vertical and horizontal threat levels
+        float closest_z = closest_approach_z(my_loc, my_vel, obstacle._location, obstacle._velocity, _warn_time_horizon + age);
+        if (obstacle.threat_level != MAV_COLLISION_THREAT_LEVEL_NONE) {
+            if (closest_z > _warn_distance_z) {
+                obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+            } else {
+                closest_z = closest_approach_z(my_loc, my_vel, obstacle._location, obstacle._velocity, _fail_time_horizon + age);
+                if (closest_z > _fail_distance_z) {
+                    obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
+                }
+            }
+        }
 
-    // could optimise this to not calculate a lot of this if threat
-    // level is none - but only *once the GCS has been informed*!
-    obstacle.closest_approach_xy = closest_xy;
-    obstacle.closest_approach_z = closest_z;
-    float current_distance = get_distance(my_loc, obstacle_loc);
-    obstacle.distance_to_closest_approach = current_distance - closest_xy;
-    Vector2f net_velocity_ne = Vector2f(my_vel[0] - obstacle_vel[0], my_vel[1] - obstacle_vel[1]);
-    obstacle.time_to_closest_approach = 0.0f;
-    if (!is_zero(obstacle.distance_to_closest_approach) &&
-        ! is_zero(net_velocity_ne.length())) {
-        obstacle.time_to_closest_approach = obstacle.distance_to_closest_approach / net_velocity_ne.length();
+        // could optimise this to not calculate a lot of this if threat
+        // level is none - but only *once the GCS has been informed*!
+        obstacle.closest_approach_xy = closest_xy;
+        obstacle.closest_approach_z = closest_z;
+        const float current_distance = norm(pos_n[k], pos_e[k]);
+        obstacle.distance_to_closest_approach = current_distance - closest_xy;
+        const float net_speed = norm(vel_n[k], vel_e[k]);
+        obstacle.time_to_closest_approach = 0.0f;
+        if (!is_zero(obstacle.distance_to_closest_approach) &&
+            !is_zero(net_speed)) {
+            obstacle.time_to_closest_approach = obstacle.distance_to_closest_approach / net_speed;
+        }
     }
 }
 
@@ -435,30 +475,35 @@ void AP_Avoidance::check_for_threats()
         return;
     }
 
+    // one cosine for all obstacles rather than one per distance
+    _projector.set_origin(my_loc);
+
+    const uint32_t now = AP_HAL::millis();
+
+    // drop obstacles we haven't heard from, keeping the rest together
+    // so the screening below only walks live ones
+    uint8_t i = 0;
+    while (i < _obstacle_count) {
+        if (now - _obstacles[i].timestamp_ms > MAX_OBSTACLE_AGE_MS) {
+            debug("i=%d src_id=%d timestamp=%u dropped", i, _obstacles[i].src_id, _obstacles[i].timestamp_ms);
+            _obstacles[i] = _obstacles[--_obstacle_count];
+        } else {
+            i++;
+        }
+    }
+
     // we always check all obstacles to see if they are threats since it
     // is most likely our own position and/or velocity have changed
     // determine the current most-serious-threat
     _current_most_serious_threat = -1;
-    for (uint8_t i=0; i<_obstacle_count; i++) {
-
-        AP_Avoidance::Obstacle &obstacle = _obstacles[i];
-        const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
-        debug("i=%d src_id=%d timestamp=%u age=%d", i, obstacle.src_id, obstacle.timestamp_ms, obstacle_age);
-
-        update_threat_level(my_loc, my_vel, obstacle);
-        debug("   threat-level=%d", obstacle.threat_level);
-
-        // ignore any really old data:
-        if (obstacle_age > MAX_OBSTACLE_AGE_MS) {
-            // shrink list if this is the last entry:
-            if (i == _obstacle_count-1) {
-                _obstacle_count -= 1;
+    for (uint8_t first=0; first<_obstacle_count; first+=AP_AVOIDANCE_THREAT_BATCH) {
+        const uint8_t count = MIN(_obstacle_count - first, AP_AVOIDANCE_THREAT_BATCH);
+        update_threat_levels(my_loc, my_vel, &_obstacles[first], count, now);
+        for (i=first; i<first+count; i++) {
+            debug("i=%d src_id=%d threat-level=%d", i, _obstacles[i].src_id, _obstacles[i].threat_level);
+            if (obstacle_is_more_serious_threat(_obstacles[i])) {
+                _current_most_serious_threat = i;
             }
-            continue;
-        }
-
-        if (obstacle_is_more_serious_threat(obstacle)) {
-            _current_most_serious_threat = i;
         }
     }
     if (_current_most_serious_threat != -1) {
@@ -38,6 +38,8 @@
 
 #define AP_AVOIDANCE_ESCAPE_TIME_SEC                        2       // vehicle runs from thread for 2 seconds
 
+#define AP_AVOIDANCE_THREAT_BATCH                           16      // obstacles screened together by check_for_threats
+
 class AP_Avoidance {
 
 public:
@@ -161,9 +163,13 @@ private:
     uint32_t src_id_for_adsb_vehicle(AP_ADSB::adsb_vehicle_t vehicle) const;
 
     void check_for_threats();
-    void update_threat_level(const Location &my_loc,
-                             const Vector3f &my_vel,
-                             AP_Avoidance::Obstacle &obstacle);
+    // update the threat level of count obstacles, at most
+    // AP_AVOIDANCE_THREAT_BATCH. _projector must have its origin at my_loc
+    void update_threat_levels(const Location &my_loc,
+                              const Vector3f &my_vel,
+                              AP_Avoidance::Obstacle *obstacles,
+                              uint8_t count,
+                              uint32_t now);
 
     // calls into the AP_ADSB library to retrieve vehicle data
     void get_adsb_samples();
@@ -179,6 +185,9 @@ private:
     int8_t _current_most_serious_threat;
     MAV_COLLISION_ACTION _latest_action = MAV_COLLISION_ACTION_NONE;
 
+    // projects obstacle locations around our own location
+    Location_Projector _projector;
+
     // external references
     class AP_ADSB &_adsb;
 
@@ -200,9 +209,9 @@ private:
 
 float closest_distance_between_radial_and_point(const Vector2f &w,
                                                 const Vector2f &p);
-float closest_approach_xy(const Location &my_loc,
+// delta_pos_ne is our North/East position relative to the obstacle in meters
+float closest_approach_xy(const Vector2f &delta_pos_ne,
                           const Vector3f &my_vel,
-                          const Location &obstacle_loc,
                           const Vector3f &obstacle_vel,
                           uint8_t time_horizon);
 
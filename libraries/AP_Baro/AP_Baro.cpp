@@ -21,6 +21,7 @@
 
 #include <utility>
 
+#include <AP_Common/AP_Alloc.h>
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
@@ -196,7 +197,7 @@ float AP_Baro::get_altitude_difference(float base_pressure, float pressure) cons
 
     // This is an exact calculation that is within +-2.5m of the standard
     // atmosphere tables in the troposphere (up to 11,000 m amsl).
-    ret = 153.8462f * temp * (1.0f - expf(0.190259f * logf(scaling)));
+    ret = 153.8462f * temp * (1.0f - pressure_ratio_pow(scaling));
 
     return ret;
 }
@@ -280,6 +281,8 @@ float AP_Baro::get_calibration_temperature(uint8_t instance) const
  */
 void AP_Baro::init(void)
 {
+    AP_Alloc::Tag alloc_tag("Baro");
+
     if (_hil_mode) {
         drivers[0] = new AP_Baro_HIL(*this);
         _num_drivers = 1;
@@ -374,6 +377,20 @@ void AP_Baro::update(void)
         }
     }
 
+    // publish new readings
+    for (uint8_t i=0; i<_num_sensors; i++) {
+        if (sensors[i].last_update_ms == sensors[i].published_ms) {
+            continue;
+        }
+        sensors[i].published_ms = sensors[i].last_update_ms;
+        const baro_sample sample = {
+            sensors[i].pressure,
+            sensors[i].temperature,
+            sensors[i].altitude
+        };
+        sensors[i].topic.publish(sample, sensors[i].last_update_ms * 1000ULL);
+    }
+
     // ensure the climb rate filter is updated
     if (healthy()) {
         _climb_rate_filter.update(get_altitude(), get_last_update());
@@ -393,16 +410,6 @@ void AP_Baro::update(void)
     }
 }
 
-/*
-  call accumulate on all drivers
- */
-void AP_Baro::accumulate(void)
-{
-    for (uint8_t i=0; i<_num_drivers; i++) {
-        drivers[i]->accumulate();
-    }
-}
-
 
 /* register a new sensor, claiming a sensor slot. If we are out of
    slots it will panic
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/SensorTopic.h>
 #include <AP_Param/AP_Param.h>
 #include <Filter/Filter.h>
 #include <Filter/DerivativeFilter.h>
@@ -44,10 +45,6 @@ public:
     float get_temperature(void) const { return get_temperature(_primary); }
     float get_temperature(uint8_t instance) const { return sensors[instance].temperature; }
 
-    // accumulate a reading on sensors. Some backends without their
-    // own thread or a timer may need this.
-    void accumulate(void);
-
     // calibrate the barometer. This must be called on startup if the
     // altitude/climb_rate/acceleration interfaces are ever used
     void calibrate(void);
@@ -61,6 +58,18 @@ public:
     float get_altitude(void) const { return get_altitude(_primary); }
     float get_altitude(uint8_t instance) const { return sensors[instance].altitude; }
 
+    // a reading along with the altitude calculated from it
+    struct baro_sample {
+        float pressure;
+        float temperature;
+        float altitude;
+    };
+
+    // readings of a sensor, published by update() as they arrive and
+    // stamped with the time the backend delivered them
+    const SensorTopic<baro_sample> &get_topic(void) const { return get_topic(_primary); }
+    const SensorTopic<baro_sample> &get_topic(uint8_t instance) const { return sensors[instance].topic; }
+
     // get altitude difference in meters relative given a base
     // pressure in Pascal
     float get_altitude_difference(float base_pressure, float pressure) const;
@@ -156,6 +165,8 @@ private:
         float altitude;                 // calculated altitude
         AP_Float ground_temperature;
         AP_Float ground_pressure;
+        uint32_t published_ms;          // last_update_ms of the last published reading
+        SensorTopic<baro_sample> topic;
     } sensors[BARO_MAX_INSTANCES];
 
     AP_Float                            _alt_offset;
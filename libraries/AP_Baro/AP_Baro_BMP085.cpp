@@ -74,18 +74,26 @@ AP_Baro_BMP085::AP_Baro_BMP085(AP_Baro &baro, AP_HAL::OwnPtr<AP_HAL::I2CDevice>
 
     _instance = _frontend.register_sensor();
 
+    _sem = hal.util->new_semaphore();
+    if (!_sem) {
+        AP_HAL::panic("BMP085: failed to create semaphore");
+    }
+
     // Send a command to read temperature
     _cmd_read_temp();
 
     _state = 0;
 
     sem->give();
+
+    hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Baro_BMP085::_timer, void));
 }
 
 /*
-  This is a state machine. Acumulate a new sensor reading.
+  This is a state machine. Acumulate a new sensor reading on the timer
+  thread whenever a conversion is done.
  */
-void AP_Baro_BMP085::accumulate(void)
+void AP_Baro_BMP085::_timer(void)
 {
     AP_HAL::Semaphore *sem = _dev->get_semaphore();
 
@@ -94,14 +102,15 @@ void AP_Baro_BMP085::accumulate(void)
     }
 
     // take i2c bus sempahore
-    if (!sem->take(1)) {
+    if (!sem->take_nonblocking()) {
         return;
     }
 
     if (_state == 0) {
         _read_temp();
-    } else if (_read_pressure()) {
+    } else if (_read_pressure() && _sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
         _calculate();
+        _sem->give();
     }
 
     _state++;
@@ -120,16 +129,19 @@ void AP_Baro_BMP085::accumulate(void)
  */
 void AP_Baro_BMP085::update(void)
 {
-    if (!_has_sample && _data_ready()) {
-        accumulate();
+    if (!_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
     }
     if (!_has_sample) {
+        _sem->give();
         return;
     }
 
     float temperature = 0.1f * _temp;
 
     float pressure = _pressure_filter.getf();
+    _sem->give();
+
     _copy_to_frontend(_instance, pressure, temperature);
 }
 
@@ -177,7 +189,11 @@ void AP_Baro_BMP085::_read_temp()
     _temp_sensor = buf[0];
     _temp_sensor = (_temp_sensor << 8) | buf[1];
 
+    if (!_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
     _raw_temp = _temp_sensor;
+    _sem->give();
 }
 
 // _calculate Temperature and Pressure in real units.
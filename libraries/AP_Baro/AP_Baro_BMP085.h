@@ -14,9 +14,11 @@ public:
 
     /* AP_Baro public interface: */
     void update();
-    void accumulate(void);
 
 private:
+    // sample the sensor, called from the timer thread
+    void _timer(void);
+
     void _cmd_read_pressure();
     void _cmd_read_temp();
     bool _read_pressure();
@@ -46,4 +48,8 @@ private:
     int32_t _raw_temp;
     int32_t _temp;
     AverageIntegralFilter<int32_t, int32_t, 10> _pressure_filter;
+
+    // protects the temperature (_raw_temp and _temp), _pressure_filter
+    // and _has_sample, shared by _timer() and update()
+    AP_HAL::Semaphore *_sem;
 };
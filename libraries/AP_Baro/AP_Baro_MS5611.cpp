@@ -149,16 +149,6 @@ uint16_t AP_Baro_MS56XX::_read_prom_word(uint8_t word)
     return (val[0] << 8) | val[1];
 }
 
-uint32_t AP_Baro_MS56XX::_read_adc()
-{
-    uint8_t val[3];
-
-    if (!_dev->transfer(&CMD_MS56XX_READ_ADC, 1, val, 3)) {
-        return 0;
-    }
-    return (val[0] << 16) | (val[1] << 8) | val[2];
-}
-
 bool AP_Baro_MS56XX::_read_prom(uint16_t prom[8])
 {
     /*
@@ -224,28 +214,38 @@ bool AP_Baro_MS56XX::_timer(void)
         return true;
     }
 
-    uint8_t next_cmd;
-    uint8_t next_state;
-    uint32_t adc_val = _read_adc();
-
-    /*
-     * If read fails, re-initiate a read command for current state or we are
-     * stuck
-     */
-    if (adc_val == 0) {
-        next_state = _state;
-    } else {
-        next_state = (_state + 1) % 5;
-    }
+    const uint8_t next_state = (_state + 1) % 5;
+    uint8_t next_cmd = next_state == 0 ? ADDR_CMD_CONVERT_TEMPERATURE
+                                       : ADDR_CMD_CONVERT_PRESSURE;
+    uint8_t val[3];
 
-    next_cmd = next_state == 0 ? ADDR_CMD_CONVERT_TEMPERATURE
+    /* read the result and start the next conversion in one go */
+    const AP_HAL::Device::Transfer transfers[] = {
+        { &CMD_MS56XX_READ_ADC, 1, val, sizeof(val) },
+        { &next_cmd, 1, nullptr, 0 },
+    };
+    if (!_dev->transfer_batch(transfers, ARRAY_SIZE(transfers))) {
+        /*
+         * The next conversion may not have started: re-initiate a read
+         * command for current state or we are stuck
+         */
+        next_cmd = _state == 0 ? ADDR_CMD_CONVERT_TEMPERATURE
                                : ADDR_CMD_CONVERT_PRESSURE;
-    _dev->transfer(&next_cmd, 1, nullptr, 0);
+        _dev->transfer(&next_cmd, 1, nullptr, 0);
+        _last_cmd_usec = AP_HAL::micros();
+        return true;
+    }
 
     _last_cmd_usec = AP_HAL::micros();
 
-    /* if we had a failed read we are all done */
+    const uint32_t adc_val = (val[0] << 16) | (val[1] << 8) | val[2];
+
+    /*
+     * the next conversion is already running, so a bad read only loses
+     * this sample
+     */
     if (adc_val == 0) {
+        _state = next_state;
         return true;
     }
 
@@ -27,7 +27,6 @@ protected:
     virtual bool _read_prom(uint16_t prom[8]);
 
     uint16_t _read_prom_word(uint8_t word);
-    uint32_t _read_adc();
 
     bool _timer();
 
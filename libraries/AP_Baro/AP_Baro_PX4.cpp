@@ -48,14 +48,25 @@ AP_Baro_PX4::AP_Baro_PX4(AP_Baro &baro) :
 void AP_Baro_PX4::update(void)
 {
     for (uint8_t i=0; i<_num_instances; i++) {
-        struct baro_report baro_report;
+        // take the queued reports in batches rather than with a
+        // read() per report
+        struct baro_report baro_report[PX4_BARO_READ_BATCH];
         struct px4_instance &instance = instances[i];
-        while (::read(instance.fd, &baro_report, sizeof(baro_report)) == sizeof(baro_report) &&
-               baro_report.timestamp != instance.last_timestamp) {
-            instance.pressure_sum += baro_report.pressure; // Pressure in mbar
-            instance.temperature_sum += baro_report.temperature; // degrees celcius
-            instance.sum_count++;
-            instance.last_timestamp = baro_report.timestamp;
+        bool more = true;
+        while (more) {
+            ssize_t ret = ::read(instance.fd, baro_report, sizeof(baro_report));
+            uint8_t n = ret > 0 ? ret / sizeof(baro_report[0]) : 0;
+            more = (n == PX4_BARO_READ_BATCH);
+            for (uint8_t r=0; r<n; r++) {
+                if (baro_report[r].timestamp == instance.last_timestamp) {
+                    more = false;
+                    break;
+                }
+                instance.pressure_sum += baro_report[r].pressure; // Pressure in mbar
+                instance.temperature_sum += baro_report[r].temperature; // degrees celcius
+                instance.sum_count++;
+                instance.last_timestamp = baro_report[r].timestamp;
+            }
         }
     }
 
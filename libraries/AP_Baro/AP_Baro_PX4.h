@@ -2,6 +2,9 @@
 
 #include "AP_Baro_Backend.h"
 
+// reports taken from the driver queue per read()
+#define PX4_BARO_READ_BATCH 10
+
 class AP_Baro_PX4 : public AP_Baro_Backend
 {
 public:
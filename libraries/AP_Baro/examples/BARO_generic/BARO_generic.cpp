@@ -11,7 +11,6 @@ const AP_HAL::HAL& hal = AP_HAL::get_HAL();
 static AP_Baro barometer;
 
 static uint32_t timer;
-static uint8_t counter;
 
 void setup()
 {
@@ -29,14 +28,9 @@ void setup()
 
 void loop()
 {
-    // run accumulate() at 50Hz and update() at 10Hz
-    if((AP_HAL::micros() - timer) > 20*1000UL) {
+    // run update() at 10Hz
+    if((AP_HAL::micros() - timer) > 100*1000UL) {
         timer = AP_HAL::micros();
-        barometer.accumulate();
-        if (counter++ < 5) {
-            return;
-        }
-        counter = 0;
         barometer.update();
         uint32_t read_time = AP_HAL::micros() - timer;
         float alt = barometer.get_altitude();
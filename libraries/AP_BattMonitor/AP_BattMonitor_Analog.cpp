@@ -8,7 +8,10 @@ extern const AP_HAL::HAL& hal;
 
 /// Constructor
 AP_BattMonitor_Analog::AP_BattMonitor_Analog(AP_BattMonitor &mon, uint8_t instance, AP_BattMonitor::BattMonitor_State &mon_state) :
-    AP_BattMonitor_Backend(mon, instance, mon_state)
+    AP_BattMonitor_Backend(mon, instance, mon_state),
+    _accum_sem(nullptr),
+    _accum{},
+    _last_sample_us(0)
 {
     _volt_pin_analog_source = hal.analogin->channel(mon._volt_pin[instance]);
     _curr_pin_analog_source = hal.analogin->channel(mon._curr_pin[instance]);
@@ -17,35 +20,87 @@ AP_BattMonitor_Analog::AP_BattMonitor_Analog(AP_BattMonitor &mon, uint8_t instan
     _state.healthy = true;
 }
 
-// read - read the voltage and current
 void
-AP_BattMonitor_Analog::read()
+AP_BattMonitor_Analog::init()
+{
+    _accum_sem = hal.util->new_semaphore();
+    if (_accum_sem == nullptr) {
+        hal.console->printf("BattMonitor: Unable to create semaphore\n");
+        return;
+    }
+    hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_BattMonitor_Analog::_sample, void));
+}
+
+/*
+  sample the voltage and current at AP_BATT_ANALOG_SAMPLE_HZ. Each
+  current reading is the average of the ADC samples taken since the
+  previous one, so multiplying it by the time since the previous
+  sample integrates the charge drawn without missing short spikes
+  between the 10Hz reads by the vehicle code
+ */
+void
+AP_BattMonitor_Analog::_sample()
 {
+    const uint32_t tnow = AP_HAL::micros();
+    const uint32_t dt = tnow - _last_sample_us;
+    if (_last_sample_us != 0 && dt < 1000000UL / AP_BATT_ANALOG_SAMPLE_HZ) {
+        return;
+    }
+
     // this copes with changing the pin at runtime
     _volt_pin_analog_source->set_pin(_mon._volt_pin[_state.instance]);
+    const float voltage = _volt_pin_analog_source->voltage_average() * _mon._volt_multiplier[_state.instance];
 
-    // get voltage
-    _state.voltage = _volt_pin_analog_source->voltage_average() * _mon._volt_multiplier[_state.instance];
+    float current = 0;
+    const bool has_current = _mon.has_current(_state.instance);
+    if (has_current) {
+        _curr_pin_analog_source->set_pin(_mon._curr_pin[_state.instance]);
+        current = (_curr_pin_analog_source->voltage_average()-_mon._curr_amp_offset[_state.instance])*_mon._curr_amp_per_volt[_state.instance];
+    }
 
-    // read current
-    if (_mon.has_current(_state.instance)) {
-        // calculate time since last current read
-        uint32_t tnow = AP_HAL::micros();
-        float dt = tnow - _state.last_time_micros;
+    if (!_accum_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+    _accum.volt_sum += voltage;
+    _accum.curr_sum += current;
+    _accum.count++;
+    if (has_current && _last_sample_us != 0 && dt < 2000000UL) {
+        // .0002778 is 1/3600 (conversion to hours)
+        _accum.mah += current * dt * 0.0000002778f;
+    }
+    _accum.last_sample_us = tnow;
+    _accum_sem->give();
 
-        // this copes with changing the pin at runtime
-        _curr_pin_analog_source->set_pin(_mon._curr_pin[_state.instance]);
+    _last_sample_us = tnow;
+}
 
-        // read current
-        _state.current_amps = (_curr_pin_analog_source->voltage_average()-_mon._curr_amp_offset[_state.instance])*_mon._curr_amp_per_volt[_state.instance];
+// read - publish the voltage and current sampled since the last call
+void
+AP_BattMonitor_Analog::read()
+{
+    if (_accum_sem == nullptr || !_accum_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+    if (_accum.count == 0) {
+        _accum_sem->give();
+        return;
+    }
+    const float voltage = _accum.volt_sum / _accum.count;
+    const float current = _accum.curr_sum / _accum.count;
+    const float mah = _accum.mah;
+    const uint32_t sample_us = _accum.last_sample_us;
+    _accum.volt_sum = 0;
+    _accum.curr_sum = 0;
+    _accum.mah = 0;
+    _accum.count = 0;
+    _accum_sem->give();
 
+    _state.voltage = voltage;
+    if (_mon.has_current(_state.instance)) {
+        _state.current_amps = current;
         // update total current drawn since startup
-        if (_state.last_time_micros != 0 && dt < 2000000.0f) {
-            // .0002778 is 1/3600 (conversion to hours)
-            _state.current_total_mah += _state.current_amps * dt * 0.0000002778f;
-        }
-
-        // record time
-        _state.last_time_micros = tnow;
+        _state.current_total_mah += mah;
+        // record time of the latest sample included
+        _state.last_time_micros = sample_us;
     }
 }
@@ -71,6 +71,9 @@
 // # define AP_BATT_CURR_AMP_PERVOLT_DEFAULT 27.32  // Amp/Volt for AttoPilot 50V/90A sensor
 // # define AP_BATT_CURR_AMP_PERVOLT_DEFAULT 13.66  // Amp/Volt for AttoPilot 13.6V/45A sensor
 
+// rate at which the IO thread samples and integrates the analog inputs
+#define AP_BATT_ANALOG_SAMPLE_HZ            100
+
 class AP_BattMonitor_Analog : public AP_BattMonitor_Backend
 {
 public:
@@ -78,11 +81,29 @@ public:
     /// Constructor
     AP_BattMonitor_Analog(AP_BattMonitor &mon, uint8_t instance, AP_BattMonitor::BattMonitor_State &mon_state);
 
-    /// Read the battery voltage and current.  Should be called at 10hz
+    /// start sampling in the IO thread
+    void init();
+
+    /// Publish the voltage, current and consumed capacity accumulated
+    /// since the last call.  Should be called at 10hz
     void read();
 
 protected:
 
+    // sample and integrate the inputs, called from the IO thread
+    void _sample();
+
     AP_HAL::AnalogSource *_volt_pin_analog_source;
     AP_HAL::AnalogSource *_curr_pin_analog_source;
+
+    // samples accumulated by the IO thread since the last read()
+    AP_HAL::Semaphore *_accum_sem;
+    struct {
+        float volt_sum;
+        float curr_sum;
+        float mah;                  // capacity consumed over the block
+        uint16_t count;
+        uint32_t last_sample_us;    // time of the latest sample
+    } _accum;
+    uint32_t _last_sample_us;       // time of the previous sample, IO thread only
 };
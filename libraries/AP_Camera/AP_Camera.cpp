@@ -101,6 +101,13 @@ extern const AP_HAL::HAL& hal;
   static trigger var for PX4 callback
  */
 volatile bool   AP_Camera::_camera_triggered;
+volatile uint32_t AP_Camera::_feedback_time_us;
+
+// a trigger is only scheduled if it falls before the next position
+// update, which is expected at most this far away
+#define CAMERA_SCHEDULE_MAX_MS  1000U
+// the shutter is not released this close to a scheduled trigger
+#define CAMERA_SCHEDULE_GUARD_US 25000
 
 /// Servo operated camera
 void
@@ -126,14 +133,10 @@ AP_Camera::relay_pic()
     _trigger_counter = constrain_int16(_trigger_duration*5,0,255);
 }
 
-/// single entry point to take pictures
-///  set send_mavlink_msg to true to send DO_DIGICAM_CONTROL message to all components
+/// activate the shutter
 void
-AP_Camera::trigger_pic(bool send_mavlink_msg)
+AP_Camera::shutter_on()
 {
-    setup_feedback_callback();
-
-    _image_index++;
     switch (_trigger_type)
     {
     case AP_CAMERA_TRIGGER_TYPE_SERVO:
@@ -143,6 +146,18 @@ AP_Camera::trigger_pic(bool send_mavlink_msg)
         relay_pic();                    // basic relay activation
         break;
     }
+}
+
+/// single entry point to take pictures
+///  set send_mavlink_msg to true to send DO_DIGICAM_CONTROL message to all components
+void
+AP_Camera::trigger_pic(bool send_mavlink_msg)
+{
+    setup_feedback_callback();
+
+    _image_index++;
+    _last_trigger_us = AP_HAL::micros();
+    shutter_on();
 
     if (send_mavlink_msg) {
         // create command long mavlink message
@@ -167,6 +182,13 @@ AP_Camera::trigger_pic_cleanup()
     if (_trigger_counter) {
         _trigger_counter--;
     } else {
+        // leave the shutter alone if the timer is about to fire it
+        const uint32_t trigger_at_us = _trigger_at_us;
+        if (trigger_at_us != 0 &&
+            (_triggered_us != 0 ||
+             (int32_t)(trigger_at_us - AP_HAL::micros()) < CAMERA_SCHEDULE_GUARD_US)) {
+            return;
+        }
         switch (_trigger_type) {
             case AP_CAMERA_TRIGGER_TYPE_SERVO:
                 RC_Channel_aux::set_radio(RC_Channel_aux::k_cam_trigger, _servo_off_pwm);
@@ -291,7 +313,18 @@ bool AP_Camera::update_location(const struct Location &loc, const AP_AHRS &ahrs)
         return false;
     }
 
-    if (get_distance(loc, _last_location) < _trigg_dist) {
+    uint32_t tnow = AP_HAL::millis();
+    _update_interval_ms = MIN(tnow - _last_update_ms, CAMERA_SCHEDULE_MAX_MS);
+    _last_update_ms = tnow;
+
+    if (_trigger_at_us != 0) {
+        // the timer will take this picture
+        return false;
+    }
+
+    const float distance = get_distance(loc, _last_location);
+    if (distance < _trigg_dist) {
+        schedule_trigger(distance, ahrs);
         return false;
     }
 
@@ -299,7 +332,6 @@ bool AP_Camera::update_location(const struct Location &loc, const AP_AHRS &ahrs)
         return false;
     }
 
-    uint32_t tnow = AP_HAL::millis();
     if (tnow - _last_photo_time < (unsigned) _min_interval) {
         return false;
     }  else {
@@ -309,6 +341,101 @@ bool AP_Camera::update_location(const struct Location &loc, const AP_AHRS &ahrs)
     }
 }
 
+/*
+  if the trigger distance will be crossed before the next position
+  update, time the picture for the crossing from the ground speed
+ */
+void AP_Camera::schedule_trigger(float distance, const AP_AHRS &ahrs)
+{
+    Vector3f vel;
+    if (!ahrs.get_velocity_NED(vel)) {
+        return;
+    }
+    const float speed = norm(vel.x, vel.y);
+    if (speed < 1.0f) {
+        return;
+    }
+    const uint32_t delay_ms = (_trigg_dist - distance) * 1000 / speed;
+    if (delay_ms >= _update_interval_ms) {
+        // the next update will be closer
+        return;
+    }
+    if (_max_roll > 0 && labs(ahrs.roll_sensor/100) > _max_roll) {
+        return;
+    }
+    if (AP_HAL::millis() + delay_ms - _last_photo_time < (unsigned) _min_interval) {
+        return;
+    }
+
+    if (!_trigger_timer_installed) {
+        hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Camera::trigger_timer, void));
+        _trigger_timer_installed = true;
+    }
+    setup_feedback_callback();
+
+    _triggered_us = 0;
+    // a zero time means nothing is scheduled
+    _trigger_at_us = MAX(AP_HAL::micros() + delay_ms * 1000, 1U);
+}
+
+/*
+  fire a scheduled trigger, called at 1kHz
+ */
+void AP_Camera::trigger_timer(void)
+{
+    const uint32_t trigger_at_us = _trigger_at_us;
+    if (trigger_at_us == 0 || _triggered_us != 0) {
+        return;
+    }
+    const uint32_t now = AP_HAL::micros();
+    if ((int32_t)(now - trigger_at_us) < 0) {
+        return;
+    }
+    shutter_on();
+    _triggered_us = MAX(now, 1U);
+}
+
+bool AP_Camera::check_scheduled_trigger(const AP_AHRS &ahrs, const Location &current_loc)
+{
+    const uint32_t triggered_us = _triggered_us;
+    if (triggered_us == 0) {
+        return false;
+    }
+
+    _image_index++;
+    _last_trigger_us = triggered_us;
+    _last_photo_time = triggered_us / 1000;
+    _last_location = trigger_location(ahrs, current_loc);
+    _trigger_at_us = 0;
+    _triggered_us = 0;
+
+    // tell other components, as trigger_pic(true) does
+    mavlink_command_long_t cmd_msg {};
+    cmd_msg.command = MAV_CMD_DO_DIGICAM_CONTROL;
+    cmd_msg.param5 = 1;
+    mavlink_message_t msg;
+    mavlink_msg_command_long_encode(0, 0, &msg, &cmd_msg);
+    GCS_MAVLINK::send_to_components(&msg);
+
+    return true;
+}
+
+/*
+  project the current location back (or forward) to time_us
+ */
+Location AP_Camera::location_at(const AP_AHRS &ahrs, const Location &current_loc, uint32_t time_us)
+{
+    Location loc = current_loc;
+    Vector3f vel;
+    if (time_us == 0 || !ahrs.get_velocity_NED(vel)) {
+        return loc;
+    }
+    const float dt = constrain_float((int32_t)(time_us - AP_HAL::micros()) * 1.0e-6f, -1.0f, 1.0f);
+    location_offset(loc, vel.x * dt, vel.y * dt);
+    loc.alt -= vel.z * dt * 100;
+    return loc;
+}
+
 /*
   check if feedback pin is high
  */
@@ -328,6 +455,7 @@ void AP_Camera::feedback_pin_timer(void)
     uint8_t trigger_polarity = _feedback_polarity==0?0:1;
     if (pin_state == trigger_polarity &&
         _last_pin_state != trigger_polarity) {
+        _feedback_time_us = AP_HAL::micros();
         _camera_triggered = true;
     }
     _last_pin_state = pin_state;
@@ -352,7 +480,8 @@ bool AP_Camera::check_trigger_pin(void)
 void AP_Camera::capture_callback(void *context, uint32_t chan_index,
                                  hrt_abstime edge_time, uint32_t edge_state, uint32_t overflow)
 {
-    _camera_triggered = true;    
+    _feedback_time_us = edge_time;
+    _camera_triggered = true;
 }
 #endif
 
@@ -64,9 +64,23 @@ public:
     // Update location of vehicle and return true if a picture should be taken
     bool update_location(const struct Location &loc, const AP_AHRS &ahrs);
 
+    // check if a picture timed for the trigger distance was taken since
+    // the last call. The caller logs it as it would after trigger_pic()
+    bool check_scheduled_trigger(const AP_AHRS &ahrs, const Location &current_loc);
+
     // check if trigger pin has fired
     bool check_trigger_pin(void);
 
+    // location of the vehicle when the last picture was taken, or when
+    // the feedback pin last fired, projected back from the current
+    // location with the AHRS velocity
+    Location trigger_location(const AP_AHRS &ahrs, const Location &current_loc) const {
+        return location_at(ahrs, current_loc, _last_trigger_us);
+    }
+    Location feedback_location(const AP_AHRS &ahrs, const Location &current_loc) const {
+        return location_at(ahrs, current_loc, _feedback_time_us);
+    }
+
     // return true if we are using a feedback pin
     bool using_feedback_pin(void) const { return _feedback_pin > 0; }
     
@@ -83,6 +97,10 @@ private:
 
     void            servo_pic();        // Servo operated camera
     void            relay_pic();        // basic relay activation
+    void            shutter_on();       // activate the shutter of either type
+    void            trigger_timer();
+    void            schedule_trigger(float distance, const AP_AHRS &ahrs);
+    static Location location_at(const AP_AHRS &ahrs, const Location &current_loc, uint32_t time_us);
     void            feedback_pin_timer();
     void            setup_feedback_callback(void);
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4
@@ -103,6 +121,16 @@ private:
 
     // this is set to 1 when camera trigger pin has fired
     static volatile bool   _camera_triggered;
+    static volatile uint32_t _feedback_time_us;
     bool            _timer_installed:1;
     uint8_t         _last_pin_state;
+
+    // distance triggering fires the shutter from a timer at the
+    // predicted time the trigger distance is crossed
+    volatile uint32_t _trigger_at_us;   // when to fire, 0 if nothing is scheduled
+    volatile uint32_t _triggered_us;    // when the timer fired, 0 until it has
+    bool            _trigger_timer_installed:1;
+    uint32_t        _last_update_ms;    // last update_location() with a new position
+    uint16_t        _update_interval_ms;
+    uint32_t        _last_trigger_us;   // time of the last picture
 };
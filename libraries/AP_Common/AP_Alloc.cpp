@@ -0,0 +1,301 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ *   AP_Alloc.cpp - boot time arena and per subsystem allocation accounting
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AP_Alloc.h"
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  all state is plain static data so it is usable by static
+  constructors running before main()
+ */
+
+#define ARENA_ALIGN 8
+
+// allocations larger than this go straight to the heap
+#define ARENA_MAX_ALLOC (AP_ALLOC_ARENA_CHUNK_SIZE / 4)
+
+#define UNTAGGED_NAME "Other"
+
+static struct {
+    uint8_t *chunk[AP_ALLOC_ARENA_MAX_CHUNKS];
+    uint8_t num_chunks;
+    uint32_t top;           // bytes used in the newest chunk
+    uint8_t *last;          // most recent arena allocation
+    uint32_t last_size;
+    uint32_t used;
+    uint32_t lost_frees;
+} arena;
+
+static AP_Alloc::tag_info tags[AP_ALLOC_MAX_TAGS];
+static uint8_t num_tags_used;
+// only ever set and read on the main thread
+static const char *current_tag;
+static uint32_t runtime_allocs;
+static bool is_frozen;
+
+// held while the arena or the accounting is updated. An allocation
+// finding it held takes the plain heap path instead of waiting, a
+// free of arena memory is queued in pending_release
+static bool lock;
+
+// arena frees made while the lock was held, handled by the next caller
+// to take the lock
+#define PENDING_RELEASE_MAX 8
+static void *pending_release[PENDING_RELEASE_MAX];
+
+static bool try_lock(void)
+{
+    return !__atomic_test_and_set(&lock, __ATOMIC_ACQUIRE);
+}
+
+static void unlock(void)
+{
+    __atomic_clear(&lock, __ATOMIC_RELEASE);
+}
+
+/*
+  find or add the accounting entry for a tag, the last entry collects
+  everything once the table is full
+ */
+static AP_Alloc::tag_info &find_tag(const char *name)
+{
+    if (name == nullptr) {
+        name = UNTAGGED_NAME;
+    }
+    for (uint8_t i=0; i<num_tags_used; i++) {
+        if (tags[i].name == name || strcmp(tags[i].name, name) == 0) {
+            return tags[i];
+        }
+    }
+    if (num_tags_used == AP_ALLOC_MAX_TAGS) {
+        return tags[AP_ALLOC_MAX_TAGS-1];
+    }
+    AP_Alloc::tag_info &info = tags[num_tags_used++];
+    info.name = name;
+    return info;
+}
+
+static void account(size_t size)
+{
+    // a tag set on the main thread doesn't apply to other threads.
+    // No tag is set until setup(), by which time the HAL is running
+    const char *tag = current_tag;
+    if (tag != nullptr && !hal.scheduler->in_main_thread()) {
+        tag = nullptr;
+    }
+    AP_Alloc::tag_info &info = find_tag(tag);
+    if (is_frozen) {
+        info.runtime_bytes += size;
+        info.runtime_count++;
+        runtime_allocs++;
+    } else {
+        info.boot_bytes += size;
+        info.boot_count++;
+    }
+}
+
+// carve an allocation from the newest arena chunk, adding a chunk if needed
+static void *arena_allocate(size_t size)
+{
+    const uint32_t aligned = (size + (ARENA_ALIGN-1)) & ~(ARENA_ALIGN-1);
+    if (arena.num_chunks == 0 || arena.top + aligned > AP_ALLOC_ARENA_CHUNK_SIZE) {
+        if (arena.num_chunks == AP_ALLOC_ARENA_MAX_CHUNKS) {
+            return nullptr;
+        }
+        uint8_t *chunk = (uint8_t *)calloc(AP_ALLOC_ARENA_CHUNK_SIZE, 1);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        arena.chunk[arena.num_chunks++] = chunk;
+        arena.top = 0;
+    }
+    uint8_t *ret = &arena.chunk[arena.num_chunks-1][arena.top];
+    arena.top += aligned;
+    arena.used += aligned;
+    arena.last = ret;
+    arena.last_size = aligned;
+    return ret;
+}
+
+// give back arena memory, called with the lock held
+static void arena_release(void *ptr)
+{
+    if (ptr == arena.last) {
+        // give back the most recent allocation, zeroed ready for reuse
+        memset(arena.last, 0, arena.last_size);
+        arena.top -= arena.last_size;
+        arena.used -= arena.last_size;
+        arena.last = nullptr;
+    } else {
+        __atomic_add_fetch(&arena.lost_frees, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// handle frees queued while the lock was held, called with the lock held
+static void release_pending(void)
+{
+    for (uint8_t i=0; i<PENDING_RELEASE_MAX; i++) {
+        void *ptr = __atomic_exchange_n(&pending_release[i], nullptr, __ATOMIC_ACQUIRE);
+        if (ptr != nullptr) {
+            arena_release(ptr);
+        }
+    }
+}
+
+static bool in_arena(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (uint8_t i=0; i<arena.num_chunks; i++) {
+        if (p >= arena.chunk[i] && p < arena.chunk[i] + AP_ALLOC_ARENA_CHUNK_SIZE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void *AP_Alloc::allocate(size_t size)
+{
+    if (size < 1) {
+        size = 1;
+    }
+    if (!try_lock()) {
+        return calloc(size, 1);
+    }
+    void *ret = nullptr;
+    release_pending();
+    if (AP_ALLOC_ARENA_CHUNK_SIZE > 0 && !is_frozen && size <= ARENA_MAX_ALLOC) {
+        ret = arena_allocate(size);
+    }
+    if (ret == nullptr) {
+        ret = calloc(size, 1);
+    }
+    if (ret != nullptr) {
+        account(size);
+    }
+    unlock();
+    return ret;
+}
+
+void AP_Alloc::release(void *ptr)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+    if (AP_ALLOC_ARENA_CHUNK_SIZE == 0 || !in_arena(ptr)) {
+        free(ptr);
+        return;
+    }
+    if (!try_lock()) {
+        // waiting could deadlock against a lower priority thread
+        // holding the lock, so leave the free to the next lock holder
+        for (uint8_t i=0; i<PENDING_RELEASE_MAX; i++) {
+            void *expected = nullptr;
+            if (__atomic_compare_exchange_n(&pending_release[i], &expected, ptr, false,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                return;
+            }
+        }
+        // queue full, the memory stays in the arena
+        __atomic_add_fetch(&arena.lost_frees, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    release_pending();
+    arena_release(ptr);
+    unlock();
+}
+
+AP_Alloc::Tag::Tag(const char *name) :
+    _previous(current_tag),
+    _active(hal.scheduler->in_main_thread())
+{
+    if (_active) {
+        current_tag = name;
+    }
+}
+
+AP_Alloc::Tag::~Tag()
+{
+    if (_active) {
+        current_tag = _previous;
+    }
+}
+
+void AP_Alloc::freeze(void)
+{
+    is_frozen = true;
+}
+
+bool AP_Alloc::frozen(void)
+{
+    return is_frozen;
+}
+
+uint8_t AP_Alloc::num_tags(void)
+{
+    return num_tags_used;
+}
+
+bool AP_Alloc::get_tag(uint8_t idx, tag_info &info)
+{
+    if (idx >= num_tags_used) {
+        return false;
+    }
+    info = tags[idx];
+    return true;
+}
+
+uint32_t AP_Alloc::runtime_count(void)
+{
+    return runtime_allocs;
+}
+
+uint32_t AP_Alloc::arena_used(void)
+{
+    return arena.used;
+}
+
+uint8_t AP_Alloc::arena_chunks(void)
+{
+    return arena.num_chunks;
+}
+
+uint32_t AP_Alloc::arena_lost_frees(void)
+{
+    return arena.lost_frees;
+}
+
+void AP_Alloc::report(AP_HAL::BetterStream *port)
+{
+    port->printf("Memory: arena %u bytes in %u chunks, %u lost frees\n",
+                 (unsigned)arena.used, (unsigned)arena.num_chunks, (unsigned)arena.lost_frees);
+    for (uint8_t i=0; i<num_tags_used; i++) {
+        const tag_info &info = tags[i];
+        port->printf("  %s: %u bytes in %u allocs",
+                     info.name, (unsigned)info.boot_bytes, (unsigned)info.boot_count);
+        if (info.runtime_count != 0) {
+            port->printf(", RUNTIME %u bytes in %u allocs",
+                         (unsigned)info.runtime_bytes, (unsigned)info.runtime_count);
+        }
+        port->printf("\n");
+    }
+}
@@ -0,0 +1,113 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  allocator behind the global operator new and new[]
+
+  Until freeze() is called small allocations are carved sequentially
+  from large zeroed arena chunks rather than given their own heap
+  block, which avoids per-allocation heap overhead and keeps boot time
+  objects packed together. Memory freed from the arena is only
+  reclaimed when it was the most recent arena allocation (the common
+  probe-then-delete pattern of backend drivers). Larger allocations,
+  and all allocations after freeze(), come from calloc().
+
+  Every allocation is accounted against the tag active at the time,
+  set with an AP_Alloc::Tag scope object. Allocations after freeze()
+  are counted separately so unexpected runtime allocations can be
+  spotted. Only allocations through operator new are accounted,
+  libraries calling malloc() or calloc() directly are not seen.
+
+  Tags are only set and applied on the main thread. Allocations made
+  by other threads, such as startup probe tasks, are reported as
+  "Other".
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_HAL/AP_HAL_Namespace.h>
+
+#ifndef AP_ALLOC_ARENA_CHUNK_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
+#define AP_ALLOC_ARENA_CHUNK_SIZE 4096
+#else
+// boards with plenty of memory only do the accounting
+#define AP_ALLOC_ARENA_CHUNK_SIZE 0
+#endif
+#endif
+
+#ifndef AP_ALLOC_ARENA_MAX_CHUNKS
+#define AP_ALLOC_ARENA_MAX_CHUNKS 64
+#endif
+
+#define AP_ALLOC_MAX_TAGS 24
+
+namespace AP_Alloc {
+
+struct tag_info {
+    const char *name;
+    uint32_t boot_bytes;
+    uint32_t boot_count;
+    uint32_t runtime_bytes;
+    uint32_t runtime_count;
+};
+
+/*
+  attribute allocations made while this object is in scope to a
+  subsystem. Tags nest, the previous tag is restored on destruction.
+  The name must be a string constant of at most 10 characters so it
+  can be reported over MAVLink. A Tag made off the main thread does
+  nothing
+ */
+class Tag {
+public:
+    Tag(const char *name);
+    ~Tag();
+
+private:
+    const char *_previous;
+    bool _active;
+};
+
+// zeroed allocation and release used by operator new and delete
+void *allocate(size_t size);
+void release(void *ptr);
+
+// end of boot time allocation, later allocations are counted as
+// runtime. The accounting is available from get_tag() and report()
+void freeze(void);
+bool frozen(void);
+
+// accounting per tag, untagged allocations are reported as "Other"
+uint8_t num_tags(void);
+bool get_tag(uint8_t idx, tag_info &info);
+
+// allocations made after freeze() across all tags
+uint32_t runtime_count(void);
+
+// bytes handed out from arena chunks and number of arena chunks
+uint32_t arena_used(void);
+uint8_t arena_chunks(void);
+
+// number of frees of arena memory that could not be reclaimed
+uint32_t arena_lost_frees(void);
+
+// print the accounting to a console
+void report(AP_HAL::BetterStream *port);
+
+}
@@ -7,32 +7,30 @@
 #include <AP_HAL/AP_HAL.h>
 #include <stdlib.h>
 
+#include "AP_Alloc.h"
+
 /*
   globally override new and delete to ensure that we always start with
-  zero memory. This ensures consistent behaviour.
+  zero memory. This ensures consistent behaviour. Allocations go
+  through AP_Alloc for the boot time arena and per subsystem
+  accounting
  */
 void * operator new(size_t size)
 {
-    if (size < 1) {
-        size = 1;
-    }
-    return(calloc(size, 1));
+    return AP_Alloc::allocate(size);
 }
 
 void operator delete(void *p)
 {
-    if (p) free(p);
+    AP_Alloc::release(p);
 }
 
 void * operator new[](size_t size)
 {
-    if (size < 1) {
-        size = 1;
-    }
-    return(calloc(size, 1));
+    return AP_Alloc::allocate(size);
 }
 
 void operator delete[](void * ptr)
 {
-    if (ptr) free(ptr);
+    AP_Alloc::release(ptr);
 }
@@ -1,4 +1,5 @@
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Alloc.h>
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 #include <AP_HAL_Linux/I2CDevice.h>
 #endif
@@ -388,6 +389,7 @@ Compass::Compass(void) :
     // default device ids to zero.  init() method will overwrite with the actual device ids
     for (uint8_t i=0; i<COMPASS_MAX_INSTANCES; i++) {
         _state[i].dev_id = 0;
+        _state[i].rotation_valid = false;
     }
 }
 
@@ -444,6 +446,8 @@ bool Compass::_add_backend(AP_Compass_Backend *backend, const char *name, bool e
  */
 void Compass::_detect_backends(void)
 {
+    AP_Alloc::Tag alloc_tag("Compass");
+
     if (_hil_mode) {
         _add_backend(AP_Compass_HIL::detect(*this), nullptr, false);
         return;
@@ -543,15 +547,6 @@ void Compass::_detect_backends(void)
     }
 }
 
-void
-Compass::accumulate(void)
-{
-    for (uint8_t i=0; i< _backend_count; i++) {
-        // call accumulate on each of the backend
-        _backends[i]->accumulate();
-    }
-}
-
 bool
 Compass::read(void)
 {
@@ -5,6 +5,7 @@
 #include <AP_Common/AP_Common.h>
 #include <AP_Declination/AP_Declination.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/SensorTopic.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Param/AP_Param.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
@@ -72,10 +73,6 @@ public:
     ///
     bool read();
 
-    /// use spare CPU cycles to accumulate values from the compass if
-    /// possible (this method should also be implemented in the backends)
-    void accumulate();
-
     /// Calculate the tilt-compensated heading_ variables.
     ///
     /// @param dcm_matrix			The current orientation rotation matrix
@@ -272,6 +269,10 @@ public:
     uint32_t last_update_usec(void) const { return _state[get_primary()].last_update_usec; }
     uint32_t last_update_usec(uint8_t i) const { return _state[i].last_update_usec; }
 
+    // corrected field as published by the backend, for readers that
+    // want the field and its time together
+    const SensorTopic<Vector3f> &get_field_topic(uint8_t i) const { return _state[i].field_topic; }
+
     static const struct AP_Param::GroupInfo var_info[];
 
     // HIL variables
@@ -388,6 +389,15 @@ private:
         // when we last got data
         uint32_t    last_update_ms;
         uint32_t    last_update_usec;
+
+        // field with the time it was published
+        SensorTopic<Vector3f> field_topic;
+
+        // MAG_BOARD_ORIENTATION combined with the board or compass
+        // orientation, rebuilt when the orientation in use changes
+        Matrix3f    rotation;
+        int8_t      rotation_orientation;
+        bool        rotation_valid;
     } _state[COMPASS_MAX_INSTANCES];
 
     CompassCalibrator _calibrator[COMPASS_MAX_INSTANCES];
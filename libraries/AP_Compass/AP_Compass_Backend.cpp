@@ -12,15 +12,21 @@ AP_Compass_Backend::AP_Compass_Backend(Compass &compass) :
 void AP_Compass_Backend::rotate_field(Vector3f &mag, uint8_t instance)
 {
     Compass::mag_state &state = _compass._state[instance];
-    mag.rotate(MAG_BOARD_ORIENTATION);
 
-    if (!state.external) {
-        // and add in AHRS_ORIENTATION setting if not an external compass
-        mag.rotate(_compass._board_orientation);
-    } else {
-        // add user selectable orientation
-        mag.rotate((enum Rotation)state.orientation.get());
+    // add in AHRS_ORIENTATION setting if not an external compass,
+    // otherwise the user selectable orientation
+    const int8_t orientation = state.external ? state.orientation.get() : (int8_t)_compass._board_orientation;
+
+    if (!state.rotation_valid || state.rotation_orientation != orientation) {
+        Matrix3f board, rotation;
+        board.from_rotation(MAG_BOARD_ORIENTATION);
+        rotation.from_rotation((enum Rotation)orientation);
+        state.rotation = rotation * board;
+        state.rotation_orientation = orientation;
+        state.rotation_valid = true;
     }
+
+    mag = state.rotation * mag;
 }
 
 void AP_Compass_Backend::publish_raw_field(const Vector3f &mag, uint32_t time_us, uint8_t instance)
@@ -80,6 +86,8 @@ void AP_Compass_Backend::publish_filtered_field(const Vector3f &mag, uint8_t ins
 
     state.last_update_ms = AP_HAL::millis();
     state.last_update_usec = AP_HAL::micros();
+
+    state.field_topic.publish(mag, AP_HAL::micros64());
 }
 
 void AP_Compass_Backend::set_last_update_usec(uint32_t last_update, uint8_t instance)
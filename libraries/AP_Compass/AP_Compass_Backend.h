@@ -34,13 +34,10 @@ public:
     // initialize the magnetometers
     virtual bool init(void) = 0;
 
-    // read sensor data
+    // read sensor data. Backends sample and accumulate on their own
+    // timer or bus thread, read() publishes what they have
     virtual void read(void) = 0;
 
-    // accumulate a reading from the magnetometer. Optional in
-    // backends
-    virtual void accumulate(void) {};
-
 protected:
 
     /*
@@ -177,9 +177,6 @@ bool AP_Compass_HMC5843::init()
     bus_sem->give();
     hal.scheduler->resume_timer_procs();
 
-    // perform an initial read
-    read();
-
     _compass_instance = register_compass();
     set_dev_id(_compass_instance, _product_id);
 
@@ -187,6 +184,9 @@ bool AP_Compass_HMC5843::init()
         set_external(_compass_instance, true);
     }
 
+    // sample on the timer thread from now on
+    hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Compass_HMC5843::_timer, void));
+
     return true;
 
 errout:
@@ -199,26 +199,19 @@ fail_sem:
 }
 
 /*
- * Accumulate a reading from the magnetometer
+ * Accumulate a reading from the magnetometer on the timer thread
  *
  * bus semaphore must not be taken
  */
-void AP_Compass_HMC5843::accumulate()
+void AP_Compass_HMC5843::_timer()
 {
-    if (!_initialised) {
-        // someone has tried to enable a compass for the first time
-        // mid-flight .... we can't do that yet (especially as we won't
-        // have the right orientation!)
-        return;
-    }
-
    uint32_t tnow = AP_HAL::micros();
-   if (_accum_count != 0 && (tnow - _last_accum_time) < 13333) {
+   if ((tnow - _last_accum_time) < 13333) {
 	  // the compass gets new data at 75Hz
 	  return;
    }
 
-   if (!_bus->get_semaphore()->take(1)) {
+   if (!_bus->get_semaphore()->take_nonblocking()) {
        // the bus is busy - try again later
        return;
    }
@@ -269,8 +262,7 @@ void AP_Compass_HMC5843::accumulate()
 }
 
 /*
- * Take accumulated reads from the magnetometer or try to read once if no
- * valid data
+ * Take accumulated reads from the magnetometer
  *
  * bus semaphore must not be locked
  */
@@ -283,11 +275,11 @@ void AP_Compass_HMC5843::read()
         return;
     }
 
+    hal.scheduler->suspend_timer_procs();
     if (_accum_count == 0) {
-       accumulate();
-       if (_retry_time != 0) {
-          return;
-       }
+        // no new data since the last read
+        hal.scheduler->resume_timer_procs();
+        return;
     }
 
     Vector3f field(_mag_x_accum * _scaling[0],
@@ -297,6 +289,7 @@ void AP_Compass_HMC5843::read()
 
     _accum_count = 0;
     _mag_x_accum = _mag_y_accum = _mag_z_accum = 0;
+    hal.scheduler->resume_timer_procs();
 
     publish_filtered_field(field, _compass_instance);
 }
@@ -28,9 +28,11 @@ public:
 
     bool init() override;
     void read() override;
-    void accumulate() override;
 
 private:
+    // accumulate a reading, called from the timer thread
+    void _timer();
+
     AP_Compass_HMC5843(Compass &compass, AP_HMC5843_BusDriver *bus,
                        bool force_external);
 
@@ -109,7 +109,8 @@ bool AP_Compass_PX4::init(void)
 
 void AP_Compass_PX4::read(void)
 {
-    // try to accumulate one more sample, so we have the latest data
+    // the PX4 driver samples on its own thread and queues up to 20
+    // reports, so everything since the last read is still there
     accumulate();
 
     for (uint8_t i=0; i<_num_sensors; i++) {
@@ -128,30 +129,42 @@ void AP_Compass_PX4::read(void)
 
 void AP_Compass_PX4::accumulate(void)
 {
-    struct mag_report mag_report;
+    // the driver returns as many queued reports as fit, so take them
+    // in batches rather than with a read() per report
+    struct mag_report mag_report[PX4_MAG_READ_BATCH];
     for (uint8_t i=0; i<_num_sensors; i++) {
         uint8_t frontend_instance = _instance[i];
-        while (::read(_mag_fd[i], &mag_report, sizeof(mag_report)) == sizeof(mag_report) &&
-               mag_report.timestamp != _last_timestamp[i]) {
-
-            uint32_t time_us = (uint32_t)mag_report.timestamp;
-            // get raw_field - sensor frame, uncorrected
-            Vector3f raw_field = Vector3f(mag_report.x, mag_report.y, mag_report.z)*1.0e3f;
-
-            // rotate raw_field from sensor frame to body frame
-            rotate_field(raw_field, frontend_instance);
-
-            // publish raw_field (uncorrected point sample) for calibration use
-            publish_raw_field(raw_field, time_us, frontend_instance);
-
-            // correct raw_field for known errors
-            correct_field(raw_field, frontend_instance);
-
-            // accumulate into averaging filter
-            _sum[i] += raw_field;
-            _count[i]++;
-
-            _last_timestamp[i] = mag_report.timestamp;
+        bool more = true;
+        while (more) {
+            ssize_t ret = ::read(_mag_fd[i], mag_report, sizeof(mag_report));
+            uint8_t n = ret > 0 ? ret / sizeof(mag_report[0]) : 0;
+            more = (n == PX4_MAG_READ_BATCH);
+            for (uint8_t r=0; r<n; r++) {
+                const struct mag_report &report = mag_report[r];
+                if (report.timestamp == _last_timestamp[i]) {
+                    more = false;
+                    break;
+                }
+
+                uint32_t time_us = (uint32_t)report.timestamp;
+                // get raw_field - sensor frame, uncorrected
+                Vector3f raw_field = Vector3f(report.x, report.y, report.z)*1.0e3f;
+
+                // rotate raw_field from sensor frame to body frame
+                rotate_field(raw_field, frontend_instance);
+
+                // publish raw_field (uncorrected point sample) for calibration use
+                publish_raw_field(raw_field, time_us, frontend_instance);
+
+                // correct raw_field for known errors
+                correct_field(raw_field, frontend_instance);
+
+                // accumulate into averaging filter
+                _sum[i] += raw_field;
+                _count[i]++;
+
+                _last_timestamp[i] = report.timestamp;
+            }
         }
     }
 }
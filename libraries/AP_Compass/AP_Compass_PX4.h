@@ -3,18 +3,23 @@
 #include "AP_Compass.h"
 #include "AP_Compass_Backend.h"
 
+// reports taken from the driver queue per read()
+#define PX4_MAG_READ_BATCH 5
+
 class AP_Compass_PX4 : public AP_Compass_Backend
 {
 public:
     bool        init(void);
     void        read(void);
-    void        accumulate(void);
 
     AP_Compass_PX4(Compass &compass);
     // detect the sensor
     static AP_Compass_Backend *detect(Compass &compass);
 
 private:
+    // take the reports queued by the PX4 driver since the last call
+    void        accumulate(void);
+
     uint8_t  _num_sensors;
 
     uint8_t  _instance[COMPASS_MAX_INSTANCES];
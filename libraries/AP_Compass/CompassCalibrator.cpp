@@ -60,6 +60,7 @@
 #include "CompassCalibrator.h"
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_GeodesicGrid.h>
+#include <AP_Math/matrixN.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -144,8 +145,27 @@ void CompassCalibrator::update_completion_mask(const Vector3f& v)
 void CompassCalibrator::update_completion_mask()
 {
     memset(_completion_mask, 0, sizeof(_completion_mask));
-    for (int i = 0; i < _samples_collected; i++) {
-        update_completion_mask(_sample_buffer[i].get());
+
+    Matrix3f softiron{
+        _params.diag.x,    _params.offdiag.x, _params.offdiag.y,
+        _params.offdiag.x, _params.diag.y,    _params.offdiag.z,
+        _params.offdiag.y, _params.offdiag.z, _params.diag.z
+    };
+
+    // classify the samples in batches, which is cheaper than one at a time
+    Vector3f corrected[COMPASS_CAL_MASK_BATCH];
+    int8_t sections[COMPASS_CAL_MASK_BATCH];
+    for (uint16_t i = 0; i < _samples_collected; i += COMPASS_CAL_MASK_BATCH) {
+        const uint16_t n = MIN(_samples_collected - i, COMPASS_CAL_MASK_BATCH);
+        for (uint16_t k = 0; k < n; k++) {
+            corrected[k] = softiron * (_sample_buffer[i + k].get() + _params.offset);
+        }
+        AP_GeodesicGrid::sections(corrected, sections, n, true);
+        for (uint16_t k = 0; k < n; k++) {
+            if (sections[k] >= 0) {
+                _completion_mask[sections[k] / 8] |= 1 << (sections[k] % 8);
+            }
+        }
     }
 }
 
@@ -193,11 +213,12 @@ void CompassCalibrator::update(bool &failure) {
             }
             set_status(COMPASS_CAL_RUNNING_STEP_TWO);
         } else {
-            if (_fit_step == 0) {
+            if (_fit_step == 0 && _fit_sample_idx == 0 && _fit_phase == FIT_PHASE_ACCUMULATE) {
                 calc_initial_offset();
             }
-            run_sphere_fit();
-            _fit_step++;
+            if (run_fit_slice(false)) {
+                _fit_step++;
+            }
         }
     } else if(_status == COMPASS_CAL_RUNNING_STEP_TWO) {
         if (_fit_step >= 35) {
@@ -207,11 +228,8 @@ void CompassCalibrator::update(bool &failure) {
                 set_status(COMPASS_CAL_FAILED);
                 failure = true;
             }
-        } else if (_fit_step < 15) {
-            run_sphere_fit();
-            _fit_step++;
-        } else {
-            run_ellipsoid_fit();
+        } else if (run_fit_slice(_fit_step >= 15)) {
+            // sphere fit for the first 15 steps, then ellipsoid
             _fit_step++;
         }
     }
@@ -239,6 +257,8 @@ void CompassCalibrator::initialize_fit() {
     _sphere_lambda = 1.0f;
     _initial_fitness = _fitness;
     _fit_step = 0;
+    _fit_phase = FIT_PHASE_ACCUMULATE;
+    _fit_sample_idx = 0;
 }
 
 void CompassCalibrator::reset_state() {
@@ -458,20 +478,16 @@ float CompassCalibrator::calc_mean_squared_residuals(const param_t& params) cons
     return sum;
 }
 
-void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
+float CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
     const Vector3f &offdiag = params.offdiag;
-    Matrix3f softiron(
-        diag.x    , offdiag.x , offdiag.y,
-        offdiag.x , diag.y    , offdiag.z,
-        offdiag.y , offdiag.z , diag.z
-    );
 
     float A =  (diag.x    * (sample.x + offset.x)) + (offdiag.x * (sample.y + offset.y)) + (offdiag.y * (sample.z + offset.z));
     float B =  (offdiag.x * (sample.x + offset.x)) + (diag.y    * (sample.y + offset.y)) + (offdiag.z * (sample.z + offset.z));
     float C =  (offdiag.y * (sample.x + offset.x)) + (offdiag.z * (sample.y + offset.y)) + (diag.z    * (sample.z + offset.z));
-    float length = (softiron*(sample+offset)).length();
+    // A, B and C are the soft iron corrected sample, so this is the same length calc_residual() finds
+    float length = norm(A, B, C);
 
     // 0: partial derivative (radius wrt fitness fn) fn operated on sample
     ret[0] = 1.0f;
@@ -479,6 +495,8 @@ void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t&
     ret[1] = -1.0f * (((diag.x    * A) + (offdiag.x * B) + (offdiag.y * C))/length);
     ret[2] = -1.0f * (((offdiag.x * A) + (diag.y    * B) + (offdiag.z * C))/length);
     ret[3] = -1.0f * (((offdiag.y * A) + (offdiag.z * B) + (diag.z    * C))/length);
+
+    return params.radius - length;
 }
 
 void CompassCalibrator::calc_initial_offset()
@@ -491,105 +509,15 @@ void CompassCalibrator::calc_initial_offset()
     _params.offset /= _samples_collected;
 }
 
-void CompassCalibrator::run_sphere_fit()
-{
-    if(_sample_buffer == NULL) {
-        return;
-    }
-
-    const float lma_damping = 10.0f;
-
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
-
-    float JTJ[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
-    float JTJ2[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
-    float JTFI[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-    memset(&JTJ,0,sizeof(JTJ));
-    memset(&JTJ2,0,sizeof(JTJ2));
-    memset(&JTFI,0,sizeof(JTFI));
-    // Gauss Newton Part common for all kind of extensions including LM
-    for(uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
-
-        float sphere_jacob[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-        calc_sphere_jacob(sample, fit1_params, sphere_jacob);
-
-        for(uint8_t i = 0;i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-            // compute JTJ
-            for(uint8_t j = 0; j < COMPASS_CAL_NUM_SPHERE_PARAMS; j++) {
-                JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];   //a backup JTJ for LM
-            }
-            // compute JTFI
-            JTFI[i] += sphere_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
-
-
-    //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
-    //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for(uint8_t i = 0; i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda/lma_damping;
-    }
-
-    if(!inverse(JTJ, JTJ, 4)) {
-        return;
-    }
-
-    if(!inverse(JTJ2, JTJ2, 4)) {
-        return;
-    }
-
-    for(uint8_t row=0; row < COMPASS_CAL_NUM_SPHERE_PARAMS; row++) {
-        for(uint8_t col=0; col < COMPASS_CAL_NUM_SPHERE_PARAMS; col++) {
-            fit1_params.get_sphere_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-            fit2_params.get_sphere_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-        }
-    }
-
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
-
-    if(fit1 > _fitness && fit2 > _fitness){
-        _sphere_lambda *= lma_damping;
-    } else if(fit2 < _fitness && fit2 < fit1) {
-        _sphere_lambda /= lma_damping;
-        fit1_params = fit2_params;
-        fitness = fit2;
-    } else if(fit1 < _fitness){
-        fitness = fit1;
-    }
-    //--------------------Levenberg-Marquardt-part-ends-here--------------------------------//
-
-    if(!isnan(fitness) && fitness < _fitness) {
-        _fitness = fitness;
-        _params = fit1_params;
-        update_completion_mask();
-    }
-}
-
-
-
-void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
+float CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
     const Vector3f &offdiag = params.offdiag;
-    Matrix3f softiron(
-        diag.x    , offdiag.x , offdiag.y,
-        offdiag.x , diag.y    , offdiag.z,
-        offdiag.y , offdiag.z , diag.z
-    );
 
     float A =  (diag.x    * (sample.x + offset.x)) + (offdiag.x * (sample.y + offset.y)) + (offdiag.y * (sample.z + offset.z));
     float B =  (offdiag.x * (sample.x + offset.x)) + (diag.y    * (sample.y + offset.y)) + (offdiag.z * (sample.z + offset.z));
     float C =  (offdiag.y * (sample.x + offset.x)) + (offdiag.z * (sample.y + offset.y)) + (diag.z    * (sample.z + offset.z));
-    float length = (softiron*(sample+offset)).length();
+    float length = norm(A, B, C);
 
     // 0-2: partial derivative (offset wrt fitness fn) fn operated on sample
     ret[0] = -1.0f * (((diag.x    * A) + (offdiag.x * B) + (offdiag.y * C))/length);
@@ -603,90 +531,173 @@ void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param
     ret[6] = -1.0f * (((sample.y + offset.y) * A) + ((sample.x + offset.x) * B))/length;
     ret[7] = -1.0f * (((sample.z + offset.z) * A) + ((sample.x + offset.x) * C))/length;
     ret[8] = -1.0f * (((sample.z + offset.z) * B) + ((sample.y + offset.y) * C))/length;
+
+    return params.radius - length;
 }
 
-void CompassCalibrator::run_ellipsoid_fit()
+/*
+  run part of one Levenberg-Marquardt iteration of the sphere or
+  ellipsoid fit. An iteration is two passes over the samples: the
+  first accumulates JTJ and JTFI, the second measures the fitness of
+  the two candidate solutions. Each call handles at most
+  COMPASS_CAL_SAMPLES_PER_SLICE samples so calibrating several
+  compasses at once does not overrun the scheduler.
+
+  returns true when the iteration is complete
+ */
+bool CompassCalibrator::run_fit_slice(bool ellipsoid)
 {
     if(_sample_buffer == NULL) {
-        return;
+        return true;
     }
 
-    const float lma_damping = 10.0f;
-
-
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
+    const uint8_t n = ellipsoid ? COMPASS_CAL_NUM_ELLIPSOID_PARAMS : COMPASS_CAL_NUM_SPHERE_PARAMS;
+    const uint16_t end = MIN(_fit_sample_idx + COMPASS_CAL_SAMPLES_PER_SLICE, _samples_collected);
 
+    if (_fit_phase == FIT_PHASE_ACCUMULATE) {
+        if (_fit_sample_idx == 0) {
+            memset(_fit_JTJ, 0, sizeof(_fit_JTJ));
+            memset(_fit_JTFI, 0, sizeof(_fit_JTFI));
+        }
+        // Gauss Newton Part common for all kind of extensions including LM
+        for(uint16_t k = _fit_sample_idx; k<end; k++) {
+            Vector3f sample = _sample_buffer[k].get();
+
+            float jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+            const float resid = ellipsoid ? calc_ellipsoid_jacob(sample, _params, jacob) :
+                                            calc_sphere_jacob(sample, _params, jacob);
+
+            for(uint8_t i = 0; i < n; i++) {
+                // compute the upper triangle of JTJ, which is symmetric
+                for(uint8_t j = i; j < n; j++) {
+                    _fit_JTJ[i*n+j] += jacob[i] * jacob[j];
+                }
+                // compute JTFI
+                _fit_JTFI[i] += jacob[i] * resid;
+            }
+        }
+        _fit_sample_idx = end;
+        if (_fit_sample_idx < _samples_collected) {
+            return false;
+        }
 
-    float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-    float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-    float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        _fit_sample_idx = 0;
+        if (!solve_fit(ellipsoid)) {
+            // singular, leave the parameters as they are for this iteration
+            return true;
+        }
+        _fit_phase = FIT_PHASE_EVALUATE;
+        _fit1_sum = 0.0f;
+        _fit2_sum = 0.0f;
+        return false;
+    }
 
-    memset(&JTJ,0,sizeof(JTJ));
-    memset(&JTJ2,0,sizeof(JTJ2));
-    memset(&JTFI,0,sizeof(JTFI));
-    // Gauss Newton Part common for all kind of extensions including LM
-    for(uint16_t k = 0; k<_samples_collected; k++) {
+    // measure both candidates in one pass over the samples
+    for(uint16_t k = _fit_sample_idx; k<end; k++) {
         Vector3f sample = _sample_buffer[k].get();
+        _fit1_sum += sq(calc_residual(sample, _fit1_params));
+        _fit2_sum += sq(calc_residual(sample, _fit2_params));
+    }
+    _fit_sample_idx = end;
+    if (_fit_sample_idx < _samples_collected) {
+        return false;
+    }
 
-        float ellipsoid_jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-
-        calc_ellipsoid_jacob(sample, fit1_params, ellipsoid_jacob);
+    _fit_sample_idx = 0;
+    _fit_phase = FIT_PHASE_ACCUMULATE;
+    finish_fit(ellipsoid);
+    return true;
+}
 
-        for(uint8_t i = 0;i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-            // compute JTJ
-            for(uint8_t j = 0; j < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; j++) {
-                JTJ [i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-            }
-            // compute JTFI
-            JTFI[i] += ellipsoid_jacob[i] * calc_residual(sample, fit1_params);
+/*
+  solve (JTJ + lambda*I) * step = JTFI for the Levenberg-Marquardt step,
+  where JTJ holds its upper triangle. JTJ is positive semi-definite so
+  with lambda > 0 the Cholesky decomposition applies
+ */
+template <uint8_t N>
+static bool lm_step(const float *JTJ, const float *JTFI, float lambda, float step[N])
+{
+    MatrixN<float,N,N> m;
+    for(uint8_t i = 0; i < N; i++) {
+        for(uint8_t j = 0; j <= i; j++) {
+            m[i][j] = JTJ[j*N+i];
         }
+        m[i][i] += lambda;
     }
+    if (!m.cholesky_decompose()) {
+        return false;
+    }
+    m.cholesky_solve(JTFI, step);
+    for(uint8_t i = 0; i < N; i++) {
+        if (isnan(step[i]) || isinf(step[i])) {
+            return false;
+        }
+    }
+    return true;
+}
 
-
+/*
+  find the two candidate solutions from the accumulated JTJ and JTFI,
+  one with the current damping and one with less
+ */
+bool CompassCalibrator::solve_fit(bool ellipsoid)
+{
+    const float lma_damping = 10.0f;
+    const uint8_t n = ellipsoid ? COMPASS_CAL_NUM_ELLIPSOID_PARAMS : COMPASS_CAL_NUM_SPHERE_PARAMS;
+    const float lambda = ellipsoid ? _ellipsoid_lambda : _sphere_lambda;
 
     //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
     //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for(uint8_t i = 0; i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda/lma_damping;
-    }
-
-    if(!inverse(JTJ, JTJ, 9)) {
-        return;
+    float step1[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    float step2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    if (ellipsoid) {
+        if (!lm_step<COMPASS_CAL_NUM_ELLIPSOID_PARAMS>(_fit_JTJ, _fit_JTFI, lambda, step1) ||
+            !lm_step<COMPASS_CAL_NUM_ELLIPSOID_PARAMS>(_fit_JTJ, _fit_JTFI, lambda/lma_damping, step2)) {
+            return false;
+        }
+    } else {
+        if (!lm_step<COMPASS_CAL_NUM_SPHERE_PARAMS>(_fit_JTJ, _fit_JTFI, lambda, step1) ||
+            !lm_step<COMPASS_CAL_NUM_SPHERE_PARAMS>(_fit_JTJ, _fit_JTFI, lambda/lma_damping, step2)) {
+            return false;
+        }
     }
 
-    if(!inverse(JTJ2, JTJ2, 9)) {
-        return;
+    _fit1_params = _fit2_params = _params;
+    float *fit1 = ellipsoid ? _fit1_params.get_ellipsoid_params() : _fit1_params.get_sphere_params();
+    float *fit2 = ellipsoid ? _fit2_params.get_ellipsoid_params() : _fit2_params.get_sphere_params();
+    for(uint8_t row=0; row < n; row++) {
+        fit1[row] -= step1[row];
+        fit2[row] -= step2[row];
     }
+    return true;
+}
 
-    for(uint8_t row=0; row < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; row++) {
-        for(uint8_t col=0; col < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; col++) {
-            fit1_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-            fit2_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-        }
-    }
+/*
+  pick the better candidate and adjust the damping
+ */
+void CompassCalibrator::finish_fit(bool ellipsoid)
+{
+    const float lma_damping = 10.0f;
+    float &lambda = ellipsoid ? _ellipsoid_lambda : _sphere_lambda;
 
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
+    float fitness = _fitness;
+    float fit1 = _fit1_sum / _samples_collected;
+    float fit2 = _fit2_sum / _samples_collected;
 
     if(fit1 > _fitness && fit2 > _fitness){
-        _ellipsoid_lambda *= lma_damping;
+        lambda *= lma_damping;
     } else if(fit2 < _fitness && fit2 < fit1) {
-        _ellipsoid_lambda /= lma_damping;
-        fit1_params = fit2_params;
+        lambda /= lma_damping;
+        _fit1_params = _fit2_params;
         fitness = fit2;
     } else if(fit1 < _fitness){
         fitness = fit1;
     }
-    //--------------------Levenberg-part-ends-here--------------------------------//
+    //--------------------Levenberg-Marquardt-part-ends-here--------------------------------//
 
-    if(fitness < _fitness) {
+    if(!isnan(fitness) && fitness < _fitness) {
         _fitness = fitness;
-        _params = fit1_params;
+        _params = _fit1_params;
         update_completion_mask();
     }
 }
@@ -4,6 +4,11 @@
 #define COMPASS_CAL_NUM_ELLIPSOID_PARAMS 9
 #define COMPASS_CAL_NUM_SAMPLES 300
 
+// samples processed by each call to update() while fitting
+#define COMPASS_CAL_SAMPLES_PER_SLICE 100
+// compass samples classified together when rebuilding the completion mask
+#define COMPASS_CAL_MASK_BATCH 16
+
 //RMS tolerance
 #define COMPASS_CAL_DEFAULT_TOLERANCE 5.0f
 
@@ -96,6 +101,20 @@ private:
     uint16_t _samples_collected;
     uint16_t _samples_thinned;
 
+    // state of the fit iteration in progress, which is spread over
+    // several calls to update()
+    enum fit_phase_t {
+        FIT_PHASE_ACCUMULATE = 0,
+        FIT_PHASE_EVALUATE = 1
+    } _fit_phase;
+    uint16_t _fit_sample_idx;
+    float _fit_JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS]; // upper triangle only
+    float _fit_JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    class param_t _fit1_params;
+    class param_t _fit2_params;
+    float _fit1_sum;
+    float _fit2_sum;
+
     bool set_status(compass_cal_status_t status);
 
     // returns true if sample should be added to buffer
@@ -118,11 +137,15 @@ private:
     float calc_mean_squared_residuals() const;
 
     void calc_initial_offset();
-    void calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_sphere_fit();
 
-    void calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_ellipsoid_fit();
+    // fill in the jacobian for a sample and return its residual
+    float calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
+    float calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
+
+    // run part of a fit iteration, returning true when it completes
+    bool run_fit_slice(bool ellipsoid);
+    bool solve_fit(bool ellipsoid);
+    void finish_fit(bool ellipsoid);
 
     /**
      * Update #_completion_mask for the geodesic section of \p v. Corrections
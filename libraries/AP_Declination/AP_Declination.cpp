@@ -109,32 +109,64 @@ static const row_value declination_values[] = {
     {0,0,0},{3,0,5},{2,0,1},{1,0,0},{0,0,0},{1,1,0},{2,1,0},{5,1,0},{8,1,0},{12,1,0},{14,1,0},{13,1,0},{9,1,0},{6,1,0},{3,1,0},{1,1,0},{0,0,0},{2,0,0},{1,0,0},{3,0,0},{2,0,0},{3,0,0},{4,0,0},{3,0,1},{4,0,0},{3,0,0},{4,0,1},{3,0,0},{4,0,0},{3,0,2},{4,0,0},{3,0,1},{4,0,0},{3,0,0},{2,0,0},{3,0,0},{2,0,2},{0,0,1},{1,1,0},{2,1,0},{4,1,0},{5,1,0},{7,1,0},{8,1,0},{6,1,1},{5,1,0},{3,1,0},{1,1,1},{1,0,1},{2,0,0},{3,0,0},{2,0,0},{3,0,1},{2,0,0},{3,0,0},
 };
 
+// latmin starts outside the grid so the first lookup fills the cell
+AP_Declination::cell AP_Declination::_cell = { INT16_MAX, INT16_MAX, 0, 0, 0, 0 };
+
+/*
+  make c the cell containing lat/lon, reading the tables only if it
+  isn't already
+ */
+void
+AP_Declination::find_cell(struct cell &c, float lat, float lon)
+{
+    const int16_t latmin = floorf(lat/5)*5;
+    const int16_t lonmin = floorf(lon/5)*5;
+    if (latmin == c.latmin && lonmin == c.lonmin) {
+        return;
+    }
+
+    const uint8_t latmin_index = (90+latmin)/5;
+    const uint8_t lonmin_index = (180+lonmin)/5;
+
+    c.SW = get_lookup_value(latmin_index, lonmin_index);
+    c.SE = get_lookup_value(latmin_index, lonmin_index+1);
+    c.NE = get_lookup_value(latmin_index+1, lonmin_index+1);
+    c.NW = get_lookup_value(latmin_index+1, lonmin_index);
+    c.latmin = latmin;
+    c.lonmin = lonmin;
+}
+
 float
-AP_Declination::get_declination(float lat, float lon)
+AP_Declination::interpolate(const struct cell &c, float lat, float lon)
 {
-    int16_t decSW, decSE, decNW, decNE, lonmin, latmin;
-    uint8_t latmin_index,lonmin_index;
-    float decmin, decmax;
+    /* approximate declination within the grid using bilinear interpolation */
+    const float decmin = (lon - c.lonmin) / 5 * (c.SE - c.SW) + c.SW;
+    const float decmax = (lon - c.lonmin) / 5 * (c.NE - c.NW) + c.NW;
+    return (lat - c.latmin) / 5 * (decmax - decmin) + decmin;
+}
 
+float
+AP_Declination::get_declination(float lat, float lon)
+{
     // Constrain to valid inputs
     lat = constrain_float(lat, -90, 90);
     lon = constrain_float(lon, -180, 180);
 
-    latmin = floorf(lat/5)*5;
-    lonmin = floorf(lon/5)*5;
-
-    latmin_index= (90+latmin)/5;
-    lonmin_index= (180+lonmin)/5;
-
-    decSW = get_lookup_value(latmin_index, lonmin_index);
-    decSE = get_lookup_value(latmin_index, lonmin_index+1);
-    decNE = get_lookup_value(latmin_index+1, lonmin_index+1);
-    decNW = get_lookup_value(latmin_index+1, lonmin_index);
+    find_cell(_cell, lat, lon);
+    return interpolate(_cell, lat, lon);
+}
 
-    /* approximate declination within the grid using bilinear interpolation */
-    decmin = (lon - lonmin) / 5 * (decSE - decSW) + decSW;
-    decmax = (lon - lonmin) / 5 * (decNE - decNW) + decNW;
-    return (lat - latmin) / 5 * (decmax - decmin) + decmin;
+void
+AP_Declination::get_declinations(uint16_t num, const float *lat, const float *lon, float *declination)
+{
+    struct cell c = _cell;
+    for (uint16_t i=0; i<num; i++) {
+        const float lat_i = constrain_float(lat[i], -90, 90);
+        const float lon_i = constrain_float(lon[i], -180, 180);
+        find_cell(c, lat_i, lon_i);
+        declination[i] = interpolate(c, lat_i, lon_i);
+    }
+    _cell = c;
 }
 
 int16_t
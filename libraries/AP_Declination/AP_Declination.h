@@ -15,6 +15,25 @@ class AP_Declination
 {
 public:
     static float            get_declination(float lat, float lon);
+
+    // declination at num positions, decoding the tables once for
+    // each run of positions in the same grid cell
+    static void             get_declinations(uint16_t num, const float *lat, const float *lon, float *declination);
+
 private:
     static int16_t          get_lookup_value(uint8_t x, uint8_t y);
+
+    // the table values at the corners of one 5 degree grid cell
+    struct cell {
+        int16_t latmin;
+        int16_t lonmin;
+        int16_t SW, SE, NE, NW;
+    };
+
+    static void             find_cell(struct cell &c, float lat, float lon);
+    static float            interpolate(const struct cell &c, float lat, float lon);
+
+    // cell of the last lookup. Decoding a value walks a compressed
+    // table row, so it is only done when the position leaves the cell
+    static struct cell      _cell;
 };
@@ -105,11 +105,35 @@ void setup(void)
             }
         }
     }
+
+    // a short track, which stays within one grid cell
+    const uint16_t track_len = 100;
+    float track_lat[track_len], track_lon[track_len], track_dec[track_len];
+    for (uint16_t k = 0; k < track_len; k++) {
+        track_lat[k] = -35.36f + k*0.001f;
+        track_lon[k] = 149.16f + k*0.001f;
+    }
+    uint32_t t1 = AP_HAL::micros();
+    AP_Declination::get_declinations(track_len, track_lat, track_lon, track_dec);
+    const uint32_t track_time = AP_HAL::micros() - t1;
+    for (uint16_t k = 0; k < track_len; k++) {
+        declination_test = get_declination(track_lat[k], track_lon[k]);
+        if (track_dec[k] == declination_test) {
+            pass++;
+        } else {
+            hal.console->printf("FAIL: %f, %f : %f, %f\n",
+                                track_lat[k], track_lon[k], track_dec[k], declination_test);
+            fail++;
+        }
+    }
+    hal.console->printf("Average time per track position: %.2f usec\n",
+                        track_time/(float)track_len);
+
     hal.console->print("Ending Test.\n\n");
     hal.console->printf("Total Pass: %i\n", pass);
     hal.console->printf("Total Fail: %i\n", fail);
     hal.console->printf("Average time per call: %.1f usec\n",
-                  total_time/(float)(pass+fail));
+                  total_time/(float)(pass+fail-track_len));
 }
 
 void loop(void)
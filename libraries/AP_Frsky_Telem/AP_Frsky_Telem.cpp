@@ -104,52 +104,8 @@ void AP_Frsky_Telem::send_SPort_Passthrough(void)
                 send_uint32(DIY_FIRST_ID, _msg_chunk.chunk);
                 return;
             }
-            // send other sensor data if it's time for them, and reset the corresponding timer if sent
-            uint32_t now = AP_HAL::millis();
-            if (((now - _passthrough.params_timer) > 1000) && (!AP_Notify::flags.armed)) {
-                send_uint32(DIY_FIRST_ID+7, calc_param());
-                _passthrough.params_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.ap_status_timer) > 500) {
-                send_uint32(DIY_FIRST_ID+1, calc_ap_status());
-                _passthrough.ap_status_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.batt_timer) > 1000) {
-                send_uint32(DIY_FIRST_ID+3, calc_batt());
-                _passthrough.batt_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.gps_status_timer) > 1000) {
-                send_uint32(DIY_FIRST_ID+2, calc_gps_status());
-                _passthrough.gps_status_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.home_timer) > 500) {
-                send_uint32(DIY_FIRST_ID+4, calc_home());
-                _passthrough.home_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.velandyaw_timer) > 500) {
-                send_uint32(DIY_FIRST_ID+5, calc_velandyaw());
-                _passthrough.velandyaw_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.gps_latlng_timer) > 1000) {
-                send_uint32(GPS_LONG_LATI_FIRST_ID, calc_gps_latlng(&_passthrough.send_latitude)); // gps latitude or longitude
-                if (!_passthrough.send_latitude) { // we've cycled and sent one each of longitude then latitude, so reset the timer
-                    _passthrough.gps_latlng_timer = AP_HAL::millis();
-                }
-                return;
-            } else if ((now - _passthrough.vario_timer) > 500) {
-                Vector3f velNED;
-                if (_ahrs.get_velocity_NED(velNED)) {
-                    send_uint32(VARIO_FIRST_ID, (int32_t)roundf(-velNED.z*100)); // vertical velocity in cm/s, +ve up
-                }
-                _passthrough.vario_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.alt_timer) > 1000) {
-                send_uint32(ALT_FIRST_ID, (int32_t)_relative_home_altitude); // altitude in cm above home position
-                _passthrough.alt_timer = AP_HAL::millis();
-                return;
-            } else if ((now - _passthrough.vfas_timer) > 1000) {
-                send_uint32(VFAS_FIRST_ID, (uint32_t)roundf(_battery.voltage() * 100.0f)); // battery pack voltage in volts
-                _passthrough.vfas_timer = AP_HAL::millis();
+            // send other sensor data if it's time for them
+            if (send_passthrough_scheduled(AP_HAL::millis())) {
                 return;
             }
         }
@@ -158,6 +114,140 @@ void AP_Frsky_Telem::send_SPort_Passthrough(void)
     }
 }
 
+/*
+ * target interval of each passthrough frame, indexed by passthrough_type
+ * attitude is sent on every other poll on top of these
+ * for FrSky SPort Passthrough (OpenTX) protocol (X-receivers)
+ */
+const uint16_t AP_Frsky_Telem::passthrough_interval_ms[PASSTHROUGH_NUM_TYPES] = {
+    500,    // PASSTHROUGH_AP_STATUS
+    500,    // PASSTHROUGH_BATT
+    500,    // PASSTHROUGH_HOME
+    500,    // PASSTHROUGH_VELANDYAW
+    500,    // PASSTHROUGH_VARIO
+    1000,   // PASSTHROUGH_GPS_STATUS
+    1000,   // PASSTHROUGH_GPS_LATLNG
+    1000,   // PASSTHROUGH_ALT
+    1000,   // PASSTHROUGH_VFAS
+    1000,   // PASSTHROUGH_PARAM
+};
+
+/*
+ * send the passthrough frame that is furthest behind its target interval, relative to that interval,
+ * so each type gets its share of the link whatever the receiver's poll rate
+ * a value that hasn't changed since it was last sent is skipped in favour of the next type,
+ * until it is PASSTHROUGH_REFRESH_FACTOR intervals old
+ * returns false if nothing was sent
+ * for FrSky SPort Passthrough (OpenTX) protocol (X-receivers)
+ */
+bool AP_Frsky_Telem::send_passthrough_scheduled(uint32_t now)
+{
+    for (uint8_t attempt=0; attempt<PASSTHROUGH_NUM_TYPES; attempt++) {
+        int8_t best = -1;
+        uint32_t best_lag = 0;
+        for (uint8_t i=0; i<PASSTHROUGH_NUM_TYPES; i++) {
+            if (i == PASSTHROUGH_PARAM && AP_Notify::flags.armed) {
+                continue;
+            }
+            const uint32_t elapsed = MIN(now - _passthrough_sched[i].checked_ms, 60000U);
+            if (elapsed < passthrough_interval_ms[i]) {
+                continue;
+            }
+            const uint32_t lag = elapsed * 256U / passthrough_interval_ms[i];
+            if (lag > best_lag) {
+                best_lag = lag;
+                best = i;
+            }
+        }
+        if (best == -1) {
+            return false;
+        }
+
+        const enum passthrough_type type = (enum passthrough_type)best;
+        const uint32_t last_checked_ms = _passthrough_sched[type].checked_ms;
+        _passthrough_sched[type].checked_ms = now;
+        uint16_t id;
+        uint32_t value;
+        if (!calc_passthrough(type, id, value)) {
+            continue;
+        }
+        // lat/lng and params step through several values, so always go
+        const bool sequence = (type == PASSTHROUGH_GPS_LATLNG || type == PASSTHROUGH_PARAM);
+        const bool stale = (now - _passthrough_sched[type].sent_ms >=
+                            (uint32_t)passthrough_interval_ms[type] * PASSTHROUGH_REFRESH_FACTOR);
+        if (!sequence && !stale && value == _passthrough_sched[type].value) {
+            continue;
+        }
+        send_uint32(id, value);
+        _passthrough_sched[type].sent_ms = now;
+        _passthrough_sched[type].value = value;
+        if (type == PASSTHROUGH_GPS_LATLNG && _passthrough.send_latitude) {
+            // longitude has been sent, latitude follows on the next slot
+            _passthrough_sched[type].checked_ms = last_checked_ms;
+        }
+        return true;
+    }
+    return false;
+}
+
+/*
+ * data ID and value of one passthrough frame, returns false if there is nothing to send
+ * for FrSky SPort Passthrough (OpenTX) protocol (X-receivers)
+ */
+bool AP_Frsky_Telem::calc_passthrough(enum passthrough_type type, uint16_t &id, uint32_t &value)
+{
+    switch (type) {
+    case PASSTHROUGH_AP_STATUS:
+        id = DIY_FIRST_ID+1;
+        value = calc_ap_status();
+        return true;
+    case PASSTHROUGH_BATT:
+        id = DIY_FIRST_ID+3;
+        value = calc_batt();
+        return true;
+    case PASSTHROUGH_HOME:
+        id = DIY_FIRST_ID+4;
+        value = calc_home();
+        return true;
+    case PASSTHROUGH_VELANDYAW:
+        id = DIY_FIRST_ID+5;
+        value = calc_velandyaw();
+        return true;
+    case PASSTHROUGH_VARIO: {
+        Vector3f velNED;
+        if (!_ahrs.get_velocity_NED(velNED)) {
+            return false;
+        }
+        id = VARIO_FIRST_ID;
+        value = (int32_t)roundf(-velNED.z*100); // vertical velocity in cm/s, +ve up
+        return true;
+    }
+    case PASSTHROUGH_GPS_STATUS:
+        id = DIY_FIRST_ID+2;
+        value = calc_gps_status();
+        return true;
+    case PASSTHROUGH_GPS_LATLNG:
+        id = GPS_LONG_LATI_FIRST_ID;
+        value = calc_gps_latlng(&_passthrough.send_latitude); // gps latitude or longitude
+        return true;
+    case PASSTHROUGH_ALT:
+        id = ALT_FIRST_ID;
+        value = (int32_t)_relative_home_altitude; // altitude in cm above home position
+        return true;
+    case PASSTHROUGH_VFAS:
+        id = VFAS_FIRST_ID;
+        value = (uint32_t)roundf(_battery.voltage() * 100.0f); // battery pack voltage in volts
+        return true;
+    case PASSTHROUGH_PARAM:
+        id = DIY_FIRST_ID+7;
+        value = calc_param();
+        return true;
+    case PASSTHROUGH_NUM_TYPES:
+        break;
+    }
+    return false;
+}
+
 /*
  * send telemetry data
  * for FrSky SPort protocol (X-receivers)
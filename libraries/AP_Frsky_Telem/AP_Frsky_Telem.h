@@ -108,6 +108,10 @@ for FrSky SPort Passthrough
 #define ATTIANDRNG_PITCH_OFFSET     11
 #define ATTIANDRNG_RNGFND_OFFSET    21
 
+// an unchanged passthrough value is still resent after this many of
+// its intervals, for receivers that missed it
+#define PASSTHROUGH_REFRESH_FACTOR  4
+
 
 
 class AP_Frsky_Telem
@@ -186,17 +190,31 @@ private:
         uint8_t new_byte;
         bool send_attiandrng;
         bool send_latitude;
-        uint32_t params_timer;
-        uint32_t ap_status_timer;
-        uint32_t batt_timer;
-        uint32_t gps_status_timer;
-        uint32_t home_timer;
-        uint32_t velandyaw_timer;
-        uint32_t gps_latlng_timer;
-        uint32_t vario_timer;
-        uint32_t alt_timer;
-        uint32_t vfas_timer;
     } _passthrough;
+
+    // passthrough frames sent between attitude frames, see
+    // send_passthrough_scheduled()
+    enum passthrough_type {
+        PASSTHROUGH_AP_STATUS = 0,
+        PASSTHROUGH_BATT,
+        PASSTHROUGH_HOME,
+        PASSTHROUGH_VELANDYAW,
+        PASSTHROUGH_VARIO,
+        PASSTHROUGH_GPS_STATUS,
+        PASSTHROUGH_GPS_LATLNG,
+        PASSTHROUGH_ALT,
+        PASSTHROUGH_VFAS,
+        PASSTHROUGH_PARAM,
+        PASSTHROUGH_NUM_TYPES
+    };
+    static const uint16_t passthrough_interval_ms[PASSTHROUGH_NUM_TYPES];
+    struct {
+        uint32_t checked_ms;    // last time the value was looked at
+        uint32_t sent_ms;
+        uint32_t value;         // last value sent
+    } _passthrough_sched[PASSTHROUGH_NUM_TYPES];
+    bool send_passthrough_scheduled(uint32_t now);
+    bool calc_passthrough(enum passthrough_type type, uint16_t &id, uint32_t &value);
     
     struct
     {
@@ -14,6 +14,7 @@
  */
 #include "AP_GPS.h"
 
+#include <AP_Common/AP_Alloc.h>
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
@@ -35,6 +36,16 @@
 #include "AP_GPS_MAV.h"
 #include "GPS_Backend.h"
 
+#define GPS_BLEND_MASK_USE_HPOS     1
+#define GPS_BLEND_MASK_USE_VPOS     2
+#define GPS_BLEND_MASK_USE_SPD      4
+
+// a receiver is left out of the blend once its messages are this old
+#define GPS_BLEND_TIMEOUT_MS        500
+// reported accuracies are floored at this so one receiver can't take
+// all of the weight
+#define GPS_BLEND_MIN_ACCURACY      0.01f
+
 extern const AP_HAL::HAL &hal;
 
 // table of user settable parameters
@@ -61,8 +72,8 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
 
     // @Param: AUTO_SWITCH
     // @DisplayName: Automatic Switchover Setting
-    // @Description: Automatic switchover to GPS reporting best lock
-    // @Values: 0:Disabled,1:Enabled
+    // @Description: Automatic switchover to GPS reporting best lock. If set to 2 the receivers are blended into one solution weighted by their reported accuracies, falling back to switching when no accuracies are reported
+    // @Values: 0:Disabled,1:UseBest,2:UseBlend
     // @User: Advanced
     AP_GROUPINFO("AUTO_SWITCH", 3, AP_GPS, _auto_switch, 1),
 
@@ -153,6 +164,45 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("RATE_MS2", 15, AP_GPS, _rate_ms[1], 200),
 
+    // @Param: RAW_LOG
+    // @DisplayName: Raw stream logging
+    // @Description: Log the bytes received from these GPS instances unchanged in GRWS messages, for post processing of the raw uBlox stream. This takes a lot of log bandwidth when raw data is enabled.
+    // @Values: 0:Disabled,1:First GPS,2:Second GPS,3:Both
+    // @Bitmask: 0:First GPS,1:Second GPS
+    // @User: Advanced
+    AP_GROUPINFO("RAW_LOG", 16, AP_GPS, _raw_log, 0),
+
+    // @Param: DELAY_MS
+    // @DisplayName: GPS delay in milliseconds
+    // @Description: Controls the amount of GPS measurement delay that the autopilot compensates for. Set to zero to use the default of 200 msec.
+    // @Units: msec
+    // @Range: 0 250
+    // @User: Advanced
+    AP_GROUPINFO("DELAY_MS", 17, AP_GPS, _delay_ms[0], 0),
+
+    // @Param: DELAY_MS2
+    // @DisplayName: GPS 2 delay in milliseconds
+    // @Description: Controls the amount of GPS measurement delay that the autopilot compensates for. Set to zero to use the default of 200 msec.
+    // @Units: msec
+    // @Range: 0 250
+    // @User: Advanced
+    AP_GROUPINFO("DELAY_MS2", 18, AP_GPS, _delay_ms[1], 0),
+
+    // @Param: BLEND_MASK
+    // @DisplayName: Multi GPS Blending Mask
+    // @Description: Determines which of the accuracy measures Horizontal position, Vertical Position and Speed are used to calculate the weighting on each GPS receiver when GPS_AUTO_SWITCH is set to 2
+    // @Bitmask: 0:Horiz Pos,1:Vert Pos,2:Speed
+    // @User: Advanced
+    AP_GROUPINFO("BLEND_MASK", 19, AP_GPS, _blend_mask, 5),
+
+    // @Param: BLEND_TC
+    // @DisplayName: Blending time constant
+    // @Description: When a receiver joins or leaves the blend the output is held where it was and moved to the new solution over this time constant, so the navigation filter sees no step
+    // @Units: s
+    // @Range: 5.0 30.0
+    // @User: Advanced
+    AP_GROUPINFO("BLEND_TC", 20, AP_GPS, _blend_tc, 10.0f),
+
     AP_GROUPEND
 };
 
@@ -165,6 +215,7 @@ void AP_GPS::init(DataFlash_Class *dataflash, const AP_SerialManager& serial_man
     // search for serial ports with gps protocol
     _port[0] = serial_manager.find_serial(AP_SerialManager::SerialProtocol_GPS, 0);
     _port[1] = serial_manager.find_serial(AP_SerialManager::SerialProtocol_GPS, 1);
+    state[GPS_BLENDED_INSTANCE].instance = GPS_BLENDED_INSTANCE;
     _last_instance_swap_ms = 0;
 }
 
@@ -219,6 +270,7 @@ void AP_GPS::send_blob_update(uint8_t instance)
 void
 AP_GPS::detect_instance(uint8_t instance)
 {
+    AP_Alloc::Tag alloc_tag("GPS");
     AP_GPS_Backend *new_gps = NULL;
     struct detect_state *dstate = &detect_state[instance];
     uint32_t now = AP_HAL::millis();
@@ -251,16 +303,24 @@ AP_GPS::detect_instance(uint8_t instance)
     state[instance].hdop = 9999;
 
 	// by default the sbf/trimble gps outputs no data on its port, until configured.
+#if AP_GPS_SBF_ENABLED
 	if (_type[instance] == GPS_TYPE_SBF) {
 		_broadcast_gps_type("SBF", instance, -1); // baud rate isn't valid
 		new_gps = new AP_GPS_SBF(*this, state[instance], _port[instance]);
-	} else if ((_type[instance] == GPS_TYPE_GSOF)) {
+	}
+#endif
+#if AP_GPS_GSOF_ENABLED
+	if ((_type[instance] == GPS_TYPE_GSOF)) {
 		_broadcast_gps_type("GSOF", instance, -1); // baud rate isn't valid
 		new_gps = new AP_GPS_GSOF(*this, state[instance], _port[instance]);
-	} else if ((_type[instance] == GPS_TYPE_NOVA)) {
+	}
+#endif
+#if AP_GPS_NOVA_ENABLED
+	if ((_type[instance] == GPS_TYPE_NOVA)) {
 		_broadcast_gps_type("NOVA", instance, -1); // baud rate isn't valid
 		new_gps = new AP_GPS_NOVA(*this, state[instance], _port[instance]);
 	}
+#endif
 
     // record the time when we started detection. This is used to try
     // to avoid initialising a uBlox as a NMEA GPS
@@ -300,54 +360,76 @@ AP_GPS::detect_instance(uint8_t instance)
           the uBlox into 38400 no matter what rate it is configured
           for.
         */
+#if AP_GPS_UBLOX_ENABLED
         if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_UBLOX) &&
             _baudrates[dstate->current_baud] >= 38400 &&
             AP_GPS_UBLOX::_detect(dstate->ublox_detect_state, data)) {
             _broadcast_gps_type("u-blox", instance, dstate->current_baud);
             new_gps = new AP_GPS_UBLOX(*this, state[instance], _port[instance]);
-        } 
-		else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_MTK19) &&
-                 AP_GPS_MTK19::_detect(dstate->mtk19_detect_state, data)) {
-			_broadcast_gps_type("MTK19", instance, dstate->current_baud);
-			new_gps = new AP_GPS_MTK19(*this, state[instance], _port[instance]);
-		} 
-		else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_MTK) &&
-                 AP_GPS_MTK::_detect(dstate->mtk_detect_state, data)) {
-			_broadcast_gps_type("MTK", instance, dstate->current_baud);
-			new_gps = new AP_GPS_MTK(*this, state[instance], _port[instance]);
-		}
-        else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_SBP) &&
-                 AP_GPS_SBP::_detect(dstate->sbp_detect_state, data)) {
+            break;
+        }
+#endif
+#if AP_GPS_MTK19_ENABLED
+        if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_MTK19) &&
+            AP_GPS_MTK19::_detect(dstate->mtk19_detect_state, data)) {
+            _broadcast_gps_type("MTK19", instance, dstate->current_baud);
+            new_gps = new AP_GPS_MTK19(*this, state[instance], _port[instance]);
+            break;
+        }
+#endif
+#if AP_GPS_MTK_ENABLED
+        if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_MTK) &&
+            AP_GPS_MTK::_detect(dstate->mtk_detect_state, data)) {
+            _broadcast_gps_type("MTK", instance, dstate->current_baud);
+            new_gps = new AP_GPS_MTK(*this, state[instance], _port[instance]);
+            break;
+        }
+#endif
+#if AP_GPS_SBP_ENABLED
+        if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_SBP) &&
+            AP_GPS_SBP::_detect(dstate->sbp_detect_state, data)) {
             _broadcast_gps_type("SBP", instance, dstate->current_baud);
             new_gps = new AP_GPS_SBP(*this, state[instance], _port[instance]);
+            break;
         }
-		// save a bit of code space on a 1280
-		else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_SIRF) &&
-                 AP_GPS_SIRF::_detect(dstate->sirf_detect_state, data)) {
-			_broadcast_gps_type("SIRF", instance, dstate->current_baud);
-			new_gps = new AP_GPS_SIRF(*this, state[instance], _port[instance]);
-		}
-        else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_ERB) &&
-                 AP_GPS_ERB::_detect(dstate->erb_detect_state, data)) {
+#endif
+#if AP_GPS_SIRF_ENABLED
+        if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_SIRF) &&
+            AP_GPS_SIRF::_detect(dstate->sirf_detect_state, data)) {
+            _broadcast_gps_type("SIRF", instance, dstate->current_baud);
+            new_gps = new AP_GPS_SIRF(*this, state[instance], _port[instance]);
+            break;
+        }
+#endif
+#if AP_GPS_ERB_ENABLED
+        if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_ERB) &&
+            AP_GPS_ERB::_detect(dstate->erb_detect_state, data)) {
             _broadcast_gps_type("ERB", instance, dstate->current_baud);
             new_gps = new AP_GPS_ERB(*this, state[instance], _port[instance]);
+            break;
         }
+#endif
+#if AP_GPS_MAV_ENABLED
         // user has to explicitly set the MAV type, do not use AUTO
         // Do not try to detect the MAV type, assume it's there
-        else if (_type[instance] == GPS_TYPE_MAV) {
+        if (_type[instance] == GPS_TYPE_MAV) {
             _broadcast_gps_type("MAV", instance, dstate->current_baud);
             new_gps = new AP_GPS_MAV(*this, state[instance], NULL);
+            break;
         }
-		else if (now - dstate->detect_started_ms > (ARRAY_SIZE(_baudrates) * GPS_BAUD_TIME_MS)) {
-			// prevent false detection of NMEA mode in
-			// a MTK or UBLOX which has booted in NMEA mode
-			if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_NMEA) &&
-                AP_GPS_NMEA::_detect(dstate->nmea_detect_state, data)) {
-				_broadcast_gps_type("NMEA", instance, dstate->current_baud);
-				new_gps = new AP_GPS_NMEA(*this, state[instance], _port[instance]);
-			}
-		}
-	}
+#endif
+#if AP_GPS_NMEA_ENABLED
+        // prevent false detection of NMEA mode in
+        // a MTK or UBLOX which has booted in NMEA mode
+        if (now - dstate->detect_started_ms > (ARRAY_SIZE(_baudrates) * GPS_BAUD_TIME_MS) &&
+            (_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_NMEA) &&
+            AP_GPS_NMEA::_detect(dstate->nmea_detect_state, data)) {
+            _broadcast_gps_type("NMEA", instance, dstate->current_baud);
+            new_gps = new AP_GPS_NMEA(*this, state[instance], _port[instance]);
+            break;
+        }
+#endif
+    }
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_QURT
 found_gps:
@@ -362,7 +444,17 @@ found_gps:
 AP_GPS::GPS_Status 
 AP_GPS::highest_supported_status(uint8_t instance) const
 {
-    if (drivers[instance] != NULL)
+    if (instance == GPS_BLENDED_INSTANCE) {
+        // the blend is as good as the best receiver in it
+        GPS_Status highest = AP_GPS::GPS_OK_FIX_3D;
+        for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+            if (drivers[i] != NULL && drivers[i]->highest_supported_status() > highest) {
+                highest = drivers[i]->highest_supported_status();
+            }
+        }
+        return highest;
+    }
+    if (instance < GPS_MAX_RECEIVERS && drivers[instance] != NULL)
         return drivers[instance]->highest_supported_status();
     return AP_GPS::GPS_OK_FIX_3D;
 }
@@ -370,9 +462,7 @@ AP_GPS::highest_supported_status(uint8_t instance) const
 AP_GPS::GPS_Status 
 AP_GPS::highest_supported_status(void) const
 {
-    if (drivers[primary_instance] != NULL)
-        return drivers[primary_instance]->highest_supported_status();
-    return AP_GPS::GPS_OK_FIX_3D;
+    return highest_supported_status(primary_instance);
 }
 
 
@@ -432,6 +522,7 @@ AP_GPS::update_instance(uint8_t instance)
         if (state[instance].status >= GPS_OK_FIX_2D) {
             timing[instance].last_fix_time_ms = tnow;
         }
+        _state_topic[instance].publish(state[instance], tnow * 1000ULL);
     }
 }
 
@@ -441,15 +532,51 @@ AP_GPS::update_instance(uint8_t instance)
 void
 AP_GPS::update(void)
 {
-    for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
         update_instance(i);
     }
 
-    // work out which GPS is the primary, and how many sensors we have
-    for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+    // work out how many sensors we have
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
         if (state[i].status != NO_GPS) {
             num_instances = i+1;
         }
+    }
+
+    if (_auto_switch == 2 && calc_blend_weights()) {
+        calc_blended_state();
+        _state_topic[GPS_BLENDED_INSTANCE].publish(state[GPS_BLENDED_INSTANCE],
+                                                   timing[GPS_BLENDED_INSTANCE].last_message_time_ms * 1000ULL);
+        primary_instance = GPS_BLENDED_INSTANCE;
+    } else {
+        update_primary();
+    }
+
+	// update notify with gps status. We always base this on the primary_instance
+    AP_Notify::flags.gps_status = state[primary_instance].status;
+    AP_Notify::flags.gps_num_sats = state[primary_instance].num_sats;
+}
+
+/*
+  choose the receiver to use as primary when not blending
+ */
+void
+AP_GPS::update_primary(void)
+{
+    if (primary_instance == GPS_BLENDED_INSTANCE) {
+        // blending has stopped, carry on from the receiver that had
+        // the most weight in it
+        primary_instance = 0;
+        for (uint8_t i=1; i<GPS_MAX_RECEIVERS; i++) {
+            if (_blend_weights[i] > _blend_weights[primary_instance]) {
+                primary_instance = i;
+            }
+        }
+        _last_instance_swap_ms = AP_HAL::millis();
+    }
+    _blend_used = 0;
+
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
         if (_auto_switch) {            
             if (i == primary_instance) {
                 continue;
@@ -482,10 +609,6 @@ AP_GPS::update(void)
             primary_instance = 0;
         }
     }
-
-	// update notify with gps status. We always base this on the primary_instance
-    AP_Notify::flags.gps_status = state[primary_instance].status;
-    AP_Notify::flags.gps_num_sats = state[primary_instance].num_sats;
 }
 
 /*
@@ -515,7 +638,7 @@ AP_GPS::setHIL(uint8_t instance, GPS_Status _status, uint64_t time_epoch_ms,
                const Location &_location, const Vector3f &_velocity, uint8_t _num_sats, 
                uint16_t hdop)
 {
-    if (instance >= GPS_MAX_INSTANCES) {
+    if (instance >= GPS_MAX_RECEIVERS) {
         return;
     }
     uint32_t tnow = AP_HAL::millis();
@@ -564,7 +687,7 @@ void
 AP_GPS::lock_port(uint8_t instance, bool lock)
 {
 
-    if (instance >= GPS_MAX_INSTANCES) {
+    if (instance >= GPS_MAX_RECEIVERS) {
         return;
     }
     if (lock) {
@@ -580,18 +703,16 @@ AP_GPS::inject_data(uint8_t *data, uint8_t len)
 {
     //Support broadcasting to all GPSes.
     if (_inject_to == GPS_RTK_INJECT_TO_ALL) {
-        for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
-            inject_data(i, data, len);
-        }
-    } else {
-        inject_data(_inject_to, data, len);
+        inject_stream(data, len, (1U<<GPS_MAX_RECEIVERS)-1);
+    } else if (_inject_to >= 0 && _inject_to < GPS_MAX_RECEIVERS) {
+        inject_stream(data, len, 1U<<_inject_to);
     }
 }
 
 void 
 AP_GPS::inject_data(uint8_t instance, uint8_t *data, uint8_t len)
 {
-    if (instance < GPS_MAX_INSTANCES && drivers[instance] != NULL)
+    if (instance < GPS_MAX_RECEIVERS && drivers[instance] != NULL)
         drivers[instance]->inject_data(data, len);
 }  
 
@@ -677,7 +798,7 @@ AP_GPS::send_mavlink_gps2_rtk(mavlink_channel_t chan)
 uint8_t
 AP_GPS::first_unconfigured_gps(void) const
 {
-    for(int i = 0; i < GPS_MAX_INSTANCES; i++) {
+    for(int i = 0; i < GPS_MAX_RECEIVERS; i++) {
         if(_type[i] != GPS_TYPE_NONE && (drivers[i] == NULL || !drivers[i]->is_configured())) {
             return i;
         }
@@ -746,6 +867,14 @@ void AP_GPS::handle_gps_rtcm_data(const mavlink_message_t *msg)
     uint8_t fragment = (packet.flags >> 1U) & 0x03;
     uint8_t sequence = (packet.flags >> 3U) & 0x1F;
 
+    // a fragment we already hold is a resend, ignore it
+    if (rtcm_buffer->fragments_received &&
+        rtcm_buffer->sequence == sequence &&
+        (rtcm_buffer->fragments_received & (1U<<fragment)) &&
+        memcmp(&rtcm_buffer->buffer[MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN*(uint16_t)fragment], packet.data, packet.len) == 0) {
+        return;
+    }
+
     // see if this fragment is consistent with existing fragments
     if (rtcm_buffer->fragments_received &&
         (rtcm_buffer->sequence != sequence ||
@@ -790,11 +919,291 @@ void AP_GPS::handle_gps_rtcm_data(const mavlink_message_t *msg)
 */
 void AP_GPS::inject_data_all(const uint8_t *data, uint16_t len)
 {
-    uint8_t i;
-    for (i=0; i<num_instances; i++) {
-        if ((drivers[i] != NULL) && (_type[i] != GPS_TYPE_NONE)) {
+    uint8_t mask = 0;
+    for (uint8_t i=0; i<num_instances; i++) {
+        if (_type[i] != GPS_TYPE_NONE) {
+            mask |= 1U<<i;
+        }
+    }
+    inject_stream(data, len, mask);
+}
+
+/*
+  inject a block of correction data. Data that starts an RTCMv3 frame
+  or continues one is re-assembled so each receiver is written whole
+  frames, once each. Anything else, such as proprietary correction
+  formats or the tail of a frame we never saw the start of, is passed
+  straight through
+ */
+void AP_GPS::inject_stream(const uint8_t *data, uint16_t len, uint8_t instance_mask)
+{
+    if (len == 0) {
+        return;
+    }
+    if (data[0] != RTCM3_PREAMBLE && (rtcm3_parser == nullptr || !rtcm3_parser->in_frame())) {
+        inject_data_mask(data, len, instance_mask);
+        return;
+    }
+    if (rtcm3_parser == nullptr) {
+        rtcm3_parser = new RTCM3_Parser;
+        if (rtcm3_parser == nullptr) {
+            inject_data_mask(data, len, instance_mask);
+            return;
+        }
+    }
+    const uint32_t now_ms = AP_HAL::millis();
+    for (uint16_t i=0; i<len; i++) {
+        if (rtcm3_parser->read(data[i]) && !rtcm3_parser->is_duplicate(now_ms)) {
+            inject_data_mask(rtcm3_parser->frame(), rtcm3_parser->frame_length(), instance_mask);
+        }
+    }
+}
+
+void AP_GPS::inject_data_mask(const uint8_t *data, uint16_t len, uint8_t instance_mask)
+{
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if ((instance_mask & (1U<<i)) && drivers[i] != NULL) {
             drivers[i]->inject_data(data, len);
         }
     }
-    
+}
+
+/*
+  the expected lag (in seconds) in the position and velocity readings
+  from a GPS instance. The blended instance lags by the weighted lag of
+  its receivers
+ */
+float AP_GPS::get_lag(uint8_t instance) const
+{
+    if (instance == GPS_BLENDED_INSTANCE) {
+        return _blended_lag_sec;
+    }
+    if (instance >= GPS_MAX_RECEIVERS || _delay_ms[instance] <= 0) {
+        return 0.2f;
+    }
+    return _delay_ms[instance] * 0.001f;
+}
+
+/*
+  calculate the share of each receiver in the blended solution from
+  the inverse variance of the accuracies selected by GPS_BLEND_MASK.
+  Returns false if no receiver can be blended, leaving the previous
+  weights in place
+ */
+bool AP_GPS::calc_blend_weights(void)
+{
+    const uint32_t now = AP_HAL::millis();
+
+    // only receivers with a fresh 3D fix take part
+    bool usable[GPS_MAX_RECEIVERS];
+    bool any_usable = false;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        usable[i] = state[i].status >= GPS_OK_FIX_3D &&
+                    now - timing[i].last_message_time_ms < GPS_BLEND_TIMEOUT_MS;
+        any_usable |= usable[i];
+    }
+    if (!any_usable) {
+        return false;
+    }
+
+    float weights[GPS_MAX_RECEIVERS] {};
+    uint8_t num_measures = 0;
+    for (uint8_t m=0; m<3; m++) {
+        if (!(_blend_mask & (1U<<m))) {
+            continue;
+        }
+        // a measure is only used if every usable receiver reports it
+        float inv_var[GPS_MAX_RECEIVERS] {};
+        float inv_var_sum = 0.0f;
+        bool complete = true;
+        for (uint8_t i=0; i<GPS_MAX_RECEIVERS && complete; i++) {
+            if (!usable[i]) {
+                continue;
+            }
+            float acc = 0.0f;
+            switch (1U<<m) {
+            case GPS_BLEND_MASK_USE_HPOS:
+                complete = horizontal_accuracy(i, acc);
+                break;
+            case GPS_BLEND_MASK_USE_VPOS:
+                complete = vertical_accuracy(i, acc);
+                break;
+            case GPS_BLEND_MASK_USE_SPD:
+                complete = speed_accuracy(i, acc);
+                break;
+            }
+            acc = MAX(acc, GPS_BLEND_MIN_ACCURACY);
+            inv_var[i] = 1.0f / sq(acc);
+            inv_var_sum += inv_var[i];
+        }
+        if (!complete) {
+            continue;
+        }
+        for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+            weights[i] += inv_var[i] / inv_var_sum;
+        }
+        num_measures++;
+    }
+    if (num_measures == 0) {
+        return false;
+    }
+
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        _blend_weights[i] = weights[i] / num_measures;
+    }
+    return true;
+}
+
+/*
+  fill in the blended instance from the weighted receivers. Each
+  receiver's solution was measured its lag before the message arrived,
+  so solutions are moved along their velocity to a common time before
+  they are combined. When the set of receivers changes, the output is
+  held where it was and converges on the new blend over GPS_BLEND_TC
+ */
+void AP_GPS::calc_blended_state(void)
+{
+    GPS_State &blend = state[GPS_BLENDED_INSTANCE];
+    GPS_timing &blend_timing = timing[GPS_BLENDED_INSTANCE];
+    const uint32_t now = AP_HAL::millis();
+
+    // the output so far, from which a change of receivers is held
+    const uint8_t prev = primary_instance;
+    const bool prev_ok = state[prev].status >= GPS_OK_FIX_3D &&
+                         now - timing[prev].last_message_time_ms < GPS_BLEND_TIMEOUT_MS;
+
+    // the receiver with most weight is the reference for the offsets
+    uint8_t best = 0;
+    uint8_t used = 0;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (_blend_weights[i] > 0.0f) {
+            used |= 1U<<i;
+        }
+        if (_blend_weights[i] > _blend_weights[best]) {
+            best = i;
+        }
+    }
+
+    // the blend is valid at the newest message time less the blended lag
+    uint32_t newest_ms = timing[best].last_message_time_ms;
+    float lag_sec = 0.0f;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (!(used & (1U<<i))) {
+            continue;
+        }
+        if ((int32_t)(timing[i].last_message_time_ms - newest_ms) > 0) {
+            newest_ms = timing[i].last_message_time_ms;
+        }
+        lag_sec += _blend_weights[i] * get_lag(i);
+    }
+
+    const Location &ref = state[best].location;
+    Vector2f NE_m;
+    float alt_cm = 0.0f;
+    Vector3f velocity;
+    float hdop = 0.0f, vdop = 0.0f;
+    float hacc = 0.0f, vacc = 0.0f, sacc = 0.0f;
+    float dt_best = 0.0f;
+    blend.status = NO_FIX;
+    blend.num_sats = 0;
+    blend.have_vertical_velocity = true;
+    blend.have_horizontal_accuracy = true;
+    blend.have_vertical_accuracy = true;
+    blend.have_speed_accuracy = true;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (!(used & (1U<<i))) {
+            continue;
+        }
+        const GPS_State &istate = state[i];
+        const float w = _blend_weights[i];
+
+        // time from this receiver's measurement to the blend time
+        const float dt = (int32_t)(newest_ms - timing[i].last_message_time_ms) * 0.001f + get_lag(i) - lag_sec;
+        if (i == best) {
+            dt_best = dt;
+        }
+
+        Vector2f ne = location_diff(ref, istate.location);
+        ne.x += istate.velocity.x * dt;
+        ne.y += istate.velocity.y * dt;
+        NE_m += ne * w;
+        float dalt_cm = istate.location.alt - ref.alt;
+        if (istate.have_vertical_velocity) {
+            dalt_cm -= istate.velocity.z * dt * 100.0f;
+        }
+        alt_cm += dalt_cm * w;
+
+        velocity += istate.velocity * w;
+        hdop += istate.hdop * w;
+        vdop += istate.vdop * w;
+        hacc += istate.horizontal_accuracy * w;
+        vacc += istate.vertical_accuracy * w;
+        sacc += istate.speed_accuracy * w;
+
+        blend.status = MAX(blend.status, istate.status);
+        blend.num_sats = MAX(blend.num_sats, istate.num_sats);
+        blend.have_vertical_velocity &= istate.have_vertical_velocity;
+        blend.have_horizontal_accuracy &= istate.have_horizontal_accuracy;
+        blend.have_vertical_accuracy &= istate.have_vertical_accuracy;
+        blend.have_speed_accuracy &= istate.have_speed_accuracy;
+    }
+
+    Location raw = ref;
+    location_offset(raw, NE_m.x, NE_m.y);
+    raw.alt += alt_cm;
+
+    // decay the hold offset, then re-seat it if receivers came or went
+    const float tc = MAX(_blend_tc, 0.1f);
+    const float decay = expf(-constrain_float((now - _last_blend_ms) * 0.001f, 0.0f, tc) / tc);
+    _blend_NE_offset_m *= decay;
+    _blend_alt_offset_cm *= decay;
+    if (used != _blend_used) {
+        // the previous output, moved forward to the blend time
+        const float dt = (int32_t)(newest_ms - timing[prev].last_message_time_ms) * 0.001f + get_lag(prev) - lag_sec;
+        if (prev_ok) {
+            Location held = state[prev].location;
+            location_offset(held, state[prev].velocity.x * dt, state[prev].velocity.y * dt);
+            _blend_NE_offset_m = location_diff(raw, held);
+            _blend_alt_offset_cm = held.alt - raw.alt;
+            if (state[prev].have_vertical_velocity) {
+                _blend_alt_offset_cm -= state[prev].velocity.z * dt * 100.0f;
+            }
+        } else {
+            _blend_NE_offset_m.zero();
+            _blend_alt_offset_cm = 0.0f;
+        }
+        _blend_used = used;
+    }
+    _last_blend_ms = now;
+
+    blend.location = raw;
+    location_offset(blend.location, _blend_NE_offset_m.x, _blend_NE_offset_m.y);
+    blend.location.alt += _blend_alt_offset_cm;
+
+    blend.velocity = velocity;
+    blend.ground_speed = norm(velocity.x, velocity.y);
+    blend.ground_course = wrap_360(degrees(atan2f(velocity.y, velocity.x)));
+    blend.hdop = hdop;
+    blend.vdop = vdop;
+    blend.horizontal_accuracy = hacc;
+    blend.vertical_accuracy = vacc;
+    blend.speed_accuracy = sacc;
+
+    // GPS time of the reference receiver, moved to the blend time
+    const uint32_t week_ms = 7 * 86400 * 1000UL;
+    int32_t time_week_ms = state[best].time_week_ms + (int32_t)(dt_best * 1000.0f);
+    blend.time_week = state[best].time_week;
+    if (time_week_ms < 0) {
+        time_week_ms += week_ms;
+        blend.time_week--;
+    } else if ((uint32_t)time_week_ms >= week_ms) {
+        time_week_ms -= week_ms;
+        blend.time_week++;
+    }
+    blend.time_week_ms = time_week_ms;
+    blend.last_gps_time_ms = state[best].last_gps_time_ms;
+
+    blend_timing.last_message_time_ms = newest_ms;
+    blend_timing.last_fix_time_ms = newest_ms;
+    _blended_lag_sec = lag_sec;
 }
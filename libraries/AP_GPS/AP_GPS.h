@@ -15,6 +15,7 @@
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/SensorTopic.h>
 #include <inttypes.h>
 #include <AP_Common/AP_Common.h>
 #include <AP_Param/AP_Param.h>
@@ -22,13 +23,56 @@
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Vehicle/AP_Vehicle.h>
 #include "GPS_detect_state.h"
+#include "RTCM3_Parser.h"
 #include <AP_SerialManager/AP_SerialManager.h>
 
+/*
+  GPS drivers built into the firmware. A board can leave a driver out
+  by defining AP_GPS_<DRIVER>_ENABLED to 0, for example with the
+  --disable-drivers waf option
+ */
+#ifndef AP_GPS_UBLOX_ENABLED
+#define AP_GPS_UBLOX_ENABLED 1
+#endif
+#ifndef AP_GPS_MTK19_ENABLED
+#define AP_GPS_MTK19_ENABLED 1
+#endif
+#ifndef AP_GPS_MTK_ENABLED
+#define AP_GPS_MTK_ENABLED 1
+#endif
+#ifndef AP_GPS_SBP_ENABLED
+#define AP_GPS_SBP_ENABLED 1
+#endif
+#ifndef AP_GPS_SIRF_ENABLED
+#define AP_GPS_SIRF_ENABLED 1
+#endif
+#ifndef AP_GPS_ERB_ENABLED
+#define AP_GPS_ERB_ENABLED 1
+#endif
+#ifndef AP_GPS_NMEA_ENABLED
+#define AP_GPS_NMEA_ENABLED 1
+#endif
+#ifndef AP_GPS_SBF_ENABLED
+#define AP_GPS_SBF_ENABLED 1
+#endif
+#ifndef AP_GPS_GSOF_ENABLED
+#define AP_GPS_GSOF_ENABLED 1
+#endif
+#ifndef AP_GPS_NOVA_ENABLED
+#define AP_GPS_NOVA_ENABLED 1
+#endif
+#ifndef AP_GPS_MAV_ENABLED
+#define AP_GPS_MAV_ENABLED 1
+#endif
+
 /**
-   maximum number of GPS instances available on this platform. If more
+   maximum number of GPS receivers available on this platform. If more
    than 1 then redundent sensors may be available
  */
-#define GPS_MAX_INSTANCES 2
+#define GPS_MAX_RECEIVERS 2
+// the receivers plus the blended instance, which follows them
+#define GPS_MAX_INSTANCES (GPS_MAX_RECEIVERS + 1)
+#define GPS_BLENDED_INSTANCE GPS_MAX_RECEIVERS
 #define GPS_RTK_INJECT_TO_ALL 127
 
 class DataFlash_Class;
@@ -163,6 +207,12 @@ public:
         return location(primary_instance);
     }
 
+    // whole state as of each message received, stamped with the
+    // system time it arrived, for readers on other threads
+    const SensorTopic<GPS_State> &get_state_topic(uint8_t instance) const {
+        return _state_topic[instance];
+    }
+
     bool speed_accuracy(uint8_t instance, float &sacc) const {
         if(state[instance].have_speed_accuracy) {
             sacc = state[instance].speed_accuracy;
@@ -310,7 +360,15 @@ public:
     }
 
     // the expected lag (in seconds) in the position and velocity readings from the gps
-    float get_lag() const { return 0.2f; }
+    float get_lag(uint8_t instance) const;
+    float get_lag(void) const {
+        return get_lag(primary_instance);
+    }
+
+    // true if the primary instance is the blend of the receivers
+    bool output_is_blended(void) const {
+        return primary_instance == GPS_BLENDED_INSTANCE;
+    }
 
     // set position for HIL
     void setHIL(uint8_t instance, GPS_Status status, uint64_t time_epoch_ms, 
@@ -326,7 +384,7 @@ public:
     DataFlash_Class *_DataFlash;
 
     // configuration parameters
-    AP_Int8 _type[GPS_MAX_INSTANCES];
+    AP_Int8 _type[GPS_MAX_RECEIVERS];
     AP_Int8 _navfilter;
     AP_Int8 _auto_switch;
     AP_Int8 _min_dgps;
@@ -336,10 +394,14 @@ public:
     AP_Int8 _sbas_mode;
     AP_Int8 _min_elevation;
     AP_Int8 _raw_data;
+    AP_Int8 _raw_log;
     AP_Int8 _gnss_mode[2];
     AP_Int16 _rate_ms[2];
     AP_Int8 _save_config;
     AP_Int8 _auto_config;
+    AP_Int16 _delay_ms[GPS_MAX_RECEIVERS];
+    AP_Int8 _blend_mask;
+    AP_Float _blend_tc;
     
     // handle sending of initialisation strings to the GPS
     void send_blob_start(uint8_t instance, const char *_blob, uint16_t size);
@@ -373,8 +435,9 @@ private:
     };
     GPS_timing timing[GPS_MAX_INSTANCES];
     GPS_State state[GPS_MAX_INSTANCES];
-    AP_GPS_Backend *drivers[GPS_MAX_INSTANCES];
-    AP_HAL::UARTDriver *_port[GPS_MAX_INSTANCES];
+    SensorTopic<GPS_State> _state_topic[GPS_MAX_INSTANCES];
+    AP_GPS_Backend *drivers[GPS_MAX_RECEIVERS];
+    AP_HAL::UARTDriver *_port[GPS_MAX_RECEIVERS];
 
     /// primary GPS instance
     uint8_t primary_instance:2;
@@ -397,12 +460,12 @@ private:
         struct NMEA_detect_state nmea_detect_state;
         struct SBP_detect_state sbp_detect_state;
         struct ERB_detect_state erb_detect_state;
-    } detect_state[GPS_MAX_INSTANCES];
+    } detect_state[GPS_MAX_RECEIVERS];
 
     struct {
         const char *blob;
         uint16_t remaining;
-    } initblob_state[GPS_MAX_INSTANCES];
+    } initblob_state[GPS_MAX_RECEIVERS];
 
     static const uint32_t  _baudrates[];
     static const char _initialisation_blob[];
@@ -410,6 +473,22 @@ private:
 
     void detect_instance(uint8_t instance);
     void update_instance(uint8_t instance);
+    void update_primary(void);
+
+    // blending of the receivers into GPS_BLENDED_INSTANCE
+    bool calc_blend_weights(void);
+    void calc_blended_state(void);
+
+    // share of each receiver in the blended solution, zero if unused
+    float _blend_weights[GPS_MAX_RECEIVERS];
+    // receivers used in the last blend, one bit per receiver
+    uint8_t _blend_used;
+    float _blended_lag_sec = 0.2f;
+    // offset of the blended output from the raw blend, added when the
+    // set of blended receivers changes and decayed over _blend_tc
+    Vector2f _blend_NE_offset_m;
+    float _blend_alt_offset_cm;
+    uint32_t _last_blend_ms;
     void _broadcast_gps_type(const char *type, uint8_t instance, int8_t baud_index);
 
     /*
@@ -437,6 +516,18 @@ private:
 
     // ibject data into all backends
     void inject_data_all(const uint8_t *data, uint16_t len);
+
+    /*
+      re-assembly of RTCMv3 frames from injected data, allocated on
+      first use. Complete frames are written once to each target
+      receiver from the parser buffer, so receivers never see a
+      partial frame and duplicates are only sent once
+     */
+    RTCM3_Parser *rtcm3_parser;
+
+    // inject a block of correction data into the receivers in the mask
+    void inject_stream(const uint8_t *data, uint16_t len, uint8_t instance_mask);
+    void inject_data_mask(const uint8_t *data, uint16_t len, uint8_t instance_mask);
 };
 
 #define GPS_BAUD_TIME_MS 1200
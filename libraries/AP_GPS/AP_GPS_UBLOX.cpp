@@ -326,6 +326,9 @@ AP_GPS_UBLOX::read(void)
     int16_t numc;
     bool parsed = false;
     uint32_t millis_now = AP_HAL::millis();
+    uint8_t chunk[UBLOX_READ_CHUNK];
+    uint16_t chunk_len = 0;
+    uint16_t chunk_ofs = 0;
 
     // walk through the gps configuration at 1 message per second
     if (millis_now - _last_config_time >= _delay_time) {
@@ -355,8 +358,38 @@ AP_GPS_UBLOX::read(void)
     numc = port->available();
     for (int16_t i = 0; i < numc; i++) {        // Process bytes received
 
+        // read in bulk rather than a virtual call per byte
+        if (chunk_ofs == chunk_len) {
+            chunk_len = port->read(chunk, MIN((uint16_t)(numc - i), sizeof(chunk)));
+            chunk_ofs = 0;
+            if (chunk_len == 0) {
+                break;
+            }
+            if (gps._raw_log & (1U << state.instance)) {
+                log_raw_stream(chunk, chunk_len);
+            }
+        }
+
         // read the next byte
-        data = port->read();
+        data = chunk[chunk_ofs++];
+
+        // Receive message data
+        //
+        // Payload bytes don't change the state until the last one, so
+        // take all of them that are in the chunk at once
+        if (_step == 6) {
+            const uint16_t run = MIN((uint16_t)(_payload_length - _payload_counter),
+                                     (uint16_t)(chunk_len - chunk_ofs + 1));
+            memcpy(&_buffer[_payload_counter], &chunk[chunk_ofs - 1], run);
+            _update_checksum(&chunk[chunk_ofs - 1], run, _ck_a, _ck_b);
+            _payload_counter += run;
+            chunk_ofs += run - 1;
+            i += run - 1;
+            if (_payload_counter == _payload_length) {
+                _step++;
+            }
+            continue;
+        }
 
 	reset:
         switch(_step) {
@@ -420,17 +453,9 @@ AP_GPS_UBLOX::read(void)
 				goto reset;
             }
             _payload_counter = 0;                               // prepare to receive payload
-            break;
-
-        // Receive message data
-        //
-        case 6:
-            _ck_b += (_ck_a += data);                   // checksum byte
-            if (_payload_counter < sizeof(_buffer)) {
-                _buffer[_payload_counter] = data;
+            if (_payload_length == 0) {
+                _step++;                                        // no payload, straight to the checksum
             }
-            if (++_payload_counter == _payload_length)
-                _step++;
             break;
 
         // Checksum and message processing
@@ -501,6 +526,23 @@ void AP_GPS_UBLOX::log_mon_hw2(void)
     gps._DataFlash->WriteBlock(&pkt, sizeof(pkt));
 }
 
+void AP_GPS_UBLOX::log_raw_stream(const uint8_t *data, uint8_t len)
+{
+    if (gps._DataFlash == NULL || !gps._DataFlash->logging_started()) {
+        return;
+    }
+
+    len = MIN(len, (uint8_t)UBLOX_READ_CHUNK);
+    struct log_GPS_RAW_STREAM pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_GPS_RAW_STREAM_MSG),
+        time_us   : AP_HAL::micros64(),
+        instance  : state.instance,
+        length    : len,
+    };
+    memcpy(pkt.data, data, len);
+    gps._DataFlash->WriteBlock(&pkt, sizeof(pkt));
+}
+
 #if UBLOX_RXM_RAW_LOGGING
 void AP_GPS_UBLOX::log_rxm_raw(const struct ubx_rxm_raw &raw)
 {
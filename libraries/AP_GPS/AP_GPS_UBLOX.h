@@ -48,6 +48,9 @@
 #define UBX_MSG_TYPES 2
 
 #define UBLOX_MAX_PORTS 6
+
+// bytes read from the port at once, also the most logged per GRWS message
+#define UBLOX_READ_CHUNK 64
 #define MINIMUM_MEASURE_RATE_MS 200
 
 #define RATE_POSLLH 1
@@ -529,6 +532,7 @@ private:
     void log_mon_ver(void);
     void log_rxm_raw(const struct ubx_rxm_raw &raw);
     void log_rxm_rawx(const struct ubx_rxm_rawx &raw);
+    void log_raw_stream(const uint8_t *data, uint8_t len);
 
     // Calculates the correct log message ID based on what GPS instance is being logged
     uint8_t _ubx_msg_log_index(uint8_t ubx_msg) {
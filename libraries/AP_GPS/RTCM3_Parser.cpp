@@ -0,0 +1,105 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  RTCMv3 frame re-assembly for GPS correction injection
+ */
+
+#include "RTCM3_Parser.h"
+
+bool RTCM3_Parser::read(uint8_t byte)
+{
+    if (_pos == 0 && byte != RTCM3_PREAMBLE) {
+        return false;
+    }
+    if (_pos == 1 && (byte & 0xFC) != 0) {
+        // the reserved bits must be zero, so this was not a
+        // preamble. This rejects most stray 0xD3 bytes before they can
+        // swallow the frames that follow
+        _pos = 0;
+        if (byte != RTCM3_PREAMBLE) {
+            return false;
+        }
+    }
+
+    _buffer[_pos++] = byte;
+
+    if (_pos == RTCM3_HEADER_LEN) {
+        const uint16_t payload_length = ((_buffer[1] & 0x03) << 8) | _buffer[2];
+        _frame_length = RTCM3_HEADER_LEN + payload_length + RTCM3_CRC_LEN;
+    }
+    if (_pos < RTCM3_HEADER_LEN || _pos < _frame_length) {
+        return false;
+    }
+
+    // frame complete
+    _pos = 0;
+    const uint16_t crc_ofs = _frame_length - RTCM3_CRC_LEN;
+    const uint32_t crc = ((uint32_t)_buffer[crc_ofs] << 16) |
+                         ((uint32_t)_buffer[crc_ofs+1] << 8) |
+                         _buffer[crc_ofs+2];
+    if (crc != crc24q(_buffer, crc_ofs)) {
+        _crc_errors++;
+        return false;
+    }
+    return true;
+}
+
+// message number, the first 12 bits of the payload
+uint16_t RTCM3_Parser::message_type() const
+{
+    if (_frame_length < RTCM3_HEADER_LEN + 2 + RTCM3_CRC_LEN) {
+        return 0;
+    }
+    return ((uint16_t)_buffer[3] << 4) | (_buffer[4] >> 4);
+}
+
+bool RTCM3_Parser::is_duplicate(uint32_t now_ms)
+{
+    const uint16_t crc_ofs = _frame_length - RTCM3_CRC_LEN;
+    // the CRC is a good enough identity for frames this close in time
+    const uint32_t crc = ((uint32_t)_buffer[crc_ofs] << 16) |
+                         ((uint32_t)_buffer[crc_ofs+1] << 8) |
+                         _buffer[crc_ofs+2];
+    for (uint8_t i=0; i<RTCM3_DEDUP_ENTRIES; i++) {
+        if (_recent[i].time_ms != 0 &&
+            _recent[i].crc == crc &&
+            now_ms - _recent[i].time_ms < RTCM3_DEDUP_MS) {
+            return true;
+        }
+    }
+    _recent[_recent_next].crc = crc;
+    // zero marks an unused entry
+    _recent[_recent_next].time_ms = now_ms ? now_ms : 1;
+    _recent_next = (_recent_next + 1) % RTCM3_DEDUP_ENTRIES;
+    return false;
+}
+
+/*
+  CRC-24Q as used by RTCMv3, polynomial 0x1864CFB
+ */
+uint32_t RTCM3_Parser::crc24q(const uint8_t *bytes, uint16_t len)
+{
+    uint32_t crc = 0;
+    while (len--) {
+        crc ^= ((uint32_t)*bytes++) << 16;
+        for (uint8_t i=0; i<8; i++) {
+            crc <<= 1;
+            if (crc & 0x1000000) {
+                crc ^= 0x1864CFB;
+            }
+        }
+    }
+    return crc & 0xFFFFFF;
+}
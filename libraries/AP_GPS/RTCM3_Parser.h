@@ -0,0 +1,76 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define RTCM3_PREAMBLE      0xD3
+#define RTCM3_HEADER_LEN    3
+#define RTCM3_CRC_LEN       3
+#define RTCM3_MAX_PAYLOAD   1023
+#define RTCM3_MAX_FRAME     (RTCM3_HEADER_LEN + RTCM3_MAX_PAYLOAD + RTCM3_CRC_LEN)
+
+// identical frames arriving within this time are dropped as duplicates
+#define RTCM3_DEDUP_MS      500
+#define RTCM3_DEDUP_ENTRIES 8
+
+/*
+  re-assemble RTCMv3 frames from a stream of injected correction data,
+  which may be split at any point. A frame is a 0xD3 preamble, 6 zero
+  bits, a 10 bit payload length, the payload and a CRC-24Q over all of
+  the preceding bytes. Frames with a bad CRC are dropped.
+
+  Bytes before a preamble are discarded, so callers should only feed
+  data that starts with a preamble or continues a frame (see
+  in_frame()) and pass anything else to the receivers untouched.
+ */
+class RTCM3_Parser {
+public:
+    // add a byte, returns true when it completes a frame with a good CRC
+    bool read(uint8_t byte);
+
+    // true if a partial frame is buffered
+    bool in_frame() const { return _pos != 0; }
+
+    // drop any partial frame
+    void reset() { _pos = 0; }
+
+    // the last complete frame, valid until the next call to read()
+    const uint8_t *frame() const { return _buffer; }
+    uint16_t frame_length() const { return _frame_length; }
+    uint16_t message_type() const;
+
+    // returns true if the last complete frame is identical to one
+    // returned within RTCM3_DEDUP_MS, otherwise records it and returns
+    // false. This drops the copies arriving when the ground station
+    // sends the same corrections over more than one link
+    bool is_duplicate(uint32_t now_ms);
+
+    uint32_t crc_errors() const { return _crc_errors; }
+
+    static uint32_t crc24q(const uint8_t *bytes, uint16_t len);
+
+private:
+    uint8_t _buffer[RTCM3_MAX_FRAME];
+    uint16_t _pos;
+    uint16_t _frame_length;
+    uint32_t _crc_errors;
+
+    struct {
+        uint32_t crc;
+        uint32_t time_ms;
+    } _recent[RTCM3_DEDUP_ENTRIES];
+    uint8_t _recent_next;
+};
@@ -0,0 +1,957 @@
+#include <AP_gbenchmark.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/edc.h>
+#include <AP_GPS/AP_GPS.h>
+#include <AP_GPS/AP_GPS_ERB.h>
+#include <AP_GPS/AP_GPS_GSOF.h>
+#include <AP_GPS/AP_GPS_NMEA.h>
+#include <AP_GPS/AP_GPS_NOVA.h>
+#include <AP_GPS/AP_GPS_SBF.h>
+#include <AP_GPS/AP_GPS_SBP.h>
+#include <AP_GPS/AP_GPS_UBLOX.h>
+
+/*
+  replay a recorded byte stream through the read() of each protocol
+  driver, one navigation epoch per call as the driver would see it
+  when polled by AP_GPS::update(). Bytes per second gives the cost per
+  byte and items per second the cost per fix returned by read().
+
+  The recordings are encoded here the same way the SITL GPS
+  simulation encodes them, for a vehicle circling at 15m/s with a
+  solution every 100ms. Each benchmark pass replays the whole
+  recording into a freshly constructed driver, as the time of week in
+  the recording restarts with every pass.
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define RECORDING_EPOCHS    100
+#define RECORDING_MAX_BYTES 0x40000
+
+// a recorded stream, with the offset of the end of each epoch
+class Recording {
+public:
+    void clear() {
+        len = 0;
+        epochs = 0;
+    }
+
+    void add(const void *data, uint16_t n) {
+        if (len + n <= sizeof(bytes)) {
+            memcpy(&bytes[len], data, n);
+            len += n;
+        }
+    }
+
+    void add_byte(uint8_t b) {
+        add(&b, 1);
+    }
+
+    void end_epoch() {
+        if (epochs < RECORDING_EPOCHS) {
+            epoch_end[epochs++] = len;
+        }
+    }
+
+    uint8_t bytes[RECORDING_MAX_BYTES];
+    uint32_t len;
+    uint32_t epoch_end[RECORDING_EPOCHS];
+    uint16_t epochs;
+};
+
+static Recording recording;
+
+/*
+  UART handing out the bytes of one epoch of a recording. Anything the
+  drivers send to configure the receiver is dropped
+ */
+class ReplayUART : public AP_HAL::UARTDriver {
+public:
+    void set_data(const uint8_t *data, uint32_t len) {
+        _data = data;
+        _len = len;
+        _ofs = 0;
+    }
+
+    void begin(uint32_t baud) override {}
+    void begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) override {}
+    void end() override {}
+    void flush() override {}
+    bool is_initialized() override { return true; }
+    void set_blocking_writes(bool blocking) override {}
+    bool tx_pending() override { return false; }
+
+    uint32_t available() override { return _len - _ofs; }
+    uint32_t txspace() override { return 1024; }
+
+    int16_t read() override {
+        if (_ofs >= _len) {
+            return -1;
+        }
+        return _data[_ofs++];
+    }
+
+    uint16_t read(uint8_t *buffer, uint16_t count) override {
+        const uint16_t n = MIN((uint32_t)count, _len - _ofs);
+        memcpy(buffer, &_data[_ofs], n);
+        _ofs += n;
+        return n;
+    }
+    using AP_HAL::UARTDriver::read;
+
+    size_t write(uint8_t c) override { return 1; }
+    size_t write(const uint8_t *buffer, size_t size) override { return size; }
+
+private:
+    const uint8_t *_data;
+    uint32_t _len;
+    uint32_t _ofs;
+};
+
+// solution reported in each epoch of a recording
+struct Fix {
+    uint16_t week;
+    uint32_t tow_ms;
+    double lat;     // degrees
+    double lng;     // degrees
+    double alt;     // metres
+    float vn;       // m/s
+    float ve;
+    float vd;
+};
+
+static void trajectory(uint16_t epoch, Fix &f)
+{
+    const float t = epoch * 0.1f;
+    f.week = 1900;
+    f.tow_ms = 345600000UL + epoch * 100UL;
+    f.lat = -35.363261 + 0.0005 * sin(t * 0.1);
+    f.lng = 149.165230 + 0.0005 * cos(t * 0.1);
+    f.alt = 584.0 + 0.1 * t;
+    f.vn = 15.0f * cosf(t * 0.1f);
+    f.ve = -15.0f * sinf(t * 0.1f);
+    f.vd = -0.1f;
+}
+
+static float ground_course_deg(const Fix &f)
+{
+    return wrap_360(degrees(atan2f(f.ve, f.vn)));
+}
+
+/*
+  UBX and ERB frames: two preamble bytes, message id (and class for
+  UBX), little endian length, payload and a Fletcher checksum over
+  everything after the preamble
+ */
+static void fletcher_frame(const uint8_t *header, uint8_t header_len, const void *payload, uint16_t len)
+{
+    uint8_t ck_a = 0, ck_b = 0;
+    for (uint8_t i=2; i<header_len; i++) {
+        ck_b += (ck_a += header[i]);
+    }
+    for (uint16_t i=0; i<len; i++) {
+        ck_b += (ck_a += ((const uint8_t *)payload)[i]);
+    }
+    recording.add(header, header_len);
+    recording.add(payload, len);
+    recording.add_byte(ck_a);
+    recording.add_byte(ck_b);
+}
+
+static void ubx_message(uint8_t msg_class, uint8_t msg_id, const void *payload, uint16_t len)
+{
+    const uint8_t header[6] { 0xb5, 0x62, msg_class, msg_id, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+    fletcher_frame(header, sizeof(header), payload, len);
+}
+
+static void erb_message(uint8_t msg_id, const void *payload, uint16_t len)
+{
+    const uint8_t header[5] { 0x45, 0x52, msg_id, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+    fletcher_frame(header, sizeof(header), payload, len);
+}
+
+/*
+  u-blox NAV solution messages, followed by an RXM-RAWX message with
+  raw_sats measurements when raw_sats is not zero. RAWX goes through
+  the whole framing and checksum path but is not logged, as GPS_RAW_DATA
+  is off
+ */
+static void record_ubx(uint8_t raw_sats)
+{
+    struct PACKED {
+        uint32_t time;
+        int32_t longitude;
+        int32_t latitude;
+        int32_t altitude_ellipsoid;
+        int32_t altitude_msl;
+        uint32_t horizontal_accuracy;
+        uint32_t vertical_accuracy;
+    } pos;
+    struct PACKED {
+        uint32_t time;
+        uint8_t fix_type;
+        uint8_t fix_status;
+        uint8_t differential_status;
+        uint8_t res;
+        uint32_t time_to_first_fix;
+        uint32_t uptime;
+    } status;
+    struct PACKED {
+        uint32_t time;
+        int32_t ned_north;
+        int32_t ned_east;
+        int32_t ned_down;
+        uint32_t speed_3d;
+        uint32_t speed_2d;
+        int32_t heading_2d;
+        uint32_t speed_accuracy;
+        uint32_t heading_accuracy;
+    } velned;
+    struct PACKED {
+        uint32_t time;
+        int32_t time_nsec;
+        int16_t week;
+        uint8_t fix_type;
+        uint8_t fix_status;
+        int32_t ecef_x;
+        int32_t ecef_y;
+        int32_t ecef_z;
+        uint32_t position_accuracy_3d;
+        int32_t ecef_x_velocity;
+        int32_t ecef_y_velocity;
+        int32_t ecef_z_velocity;
+        uint32_t speed_accuracy;
+        uint16_t position_DOP;
+        uint8_t res;
+        uint8_t satellites;
+        uint32_t res2;
+    } sol;
+    struct PACKED {
+        uint32_t time;
+        uint16_t gDOP;
+        uint16_t pDOP;
+        uint16_t tDOP;
+        uint16_t vDOP;
+        uint16_t hDOP;
+        uint16_t nDOP;
+        uint16_t eDOP;
+    } dop;
+    struct PACKED {
+        double rcvTow;
+        uint16_t week;
+        int8_t leapS;
+        uint8_t numMeas;
+        uint8_t recStat;
+        uint8_t reserved1[3];
+        struct PACKED {
+            double prMes;
+            double cpMes;
+            float doMes;
+            uint8_t gnssId;
+            uint8_t svId;
+            uint8_t reserved2;
+            uint8_t freqId;
+            uint16_t locktime;
+            uint8_t cno;
+            uint8_t prStdev;
+            uint8_t cpStdev;
+            uint8_t doStdev;
+            uint8_t trkStat;
+            uint8_t reserved3;
+        } sv[32];
+    } rawx;
+
+    raw_sats = MIN(raw_sats, ARRAY_SIZE(rawx.sv));
+
+    recording.clear();
+    for (uint16_t i=0; i<RECORDING_EPOCHS; i++) {
+        Fix f;
+        trajectory(i, f);
+
+        memset(&pos, 0, sizeof(pos));
+        pos.time = f.tow_ms;
+        pos.longitude = f.lng * 1.0e7;
+        pos.latitude = f.lat * 1.0e7;
+        pos.altitude_ellipsoid = f.alt * 1000;
+        pos.altitude_msl = f.alt * 1000;
+        pos.horizontal_accuracy = 1500;
+        pos.vertical_accuracy = 2000;
+
+        memset(&status, 0, sizeof(status));
+        status.time = f.tow_ms;
+        status.fix_type = 3;
+        status.fix_status = 1;
+
+        memset(&velned, 0, sizeof(velned));
+        velned.time = f.tow_ms;
+        velned.ned_north = f.vn * 100;
+        velned.ned_east = f.ve * 100;
+        velned.ned_down = f.vd * 100;
+        velned.speed_2d = norm(f.vn, f.ve) * 100;
+        velned.speed_3d = norm(f.vn, f.ve, f.vd) * 100;
+        velned.heading_2d = ground_course_deg(f) * 100000;
+        velned.speed_accuracy = 40;
+        velned.heading_accuracy = 4;
+
+        memset(&sol, 0, sizeof(sol));
+        sol.time = f.tow_ms;
+        sol.week = f.week;
+        sol.fix_type = 3;
+        sol.fix_status = 221;
+        sol.satellites = 12;
+
+        memset(&dop, 0, sizeof(dop));
+        dop.time = f.tow_ms;
+        dop.vDOP = 200;
+        dop.hDOP = 121;
+
+        ubx_message(0x01, 0x02, &pos, sizeof(pos));
+        ubx_message(0x01, 0x03, &status, sizeof(status));
+        ubx_message(0x01, 0x12, &velned, sizeof(velned));
+        ubx_message(0x01, 0x06, &sol, sizeof(sol));
+        ubx_message(0x01, 0x04, &dop, sizeof(dop));
+
+        if (raw_sats > 0) {
+            memset(&rawx, 0, sizeof(rawx));
+            rawx.rcvTow = f.tow_ms * 0.001;
+            rawx.week = f.week;
+            rawx.numMeas = raw_sats;
+            for (uint8_t s=0; s<raw_sats; s++) {
+                rawx.sv[s].prMes = 2.0e7 + s * 1.0e5 + i * 1.5;
+                rawx.sv[s].cpMes = 1.05e8 + s * 5.0e5 + i * 7.9;
+                rawx.sv[s].doMes = 500.0f - s * 40;
+                rawx.sv[s].svId = s + 1;
+                rawx.sv[s].locktime = 64500;
+                rawx.sv[s].cno = 40 + (s & 7);
+                rawx.sv[s].trkStat = 0x07;
+            }
+            ubx_message(0x02, 0x15, &rawx, 16 + raw_sats * sizeof(rawx.sv[0]));
+        }
+        recording.end_epoch();
+    }
+}
+
+static void nmea_printf(const char *fmt, ...) FMT_PRINTF(1, 2);
+static void nmea_printf(const char *fmt, ...)
+{
+    char s[120];
+    va_list ap;
+    va_start(ap, fmt);
+    const int n = vsnprintf(s, sizeof(s) - 5, fmt, ap);
+    va_end(ap);
+    if (n <= 0 || n >= (int)sizeof(s) - 5) {
+        return;
+    }
+    uint8_t csum = 0;
+    for (int i=1; i<n; i++) {
+        csum ^= s[i];
+    }
+    snprintf(&s[n], 6, "*%02X\r\n", (unsigned)csum);
+    recording.add(s, n + 5);
+}
+
+// NMEA GGA and RMC sentences with an RTK fixed solution
+static void record_nmea(void)
+{
+    recording.clear();
+    for (uint16_t i=0; i<RECORDING_EPOCHS; i++) {
+        Fix f;
+        trajectory(i, f);
+
+        const uint32_t day_ms = f.tow_ms % 86400000UL;
+        char tstring[20];
+        snprintf(tstring, sizeof(tstring), "%02u%02u%05.2f",
+                 (unsigned)(day_ms / 3600000UL),
+                 (unsigned)((day_ms / 60000UL) % 60),
+                 (day_ms % 60000UL) * 0.001);
+
+        char lat_string[20];
+        double deg = fabs(f.lat);
+        snprintf(lat_string, sizeof(lat_string), "%02u%08.5f,%c",
+                 (unsigned)deg, (deg - int(deg)) * 60, f.lat < 0 ? 'S' : 'N');
+
+        char lng_string[20];
+        deg = fabs(f.lng);
+        snprintf(lng_string, sizeof(lng_string), "%03u%08.5f,%c",
+                 (unsigned)deg, (deg - int(deg)) * 60, f.lng < 0 ? 'W' : 'E');
+
+        nmea_printf("$GPGGA,%s,%s,%s,4,12,0.8,%07.2f,M,0.0,M,1.0,0000",
+                    tstring, lat_string, lng_string, f.alt);
+        nmea_printf("$GPRMC,%s,A,%s,%s,%.2f,%.2f,141026,,",
+                    tstring, lat_string, lng_string,
+                    norm(f.vn, f.ve) * 1.94384449f, ground_course_deg(f));
+        recording.end_epoch();
+    }
+}
+
+static void sbp_message(uint16_t msg_type, const void *payload, uint8_t len)
+{
+    const uint16_t sender_id = 0x2222;
+    uint16_t crc = crc16_ccitt((const uint8_t *)&msg_type, 2, 0);
+    crc = crc16_ccitt((const uint8_t *)&sender_id, 2, crc);
+    crc = crc16_ccitt(&len, 1, crc);
+    crc = crc16_ccitt((const uint8_t *)payload, len, crc);
+
+    recording.add_byte(0x55);
+    recording.add(&msg_type, 2);
+    recording.add(&sender_id, 2);
+    recording.add_byte(len);
+    recording.add(payload, len);
+    recording.add(&crc, 2);
+}
+
+// Swift Navigation SBP with single point and RTK fixed positions
+static void record_sbp(void)
+{
+    struct PACKED {
+        uint16_t wn;
+        uint32_t tow;
+        int32_t ns;
+        uint8_t flags;
+    } t;
+    struct PACKED {
+        uint32_t tow;
+        double lat;
+        double lon;
+        double height;
+        uint16_t h_accuracy;
+        uint16_t v_accuracy;
+        uint8_t n_sats;
+        uint8_t flags;
+    } pos;
+    struct PACKED {
+        uint32_t tow;
+        int32_t n;
+        int32_t e;
+        int32_t d;
+        uint16_t h_accuracy;
+        uint16_t v_accuracy;
+        uint8_t n_sats;
+        uint8_t flags;
+    } velned;
+    struct PACKED {
+        uint32_t tow;
+        uint16_t gdop;
+        uint16_t pdop;
+        uint16_t tdop;
+        uint16_t hdop;
+        uint16_t vdop;
+    } dops;
+    const uint32_t system_flags = 0;
+
+    recording.clear();
+    for (uint16_t i=0; i<RECORDING_EPOCHS; i++) {
+        Fix f;
+        trajectory(i, f);
+
+        t.wn = f.week;
+        t.tow = f.tow_ms;
+        t.ns = 0;
+        t.flags = 0;
+        sbp_message(0x0100, &t, sizeof(t));
+
+        pos.tow = f.tow_ms;
+        pos.lat = f.lat;
+        pos.lon = f.lng;
+        pos.height = f.alt;
+        pos.h_accuracy = 20;
+        pos.v_accuracy = 30;
+        pos.n_sats = 12;
+        pos.flags = 0;
+        sbp_message(0x0201, &pos, sizeof(pos));
+        pos.flags = 1;
+        sbp_message(0x0201, &pos, sizeof(pos));
+
+        velned.tow = f.tow_ms;
+        velned.n = f.vn * 1000;
+        velned.e = f.ve * 1000;
+        velned.d = f.vd * 1000;
+        velned.h_accuracy = 50;
+        velned.v_accuracy = 50;
+        velned.n_sats = 12;
+        velned.flags = 0;
+        sbp_message(0x0205, &velned, sizeof(velned));
+
+        if (i % 5 == 0) {
+            dops.tow = f.tow_ms;
+            dops.gdop = 1;
+            dops.pdop = 1;
+            dops.tdop = 1;
+            dops.hdop = 100;
+            dops.vdop = 1;
+            sbp_message(0x0206, &dops, sizeof(dops));
+            sbp_message(0xFFFF, &system_flags, sizeof(system_flags));
+        }
+        recording.end_epoch();
+    }
+}
+
+/*
+  SBF block: "$@", CRC, block id, length of the whole block padded to
+  a multiple of 4 and the block body. The CRC covers everything after
+  itself
+ */
+static void sbf_block(uint16_t blockid, const void *payload, uint16_t len)
+{
+    uint8_t body[128] {};
+    len = MIN(len, sizeof(body));
+    memcpy(body, payload, len);
+    const uint16_t length = 8 + ((len + 3) & ~3);
+
+    uint16_t crc = crc16_ccitt((const uint8_t *)&blockid, 2, 0);
+    crc = crc16_ccitt((const uint8_t *)&length, 2, crc);
+    crc = crc16_ccitt(body, length - 8, crc);
+
+    recording.add_byte('$');
+    recording.add_byte('@');
+    recording.add(&crc, 2);
+    recording.add(&blockid, 2);
+    recording.add(&length, 2);
+    recording.add(body, length - 8);
+}
+
+// Septentrio SBF DOP and PVTGeodetic blocks with an RTK fixed solution
+static void record_sbf(void)
+{
+    struct PACKED {
+        uint32_t TOW;
+        uint16_t WNc;
+        uint8_t NrSV;
+        uint8_t Reserved;
+        uint16_t PDOP;
+        uint16_t TDOP;
+        uint16_t HDOP;
+        uint16_t VDOP;
+        float HPL;
+        float VPL;
+    } dop;
+    struct PACKED {
+        uint32_t TOW;
+        uint16_t WNc;
+        uint8_t Mode;
+        uint8_t Error;
+        double Latitude;
+        double Longitude;
+        double Height;
+        float Undulation;
+        float Vn;
+        float Ve;
+        float Vu;
+        float COG;
+        double RxClkBias;
+        float RxClkDrift;
+        uint8_t TimeSystem;
+        uint8_t Datum;
+        uint8_t NrSV;
+        uint8_t WACorrInfo;
+        uint16_t ReferenceID;
+        uint16_t MeanCorrAge;
+        uint32_t SignalInfo;
+        uint8_t AlertFlag;
+        uint8_t NrBases;
+        uint16_t PPPInfo;
+        uint16_t Latency;
+        uint16_t HAccuracy;
+        uint16_t VAccuracy;
+        uint8_t Misc;
+    } pvt;
+
+    recording.clear();
+    for (uint16_t i=0; i<RECORDING_EPOCHS; i++) {
+        Fix f;
+        trajectory(i, f);
+
+        memset(&dop, 0, sizeof(dop));
+        dop.TOW = f.tow_ms;
+        dop.WNc = f.week;
+        dop.NrSV = 12;
+        dop.PDOP = 150;
+        dop.HDOP = 80;
+        dop.VDOP = 120;
+        sbf_block(4001, &dop, sizeof(dop));
+
+        memset(&pvt, 0, sizeof(pvt));
+        pvt.TOW = f.tow_ms;
+        pvt.WNc = f.week;
+        pvt.Mode = 4;
+        pvt.Latitude = f.lat * DEG_TO_RAD_DOUBLE;
+        pvt.Longitude = f.lng * DEG_TO_RAD_DOUBLE;
+        pvt.Height = f.alt;
+        pvt.Vn = f.vn;
+        pvt.Ve = f.ve;
+        pvt.Vu = -f.vd;
+        pvt.COG = ground_course_deg(f);
+        pvt.NrSV = 12;
+        pvt.NrBases = 1;
+        pvt.HAccuracy = 2;
+        pvt.VAccuracy = 3;
+        sbf_block(4007, &pvt, sizeof(pvt));
+        recording.end_epoch();
+    }
+}
+
+// store a value big endian
+static uint8_t *put_be(uint8_t *p, const void *v, uint8_t n)
+{
+    for (uint8_t i=0; i<n; i++) {
+        p[i] = ((const uint8_t *)v)[n-1-i];
+    }
+    return p + n;
+}
+
+/*
+  Trimble GSOF report with the position time, position, velocity, DOP
+  and sigma records the driver needs for a fix, RTK fixed
+ */
+static void record_gsof(void)
+{
+    recording.clear();
+    for (uint16_t i=0; i<RECORDING_EPOCHS; i++) {
+        Fix f;
+        trajectory(i, f);
+
+        uint8_t data[128] {};
+        uint8_t *p = data;
+        *p++ = i & 0xFF;    // transmission number
+        *p++ = 0;           // page index
+        *p++ = 0;           // max page index
+
+        *p++ = 1;
+        *p++ = 10;
+        p = put_be(p, &f.tow_ms, 4);
+        p = put_be(p, &f.week, 2);
+        *p++ = 12;          // satellites
+        *p++ = 0x01;        // new position
+        *p++ = 0x05;        // differential, RTK fixed
+        *p++ = 0;
+
+        const double lat = f.lat * DEG_TO_RAD_DOUBLE;
+        const double lng = f.lng * DEG_TO_RAD_DOUBLE;
+        *p++ = 2;
+        *p++ = 24;
+        p = put_be(p, &lat, 8);
+        p = put_be(p, &lng, 8);
+        p = put_be(p, &f.alt, 8);
+
+        const float speed = norm(f.vn, f.ve);
+        const float heading = radians(ground_course_deg(f));
+        const float vvel = -f.vd;
+        *p++ = 8;
+        *p++ = 13;
+        *p++ = 0x01;        // velocity valid
+        p = put_be(p, &speed, 4);
+        p = put_be(p, &heading, 4);
+        p = put_be(p, &vvel, 4);
+
+        const float dops[4] { 1.5f, 0.8f, 1.2f, 1.0f };
+        *p++ = 9;
+        *p++ = 16;
+        for (uint8_t d=0; d<ARRAY_SIZE(dops); d++) {
+            p = put_be(p, &dops[d], 4);
+        }
+
+        const float sigma[9] { 0.02f, 0.01f, 0.01f, 0.0f, 0.015f, 0.01f, 0.01f, 0.0f, 1.0f };
+        *p++ = 12;
+        *p++ = 38;
+        for (uint8_t s=0; s<ARRAY_SIZE(sigma); s++) {
+            p = put_be(p, &sigma[s], 4);
+        }
+        p += 2;             // epochs
+
+        const uint8_t length = p - data;
+        const uint8_t header[4] { 0x02, 0x28, 0x40, length };
+        uint8_t checksum = header[1] + header[2] + header[3];
+        for (uint8_t d=0; d<length; d++) {
+            checksum += data[d];
+        }
+        recording.add(header, sizeof(header));
+        recording.add(data, length);
+        recording.add_byte(checksum);
+        recording.add_byte(0x03);
+        recording.end_epoch();
+    }
+}
+
+struct PACKED nova_header {
+    uint8_t preamble[3];
+    uint8_t headerlength;
+    uint16_t messageid;
+    uint8_t messagetype;
+    uint8_t portaddr;
+    uint16_t messagelength;
+    uint16_t sequence;
+    uint8_t idletime;
+    uint8_t timestatus;
+    uint16_t week;
+    uint32_t tow;
+    uint32_t recvstatus;
+    uint16_t resv;
+    uint16_t recvswver;
+};
+
+static void nova_message(nova_header &header, uint16_t messageid, const void *payload, uint16_t len)
+{
+    header.messageid = messageid;
+    header.messagelength = len;
+    header.sequence++;
+
+    // the NovAtel CRC32 is the zlib one without the inversions
+    uint32_t crc = crc_crc32(0xFFFFFFFF, (const uint8_t *)&header, sizeof(header));
+    crc = ~crc_crc32(crc, (const uint8_t *)payload, len);
+
+    recording.add(&header, sizeof(header));
+    recording.add(payload, len);
+    recording.add(&crc, 4);
+}
+
+// NovAtel PSRDOP, BESTVEL and BESTPOS logs with a narrow-lane RTK fix
+static void record_nova(void)
+{
+    struct PACKED {
+        float gdop;
+        float pdop;
+        float hdop;
+        float htdop;
+        float tdop;
+        float cutoff;
+        uint32_t svcount;
+    } psrdop;
+    struct PACKED {
+        uint32_t solstat;
+        uint32_t postype;
+        double lat;
+        double lng;
+        double hgt;
+        float undulation;
+        uint32_t datumid;
+        float latsdev;
+        float lngsdev;
+        float hgtsdev;
+        uint8_t stnid[4];
+        float diffage;
+        float sol_age;
+        uint8_t svstracked;
+        uint8_t svsused;
+        uint8_t svsl1;
+        uint8_t svsmultfreq;
+        uint8_t resv;
+        uint8_t extsolstat;
+        uint8_t galbeisigmask;
+        uint8_t gpsglosigmask;
+    } bestpos;
+    struct PACKED {
+        uint32_t solstat;
+        uint32_t veltype;
+        float latency;
+        float age;
+        double horspd;
+        double trkgnd;
+        double vertspd;
+        float resv;
+    } bestvel;
+
+    nova_header header {};
+    header.preamble[0] = 0xaa;
+    header.preamble[1] = 0x44;
+    header.preamble[2] = 0x12;
+    header.headerlength = sizeof(header);
+
+    recording.clear();
+    for (uint16_t i=0; i<RECORDING_EPOCHS; i++) {
+        Fix f;
+        trajectory(i, f);
+
+        header.week = f.week;
+        header.tow = f.tow_ms;
+
+        memset(&psrdop, 0, sizeof(psrdop));
+        psrdop.hdop = 0.8f;
+        psrdop.htdop = 1.0f;
+        nova_message(header, 174, &psrdop, sizeof(psrdop));
+
+        memset(&bestvel, 0, sizeof(bestvel));
+        bestvel.horspd = norm(f.vn, f.ve);
+        bestvel.trkgnd = ground_course_deg(f);
+        bestvel.vertspd = -f.vd;
+        nova_message(header, 99, &bestvel, sizeof(bestvel));
+
+        memset(&bestpos, 0, sizeof(bestpos));
+        bestpos.solstat = 0;
+        bestpos.postype = 50;
+        bestpos.lat = f.lat;
+        bestpos.lng = f.lng;
+        bestpos.hgt = f.alt;
+        bestpos.latsdev = 0.01f;
+        bestpos.lngsdev = 0.01f;
+        bestpos.hgtsdev = 0.02f;
+        bestpos.svsused = 12;
+        nova_message(header, 42, &bestpos, sizeof(bestpos));
+        recording.end_epoch();
+    }
+}
+
+// Emlid ERB STAT, DOPS, POS and VEL messages with an RTK fixed solution
+static void record_erb(void)
+{
+    struct PACKED {
+        uint32_t time;
+        uint16_t week;
+        uint8_t fix_type;
+        uint8_t fix_status;
+        uint8_t satellites;
+    } stat;
+    struct PACKED {
+        uint32_t time;
+        uint16_t gDOP;
+        uint16_t pDOP;
+        uint16_t vDOP;
+        uint16_t hDOP;
+    } dops;
+    struct PACKED {
+        uint32_t time;
+        double longitude;
+        double latitude;
+        double altitude_ellipsoid;
+        double altitude_msl;
+        uint32_t horizontal_accuracy;
+        uint32_t vertical_accuracy;
+    } pos;
+    struct PACKED {
+        uint32_t time;
+        int32_t vel_north;
+        int32_t vel_east;
+        int32_t vel_down;
+        uint32_t speed_2d;
+        int32_t heading_2d;
+        uint32_t speed_accuracy;
+    } vel;
+
+    recording.clear();
+    for (uint16_t i=0; i<RECORDING_EPOCHS; i++) {
+        Fix f;
+        trajectory(i, f);
+
+        stat.time = f.tow_ms;
+        stat.week = f.week;
+        stat.fix_type = 3;
+        stat.fix_status = 1;
+        stat.satellites = 12;
+        erb_message(0x03, &stat, sizeof(stat));
+
+        dops.time = f.tow_ms;
+        dops.gDOP = 150;
+        dops.pDOP = 130;
+        dops.vDOP = 120;
+        dops.hDOP = 80;
+        erb_message(0x04, &dops, sizeof(dops));
+
+        pos.time = f.tow_ms;
+        pos.longitude = f.lng;
+        pos.latitude = f.lat;
+        pos.altitude_ellipsoid = f.alt;
+        pos.altitude_msl = f.alt;
+        pos.horizontal_accuracy = 20;
+        pos.vertical_accuracy = 30;
+        erb_message(0x02, &pos, sizeof(pos));
+
+        vel.time = f.tow_ms;
+        vel.vel_north = f.vn * 100;
+        vel.vel_east = f.ve * 100;
+        vel.vel_down = f.vd * 100;
+        vel.speed_2d = norm(f.vn, f.ve) * 100;
+        vel.heading_2d = ground_course_deg(f) * 100000;
+        vel.speed_accuracy = 10;
+        erb_message(0x05, &vel, sizeof(vel));
+        recording.end_epoch();
+    }
+}
+
+static AP_GPS gps;
+
+template <class Backend>
+static void replay(benchmark::State& state)
+{
+    ReplayUART uart;
+    uint64_t fixes = 0;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        AP_GPS::GPS_State gps_state {};
+        Backend *backend = new Backend(gps, gps_state, &uart);
+        state.ResumeTiming();
+
+        uint32_t start = 0;
+        for (uint16_t i=0; i<recording.epochs; i++) {
+            uart.set_data(&recording.bytes[start], recording.epoch_end[i] - start);
+            if (backend->read()) {
+                fixes++;
+            }
+            start = recording.epoch_end[i];
+        }
+
+        state.PauseTiming();
+        delete backend;
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(state.iterations() * recording.len);
+    state.SetItemsProcessed(fixes);
+}
+
+// argument is the number of raw measurements per epoch, 0 for none
+static void BM_ReplayUBLOX(benchmark::State& state)
+{
+    record_ubx(state.range(0));
+    replay<AP_GPS_UBLOX>(state);
+}
+
+static void BM_ReplayNMEA(benchmark::State& state)
+{
+    record_nmea();
+    replay<AP_GPS_NMEA>(state);
+}
+
+static void BM_ReplaySBP(benchmark::State& state)
+{
+    record_sbp();
+    replay<AP_GPS_SBP>(state);
+}
+
+static void BM_ReplaySBF(benchmark::State& state)
+{
+    record_sbf();
+    replay<AP_GPS_SBF>(state);
+}
+
+static void BM_ReplayGSOF(benchmark::State& state)
+{
+    record_gsof();
+    replay<AP_GPS_GSOF>(state);
+}
+
+static void BM_ReplayNOVA(benchmark::State& state)
+{
+    record_nova();
+    replay<AP_GPS_NOVA>(state);
+}
+
+static void BM_ReplayERB(benchmark::State& state)
+{
+    record_erb();
+    replay<AP_GPS_ERB>(state);
+}
+
+BENCHMARK(BM_ReplayUBLOX)->Arg(0)->Arg(12)->Arg(32);
+BENCHMARK(BM_ReplayNMEA);
+BENCHMARK(BM_ReplaySBP);
+BENCHMARK(BM_ReplaySBF);
+BENCHMARK(BM_ReplayGSOF);
+BENCHMARK(BM_ReplayNOVA);
+BENCHMARK(BM_ReplayERB);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,108 @@
+#include <AP_gtest.h>
+
+#include <AP_GPS/RTCM3_Parser.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+// build a frame for message type 1005 with the given payload length
+static uint16_t make_frame(uint8_t *buf, uint16_t payload_len, uint8_t fill)
+{
+    buf[0] = RTCM3_PREAMBLE;
+    buf[1] = payload_len >> 8;
+    buf[2] = payload_len & 0xFF;
+    for (uint16_t i=0; i<payload_len; i++) {
+        buf[3+i] = fill + i;
+    }
+    buf[3] = 1005 >> 4;
+    buf[4] = (1005 & 0x0F) << 4;
+    const uint32_t crc = RTCM3_Parser::crc24q(buf, 3 + payload_len);
+    buf[3+payload_len] = crc >> 16;
+    buf[4+payload_len] = crc >> 8;
+    buf[5+payload_len] = crc;
+    return payload_len + 6;
+}
+
+static uint16_t feed(RTCM3_Parser &parser, const uint8_t *data, uint16_t len)
+{
+    uint16_t frames = 0;
+    for (uint16_t i=0; i<len; i++) {
+        if (parser.read(data[i])) {
+            frames++;
+        }
+    }
+    return frames;
+}
+
+TEST(RTCM3_Parser, crc24q)
+{
+    // the empty frame, a well known test vector
+    const uint8_t frame[] = { 0xD3, 0x00, 0x00 };
+    EXPECT_EQ(0x47EA4BU, RTCM3_Parser::crc24q(frame, sizeof(frame)));
+}
+
+TEST(RTCM3_Parser, split_frame)
+{
+    RTCM3_Parser parser {};
+    uint8_t buf[RTCM3_MAX_FRAME];
+    const uint16_t len = make_frame(buf, 300, 7);
+
+    // any split point gives one frame on the final byte
+    EXPECT_EQ(0U, feed(parser, buf, 110));
+    EXPECT_TRUE(parser.in_frame());
+    EXPECT_EQ(1U, feed(parser, &buf[110], len - 110));
+    EXPECT_FALSE(parser.in_frame());
+    EXPECT_EQ(len, parser.frame_length());
+    EXPECT_EQ(1005U, parser.message_type());
+    EXPECT_EQ(0, memcmp(buf, parser.frame(), len));
+}
+
+TEST(RTCM3_Parser, bad_crc)
+{
+    RTCM3_Parser parser {};
+    uint8_t buf[RTCM3_MAX_FRAME];
+    const uint16_t len = make_frame(buf, 20, 3);
+
+    buf[10] ^= 1;
+    EXPECT_EQ(0U, feed(parser, buf, len));
+    EXPECT_EQ(1U, parser.crc_errors());
+
+    // the parser recovers on the next frame
+    buf[10] ^= 1;
+    EXPECT_EQ(1U, feed(parser, buf, len));
+}
+
+TEST(RTCM3_Parser, stray_preamble)
+{
+    RTCM3_Parser parser {};
+    uint8_t buf[RTCM3_MAX_FRAME+2];
+    // 0xD3 followed by non-zero reserved bits is not a frame start
+    buf[0] = RTCM3_PREAMBLE;
+    buf[1] = 0xFF;
+    const uint16_t len = make_frame(&buf[2], 50, 9);
+    EXPECT_EQ(1U, feed(parser, buf, len + 2));
+}
+
+TEST(RTCM3_Parser, duplicates)
+{
+    RTCM3_Parser parser {};
+    uint8_t buf[RTCM3_MAX_FRAME];
+    const uint16_t len = make_frame(buf, 40, 1);
+
+    EXPECT_EQ(1U, feed(parser, buf, len));
+    EXPECT_FALSE(parser.is_duplicate(1000));
+
+    // the same frame again shortly after is a duplicate
+    EXPECT_EQ(1U, feed(parser, buf, len));
+    EXPECT_TRUE(parser.is_duplicate(1100));
+
+    // but not once the dedup window has passed
+    EXPECT_EQ(1U, feed(parser, buf, len));
+    EXPECT_FALSE(parser.is_duplicate(1000 + RTCM3_DEDUP_MS));
+
+    // a different frame is never a duplicate
+    const uint16_t len2 = make_frame(buf, 40, 2);
+    EXPECT_EQ(1U, feed(parser, buf, len2));
+    EXPECT_FALSE(parser.is_duplicate(1600));
+}
+
+AP_GTEST_MAIN()
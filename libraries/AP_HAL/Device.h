@@ -65,6 +65,35 @@ public:
     virtual bool transfer(const uint8_t *send, uint32_t send_len,
                           uint8_t *recv, uint32_t recv_len) = 0;
 
+    /*
+     * A single transaction queued by #transfer_batch().
+     */
+    struct Transfer {
+        const uint8_t *send;
+        uint32_t send_len;
+        uint8_t *recv;
+        uint32_t recv_len;
+    };
+
+    /*
+     * Do several bus transactions back to back, in the same way as calling
+     * #transfer() for each of them in order. Buses that can queue
+     * transactions submit them all at once, saving the overhead of one call
+     * per transaction. Stops at the first failing transaction.
+     *
+     * Return: true if all transfers succeeded, false otherwise.
+     */
+    virtual bool transfer_batch(const Transfer *transfers, uint8_t count)
+    {
+        for (uint8_t i = 0; i < count; i++) {
+            if (!transfer(transfers[i].send, transfers[i].send_len,
+                          transfers[i].recv, transfers[i].recv_len)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     /**
      * Wrapper function over #transfer() to read recv_len registers, starting
      * by first_reg, into the array pointed by recv. The read flag passed to
@@ -132,6 +161,24 @@ public:
      */
     virtual bool adjust_periodic_callback(PeriodicHandle h, uint32_t period_usec) = 0;
 
+    /*
+     * Like #register_periodic_callback(), but the callback runs when the
+     * device raises its data ready line, connected to GPIO pin gpio_pin,
+     * rather than on a fixed period. If no data ready edge is seen for
+     * @timeout_usec the callback is run anyway, so a missed edge can't stall
+     * the device.
+     *
+     * Return: A handle for this callback or nullptr if the platform can't
+     * wait on the GPIO, in which case #register_periodic_callback() should
+     * be used instead.
+     */
+    virtual PeriodicHandle register_data_ready_callback(uint8_t gpio_pin,
+                                                        uint32_t timeout_usec,
+                                                        PeriodicCb)
+    {
+        return nullptr;
+    }
+
     /*
      * Cancel a periodic callback on this bus.
      *
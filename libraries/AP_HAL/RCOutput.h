@@ -114,11 +114,24 @@ public:
     virtual bool     enable_sbus_out(uint16_t rate_gz) { return false; }
     
     /*
-      output modes. Allows for support of oneshot
+      output modes. Allows for support of oneshot and DShot. In the
+      DShot modes channel writes are still PWM values, converted to
+      DShot throttle using the range given to set_esc_scaling(), and
+      cork()/push() should send all channels in one burst
      */
     enum output_mode {
         MODE_PWM_NORMAL,
-        MODE_PWM_ONESHOT
+        MODE_PWM_ONESHOT,
+        MODE_DSHOT150,
+        MODE_DSHOT300,
+        MODE_DSHOT600,
     };
     virtual void    set_output_mode(enum output_mode mode) {}
+
+    /*
+      get the output mode in use. Drivers that can't produce a
+      requested mode stay in their previous one, letting callers
+      check whether the mode was accepted
+     */
+    virtual enum output_mode get_output_mode(void) { return MODE_PWM_NORMAL; }
 };
@@ -43,11 +43,47 @@ public:
     // register a low priority IO task
     virtual void     register_io_process(AP_HAL::MemberProc) = 0;
 
+    /*
+      register a task to be called regularly from a worker thread
+      separate from the main thread, so it can run on another CPU
+      core. Returns false if the HAL has no worker thread
+     */
+    virtual bool     register_worker_process(AP_HAL::MemberProc) { return false; }
+
+    /*
+      register a task doing blocking file IO, to be called regularly
+      from a thread of its own so that a slow storage device can't
+      delay the other IO processes. Returns false if the HAL has no
+      storage thread, in which case register_io_process() should be
+      used instead
+     */
+    virtual bool     register_storage_process(AP_HAL::MemberProc) { return false; }
+
+    /*
+      register a task to be called at rate_hz from a high priority
+      thread of its own, for an inner control loop that should run
+      faster than the main loop. Only one rate process can be
+      registered. Returns false if the HAL has no rate thread
+     */
+    virtual bool     register_rate_process(AP_HAL::MemberProc, uint16_t rate_hz) { return false; }
+
+    /*
+      run a one-off task on a thread of its own during startup, so that
+      independent device probes can overlap. Returns false if the HAL
+      can't, in which case the caller should run the task itself.
+      wait_startup_tasks() returns once all of them have finished
+     */
+    virtual bool     run_startup_task(AP_HAL::MemberProc) { return false; }
+    virtual void     wait_startup_tasks() {}
+
     // suspend and resume both timer and IO processes
     virtual void     suspend_timer_procs() = 0;
     virtual void     resume_timer_procs() = 0;
 
     virtual bool     in_timerprocess() = 0;
+
+    // true when called from the thread running setup() and loop()
+    virtual bool     in_main_thread() { return !in_timerprocess(); }
     
     virtual void     register_timer_failsafe(AP_HAL::Proc,
                                              uint32_t period_us) = 0;
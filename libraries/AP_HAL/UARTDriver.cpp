@@ -36,3 +36,18 @@ void AP_HAL::UARTDriver::vprintf(const char *fmt, va_list ap)
 {
     print_vprintf(this, fmt, ap);
 }
+
+uint16_t AP_HAL::UARTDriver::read(uint8_t *buffer, uint16_t count)
+{
+    uint16_t n = 0;
+
+    while (n < count) {
+        const int16_t c = read();
+        if (c < 0) {
+            break;
+        }
+        buffer[n++] = c;
+    }
+
+    return n;
+}
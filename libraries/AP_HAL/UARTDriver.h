@@ -6,6 +6,7 @@
 
 #include "AP_HAL_Namespace.h"
 #include "utility/BetterStream.h"
+#include "utility/RingBuffer.h"
 
 /* Pure virtual UARTDriver class */
 class AP_HAL::UARTDriver : public AP_HAL::BetterStream {
@@ -45,6 +46,37 @@ public:
     virtual void set_flow_control(enum flow_control flow_control_setting) {};
     virtual enum flow_control get_flow_control(void) { return FLOW_CONTROL_DISABLE; }
 
+    /*
+      read up to count bytes into buffer, returning the number of
+      bytes read. Ports with a receive buffer should override this to
+      copy in one go instead of a virtual call per byte
+     */
+    virtual uint16_t read(uint8_t *buffer, uint16_t count);
+    using AP_HAL::Stream::read;
+
+    /*
+      estimated time in microseconds, on the AP_HAL::micros64() clock,
+      at which the next byte to be read was received. Returns 0 if the
+      port doesn't keep receive times or nothing is buffered
+     */
+    virtual uint64_t receive_time_us() { return 0; }
+
+    // read() giving the receive time of the first byte, 0 if unknown
+    uint16_t read(uint8_t *buffer, uint16_t count, uint64_t &time_us) {
+        time_us = receive_time_us();
+        return read(buffer, count);
+    }
+
+    /*
+      write straight into the transmit buffer: reserve len bytes,
+      returning the number of regions of vec filled in, then fill them
+      and make them available with tx_commit(). No write() may be made
+      in between. Returns 0 if the port doesn't support this or hasn't
+      got room for all len bytes, in which case use write()
+     */
+    virtual uint8_t tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len) { return 0; }
+    virtual bool tx_commit(uint32_t len) { return false; }
+
     /* Implementations of BetterStream virtual methods. These are
      * provided by AP_HAL to ensure consistency between ports to
      * different boards
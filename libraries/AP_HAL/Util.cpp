@@ -20,10 +20,9 @@ public:
         }
     }
     size_t write(const uint8_t *buffer, size_t size) {
-        size_t n = 0;
-        while (size--) {
-            n += write(*buffer++);
-        }
+        const size_t n = size < _size - _offs ? size : _size - _offs;
+        memcpy(&_str[_offs], buffer, n);
+        _offs += n;
         return n;
     }
 
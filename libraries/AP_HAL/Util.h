@@ -108,6 +108,39 @@ public:
     virtual void perf_end(perf_counter_t h) {}
     virtual void perf_count(perf_counter_t h) {}
 
+    /*
+      summary of the distribution recorded by a PC_ELAPSED counter,
+      in microseconds
+     */
+    struct perf_counter_info {
+        const char *name;
+        uint32_t count;
+        float avg_us;
+        uint32_t p50_us;
+        uint32_t p99_us;
+        uint32_t p999_us;
+        uint32_t max_us;
+    };
+    // get the summary of the idx'th elapsed counter, false past the last one
+    virtual bool perf_get_info(uint16_t idx, perf_counter_info &info) { return false; }
+    // zero all the counters with the given name
+    virtual bool perf_reset(const char *name) { return false; }
+
+    /*
+      stack high-water mark and run-time statistics of a HAL thread,
+      refreshed at low rate by the HAL
+     */
+    struct thread_info {
+        const char *name;
+        uint32_t stack_used;            // bytes
+        uint32_t stack_size;            // bytes
+        uint32_t cpu_ms;
+        uint32_t voluntary_switches;
+        uint32_t involuntary_switches;
+    };
+    // get the statistics of the idx'th thread, false past the last one
+    virtual bool thread_get_info(uint8_t idx, thread_info &info) { return false; }
+
     // create a new semaphore
     virtual Semaphore *new_semaphore(void) { return nullptr; }
 
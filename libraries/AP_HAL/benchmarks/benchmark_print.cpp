@@ -0,0 +1,96 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/ftoa_engine.h>
+#include <AP_HAL/utility/print_vprintf.h>
+
+/*
+  measure formatted output as used for parameter dumps and text
+  messages, through a stream that discards the output
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class NullPrint : public AP_HAL::Print {
+public:
+    size_t write(uint8_t c) override {
+        bytes++;
+        return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        gbenchmark_escape((void *)buffer);
+        bytes += size;
+        return size;
+    }
+
+    uint64_t bytes = 0;
+};
+
+static void null_printf(NullPrint &s, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    print_vprintf(&s, fmt, ap);
+    va_end(ap);
+}
+
+// one line of a parameter dump
+static void BM_PrintParamLine(benchmark::State& state)
+{
+    NullPrint s;
+    float value = 0.0123f;
+
+    while (state.KeepRunning()) {
+        null_printf(s, "%-16s %f\n", "ATC_RAT_RLL_P", value);
+        value += 0.5f;
+    }
+    state.SetBytesProcessed(s.bytes);
+}
+
+// integers and a string, no floats
+static void BM_PrintIntegers(benchmark::State& state)
+{
+    NullPrint s;
+    uint32_t value = 1;
+
+    while (state.KeepRunning()) {
+        null_printf(s, "Log %u: %5u bytes %s\n", (unsigned)(value & 0xFF), (unsigned)value, "ok");
+        value += 7919;
+    }
+    state.SetBytesProcessed(s.bytes);
+}
+
+// statustext sized message through hal.util->snprintf
+static void BM_SnprintfStatustext(benchmark::State& state)
+{
+    char buf[50];
+    float value = 12.5f;
+
+    while (state.KeepRunning()) {
+        hal.util->snprintf(buf, sizeof(buf), "EKF2 IMU%u yaw aligned %.2f %.4f", 1U, value, value * 0.01f);
+        gbenchmark_escape(buf);
+        value += 0.25f;
+    }
+}
+
+// float to digits conversion alone, as used by %f with the given precision
+static void BM_FtoaEngine(benchmark::State& state)
+{
+    char buf[10];
+    const uint8_t prec = state.range(0);
+    float value = 1.2345678f;
+
+    while (state.KeepRunning()) {
+        int16_t exp = ftoa_engine(value, buf, 7, prec + 1);
+        gbenchmark_escape(&exp);
+        gbenchmark_escape(buf);
+        value += 0.37f;
+    }
+}
+
+BENCHMARK(BM_PrintParamLine);
+BENCHMARK(BM_PrintIntegers);
+BENCHMARK(BM_SnprintfStatustext);
+BENCHMARK(BM_FtoaEngine)->Arg(2)->Arg(6);
+
+BENCHMARK_MAIN()
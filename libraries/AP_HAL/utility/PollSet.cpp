@@ -0,0 +1,57 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  a set of sensor device file descriptors checked with one poll() call
+ */
+#include "PollSet.h"
+
+#if HAL_OS_POSIX_IO
+
+#include <string.h>
+
+PollSet::PollSet() :
+    _count(0)
+{
+    memset(_fds, 0, sizeof(_fds));
+}
+
+int8_t PollSet::add(int fd)
+{
+    if (fd < 0 || _count >= max_fds) {
+        return -1;
+    }
+    _fds[_count].fd = fd;
+    _fds[_count].events = POLLIN;
+    _fds[_count].revents = 0;
+    return _count++;
+}
+
+bool PollSet::wait(int timeout_ms)
+{
+    if (_count == 0) {
+        return false;
+    }
+    int ret = ::poll(_fds, _count, timeout_ms);
+    if (ret < 0) {
+        // treat all as ready, so a poll failure costs reads rather than data
+        for (uint8_t i=0; i<_count; i++) {
+            _fds[i].revents = POLLIN;
+        }
+        return true;
+    }
+    return ret > 0;
+}
+
+#endif // HAL_OS_POSIX_IO
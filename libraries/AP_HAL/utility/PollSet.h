@@ -0,0 +1,48 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  a set of sensor device file descriptors checked with one poll()
+  call, so a backend only reads the devices that have new reports
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#if HAL_OS_POSIX_IO
+
+#include <poll.h>
+
+class PollSet {
+public:
+    PollSet();
+
+    // add a descriptor, returning its slot or -1 if the set is full
+    int8_t add(int fd);
+
+    // check all descriptors, waiting up to timeout_ms for one to
+    // have data. Returns true if any have data
+    bool wait(int timeout_ms);
+
+    // true if the descriptor in slot had data at the last wait()
+    bool ready(int8_t slot) const {
+        return slot >= 0 && slot < _count && (_fds[slot].revents & POLLIN);
+    }
+
+private:
+    static const uint8_t max_fds = 12;
+    struct pollfd _fds[max_fds];
+    uint8_t _count;
+};
+
+#endif // HAL_OS_POSIX_IO
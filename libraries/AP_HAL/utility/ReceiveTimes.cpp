@@ -0,0 +1,47 @@
+#include "ReceiveTimes.h"
+
+void ReceiveTimes::received(uint32_t n, uint64_t time_us)
+{
+    if (n == 0) {
+        return;
+    }
+    _received += n;
+
+    // with no room left the bytes are covered by the next mark, whose
+    // time gets extrapolated back over them
+    _marks.push(mark{_received, time_us});
+}
+
+void ReceiveTimes::consumed(uint32_t n)
+{
+    mark m;
+
+    _consumed += n;
+
+    // drop the reads whose bytes have all been consumed, making room
+    // for new ones
+    while (_marks.peek(m) && (int32_t)(m.end - _consumed) <= 0) {
+        _marks.pop();
+    }
+}
+
+uint64_t ReceiveTimes::next_byte_time_us()
+{
+    mark m;
+
+    if (!_marks.peek(m)) {
+        return 0;
+    }
+
+    // the bytes after the next one in the same read arrived later
+    const uint64_t later_ns = (uint64_t)(m.end - _consumed - 1) * _byte_time_ns;
+    return m.time_us - later_ns / 1000;
+}
+
+void ReceiveTimes::reset()
+{
+    while (_marks.pop()) {
+    }
+    _received = 0;
+    _consumed = 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RingBuffer.h"
+
+/*
+  receive times of the bytes going through a port's read buffer, so
+  that a reader can tell when the next byte it reads arrived.
+
+  The thread filling the read buffer calls received() after each
+  device read and the thread reading it calls consumed() for what it
+  took out. One thread each, like ByteBuffer.
+ */
+class ReceiveTimes {
+public:
+    ReceiveTimes(uint8_t marks) : _marks(marks) { }
+
+    // time on the wire of one byte, zero for ports receiving packets
+    // whose bytes all arrive at once
+    void set_byte_time_ns(uint32_t byte_time_ns) { _byte_time_ns = byte_time_ns; }
+
+    // producer: n bytes were read from the device at time_us
+    void received(uint32_t n, uint64_t time_us);
+
+    // consumer: n bytes were taken out of the read buffer
+    void consumed(uint32_t n);
+
+    // consumer: estimated time in microseconds at which the next byte
+    // to be read was received, or 0 if it is not known
+    uint64_t next_byte_time_us();
+
+    // forget all bytes, with neither side running
+    void reset();
+
+private:
+    struct mark {
+        // count of bytes received up to the end of a device read
+        uint32_t end;
+        uint64_t time_us;
+    };
+
+    ObjectBuffer<mark> _marks;
+    uint32_t _received = 0;
+    uint32_t _consumed = 0;
+    uint32_t _byte_time_ns = 0;
+};
@@ -3,6 +3,20 @@
 
 #include "RingBuffer.h"
 
+/*
+  ByteBuffer is safe for one producer thread calling the write side
+  methods (write, reserve, commit) concurrently with one consumer
+  thread calling the read side methods (read, read_byte, advance,
+  peek, peekbytes, peekiovec, readptr, update).
+
+  Each side owns one index: the producer only stores tail and the
+  consumer only stores head. An index is published with a release
+  store after the data it covers has been written or consumed, and
+  the other side loads it with acquire, so the buffer contents are
+  always visible before the index that makes them available. Each
+  side reads its own index with a relaxed load.
+ */
+
 ByteBuffer::ByteBuffer(uint32_t _size)
 {
     buf = (uint8_t*)malloc(_size);
@@ -36,8 +50,9 @@ bool ByteBuffer::set_size(uint32_t _size)
 
 uint32_t ByteBuffer::available(void) const
 {
-    uint32_t _tail;
-    return ((head > (_tail=tail))? (size - head) + _tail: _tail - head);
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    return (_head > _tail) ? (size - _head) + _tail : _tail - _head;
 }
 
 void ByteBuffer::clear(void)
@@ -47,13 +62,14 @@ void ByteBuffer::clear(void)
 
 uint32_t ByteBuffer::space(void) const
 {
-    uint32_t _head = head;
-    return size ? (_head > tail ? 0 : size) + _head - tail - 1 : 0;
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    return size ? (_head > _tail ? 0 : size) + _head - _tail - 1 : 0;
 }
 
 bool ByteBuffer::empty(void) const
 {
-    return head == tail;
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
 }
 
 uint32_t ByteBuffer::write(const uint8_t *data, uint32_t len)
@@ -81,11 +97,12 @@ bool ByteBuffer::update(const uint8_t *data, uint32_t len)
         return false;
     }
     // perform as two memcpy calls
-    uint32_t n = size - head;
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    uint32_t n = size - _head;
     if (n > len) {
         n = len;
     }
-    memcpy(&buf[head], data, n);
+    memcpy(&buf[_head], data, n);
     data += n;
     if (len > n) {
         memcpy(&buf[0], data, len-n);
@@ -98,7 +115,7 @@ bool ByteBuffer::advance(uint32_t n)
     if (n > available()) {
         return false;
     }
-    head = (head + n) % size;
+    head.store((head.load(std::memory_order_relaxed) + n) % size, std::memory_order_release);
     return true;
 }
 
@@ -160,9 +177,10 @@ uint8_t ByteBuffer::reserve(ByteBuffer::IoVec iovec[2], uint32_t len)
         return 0;
     }
 
-    iovec[0].data = &buf[tail];
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    iovec[0].data = &buf[_tail];
 
-    n = size - tail;
+    n = size - _tail;
     if (len <= n) {
         iovec[0].len = len;
         return 1;
@@ -185,7 +203,8 @@ bool ByteBuffer::commit(uint32_t len)
         return false; //Someone broke the agreement
     }
 
-    tail = (tail + len) % size;
+    // publish the bytes written into the reserved region
+    tail.store((tail.load(std::memory_order_relaxed) + len) % size, std::memory_order_release);
     return true;
 }
 
@@ -217,10 +236,11 @@ bool ByteBuffer::read_byte(uint8_t *data)
  */
 const uint8_t *ByteBuffer::readptr(uint32_t &available_bytes)
 {
-    uint32_t _tail = tail;
-    available_bytes = (head > _tail) ? size - head : _tail - head;
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    available_bytes = (_head > _tail) ? size - _head : _tail - _head;
 
-    return available_bytes ? &buf[head] : nullptr;
+    return available_bytes ? &buf[_head] : nullptr;
 }
 
 int16_t ByteBuffer::peek(uint32_t ofs) const
@@ -228,5 +248,5 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     if (ofs >= available()) {
         return -1;
     }
-    return buf[(head+ofs)%size];
+    return buf[(head.load(std::memory_order_relaxed)+ofs)%size];
 }
@@ -5,7 +5,8 @@
 #include <stdint.h>
 
 /*
- * Circular buffer of bytes.
+ * Circular buffer of bytes. Lock free for a single producer thread and
+ * a single consumer thread, see RingBuffer.cpp for the memory ordering.
  */
 class ByteBuffer {
 public:
@@ -15,7 +16,8 @@ public:
     // number of bytes available to be read
     uint32_t available(void) const;
 
-    // Discards the buffer content, emptying it.
+    // Discards the buffer content, emptying it. Not safe to call
+    // while the other side is using the buffer
     void clear(void);
 
     // number of bytes space available to write
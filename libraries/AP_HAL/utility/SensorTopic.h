@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Timestamped samples published by a single producer and read by any
+ * number of consumers without locking, so a driver never blocks on a
+ * reader and a reader always sees each sample whole, with its own
+ * timestamp.
+ *
+ * The topic keeps the last HISTORY samples in a ring indexed by a
+ * sequence number. The producer bumps the sequence after filling a
+ * slot, and a reader that finds the sequence has moved far enough to
+ * reuse the slot it was copying retries (or skips, for history). The
+ * slot the producer fills next is never readable, so HISTORY - 1
+ * samples can be read back.
+ */
+template <class T, uint8_t HISTORY = 2>
+class SensorTopic {
+public:
+    static_assert(HISTORY >= 2 && (HISTORY & (HISTORY - 1)) == 0,
+                  "HISTORY must be a power of two, at least 2");
+
+    struct Sample {
+        uint64_t timestamp_us;
+        T data;
+    };
+
+    // publish a new sample. Only one thread may publish
+    void publish(const T &data, uint64_t timestamp_us) {
+        const uint32_t seq = _seq.load(std::memory_order_relaxed) + 1;
+        // keep the previous sequence store ahead of the writes below,
+        // which reuse the slot of the oldest sample
+        std::atomic_thread_fence(std::memory_order_release);
+        Sample &slot = _samples[seq & (HISTORY - 1)];
+        slot.timestamp_us = timestamp_us;
+        slot.data = data;
+        _seq.store(seq, std::memory_order_release);
+    }
+
+    // copy the latest sample, returning false if nothing has been
+    // published yet
+    bool read(Sample &sample) const {
+        uint32_t seq = _seq.load(std::memory_order_acquire);
+        while (seq != 0) {
+            if (_copy(seq, sample)) {
+                return true;
+            }
+            seq = _seq.load(std::memory_order_acquire);
+        }
+        return false;
+    }
+
+    /*
+     * copy the samples published since the sequence number in since,
+     * oldest first, up to max of the newest. Samples that are no
+     * longer held are skipped. since is moved on to the latest
+     * sequence number, ready for the next call. Returns the number of
+     * samples copied
+     */
+    uint8_t read_history(Sample *samples, uint8_t max, uint32_t &since) const {
+        const uint32_t seq = _seq.load(std::memory_order_acquire);
+        uint32_t count = seq - since;
+        if (count > HISTORY - 1) {
+            count = HISTORY - 1;
+        }
+        if (count > max) {
+            count = max;
+        }
+        uint8_t n = 0;
+        for (uint32_t s = seq - count + 1; s != seq + 1; s++) {
+            if (_copy(s, samples[n])) {
+                n++;
+            }
+        }
+        since = seq;
+        return n;
+    }
+
+    // number of samples published so far, for readers to spot a new one
+    uint32_t sequence(void) const {
+        return _seq.load(std::memory_order_acquire);
+    }
+
+private:
+    // copy sample seq, false if the producer may have reused its slot
+    bool _copy(uint32_t seq, Sample &sample) const {
+        sample = _samples[seq & (HISTORY - 1)];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // the producer only starts on this slot once the sequence
+        // reaches seq + HISTORY - 1
+        return _seq.load(std::memory_order_relaxed) - seq < HISTORY - 1u;
+    }
+
+    Sample _samples[HISTORY];
+    std::atomic<uint32_t> _seq{0};
+};
@@ -61,6 +61,9 @@ public:
     // listen has been used. A new socket is returned
     SocketAPM *accept(uint32_t timeout_ms);
 
+    // underlying file descriptor, for batched system calls
+    int get_read_fd(void) const { return fd; }
+
 private:
     bool datagram;
     struct sockaddr_in in_addr {};
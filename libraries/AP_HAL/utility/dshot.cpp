@@ -0,0 +1,70 @@
+#include "dshot.h"
+
+uint16_t dshot_packet(uint16_t value, bool telemetry)
+{
+    uint16_t packet = ((value & 0x7FF) << 1) | (telemetry ? 1 : 0);
+
+    // checksum is the xor of the three nibbles above it
+    uint16_t csum = 0;
+    uint16_t data = packet;
+    for (uint8_t i = 0; i < 3; i++) {
+        csum ^= data;
+        data >>= 4;
+    }
+    return (packet << 4) | (csum & 0xF);
+}
+
+uint16_t dshot_throttle(uint16_t pwm, uint16_t pwm_min, uint16_t pwm_max)
+{
+    if (pwm <= pwm_min || pwm_max <= pwm_min) {
+        return 0;
+    }
+    if (pwm >= pwm_max) {
+        return DSHOT_THROTTLE_MAX;
+    }
+    const uint32_t range = DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN;
+    return DSHOT_THROTTLE_MIN + (uint32_t)(pwm - pwm_min) * range / (pwm_max - pwm_min);
+}
+
+void dshot_bit_ticks(uint16_t period_ticks, uint16_t &bit0_ticks, uint16_t &bit1_ticks)
+{
+    bit0_ticks = (uint32_t)period_ticks * 3 / 8;
+    bit1_ticks = (uint32_t)period_ticks * 3 / 4;
+}
+
+void dshot_fill_dma(uint16_t packet, uint16_t bit0_ticks, uint16_t bit1_ticks,
+                    uint16_t *buf, uint8_t stride)
+{
+    for (uint8_t i = 0; i < DSHOT_FRAME_BITS; i++) {
+        buf[i * stride] = (packet & 0x8000) ? bit1_ticks : bit0_ticks;
+        packet <<= 1;
+    }
+    buf[DSHOT_FRAME_BITS * stride] = 0;
+}
+
+// crc8 with polynomial 0x07, as used by the ESC telemetry frame
+static uint8_t telem_crc8(const uint8_t *buf, uint8_t len)
+{
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool dshot_telem_decode(const uint8_t frame[DSHOT_TELEM_FRAME_LEN], struct dshot_telem &telem)
+{
+    if (telem_crc8(frame, DSHOT_TELEM_FRAME_LEN-1) != frame[DSHOT_TELEM_FRAME_LEN-1]) {
+        return false;
+    }
+    telem.temperature_c = (int8_t)frame[0];
+    telem.voltage_cv = (frame[1] << 8) | frame[2];
+    telem.current_ca = (frame[3] << 8) | frame[4];
+    telem.consumption_mah = (frame[5] << 8) | frame[6];
+    // sent in hundreds of eRPM
+    telem.erpm = ((frame[7] << 8) | frame[8]) * 100UL;
+    return true;
+}
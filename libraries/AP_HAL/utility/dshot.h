@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+  DShot digital ESC protocol, shared by the RCOutput drivers that can
+  produce it.
+
+  A frame is 16 bits sent MSB first: an 11 bit value, a telemetry
+  request bit and a 4 bit checksum. Values 1 to 47 are ESC commands,
+  48 to 2047 are throttle and 0 stops the motor. Each bit is a fixed
+  length period whose high time tells a 0 (37.5%) from a 1 (75%), so
+  a driver generates a frame by loading timer compare values from a
+  DMA buffer.
+ */
+
+#define DSHOT_FRAME_BITS        16
+#define DSHOT_THROTTLE_MIN      48
+#define DSHOT_THROTTLE_MAX      2047
+
+// length of the ESC telemetry frame sent back on the telemetry wire
+#define DSHOT_TELEM_FRAME_LEN   10
+
+// build a frame from a value and the telemetry request bit
+uint16_t dshot_packet(uint16_t value, bool telemetry);
+
+// DShot throttle for a PWM value scaled between pwm_min and pwm_max,
+// zero (motor stop) at or below pwm_min
+uint16_t dshot_throttle(uint16_t pwm, uint16_t pwm_min, uint16_t pwm_max);
+
+// timer compare values for a 0 and a 1 bit given the timer ticks per
+// bit period
+void dshot_bit_ticks(uint16_t period_ticks, uint16_t &bit0_ticks, uint16_t &bit1_ticks);
+
+/*
+  write the compare values of a frame to a DMA buffer, one value every
+  stride entries. Interleaving the channels of a timer with stride set
+  to the channel count lets one DMA burst send every channel. The
+  buffer needs DSHOT_FRAME_BITS+1 slots per channel, the last one
+  zero so the line stays low between frames
+ */
+void dshot_fill_dma(uint16_t packet, uint16_t bit0_ticks, uint16_t bit1_ticks,
+                    uint16_t *buf, uint8_t stride);
+
+struct dshot_telem {
+    int8_t temperature_c;
+    uint16_t voltage_cv;     // centivolts
+    uint16_t current_ca;     // centiamps
+    uint16_t consumption_mah;
+    uint32_t erpm;           // electrical revolutions per minute
+};
+
+// decode an ESC telemetry frame, returning false on a bad checksum
+bool dshot_telem_decode(const uint8_t frame[DSHOT_TELEM_FRAME_LEN], struct dshot_telem &telem);
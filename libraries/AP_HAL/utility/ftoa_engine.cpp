@@ -85,6 +85,29 @@ static const uint32_t factorTable[32] = {
     1038459372UL
 };
 
+/*
+ * decimal place values of the digits, walked through rather than
+ * dividing by 10 for each digit, which is a library call for 64 bit
+ * values on 32 bit processors
+ */
+static const int64_t decimalTable[15] = {
+    100000000000000LL,
+    10000000000000LL,
+    1000000000000LL,
+    100000000000LL,
+    10000000000LL,
+    1000000000LL,
+    100000000LL,
+    10000000LL,
+    1000000LL,
+    100000LL,
+    10000LL,
+    1000LL,
+    100LL,
+    10LL,
+    1LL
+};
+
 int16_t ftoa_engine(float val, char *buf, uint8_t precision, uint8_t maxDecimals) 
 {
     uint8_t flags;
@@ -141,19 +164,20 @@ int16_t ftoa_engine(float val, char *buf, uint8_t precision, uint8_t maxDecimals
     // Now convert to decimal.
     uint8_t hadNonzeroDigit = 0; // a flag
     uint8_t outputIdx = 0;
-    int64_t decimal = 100000000000000ull;
+    uint8_t decimalIdx = 0;
+    int64_t decimal = decimalTable[0];
 
     do {
         char digit = '0';
         while(1) {// find the first nonzero digit or any of the next digits.
-            while ((prod -= decimal) >= 0)
-                digit++;
-            // Now we got too low. Fix it by adding again, once.
-            // it might appear more efficient to check before subtract, or
-            // to save and restore last nonnegative value - but in fact
-            // they take as long time and more space.
-            prod += decimal;
-            decimal /= 10;
+            // digits below the last place value are always zero
+            if (decimalIdx < ARRAY_SIZE(decimalTable)) {
+                decimal = decimalTable[decimalIdx++];
+                while (prod >= decimal) {
+                    prod -= decimal;
+                    digit++;
+                }
+            }
 
             // If already found a leading nonzero digit, accept zeros.
             if (hadNonzeroDigit) break;
@@ -202,10 +226,8 @@ int16_t ftoa_engine(float val, char *buf, uint8_t precision, uint8_t maxDecimals
         }
     } while (outputIdx<precision);
 
-    // Rounding:
-    decimal *= 10;
-
-    if (prod - (decimal >> 1) >= 0) {
+    // Rounding, on the remainder below the last digit:
+    if (2 * prod >= decimal) {
 
     roundup:
         // Increment digit, cascade
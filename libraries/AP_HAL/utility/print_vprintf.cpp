@@ -66,7 +66,43 @@
 #define FL_FLTEXP   FL_PREC
 #define FL_FLTFIX   FL_LONG
 
-void print_vprintf(AP_HAL::Print *s, const char *fmt, va_list ap)
+#ifndef PRINT_VPRINTF_BUFFER_SIZE
+#define PRINT_VPRINTF_BUFFER_SIZE 32
+#endif
+
+/*
+  formatted output is collected here and handed to the stream a block
+  at a time, so the stream sees one write() per block rather than one
+  per character
+ */
+class PrintBuffer {
+public:
+    PrintBuffer(AP_HAL::Print *s) :
+        _s(s),
+        _len(0)
+    {}
+
+    void write(uint8_t c) {
+        if (_len == sizeof(_buf)) {
+            flush();
+        }
+        _buf[_len++] = c;
+    }
+
+    void flush() {
+        if (_len > 0) {
+            _s->write(_buf, _len);
+            _len = 0;
+        }
+    }
+
+private:
+    AP_HAL::Print *_s;
+    uint8_t _len;
+    uint8_t _buf[PRINT_VPRINTF_BUFFER_SIZE];
+};
+
+static void print_vprintf_buffered(PrintBuffer *s, const char *fmt, va_list ap)
 {
         unsigned char c;        /* holds a char from the format string */
         uint16_t flags;
@@ -535,3 +571,10 @@ tail:
             }
         } /* for (;;) */
 }
+
+void print_vprintf(AP_HAL::Print *s, const char *fmt, va_list ap)
+{
+    PrintBuffer out(s);
+    print_vprintf_buffered(&out, fmt, ap);
+    out.flush();
+}
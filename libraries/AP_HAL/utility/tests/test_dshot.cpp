@@ -0,0 +1,89 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/dshot.h>
+
+TEST(DShotTest, PacketChecksum)
+{
+    // value 1046 without telemetry: 0x82C, checksum 0x8^0x2^0xC = 0x6
+    EXPECT_EQ(0x82C6, dshot_packet(1046, false));
+    // the telemetry bit is covered by the checksum
+    EXPECT_EQ(0x82D7, dshot_packet(1046, true));
+    EXPECT_EQ(0x0000, dshot_packet(0, false));
+    EXPECT_EQ(0xFFEE, dshot_packet(DSHOT_THROTTLE_MAX, false));
+}
+
+TEST(DShotTest, ValueIsMasked)
+{
+    EXPECT_EQ(dshot_packet(5, false), dshot_packet(0x800 | 5, false));
+}
+
+TEST(DShotTest, Throttle)
+{
+    EXPECT_EQ(0, dshot_throttle(1000, 1000, 2000));
+    EXPECT_EQ(0, dshot_throttle(900, 1000, 2000));
+    EXPECT_EQ(DSHOT_THROTTLE_MIN+1, dshot_throttle(1001, 1000, 2000));
+    EXPECT_EQ(DSHOT_THROTTLE_MAX, dshot_throttle(2000, 1000, 2000));
+    EXPECT_EQ(DSHOT_THROTTLE_MAX, dshot_throttle(2100, 1000, 2000));
+    EXPECT_EQ(1047, dshot_throttle(1500, 1000, 2000));
+    // bad scaling stops the motor
+    EXPECT_EQ(0, dshot_throttle(1500, 2000, 1000));
+}
+
+TEST(DShotTest, BitTicks)
+{
+    uint16_t bit0, bit1;
+
+    // DShot600 from a 48MHz timer: 80 ticks a bit
+    dshot_bit_ticks(80, bit0, bit1);
+    EXPECT_EQ(30, bit0);
+    EXPECT_EQ(60, bit1);
+}
+
+TEST(DShotTest, FillDmaInterleaved)
+{
+    uint16_t buf[(DSHOT_FRAME_BITS+1)*2];
+    for (uint8_t i = 0; i < sizeof(buf)/sizeof(buf[0]); i++) {
+        buf[i] = 0xFFFF;
+    }
+
+    dshot_fill_dma(0x8001, 3, 6, &buf[0], 2);
+    dshot_fill_dma(0x7FFE, 3, 6, &buf[1], 2);
+
+    EXPECT_EQ(6, buf[0]);
+    EXPECT_EQ(3, buf[1]);
+    for (uint8_t i = 1; i < DSHOT_FRAME_BITS-1; i++) {
+        EXPECT_EQ(3, buf[i*2]);
+        EXPECT_EQ(6, buf[i*2+1]);
+    }
+    EXPECT_EQ(6, buf[(DSHOT_FRAME_BITS-1)*2]);
+    EXPECT_EQ(3, buf[(DSHOT_FRAME_BITS-1)*2+1]);
+    EXPECT_EQ(0, buf[DSHOT_FRAME_BITS*2]);
+    EXPECT_EQ(0, buf[DSHOT_FRAME_BITS*2+1]);
+}
+
+TEST(DShotTest, TelemetryDecode)
+{
+    // 35C, 16.80V, 12.34A, 567mAh, 23400 eRPM
+    uint8_t frame[DSHOT_TELEM_FRAME_LEN] = { 35, 0x06, 0x90, 0x04, 0xD2, 0x02, 0x37, 0x00, 0xEA, 0 };
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < DSHOT_TELEM_FRAME_LEN-1; i++) {
+        crc ^= frame[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+    }
+    frame[DSHOT_TELEM_FRAME_LEN-1] = crc;
+
+    struct dshot_telem telem;
+    ASSERT_TRUE(dshot_telem_decode(frame, telem));
+    EXPECT_EQ(35, telem.temperature_c);
+    EXPECT_EQ(1680, telem.voltage_cv);
+    EXPECT_EQ(1234, telem.current_ca);
+    EXPECT_EQ(567, telem.consumption_mah);
+    EXPECT_EQ(23400u, telem.erpm);
+
+    frame[4] ^= 1;
+    EXPECT_FALSE(dshot_telem_decode(frame, telem));
+}
+
+AP_GTEST_MAIN()
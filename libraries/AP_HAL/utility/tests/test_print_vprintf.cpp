@@ -0,0 +1,94 @@
+#include <AP_gtest.h>
+
+#include <math.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/print_vprintf.h>
+
+// collects the output, counting the calls of each write()
+class StringPrint : public AP_HAL::Print {
+public:
+    size_t write(uint8_t c) override {
+        char_writes++;
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t *buffer, size_t size) override {
+        block_writes++;
+        if (len + size >= sizeof(str)) {
+            size = sizeof(str) - 1 - len;
+        }
+        memcpy(&str[len], buffer, size);
+        len += size;
+        str[len] = 0;
+        return size;
+    }
+
+    char str[256] {};
+    size_t len = 0;
+    unsigned char_writes = 0;
+    unsigned block_writes = 0;
+};
+
+static void sprint(StringPrint &s, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    print_vprintf(&s, fmt, ap);
+    va_end(ap);
+}
+
+#define EXPECT_PRINTF(expected, fmt, ...) do { \
+        StringPrint s; \
+        sprint(s, fmt, ##__VA_ARGS__); \
+        EXPECT_STREQ(expected, s.str); \
+    } while (0)
+
+TEST(PrintVprintfTest, Integers)
+{
+    EXPECT_PRINTF("-42 7 4000000000", "%d %i %u", -42, 7, 4000000000U);
+    EXPECT_PRINTF("   42|42   |-0042", "%5d|%-5d|%05d", 42, 42, -42);
+    EXPECT_PRINTF("-1234567890123", "%lld", -1234567890123LL);
+    EXPECT_PRINTF("01:02", "%02u:%02u", 1, 2);
+}
+
+TEST(PrintVprintfTest, Strings)
+{
+    EXPECT_PRINTF("abc|     right|left  |tru", "%s|%10s|%-6s|%.3s", "abc", "right", "left", "truncate");
+    EXPECT_PRINTF("ok", "%c%c", 'o', 'k');
+    EXPECT_PRINTF("", "");
+}
+
+TEST(PrintVprintfTest, Floats)
+{
+    EXPECT_PRINTF("1.500000", "%f", 1.5);
+    EXPECT_PRINTF("3.14", "%.2f", 3.14159);
+    EXPECT_PRINTF("  -2.500|2.500   |", "%8.3f|%-8.3f|", -2.5, 2.5);
+    EXPECT_PRINTF("42", "%.0f", 42.0);
+    EXPECT_PRINTF("0.1", "%.1f", 0.05);
+    EXPECT_PRINTF("+1.00  1.00", "%+.2f % .2f", 1.0, 1.0);
+    EXPECT_PRINTF("03.500", "%06.3f", 3.5);
+    EXPECT_PRINTF("1.234568e+04", "%e", 12345.678);
+    EXPECT_PRINTF("-1.234e-04", "%.3e", -0.00012345);
+    EXPECT_PRINTF("0.0001 123456", "%g %g", 0.0001, 123456.0);
+    EXPECT_PRINTF("inf nan", "%f %f", INFINITY, NAN);
+
+    // floats only carry 8 significant digits
+    EXPECT_PRINTF("1234.568", "%.4f", 1234.5678);
+}
+
+TEST(PrintVprintfTest, NewlineIsCRLF)
+{
+    EXPECT_PRINTF("a\r\nb\r\n", "a\nb\n");
+}
+
+TEST(PrintVprintfTest, WritesInBlocks)
+{
+    const char *line = "0123456789012345678901234567890123456789012345678901234567890123456789";
+    StringPrint s;
+    sprint(s, "%s %d %.3f\n", line, 42, 1.5);
+    EXPECT_EQ(strlen(line) + 11, s.len);
+    EXPECT_EQ(0u, s.char_writes);
+    EXPECT_GE(4u, s.block_writes);
+}
+
+AP_GTEST_MAIN()
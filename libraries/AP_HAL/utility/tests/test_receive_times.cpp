@@ -0,0 +1,69 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/ReceiveTimes.h>
+
+TEST(ReceiveTimesTest, NothingReceived)
+{
+    ReceiveTimes times(4);
+
+    EXPECT_EQ(0u, times.next_byte_time_us());
+}
+
+TEST(ReceiveTimesTest, PacketsKeepTheirReadTime)
+{
+    ReceiveTimes times(4);
+
+    times.received(10, 1000);
+    times.received(5, 2000);
+
+    EXPECT_EQ(1000u, times.next_byte_time_us());
+    times.consumed(9);
+    EXPECT_EQ(1000u, times.next_byte_time_us());
+    times.consumed(1);
+    EXPECT_EQ(2000u, times.next_byte_time_us());
+    times.consumed(5);
+    EXPECT_EQ(0u, times.next_byte_time_us());
+}
+
+TEST(ReceiveTimesTest, BytesDatedBackOverTheRead)
+{
+    ReceiveTimes times(4);
+
+    // 100us per byte: the first of 10 bytes read at 5000us arrived 900us before
+    times.set_byte_time_ns(100000);
+    times.received(10, 5000);
+
+    EXPECT_EQ(4100u, times.next_byte_time_us());
+    times.consumed(4);
+    EXPECT_EQ(4500u, times.next_byte_time_us());
+}
+
+TEST(ReceiveTimesTest, FullMarksExtrapolate)
+{
+    ReceiveTimes times(2);
+
+    times.set_byte_time_ns(1000000);
+    times.received(1, 1000);
+    times.received(1, 2000);
+    // no room for this mark, the next one covers its bytes
+    times.received(2, 4000);
+    times.consumed(2);
+    times.received(1, 5000);
+
+    EXPECT_EQ(3000u, times.next_byte_time_us());
+    times.consumed(2);
+    EXPECT_EQ(5000u, times.next_byte_time_us());
+}
+
+TEST(ReceiveTimesTest, Reset)
+{
+    ReceiveTimes times(4);
+
+    times.received(3, 1000);
+    times.consumed(1);
+    times.reset();
+
+    EXPECT_EQ(0u, times.next_byte_time_us());
+    times.received(1, 3000);
+    EXPECT_EQ(3000u, times.next_byte_time_us());
+}
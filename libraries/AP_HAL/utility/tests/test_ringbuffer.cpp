@@ -0,0 +1,97 @@
+#include <AP_gtest.h>
+
+#include <thread>
+#include <AP_HAL/utility/RingBuffer.h>
+
+TEST(ByteBufferTest, WriteRead)
+{
+    ByteBuffer buf(16);
+    const uint8_t data[] = {1, 2, 3, 4, 5};
+
+    EXPECT_EQ(15u, buf.space());
+    EXPECT_EQ(5u, buf.write(data, sizeof(data)));
+    EXPECT_EQ(5u, buf.available());
+    EXPECT_EQ(3, buf.peek(2));
+
+    uint8_t out[5] {};
+    EXPECT_EQ(5u, buf.read(out, sizeof(out)));
+    EXPECT_EQ(0, memcmp(data, out, sizeof(data)));
+    EXPECT_TRUE(buf.empty());
+}
+
+TEST(ByteBufferTest, ReserveCommitWraps)
+{
+    ByteBuffer buf(8);
+    uint8_t tmp[6] {};
+
+    // move the indexes so the next reservation wraps
+    buf.write(tmp, 6);
+    buf.advance(6);
+
+    ByteBuffer::IoVec vec[2];
+    EXPECT_EQ(2, buf.reserve(vec, 5));
+    EXPECT_EQ(2u, vec[0].len);
+    EXPECT_EQ(3u, vec[1].len);
+    for (uint8_t i = 0; i < 5; i++) {
+        (i < 2 ? vec[0].data[i] : vec[1].data[i - 2]) = i;
+    }
+
+    // nothing is visible to the reader until committed
+    EXPECT_EQ(0u, buf.available());
+    EXPECT_TRUE(buf.commit(5));
+    EXPECT_EQ(5u, buf.available());
+
+    uint8_t out[5] {};
+    EXPECT_EQ(5u, buf.read(out, sizeof(out)));
+    for (uint8_t i = 0; i < 5; i++) {
+        EXPECT_EQ(i, out[i]);
+    }
+}
+
+TEST(ByteBufferTest, ProducerConsumerThreads)
+{
+    ByteBuffer buf(61);
+    const uint32_t total = 200000;
+
+    std::thread producer([&buf, total]() {
+        uint32_t sent = 0;
+        while (sent < total) {
+            ByteBuffer::IoVec vec[2];
+            const uint8_t n_vec = buf.reserve(vec, total - sent);
+            uint32_t n = 0;
+            for (uint8_t i = 0; i < n_vec; i++) {
+                for (uint32_t j = 0; j < vec[i].len; j++) {
+                    vec[i].data[j] = (uint8_t)(sent + n++);
+                }
+            }
+            buf.commit(n);
+            sent += n;
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t received = 0;
+    bool in_order = true;
+    while (received < total) {
+        uint32_t n;
+        const uint8_t *p = buf.readptr(n);
+        for (uint32_t i = 0; i < n; i++) {
+            if (p[i] != (uint8_t)(received + i)) {
+                in_order = false;
+            }
+        }
+        buf.advance(n);
+        received += n;
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(buf.empty());
+}
+
+AP_GTEST_MAIN()
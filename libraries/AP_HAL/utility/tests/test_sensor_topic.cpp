@@ -0,0 +1,84 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/SensorTopic.h>
+
+struct TestObject {
+    uint32_t a;
+    uint32_t b;
+};
+
+TEST(SensorTopicTest, EmptyUntilPublished)
+{
+    SensorTopic<TestObject> topic;
+    SensorTopic<TestObject>::Sample sample {};
+    uint32_t since = 0;
+
+    EXPECT_EQ(0u, topic.sequence());
+    EXPECT_FALSE(topic.read(sample));
+    EXPECT_EQ(0u, topic.read_history(&sample, 1, since));
+    EXPECT_EQ(0u, since);
+}
+
+TEST(SensorTopicTest, ReadsLatestWithTimestamp)
+{
+    SensorTopic<TestObject> topic;
+    SensorTopic<TestObject>::Sample sample;
+
+    for (uint32_t i = 1; i <= 5; i++) {
+        topic.publish(TestObject{i, i * 10}, i * 1000);
+        EXPECT_EQ(i, topic.sequence());
+        ASSERT_TRUE(topic.read(sample));
+        EXPECT_EQ(i * 1000, sample.timestamp_us);
+        EXPECT_EQ(i, sample.data.a);
+        EXPECT_EQ(i * 10, sample.data.b);
+    }
+}
+
+TEST(SensorTopicTest, HistoryOldestFirst)
+{
+    SensorTopic<TestObject, 8> topic;
+    SensorTopic<TestObject, 8>::Sample samples[8];
+    uint32_t since = 0;
+
+    for (uint32_t i = 1; i <= 3; i++) {
+        topic.publish(TestObject{i, 0}, i);
+    }
+    ASSERT_EQ(3u, topic.read_history(samples, 8, since));
+    EXPECT_EQ(3u, since);
+    for (uint8_t i = 0; i < 3; i++) {
+        EXPECT_EQ(i + 1u, samples[i].data.a);
+    }
+
+    // only what was published since the last call
+    EXPECT_EQ(0u, topic.read_history(samples, 8, since));
+    topic.publish(TestObject{4, 0}, 4);
+    ASSERT_EQ(1u, topic.read_history(samples, 8, since));
+    EXPECT_EQ(4u, samples[0].data.a);
+}
+
+TEST(SensorTopicTest, HistoryKeepsNewest)
+{
+    SensorTopic<TestObject, 4> topic;
+    SensorTopic<TestObject, 4>::Sample samples[4];
+    uint32_t since = 0;
+
+    for (uint32_t i = 1; i <= 10; i++) {
+        topic.publish(TestObject{i, 0}, i);
+    }
+
+    // one slot is left for the producer, so three can be read back
+    ASSERT_EQ(3u, topic.read_history(samples, 4, since));
+    EXPECT_EQ(10u, since);
+    EXPECT_EQ(8u, samples[0].data.a);
+    EXPECT_EQ(9u, samples[1].data.a);
+    EXPECT_EQ(10u, samples[2].data.a);
+
+    for (uint32_t i = 11; i <= 13; i++) {
+        topic.publish(TestObject{i, 0}, i);
+    }
+    ASSERT_EQ(2u, topic.read_history(samples, 2, since));
+    EXPECT_EQ(12u, samples[0].data.a);
+    EXPECT_EQ(13u, samples[1].data.a);
+}
+
+AP_GTEST_MAIN()
@@ -1,7 +1,11 @@
 #include "AnalogIn_IIO.h"
 
+#include <stdio.h>
+
 #include <AP_HAL/AP_HAL.h>
 
+#include "Util.h"
+
 extern const AP_HAL::HAL &hal;
 
 const char* AnalogSource_IIO::analog_sources[] = {
@@ -15,16 +19,20 @@ const char* AnalogSource_IIO::analog_sources[] = {
     "in_voltage7_raw",
 };
 
-AnalogSource_IIO::AnalogSource_IIO(int16_t pin, float initial_value, float voltage_scaling) :
+AnalogSource_IIO::AnalogSource_IIO(int16_t pin, float initial_value, float voltage_scaling,
+                                   bool buffered) :
     _pin(pin),
     _value(initial_value),
     _voltage_scaling(voltage_scaling),
     _sum_value(0),
     _sum_count(0),
-    _pin_fd(-1)
+    _pin_fd(-1),
+    _buffered(buffered)
 {
-    init_pins();
-    select_pin();
+    if (!_buffered) {
+        init_pins();
+        select_pin();
+    }
 }
 
 void AnalogSource_IIO::init_pins(void)
@@ -49,7 +57,9 @@ void AnalogSource_IIO::select_pin(void)
 
 float AnalogSource_IIO::read_average()
 {
-    read_latest();
+    if (!_buffered) {
+        read_latest();
+    }
     if (_sum_count == 0) {
         return _value;
     }
@@ -65,6 +75,10 @@ float AnalogSource_IIO::read_latest()
 {
     char sbuf[10];
 
+    if (_buffered) {
+        return _latest;
+    }
+
     if (_pin_fd == -1) {
         _latest = 0;
         return 0;
@@ -91,6 +105,20 @@ float AnalogSource_IIO::voltage_latest()
     return _latest;
 }
 
+/*
+  apply a sample in buffered capture mode, called from the timer thread
+ */
+void AnalogSource_IIO::_add_value(float v)
+{
+    _latest = v * _voltage_scaling;
+    _sum_value += _latest;
+    _sum_count++;
+    if (_sum_count == 254) {
+        _sum_value /= 2;
+        _sum_count /= 2;
+    }
+}
+
 void AnalogSource_IIO::set_pin(uint8_t pin)
 {
     if (_pin == pin) {
@@ -103,7 +131,9 @@ void AnalogSource_IIO::set_pin(uint8_t pin)
     _sum_count = 0;
     _latest = 0;
     _value = 0;
-    select_pin();
+    if (!_buffered) {
+        select_pin();
+    }
     hal.scheduler->resume_timer_procs();
 }
 
@@ -113,13 +143,163 @@ void AnalogSource_IIO::set_stop_pin(uint8_t p)
 void AnalogSource_IIO::set_settle_time(uint16_t settle_time_ms)
 {}
 
-AnalogIn_IIO::AnalogIn_IIO()
+AnalogIn_IIO::AnalogIn_IIO() :
+    _scan_count(0),
+    _scan_size(0),
+    _buffer_fd(-1),
+    _last_run_us(0),
+    _num_channels(0)
 {}
 
 void AnalogIn_IIO::init()
-{}
+{
+    if (!_init_buffer()) {
+        hal.console->printf("AnalogIn_IIO: no buffered capture, reading sysfs\n");
+        return;
+    }
+    hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AnalogIn_IIO::_timer_tick, void));
+}
 
+/*
+  parse the scan element type of a channel, such as "le:u12/16>>0"
+ */
+bool AnalogIn_IIO::_read_scan_type(uint8_t channel)
+{
+    char path[100];
+    char type[32];
+    unsigned index, bits, storage, shift;
+    char endian, sign;
+
+    snprintf(path, sizeof(path), IIO_ANALOG_IN_DIR "scan_elements/in_voltage%u_index", channel);
+    if (Linux::Util::from(hal.util)->read_file(path, "%u", &index) < 0) {
+        return false;
+    }
+    snprintf(path, sizeof(path), IIO_ANALOG_IN_DIR "scan_elements/in_voltage%u_type", channel);
+    if (Linux::Util::from(hal.util)->read_file(path, "%31s", type) < 0 ||
+        sscanf(type, "%ce:%c%u/%u>>%u", &endian, &sign, &bits, &storage, &shift) != 5 ||
+        (storage != 8 && storage != 16 && storage != 32) || bits > storage) {
+        return false;
+    }
+
+    // elements are laid out in index order, keep the table sorted
+    uint8_t i = _scan_count;
+    while (i > 0 && _scan[i-1].index > index) {
+        _scan[i] = _scan[i-1];
+        i--;
+    }
+    struct scan_element &e = _scan[i];
+    e.channel = channel;
+    e.index = index;
+    e.storage_bytes = storage / 8;
+    e.bits = bits;
+    e.shift = shift;
+    e.is_signed = (sign == 's');
+    e.big_endian = (endian == 'b');
+    _scan_count++;
+    return true;
+}
+
+bool AnalogIn_IIO::_init_buffer(void)
+{
+    Linux::Util *util = Linux::Util::from(hal.util);
+
+    // the buffer must be disabled to change the scan
+    util->write_file(IIO_ANALOG_IN_DIR "buffer/enable", "0");
+
+    for (uint8_t i = 0; i < IIO_ANALOG_IN_COUNT; i++) {
+        char path[100];
+        snprintf(path, sizeof(path), IIO_ANALOG_IN_DIR "scan_elements/in_voltage%u_en", i);
+        if (util->write_file(path, "1") < 0) {
+            // the device has fewer channels
+            break;
+        }
+        if (!_read_scan_type(i)) {
+            return false;
+        }
+    }
+    if (_scan_count == 0) {
+        return false;
+    }
+
+    // each element is aligned to its own size
+    for (uint8_t i = 0; i < _scan_count; i++) {
+        const uint8_t size = _scan[i].storage_bytes;
+        _scan_size = (_scan_size + size - 1) / size * size;
+        _scan[i].offset = _scan_size;
+        _scan_size += size;
+    }
+
+    if (util->write_file(IIO_ANALOG_IN_DIR "buffer/length", "%u", IIO_BUFFER_LENGTH) < 0 ||
+        util->write_file(IIO_ANALOG_IN_DIR "buffer/enable", "1") < 0) {
+        return false;
+    }
+
+    _buffer_fd = open(IIO_ANALOG_IN_DEV, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (_buffer_fd == -1) {
+        util->write_file(IIO_ANALOG_IN_DIR "buffer/enable", "0");
+        return false;
+    }
+    return true;
+}
+
+/*
+  drain the scans captured since the last call and average them into
+  the sources
+ */
+void AnalogIn_IIO::_timer_tick(void)
+{
+    const uint32_t now = AP_HAL::micros();
+    if (now - _last_run_us < 1000000UL / IIO_BUFFER_READ_HZ) {
+        return;
+    }
+    _last_run_us = now;
+
+    uint8_t buf[IIO_BUFFER_LENGTH * 4 * IIO_ANALOG_IN_COUNT];
+    const ssize_t ret = ::read(_buffer_fd, buf, (sizeof(buf) / _scan_size) * _scan_size);
+    if (ret <= 0) {
+        return;
+    }
+
+    for (ssize_t ofs = 0; ofs + _scan_size <= ret; ofs += _scan_size) {
+        for (uint8_t i = 0; i < _scan_count; i++) {
+            const struct scan_element &e = _scan[i];
+            const uint8_t *p = &buf[ofs + e.offset];
+            uint32_t raw = 0;
+            for (uint8_t b = 0; b < e.storage_bytes; b++) {
+                const uint8_t byte = e.big_endian ? p[b] : p[e.storage_bytes - 1 - b];
+                raw = (raw << 8) | byte;
+            }
+            raw >>= e.shift;
+            int32_t value;
+            if (e.bits < 32) {
+                raw &= (1UL << e.bits) - 1;
+                if (e.is_signed && (raw & (1UL << (e.bits - 1)))) {
+                    value = (int32_t)(raw | ~((1UL << e.bits) - 1));
+                } else {
+                    value = raw;
+                }
+            } else {
+                value = (int32_t)raw;
+            }
+            for (uint8_t j = 0; j < _num_channels; j++) {
+                if (_channels[j]->_pin == e.channel) {
+                    _channels[j]->_add_value(value);
+                }
+            }
+        }
+    }
+}
 
 AP_HAL::AnalogSource* AnalogIn_IIO::channel(int16_t pin) {
-    return new AnalogSource_IIO(pin, 0.0f, IIO_VOLTAGE_SCALING);
+    if (_buffer_fd == -1) {
+        return new AnalogSource_IIO(pin, 0.0f, IIO_VOLTAGE_SCALING, false);
+    }
+    if (_num_channels >= IIO_MAX_SOURCES) {
+        AP_HAL::panic("AnalogIn_IIO: too many analog sources");
+    }
+    AnalogSource_IIO *source = new AnalogSource_IIO(pin, 0.0f, IIO_VOLTAGE_SCALING, true);
+    hal.scheduler->suspend_timer_procs();
+    _channels[_num_channels++] = source;
+    hal.scheduler->resume_timer_procs();
+    return source;
 }
@@ -8,6 +8,13 @@
 
 #define IIO_ANALOG_IN_COUNT 8
 #define IIO_ANALOG_IN_DIR "/sys/bus/iio/devices/iio:device0/"
+#define IIO_ANALOG_IN_DEV "/dev/iio:device0"
+
+// scans held by the kernel buffer in buffered capture mode
+#define IIO_BUFFER_LENGTH 64
+// rate at which the buffer is drained
+#define IIO_BUFFER_READ_HZ 100
+#define IIO_MAX_SOURCES 16
 
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
 // Note that echo BB-ADC cape should be loaded
@@ -23,7 +30,8 @@
 class AnalogSource_IIO : public AP_HAL::AnalogSource {
 public:
     friend class AnalogIn_IIO;
-    AnalogSource_IIO(int16_t pin, float initial_value, float voltage_scaling);
+    AnalogSource_IIO(int16_t pin, float initial_value, float voltage_scaling,
+                     bool buffered);
     float read_average();
     float read_latest();
     void set_pin(uint8_t p);
@@ -42,8 +50,12 @@ private:
     int         _pin_fd;
     int         fd_analog_sources[IIO_ANALOG_IN_COUNT];
 
+    // samples are pushed by AnalogIn_IIO rather than read from sysfs
+    bool        _buffered;
+
     void init_pins(void);
     void select_pin(void);
+    void _add_value(float v);
 
     static const char *analog_sources[];
 };
@@ -56,4 +68,34 @@ public:
 
     // we don't yet know how to get the board voltage
     float board_voltage(void) { return 5.0f; }
+
+private:
+    /*
+      buffered capture: all channels are enabled in the IIO scan and
+      the binary scans are read from the character device in one
+      read(), with every sample averaged into the sources. Without
+      buffer support each source reads its sysfs file when asked
+     */
+    bool _init_buffer(void);
+    bool _read_scan_type(uint8_t channel);
+    void _timer_tick(void);
+
+    struct scan_element {
+        uint8_t channel;
+        uint8_t index;          // position in the scan
+        uint8_t offset;         // byte offset within a scan
+        uint8_t storage_bytes;
+        uint8_t bits;
+        uint8_t shift;
+        bool is_signed;
+        bool big_endian;
+    } _scan[IIO_ANALOG_IN_COUNT];
+    uint8_t _scan_count;
+    uint8_t _scan_size;
+
+    int _buffer_fd;
+    uint32_t _last_run_us;
+
+    AnalogSource_IIO *_channels[IIO_MAX_SOURCES];
+    uint8_t _num_channels;
 };
@@ -0,0 +1,37 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "AP_HAL_Linux.h"
+
+namespace Linux {
+
+/*
+ * Optical flow algorithm run by OpticalFlow_Onboard on pairs of 8bpp frames
+ */
+class Flow {
+public:
+    virtual ~Flow() { }
+
+    /*
+     * Compute the flow in pixels from image1 to image2, taken delta_time
+     * microseconds apart. Returns a quality from 0 (no flow found) to 255.
+     */
+    virtual uint8_t compute_flow(uint8_t *image1, uint8_t *image2,
+                                 uint32_t delta_time, float *pixel_flow_x,
+                                 float *pixel_flow_y) = 0;
+};
+
+}
@@ -15,17 +15,18 @@
 #pragma once
 
 #include "AP_HAL_Linux.h"
+#include "Flow.h"
 
 namespace Linux {
 
-class Flow_PX4 {
+class Flow_PX4 : public Flow {
 public:
     Flow_PX4(uint32_t width, uint32_t bytesperline,
              uint32_t max_flow_pixel,
              float bottom_flow_feature_threshold,
              float bottom_flow_value_threshold);
     uint8_t compute_flow(uint8_t *image1, uint8_t *image2, uint32_t delta_time,
-                         float *pixel_flow_x, float *pixel_flow_y);
+                         float *pixel_flow_x, float *pixel_flow_y) override;
 private:
     uint32_t _width;
     uint32_t _search_size;
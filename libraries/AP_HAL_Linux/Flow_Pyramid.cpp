@@ -0,0 +1,378 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_HAL/AP_HAL.h>
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BEBOP ||\
+    CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_MINLURE ||\
+    CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BBBMINI
+#include "Flow_Pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "VideoIn.h"
+
+/* tracking stops at a level once the update is this small, in pixels */
+#define FLOW_PYRAMID_EPSILON 0.01f
+/* points further than this from the median flow are outliers, in pixels */
+#define FLOW_PYRAMID_OUTLIER_DISTANCE 1.0f
+
+using namespace Linux;
+
+/* bilinear sample, clamped to the level borders */
+static inline float sample(const uint8_t *data, uint32_t stride,
+                           uint32_t width, uint32_t height, float x, float y)
+{
+    x = std::min(std::max(x, 0.0f), width - 1.001f);
+    y = std::min(std::max(y, 0.0f), height - 1.001f);
+
+    const int ix = (int)x;
+    const int iy = (int)y;
+    const float ax = x - ix;
+    const float ay = y - iy;
+    const uint8_t *p = data + iy * stride + ix;
+
+    const float top = p[0] + ax * (p[1] - p[0]);
+    const float bottom = p[stride] + ax * (p[stride + 1] - p[stride]);
+
+    return top + ay * (bottom - top);
+}
+
+/*
+ * Sample a size x size patch with its top left corner at (x, y). All the
+ * pixels share the same sub-pixel offset, so the weights are computed once
+ * unless the patch crosses the borders.
+ */
+static void sample_patch(const uint8_t *data, uint32_t stride,
+                         uint32_t width, uint32_t height, float x, float y,
+                         int size, float *out)
+{
+    const float fx = floorf(x);
+    const float fy = floorf(y);
+
+    if (fx < 0 || fy < 0 || fx + size >= width || fy + size >= height) {
+        for (int v = 0; v < size; v++) {
+            for (int u = 0; u < size; u++) {
+                *out++ = sample(data, stride, width, height, x + u, y + v);
+            }
+        }
+        return;
+    }
+
+    const float ax = x - fx;
+    const float ay = y - fy;
+    const float w00 = (1 - ax) * (1 - ay);
+    const float w01 = ax * (1 - ay);
+    const float w10 = (1 - ax) * ay;
+    const float w11 = ax * ay;
+    const uint8_t *row = data + (int)fy * stride + (int)fx;
+
+    for (int v = 0; v < size; v++, row += stride) {
+        const uint8_t *p = row;
+        for (int u = 0; u < size; u++, p++) {
+            *out++ = w00 * p[0] + w01 * p[1] + w10 * p[stride] + w11 * p[stride + 1];
+        }
+    }
+}
+
+Flow_Pyramid::Flow_Pyramid(uint32_t width, uint32_t height,
+                           uint32_t bytesperline, uint8_t levels,
+                           uint8_t threads, int prio, float min_eigenvalue,
+                           float max_residual)
+    : _width(width)
+    , _height(height)
+    , _bytesperline(bytesperline)
+    , _min_eigenvalue(min_eigenvalue)
+    , _max_residual(max_residual)
+    , _pyramids()
+    , _last(0)
+    , _from(nullptr)
+    , _to(nullptr)
+    , _workers()
+    , _exit(false)
+{
+    /* stop before a level gets smaller than the tracked window */
+    _levels = 1;
+    while (_levels < std::min<uint8_t>(levels, LINUX_FLOW_PYRAMID_MAX_LEVELS) &&
+           (width >> _levels) > 2 * LINUX_FLOW_PYRAMID_WINDOW &&
+           (height >> _levels) > 2 * LINUX_FLOW_PYRAMID_WINDOW) {
+        _levels++;
+    }
+
+    /* level 0 is read from the image itself */
+    uint32_t size = 0;
+    for (uint8_t l = 1; l < _levels; l++) {
+        size += (width >> l) * (height >> l);
+    }
+    for (Pyramid &pyramid : _pyramids) {
+        if (size > 0) {
+            pyramid.buffer = (uint8_t *)malloc(size);
+            if (pyramid.buffer == nullptr) {
+                AP_HAL::panic("Flow_Pyramid: couldn't allocate pyramid");
+            }
+        }
+    }
+
+    /* a regular grid of points, kept clear of the borders at level 0 */
+    const float margin = LINUX_FLOW_PYRAMID_HALF_WINDOW + 1;
+    const float step_x = (width - 2 * margin) / (LINUX_FLOW_PYRAMID_GRID - 1);
+    const float step_y = (height - 2 * margin) / (LINUX_FLOW_PYRAMID_GRID - 1);
+    for (uint8_t j = 0; j < LINUX_FLOW_PYRAMID_GRID; j++) {
+        for (uint8_t i = 0; i < LINUX_FLOW_PYRAMID_GRID; i++) {
+            _point_x[j * LINUX_FLOW_PYRAMID_GRID + i] = margin + i * step_x;
+            _point_y[j * LINUX_FLOW_PYRAMID_GRID + i] = margin + j * step_y;
+        }
+    }
+
+    /* the calling thread tracks its share of the points too */
+    _threads = std::max<uint8_t>(1, std::min<uint8_t>(threads, LINUX_FLOW_PYRAMID_MAX_THREADS));
+    if (_threads == 1) {
+        return;
+    }
+
+    if (pthread_barrier_init(&_start_barrier, nullptr, _threads) != 0 ||
+        pthread_barrier_init(&_done_barrier, nullptr, _threads) != 0) {
+        AP_HAL::panic("Flow_Pyramid: couldn't init barriers");
+    }
+
+    for (uint8_t i = 1; i < _threads; i++) {
+        char name[16];
+
+        snprintf(name, sizeof(name), "ap-flow-%u", i);
+        _workers[i] = new Worker(*this, i);
+        if (!_workers[i]->start(name, SCHED_FIFO, prio)) {
+            AP_HAL::panic("Flow_Pyramid: couldn't start worker thread");
+        }
+    }
+}
+
+Flow_Pyramid::~Flow_Pyramid()
+{
+    if (_threads > 1) {
+        _exit = true;
+        pthread_barrier_wait(&_start_barrier);
+        pthread_barrier_wait(&_done_barrier);
+
+        for (uint8_t i = 1; i < _threads; i++) {
+            delete _workers[i];
+        }
+        pthread_barrier_destroy(&_start_barrier);
+        pthread_barrier_destroy(&_done_barrier);
+    }
+
+    for (Pyramid &pyramid : _pyramids) {
+        free(pyramid.buffer);
+    }
+}
+
+void Flow_Pyramid::_build_pyramid(Pyramid &pyramid, const uint8_t *image)
+{
+    uint8_t *buffer = pyramid.buffer;
+
+    pyramid.source = image;
+    pyramid.levels[0] = { image, _width, _height, _bytesperline };
+
+    for (uint8_t l = 1; l < _levels; l++) {
+        const Level &prev = pyramid.levels[l - 1];
+        Level &level = pyramid.levels[l];
+
+        level.width = prev.width / 2;
+        level.height = prev.height / 2;
+        level.stride = level.width;
+        level.data = buffer;
+
+        VideoIn::shrink_8bpp((uint8_t *)prev.data, buffer, prev.stride,
+                             prev.height, 0, level.width * 2, 0,
+                             level.height * 2, 2, 2);
+        buffer += level.width * level.height;
+    }
+}
+
+bool Flow_Pyramid::_track(float x0, float y0, PointFlow &flow) const
+{
+    const int hw = LINUX_FLOW_PYRAMID_HALF_WINDOW;
+    const int w = LINUX_FLOW_PYRAMID_WINDOW;
+    const int n = LINUX_FLOW_PYRAMID_WINDOW * LINUX_FLOW_PYRAMID_WINDOW;
+    /* the template with a one pixel border for the gradients */
+    float patch[(LINUX_FLOW_PYRAMID_WINDOW + 2) * (LINUX_FLOW_PYRAMID_WINDOW + 2)];
+    float tmpl[n], grad_x[n], grad_y[n], warped[n];
+    float gx = 0.0f, gy = 0.0f;
+    float residual = 0.0f;
+
+    for (int l = _levels - 1; l >= 0; l--) {
+        const Level &a = _from->levels[l];
+        const Level &b = _to->levels[l];
+        const float x = x0 / (1 << l) - hw;
+        const float y = y0 / (1 << l) - hw;
+        float gxx = 0.0f, gxy = 0.0f, gyy = 0.0f;
+
+        /* template and its gradients, fixed for the iterations */
+        sample_patch(a.data, a.stride, a.width, a.height, x - 1, y - 1,
+                     w + 2, patch);
+        for (int v = 0, k = 0; v < w; v++) {
+            const float *p = patch + (v + 1) * (w + 2) + 1;
+            for (int u = 0; u < w; u++, k++, p++) {
+                tmpl[k] = p[0];
+                grad_x[k] = 0.5f * (p[1] - p[-1]);
+                grad_y[k] = 0.5f * (p[w + 2] - p[-(w + 2)]);
+                gxx += grad_x[k] * grad_x[k];
+                gxy += grad_x[k] * grad_y[k];
+                gyy += grad_y[k] * grad_y[k];
+            }
+        }
+
+        /* smaller eigenvalue of the structure tensor: a flat or edge-only
+         * window can't be tracked reliably */
+        const float min_eigenvalue = 0.5f * (gxx + gyy) -
+            sqrtf(0.25f * (gxx - gyy) * (gxx - gyy) + gxy * gxy);
+        const float det = gxx * gyy - gxy * gxy;
+        if (min_eigenvalue / n < _min_eigenvalue || det <= 0.0f) {
+            if (l == 0) {
+                return false;
+            }
+            /* keep the coarser estimate for the next level */
+            gx *= 2;
+            gy *= 2;
+            continue;
+        }
+
+        for (uint8_t i = 0; i < LINUX_FLOW_PYRAMID_ITERATIONS; i++) {
+            float bx = 0.0f, by = 0.0f;
+
+            sample_patch(b.data, b.stride, b.width, b.height, x + gx, y + gy,
+                         w, warped);
+            residual = 0.0f;
+            for (int k = 0; k < n; k++) {
+                const float diff = warped[k] - tmpl[k];
+                bx += diff * grad_x[k];
+                by += diff * grad_y[k];
+                residual += fabsf(diff);
+            }
+
+            const float dx = (gxy * by - gyy * bx) / det;
+            const float dy = (gxy * bx - gxx * by) / det;
+            gx += dx;
+            gy += dy;
+            if (fabsf(dx) + fabsf(dy) < FLOW_PYRAMID_EPSILON) {
+                break;
+            }
+        }
+
+        if (l > 0) {
+            gx *= 2;
+            gy *= 2;
+        }
+    }
+
+    /* the point left the image or doesn't match anymore */
+    if (x0 + gx < hw || x0 + gx > _width - hw - 1 ||
+        y0 + gy < hw || y0 + gy > _height - hw - 1 ||
+        residual / n > _max_residual) {
+        return false;
+    }
+
+    flow.x = gx;
+    flow.y = gy;
+    return true;
+}
+
+void Flow_Pyramid::_track_points(uint8_t index)
+{
+    for (uint8_t i = index; i < LINUX_FLOW_PYRAMID_POINTS; i += _threads) {
+        _point_flow[i].valid = _track(_point_x[i], _point_y[i], _point_flow[i]);
+    }
+}
+
+void Flow_Pyramid::_worker_loop(uint8_t index)
+{
+    while (true) {
+        pthread_barrier_wait(&_start_barrier);
+        if (_exit) {
+            pthread_barrier_wait(&_done_barrier);
+            return;
+        }
+        _track_points(index);
+        pthread_barrier_wait(&_done_barrier);
+    }
+}
+
+uint8_t Flow_Pyramid::compute_flow(uint8_t *image1, uint8_t *image2,
+                                   uint32_t delta_time, float *pixel_flow_x,
+                                   float *pixel_flow_y)
+{
+    /* consecutive frames share an image: only build the new pyramid */
+    if (_pyramids[_last].source != image1) {
+        _build_pyramid(_pyramids[_last], image1);
+    }
+    _build_pyramid(_pyramids[!_last], image2);
+    _from = &_pyramids[_last];
+    _to = &_pyramids[!_last];
+    _last = !_last;
+
+    if (_threads > 1) {
+        pthread_barrier_wait(&_start_barrier);
+    }
+    _track_points(0);
+    if (_threads > 1) {
+        pthread_barrier_wait(&_done_barrier);
+    }
+
+    float xs[LINUX_FLOW_PYRAMID_POINTS];
+    float ys[LINUX_FLOW_PYRAMID_POINTS];
+    uint8_t valid = 0;
+    for (const PointFlow &flow : _point_flow) {
+        if (flow.valid) {
+            xs[valid] = flow.x;
+            ys[valid] = flow.y;
+            valid++;
+        }
+    }
+
+    *pixel_flow_x = 0.0f;
+    *pixel_flow_y = 0.0f;
+    if (valid == 0) {
+        return 0;
+    }
+
+    /* median flow, then the mean of the points agreeing with it */
+    std::nth_element(xs, xs + valid / 2, xs + valid);
+    std::nth_element(ys, ys + valid / 2, ys + valid);
+    const float median_x = xs[valid / 2];
+    const float median_y = ys[valid / 2];
+
+    float sum_x = 0.0f, sum_y = 0.0f;
+    uint8_t inliers = 0;
+    for (const PointFlow &flow : _point_flow) {
+        if (flow.valid &&
+            fabsf(flow.x - median_x) <= FLOW_PYRAMID_OUTLIER_DISTANCE &&
+            fabsf(flow.y - median_y) <= FLOW_PYRAMID_OUTLIER_DISTANCE) {
+            sum_x += flow.x;
+            sum_y += flow.y;
+            inliers++;
+        }
+    }
+
+    /* too few points agree to trust the flow */
+    if (inliers < LINUX_FLOW_PYRAMID_POINTS / 4) {
+        return 0;
+    }
+
+    *pixel_flow_x = sum_x / inliers;
+    *pixel_flow_y = sum_y / inliers;
+
+    return inliers * 255 / LINUX_FLOW_PYRAMID_POINTS;
+}
+#endif
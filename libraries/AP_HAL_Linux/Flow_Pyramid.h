@@ -0,0 +1,117 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <pthread.h>
+
+#include "AP_HAL_Linux.h"
+#include "Flow.h"
+#include "Thread.h"
+
+#define LINUX_FLOW_PYRAMID_MAX_LEVELS   4
+#define LINUX_FLOW_PYRAMID_MAX_THREADS  4
+/* tracked points along each side of the image */
+#define LINUX_FLOW_PYRAMID_GRID         8
+#define LINUX_FLOW_PYRAMID_POINTS       (LINUX_FLOW_PYRAMID_GRID * LINUX_FLOW_PYRAMID_GRID)
+/* the tracked window is (2 * half window + 1) pixels square */
+#define LINUX_FLOW_PYRAMID_HALF_WINDOW  3
+#define LINUX_FLOW_PYRAMID_WINDOW       (2 * LINUX_FLOW_PYRAMID_HALF_WINDOW + 1)
+#define LINUX_FLOW_PYRAMID_ITERATIONS   8
+
+namespace Linux {
+
+/*
+ * Pyramidal Lucas-Kanade flow: a grid of points is tracked from coarse to
+ * fine over an image pyramid, giving sub-pixel flow with a search range
+ * growing with the number of levels. The points are shared among threads.
+ * The flow is the mean of the points agreeing with the median flow and
+ * the quality is the share of those points.
+ */
+class Flow_Pyramid : public Flow {
+public:
+    Flow_Pyramid(uint32_t width, uint32_t height, uint32_t bytesperline,
+                 uint8_t levels, uint8_t threads, int prio,
+                 float min_eigenvalue, float max_residual);
+    ~Flow_Pyramid();
+
+    uint8_t compute_flow(uint8_t *image1, uint8_t *image2, uint32_t delta_time,
+                         float *pixel_flow_x, float *pixel_flow_y) override;
+
+private:
+    struct Level {
+        const uint8_t *data;
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+    };
+
+    struct Pyramid {
+        /* image the pyramid was built from, level 0 */
+        const uint8_t *source;
+        Level levels[LINUX_FLOW_PYRAMID_MAX_LEVELS];
+        uint8_t *buffer;
+    };
+
+    struct PointFlow {
+        float x;
+        float y;
+        bool valid;
+    };
+
+    class Worker : public Thread {
+    public:
+        Worker(Flow_Pyramid &flow, uint8_t index)
+            : Thread(FUNCTOR_BIND_MEMBER(&Worker::_loop, void))
+            , _flow(flow)
+            , _index(index)
+        { }
+
+    protected:
+        void _loop() { _flow._worker_loop(_index); }
+
+        Flow_Pyramid &_flow;
+        uint8_t _index;
+    };
+
+    void _build_pyramid(Pyramid &pyramid, const uint8_t *image);
+    void _track_points(uint8_t index);
+    bool _track(float x0, float y0, PointFlow &flow) const;
+    void _worker_loop(uint8_t index);
+
+    uint32_t _width;
+    uint32_t _height;
+    uint32_t _bytesperline;
+    uint8_t _levels;
+    uint8_t _threads;
+    float _min_eigenvalue;
+    float _max_residual;
+
+    /* the pyramid of the last image2, reused as the next image1 */
+    Pyramid _pyramids[2];
+    uint8_t _last;
+    const Pyramid *_from;
+    const Pyramid *_to;
+
+    float _point_x[LINUX_FLOW_PYRAMID_POINTS];
+    float _point_y[LINUX_FLOW_PYRAMID_POINTS];
+    PointFlow _point_flow[LINUX_FLOW_PYRAMID_POINTS];
+
+    Worker *_workers[LINUX_FLOW_PYRAMID_MAX_THREADS];
+    pthread_barrier_t _start_barrier;
+    pthread_barrier_t _done_barrier;
+    volatile bool _exit;
+};
+
+}
@@ -32,6 +32,7 @@ union gpio_params {
     char export_gpio[sizeof("export")];
     char direction[sizeof("gpio" UINT32_MAX_STR "/direction")];
     char value[sizeof("gpio" UINT32_MAX_STR "/value")];
+    char edge[sizeof("gpio" UINT32_MAX_STR "/edge")];
 };
 
 #define GPIO_BASE_PATH "/sys/class/gpio/"
@@ -201,6 +202,40 @@ bool GPIO_Sysfs::attach_interrupt(uint8_t interrupt_num, AP_HAL::Proc p,
     return false;
 }
 
+int GPIO_Sysfs::open_edge_fd(uint8_t vpin)
+{
+    assert_vpin(vpin, n_pins, -1);
+
+    const unsigned pin = pin_table[vpin];
+    char path[GPIO_PATH_MAX];
+
+    if (!_export_pin(vpin)) {
+        return -1;
+    }
+    _pinMode(pin, HAL_GPIO_INPUT);
+
+    int r = snprintf(path, GPIO_PATH_MAX, GPIO_BASE_PATH "gpio%u/edge", pin);
+    if (r < 0 || r >= (int)GPIO_PATH_MAX
+        || Util::from(hal.util)->write_file(path, "%s", "rising") < 0) {
+        hal.console->printf("GPIO_Sysfs: Unable to set pin %u edge.\n", pin);
+        return -1;
+    }
+
+    int fd = _open_pin_value(pin, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* consume the current state so only new edges are reported */
+    char char_value;
+    if (::pread(fd, &char_value, 1, 0) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
 bool GPIO_Sysfs::usb_connected(void)
 {
     return false;
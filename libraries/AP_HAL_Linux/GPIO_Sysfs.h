@@ -64,6 +64,14 @@ public:
      */
     bool usb_connected() override;
 
+    /*
+     * Configure pin as an input raising an event on rising edges and
+     * return a file descriptor to wait for them with POLLPRI, or -1 on
+     * failure. The caller owns the descriptor and must pread() it after
+     * each event.
+     */
+    int open_edge_fd(uint8_t vpin);
+
 protected:
     void _pinMode(unsigned int pin, uint8_t output);
     int _open_pin_value(unsigned int pin, int flags);
@@ -257,6 +257,9 @@ void _usage(void)
     printf("\tnetworking UDP:\n");
     printf("\t                  -A udp:11.0.0.255:14550:bcast\n");
     printf("\t                  -A udpin:0.0.0.0:14550\n");
+    printf("\t                  -A udp:11.0.0.2,11.0.0.3:14550\n");
+    printf("\tshared memory with a local process:\n");
+    printf("\t                  -C shm:/ardupilot-mav\n");
     printf("\tcustom log path:\n");
     printf("\t                  --log-directory /var/APM/logs\n");
     printf("\t                  -l /var/APM/logs\n");
@@ -266,6 +269,12 @@ void _usage(void)
     printf("\tmodule support:\n");
     printf("\t                   --module-directory %s\n", AP_MODULE_DEFAULT_DIRECTORY);
     printf("\t                   -M %s\n", AP_MODULE_DEFAULT_DIRECTORY);
+    printf("\tthread priority and CPU mask:\n");
+    printf("\t                   --thread ap-spi-0:15:0x8\n");
+    printf("\t                   -b ap-io-1:9\n");
+    printf("\treal-time memory, prefaulted heap pool in kB:\n");
+    printf("\t                   --rt-memory 4096\n");
+    printf("\t                   -r 4096\n");
 }
 
 void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
@@ -289,11 +298,14 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         {"log-directory",       true,  0, 'l'},
         {"terrain-directory",   true,  0, 't'},
         {"module-directory",    true,  0, 'M'},
+        {"thread",              true,  0, 'b'},
+        {"bus-thread",          true,  0, 'b'},
+        {"rt-memory",           true,  0, 'r'},
         {"help",                false,  0, 'h'},
         {0, false, 0, 0}
     };
 
-    GetOptLong gopt(argc, argv, "A:B:C:D:E:F:l:t:he:SM:",
+    GetOptLong gopt(argc, argv, "A:B:C:D:E:F:l:t:he:SM:b:r:",
                     options);
 
     /*
@@ -336,6 +348,15 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         case 'M':
             module_path = gopt.optarg;
             break;
+        case 'b':
+            if (!schedulerInstance.set_thread_config(gopt.optarg)) {
+                printf("Invalid thread config '%s'\n", gopt.optarg);
+                exit(1);
+            }
+            break;
+        case 'r':
+            schedulerInstance.set_rt_memory(strtoul(gopt.optarg, nullptr, 0));
+            break;
         case 'h':
             _usage();
             exit(0);
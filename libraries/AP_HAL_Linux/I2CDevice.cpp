@@ -45,6 +45,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 
+#include "GPIO.h"
 #include "PollerThread.h"
 #include "Scheduler.h"
 #include "Semaphores.h"
@@ -87,6 +88,8 @@ public:
     void start_cb() override;
     void end_cb() override;
 
+    void start_thread();
+
     int open(uint8_t n);
 
     PollerThread thread;
@@ -113,6 +116,26 @@ void I2CBus::end_cb()
     sem.give();
 }
 
+void I2CBus::start_thread()
+{
+    if (thread.is_started()) {
+        return;
+    }
+
+    char name[16];
+    snprintf(name, sizeof(name), "ap-i2c-%u", bus);
+    sem.set_name(name + 3);
+
+    int prio;
+    uint32_t cpu_mask;
+    Scheduler::from(hal.scheduler)->get_thread_config(name, AP_LINUX_SENSORS_SCHED_PRIO,
+                                                     prio, cpu_mask);
+
+    thread.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
+    thread.set_cpu_affinity(cpu_mask);
+    thread.start(name, AP_LINUX_SENSORS_SCHED_POLICY, prio);
+}
+
 int I2CBus::open(uint8_t n)
 {
     char path[sizeof("/dev/i2c-XXX")];
@@ -245,16 +268,31 @@ AP_HAL::Device::PeriodicHandle I2CDevice::register_periodic_callback(
         AP_HAL::panic("Could not create periodic callback");
     }
 
-    if (!_bus.thread.is_started()) {
-        char name[16];
-        snprintf(name, sizeof(name), "ap-i2c-%u", _bus.bus);
+    _bus.start_thread();
+
+    return static_cast<AP_HAL::Device::PeriodicHandle>(p);
+}
+
+AP_HAL::Device::PeriodicHandle I2CDevice::register_data_ready_callback(
+    uint8_t gpio_pin, uint32_t timeout_usec, AP_HAL::Device::PeriodicCb cb)
+{
+#ifdef LINUX_GPIO_SYSFS
+    int fd = GPIO_Sysfs::from(hal.gpio)->open_edge_fd(gpio_pin);
+    if (fd < 0) {
+        return nullptr;
+    }
 
-        _bus.thread.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
-        _bus.thread.start(name, AP_LINUX_SENSORS_SCHED_POLICY,
-                          AP_LINUX_SENSORS_SCHED_PRIO);
+    TimerPollable *p = _bus.thread.add_data_ready(cb, &_bus, fd, timeout_usec);
+    if (!p) {
+        return nullptr;
     }
 
+    _bus.start_thread();
+
     return static_cast<AP_HAL::Device::PeriodicHandle>(p);
+#else
+    return nullptr;
+#endif
 }
 
 bool I2CDevice::adjust_periodic_callback(
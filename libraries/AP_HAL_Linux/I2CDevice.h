@@ -75,6 +75,11 @@ public:
     bool adjust_periodic_callback(
         AP_HAL::Device::PeriodicHandle h, uint32_t period_usec) override;
 
+    /* See AP_HAL::Device::register_data_ready_callback() */
+    AP_HAL::Device::PeriodicHandle register_data_ready_callback(
+        uint8_t gpio_pin, uint32_t timeout_usec,
+        AP_HAL::Device::PeriodicCb) override;
+
 protected:
     I2CBus &_bus;
     uint8_t _address;
@@ -29,11 +29,37 @@
 #include <vector>
 
 #include "CameraSensor_Mt9v117.h"
+#include "Flow_PX4.h"
+#include "Flow_Pyramid.h"
 #include "GPIO.h"
 #include "PWM_Sysfs.h"
 
 #define OPTICAL_FLOW_ONBOARD_RTPRIO 11
 
+/* boards whose capture driver can't export buffers may use
+ * V4L2_MEMORY_USERPTR, with buffers allocated by VideoIn */
+#ifndef HAL_OPTFLOW_ONBOARD_MEMTYPE
+#define HAL_OPTFLOW_ONBOARD_MEMTYPE V4L2_MEMORY_MMAP
+#endif
+
+/* the pyramidal Lucas-Kanade engine tracks larger and sub-pixel motion
+ * than the px4 block matching, at a higher cost spread over threads */
+#ifndef HAL_OPTFLOW_ONBOARD_FLOW_PYRAMID
+#define HAL_OPTFLOW_ONBOARD_FLOW_PYRAMID 0
+#endif
+#ifndef HAL_FLOW_PYRAMID_LEVELS
+#define HAL_FLOW_PYRAMID_LEVELS 3
+#endif
+#ifndef HAL_FLOW_PYRAMID_THREADS
+#define HAL_FLOW_PYRAMID_THREADS 2
+#endif
+#ifndef HAL_FLOW_PYRAMID_MIN_EIGENVALUE
+#define HAL_FLOW_PYRAMID_MIN_EIGENVALUE 4.0f
+#endif
+#ifndef HAL_FLOW_PYRAMID_MAX_RESIDUAL
+#define HAL_FLOW_PYRAMID_MAX_RESIDUAL 16.0f
+#endif
+
 extern const AP_HAL::HAL& hal;
 
 using namespace Linux;
@@ -42,7 +68,7 @@ void OpticalFlow_Onboard::init(AP_HAL::OpticalFlow::Gyro_Cb get_gyro)
 {
     uint32_t top, left;
     uint32_t crop_width, crop_height;
-    uint32_t memtype = V4L2_MEMORY_MMAP;
+    uint32_t memtype;
     unsigned int nbufs = 0;
     int ret;
     pthread_attr_t attr;
@@ -57,7 +83,7 @@ void OpticalFlow_Onboard::init(AP_HAL::OpticalFlow::Gyro_Cb get_gyro)
     _get_gyro = get_gyro;
     _videoin = new VideoIn;
     const char* device_path = HAL_OPTFLOW_ONBOARD_VDEV_PATH;
-    memtype = V4L2_MEMORY_MMAP;
+    memtype = HAL_OPTFLOW_ONBOARD_MEMTYPE;
     nbufs = HAL_OPTFLOW_ONBOARD_NBUFS;
     _width = HAL_OPTFLOW_ONBOARD_OUTPUT_WIDTH;
     _height = HAL_OPTFLOW_ONBOARD_OUTPUT_HEIGHT;
@@ -162,11 +188,20 @@ void OpticalFlow_Onboard::init(AP_HAL::OpticalFlow::Gyro_Cb get_gyro)
 
     _videoin->prepare_capture();
 
+#if HAL_OPTFLOW_ONBOARD_FLOW_PYRAMID
+    _flow = new Flow_Pyramid(_width, _height, _bytesperline,
+                             HAL_FLOW_PYRAMID_LEVELS,
+                             HAL_FLOW_PYRAMID_THREADS,
+                             OPTICAL_FLOW_ONBOARD_RTPRIO,
+                             HAL_FLOW_PYRAMID_MIN_EIGENVALUE,
+                             HAL_FLOW_PYRAMID_MAX_RESIDUAL);
+#else
     /* Use px4 algorithm for optical flow */
     _flow = new Flow_PX4(_width, _bytesperline,
                          HAL_FLOW_PX4_MAX_FLOW_PIXEL,
                          HAL_FLOW_PX4_BOTTOM_FLOW_FEATURE_THRESHOLD,
                          HAL_FLOW_PX4_BOTTOM_FLOW_VALUE_THRESHOLD);
+#endif
 
     /* Create the thread that will be waiting for frames
      * Initialize thread and mutex */
@@ -231,37 +266,30 @@ void OpticalFlow_Onboard::_run_optflow()
     Vector3f gyro_rate;
     Vector2f flow_rate;
     VideoIn::Frame video_frame;
-    uint32_t convert_buffer_size = 0, output_buffer_size = 0;
+    uint32_t output_buffer_size = 0;
     uint32_t crop_left = 0, crop_top = 0;
     uint32_t shrink_scale = 0, shrink_width = 0, shrink_height = 0;
     uint32_t shrink_width_offset = 0, shrink_height_offset = 0;
-    uint8_t *convert_buffer = NULL, *output_buffer = NULL;
+    uint8_t *output_buffers[2] = { NULL, NULL };
+    uint8_t next_output = 0;
     uint8_t qual;
 
-    if (_format == V4L2_PIX_FMT_YUYV) {
-        if (_shrink_by_software || _crop_by_software) {
-            convert_buffer_size = _camera_output_width * _camera_output_height;
-        } else {
-            convert_buffer_size = _width * _height;
-        }
-
-        convert_buffer = (uint8_t *)malloc(convert_buffer_size);
-        if (!convert_buffer) {
-            AP_HAL::panic("OpticalFlow_Onboard: couldn't allocate conversion buffer\n");
-        }
-    }
-
-    if (_shrink_by_software || _crop_by_software) {
-        output_buffer_size = HAL_OPTFLOW_ONBOARD_OUTPUT_WIDTH *
-            HAL_OPTFLOW_ONBOARD_OUTPUT_HEIGHT;
-
-        output_buffer = (uint8_t *)malloc(output_buffer_size);
-        if (!output_buffer) {
-            if (convert_buffer) {
-                free(convert_buffer);
+    /* Frames that need converting, shrinking or cropping are processed
+     * in a single pass into one of two output buffers, used alternately
+     * as the current and last frame, and the capture buffer is requeued
+     * straight away. Other frames are used in place in the capture
+     * buffer, which is held until the next frame is processed. */
+    const bool process_by_software = _format == V4L2_PIX_FMT_YUYV ||
+        _shrink_by_software || _crop_by_software;
+
+    if (process_by_software) {
+        output_buffer_size = _width * _height;
+
+        for (uint8_t i = 0; i < 2; i++) {
+            output_buffers[i] = (uint8_t *)malloc(output_buffer_size);
+            if (!output_buffers[i]) {
+                AP_HAL::panic("OpticalFlow_Onboard: couldn't allocate output buffer\n");
             }
-
-            AP_HAL::panic("OpticalFlow_Onboard: couldn't allocate crop buffer\n");
         }
     }
 
@@ -289,43 +317,50 @@ void OpticalFlow_Onboard::_run_optflow()
     while(true) {
         /* wait for next frame to come */
         if (!_videoin->get_frame(video_frame)) {
-            if (convert_buffer) {
-               free(convert_buffer);
-            }
-
-            if (output_buffer) {
-               free(output_buffer);
-            }
+            free(output_buffers[0]);
+            free(output_buffers[1]);
 
             AP_HAL::panic("OpticalFlow_Onboard: couldn't get frame\n");
         }
 
-        if (_format == V4L2_PIX_FMT_YUYV) {
-            VideoIn::yuyv_to_grey((uint8_t *)video_frame.data,
-                convert_buffer_size * 2, convert_buffer);
-
-            memset(video_frame.data, 0, convert_buffer_size * 2);
-            memcpy(video_frame.data, convert_buffer, convert_buffer_size);
-        }
+        if (process_by_software) {
+            uint8_t *frame_data = (uint8_t *)video_frame.data;
+            uint8_t *output_buffer = output_buffers[next_output];
+
+            if (_format == V4L2_PIX_FMT_YUYV && _shrink_by_software) {
+                VideoIn::yuyv_to_grey_8bpp(frame_data, output_buffer,
+                                           _camera_output_width,
+                                           shrink_width_offset, shrink_width,
+                                           shrink_height_offset, shrink_height,
+                                           shrink_scale, shrink_scale);
+            } else if (_format == V4L2_PIX_FMT_YUYV && _crop_by_software) {
+                VideoIn::yuyv_to_grey_8bpp(frame_data, output_buffer,
+                                           _camera_output_width,
+                                           crop_left, HAL_OPTFLOW_ONBOARD_OUTPUT_WIDTH,
+                                           crop_top, HAL_OPTFLOW_ONBOARD_OUTPUT_HEIGHT,
+                                           1, 1);
+            } else if (_format == V4L2_PIX_FMT_YUYV) {
+                VideoIn::yuyv_to_grey(frame_data, output_buffer_size * 2,
+                                      output_buffer);
+            } else if (_shrink_by_software) {
+                /* shrink_8bpp() will shrink a selected area using the offsets,
+                 * therefore, we don't need the crop. */
+                VideoIn::shrink_8bpp(frame_data, output_buffer,
+                                     _camera_output_width, _camera_output_height,
+                                     shrink_width_offset, shrink_width,
+                                     shrink_height_offset, shrink_height,
+                                     shrink_scale, shrink_scale);
+            } else {
+                VideoIn::crop_8bpp(frame_data, output_buffer,
+                                   _camera_output_width,
+                                   crop_left, HAL_OPTFLOW_ONBOARD_OUTPUT_WIDTH,
+                                   crop_top, HAL_OPTFLOW_ONBOARD_OUTPUT_HEIGHT);
+            }
 
-        if (_shrink_by_software) {
-            /* shrink_8bpp() will shrink a selected area using the offsets,
-             * therefore, we don't need the crop. */
-            VideoIn::shrink_8bpp((uint8_t *)video_frame.data, output_buffer,
-                                 _camera_output_width, _camera_output_height,
-                                 shrink_width_offset, shrink_width,
-                                 shrink_height_offset, shrink_height,
-                                 shrink_scale, shrink_scale);
-            memset(video_frame.data, 0, _camera_output_width * _camera_output_height);
-            memcpy(video_frame.data, output_buffer, output_buffer_size);
-        } else if (_crop_by_software) {
-            VideoIn::crop_8bpp((uint8_t *)video_frame.data, output_buffer,
-                               _camera_output_width,
-                               crop_left, HAL_OPTFLOW_ONBOARD_OUTPUT_WIDTH,
-                               crop_top, HAL_OPTFLOW_ONBOARD_OUTPUT_HEIGHT);
-
-            memset(video_frame.data, 0, _camera_output_width * _camera_output_height);
-            memcpy(video_frame.data, output_buffer, output_buffer_size);
+            /* the capture buffer can be filled again while we compute */
+            _videoin->put_frame(video_frame);
+            video_frame.data = output_buffer;
+            next_output ^= 1;
         }
 
         /* if it is at least the second frame we receive
@@ -346,7 +381,8 @@ void OpticalFlow_Onboard::_run_optflow()
                 | O_APPEND, S_IRUSR | S_IWUSR | S_IRGRP |
                 S_IWGRP | S_IROTH | S_IWOTH);
 	    if (fd != -1) {
-	        write(fd, video_frame.data, _sizeimage);
+	        write(fd, video_frame.data,
+                  process_by_software ? output_buffer_size : _sizeimage);
 #ifdef OPTICALFLOW_ONBOARD_RECORD_METADATAS
             struct PACKED {
                 uint32_t timestamp;
@@ -388,17 +424,14 @@ void OpticalFlow_Onboard::_run_optflow()
         pthread_mutex_unlock(&_mutex);
 
         /* give the last frame back to the video input driver */
-        _videoin->put_frame(_last_video_frame);
+        if (!process_by_software) {
+            _videoin->put_frame(_last_video_frame);
+        }
         _last_video_frame = video_frame;
         _last_gyro_rate = gyro_rate;
     }
 
-    if (convert_buffer) {
-        free(convert_buffer);
-    }
-
-    if (output_buffer) {
-        free(output_buffer);
-    }
+    free(output_buffers[0]);
+    free(output_buffers[1]);
 }
 #endif
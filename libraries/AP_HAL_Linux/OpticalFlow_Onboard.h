@@ -21,7 +21,7 @@
 
 #include "AP_HAL_Linux.h"
 #include "CameraSensor.h"
-#include "Flow_PX4.h"
+#include "Flow.h"
 #include "PWM_Sysfs.h"
 #include "VideoIn.h"
 
@@ -39,7 +39,7 @@ private:
     VideoIn::Frame _last_video_frame;
     PWM_Sysfs_Base* _pwm;
     CameraSensor* _camerasensor;
-    Flow_PX4* _flow;
+    Flow* _flow;
     pthread_t _thread;
     pthread_mutex_t _mutex;
     bool _initialized;
@@ -16,6 +16,7 @@
  */
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <vector>
 
@@ -44,6 +45,57 @@ static inline uint64_t now_nsec()
     return ts.tv_nsec + (ts.tv_sec * NSEC_PER_SEC);
 }
 
+/* histogram bucket holding a value in microseconds */
+static uint8_t histogram_bucket(uint64_t us)
+{
+    if (us < PERF_HISTOGRAM_SUB_BUCKETS) {
+        return us;
+    }
+
+    /* the top two bits below the leading one pick the sub bucket */
+    const uint8_t exp = 63 - __builtin_clzll(us);
+    if (exp >= PERF_HISTOGRAM_MAX_EXP) {
+        return PERF_HISTOGRAM_BUCKETS - 1;
+    }
+    return PERF_HISTOGRAM_SUB_BUCKETS * (exp - 1) +
+        (us >> (exp - 2)) - PERF_HISTOGRAM_SUB_BUCKETS;
+}
+
+/* smallest value in microseconds above every value of a bucket */
+static uint32_t histogram_bucket_end(uint8_t bucket)
+{
+    if (bucket < PERF_HISTOGRAM_SUB_BUCKETS) {
+        return bucket + 1;
+    }
+
+    const uint8_t exp = bucket / PERF_HISTOGRAM_SUB_BUCKETS + 1;
+    const uint8_t sub = bucket % PERF_HISTOGRAM_SUB_BUCKETS;
+    return (PERF_HISTOGRAM_SUB_BUCKETS + sub + 1) << (exp - 2);
+}
+
+uint32_t Perf_Counter::percentile_us(float pct) const
+{
+    uint64_t samples = 0;
+    for (uint8_t i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+        samples += __atomic_load_n(&histogram[i], __ATOMIC_RELAXED);
+    }
+    if (samples == 0) {
+        return 0;
+    }
+
+    const uint32_t max_us = max / NSEC_PER_USEC;
+    const uint64_t threshold = ceil(samples * pct / 100);
+    uint64_t sum = 0;
+    for (uint8_t i = 0; i < PERF_HISTOGRAM_BUCKETS - 1; i++) {
+        sum += __atomic_load_n(&histogram[i], __ATOMIC_RELAXED);
+        if (sum >= threshold) {
+            return MIN(histogram_bucket_end(i), max_us);
+        }
+    }
+
+    return max_us;
+}
+
 Perf *Perf::get_instance()
 {
     if (!_instance) {
@@ -82,6 +134,13 @@ void Perf::_debug_counters()
                     "avg: %.4f\t"
                     "stddev: %.4f\n",
                     c.name, c.count, c.min, c.max, c.avg, sqrt(c.m2));
+            fprintf(stderr, "%-30s\t"
+                    "p50: %u\tp99: %u\tp99.9: %u (us)\n",
+                    "", c.percentile_us(50), c.percentile_us(99),
+                    c.percentile_us(99.9));
+            if (c.max_note[0] != '\0') {
+                fprintf(stderr, "%-30s\tmax during: %s\n", "", c.max_note);
+            }
         } else {
             fprintf(stderr, "%-30s\t"
                     "count: %" PRIu64 "\n",
@@ -161,7 +220,54 @@ void Perf::end(Util::perf_counter_t pc)
 
     _update_count++;
 
-    const uint64_t elapsed = now_nsec() - perf.start;
+    _update_stats(perf, now_nsec() - perf.start);
+    perf.start = 0;
+
+    perf.lttng.end(perf.name);
+}
+
+void Perf::sample(Util::perf_counter_t pc, uint64_t elapsed_nsec)
+{
+    uintptr_t idx = (uintptr_t)pc;
+
+    if (idx >= _perf_counters.size()) {
+        return;
+    }
+
+    Perf_Counter &perf = _perf_counters[idx];
+    if (perf.type != Util::PC_ELAPSED) {
+        hal.console->printf("perf_sample() called on perf_counter_t(%s) that"
+                            " is not of PC_ELAPSED type.\n",
+                            perf.name);
+        return;
+    }
+
+    _update_count++;
+
+    _update_stats(perf, elapsed_nsec);
+}
+
+void Perf::sample(Util::perf_counter_t pc, uint64_t elapsed_nsec, const char *note)
+{
+    uintptr_t idx = (uintptr_t)pc;
+
+    if (idx >= _perf_counters.size()) {
+        return;
+    }
+
+    Perf_Counter &perf = _perf_counters[idx];
+    const bool new_max = elapsed_nsec > perf.max;
+
+    sample(pc, elapsed_nsec);
+
+    if (new_max && perf.type == Util::PC_ELAPSED) {
+        strncpy(perf.max_note, note, sizeof(perf.max_note) - 1);
+        perf.max_note[sizeof(perf.max_note) - 1] = '\0';
+    }
+}
+
+void Perf::_update_stats(Perf_Counter &perf, uint64_t elapsed)
+{
     perf.count++;
     perf.total += elapsed;
 
@@ -181,12 +287,71 @@ void Perf::end(Util::perf_counter_t pc)
     const double delta_intvl = elapsed - perf.avg;
     perf.avg += (delta_intvl / perf.count);
     perf.m2 += (delta_intvl * (elapsed - perf.avg));
-    perf.start = 0;
 
-    perf.lttng.end(perf.name);
+    __atomic_fetch_add(&perf.histogram[histogram_bucket(elapsed / NSEC_PER_USEC)],
+                       1, __ATOMIC_RELAXED);
+}
+
+bool Perf::get_info(uint16_t idx, AP_HAL::Util::perf_counter_info &info)
+{
+    bool found = false;
+
+    pthread_rwlock_rdlock(&_perf_counters_lock);
+    for (auto &c : _perf_counters) {
+        if (c.type != Util::PC_ELAPSED) {
+            continue;
+        }
+        if (idx-- != 0) {
+            continue;
+        }
+        info.name = c.name;
+        info.count = c.count;
+        info.avg_us = c.avg / NSEC_PER_USEC;
+        info.p50_us = c.percentile_us(50);
+        info.p99_us = c.percentile_us(99);
+        info.p999_us = c.percentile_us(99.9);
+        info.max_us = c.max / NSEC_PER_USEC;
+        found = true;
+        break;
+    }
+    pthread_rwlock_unlock(&_perf_counters_lock);
+
+    return found;
+}
+
+bool Perf::reset(const char *name)
+{
+    bool found = false;
+
+    pthread_rwlock_rdlock(&_perf_counters_lock);
+    for (auto &c : _perf_counters) {
+        if (strcmp(c.name, name) != 0) {
+            continue;
+        }
+        c.count = 0;
+        c.total = 0;
+        c.min = ULONG_MAX;
+        c.max = 0;
+        c.max_note[0] = '\0';
+        c.avg = 0;
+        c.m2 = 0;
+        for (uint8_t i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+            __atomic_store_n(&c.histogram[i], 0, __ATOMIC_RELAXED);
+        }
+        found = true;
+    }
+    _update_count++;
+    pthread_rwlock_unlock(&_perf_counters_lock);
+
+    return found;
 }
 
 void Perf::count(Util::perf_counter_t pc)
+{
+    count(pc, 1);
+}
+
+void Perf::count(Util::perf_counter_t pc, uint64_t n)
 {
     uintptr_t idx = (uintptr_t)pc;
 
@@ -203,7 +368,7 @@ void Perf::count(Util::perf_counter_t pc)
     }
 
     _update_count++;
-    perf.count++;
+    perf.count += n;
 
     perf.lttng.count(perf.name, perf.count);
 }
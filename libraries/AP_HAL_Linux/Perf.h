@@ -26,6 +26,17 @@
 #include "Thread.h"
 #include "Util.h"
 
+/*
+ * Elapsed counters keep a log-linear histogram in microseconds: values
+ * below PERF_HISTOGRAM_SUB_BUCKETS get a bucket each, and every power of
+ * two above is split into PERF_HISTOGRAM_SUB_BUCKETS linear buckets, so a
+ * bucket is never wider than 1/4 of its value. The last bucket holds
+ * everything from 2^PERF_HISTOGRAM_MAX_EXP us (about 1s) up.
+ */
+#define PERF_HISTOGRAM_SUB_BUCKETS 4
+#define PERF_HISTOGRAM_MAX_EXP 20
+#define PERF_HISTOGRAM_BUCKETS (PERF_HISTOGRAM_SUB_BUCKETS * (PERF_HISTOGRAM_MAX_EXP - 1) + 1)
+
 namespace Linux {
 
 class Perf_Counter {
@@ -55,6 +66,15 @@ public:
 
     double avg;
     double m2;
+
+    /* updated with atomic increments so readers don't need a lock */
+    uint32_t histogram[PERF_HISTOGRAM_BUCKETS] {};
+
+    /* caller's note about the sample that set max, e.g. a thread name */
+    char max_note[16] {};
+
+    /* upper bound in microseconds of the bucket holding pct of the samples */
+    uint32_t percentile_us(float pct) const;
 };
 
 class Perf {
@@ -72,6 +92,30 @@ public:
     void end(perf_counter_t pc);
     void count(perf_counter_t pc);
 
+    /* add n events at once to a PC_COUNT counter */
+    void count(perf_counter_t pc, uint64_t n);
+
+    /*
+     * Record a duration measured by the caller, for example how late a
+     * timer fired, on a PC_ELAPSED counter
+     */
+    void sample(perf_counter_t pc, uint64_t elapsed_nsec);
+
+    /*
+     * As above, keeping note with the counter if this sample is the
+     * new max
+     */
+    void sample(perf_counter_t pc, uint64_t elapsed_nsec, const char *note);
+
+    /*
+     * Summary of the idx'th PC_ELAPSED counter, counting elapsed counters
+     * only. Returns false when idx is past the last one.
+     */
+    bool get_info(uint16_t idx, AP_HAL::Util::perf_counter_info &info);
+
+    /* Zero the statistics of every counter called name */
+    bool reset(const char *name);
+
     unsigned int get_update_count() { return _update_count; }
 
 private:
@@ -81,6 +125,8 @@ private:
 
     void _debug_counters();
 
+    void _update_stats(Perf_Counter &perf, uint64_t elapsed);
+
     uint64_t _last_debug_msec;
 
     std::vector<Perf_Counter> _perf_counters;
@@ -56,14 +56,14 @@ void Poller::unregister_pollable(const Pollable *p)
     }
 }
 
-int Poller::poll() const
+int Poller::poll(int timeout_ms) const
 {
     const int max_events = 16;
     epoll_event events[max_events];
     int r;
 
     do {
-        r = epoll_wait(_epfd, events, max_events, -1);
+        r = epoll_wait(_epfd, events, max_events, timeout_ms);
     } while (r < 0 && errno == EINTR);
 
     if (r < 0) {
@@ -76,6 +76,9 @@ int Poller::poll() const
         if (events[i].events & EPOLLIN) {
             p->on_can_read();
         }
+        if (events[i].events & EPOLLPRI) {
+            p->on_priority();
+        }
         if (events[i].events & EPOLLOUT) {
             p->on_can_write();
         }
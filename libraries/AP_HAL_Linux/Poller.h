@@ -37,6 +37,7 @@ public:
     int get_fd() const { return _fd; }
 
     virtual void on_can_read() { }
+    virtual void on_priority() { }
     virtual void on_can_write() { }
     virtual void on_error() { }
     virtual void on_hang_up() { }
@@ -53,7 +54,11 @@ public:
     bool register_pollable(Pollable*, uint32_t events);
     void unregister_pollable(const Pollable*);
 
-    int poll() const;
+    /*
+     * Wait up to timeout_ms for events and dispatch them, -1 to wait
+     * forever. Returns the number of events or a negative errno.
+     */
+    int poll(int timeout_ms = -1) const;
 
 private:
     int _epfd;
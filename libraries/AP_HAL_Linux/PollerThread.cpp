@@ -18,113 +18,277 @@
 
 #include <algorithm>
 #include <poll.h>
+#include <stdio.h>
+#include <string.h>
 #include <sys/epoll.h>
 #include <sys/timerfd.h>
+#include <time.h>
 
 #include <AP_Math/AP_Math.h>
 
+#include "Util.h"
+#include "Perf.h"
+
 namespace Linux {
 
-void TimerPollable::on_can_read()
+static inline uint64_t now_usec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+void TimerPollable::_run_cb()
 {
     if (_removeme) {
         return;
     }
 
-    uint64_t nevents = 0;
-    int r = read(_fd, &nevents, sizeof(nevents));
-    if (r < 0) {
-        return;
+    if (!_perf_allocated) {
+        _alloc_perf_counters();
     }
 
+    Perf *perf = Perf::get_instance();
+
     if (_wrapper) {
         _wrapper->start_cb();
     }
 
+    perf->begin(_perf_run);
     if (!_cb()) {
         _removeme = true;
     }
+    perf->end(_perf_run);
 
     if (_wrapper) {
         _wrapper->end_cb();
     }
 }
 
-bool TimerPollable::setup_timer(uint32_t timeout_usec)
+/*
+ * Counters are named after the thread running the timer, which is only
+ * known once it first fires. They live as long as the process.
+ */
+void TimerPollable::_alloc_perf_counters()
 {
-    if (_fd >= 0) {
-        return false;
-    }
+    char thread_name[16] = "poller";
+    char name[32];
 
-    _fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC|TFD_NONBLOCK);
-    if (_fd < 0) {
-        return false;
-    }
+    pthread_getname_np(pthread_self(), thread_name, sizeof(thread_name));
 
-    if (!adjust_timer(timeout_usec)) {
-        ::close(_fd);
-        _fd = -1;
-        return false;
-    }
+    Perf *perf = Perf::get_instance();
+    snprintf(name, sizeof(name), "%s-cb%u", thread_name, _id);
+    _perf_run = perf->add(AP_HAL::Util::PC_ELAPSED, strdup(name));
+    snprintf(name, sizeof(name), "%s-cb%u-lat", thread_name, _id);
+    _perf_latency = perf->add(AP_HAL::Util::PC_ELAPSED, strdup(name));
 
-    return true;
+    _perf_allocated = true;
 }
 
-bool TimerPollable::adjust_timer(uint32_t timeout_usec)
+void DataReadyPollable::on_priority()
 {
-    if (_fd < 0) {
-        return false;
+    /* sysfs needs the value read back to arm the next event */
+    char value;
+    if (::pread(_fd, &value, 1, 0) < 0) {
+        return;
     }
 
-    struct itimerspec spec = { };
+    /* push the backup timer back while edges keep coming */
+    _thread._postpone_timer(_timer);
+    _timer->_run_cb();
+}
 
-    spec.it_interval.tv_nsec = timeout_usec * NSEC_PER_USEC;
-    spec.it_value.tv_nsec = timeout_usec * NSEC_PER_USEC;
+PollerThread::TimerFd::TimerFd(PollerThread &thread)
+    : Pollable(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC|TFD_NONBLOCK))
+    , _thread(thread)
+{
+}
 
-    if (timerfd_settime(_fd, 0, &spec, nullptr) < 0) {
-        return false;
+void PollerThread::TimerFd::on_can_read()
+{
+    uint64_t nevents = 0;
+    if (read(_fd, &nevents, sizeof(nevents)) < 0) {
+        return;
     }
 
-    return true;
+    _thread._run_timers();
+}
+
+PollerThread::PollerThread()
+    : Thread{FUNCTOR_BIND_MEMBER(&PollerThread::mainloop, void)}
+{
+    if (_timerfd.get_fd() < 0 ||
+        !_poller.register_pollable(&_timerfd, POLLIN)) {
+        AP_HAL::panic("PollerThread: unable to create timer");
+    }
 }
 
 TimerPollable *PollerThread::add_timer(TimerPollable::PeriodicCb cb,
                                        TimerPollable::WrapperCb *wrapper,
                                        uint32_t timeout_usec)
 {
-    TimerPollable *p = new TimerPollable(cb, wrapper);
-    if (!p || !p->setup_timer(timeout_usec) ||
-        !_poller.register_pollable(p, POLLIN)) {
-        delete p;
+    TimerPollable *p = new TimerPollable(cb, wrapper, _next_timer_id++);
+    if (!p) {
         return nullptr;
     }
 
+    p->_period_usec = timeout_usec;
+    p->_next_usec = now_usec() + timeout_usec;
+
+    pthread_mutex_lock(&_timers_mtx);
     _timers.push_back(p);
+    pthread_mutex_unlock(&_timers_mtx);
+
+    _rearm_timer();
+
+    return p;
+}
+
+TimerPollable *PollerThread::add_data_ready(TimerPollable::PeriodicCb cb,
+                                            TimerPollable::WrapperCb *wrapper,
+                                            int gpio_fd, uint32_t timeout_usec)
+{
+    TimerPollable *p = add_timer(cb, wrapper, timeout_usec);
+    if (!p) {
+        ::close(gpio_fd);
+        return nullptr;
+    }
+
+    DataReadyPollable *d = new DataReadyPollable(gpio_fd, *this, p);
+    if (!d || !_poller.register_pollable(d, POLLPRI)) {
+        if (!d) {
+            ::close(gpio_fd);
+        }
+        delete d;
+        /* fall back on polling at the timeout rate */
+        return p;
+    }
+
+    p->_data_ready = d;
 
     return p;
 }
 
 bool PollerThread::adjust_timer(TimerPollable *p, uint32_t timeout_usec)
 {
+    pthread_mutex_lock(&_timers_mtx);
+
     /* Make sure the handle points to a valid timer */
     auto it = std::find(_timers.begin(), _timers.end(), p);
     if (it == _timers.end()) {
+        pthread_mutex_unlock(&_timers_mtx);
         return false;
     }
 
-    return (*it)->adjust_timer(timeout_usec);
+    p->_period_usec = timeout_usec;
+    p->_next_usec = now_usec() + timeout_usec;
+
+    pthread_mutex_unlock(&_timers_mtx);
+
+    _rearm_timer();
+
+    return true;
+}
+
+/*
+ * Restart the period of a timer without rearming the timerfd: if it
+ * fires for the old deadline it finds nothing due and is rearmed then,
+ * which costs less than a syscall on every data ready edge
+ */
+void PollerThread::_postpone_timer(TimerPollable *p)
+{
+    pthread_mutex_lock(&_timers_mtx);
+    p->_next_usec = now_usec() + p->_period_usec;
+    pthread_mutex_unlock(&_timers_mtx);
+}
+
+/* arm the timerfd for the earliest deadline of all timers */
+void PollerThread::_rearm_timer()
+{
+    uint64_t next_usec = UINT64_MAX;
+
+    pthread_mutex_lock(&_timers_mtx);
+    for (TimerPollable *p : _timers) {
+        if (!p->_removeme && p->_next_usec < next_usec) {
+            next_usec = p->_next_usec;
+        }
+    }
+    pthread_mutex_unlock(&_timers_mtx);
+
+    struct itimerspec spec = { };
+    if (next_usec != UINT64_MAX) {
+        /* a zero it_value would disarm the timer */
+        next_usec = MAX(next_usec, (uint64_t)1);
+        spec.it_value.tv_sec = next_usec / USEC_PER_SEC;
+        spec.it_value.tv_nsec = (next_usec % USEC_PER_SEC) * NSEC_PER_USEC;
+    }
+
+    timerfd_settime(_timerfd.get_fd(), TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+/*
+ * Run every timer due now, or within LINUX_POLLER_COALESCE_USEC of now,
+ * in deadline order. Each runs at most once per wakeup; one that fell
+ * more than a period behind skips the missed periods.
+ */
+void PollerThread::_run_timers()
+{
+    const uint64_t now = now_usec();
+
+    _due.clear();
+
+    pthread_mutex_lock(&_timers_mtx);
+    for (TimerPollable *p : _timers) {
+        if (!p->_removeme && p->_next_usec <= now + LINUX_POLLER_COALESCE_USEC) {
+            _due.push_back(p);
+        }
+    }
+    std::sort(_due.begin(), _due.end(), [](TimerPollable *a, TimerPollable *b) {
+        return a->_next_usec < b->_next_usec;
+    });
+    pthread_mutex_unlock(&_timers_mtx);
+
+    for (TimerPollable *p : _due) {
+        pthread_mutex_lock(&_timers_mtx);
+        const uint64_t deadline = p->_next_usec;
+        const uint64_t period = MAX(p->_period_usec, 1U);
+        uint64_t next = deadline + period;
+        if (next <= now) {
+            next += ((now - next) / period + 1) * period;
+        }
+        p->_next_usec = next;
+        pthread_mutex_unlock(&_timers_mtx);
+
+        if (!p->_perf_allocated) {
+            p->_alloc_perf_counters();
+        }
+        const uint64_t t = now_usec();
+        Perf::get_instance()->sample(p->_perf_latency,
+                                     t > deadline ? (t - deadline) * NSEC_PER_USEC : 0);
+
+        p->_run_cb();
+    }
+
+    _rearm_timer();
 }
 
 void PollerThread::_cleanup_timers()
 {
-    for (auto it = _timers.begin(); it != _timers.end(); it++) {
+    pthread_mutex_lock(&_timers_mtx);
+    for (auto it = _timers.begin(); it != _timers.end();) {
         TimerPollable *p = *it;
-        if (p->_removeme) {
-            _timers.erase(it);
-            _poller.unregister_pollable(p);
-            delete p;
+        if (!p->_removeme) {
+            it++;
+            continue;
         }
+        it = _timers.erase(it);
+        if (p->_data_ready) {
+            _poller.unregister_pollable(p->_data_ready);
+            delete p->_data_ready;
+        }
+        delete p;
     }
+    pthread_mutex_unlock(&_timers_mtx);
 }
 
 void PollerThread::mainloop()
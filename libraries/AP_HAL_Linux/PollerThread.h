@@ -17,17 +17,52 @@
 #pragma once
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <vector>
 
 #include <AP_HAL/Device.h>
+#include <AP_HAL/Util.h>
 
 #include "Poller.h"
 #include "Thread.h"
 
+/*
+ * Timers due within this many microseconds of each other are run on the
+ * same wakeup of the poller thread
+ */
+#define LINUX_POLLER_COALESCE_USEC 20
+
 namespace Linux {
 
-class TimerPollable : public Pollable {
+class PollerThread;
+class TimerPollable;
+
+/*
+ * Runs the callback of a TimerPollable when a GPIO sees an edge
+ */
+class DataReadyPollable : public Pollable {
+public:
+    DataReadyPollable(int fd, PollerThread &thread, TimerPollable *timer)
+        : Pollable(fd)
+        , _thread(thread)
+        , _timer(timer)
+    {
+    }
+
+    void on_priority() override;
+
+protected:
+    PollerThread &_thread;
+    TimerPollable *_timer;
+};
+
+/*
+ * A periodic callback of a PollerThread. All the timers of a thread
+ * share a single timerfd armed for the earliest deadline.
+ */
+class TimerPollable {
     friend class PollerThread;
+    friend class DataReadyPollable;
 
 public:
     class WrapperCb {
@@ -42,27 +77,43 @@ public:
 
     virtual ~TimerPollable() { }
 
-    void on_can_read() override;
-
-    bool setup_timer(uint32_t timeout_usec);
-    bool adjust_timer(uint32_t timeout_usec);
-
 protected:
-    TimerPollable(PeriodicCb cb, WrapperCb *wrapper)
+    TimerPollable(PeriodicCb cb, WrapperCb *wrapper, uint8_t id)
         : _cb(cb)
         , _wrapper(wrapper)
+        , _id(id)
     {
     }
 
+    void _run_cb();
+    void _alloc_perf_counters();
+
     PeriodicCb _cb;
     WrapperCb *_wrapper;
-    bool _removeme;
+    bool _removeme = false;
+
+    /* period and next deadline in monotonic microseconds */
+    uint32_t _period_usec = 0;
+    uint64_t _next_usec = 0;
+
+    /* number of the timer in its thread, for statistics */
+    uint8_t _id;
+
+    /* time spent in the callback and how late it was called */
+    AP_HAL::Util::perf_counter_t _perf_run;
+    AP_HAL::Util::perf_counter_t _perf_latency;
+    bool _perf_allocated = false;
+
+    /* set when the timer only backs up a data ready GPIO */
+    DataReadyPollable *_data_ready = nullptr;
 };
 
 
 class PollerThread : public Thread {
+    friend class DataReadyPollable;
+
 public:
-    PollerThread() : Thread{FUNCTOR_BIND_MEMBER(&PollerThread::mainloop, void)} { }
+    PollerThread();
     virtual ~PollerThread() { }
 
     TimerPollable *add_timer(TimerPollable::PeriodicCb cb,
@@ -70,13 +121,45 @@ public:
                              uint32_t timeout_usec);
     bool adjust_timer(TimerPollable *p, uint32_t timeout_usec);
 
+    /*
+     * Like add_timer(), but cb runs each time the GPIO behind gpio_fd
+     * (see GPIO_Sysfs::open_edge_fd()) sees an edge. The timer is restarted
+     * on every edge so it only fires if no edge came for timeout_usec.
+     * Takes ownership of gpio_fd.
+     */
+    TimerPollable *add_data_ready(TimerPollable::PeriodicCb cb,
+                                  TimerPollable::WrapperCb *wrapper,
+                                  int gpio_fd, uint32_t timeout_usec);
+
     void mainloop();
 
 protected:
+    /* the timerfd shared by all timers */
+    class TimerFd : public Pollable {
+    public:
+        TimerFd(PollerThread &thread);
+
+        void on_can_read() override;
+
+    protected:
+        PollerThread &_thread;
+    };
+
+    void _run_timers();
+    void _postpone_timer(TimerPollable *p);
+    void _rearm_timer();
     void _cleanup_timers();
 
     Poller _poller{};
+    TimerFd _timerfd{*this};
+
+    /* protects the timer list and deadlines, which other threads adjust */
+    pthread_mutex_t _timers_mtx = PTHREAD_MUTEX_INITIALIZER;
     std::vector<TimerPollable*> _timers;
+    uint8_t _next_timer_id = 0;
+
+    /* timers due on the current wakeup, kept to avoid reallocating */
+    std::vector<TimerPollable*> _due;
 };
 
 }
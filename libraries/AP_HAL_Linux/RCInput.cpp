@@ -26,7 +26,10 @@ extern const AP_HAL::HAL& hal;
 using namespace Linux;
 
 RCInput::RCInput() :
-    new_rc_input(false)
+    new_rc_input(false),
+    _pulse_end_us(0),
+    _last_frame_us(0),
+    _frame_latency_us(0)
 {
     ppm_state._channel_counter = -1;
 }
@@ -59,9 +62,19 @@ uint16_t RCInput::read(uint8_t ch)
 
 uint8_t RCInput::read(uint16_t* periods, uint8_t len)
 {
-    uint8_t i;
-    for (i=0; i<len; i++) {
-        periods[i] = read(i);
+    if (len > LINUX_RC_INPUT_NUM_CHANNELS) {
+        len = LINUX_RC_INPUT_NUM_CHANNELS;
+    }
+    // copy the whole frame here rather than a virtual read() per channel
+    new_rc_input = false;
+    for (uint8_t i=0; i<len; i++) {
+        if (_override[i]) {
+            periods[i] = _override[i];
+        } else if (i < _num_channels) {
+            periods[i] = _pwm_values[i];
+        } else {
+            periods[i] = 0;
+        }
     }
     return len;
 }
@@ -112,7 +125,7 @@ void RCInput::_process_ppmsum_pulse(uint16_t width_usec)
                 _pwm_values[i] = ppm_state._pulse_capt[i];
             }
             _num_channels = ppm_state._channel_counter;
-            new_rc_input = true;
+            _pulse_frame_done();
         }
         ppm_state._channel_counter = 0;
         return;
@@ -143,7 +156,7 @@ void RCInput::_process_ppmsum_pulse(uint16_t width_usec)
             _pwm_values[i] = ppm_state._pulse_capt[i];
         }
         _num_channels = ppm_state._channel_counter;
-        new_rc_input = true;
+        _pulse_frame_done();
         ppm_state._channel_counter = -1;
     }
 }
@@ -221,7 +234,7 @@ void RCInput::_process_sbus_pulse(uint16_t width_s0, uint16_t width_s1)
             }
             _num_channels = num_values;
             if (!sbus_failsafe) {
-                new_rc_input = true;
+                _pulse_frame_done();
             }
         }
         goto reset;
@@ -231,7 +244,9 @@ void RCInput::_process_sbus_pulse(uint16_t width_s0, uint16_t width_s1)
     }
     return;
 reset:
-    memset(&sbus_state, 0, sizeof(sbus_state));
+    if (sbus_state.bit_ofs != 0) {
+        memset(&sbus_state, 0, sizeof(sbus_state));
+    }
 }
 
 void RCInput::_process_dsm_pulse(uint16_t width_s0, uint16_t width_s1)
@@ -285,13 +300,13 @@ void RCInput::_process_dsm_pulse(uint16_t width_s0, uint16_t width_s1)
             }
             uint16_t values[8];
             uint16_t num_values=0;
-            if (dsm_decode(AP_HAL::micros64(), bytes, values, &num_values, 8) &&
+            if (dsm_decode(_pulse_end_us, bytes, values, &num_values, 8) &&
                 num_values >= MIN_NUM_CHANNELS) {
                 for (i=0; i<num_values; i++) {
                     _pwm_values[i] = values[i];
                 }
                 _num_channels = num_values;
-                new_rc_input = true;
+                _pulse_frame_done();
             }
         }
         memset(&dsm_state, 0, sizeof(dsm_state));
@@ -309,13 +324,37 @@ void RCInput::_process_dsm_pulse(uint16_t width_s0, uint16_t width_s1)
     dsm_state.bit_ofs += bits_s1;
     return;
 reset:
-    memset(&dsm_state, 0, sizeof(dsm_state));
+    if (dsm_state.bit_ofs != 0) {
+        memset(&dsm_state, 0, sizeof(dsm_state));
+    }
+}
+
+/*
+  note a frame decoded from captured pulses
+ */
+void RCInput::_pulse_frame_done()
+{
+    _last_frame_us = _pulse_end_us;
+    _frame_latency_us = AP_HAL::micros64() - _pulse_end_us;
+    new_rc_input = true;
 }
 
 /*
   process a RC input pulse of the given width
  */
 void RCInput::_process_rc_pulse(uint16_t width_s0, uint16_t width_s1)
+{
+    struct rc_pulse pulse = { width_s0, width_s1 };
+    _process_rc_pulses(&pulse, 1, AP_HAL::micros64());
+}
+
+/*
+  process a block of RC input pulses. Each decoder is run over the
+  whole block in turn rather than all three on each pulse, which keeps
+  one decoder's state in cache at a time. The decoders are independent,
+  and only one of them finds frames in a given signal
+ */
+void RCInput::_process_rc_pulses(const struct rc_pulse *pulses, uint16_t count, uint64_t end_us)
 {
 #if 0
     // useful for debugging
@@ -324,17 +363,40 @@ void RCInput::_process_rc_pulse(uint16_t width_s0, uint16_t width_s1)
         rclog = fopen("/tmp/rcin.log", "w");
     }
     if (rclog) {
-        fprintf(rclog, "%u %u\n", (unsigned)width_s0, (unsigned)width_s1);
+        for (uint16_t i=0; i<count; i++) {
+            fprintf(rclog, "%u %u\n", (unsigned)pulses[i].width_s0, (unsigned)pulses[i].width_s1);
+        }
     }
 #endif
+    // work back from the end of the block to when it started, so
+    // each frame can be stamped with the time of the edge that
+    // completed it
+    uint64_t start_us = end_us;
+    for (uint16_t i=0; i<count; i++) {
+        start_us -= pulses[i].width_s0 + pulses[i].width_s1;
+    }
+
     // treat as PPM-sum
-    _process_ppmsum_pulse(width_s0 + width_s1);
+    _pulse_end_us = start_us;
+    for (uint16_t i=0; i<count; i++) {
+        const uint16_t width = pulses[i].width_s0 + pulses[i].width_s1;
+        _pulse_end_us += width;
+        _process_ppmsum_pulse(width);
+    }
 
     // treat as SBUS
-    _process_sbus_pulse(width_s0, width_s1);
+    _pulse_end_us = start_us;
+    for (uint16_t i=0; i<count; i++) {
+        _pulse_end_us += pulses[i].width_s0 + pulses[i].width_s1;
+        _process_sbus_pulse(pulses[i].width_s0, pulses[i].width_s1);
+    }
 
     // treat as DSM
-    _process_dsm_pulse(width_s0, width_s1);
+    _pulse_end_us = start_us;
+    for (uint16_t i=0; i<count; i++) {
+        _pulse_end_us += pulses[i].width_s0 + pulses[i].width_s1;
+        _process_dsm_pulse(pulses[i].width_s0, pulses[i].width_s1);
+    }
 }
 
 /*
@@ -4,6 +4,9 @@
 
 #define LINUX_RC_INPUT_NUM_CHANNELS 16
 
+// number of pulses a capture driver decodes at once
+#define LINUX_RC_INPUT_PULSE_BATCH 64
+
 namespace Linux {
 
 class RCInput : public AP_HAL::RCInput {
@@ -42,9 +45,23 @@ public:
 
     // add some srxl input bytes, for RCInput over a serial port
     bool add_srxl_input(const uint8_t *bytes, size_t nbytes);
-    
+
+    // time in microseconds of the edge that completed the last frame
+    // decoded from captured pulses, and how long after that edge it
+    // was decoded
+    uint64_t last_frame_us() const { return _last_frame_us; }
+    uint32_t frame_latency_us() const { return _frame_latency_us; }
+
+    struct rc_pulse {
+        uint16_t width_s0;
+        uint16_t width_s1;
+    };
+
 protected:
     void _process_rc_pulse(uint16_t width_s0, uint16_t width_s1);
+    // decode a block of captured pulses, the last of which ended at
+    // end_us
+    void _process_rc_pulses(const struct rc_pulse *pulses, uint16_t count, uint64_t end_us);
     void _update_periods(uint16_t *periods, uint8_t len);
 
     volatile bool new_rc_input;
@@ -55,6 +72,12 @@ protected:
     void _process_ppmsum_pulse(uint16_t width);
     void _process_sbus_pulse(uint16_t width_s0, uint16_t width_s1);
     void _process_dsm_pulse(uint16_t width_s0, uint16_t width_s1);
+    void _pulse_frame_done();
+
+    // end of the pulse being decoded, and frame timing
+    uint64_t _pulse_end_us;
+    uint64_t _last_frame_us;
+    uint32_t _frame_latency_us;
 
     /* override state */
     uint16_t _override[LINUX_RC_INPUT_NUM_CHANNELS];
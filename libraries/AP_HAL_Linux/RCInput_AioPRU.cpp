@@ -49,16 +49,27 @@ void RCInput_AioPRU::init()
  */
 void RCInput_AioPRU::_timer_tick()
 {
+    struct rc_pulse pulses[LINUX_RC_INPUT_PULSE_BATCH];
+    uint16_t count = 0;
+
     while (ring_buffer->ring_head != ring_buffer->ring_tail) {
         if (ring_buffer->ring_tail >= NUM_RING_ENTRIES) {
             // invalid ring_tail from PRU - ignore RC input
             return;
         }
-        _process_rc_pulse((ring_buffer->buffer[ring_buffer->ring_head].s1_t) / TICK_PER_US,
-                          (ring_buffer->buffer[ring_buffer->ring_head].s0_t) / TICK_PER_US);
+        pulses[count].width_s0 = (ring_buffer->buffer[ring_buffer->ring_head].s1_t) / TICK_PER_US;
+        pulses[count].width_s1 = (ring_buffer->buffer[ring_buffer->ring_head].s0_t) / TICK_PER_US;
+        if (++count == LINUX_RC_INPUT_PULSE_BATCH) {
+            _process_rc_pulses(pulses, count, AP_HAL::micros64());
+            count = 0;
+        }
         // move to the next ring buffer entry
         ring_buffer->ring_head = (ring_buffer->ring_head + 1) % NUM_RING_ENTRIES;
     }
+    // the PRU only gives pulse widths, so the last edge is taken as now
+    if (count > 0) {
+        _process_rc_pulses(pulses, count, AP_HAL::micros64());
+    }
 }
 
 #endif // CONFIG_HAL_BOARD_SUBTYPE
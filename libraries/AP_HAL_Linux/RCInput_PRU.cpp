@@ -47,6 +47,9 @@ void RCInput_PRU::init()
  */
 void RCInput_PRU::_timer_tick()
 {
+    struct rc_pulse pulses[LINUX_RC_INPUT_PULSE_BATCH];
+    uint16_t count = 0;
+
     while (ring_buffer->ring_head != ring_buffer->ring_tail) {
         if (ring_buffer->ring_tail >= NUM_RING_ENTRIES) {
             // invalid ring_tail from PRU - ignore RC input
@@ -58,11 +61,20 @@ void RCInput_PRU::_timer_tick()
         } else {
             // the pulse value is the sum of the time spent in the low
             // and high states
-            _process_rc_pulse(_s0_time, ring_buffer->buffer[ring_buffer->ring_head].delta_t);
+            pulses[count].width_s0 = _s0_time;
+            pulses[count].width_s1 = ring_buffer->buffer[ring_buffer->ring_head].delta_t;
+            if (++count == LINUX_RC_INPUT_PULSE_BATCH) {
+                _process_rc_pulses(pulses, count, AP_HAL::micros64());
+                count = 0;
+            }
         }
         // move to the next ring buffer entry
         ring_buffer->ring_head = (ring_buffer->ring_head + 1) % NUM_RING_ENTRIES;        
     }
+    // the PRU only gives pulse widths, so the last edge is taken as now
+    if (count > 0) {
+        _process_rc_pulses(pulses, count, AP_HAL::micros64());
+    }
 }
 
 #endif // CONFIG_HAL_BOARD_SUBTYPE
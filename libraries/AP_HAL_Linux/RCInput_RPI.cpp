@@ -461,11 +461,24 @@ void RCInput_RPI::init()
 }
 
 
+/*
+  system time of a sampled edge, from how far it is behind the first
+  sample not yet read, backlog bytes after the current one
+ */
+uint64_t RCInput_RPI::edge_time_us(uint64_t edge_tick, uint32_t backlog) const
+{
+    return AP_HAL::micros64() - (curr_tick - edge_tick) - (uint64_t)backlog * curr_tick_inc;
+}
+
 //Processing signal
 void RCInput_RPI::_timer_tick()
 {
     int j;
     void* x;
+    struct rc_pulse pulses[LINUX_RC_INPUT_PULSE_BATCH];
+    uint16_t count = 0;
+    uint64_t last_edge_tick = 0;
+    uint32_t skipped = 0;
 
     //Now we are getting address in which DMAC is writing at current moment
     dma_cb_t* ad = (dma_cb_t*) con_blocks->get_virt_addr(dma_reg[RCIN_RPI_DMA_CONBLK_AD | RCIN_RPI_DMA_CHANNEL << 8]);
@@ -479,6 +492,7 @@ void RCInput_RPI::_timer_tick()
     counter = circle_buffer->bytes_available(curr_pointer, circle_buffer->get_offset(circle_buffer->_virt_pages, (uintptr_t)x));
     //We can't stay in method for a long time, because it may lead to delays
     if (counter > RCIN_RPI_MAX_COUNTER) {
+        skipped = counter - RCIN_RPI_MAX_COUNTER;
         counter = RCIN_RPI_MAX_COUNTER;
     }
 
@@ -512,7 +526,13 @@ void RCInput_RPI::_timer_tick()
                 if (curr_signal == 1) {
                     width_s1 = (uint16_t) delta_time;
                     state = RCIN_RPI_ZERO_STATE;
-                    _process_rc_pulse(width_s0, width_s1);
+                    pulses[count].width_s0 = width_s0;
+                    pulses[count].width_s1 = width_s1;
+                    last_edge_tick = prev_tick;
+                    if (++count == LINUX_RC_INPUT_PULSE_BATCH) {
+                        _process_rc_pulses(pulses, count, edge_time_us(last_edge_tick, counter + skipped));
+                        count = 0;
+                    }
                     break;
                 }
                 else 
@@ -526,5 +546,8 @@ void RCInput_RPI::_timer_tick()
         }
         curr_tick+=curr_tick_inc;
     }
+    if (count > 0) {
+        _process_rc_pulses(pulses, count, edge_time_us(last_edge_tick, counter + skipped));
+    }
 }
 #endif // CONFIG_HAL_BOARD_SUBTYPE
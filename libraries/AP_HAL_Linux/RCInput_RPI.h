@@ -123,6 +123,7 @@ private:
     void init_PCM();
     void init_DMA();
     void init_buffer();
+    uint64_t edge_time_us(uint64_t edge_tick, uint32_t backlog) const;
     static void stop_dma();
     static void termination_handler(int signum);
     void set_sigaction();
@@ -41,13 +41,26 @@ void RCInput_ZYNQ::init()
 void RCInput_ZYNQ::_timer_tick()
 {
     uint32_t v;
+    struct rc_pulse pulses[LINUX_RC_INPUT_PULSE_BATCH];
+    uint16_t count = 0;
 
     // all F's means no samples available
     while((v = *pulse_input) != 0xffffffff) {
         // Hi bit indicates pin state, low bits denote pulse length
         if(!(v & 0x80000000))
             _s0_time = (v & 0x7fffffff)/TICK_PER_US;
-        else
-            _process_rc_pulse(_s0_time, (v & 0x7fffffff)/TICK_PER_US);
+        else {
+            pulses[count].width_s0 = _s0_time;
+            pulses[count].width_s1 = (v & 0x7fffffff)/TICK_PER_US;
+            if (++count == LINUX_RC_INPUT_PULSE_BATCH) {
+                _process_rc_pulses(pulses, count, AP_HAL::micros64());
+                count = 0;
+            }
+        }
+    }
+    // the pulse timer only gives pulse widths, so the last edge is
+    // taken as now
+    if (count > 0) {
+        _process_rc_pulses(pulses, count, AP_HAL::micros64());
     }
 }
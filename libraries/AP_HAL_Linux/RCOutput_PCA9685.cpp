@@ -64,9 +64,11 @@ RCOutput_PCA9685::RCOutput_PCA9685(AP_HAL::OwnPtr<AP_HAL::I2CDevice> dev,
     _enable_pin(NULL),
     _frequency(50),
     _pulses_buffer(new uint16_t[PWM_CHAN_COUNT - channel_offset]),
+    _off_counts(new uint16_t[PWM_CHAN_COUNT - channel_offset]()),
     _external_clock(external_clock),
     _channel_offset(channel_offset),
-    _oe_pin_number(oe_pin_number)
+    _oe_pin_number(oe_pin_number),
+    _pending_write_mask(0)
 {
     if (_external_clock)
         _osc_clock = PCA9685_EXTERNAL_CLOCK;
@@ -77,6 +79,7 @@ RCOutput_PCA9685::RCOutput_PCA9685(AP_HAL::OwnPtr<AP_HAL::I2CDevice> dev,
 RCOutput_PCA9685::~RCOutput_PCA9685()
 {
     delete [] _pulses_buffer;
+    delete [] _off_counts;
 }
 
 void RCOutput_PCA9685::init()
@@ -150,6 +153,15 @@ void RCOutput_PCA9685::set_freq(uint32_t chmask, uint16_t freq_hz)
                          PCA9685_MODE1_RESTART_BIT | PCA9685_MODE1_AI_BIT);
 
     _dev->get_semaphore()->give();
+
+    /* The counts of all channels depend on the frequency */
+    for (uint8_t i = 0; i < (PWM_CHAN_COUNT - _channel_offset); i++) {
+        _stage(i);
+        _pending_write_mask |= (1U << i);
+    }
+    if (!_corking) {
+        push();
+    }
 }
 
 uint16_t RCOutput_PCA9685::get_freq(uint8_t ch)
@@ -174,12 +186,27 @@ void RCOutput_PCA9685::write(uint8_t ch, uint16_t period_us)
     }
 
     _pulses_buffer[ch] = period_us;
-    _pending_write_mask |= (1U << ch);
+    _stage(ch);
 
     if (!_corking)
         push();
 }
 
+void RCOutput_PCA9685::_stage(uint8_t ch)
+{
+    uint16_t period_us = _pulses_buffer[ch];
+    uint16_t length = 0;
+
+    if (period_us) {
+        length = round((period_us * 4096) / (1000000.f / _frequency)) - 1;
+    }
+
+    if (length != _off_counts[ch]) {
+        _off_counts[ch] = length;
+        _pending_write_mask |= (1U << ch);
+    }
+}
+
 void RCOutput_PCA9685::cork()
 {
     _corking = true;
@@ -205,13 +232,13 @@ void RCOutput_PCA9685::push()
         uint8_t data[PWM_CHAN_COUNT * 4];
     } pwm_values;
 
+    /*
+     * all channels from the first to the last changed one go in a single
+     * auto-increment transfer. Unchanged channels in between are cheaper
+     * to rewrite than a second transaction
+     */
     for (unsigned ch = min_ch; ch < max_ch; ch++) {
-        uint16_t period_us = _pulses_buffer[ch];
-        uint16_t length = 0;
-
-        if (period_us) {
-            length = round((period_us * 4096) / (1000000.f / _frequency)) - 1;
-        }
+        uint16_t length = _off_counts[ch];
 
         uint8_t *d = &pwm_values.data[(ch - min_ch) * 4];
         *d++ = 0;
@@ -35,6 +35,10 @@ public:
 private:
     void reset();
 
+    // update the staged OFF count of a channel, marking it for the
+    // next push() if it changed
+    void _stage(uint8_t ch);
+
     AP_HAL::DigitalSource *_enable_pin;
     AP_HAL::OwnPtr<AP_HAL::I2CDevice> _dev;
     uint16_t _frequency;
@@ -42,6 +46,10 @@ private:
 
     uint16_t *_pulses_buffer;
 
+    // OFF register count of each channel for the current pulse
+    // widths. Only changed channels are marked pending
+    uint16_t *_off_counts;
+
     bool _external_clock;
     bool _corking = false;
     uint8_t _channel_offset;
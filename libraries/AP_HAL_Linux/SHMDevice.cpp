@@ -0,0 +1,137 @@
+#include "SHMDevice.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+
+SHMDevice::SHMDevice(const char *name):
+    _name(name)
+{
+}
+
+SHMDevice::~SHMDevice()
+{
+    close();
+}
+
+bool SHMDevice::open()
+{
+    if (_region != nullptr) {
+        return true;
+    }
+
+    _fd = shm_open(_name, O_RDWR | O_CREAT, 0660);
+    if (_fd < 0) {
+        ::fprintf(stderr, "Failed to open shared memory %s - %s\n",
+                  _name, strerror(errno));
+        return false;
+    }
+
+    if (ftruncate(_fd, sizeof(Region)) < 0) {
+        ::fprintf(stderr, "Failed to size shared memory %s - %s\n",
+                  _name, strerror(errno));
+        close();
+        return false;
+    }
+
+    void *p = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, _fd, 0);
+    if (p == MAP_FAILED) {
+        ::fprintf(stderr, "Failed to map shared memory %s - %s\n",
+                  _name, strerror(errno));
+        close();
+        return false;
+    }
+    _region = static_cast<Region *>(p);
+
+    // reset the rings, then tell the peer they are ready
+    _region->magic.store(0, std::memory_order_relaxed);
+    _region->ring_size = LINUX_SHM_RING_SIZE;
+    _region->to_peer.head.store(0, std::memory_order_relaxed);
+    _region->to_peer.tail.store(0, std::memory_order_relaxed);
+    _region->from_peer.head.store(0, std::memory_order_relaxed);
+    _region->from_peer.tail.store(0, std::memory_order_relaxed);
+    _region->magic.store(LINUX_SHM_MAGIC, std::memory_order_release);
+
+    // pre-fault the mapping so the first transfers don't page fault
+    mlock(_region, sizeof(Region));
+
+    return true;
+}
+
+bool SHMDevice::close()
+{
+    if (_region != nullptr) {
+        _region->magic.store(0, std::memory_order_release);
+        munmap(_region, sizeof(Region));
+        _region = nullptr;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    return true;
+}
+
+ssize_t SHMDevice::write(const uint8_t *buf, uint16_t n)
+{
+    if (_region == nullptr) {
+        return -1;
+    }
+
+    Ring &ring = _region->to_peer;
+    const uint32_t head = ring.head.load(std::memory_order_relaxed);
+    const uint32_t tail = ring.tail.load(std::memory_order_acquire);
+    if (head - tail > LINUX_SHM_RING_SIZE) {
+        // the peer corrupted the ring
+        return -1;
+    }
+
+    n = MIN((uint32_t)n, LINUX_SHM_RING_SIZE - (head - tail));
+    const uint32_t ofs = head % LINUX_SHM_RING_SIZE;
+    const uint32_t part = MIN((uint32_t)n, LINUX_SHM_RING_SIZE - ofs);
+    memcpy(&ring.data[ofs], buf, part);
+    memcpy(&ring.data[0], buf + part, n - part);
+
+    ring.head.store(head + n, std::memory_order_release);
+    return n;
+}
+
+ssize_t SHMDevice::read(uint8_t *buf, uint16_t n)
+{
+    if (_region == nullptr) {
+        return -1;
+    }
+
+    Ring &ring = _region->from_peer;
+    const uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    const uint32_t head = ring.head.load(std::memory_order_acquire);
+    if (head - tail > LINUX_SHM_RING_SIZE) {
+        // the peer corrupted the ring
+        return -1;
+    }
+
+    n = MIN((uint32_t)n, head - tail);
+    const uint32_t ofs = tail % LINUX_SHM_RING_SIZE;
+    const uint32_t part = MIN((uint32_t)n, LINUX_SHM_RING_SIZE - ofs);
+    memcpy(buf, &ring.data[ofs], part);
+    memcpy(buf + part, &ring.data[0], n - part);
+
+    ring.tail.store(tail + n, std::memory_order_release);
+    return n;
+}
+
+void SHMDevice::set_blocking(bool blocking)
+{
+}
+
+void SHMDevice::set_speed(uint32_t speed)
+{
+}
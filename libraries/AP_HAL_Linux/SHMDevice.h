@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+#include "SerialDevice.h"
+
+#define LINUX_SHM_MAGIC         0x4150534d
+#define LINUX_SHM_RING_SIZE     (64 * 1024)
+
+/*
+  serial port to a process on the same machine through a POSIX shared
+  memory object, selected with a "shm:/<name>" device path.
+
+  The object holds a pair of single producer, single consumer rings.
+  Each ring index is a free running byte count, which the producer or
+  consumer publishes with a release store after copying the data it
+  covers. ArduPilot creates and resets the object on open and sets
+  magic last; a peer should wait for magic before using the rings.
+ */
+class SHMDevice: public SerialDevice {
+public:
+    struct Ring {
+        /* bytes written, only stored by the producer */
+        alignas(64) std::atomic<uint32_t> head;
+        /* bytes read, only stored by the consumer */
+        alignas(64) std::atomic<uint32_t> tail;
+        alignas(64) uint8_t data[LINUX_SHM_RING_SIZE];
+    };
+
+    struct Region {
+        std::atomic<uint32_t> magic;
+        uint32_t ring_size;
+        /* written by ArduPilot */
+        Ring to_peer;
+        /* read by ArduPilot */
+        Ring from_peer;
+    };
+
+    SHMDevice(const char *name);
+    virtual ~SHMDevice();
+
+    virtual bool open() override;
+    virtual bool close() override;
+    virtual void set_blocking(bool blocking) override;
+    virtual void set_speed(uint32_t speed) override;
+    virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
+    virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+
+private:
+    const char *_name;
+    int _fd = -1;
+    Region *_region = nullptr;
+};
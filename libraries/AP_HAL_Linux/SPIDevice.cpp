@@ -45,6 +45,9 @@ static const AP_HAL::HAL &hal = AP_HAL::get_HAL();
 #define KHZ (1000U)
 #define SPI_CS_KERNEL -1
 
+/* maximum number of transactions submitted in a single ioctl */
+#define LINUX_SPI_MAX_BATCH 8
+
 struct SPIDesc {
     SPIDesc(const char *name_, uint16_t bus_, uint16_t subdev_, uint8_t mode_,
             uint8_t bits_per_word_, int16_t cs_pin_, uint32_t lowspeed_,
@@ -157,6 +160,8 @@ public:
     void start_cb() override;
     void end_cb() override;
 
+    void start_thread();
+
     int open(uint16_t bus_, uint16_t kernel_cs_);
 
     PollerThread thread;
@@ -186,6 +191,26 @@ void SPIBus::end_cb()
 }
 
 
+void SPIBus::start_thread()
+{
+    if (thread.is_started()) {
+        return;
+    }
+
+    char name[16];
+    snprintf(name, sizeof(name), "ap-spi-%u", bus);
+    sem.set_name(name + 3);
+
+    int prio;
+    uint32_t cpu_mask;
+    Scheduler::from(hal.scheduler)->get_thread_config(name, AP_LINUX_SENSORS_SCHED_PRIO,
+                                                     prio, cpu_mask);
+
+    thread.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
+    thread.set_cpu_affinity(cpu_mask);
+    thread.start(name, AP_LINUX_SENSORS_SCHED_POLICY, prio);
+}
+
 int SPIBus::open(uint16_t bus_, uint16_t kernel_cs_)
 {
     char path[sizeof("/dev/spidevXXXXX.XXXXX")];
@@ -245,21 +270,24 @@ bool SPIDevice::set_speed(AP_HAL::Device::Speed speed)
     return true;
 }
 
-bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
-                         uint8_t *recv, uint32_t recv_len)
+/*
+ * Append the messages for one send-then-receive transaction to msgs,
+ * returning how many were added
+ */
+static unsigned fill_msgs(struct spi_ioc_transfer *msgs,
+                          const uint8_t *send, uint32_t send_len,
+                          uint8_t *recv, uint32_t recv_len,
+                          uint32_t speed, uint8_t bits_per_word)
 {
-    struct spi_ioc_transfer msgs[2] = { };
     unsigned nmsgs = 0;
 
-    assert(_bus.fd >= 0);
-
     if (send && send_len != 0) {
         msgs[nmsgs].tx_buf = (uint64_t) send;
         msgs[nmsgs].rx_buf = 0;
         msgs[nmsgs].len = send_len;
-        msgs[nmsgs].speed_hz = _speed;
+        msgs[nmsgs].speed_hz = speed;
         msgs[nmsgs].delay_usecs = 0;
-        msgs[nmsgs].bits_per_word = _desc.bits_per_word;
+        msgs[nmsgs].bits_per_word = bits_per_word;
         msgs[nmsgs].cs_change = 0;
         nmsgs++;
     }
@@ -268,18 +296,18 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
         msgs[nmsgs].tx_buf = 0;
         msgs[nmsgs].rx_buf = (uint64_t) recv;
         msgs[nmsgs].len = recv_len;
-        msgs[nmsgs].speed_hz = _speed;
+        msgs[nmsgs].speed_hz = speed;
         msgs[nmsgs].delay_usecs = 0;
-        msgs[nmsgs].bits_per_word = _desc.bits_per_word;
+        msgs[nmsgs].bits_per_word = bits_per_word;
         msgs[nmsgs].cs_change = 0;
         nmsgs++;
     }
 
-    if (!nmsgs) {
-        return false;
-    }
+    return nmsgs;
+}
 
-    int r;
+bool SPIDevice::_update_mode()
+{
     if (_bus.last_mode == _desc.mode) {
         /*
           the mode in the kernel is not tied to the file descriptor,
@@ -301,7 +329,7 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
         }
     }
     if (_desc.mode != _bus.last_mode) {
-        r = ioctl(_bus.fd, SPI_IOC_WR_MODE, &_desc.mode);
+        int r = ioctl(_bus.fd, SPI_IOC_WR_MODE, &_desc.mode);
         if (r < 0) {
             hal.console->printf("SPIDevice: error on setting mode fd=%d (%s)\n",
                                 _bus.fd, strerror(errno));
@@ -310,8 +338,28 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
         _bus.last_mode = _desc.mode;
     }
 
+    return true;
+}
+
+bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
+                         uint8_t *recv, uint32_t recv_len)
+{
+    struct spi_ioc_transfer msgs[2] = { };
+
+    assert(_bus.fd >= 0);
+
+    unsigned nmsgs = fill_msgs(msgs, send, send_len, recv, recv_len,
+                               _speed, _desc.bits_per_word);
+    if (!nmsgs) {
+        return false;
+    }
+
+    if (!_update_mode()) {
+        return false;
+    }
+
     _cs_assert();
-    r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
+    int r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
     _cs_release();
 
     if (r == -1) {
@@ -323,6 +371,53 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
     return true;
 }
 
+bool SPIDevice::transfer_batch(const AP_HAL::Device::Transfer *transfers,
+                               uint8_t count)
+{
+    struct spi_ioc_transfer msgs[2 * LINUX_SPI_MAX_BATCH] = { };
+    unsigned nmsgs = 0;
+
+    assert(_bus.fd >= 0);
+
+    /*
+     * with userspace CS the chip select can't be toggled between the
+     * transactions of a single ioctl
+     */
+    if (_desc.cs_pin != SPI_CS_KERNEL || count > LINUX_SPI_MAX_BATCH) {
+        return AP_HAL::SPIDevice::transfer_batch(transfers, count);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        unsigned n = fill_msgs(&msgs[nmsgs],
+                               transfers[i].send, transfers[i].send_len,
+                               transfers[i].recv, transfers[i].recv_len,
+                               _speed, _desc.bits_per_word);
+        if (!n) {
+            return false;
+        }
+        nmsgs += n;
+        /* deselect the device between transactions */
+        msgs[nmsgs - 1].cs_change = i + 1 < count;
+    }
+
+    if (!nmsgs) {
+        return true;
+    }
+
+    if (!_update_mode()) {
+        return false;
+    }
+
+    int r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
+    if (r == -1) {
+        hal.console->printf("SPIDevice: error transferring data fd=%d (%s)\n",
+                            _bus.fd, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
 bool SPIDevice::transfer_fullduplex(const uint8_t *send, uint8_t *recv,
                                     uint32_t len)
 {
@@ -394,16 +489,31 @@ AP_HAL::Device::PeriodicHandle SPIDevice::register_periodic_callback(
         AP_HAL::panic("Could not create periodic callback");
     }
 
-    if (!_bus.thread.is_started()) {
-        char name[16];
-        snprintf(name, sizeof(name), "ap-spi-%u", _bus.bus);
+    _bus.start_thread();
+
+    return static_cast<AP_HAL::Device::PeriodicHandle>(p);
+}
+
+AP_HAL::Device::PeriodicHandle SPIDevice::register_data_ready_callback(
+    uint8_t gpio_pin, uint32_t timeout_usec, AP_HAL::Device::PeriodicCb cb)
+{
+#ifdef LINUX_GPIO_SYSFS
+    int fd = GPIO_Sysfs::from(hal.gpio)->open_edge_fd(gpio_pin);
+    if (fd < 0) {
+        return nullptr;
+    }
 
-        _bus.thread.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
-        _bus.thread.start(name, AP_LINUX_SENSORS_SCHED_POLICY,
-                          AP_LINUX_SENSORS_SCHED_PRIO);
+    TimerPollable *p = _bus.thread.add_data_ready(cb, &_bus, fd, timeout_usec);
+    if (!p) {
+        return nullptr;
     }
 
+    _bus.start_thread();
+
     return static_cast<AP_HAL::Device::PeriodicHandle>(p);
+#else
+    return nullptr;
+#endif
 }
 
 bool SPIDevice::adjust_periodic_callback(
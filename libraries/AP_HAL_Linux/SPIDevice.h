@@ -42,6 +42,10 @@ public:
     bool transfer(const uint8_t *send, uint32_t send_len,
                   uint8_t *recv, uint32_t recv_len) override;
 
+    /* See AP_HAL::Device::transfer_batch() */
+    bool transfer_batch(const AP_HAL::Device::Transfer *transfers,
+                        uint8_t count) override;
+
     /* See AP_HAL::SPIDevice::transfer_fullduplex() */
     bool transfer_fullduplex(const uint8_t *send, uint8_t *recv,
                              uint32_t len) override;
@@ -57,12 +61,22 @@ public:
     bool adjust_periodic_callback(
         AP_HAL::Device::PeriodicHandle h, uint32_t period_usec) override;
 
+    /* See AP_HAL::Device::register_data_ready_callback() */
+    AP_HAL::Device::PeriodicHandle register_data_ready_callback(
+        uint8_t gpio_pin, uint32_t timeout_usec,
+        AP_HAL::Device::PeriodicCb) override;
+
 protected:
     SPIBus &_bus;
     SPIDesc &_desc;
     AP_HAL::DigitalSource *_cs;
     uint32_t _speed;
 
+    /*
+     * Set the SPI mode of the bus if another device changed it
+     */
+    bool _update_mode();
+
     /*
      * Select device if using userspace CS
      */
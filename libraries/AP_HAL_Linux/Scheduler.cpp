@@ -1,11 +1,15 @@
 #include "Scheduler.h"
 
 #include <algorithm>
+#include <alloca.h>
 #include <errno.h>
+#include <malloc.h>
 #include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -32,12 +36,17 @@ extern const AP_HAL::HAL& hal;
 #define APM_LINUX_TIMER_PRIORITY        15
 #define APM_LINUX_UART_PRIORITY         14
 #define APM_LINUX_RCIN_PRIORITY         13
+#define APM_LINUX_RATE_PRIORITY         13
 #define APM_LINUX_MAIN_PRIORITY         12
 #define APM_LINUX_TONEALARM_PRIORITY    11
+#define APM_LINUX_WORKER_PRIORITY       11
 #define APM_LINUX_IO_PRIORITY           10
+#define APM_LINUX_STORAGE_PRIORITY      10
 
 #define APM_LINUX_TIMER_RATE            1000
 #define APM_LINUX_UART_RATE             100
+#define APM_LINUX_WORKER_RATE           1000
+#define APM_LINUX_STORAGE_RATE          50
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO ||    \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_ERLEBRAIN2 || \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BH || \
@@ -52,6 +61,12 @@ extern const AP_HAL::HAL& hal;
 #define APM_LINUX_IO_RATE               50
 #endif
 
+/* main thread stack touched at boot in real-time memory mode */
+#define APM_LINUX_RT_STACK_PREFAULT     (256 * 1024)
+
+/* an IO process taking longer than one IO period is overrunning */
+#define APM_LINUX_IO_BUDGET_USEC        (1000000 / APM_LINUX_IO_RATE)
+
 #define SCHED_THREAD(name_, UPPER_NAME_)                        \
     {                                                           \
         .name = "ap-" #name_,                                   \
@@ -61,6 +76,15 @@ extern const AP_HAL::HAL& hal;
         .rate = APM_LINUX_##UPPER_NAME_##_RATE,                 \
     }
 
+#define IO_THREAD(index_)                                       \
+    {                                                           \
+        .name = "ap-io-" #index_,                               \
+        .thread = &_io_threads[index_],                         \
+        .policy = SCHED_FIFO,                                   \
+        .prio = APM_LINUX_IO_PRIORITY,                          \
+        .rate = APM_LINUX_IO_RATE,                              \
+    }
+
 Scheduler::Scheduler()
 { }
 
@@ -77,10 +101,15 @@ void Scheduler::init()
         SCHED_THREAD(uart, UART),
         SCHED_THREAD(rcin, RCIN),
         SCHED_THREAD(tonealarm, TONEALARM),
-        SCHED_THREAD(io, IO),
+        IO_THREAD(0),
+        IO_THREAD(1),
+        SCHED_THREAD(worker, WORKER),
+        SCHED_THREAD(storage, STORAGE),
     };
 
-    mlockall(MCL_CURRENT|MCL_FUTURE);
+    _main_ctx = pthread_self();
+
+    _setup_rt_memory();
 
     if (geteuid() != 0) {
         printf("WARNING: running as non-root. Will not use realtime scheduling\n");
@@ -89,23 +118,140 @@ void Scheduler::init()
     struct sched_param param = { .sched_priority = APM_LINUX_MAIN_PRIORITY };
     sched_setscheduler(0, SCHED_FIFO, &param);
 
+    _timer_semaphore.set_name("timer");
+    for (uint8_t i = 0; i < LINUX_SCHEDULER_IO_THREADS; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "io%u", i);
+        _io_semaphore[i].set_name(name);
+    }
+
     /* set barrier to N + 1 threads: worker threads + main */
     unsigned n_threads = ARRAY_SIZE(sched_table) + 1;
     pthread_barrier_init(&_initialized_barrier, nullptr, n_threads);
 
     for (size_t i = 0; i < ARRAY_SIZE(sched_table); i++) {
         const struct sched_table *t = &sched_table[i];
+        int prio;
+        uint32_t cpu_mask;
+
+        get_thread_config(t->name, t->prio, prio, cpu_mask);
 
         t->thread->set_rate(t->rate);
         t->thread->set_stack_size(256 * 1024);
-        t->thread->start(t->name, t->policy, t->prio);
+        t->thread->set_cpu_affinity(cpu_mask);
+        t->thread->start(t->name, t->policy, prio);
     }
 
+    register_io_process(FUNCTOR_BIND_MEMBER(&Scheduler::_update_thread_stats, void));
+    register_io_process(FUNCTOR_BIND_MEMBER(&Scheduler::_update_page_faults, void));
+
 #if defined(DEBUG_STACK) && DEBUG_STACK
     register_timer_process(FUNCTOR_BIND_MEMBER(&Scheduler::_debug_stack, void));
 #endif
 }
 
+/*
+  touch size bytes of the calling thread's stack, one write per page,
+  so the pages are present (and locked by mlockall()) before they are
+  needed
+ */
+static void __attribute__((noinline)) prefault_stack(size_t size)
+{
+    volatile uint8_t *stack = (volatile uint8_t *)alloca(size);
+    const size_t page = sysconf(_SC_PAGESIZE);
+
+    for (size_t i = 0; i < size; i += page) {
+        stack[i] = 0;
+    }
+}
+
+void Scheduler::_setup_rt_memory()
+{
+    if (mlockall(MCL_CURRENT|MCL_FUTURE) != 0) {
+        printf("WARNING: mlockall failed: %s\n", strerror(errno));
+    }
+
+    if (_rt_heap_kb == 0) {
+        return;
+    }
+
+    /*
+      keep everything freed in the heap rather than returning it to the
+      kernel, and serve large allocations from the heap too, so the
+      pool below stays mapped for later allocations
+     */
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    const size_t size = _rt_heap_kb * 1024;
+    const size_t page = sysconf(_SC_PAGESIZE);
+    volatile uint8_t *pool = (volatile uint8_t *)malloc(size);
+    if (pool == nullptr) {
+        printf("WARNING: failed to reserve %u kB heap pool\n", (unsigned)_rt_heap_kb);
+    } else {
+        for (size_t i = 0; i < size; i += page) {
+            pool[i] = 0;
+        }
+        free((void *)pool);
+    }
+
+    /* the other threads touch their whole stack when it is poisoned */
+    prefault_stack(APM_LINUX_RT_STACK_PREFAULT);
+}
+
+/*
+  count the process page faults since the last call into perf
+  counters, so faults turning up after boot can be seen next to the
+  overruns they cause
+ */
+void Scheduler::_update_page_faults()
+{
+    uint64_t now = AP_HAL::millis64();
+
+    if (now - _last_page_faults_msec < 1000) {
+        return;
+    }
+    _last_page_faults_msec = now;
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return;
+    }
+
+    Perf *perf = Perf::get_instance();
+    if (!_page_faults.allocated) {
+        _page_faults.perf_major = perf->add(AP_HAL::Util::PC_COUNT, "page_faults_major");
+        _page_faults.perf_minor = perf->add(AP_HAL::Util::PC_COUNT, "page_faults_minor");
+        _page_faults.allocated = true;
+    } else {
+        perf->count(_page_faults.perf_major, usage.ru_majflt - _page_faults.last_major);
+        perf->count(_page_faults.perf_minor, usage.ru_minflt - _page_faults.last_minor);
+    }
+    _page_faults.last_major = usage.ru_majflt;
+    _page_faults.last_minor = usage.ru_minflt;
+}
+
+/*
+  refresh the stack and run-time statistics of every thread for
+  Util::thread_get_info(). Runs in an IO thread as it reads procfs
+ */
+void Scheduler::_update_thread_stats()
+{
+    uint64_t now = AP_HAL::millis64();
+
+    if (now - _last_thread_stats_msec < 5000) {
+        return;
+    }
+    _last_thread_stats_msec = now;
+
+    for (uint8_t i = 0; i < Thread::get_count(); i++) {
+        Thread *thread = Thread::get_thread(i);
+        if (thread != nullptr) {
+            thread->update_stats();
+        }
+    }
+}
+
 void Scheduler::_debug_stack()
 {
     uint64_t now = AP_HAL::millis64();
@@ -113,15 +259,21 @@ void Scheduler::_debug_stack()
     if (now - _last_stack_debug_msec > 5000) {
         fprintf(stderr, "Stack Usage:\n"
                 "\ttimer = %zu\n"
-                "\tio    = %zu\n"
+                "\tio0   = %zu\n"
+                "\tio1   = %zu\n"
                 "\trcin  = %zu\n"
                 "\tuart  = %zu\n"
-                "\ttone  = %zu\n",
+                "\ttone  = %zu\n"
+                "\twork  = %zu\n"
+                "\tstore = %zu\n",
                 _timer_thread.get_stack_usage(),
-                _io_thread.get_stack_usage(),
+                _io_threads[0].get_stack_usage(),
+                _io_threads[1].get_stack_usage(),
                 _rcin_thread.get_stack_usage(),
                 _uart_thread.get_stack_usage(),
-                _tonealarm_thread.get_stack_usage());
+                _tonealarm_thread.get_stack_usage(),
+                _worker_thread.get_stack_usage(),
+                _storage_thread.get_stack_usage());
         _last_stack_debug_msec = now;
     }
 }
@@ -134,6 +286,60 @@ void Scheduler::microsleep(uint32_t usec)
     while (nanosleep(&ts, &ts) == -1 && errno == EINTR) ;
 }
 
+bool Scheduler::set_thread_config(const char *spec)
+{
+    if (_num_thread_configs >= LINUX_SCHEDULER_MAX_THREAD_CONFIGS) {
+        return false;
+    }
+
+    const char *sep = strchr(spec, ':');
+    if (sep == nullptr || sep == spec ||
+        (size_t)(sep - spec) >= sizeof(_thread_config[0].name)) {
+        return false;
+    }
+
+    thread_config &config = _thread_config[_num_thread_configs];
+    char *end;
+    long prio = strtol(sep + 1, &end, 10);
+    if (end == sep + 1 || prio < sched_get_priority_min(SCHED_FIFO) ||
+        prio > sched_get_priority_max(SCHED_FIFO)) {
+        return false;
+    }
+    config.cpu_mask = 0;
+    if (*end == ':') {
+        const char *mask = end + 1;
+        config.cpu_mask = strtoul(mask, &end, 0);
+        if (end == mask) {
+            return false;
+        }
+    }
+    if (*end != '\0') {
+        return false;
+    }
+
+    memcpy(config.name, spec, sep - spec);
+    config.name[sep - spec] = '\0';
+    config.prio = prio;
+    _num_thread_configs++;
+
+    return true;
+}
+
+void Scheduler::get_thread_config(const char *name, int default_prio,
+                                  int &prio, uint32_t &cpu_mask) const
+{
+    prio = default_prio;
+    cpu_mask = 0;
+
+    for (uint8_t i = 0; i < _num_thread_configs; i++) {
+        if (strcmp(_thread_config[i].name, name) == 0) {
+            prio = _thread_config[i].prio;
+            cpu_mask = _thread_config[i].cpu_mask;
+            return;
+        }
+    }
+}
+
 void Scheduler::delay(uint16_t ms)
 {
     if (_stopped_clock_usec) {
@@ -144,7 +350,7 @@ void Scheduler::delay(uint16_t ms)
     while ((AP_HAL::millis64() - start) < ms) {
         // this yields the CPU to other apps
         microsleep(1000);
-        if (_min_delay_cb_ms <= ms) {
+        if (_min_delay_cb_ms <= ms && pthread_equal(pthread_self(), _main_ctx)) {
             if (_delay_cb) {
                 _delay_cb();
             }
@@ -248,20 +454,138 @@ bool Scheduler::_register_timesliced_proc(AP_HAL::MemberProc proc,
 
 void Scheduler::register_io_process(AP_HAL::MemberProc proc)
 {
+    uint8_t procs_per_thread[LINUX_SCHEDULER_IO_THREADS] {};
+
     for (uint8_t i = 0; i < _num_io_procs; i++) {
-        if (_io_proc[i] == proc) {
+        if (_io_proc[i].proc == proc) {
             return;
         }
+        procs_per_thread[_io_proc[i].thread]++;
     }
 
-    if (_num_io_procs < LINUX_SCHEDULER_MAX_IO_PROCS) {
-        _io_proc[_num_io_procs] = proc;
-        _num_io_procs++;
-    } else {
+    if (_num_io_procs >= LINUX_SCHEDULER_MAX_IO_PROCS) {
         hal.console->printf("Out of IO processes\n");
+        return;
+    }
+
+    /* spread the processes so one slow driver doesn't hold up the rest */
+    uint8_t thread = 0;
+    for (uint8_t i = 1; i < LINUX_SCHEDULER_IO_THREADS; i++) {
+        if (procs_per_thread[i] < procs_per_thread[thread]) {
+            thread = i;
+        }
+    }
+
+    char name[16];
+    snprintf(name, sizeof(name), "io-%u-%u", thread, _num_io_procs);
+
+    io_proc &p = _io_proc[_num_io_procs];
+    p.proc = proc;
+    p.thread = thread;
+    p.max_usec = 0;
+    p.overruns = 0;
+    p.perf = Perf::get_instance()->add(AP_HAL::Util::PC_ELAPSED, strdup(name));
+
+    /* publish the entry only once it is complete */
+    __sync_synchronize();
+    _num_io_procs++;
+}
+
+bool Scheduler::register_worker_process(AP_HAL::MemberProc proc)
+{
+    for (uint8_t i = 0; i < _num_worker_procs; i++) {
+        if (_worker_proc[i] == proc) {
+            return true;
+        }
+    }
+
+    if (_num_worker_procs < LINUX_SCHEDULER_MAX_WORKER_PROCS) {
+        _worker_proc[_num_worker_procs] = proc;
+        _num_worker_procs++;
+        return true;
+    }
+
+    hal.console->printf("Out of worker processes\n");
+    return false;
+}
+
+bool Scheduler::register_storage_process(AP_HAL::MemberProc proc)
+{
+    for (uint8_t i = 0; i < _num_storage_procs; i++) {
+        if (_storage_proc[i] == proc) {
+            return true;
+        }
+    }
+
+    if (_num_storage_procs < LINUX_SCHEDULER_MAX_STORAGE_PROCS) {
+        _storage_proc[_num_storage_procs] = proc;
+        _num_storage_procs++;
+        return true;
+    }
+
+    hal.console->printf("Out of storage processes\n");
+    return false;
+}
+
+bool Scheduler::register_rate_process(AP_HAL::MemberProc proc, uint16_t rate_hz)
+{
+    if (_rate_thread.is_started() || rate_hz == 0) {
+        return false;
+    }
+
+    int prio;
+    uint32_t cpu_mask;
+    get_thread_config("ap-rate", APM_LINUX_RATE_PRIORITY, prio, cpu_mask);
+
+    _rate_proc = proc;
+    _rate_thread.set_rate(rate_hz);
+    _rate_thread.set_stack_size(256 * 1024);
+    _rate_thread.set_cpu_affinity(cpu_mask);
+    if (!_rate_thread.start("ap-rate", SCHED_FIFO, prio)) {
+        hal.console->printf("Failed to start rate thread\n");
+        return false;
+    }
+    return true;
+}
+
+bool Scheduler::run_startup_task(AP_HAL::MemberProc proc)
+{
+    if (_initialized || _num_startup_tasks >= LINUX_SCHEDULER_MAX_STARTUP_TASKS) {
+        return false;
+    }
+
+    int prio;
+    uint32_t cpu_mask;
+    get_thread_config("ap-startup", APM_LINUX_MAIN_PRIORITY, prio, cpu_mask);
+
+    StartupThread &thread = _startup_threads[_num_startup_tasks];
+    thread.set_task(proc);
+    thread.set_stack_size(256 * 1024);
+    thread.set_cpu_affinity(cpu_mask);
+    if (!thread.start("ap-startup", SCHED_FIFO, prio)) {
+        return false;
+    }
+    _num_startup_tasks++;
+    return true;
+}
+
+void Scheduler::wait_startup_tasks()
+{
+    for (uint8_t i = 0; i < _num_startup_tasks; i++) {
+        while (!_startup_threads[i].is_done()) {
+            // long enough for the delay callback to keep the GCS served
+            delay(_min_delay_cb_ms > 0 ? _min_delay_cb_ms : 1);
+        }
     }
 }
 
+bool Scheduler::StartupThread::_run()
+{
+    bool ret = Thread::_run();
+    __atomic_store_n(&_done, true, __ATOMIC_RELEASE);
+    return ret;
+}
+
 void Scheduler::register_timer_failsafe(AP_HAL::Proc failsafe, uint32_t period_us)
 {
     _failsafe = failsafe;
@@ -339,20 +663,40 @@ void Scheduler::_timer_task()
 #endif
 }
 
-void Scheduler::_run_io(void)
+void Scheduler::_run_io(uint8_t index)
 {
-    if (!_io_semaphore.take(0)) {
+    if (!_io_semaphore[index].take(0)) {
         return;
     }
 
-    // now call the IO based drivers
-    for (int i = 0; i < _num_io_procs; i++) {
-        if (_io_proc[i]) {
-            _io_proc[i]();
+    // now call the IO based drivers assigned to this thread
+    const uint8_t num_procs = _num_io_procs;
+    for (uint8_t i = 0; i < num_procs; i++) {
+        io_proc &p = _io_proc[i];
+        if (p.thread != index || !p.proc) {
+            continue;
+        }
+
+        const uint64_t start_usec = AP_HAL::micros64();
+        p.proc();
+        const uint32_t elapsed_usec = AP_HAL::micros64() - start_usec;
+
+        Perf::get_instance()->sample(p.perf, elapsed_usec * 1000ULL);
+        if (elapsed_usec > p.max_usec) {
+            p.max_usec = elapsed_usec;
+        }
+        if (elapsed_usec > APM_LINUX_IO_BUDGET_USEC) {
+            p.overruns++;
+            /* report the 1st, 2nd, 4th, 8th ... overrun */
+            if ((p.overruns & (p.overruns - 1)) == 0) {
+                hal.console->printf("IO process %u overran: %u us (max %u us, %u overruns)\n",
+                                    i, (unsigned)elapsed_usec, (unsigned)p.max_usec,
+                                    (unsigned)p.overruns);
+            }
         }
     }
 
-    _io_semaphore.give();
+    _io_semaphore[index].give();
 }
 
 /*
@@ -395,13 +739,36 @@ void Scheduler::_tonealarm_task()
     Util::from(hal.util)->_toneAlarm_timer_tick();
 }
 
-void Scheduler::_io_task()
+void Scheduler::_worker_task()
 {
-    // process any pending storage writes
-    Storage::from(hal.storage)->_timer_tick();
+    // run registered worker processes
+    for (uint8_t i = 0; i < _num_worker_procs; i++) {
+        _worker_proc[i]();
+    }
+}
+
+void Scheduler::_storage_task()
+{
+    // run registered storage processes, which may block on file IO
+    for (uint8_t i = 0; i < _num_storage_procs; i++) {
+        _storage_proc[i]();
+    }
+}
+
+void Scheduler::_rate_task()
+{
+    _rate_proc();
+}
+
+void Scheduler::_io_task(uint8_t index)
+{
+    if (index == 0) {
+        // process any pending storage writes
+        Storage::from(hal.storage)->_timer_tick();
+    }
 
     // run registered IO processes
-    _run_io();
+    _run_io(index);
 }
 
 bool Scheduler::in_timerprocess()
@@ -409,6 +776,11 @@ bool Scheduler::in_timerprocess()
     return _in_timer_proc;
 }
 
+bool Scheduler::in_main_thread()
+{
+    return pthread_equal(pthread_self(), _main_ctx);
+}
+
 void Scheduler::_wait_all_threads()
 {
     int r = pthread_barrier_wait(&_initialized_barrier);
@@ -437,7 +809,33 @@ void Scheduler::stop_clock(uint64_t time_usec)
 {
     if (time_usec >= _stopped_clock_usec) {
         _stopped_clock_usec = time_usec;
-        _run_io();
+        for (uint8_t i = 0; i < LINUX_SCHEDULER_IO_THREADS; i++) {
+            _run_io(i);
+        }
+    }
+}
+
+bool Scheduler::register_uart_pollable(Pollable *p, uint32_t events)
+{
+#if HAL_LINUX_UARTS_ON_TIMER_THREAD
+    // the timer thread can't block waiting for serial events
+    return false;
+#else
+    return _uart_poller.register_pollable(p, events);
+#endif
+}
+
+void Scheduler::UARTThread::_wait(uint64_t usec)
+{
+    const uint64_t deadline_usec = AP_HAL::micros64() + usec;
+
+    while (true) {
+        const uint64_t now_usec = AP_HAL::micros64();
+        if (now_usec >= deadline_usec) {
+            break;
+        }
+        // round up so we never spin on a sub-millisecond remainder
+        _sched._uart_poller.poll((deadline_usec - now_usec + 999) / 1000);
     }
 }
 
@@ -3,17 +3,24 @@
 #include <pthread.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
 #include "Semaphores.h"
 #include "Thread.h"
 
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_TIMESLICED_PROCS 10
 #define LINUX_SCHEDULER_MAX_IO_PROCS 10
+#define LINUX_SCHEDULER_IO_THREADS 2
+#define LINUX_SCHEDULER_MAX_WORKER_PROCS 4
+#define LINUX_SCHEDULER_MAX_STORAGE_PROCS 4
+#define LINUX_SCHEDULER_MAX_STARTUP_TASKS 4
 
 #define AP_LINUX_SENSORS_STACK_SIZE  256 * 1024
 #define AP_LINUX_SENSORS_SCHED_POLICY  SCHED_FIFO
 #define AP_LINUX_SENSORS_SCHED_PRIO 12
 
+#define LINUX_SCHEDULER_MAX_THREAD_CONFIGS 8
+
 namespace Linux {
 
 class Scheduler : public AP_HAL::Scheduler {
@@ -33,10 +40,16 @@ public:
     void     register_timer_process(AP_HAL::MemberProc);
     bool     register_timer_process(AP_HAL::MemberProc, uint8_t);
     void     register_io_process(AP_HAL::MemberProc);
+    bool     register_worker_process(AP_HAL::MemberProc) override;
+    bool     register_storage_process(AP_HAL::MemberProc) override;
+    bool     register_rate_process(AP_HAL::MemberProc, uint16_t rate_hz) override;
+    bool     run_startup_task(AP_HAL::MemberProc) override;
+    void     wait_startup_tasks() override;
     void     suspend_timer_procs();
     void     resume_timer_procs();
 
     bool     in_timerprocess();
+    bool     in_main_thread() override;
 
     void     register_timer_failsafe(AP_HAL::Proc, uint32_t period_us);
 
@@ -50,6 +63,35 @@ public:
 
     void microsleep(uint32_t usec);
 
+    /*
+     * Override the priority and CPU placement of a scheduler, IO or sensor
+     * bus thread. spec is "<thread name>:<priority>[:<cpu mask>]", for
+     * example "ap-spi-0:15:0x8" to run the first SPI bus on CPU 3.
+     */
+    bool set_thread_config(const char *spec);
+
+    /*
+     * Real-time memory mode, must be called before init(). Reserves and
+     * prefaults a heap pool of heap_kb kilobytes and the main thread
+     * stack, and keeps freed heap in the process so later allocations
+     * and deep call paths don't take page faults. 0 disables it.
+     */
+    void set_rt_memory(uint32_t heap_kb) { _rt_heap_kb = heap_kb; }
+
+    /*
+     * Get the priority and CPU affinity mask a thread should be started
+     * with, default_prio unless overridden. A zero mask means any CPU.
+     */
+    void get_thread_config(const char *name, int default_prio,
+                           int &prio, uint32_t &cpu_mask) const;
+
+    /*
+     * Have the UART thread dispatch events of a serial port file descriptor
+     * as they arrive instead of only polling the port every tick. Returns
+     * false if the UARTs can't be event driven on this board.
+     */
+    bool register_uart_pollable(Pollable *p, uint32_t events);
+
 private:
     class SchedulerThread : public PeriodicThread {
     public:
@@ -64,9 +106,51 @@ private:
         Scheduler &_sched;
     };
 
+    /* one of the threads sharing the registered IO processes */
+    class IOThread : public SchedulerThread {
+    public:
+        IOThread(Scheduler &sched, uint8_t index)
+            : SchedulerThread(FUNCTOR_BIND_MEMBER(&IOThread::_io_task, void), sched)
+            , _index(index)
+        { }
+
+    protected:
+        void _io_task() { _sched._io_task(_index); }
+
+        uint8_t _index;
+    };
+
+    /* serves the event driven serial ports while waiting for its tick */
+    class UARTThread : public SchedulerThread {
+    public:
+        UARTThread(Scheduler &sched)
+            : SchedulerThread(FUNCTOR_BIND(&sched, &Scheduler::_uart_task, void), sched)
+        { }
+
+    protected:
+        void _wait(uint64_t usec) override;
+    };
+
+    /* runs one task given to run_startup_task() and flags when it is done */
+    class StartupThread : public Thread {
+    public:
+        StartupThread() : Thread(nullptr) { }
+
+        void set_task(task_t t) { _task = t; }
+        bool is_done() const { return __atomic_load_n(&_done, __ATOMIC_ACQUIRE); }
+
+    protected:
+        bool _run() override;
+
+        bool _done = false;
+    };
+
     void _wait_all_threads();
 
     void     _debug_stack();
+    void     _update_thread_stats();
+    void     _update_page_faults();
+    void     _setup_rt_memory();
 
     AP_HAL::Proc _delay_cb;
     uint16_t _min_delay_cb_ms;
@@ -90,30 +174,85 @@ private:
     uint8_t _num_timesliced_procs;
     uint8_t _max_freq_div;
 
-    AP_HAL::MemberProc _io_proc[LINUX_SCHEDULER_MAX_IO_PROCS];
-    uint8_t _num_io_procs;
+    struct io_proc {
+        AP_HAL::MemberProc proc;
+        uint8_t thread;
+        uint32_t max_usec;
+        uint32_t overruns;
+        AP_HAL::Util::perf_counter_t perf;
+    };
+    io_proc _io_proc[LINUX_SCHEDULER_MAX_IO_PROCS];
+    volatile uint8_t _num_io_procs;
+
+    AP_HAL::MemberProc _worker_proc[LINUX_SCHEDULER_MAX_WORKER_PROCS];
+    volatile uint8_t _num_worker_procs;
+
+    AP_HAL::MemberProc _storage_proc[LINUX_SCHEDULER_MAX_STORAGE_PROCS];
+    volatile uint8_t _num_storage_procs;
 
     SchedulerThread _timer_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_timer_task, void), *this};
-    SchedulerThread _io_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_io_task, void), *this};
+    static_assert(LINUX_SCHEDULER_IO_THREADS == 2, "update _io_threads initializers");
+    IOThread _io_threads[LINUX_SCHEDULER_IO_THREADS]{{*this, 0}, {*this, 1}};
     SchedulerThread _rcin_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rcin_task, void), *this};
-    SchedulerThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
+    UARTThread _uart_thread{*this};
     SchedulerThread _tonealarm_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_tonealarm_task, void), *this};
+    SchedulerThread _worker_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_worker_task, void), *this};
+    SchedulerThread _storage_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_storage_task, void), *this};
+
+    /*
+     * started when a rate process is registered, after the other threads
+     * have passed the initialisation barrier
+     */
+    PeriodicThread _rate_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rate_task, void)};
+    AP_HAL::MemberProc _rate_proc;
+
+    StartupThread _startup_threads[LINUX_SCHEDULER_MAX_STARTUP_TASKS];
+    uint8_t _num_startup_tasks;
+
+    // the delay callback is only run from the main thread
+    pthread_t _main_ctx;
 
     void _timer_task();
-    void _io_task();
+    void _io_task(uint8_t index);
     void _rcin_task();
     void _uart_task();
     void _tonealarm_task();
+    void _worker_task();
+    void _storage_task();
+    void _rate_task();
 
-    void _run_io();
+    void _run_io(uint8_t index);
     void _run_uarts();
     bool _register_timesliced_proc(AP_HAL::MemberProc, uint8_t);
 
     uint64_t _stopped_clock_usec;
     uint64_t _last_stack_debug_msec;
+    uint64_t _last_thread_stats_msec;
+    uint64_t _last_page_faults_msec;
+
+    /* the counters only cover faults after the first sample */
+    struct {
+        AP_HAL::Util::perf_counter_t perf_major;
+        AP_HAL::Util::perf_counter_t perf_minor;
+        long last_major;
+        long last_minor;
+        bool allocated;
+    } _page_faults;
+
+    uint32_t _rt_heap_kb;
+
+    Poller _uart_poller;
 
     Semaphore _timer_semaphore;
-    Semaphore _io_semaphore;
+    Semaphore _io_semaphore[LINUX_SCHEDULER_IO_THREADS];
+
+    struct thread_config {
+        char name[16];
+        int prio;
+        uint32_t cpu_mask;
+    };
+    thread_config _thread_config[LINUX_SCHEDULER_MAX_THREAD_CONFIGS];
+    uint8_t _num_thread_configs;
 };
 
 }
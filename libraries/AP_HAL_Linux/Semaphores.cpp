@@ -1,35 +1,129 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
 
+#include "Util.h"
+#include "Perf.h"
 #include "Semaphores.h"
 
 extern const AP_HAL::HAL& hal;
 
 using namespace Linux;
 
+static inline uint64_t now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_nsec + (ts.tv_sec * NSEC_PER_SEC);
+}
+
+Semaphore::Semaphore()
+    : _owned(false)
+    , _perf_wait(nullptr)
+    , _wait_count(0)
+    , _max_wait_us(0)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void Semaphore::set_name(const char *name)
+{
+    if (_perf_wait != nullptr) {
+        return;
+    }
+    char perf_name[32];
+    snprintf(perf_name, sizeof(perf_name), "sem-%s", name);
+    _perf_wait = Perf::get_instance()->add(AP_HAL::Util::PC_ELAPSED, strdup(perf_name));
+}
+
 bool Semaphore::give()
 {
+    _owned = false;
     return pthread_mutex_unlock(&_lock) == 0;
 }
 
-bool Semaphore::take(uint32_t timeout_ms)
+void Semaphore::_took()
+{
+    _owner = pthread_self();
+    _owned = true;
+}
+
+/*
+ * account for a take that had to wait. The owner is read before
+ * waiting, so it is the thread that held us up
+ */
+void Semaphore::_record_wait(pthread_t owner, bool owner_known, uint64_t start_nsec)
 {
-    if (timeout_ms == 0) {
-        return pthread_mutex_lock(&_lock) == 0;
+    const uint64_t waited = now_nsec() - start_nsec;
+    const uint32_t waited_us = MIN(waited / NSEC_PER_USEC, UINT32_MAX);
+
+    _wait_count++;
+    if (_perf_wait == nullptr) {
+        if (waited_us > _max_wait_us) {
+            _max_wait_us = waited_us;
+        }
+        return;
+    }
+
+    char owner_name[16] = "?";
+    if (waited_us > _max_wait_us) {
+        _max_wait_us = waited_us;
+        // only named for a new longest wait, as the name comes from /proc
+        if (owner_known) {
+            pthread_getname_np(owner, owner_name, sizeof(owner_name));
+        }
+        Perf::get_instance()->sample(_perf_wait, waited, owner_name);
+    } else {
+        Perf::get_instance()->sample(_perf_wait, waited);
     }
+}
+
+bool Semaphore::take(uint32_t timeout_ms)
+{
     if (take_nonblocking()) {
         return true;
     }
-    uint64_t start = AP_HAL::micros64();
-    do {
-        hal.scheduler->delay_microseconds(200);
-        if (take_nonblocking()) {
-            return true;
-        }
-    } while ((AP_HAL::micros64() - start) < timeout_ms*1000);
-    return false;
+
+    const pthread_t owner = _owner;
+    const bool owner_known = _owned;
+    const uint64_t start = now_nsec();
+
+    int ret;
+    if (timeout_ms == 0 || timeout_ms == HAL_SEMAPHORE_BLOCK_FOREVER) {
+        ret = pthread_mutex_lock(&_lock);
+    } else {
+        // a timed lock keeps priority inheritance while waiting, which
+        // polling with trylock would not
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        const uint64_t deadline = ts.tv_nsec + (uint64_t)timeout_ms * 1000000ULL;
+        ts.tv_sec += deadline / NSEC_PER_SEC;
+        ts.tv_nsec = deadline % NSEC_PER_SEC;
+        do {
+            ret = pthread_mutex_timedlock(&_lock, &ts);
+        } while (ret == EINTR);
+    }
+    if (ret != 0) {
+        return false;
+    }
+    _took();
+    _record_wait(owner, owner_known, start);
+    return true;
 }
 
 bool Semaphore::take_nonblocking()
 {
-    return pthread_mutex_trylock(&_lock) == 0;
+    if (pthread_mutex_trylock(&_lock) != 0) {
+        return false;
+    }
+    _took();
+    return true;
 }
@@ -3,21 +3,51 @@
 #include <pthread.h>
 
 #include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_HAL/Util.h>
 
 #include "AP_HAL_Linux.h"
 
 namespace Linux {
 
+/*
+ * Mutex with priority inheritance, so a low priority thread holding a
+ * bus can't be held off by a medium priority one while a high
+ * priority thread waits for it. Takes that have to wait are counted
+ * and timed through Linux::Perf once the semaphore has a name.
+ */
 class Semaphore : public AP_HAL::Semaphore {
 public:
-    Semaphore() {
-        pthread_mutex_init(&_lock, NULL);
-    }
+    Semaphore();
     bool give();
     bool take(uint32_t timeout_ms);
     bool take_nonblocking();
+
+    /*
+     * Name the semaphore, creating a perf counter "sem-NAME" timing
+     * every take that had to wait. Call once, before the semaphore is
+     * shared between threads.
+     */
+    void set_name(const char *name);
+
+    /* number of takes that had to wait */
+    uint32_t get_wait_count() const { return _wait_count; }
+
+    /* longest wait in microseconds */
+    uint32_t get_max_wait_us() const { return _max_wait_us; }
+
 private:
     pthread_mutex_t _lock;
+
+    /* thread holding the lock, only valid while _owned */
+    pthread_t _owner;
+    volatile bool _owned;
+
+    AP_HAL::Util::perf_counter_t _perf_wait;
+    uint32_t _wait_count;
+    uint32_t _max_wait_us;
+
+    void _took();
+    void _record_wait(pthread_t owner, bool owner_known, uint64_t start_nsec);
 };
 
 }
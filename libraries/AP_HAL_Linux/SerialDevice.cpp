@@ -0,0 +1,27 @@
+#include "SerialDevice.h"
+
+#include <string.h>
+
+int SerialDevice::write_packets(const Packet *pkts, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        const Packet &pkt = pkts[i];
+        ssize_t ret;
+
+        if (pkt.iovcnt == 1) {
+            ret = write((const uint8_t *)pkt.iov[0].iov_base, pkt.iov[0].iov_len);
+        } else {
+            const size_t len = pkt.iov[0].iov_len + pkt.iov[1].iov_len;
+            uint8_t tmpbuf[len];
+            memcpy(tmpbuf, pkt.iov[0].iov_base, pkt.iov[0].iov_len);
+            memcpy(tmpbuf + pkt.iov[0].iov_len, pkt.iov[1].iov_base, pkt.iov[1].iov_len);
+            ret = write(tmpbuf, len);
+        }
+
+        if (ret <= 0) {
+            return i > 0 ? i : -1;
+        }
+    }
+
+    return count;
+}
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/uio.h>
 
 #include "AP_HAL_Linux.h"
 
@@ -13,8 +14,34 @@ public:
     virtual bool close() = 0;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) = 0;
     virtual ssize_t read(uint8_t *buf, uint16_t n) = 0;
+
+    /* one datagram, which may wrap around the end of a ring buffer */
+    struct Packet {
+        struct iovec iov[2];
+        uint8_t iovcnt;
+    };
+
+    /*
+     * Write count packets keeping their boundaries. Returns the number of
+     * packets written, or -1 if none could be. The default writes them one
+     * at a time.
+     */
+    virtual int write_packets(const Packet *pkts, uint8_t count);
+
     virtual void set_blocking(bool blocking) = 0;
     virtual void set_speed(uint32_t speed) = 0;
+
+    /*
+     * File descriptor to wait on for input, valid as long as the device
+     * is open, or -1 if the device has to be polled.
+     */
+    virtual int get_fd() const { return -1; }
+
+    /*
+     * Time on the wire of one received byte, or 0 if bytes arrive in
+     * packets, to date the bytes of a read back from the time of the read.
+     */
+    virtual uint32_t get_byte_time_ns() const { return 0; }
     virtual AP_HAL::UARTDriver::flow_control get_flow_control(void) { return AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE; }
     virtual void set_flow_control(AP_HAL::UARTDriver::flow_control flow_control_setting)
     {
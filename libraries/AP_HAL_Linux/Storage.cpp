@@ -9,6 +9,7 @@
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/edc.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
 
 using namespace Linux;
@@ -16,6 +17,13 @@ using namespace Linux;
 /*
   This stores 'eeprom' data on the SD card, with a 4k size, and a
   in-memory buffer. This keeps the latency down.
+
+  Changed lines are not written in place. They are appended to a
+  journal next to the storage file, all dirty lines in one write, and
+  the journal is replayed over the storage file on startup. Once the
+  journal is long enough the whole buffer is written to a new storage
+  file which is renamed over the old one, so the storage file is never
+  left half written.
  */
 
 // name the storage file after the sketch so you can use the same board
@@ -28,6 +36,10 @@ using namespace Linux;
 #define STORAGE_DIR "/var/APM"
 #endif
 #define STORAGE_FILE STORAGE_DIR "/" SKETCHNAME ".stg"
+#define STORAGE_JOURNAL STORAGE_DIR "/" SKETCHNAME ".stj"
+#define STORAGE_TMP_FILE STORAGE_FILE ".tmp"
+
+#define STORAGE_JOURNAL_MAGIC 0x4A545341
 
 extern const AP_HAL::HAL& hal;
 
@@ -35,6 +47,8 @@ void Storage::_storage_create(void)
 {
     mkdir(STORAGE_DIR, 0777);
     unlink(STORAGE_FILE);
+    // a journal of changes to the old file is meaningless now
+    unlink(STORAGE_JOURNAL);
     int fd = open(STORAGE_FILE, O_RDWR|O_CREAT, 0666);
     if (fd == -1) {
         AP_HAL::panic("Failed to create " STORAGE_FILE);
@@ -89,9 +103,86 @@ void Storage::_storage_open(void)
         }
     }
     close(fd);
+    _journal_replay();
     _initialised = true;
 }
 
+uint32_t Storage::_record_crc(const struct journal_record &rec)
+{
+    uint32_t crc = crc_crc32(0, (const uint8_t *)&rec.seq, sizeof(rec.seq));
+    crc = crc_crc32(crc, &rec.line, sizeof(rec.line));
+    return crc_crc32(crc, rec.data, sizeof(rec.data));
+}
+
+/*
+  apply the journal over the buffer. Replay stops at the first record
+  which is torn or out of sequence, and the journal is cut back to the
+  good records so new ones follow on from them
+ */
+void Storage::_journal_replay(void)
+{
+    _journal_seq = 0;
+    _journal_records = 0;
+
+    int fd = open(STORAGE_JOURNAL, O_RDWR);
+    if (fd == -1) {
+        return;
+    }
+
+    struct journal_record &rec = _journal_buf[0];
+    off_t good_length = 0;
+    while (read(fd, &rec, sizeof(rec)) == sizeof(rec)) {
+        if (rec.magic != STORAGE_JOURNAL_MAGIC ||
+            rec.line >= LINUX_STORAGE_NUM_LINES ||
+            (_journal_records != 0 && rec.seq != _journal_seq) ||
+            rec.crc != _record_crc(rec)) {
+            break;
+        }
+        memcpy(&_buffer[rec.line<<LINUX_STORAGE_LINE_SHIFT], rec.data, sizeof(rec.data));
+        _journal_seq = rec.seq + 1;
+        _journal_records++;
+        good_length += sizeof(rec);
+    }
+
+    if (lseek(fd, 0, SEEK_END) != good_length) {
+        if (ftruncate(fd, good_length) != 0 || fsync(fd) != 0) {
+            AP_HAL::panic("Failed to trim " STORAGE_JOURNAL);
+        }
+    }
+    close(fd);
+}
+
+/*
+  write the whole buffer to a new storage file, swap it in, then empty
+  the journal. If power is lost before the journal is emptied then the
+  journal is replayed over the new file, which only holds what is
+  already in it
+ */
+void Storage::_journal_compact(void)
+{
+    int fd = open(STORAGE_TMP_FILE, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd == -1) {
+        return;
+    }
+    if (write(fd, _buffer, sizeof(_buffer)) != sizeof(_buffer) ||
+        fsync(fd) != 0) {
+        close(fd);
+        unlink(STORAGE_TMP_FILE);
+        return;
+    }
+    close(fd);
+    if (rename(STORAGE_TMP_FILE, STORAGE_FILE) != 0) {
+        unlink(STORAGE_TMP_FILE);
+        return;
+    }
+    if (ftruncate(_fd, 0) != 0 || fsync(_fd) != 0) {
+        close(_fd);
+        _fd = -1;
+        return;
+    }
+    _journal_records = 0;
+}
+
 /*
   mark some lines as dirty. Note that there is no attempt to avoid
   the race condition between this code and the _timer_tick() code
@@ -101,7 +192,9 @@ void Storage::_storage_open(void)
  */
 void Storage::_mark_dirty(uint16_t loc, uint16_t length)
 {
-    uint16_t end = loc + length;
+    // end is the last byte written, so a write which finishes on a
+    // line boundary doesn't dirty the following line
+    uint16_t end = loc + length - 1;
     for (uint8_t line=loc>>LINUX_STORAGE_LINE_SHIFT;
          line <= end>>LINUX_STORAGE_LINE_SHIFT;
          line++) {
@@ -137,54 +230,62 @@ void Storage::_timer_tick(void)
     }
 
     if (_fd == -1) {
-        _fd = open(STORAGE_FILE, O_WRONLY);
+        _fd = open(STORAGE_JOURNAL, O_WRONLY|O_CREAT|O_APPEND, 0666);
         if (_fd == -1) {
             return;
         }
     }
 
-    // write out the first dirty set of lines. We don't write more
-    // than one to keep the latency of this call to a minimum
-    uint8_t i, n;
-    for (i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
-        if (_dirty_mask & (1<<i)) {
-            break;
-        }
-    }
-    if (i == LINUX_STORAGE_NUM_LINES) {
-        // this shouldn't be possible
-        return;
-    }
-    uint32_t write_mask = (1U<<i);
-    // see how many lines to write
-    for (n=1; (i+n) < LINUX_STORAGE_NUM_LINES &&
-             n < (LINUX_STORAGE_MAX_WRITE>>LINUX_STORAGE_LINE_SHIFT); n++) {
-        if (!(_dirty_mask & (1<<(n+i)))) {
-            break;
+    if (_journal_records >= LINUX_STORAGE_JOURNAL_MAX_RECORDS) {
+        // a previous compaction or a torn write is outstanding
+        _journal_compact();
+        if (_fd == -1) {
+            return;
         }
-        // mark that line clean
-        write_mask |= (1<<(n+i));
     }
 
     /*
-      write the lines. This also updates _dirty_mask. Note that
-      because this is a SCHED_FIFO thread it will not be preempted
-      by the main task except during blocking calls. This means we
-      don't need a semaphore around the _dirty_mask updates.
+      pack every dirty line into the journal buffer. The lines are
+      marked clean before they are copied, so a write which lands
+      while we copy dirties the line again. Note that because this is
+      a SCHED_FIFO thread it will not be preempted by the main task
+      except during blocking calls. This means we don't need a
+      semaphore around the _dirty_mask updates.
      */
-    if (lseek(_fd, i<<LINUX_STORAGE_LINE_SHIFT, SEEK_SET) == (i<<LINUX_STORAGE_LINE_SHIFT)) {
-        _dirty_mask &= ~write_mask;
-        if (write(_fd, &_buffer[i<<LINUX_STORAGE_LINE_SHIFT], n<<LINUX_STORAGE_LINE_SHIFT) != n<<LINUX_STORAGE_LINE_SHIFT) {
-            // write error - likely EINTR
-            _dirty_mask |= write_mask;
-            close(_fd);
-            _fd = -1;
+    const uint32_t write_mask = _dirty_mask;
+    _dirty_mask &= ~write_mask;
+    uint8_t n = 0;
+    for (uint8_t i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
+        if (!(write_mask & (1U<<i))) {
+            continue;
         }
-        if (_dirty_mask == 0) {
-            if (fsync(_fd) != 0) {
-                close(_fd);
-                _fd = -1;
-            }
+        struct journal_record &rec = _journal_buf[n++];
+        rec.magic = STORAGE_JOURNAL_MAGIC;
+        rec.seq = _journal_seq + n - 1;
+        rec.line = i;
+        memset(rec.reserved, 0, sizeof(rec.reserved));
+        memcpy(rec.data, &_buffer[i<<LINUX_STORAGE_LINE_SHIFT], sizeof(rec.data));
+        rec.crc = _record_crc(rec);
+    }
+
+    const ssize_t len = n * sizeof(struct journal_record);
+    if (write(_fd, _journal_buf, len) != len || fdatasync(_fd) != 0) {
+        // write error - likely EINTR. Cut off anything partly
+        // written so the next records follow on from the good ones
+        _dirty_mask |= write_mask;
+        if (ftruncate(_fd, _journal_records * sizeof(struct journal_record)) != 0) {
+            // replay stops at the torn record, fold the journal in
+            // on the next tick rather than append after it
+            _journal_records = LINUX_STORAGE_JOURNAL_MAX_RECORDS;
         }
+        close(_fd);
+        _fd = -1;
+        return;
+    }
+    _journal_seq += n;
+    _journal_records += n;
+
+    if (_journal_records >= LINUX_STORAGE_JOURNAL_MAX_RECORDS) {
+        _journal_compact();
     }
 }
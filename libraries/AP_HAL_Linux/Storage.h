@@ -1,5 +1,6 @@
 #pragma once
 
+#include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
 
 #define LINUX_STORAGE_SIZE HAL_STORAGE_SIZE
@@ -8,12 +9,16 @@
 #define LINUX_STORAGE_LINE_SIZE (1<<LINUX_STORAGE_LINE_SHIFT)
 #define LINUX_STORAGE_NUM_LINES (LINUX_STORAGE_SIZE/LINUX_STORAGE_LINE_SIZE)
 
+// number of journal records appended before the journal is folded
+// back into the storage image
+#define LINUX_STORAGE_JOURNAL_MAX_RECORDS 128
+
 namespace Linux {
 
 class Storage : public AP_HAL::Storage
 {
 public:
-    Storage() : _fd(-1),_dirty_mask(0) { }
+    Storage() : _fd(-1),_dirty_mask(0),_journal_seq(0),_journal_records(0) { }
 
     static Storage *from(AP_HAL::Storage *storage) {
         return static_cast<Storage*>(storage);
@@ -39,6 +44,32 @@ protected:
     volatile bool _initialised;
     uint8_t _buffer[LINUX_STORAGE_SIZE];
     volatile uint32_t _dirty_mask;
+
+private:
+    /*
+      one changed line, appended to the journal. The CRC covers the
+      sequence number, the line number and the data, so a record torn
+      by a power loss is discarded on replay
+     */
+    struct PACKED journal_record {
+        uint32_t magic;
+        uint32_t seq;
+        uint8_t line;
+        uint8_t reserved[3];
+        uint32_t crc;
+        uint8_t data[LINUX_STORAGE_LINE_SIZE];
+    };
+
+    static uint32_t _record_crc(const struct journal_record &rec);
+    void _journal_replay(void);
+    void _journal_compact(void);
+
+    // next journal sequence number, and records since the last compaction
+    uint32_t _journal_seq;
+    uint16_t _journal_records;
+
+    // all dirty lines are packed here and written with a single write()
+    struct journal_record _journal_buf[LINUX_STORAGE_NUM_LINES];
 };
 
 }
@@ -6,6 +6,7 @@
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -18,43 +19,77 @@ TCPServerDevice::TCPServerDevice(const char *ip, uint16_t port, bool wait):
 
 TCPServerDevice::~TCPServerDevice()
 {
-    if (sock != NULL) {
-        delete sock;
-        sock = NULL;
+    close();
+}
+
+void TCPServerDevice::_accept_clients()
+{
+    while (_num_clients < LINUX_TCP_MAX_CLIENTS) {
+        SocketAPM *sock = listener.accept(0);
+        if (sock == NULL) {
+            return;
+        }
+        sock->set_blocking(_blocking);
+        _clients[_num_clients++] = sock;
     }
 }
 
+void TCPServerDevice::_drop_client(uint8_t i)
+{
+    delete _clients[i];
+    _clients[i] = _clients[--_num_clients];
+    _clients[_num_clients] = NULL;
+}
+
+/*
+  send the same bytes to every client, straight from the caller's
+  buffer. The count returned is the most any client took, as with a
+  single client; a slower client loses the rest of the buffer rather
+  than holding up the others, and a disconnected one is dropped
+ */
 ssize_t TCPServerDevice::write(const uint8_t *buf, uint16_t n)
 {
-    if (sock == NULL) {
-        return -1;
+    ssize_t ret = -1;
+
+    for (uint8_t i = 0; i < _num_clients; ) {
+        const ssize_t sent = ::send(_clients[i]->get_read_fd(), buf, n, MSG_NOSIGNAL);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            _drop_client(i);
+            continue;
+        }
+        ret = MAX(ret, sent);
+        i++;
     }
-    return sock->send(buf, n);
+    return ret;
 }
 
 /*
-  when we try to read we accept new connections if one isn't already
-  established
+  when we try to read we accept any new connections, then read from
+  the clients in turn starting after the last one read, so a busy
+  client can't starve the others. Bytes from different clients are
+  not interleaved within a read
  */
 ssize_t TCPServerDevice::read(uint8_t *buf, uint16_t n)
 {
-    if (sock == NULL) {
-        sock = listener.accept(0);
-        if (sock != NULL) {
-            sock->set_blocking(_blocking);
+    _accept_clients();
+
+    for (uint8_t tries = _num_clients; tries > 0 && _num_clients > 0; tries--) {
+        if (_next_read >= _num_clients) {
+            _next_read = 0;
+        }
+        const uint8_t i = _next_read;
+        const ssize_t ret = _clients[i]->recv(buf, n, 0);
+        if (ret == 0) {
+            // EOF, this client has gone
+            _drop_client(i);
+            continue;
+        }
+        _next_read = i + 1;
+        if (ret > 0) {
+            return ret;
         }
     }
-    if (sock == NULL) {
-        return -1;
-    }
-    ssize_t ret = sock->recv(buf, n, 1);
-    if (ret == 0) {
-        // EOF, go back to waiting for a new connection
-        delete sock;
-        sock = NULL;
-        return -1;
-    }
-    return ret;
+    return -1;
 }
 
 bool TCPServerDevice::open()
@@ -72,7 +107,7 @@ bool TCPServerDevice::open()
         return false;
     }
 
-    if (!listener.listen(1)) {
+    if (!listener.listen(LINUX_TCP_MAX_CLIENTS)) {
         if (AP_HAL::millis() - _last_bind_warning > 5000) {
             ::printf("listen failed on %s port %u - %s\n",
                      _ip,
@@ -89,10 +124,13 @@ bool TCPServerDevice::open()
         ::printf("Waiting for connection on %s:%u ....\n",
                  _ip, (unsigned)_port);
         ::fflush(stdout);
-        while (sock == NULL) {
-            sock = listener.accept(1000);
+        while (_num_clients == 0) {
+            SocketAPM *sock = listener.accept(1000);
+            if (sock != NULL) {
+                sock->set_blocking(_blocking);
+                _clients[_num_clients++] = sock;
+            }
         }
-        sock->set_blocking(_blocking);
         ::printf("connected\n");
         ::fflush(stdout);
     }
@@ -102,9 +140,8 @@ bool TCPServerDevice::open()
 
 bool TCPServerDevice::close()
 {
-    if (sock != NULL) {
-        delete sock;
-        sock = NULL;
+    while (_num_clients > 0) {
+        _drop_client(_num_clients - 1);
     }
     return true;
 }
@@ -113,6 +150,9 @@ void TCPServerDevice::set_blocking(bool blocking)
 {
     _blocking = blocking;
     listener.set_blocking(_blocking);
+    for (uint8_t i = 0; i < _num_clients; i++) {
+        _clients[i]->set_blocking(_blocking);
+    }
 }
 
 void TCPServerDevice::set_speed(uint32_t speed)
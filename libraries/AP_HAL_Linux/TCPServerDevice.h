@@ -3,6 +3,11 @@
 #include "SerialDevice.h"
 #include <AP_HAL/utility/Socket.h>
 
+// clients served at the same time on one port
+#ifndef LINUX_TCP_MAX_CLIENTS
+#define LINUX_TCP_MAX_CLIENTS 4
+#endif
+
 class TCPServerDevice: public SerialDevice {
 public:
     TCPServerDevice(const char *ip, uint16_t port, bool wait);
@@ -16,8 +21,16 @@ public:
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
 
 private:
+    void _accept_clients();
+    void _drop_client(uint8_t i);
+
     SocketAPM listener{false};
-    SocketAPM *sock = NULL;
+    SocketAPM *_clients[LINUX_TCP_MAX_CLIENTS] {};
+    uint8_t _num_clients = 0;
+
+    // client to read from first, so each gets its turn
+    uint8_t _next_read = 0;
+
     const char *_ip;
     uint16_t _port;
     bool _wait;
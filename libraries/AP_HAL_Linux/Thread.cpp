@@ -17,8 +17,10 @@
 #include "Thread.h"
 
 #include <alloca.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 #include <utility>
 
@@ -33,10 +35,35 @@ extern const AP_HAL::HAL &hal;
 
 namespace Linux {
 
+Thread *Thread::_registry[LINUX_MAX_THREADS];
+uint8_t Thread::_registry_count;
+
+Thread::~Thread()
+{
+    for (uint8_t i = 0; i < get_count(); i++) {
+        if (_registry[i] == this) {
+            __atomic_store_n(&_registry[i], nullptr, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+uint8_t Thread::get_count()
+{
+    return MIN(__atomic_load_n(&_registry_count, __ATOMIC_ACQUIRE), LINUX_MAX_THREADS);
+}
+
+Thread *Thread::get_thread(uint8_t idx)
+{
+    if (idx >= get_count()) {
+        return nullptr;
+    }
+    return __atomic_load_n(&_registry[idx], __ATOMIC_ACQUIRE);
+}
 
 void *Thread::_run_trampoline(void *arg)
 {
     Thread *thread = static_cast<Thread *>(arg);
+    thread->_tid = syscall(SYS_gettid);
     thread->_poison_stack();
     thread->_run();
 
@@ -149,7 +176,49 @@ size_t Thread::get_stack_usage()
         result = _stack_debug.start - p;
     }
 
-    return result;
+    return result * sizeof(uint32_t);
+}
+
+/*
+ * getrusage(RUSAGE_THREAD) only reports on the calling thread, so the
+ * CPU time comes from the thread's CPU clock and the context switches
+ * from the same counters in procfs
+ */
+void Thread::update_stats()
+{
+    if (!_started) {
+        return;
+    }
+
+    _stats.stack_used = get_stack_usage();
+    _stats.stack_size = labs(_stack_debug.start - _stack_debug.end) * sizeof(uint32_t);
+
+    clockid_t cid;
+    struct timespec ts;
+    if (pthread_getcpuclockid(_ctx, &cid) == 0 && clock_gettime(cid, &ts) == 0) {
+        _stats.cpu_usec = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    }
+
+    if (_tid == 0) {
+        return;
+    }
+
+    char path[40];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", (int)_tid);
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        return;
+    }
+    char line[64];
+    unsigned v;
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        if (sscanf(line, "voluntary_ctxt_switches: %u", &v) == 1) {
+            _stats.voluntary_switches = v;
+        } else if (sscanf(line, "nonvoluntary_ctxt_switches: %u", &v) == 1) {
+            _stats.involuntary_switches = v;
+        }
+    }
+    fclose(f);
 }
 
 bool Thread::start(const char *name, int policy, int prio)
@@ -184,6 +253,20 @@ bool Thread::start(const char *name, int policy, int prio)
         }
     }
 
+    if (_cpu_mask) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (uint8_t cpu = 0; cpu < 32; cpu++) {
+            if (_cpu_mask & (1U << cpu)) {
+                CPU_SET(cpu, &cpuset);
+            }
+        }
+        if ((r = pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset)) != 0) {
+            AP_HAL::panic("Failed to set CPU affinity for thread '%s': %s",
+                          name, strerror(r));
+        }
+    }
+
     r = pthread_create(&_ctx, &attr, &Thread::_run_trampoline, this);
     if (r != 0) {
         AP_HAL::panic("Failed to create thread '%s': %s",
@@ -193,10 +276,18 @@ bool Thread::start(const char *name, int policy, int prio)
 
     if (name) {
         pthread_setname_np(_ctx, name);
+        strncpy(_name, name, sizeof(_name) - 1);
     }
 
     _started = true;
 
+    /* threads may be started concurrently, reserve the slot first. A
+     * reserved slot reads as nullptr until it is filled in */
+    uint8_t idx = __atomic_fetch_add(&_registry_count, 1, __ATOMIC_ACQ_REL);
+    if (idx < LINUX_MAX_THREADS) {
+        __atomic_store_n(&_registry[idx], this, __ATOMIC_RELEASE);
+    }
+
     return true;
 }
 
@@ -227,6 +318,17 @@ bool Thread::set_stack_size(size_t stack_size)
     return true;
 }
 
+bool Thread::set_cpu_affinity(uint32_t cpu_mask)
+{
+    if (_started) {
+        return false;
+    }
+
+    _cpu_mask = cpu_mask;
+
+    return true;
+}
+
 bool PeriodicThread::_run()
 {
     uint64_t next_run_usec = AP_HAL::micros64() + _period_usec;
@@ -237,7 +339,7 @@ bool PeriodicThread::_run()
             // we've lost sync - restart
             next_run_usec = AP_HAL::micros64();
         } else {
-            Scheduler::from(hal.scheduler)->microsleep(dt);
+            _wait(dt);
         }
         next_run_usec += _period_usec;
 
@@ -247,4 +349,9 @@ bool PeriodicThread::_run()
     return true;
 }
 
+void PeriodicThread::_wait(uint64_t usec)
+{
+    Scheduler::from(hal.scheduler)->microsleep(usec);
+}
+
 }
@@ -19,9 +19,12 @@
 #include <pthread.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <sys/types.h>
 
 #include <AP_HAL/utility/functor.h>
 
+#define LINUX_MAX_THREADS 32
+
 namespace Linux {
 
 /*
@@ -33,7 +36,19 @@ public:
 
     Thread(task_t t) : _task(t) { }
 
-    virtual ~Thread() { }
+    virtual ~Thread();
+
+    /*
+     * Stack high-water mark and run-time statistics, as of the last
+     * update_stats() call
+     */
+    struct stats {
+        size_t stack_used;              // bytes
+        size_t stack_size;              // bytes, excluding the guard
+        uint64_t cpu_usec;
+        uint32_t voluntary_switches;
+        uint32_t involuntary_switches;
+    };
 
     bool start(const char *name, int policy, int prio);
 
@@ -41,10 +56,36 @@ public:
 
     bool is_started() const { return _started; }
 
+    /* bytes of stack used so far, 0 if not tracked */
     size_t get_stack_usage();
 
+    /*
+     * Refresh the statistics. May be called from any thread: it scans
+     * the poisoned stack and reads the kernel's per-thread counters, so
+     * it should be called at low rate from a thread that can block.
+     */
+    void update_stats();
+
+    const struct stats &get_stats() const { return _stats; }
+
+    const char *get_name() const { return _name; }
+
+    /*
+     * Every started thread is registered until destroyed. Slots of
+     * destroyed threads read back as nullptr
+     */
+    static uint8_t get_count();
+    static Thread *get_thread(uint8_t idx);
+
     bool set_stack_size(size_t stack_size);
 
+    /*
+     * Restrict the thread to the CPUs set in cpu_mask, bit 0 being CPU 0.
+     * Must be called before start(); a zero mask leaves the thread free
+     * to run on any CPU.
+     */
+    bool set_cpu_affinity(uint32_t cpu_mask);
+
 protected:
     static void *_run_trampoline(void *arg);
 
@@ -58,15 +99,22 @@ protected:
     void _poison_stack();
 
     task_t _task;
-    bool _started;
+    bool _started = false;
     pthread_t _ctx;
+    pid_t _tid = 0;
+    char _name[16] {};
+    struct stats _stats {};
+
+    static Thread *_registry[LINUX_MAX_THREADS];
+    static uint8_t _registry_count;
 
     struct stack_debug {
         uint32_t *start;
         uint32_t *end;
     } _stack_debug;
 
-    size_t _stack_size;
+    size_t _stack_size = 0;
+    uint32_t _cpu_mask = 0;
 };
 
 class PeriodicThread : public Thread {
@@ -80,6 +128,9 @@ public:
 protected:
     bool _run() override;
 
+    /* wait for the next period, usec from now */
+    virtual void _wait(uint64_t usec);
+
     uint64_t _period_usec;
 };
 
@@ -108,6 +108,11 @@ void UARTDevice::set_speed(uint32_t baudrate)
     tcgetattr(_fd, &t);
     cfsetspeed(&t, baudrate);
     tcsetattr(_fd, TCSANOW, &t);
+
+    if (baudrate != 0) {
+        /* start, 8 data and stop bits */
+        _byte_time_ns = 10000000000ULL / baudrate;
+    }
 }
 
 void UARTDevice::set_flow_control(AP_HAL::UARTDriver::flow_control flow_control_setting)
@@ -12,6 +12,8 @@ public:
     virtual bool close() override;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+    virtual int get_fd() const override { return _fd; }
+    virtual uint32_t get_byte_time_ns() const override { return _byte_time_ns; }
     virtual void set_blocking(bool blocking) override;
     virtual void set_speed(uint32_t speed) override;
     virtual void set_flow_control(enum AP_HAL::UARTDriver::flow_control flow_control_setting) override;
@@ -26,4 +28,5 @@ private:
 
     int _fd = -1;
     const char *_device_path;
+    uint32_t _byte_time_ns = 0;
 };
@@ -20,6 +20,8 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "ConsoleDevice.h"
+#include "SHMDevice.h"
+#include "Scheduler.h"
 #include "TCPServerDevice.h"
 #include "UARTDevice.h"
 #include "UARTQFlight.h"
@@ -88,6 +90,40 @@ void UARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
     _device->set_speed(b);
 
     _allocate_buffers(rxS, txS);
+    _receive_times.reset();
+    _receive_times.set_byte_time_ns(_device->get_byte_time_ns());
+
+    if (_connected && !_event_driven) {
+        _register_pollable();
+    }
+}
+
+/*
+  have the UART thread read the device as soon as data arrives and
+  flush it as soon as it can take more. Ports without a pollable file
+  descriptor stay polled from _timer_tick()
+ */
+void UARTDriver::_register_pollable()
+{
+    const int fd = _device->get_fd();
+    if (fd < 0) {
+        return;
+    }
+
+    // the pollable owns its descriptor, so give it a duplicate
+    const int dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dup_fd < 0) {
+        return;
+    }
+    _pollable.set_fd(dup_fd);
+
+    // writes are mostly possible, so only wake up when a full port drains
+    _event_driven = Scheduler::from(hal.scheduler)->register_uart_pollable(
+        &_pollable, EPOLLIN | EPOLLOUT | EPOLLET);
+    if (!_event_driven) {
+        _pollable.set_fd(-1);
+        close(dup_fd);
+    }
 }
 
 void UARTDriver::_allocate_buffers(uint16_t rxS, uint16_t txS)
@@ -120,6 +156,8 @@ void UARTDriver::_deallocate_buffers()
         - /dev/ttyO1
         - tcp:*:1243:wait
         - udp:192.168.2.15:1243
+        - udp:192.168.2.15,192.168.2.16:1243 (same packets to each address)
+        - shm:/ardupilot-mav (shared memory with a local process)
 */
 AP_HAL::OwnPtr<SerialDevice> UARTDriver::_parseDevicePath(const char *arg)
 {
@@ -127,6 +165,8 @@ AP_HAL::OwnPtr<SerialDevice> UARTDriver::_parseDevicePath(const char *arg)
 
     if (stat(arg, &st) == 0 && S_ISCHR(st.st_mode)) {
         return AP_HAL::OwnPtr<SerialDevice>(new UARTDevice(arg));
+    } else if (strncmp(arg, "shm:", 4) == 0) {
+        return AP_HAL::OwnPtr<SerialDevice>(new SHMDevice(arg + 4));
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_QFLIGHT
     } else if (strncmp(arg, "qflight:", 8) == 0) {
         return AP_HAL::OwnPtr<SerialDevice>(new QFLIGHTDevice(device_path));
@@ -278,10 +318,32 @@ int16_t UARTDriver::read()
     if (!_readbuf.read_byte(&byte)) {
         return -1;
     }
+    _receive_times.consumed(1);
 
     return byte;
 }
 
+uint16_t UARTDriver::read(uint8_t *buffer, uint16_t count)
+{
+    if (!_initialised) {
+        return 0;
+    }
+
+    const uint32_t n = _readbuf.read(buffer, count);
+    _receive_times.consumed(n);
+
+    return n;
+}
+
+uint64_t UARTDriver::receive_time_us()
+{
+    if (!_initialised) {
+        return 0;
+    }
+
+    return _receive_times.next_byte_time_us();
+}
+
 /* Linux implementations of Print virtual methods */
 size_t UARTDriver::write(uint8_t c)
 {
@@ -321,6 +383,22 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
     return _writebuf.write(buffer, size);
 }
 
+/*
+  reserve space in the write buffer for a caller to fill in place
+ */
+uint8_t UARTDriver::tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (!_initialised || !_nonblocking_writes || _writebuf.space() < len) {
+        return 0;
+    }
+    return _writebuf.reserve(vec, len);
+}
+
+bool UARTDriver::tx_commit(uint32_t len)
+{
+    return _writebuf.commit(len);
+}
+
 /*
   try writing n bytes, handling an unresponsive port
  */
@@ -350,17 +428,34 @@ int UARTDriver::_read_fd(uint8_t *buf, uint16_t n)
 
 
 /*
-  try to push out one lump of pending bytes
-  return true if progress is made
+  try writing count packets, handling an unresponsive port
  */
-bool UARTDriver::_write_pending_bytes(void)
+int UARTDriver::_write_packets_fd(const SerialDevice::Packet *pkts, uint8_t count)
 {
-    // write any pending bytes
-    uint32_t available_bytes = _writebuf.available();
-    uint16_t n = available_bytes;
-    int16_t b = _writebuf.peek(0);
-    if (_packetise && n > 0 &&
-        b != MAVLINK_STX_MAVLINK1 && b != MAVLINK_STX) {
+    if (!_connected) {
+        _connected = _device->open();
+    }
+    if (!_connected) {
+        return 0;
+    }
+
+    return _device->write_packets(pkts, count);
+}
+
+/*
+  length of the next lump to send as one packet, starting ofs bytes
+  into the write buffer. Returns 0 if the next MAVLink packet is not
+  complete yet
+ */
+uint16_t UARTDriver::_packet_length(uint32_t ofs, uint32_t available_bytes)
+{
+    if (ofs >= available_bytes) {
+        return 0;
+    }
+
+    uint16_t n = MIN(available_bytes - ofs, (uint32_t)UINT16_MAX);
+    int16_t b = _writebuf.peek(ofs);
+    if (b != MAVLINK_STX_MAVLINK1 && b != MAVLINK_STX) {
         /*
           we have a non-mavlink packet at the start of the
           buffer. Look ahead for a MAVLink start byte, up to 256 bytes
@@ -369,74 +464,132 @@ bool UARTDriver::_write_pending_bytes(void)
         uint16_t limit = n>256?256:n;
         uint16_t i;
         for (i=0; i<limit; i++) {
-            b = _writebuf.peek(i);
+            b = _writebuf.peek(ofs+i);
             if (b == MAVLINK_STX_MAVLINK1 || b == MAVLINK_STX) {
-                n = i;
-                break;
+                return i;
             }
         }
         // if we didn't find a MAVLink marker then limit the send size to 256
-        if (i == limit) {
-            n = limit;
+        return limit;
+    }
+
+    uint8_t min_length = (b == MAVLINK_STX_MAVLINK1)?8:12;
+    // this looks like a MAVLink packet - try to write on
+    // packet boundaries when possible
+    if (n < min_length) {
+        // we need to wait for more data to arrive
+        return 0;
+    }
+    // the length of the packet is the 2nd byte, and mavlink
+    // packets have a 6 byte header plus 2 byte checksum,
+    // giving len+8 bytes
+    int16_t len = _writebuf.peek(ofs+1);
+    if (b == MAVLINK_STX) {
+        // check for signed packet with extra 13 bytes
+        int16_t incompat_flags = _writebuf.peek(ofs+2);
+        if (incompat_flags & MAVLINK_IFLAG_SIGNED) {
+            min_length += MAVLINK_SIGNATURE_BLOCK_LEN;
         }
     }
-    b = _writebuf.peek(0);
-    if (_packetise && n > 0 &&
-        (b == MAVLINK_STX_MAVLINK1 || b == MAVLINK_STX)) {
-        uint8_t min_length = (b == MAVLINK_STX_MAVLINK1)?8:12;
-        // this looks like a MAVLink packet - try to write on
-        // packet boundaries when possible
-        if (n < min_length) {
-            // we need to wait for more data to arrive
-            n = 0;
-        } else {
-            // the length of the packet is the 2nd byte, and mavlink
-            // packets have a 6 byte header plus 2 byte checksum,
-            // giving len+8 bytes
-            int16_t len = _writebuf.peek(1);
-            if (b == MAVLINK_STX) {
-                // check for signed packet with extra 13 bytes
-                int16_t incompat_flags = _writebuf.peek(2);
-                if (incompat_flags & MAVLINK_IFLAG_SIGNED) {
-                    min_length += MAVLINK_SIGNATURE_BLOCK_LEN;
-                }
-            }
-            if (n < len+min_length) {
-                // we don't have a full packet yet
-                n = 0;
-            } else if (n > len+min_length) {
-                // send just 1 packet at a time (so MAVLink packets
-                // are aligned on UDP boundaries)
-                n = len+min_length;
+    if (n < len+min_length) {
+        // we don't have a full packet yet
+        return 0;
+    }
+    // send just 1 packet at a time (so MAVLink packets
+    // are aligned on UDP boundaries)
+    return len+min_length;
+}
+
+/*
+  write up to LINUX_UART_MAX_PACKETS whole packets in one device call,
+  straight from the ring buffer
+ */
+void UARTDriver::_write_pending_packets(uint32_t available_bytes)
+{
+    uint16_t lens[LINUX_UART_MAX_PACKETS];
+    uint8_t count = 0;
+    uint32_t total = 0;
+
+    while (count < LINUX_UART_MAX_PACKETS) {
+        const uint16_t len = _packet_length(total, available_bytes);
+        if (len == 0) {
+            break;
+        }
+        lens[count++] = len;
+        total += len;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // split the (at most two) contiguous parts of the ring buffer
+    // into packets, a packet wrapping around taking one of each
+    ByteBuffer::IoVec vec[2];
+    SerialDevice::Packet pkts[LINUX_UART_MAX_PACKETS];
+    _writebuf.peekiovec(vec, total);
+    uint8_t v = 0;
+    uint32_t vofs = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t left = lens[i];
+        pkts[i].iovcnt = 0;
+        while (left > 0) {
+            const uint32_t chunk = MIN(left, vec[v].len - vofs);
+            struct iovec &iov = pkts[i].iov[pkts[i].iovcnt++];
+            iov.iov_base = vec[v].data + vofs;
+            iov.iov_len = chunk;
+            left -= chunk;
+            vofs += chunk;
+            if (vofs == vec[v].len) {
+                v++;
+                vofs = 0;
             }
         }
     }
 
-    if (n > 0) {
-        int ret;
+    const int sent = _write_packets_fd(pkts, count);
+    uint32_t sent_bytes = 0;
+    for (int i = 0; i < sent; i++) {
+        sent_bytes += lens[i];
+    }
+    if (sent_bytes > 0) {
+        _writebuf.advance(sent_bytes);
+    }
+}
 
-        if (_packetise) {
-            // keep as a single UDP packet
-            uint8_t tmpbuf[n];
-            _writebuf.peekbytes(tmpbuf, n);
-            ret = _write_fd(tmpbuf, n);
-            if (ret > 0)
-                _writebuf.advance(ret);
-        } else {
-            ByteBuffer::IoVec vec[2];
-            const auto n_vec = _writebuf.peekiovec(vec, n);
-            for (int i = 0; i < n_vec; i++) {
-                ret = _write_fd(vec[i].data, (uint16_t)vec[i].len);
-                if (ret < 0) {
-                    break;
-                }
-                _writebuf.advance(ret);
-
-                /* We wrote less than we asked for, stop */
-                if ((unsigned)ret != vec[i].len) {
-                    break;
-                }
-            }
+/*
+  try to push out one lump of pending bytes
+  return true if progress is made
+ */
+bool UARTDriver::_write_pending_bytes(void)
+{
+    // write any pending bytes
+    uint32_t available_bytes = _writebuf.available();
+
+    if (available_bytes == 0) {
+        return false;
+    }
+
+    if (_packetise) {
+        // keep MAVLink packets aligned on UDP boundaries, batching
+        // several to save system calls
+        _write_pending_packets(available_bytes);
+        return _writebuf.available() != available_bytes;
+    }
+
+    int ret;
+    uint16_t n = available_bytes;
+    ByteBuffer::IoVec vec[2];
+    const auto n_vec = _writebuf.peekiovec(vec, n);
+    for (int i = 0; i < n_vec; i++) {
+        ret = _write_fd(vec[i].data, (uint16_t)vec[i].len);
+        if (ret < 0) {
+            break;
+        }
+        _writebuf.advance(ret);
+
+        /* We wrote less than we asked for, stop */
+        if ((unsigned)ret != vec[i].len) {
+            break;
         }
     }
 
@@ -459,23 +612,70 @@ void UARTDriver::_timer_tick(void)
         num_send--;
     }
 
-    // try to fill the read buffer
+    // event driven ports are read on POLLIN, unless the last read
+    // stopped short because the read buffer was full
+    if (!_event_driven || _read_pending) {
+        _fill_readbuf();
+    }
+
+    _in_timer = false;
+}
+
+/*
+  try to fill the read buffer
+ */
+void UARTDriver::_fill_readbuf()
+{
     int ret;
     ByteBuffer::IoVec vec[2];
+    uint32_t total = 0;
+
+    /* the device may hold more unless a read comes short */
+    _read_pending = true;
 
     const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
     for (int i = 0; i < n_vec; i++) {
         ret = _read_fd(vec[i].data, vec[i].len);
         if (ret < 0) {
+            _read_pending = false;
             break;
         }
         _readbuf.commit((unsigned)ret);
+        total += ret;
 
         /* stop reading as we read less than we asked for */
         if ((unsigned)ret < vec[i].len) {
+            _read_pending = false;
             break;
         }
     }
 
+    if (total > 0) {
+        _receive_times.received(total, AP_HAL::micros64());
+    }
+}
+
+void UARTDriver::_on_can_read()
+{
+    if (!_initialised) {
+        // the event is edge triggered, leave the read to the next tick
+        _read_pending = true;
+        return;
+    }
+
+    _in_timer = true;
+    _fill_readbuf();
+    _in_timer = false;
+}
+
+void UARTDriver::_on_can_write()
+{
+    if (!_initialised) return;
+
+    _in_timer = true;
+    uint8_t num_send = 10;
+    while (num_send != 0 && _write_pending_bytes()) {
+        num_send--;
+    }
     _in_timer = false;
 }
@@ -1,11 +1,18 @@
 #pragma once
 
 #include <AP_HAL/utility/OwnPtr.h>
+#include <AP_HAL/utility/ReceiveTimes.h>
 #include <AP_HAL/utility/RingBuffer.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
 #include "SerialDevice.h"
 
+/* packets written per device call when writes are packetised */
+#define LINUX_UART_MAX_PACKETS 8
+/* device reads remembered to timestamp the bytes in the read buffer */
+#define LINUX_UART_RX_MARKS 16
+
 namespace Linux {
 
 class UARTDriver : public AP_HAL::UARTDriver {
@@ -29,10 +36,14 @@ public:
     uint32_t available() override;
     uint32_t txspace() override;
     int16_t read() override;
+    uint16_t read(uint8_t *buffer, uint16_t count) override;
+    uint64_t receive_time_us() override;
 
     /* Linux implementations of Print virtual methods */
     size_t write(uint8_t c);
     size_t write(const uint8_t *buffer, size_t size);
+    uint8_t tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len) override;
+    bool tx_commit(uint32_t len) override;
 
     void set_device_path(const char *path);
 
@@ -50,6 +61,20 @@ public:
    }
 
 private:
+    /* reads and flushes the port as soon as its file descriptor is ready */
+    class DevicePollable : public Pollable {
+    public:
+        DevicePollable(UARTDriver &uart) : _uart(uart) { }
+
+        void set_fd(int fd) { _fd = fd; }
+
+        void on_can_read() override { _uart._on_can_read(); }
+        void on_can_write() override { _uart._on_can_write(); }
+
+    protected:
+        UARTDriver &_uart;
+    };
+
     AP_HAL::OwnPtr<SerialDevice> _device;
     bool _nonblocking_writes;
     bool _console;
@@ -60,10 +85,21 @@ private:
     bool _connected; // true if a client has connected
     bool _packetise; // true if writes should try to be on mavlink boundaries
 
+    DevicePollable _pollable{*this};
+    bool _event_driven = false; // true if reads happen on POLLIN, not every tick
+    bool _read_pending = false; // true if the device may hold more unread data
+
     void _allocate_buffers(uint16_t rxS, uint16_t txS);
     void _deallocate_buffers();
 
     AP_HAL::OwnPtr<SerialDevice> _parseDevicePath(const char *arg);
+    int _write_packets_fd(const SerialDevice::Packet *pkts, uint8_t count);
+    uint16_t _packet_length(uint32_t ofs, uint32_t available_bytes);
+    void _write_pending_packets(uint32_t available_bytes);
+    void _register_pollable();
+    void _fill_readbuf();
+    void _on_can_read();
+    void _on_can_write();
     uint64_t _last_write_time;
 
 protected:
@@ -74,6 +110,7 @@ protected:
     // of ::read() and ::write() in the main loop
     ByteBuffer _readbuf{0};
     ByteBuffer _writebuf{0};
+    ReceiveTimes _receive_times{LINUX_UART_RX_MARKS};
 
     virtual int _write_fd(const uint8_t *buf, uint16_t n);
     virtual int _read_fd(uint8_t *buf, uint16_t n);
@@ -1,10 +1,13 @@
 #include "UDPDevice.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/ioctl.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
 
 UDPDevice::UDPDevice(const char *ip, uint16_t port, bool bcast, bool input):
     _ip(ip),
@@ -20,29 +23,152 @@ UDPDevice::~UDPDevice()
 
 ssize_t UDPDevice::write(const uint8_t *buf, uint16_t n)
 {
-    if (!socket.pollout(0)) {
+    Packet pkt;
+
+    pkt.iov[0].iov_base = (void *)buf;
+    pkt.iov[0].iov_len = n;
+    pkt.iovcnt = 1;
+
+    return write_packets(&pkt, 1) == 1 ? n : -1;
+}
+
+/*
+  send a batch of datagrams with a single sendmmsg(). Until a peer is
+  connected each datagram goes to every destination address
+ */
+int UDPDevice::write_packets(const Packet *pkts, uint8_t count)
+{
+    if (!_connected && (_input || _num_dests == 0)) {
+        // can't send yet
         return -1;
     }
-    if (_connected) {
-        return socket.send(buf, n);
+
+    const uint8_t num_dests = _connected ? 1 : _num_dests;
+    struct mmsghdr msgs[LINUX_UDP_TX_BATCH * LINUX_UDP_MAX_DESTS];
+    unsigned n_msgs = 0;
+
+    count = MIN(count, LINUX_UDP_TX_BATCH);
+    memset(msgs, 0, sizeof(msgs[0]) * count * num_dests);
+
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint8_t d = 0; d < num_dests; d++) {
+            struct msghdr &hdr = msgs[n_msgs++].msg_hdr;
+            hdr.msg_iov = (struct iovec *)pkts[i].iov;
+            hdr.msg_iovlen = pkts[i].iovcnt;
+            if (!_connected) {
+                hdr.msg_name = &_dest[d];
+                hdr.msg_namelen = sizeof(_dest[d]);
+            }
+        }
     }
-    if (_input) {
-        // can't send yet
+
+    int ret = sendmmsg(socket.get_read_fd(), msgs, n_msgs, MSG_DONTWAIT);
+    if (ret <= 0) {
         return -1;
     }
-    return socket.sendto(buf, n, _ip, _port);
+
+    /*
+      a datagram only partially fanned out counts as written: resending
+      it would duplicate it on the destinations that did get it
+     */
+    return (ret + num_dests - 1) / num_dests;
 }
 
+/*
+  receive up to LINUX_UDP_RX_BATCH datagrams with a single recvmmsg()
+ */
+void UDPDevice::_fill_rx_batch()
+{
+    struct mmsghdr msgs[LINUX_UDP_RX_BATCH];
+    struct iovec iov[LINUX_UDP_RX_BATCH];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (uint8_t i = 0; i < LINUX_UDP_RX_BATCH; i++) {
+        iov[i].iov_base = _rx_buf[i];
+        iov[i].iov_len = sizeof(_rx_buf[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &_rx_addr[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(_rx_addr[i]);
+    }
+
+    int ret = recvmmsg(socket.get_read_fd(), msgs, LINUX_UDP_RX_BATCH,
+                       MSG_DONTWAIT, nullptr);
+    _rx_next = 0;
+    _rx_ofs = 0;
+    if (ret <= 0) {
+        _rx_count = 0;
+        return;
+    }
+
+    _rx_count = ret;
+    for (uint8_t i = 0; i < _rx_count; i++) {
+        _rx_len[i] = msgs[i].msg_len;
+    }
+
+    if (!_connected && _num_dests <= 1) {
+        // reply to whoever talked to us first
+        _connected = socket.connect(inet_ntoa(_rx_addr[0].sin_addr),
+                                    ntohs(_rx_addr[0].sin_port));
+    }
+}
+
+/*
+  read from the received datagrams, as a byte stream. Only returns
+  less than n once the socket has been drained
+ */
 ssize_t UDPDevice::read(uint8_t *buf, uint16_t n)
 {
-    ssize_t ret = socket.recv(buf, n, 0);
-    if (!_connected && ret > 0) {
-        const char *ip;
-        uint16_t port;
-        socket.last_recv_address(ip, port);
-        _connected = socket.connect(ip, port);
+    ssize_t ret = 0;
+    while (n > 0) {
+        if (_rx_next >= _rx_count) {
+            _fill_rx_batch();
+            if (_rx_count == 0) {
+                break;
+            }
+        }
+        const uint16_t len = MIN(n, (uint16_t)(_rx_len[_rx_next] - _rx_ofs));
+        memcpy(buf + ret, &_rx_buf[_rx_next][_rx_ofs], len);
+        ret += len;
+        n -= len;
+        _rx_ofs += len;
+        if (_rx_ofs >= _rx_len[_rx_next]) {
+            _rx_next++;
+            _rx_ofs = 0;
+        }
+    }
+    return ret > 0 ? ret : -1;
+}
+
+/*
+  parse the comma separated destination addresses of a "udp:" output
+ */
+bool UDPDevice::_parse_dests()
+{
+    char ips[128];
+    char *saveptr = nullptr;
+
+    strncpy(ips, _ip, sizeof(ips) - 1);
+    ips[sizeof(ips) - 1] = '\0';
+
+    _num_dests = 0;
+    for (char *ip = strtok_r(ips, ",", &saveptr); ip != nullptr;
+         ip = strtok_r(nullptr, ",", &saveptr)) {
+        if (_num_dests >= LINUX_UDP_MAX_DESTS) {
+            fprintf(stderr, "UDP: only %u destinations supported\n", LINUX_UDP_MAX_DESTS);
+            break;
+        }
+        struct sockaddr_in &dest = _dest[_num_dests];
+        memset(&dest, 0, sizeof(dest));
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons(_port);
+        if (inet_aton(ip, &dest.sin_addr) == 0) {
+            fprintf(stderr, "UDP: invalid address %s\n", ip);
+            return false;
+        }
+        _num_dests++;
     }
-    return ret;
+    return _num_dests > 0;
 }
 
 bool UDPDevice::open()
@@ -51,11 +177,18 @@ bool UDPDevice::open()
         socket.bind(_ip, _port);
         return true;
     }
+    if (!_parse_dests()) {
+        return false;
+    }
     if (_bcast) {
         // open now, then connect on first received packet
         socket.set_broadcast();
         return true;
     }
+    if (_num_dests > 1) {
+        // fan out to every destination, never connect
+        return true;
+    }
     _connected = socket.connect(_ip, _port);
     return _connected;
 }
@@ -3,6 +3,14 @@
 #include "SerialDevice.h"
 #include <AP_HAL/utility/Socket.h>
 
+/* maximum number of addresses a "udp:" output can fan out to */
+#define LINUX_UDP_MAX_DESTS     4
+/* datagrams received per recvmmsg() call */
+#define LINUX_UDP_RX_BATCH      8
+#define LINUX_UDP_RX_SIZE       1500
+/* datagrams sent per sendmmsg() call, before fanning out */
+#define LINUX_UDP_TX_BATCH      8
+
 class UDPDevice: public SerialDevice {
 public:
     UDPDevice(const char *ip, uint16_t port, bool bcast, bool input);
@@ -14,11 +22,28 @@ public:
     virtual void set_speed(uint32_t speed) override;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+    virtual int write_packets(const Packet *pkts, uint8_t count) override;
+    virtual int get_fd() const override { return socket.get_read_fd(); }
 private:
+    bool _parse_dests();
+    void _fill_rx_batch();
+
     SocketAPM socket{true};
     const char *_ip;
     uint16_t _port;
     bool _bcast;
     bool _input;
     bool _connected = false;
+
+    /* "udp:" outputs may list several comma separated addresses */
+    struct sockaddr_in _dest[LINUX_UDP_MAX_DESTS];
+    uint8_t _num_dests = 0;
+
+    /* datagrams received but not read yet */
+    uint8_t _rx_buf[LINUX_UDP_RX_BATCH][LINUX_UDP_RX_SIZE];
+    uint16_t _rx_len[LINUX_UDP_RX_BATCH];
+    struct sockaddr_in _rx_addr[LINUX_UDP_RX_BATCH];
+    uint8_t _rx_count = 0;
+    uint8_t _rx_next = 0;
+    uint16_t _rx_ofs = 0;
 };
@@ -10,6 +10,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "Heat_Pwm.h"
+#include "Thread.h"
 #include "ToneAlarm_Raspilot.h"
 #include "Util.h"
 
@@ -123,6 +124,32 @@ uint32_t Util::available_memory(void)
     return 256*1024;
 }
 
+/*
+  the statistics are refreshed by the scheduler, so this only copies
+  them out. Slots of destroyed threads are skipped
+ */
+bool Util::thread_get_info(uint8_t idx, thread_info &info)
+{
+    for (uint8_t i = 0; i < Thread::get_count(); i++) {
+        Thread *thread = Thread::get_thread(i);
+        if (thread == nullptr) {
+            continue;
+        }
+        if (idx-- > 0) {
+            continue;
+        }
+        const Thread::stats &stats = thread->get_stats();
+        info.name = thread->get_name();
+        info.stack_used = stats.stack_used;
+        info.stack_size = stats.stack_size;
+        info.cpu_ms = stats.cpu_usec / 1000;
+        info.voluntary_switches = stats.voluntary_switches;
+        info.involuntary_switches = stats.involuntary_switches;
+        return true;
+    }
+    return false;
+}
+
 int Util::write_file(const char *path, const char *fmt, ...)
 {
     errno = 0;
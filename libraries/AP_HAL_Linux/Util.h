@@ -91,6 +91,18 @@ public:
         return Perf::get_instance()->count(perf);
     }
 
+    bool perf_get_info(uint16_t idx, perf_counter_info &info) override
+    {
+        return Perf::get_instance()->get_info(idx, info);
+    }
+
+    bool thread_get_info(uint8_t idx, thread_info &info) override;
+
+    bool perf_reset(const char *name) override
+    {
+        return Perf::get_instance()->reset(name);
+    }
+
     // create a new semaphore
     AP_HAL::Semaphore *new_semaphore(void) override { return new Semaphore; }
 
@@ -39,6 +39,18 @@
 #include <time.h>
 #include <unistd.h>
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VIDEOIN_NEON 1
+#define VIDEOIN_SIMD 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VIDEOIN_SSE2 1
+#define VIDEOIN_SIMD 1
+#else
+#define VIDEOIN_SIMD 0
+#endif
+
 extern const AP_HAL::HAL& hal;
 
 using namespace Linux;
@@ -251,74 +263,185 @@ void VideoIn::prepare_capture()
     }
 }
 
-void VideoIn::shrink_8bpp(uint8_t *buffer, uint8_t *new_buffer,
-                          uint32_t width, uint32_t height, uint32_t left,
-                          uint32_t selection_width, uint32_t top,
-                          uint32_t selection_height, uint32_t fx, uint32_t fy)
+/*
+  add pixel_stride spaced bytes of row to the column sums, the inner
+  loop of every shrink
+ */
+static void accumulate_row(uint16_t *sums, const uint8_t *row, uint32_t n,
+                           uint32_t pixel_stride)
+{
+    uint32_t x = 0;
+
+#if VIDEOIN_NEON
+    if (pixel_stride == 1) {
+        for (; x + 16 <= n; x += 16) {
+            const uint8x16_t v = vld1q_u8(row + x);
+            vst1q_u16(sums + x, vaddw_u8(vld1q_u16(sums + x), vget_low_u8(v)));
+            vst1q_u16(sums + x + 8, vaddw_u8(vld1q_u16(sums + x + 8), vget_high_u8(v)));
+        }
+    } else if (pixel_stride == 2) {
+        for (; x + 16 <= n; x += 16) {
+            const uint8x16_t v = vld2q_u8(row + 2 * x).val[0];
+            vst1q_u16(sums + x, vaddw_u8(vld1q_u16(sums + x), vget_low_u8(v)));
+            vst1q_u16(sums + x + 8, vaddw_u8(vld1q_u16(sums + x + 8), vget_high_u8(v)));
+        }
+    }
+#elif VIDEOIN_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low_bytes = _mm_set1_epi16(0x00ff);
+    if (pixel_stride == 1) {
+        for (; x + 16 <= n; x += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i *)(row + x));
+            __m128i *s = (__m128i *)(sums + x);
+            _mm_storeu_si128(s, _mm_add_epi16(_mm_loadu_si128(s), _mm_unpacklo_epi8(v, zero)));
+            _mm_storeu_si128(s + 1, _mm_add_epi16(_mm_loadu_si128(s + 1), _mm_unpackhi_epi8(v, zero)));
+        }
+    } else if (pixel_stride == 2) {
+        /* YUYV: the Y bytes are the low halves of each 16 bit word */
+        for (; x + 16 <= n; x += 16) {
+            const __m128i a = _mm_loadu_si128((const __m128i *)(row + 2 * x));
+            const __m128i b = _mm_loadu_si128((const __m128i *)(row + 2 * x + 16));
+            __m128i *s = (__m128i *)(sums + x);
+            _mm_storeu_si128(s, _mm_add_epi16(_mm_loadu_si128(s), _mm_and_si128(a, low_bytes)));
+            _mm_storeu_si128(s + 1, _mm_add_epi16(_mm_loadu_si128(s + 1), _mm_and_si128(b, low_bytes)));
+        }
+    }
+#endif
+
+    /* constant strides so the compiler can vectorize the remainder */
+    if (pixel_stride == 1) {
+        for (; x < n; x++) {
+            sums[x] += row[x];
+        }
+    } else {
+        for (; x < n; x++) {
+            sums[x] += row[2 * x];
+        }
+    }
+}
+
+/*
+  average fx by fy blocks of the selection into new_buffer. With vector
+  instructions rows are first summed per column, then fx columns are
+  summed per output pixel
+ */
+static void shrink(const uint8_t *buffer, uint32_t pixel_stride,
+                   uint32_t line_stride, uint8_t *new_buffer,
+                   uint32_t left, uint32_t selection_width, uint32_t top,
+                   uint32_t selection_height, uint32_t fx, uint32_t fy)
 {
-    uint32_t i, j, k, kk, px, block_x, block_y, block_position;
-    uint32_t out_width = selection_width / fx;
-    uint32_t out_height = selection_height / fy;
-    uint32_t width_per_fy = width * fy;
-    uint32_t fx_fy = fx * fy;
-    uint32_t width_sum, out_width_sum = 0;
-
-    /* selection offset */
-    block_y = top * width;
-    block_position = left + block_y;
-
-    for (i = 0; i < out_height; i++) {
-        block_x = left;
-        for (j = 0; j < out_width; j++) {
-            px = 0;
-
-            width_sum = 0;
-            for(k = 0; k < fy; k++) {
-                for(kk = 0; kk < fx; kk++) {
-                    px += buffer[block_position + kk + width_sum];
+    const uint32_t out_width = selection_width / fx;
+    const uint32_t out_height = selection_height / fy;
+    const uint32_t used_width = out_width * fx;
+    const uint32_t fx_fy = fx * fy;
+
+    if (!VIDEOIN_SIMD || fx_fy > UINT16_MAX / UINT8_MAX) {
+        /* sum each block directly, also when column sums could overflow */
+        for (uint32_t i = 0; i < out_height; i++) {
+            for (uint32_t j = 0; j < out_width; j++) {
+                uint32_t px = 0;
+                for (uint32_t k = 0; k < fy; k++) {
+                    const uint8_t *row = buffer + (top + i * fy + k) * line_stride +
+                        (left + j * fx) * pixel_stride;
+                    for (uint32_t kk = 0; kk < fx; kk++) {
+                        px += row[kk * pixel_stride];
+                    }
                 }
-                width_sum += width;
+                new_buffer[i * out_width + j] = px / fx_fy;
             }
+        }
+        return;
+    }
+
+    uint16_t sums[used_width];
 
-            new_buffer[j + out_width_sum] = px / (fx_fy);
+    for (uint32_t i = 0; i < out_height; i++) {
+        memset(sums, 0, sizeof(sums));
+        for (uint32_t k = 0; k < fy; k++) {
+            const uint8_t *row = buffer + (top + i * fy + k) * line_stride +
+                left * pixel_stride;
+            accumulate_row(sums, row, used_width, pixel_stride);
+        }
 
-            block_x += fx;
-            block_position = block_x + block_y;
+        uint8_t *out = new_buffer + i * out_width;
+        for (uint32_t j = 0; j < out_width; j++) {
+            uint32_t px = 0;
+            for (uint32_t kk = 0; kk < fx; kk++) {
+                px += sums[j * fx + kk];
+            }
+            out[j] = px / fx_fy;
         }
-        block_y += width_per_fy;
-        out_width_sum += out_width;
     }
 }
 
+void VideoIn::shrink_8bpp(uint8_t *buffer, uint8_t *new_buffer,
+                          uint32_t width, uint32_t height, uint32_t left,
+                          uint32_t selection_width, uint32_t top,
+                          uint32_t selection_height, uint32_t fx, uint32_t fy)
+{
+    shrink(buffer, 1, width, new_buffer, left, selection_width, top,
+           selection_height, fx, fy);
+}
+
 void VideoIn::crop_8bpp(uint8_t *buffer, uint8_t *new_buffer,
                         uint32_t width, uint32_t left, uint32_t crop_width,
                         uint32_t top, uint32_t crop_height)
 {
-    uint32_t crop_x = left + crop_width;
-    uint32_t crop_y = top + crop_height;
-    uint32_t buffer_index = top * width;
-    uint32_t new_buffer_index = 0;
-
-    for (uint32_t j = top; j < crop_y; j++) {
-        for (uint32_t i = left; i < crop_x; i++) {
-            new_buffer[i - left + new_buffer_index] =  buffer[i + buffer_index];
-        }
-        buffer_index += width;
-        new_buffer_index += crop_width;
+    const uint8_t *row = buffer + top * width + left;
+
+    for (uint32_t j = 0; j < crop_height; j++) {
+        memcpy(new_buffer, row, crop_width);
+        row += width;
+        new_buffer += crop_width;
     }
 }
 
 void VideoIn::yuyv_to_grey(uint8_t *buffer, uint32_t buffer_size,
                            uint8_t *new_buffer)
 {
-    uint32_t new_buffer_position = 0;
+    const uint32_t n = (buffer_size + 1) / 2;
+    uint32_t i = 0;
+
+#if VIDEOIN_NEON
+    for (; i + 16 <= n; i += 16) {
+        vst1q_u8(new_buffer + i, vld2q_u8(buffer + 2 * i).val[0]);
+    }
+#elif VIDEOIN_SSE2
+    const __m128i low_bytes = _mm_set1_epi16(0x00ff);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(buffer + 2 * i));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(buffer + 2 * i + 16));
+        _mm_storeu_si128((__m128i *)(new_buffer + i),
+                         _mm_packus_epi16(_mm_and_si128(a, low_bytes),
+                                          _mm_and_si128(b, low_bytes)));
+    }
+#endif
 
-    for (uint32_t i = 0; i < buffer_size; i += 2) {
-        new_buffer[new_buffer_position] = buffer[i];
-        new_buffer_position++;
+    for (; i < n; i++) {
+        new_buffer[i] = buffer[2 * i];
     }
 }
 
+void VideoIn::yuyv_to_grey_8bpp(uint8_t *buffer, uint8_t *new_buffer,
+                                uint32_t width, uint32_t left,
+                                uint32_t selection_width, uint32_t top,
+                                uint32_t selection_height,
+                                uint32_t fx, uint32_t fy)
+{
+    if (fx == 1 && fy == 1) {
+        const uint8_t *row = buffer + (top * width + left) * 2;
+        for (uint32_t j = 0; j < selection_height; j++) {
+            yuyv_to_grey((uint8_t *)row, selection_width * 2, new_buffer);
+            row += width * 2;
+            new_buffer += selection_width;
+        }
+        return;
+    }
+
+    shrink(buffer, 2, width * 2, new_buffer, left, selection_width, top,
+           selection_height, fx, fy);
+}
+
 uint32_t VideoIn::_timeval_to_us(struct timeval& tv)
 {
     return (1.0e6 * tv.tv_sec + tv.tv_usec);
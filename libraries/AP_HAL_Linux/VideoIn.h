@@ -66,6 +66,14 @@ public:
     static void yuyv_to_grey(uint8_t *buffer, uint32_t buffer_size,
                              uint8_t *new_buffer);
 
+    /* convert a selection of a YUYV image to 8bpp grey and shrink it by
+     * fx, fy (1 for a plain crop), reading each source pixel once */
+    static void yuyv_to_grey_8bpp(uint8_t *buffer, uint8_t *new_buffer,
+                                  uint32_t width, uint32_t left,
+                                  uint32_t selection_width, uint32_t top,
+                                  uint32_t selection_height,
+                                  uint32_t fx, uint32_t fy);
+
 private:
     void _queue_buffer(int index);
     bool _set_streaming(bool enable);
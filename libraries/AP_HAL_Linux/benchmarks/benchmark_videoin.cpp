@@ -62,6 +62,112 @@ static void BM_YuyvToGrey(benchmark::State& state)
 }
 
 BENCHMARK(BM_YuyvToGrey)->Arg(64 * 64)->Arg(320 * 240)->Arg(640 * 480);
+
+static void BM_Shrink8bpp(benchmark::State& state)
+{
+    uint8_t *buffer, *new_buffer;
+    uint32_t width = 320;
+    uint32_t height = 240;
+    uint32_t scale = state.range_x();
+    uint32_t selection = height / scale * scale;
+    uint32_t left = (width - selection) / 2;
+
+    buffer = (uint8_t *)malloc(width * height);
+    if (!buffer) {
+        fprintf(stderr, "error: couldn't malloc buffer\n");
+        return;
+    }
+
+    new_buffer = (uint8_t *)malloc(selection / scale * selection / scale);
+    if (!new_buffer) {
+        fprintf(stderr, "error: couldn't malloc new_buffer\n");
+        return;
+    }
+
+    while (state.KeepRunning()) {
+        Linux::VideoIn::shrink_8bpp(buffer, new_buffer, width, height,
+            left, selection, 0, selection, scale, scale);
+    }
+
+    free(buffer);
+    free(new_buffer);
+}
+
+BENCHMARK(BM_Shrink8bpp)->Arg(2)->Arg(3)->Arg(4);
+
+/* YUYV to grey then shrink, as two passes over the frame */
+static void BM_YuyvToGreyShrink(benchmark::State& state)
+{
+    uint8_t *buffer, *grey_buffer, *new_buffer;
+    uint32_t width = 320;
+    uint32_t height = 240;
+    uint32_t scale = state.range_x();
+    uint32_t selection = height / scale * scale;
+    uint32_t left = (width - selection) / 2;
+
+    buffer = (uint8_t *)malloc(width * height * 2);
+    if (!buffer) {
+        fprintf(stderr, "error: couldn't malloc buffer\n");
+        return;
+    }
+
+    grey_buffer = (uint8_t *)malloc(width * height);
+    if (!grey_buffer) {
+        fprintf(stderr, "error: couldn't malloc grey_buffer\n");
+        return;
+    }
+
+    new_buffer = (uint8_t *)malloc(selection / scale * selection / scale);
+    if (!new_buffer) {
+        fprintf(stderr, "error: couldn't malloc new_buffer\n");
+        return;
+    }
+
+    while (state.KeepRunning()) {
+        Linux::VideoIn::yuyv_to_grey(buffer, width * height * 2, grey_buffer);
+        Linux::VideoIn::shrink_8bpp(grey_buffer, new_buffer, width, height,
+            left, selection, 0, selection, scale, scale);
+    }
+
+    free(buffer);
+    free(grey_buffer);
+    free(new_buffer);
+}
+
+BENCHMARK(BM_YuyvToGreyShrink)->Arg(1)->Arg(3);
+
+/* the same in a single pass */
+static void BM_YuyvToGrey8bpp(benchmark::State& state)
+{
+    uint8_t *buffer, *new_buffer;
+    uint32_t width = 320;
+    uint32_t height = 240;
+    uint32_t scale = state.range_x();
+    uint32_t selection = height / scale * scale;
+    uint32_t left = (width - selection) / 2;
+
+    buffer = (uint8_t *)malloc(width * height * 2);
+    if (!buffer) {
+        fprintf(stderr, "error: couldn't malloc buffer\n");
+        return;
+    }
+
+    new_buffer = (uint8_t *)malloc(selection / scale * selection / scale);
+    if (!new_buffer) {
+        fprintf(stderr, "error: couldn't malloc new_buffer\n");
+        return;
+    }
+
+    while (state.KeepRunning()) {
+        Linux::VideoIn::yuyv_to_grey_8bpp(buffer, new_buffer, width,
+            left, selection, 0, selection, scale, scale);
+    }
+
+    free(buffer);
+    free(new_buffer);
+}
+
+BENCHMARK(BM_YuyvToGrey8bpp)->Arg(1)->Arg(3);
 #endif
 
 BENCHMARK_MAIN()
@@ -54,6 +54,28 @@ static ObjectBuffer<DSPBuffer::IMU::BUF> imu_buffer(30);
 static ObjectBuffer<DSPBuffer::MAG::BUF> mag_buffer(10);
 static ObjectBuffer<DSPBuffer::BARO::BUF> baro_buffer(10);
 static bool mpu9250_started;
+
+/*
+  raw IMU samples are integrated here at the sample rate and handed to
+  the ARM side every imu_decimation samples
+ */
+static const float IMU_RAW_DT = 0.001;
+static const uint32_t IMU_MAX_DECIMATION = 10;
+static uint32_t imu_decimation = 1;
+static struct {
+    uint32_t count;
+    uint64_t last_timestamp;
+    float accel_sum[3];
+    float gyro_sum[3];
+    float last_gyro[3];
+    float last_delta_angle[3];
+    float last_delta_velocity[3];
+    float delta_time;
+    float delta_angle[3];
+    float delta_velocity[3];
+    float delta_velocity_alpha[3];
+    float delta_velocity_scul[3];
+} imu_accum;
 static uint32_t bmp280_handle;
 static uint32_t baro_counter;
 
@@ -119,6 +141,88 @@ static int init_mpu9250(void)
     return ret;
 }
 
+// ret = a x b
+static void cross3(const float a[3], const float b[3], float ret[3])
+{
+    ret[0] = a[1]*b[2] - a[2]*b[1];
+    ret[1] = a[2]*b[0] - a[0]*b[2];
+    ret[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+/*
+  integrate one raw IMU sample, with the same coning and sculling
+  corrections AP_InertialSensor_Backend applies on the ARM side, and
+  push a sample every imu_decimation raw samples
+ */
+static void imu_accumulate(uint64_t timestamp, const float accel[3], const float gyro[3])
+{
+    float dt = IMU_RAW_DT;
+    if (imu_accum.last_timestamp != 0 && timestamp > imu_accum.last_timestamp &&
+        timestamp - imu_accum.last_timestamp < 10000) {
+        dt = (timestamp - imu_accum.last_timestamp) * 1.0e-6f;
+    }
+    imu_accum.last_timestamp = timestamp;
+
+    float delta_angle[3], delta_velocity[3], accel_delta_angle[3];
+    float t[3], c[3], c2[3];
+    for (uint8_t i=0; i<3; i++) {
+        delta_angle[i] = (gyro[i] + imu_accum.last_gyro[i]) * 0.5f * dt;
+        delta_velocity[i] = accel[i] * dt;
+        accel_delta_angle[i] = gyro[i] * dt;
+    }
+
+    // coning correction
+    for (uint8_t i=0; i<3; i++) {
+        t[i] = imu_accum.delta_angle[i] + imu_accum.last_delta_angle[i] * (1.0f / 6.0f);
+    }
+    cross3(t, delta_angle, c);
+
+    // sculling correction
+    float v[3];
+    for (uint8_t i=0; i<3; i++) {
+        t[i] = imu_accum.delta_velocity_alpha[i] + accel_delta_angle[i] * (1.0f / 6.0f);
+        v[i] = imu_accum.delta_velocity[i] + imu_accum.last_delta_velocity[i] * (1.0f / 6.0f);
+    }
+    cross3(t, delta_velocity, c2);
+    cross3(v, accel_delta_angle, t);
+
+    for (uint8_t i=0; i<3; i++) {
+        imu_accum.delta_angle[i] += delta_angle[i] + c[i] * 0.5f;
+        imu_accum.delta_velocity_scul[i] += (c2[i] + t[i]) * 0.5f;
+        imu_accum.delta_velocity[i] += delta_velocity[i];
+        imu_accum.delta_velocity_alpha[i] += accel_delta_angle[i];
+        imu_accum.last_delta_angle[i] = delta_angle[i];
+        imu_accum.last_delta_velocity[i] = delta_velocity[i];
+        imu_accum.last_gyro[i] = gyro[i];
+        imu_accum.accel_sum[i] += accel[i];
+        imu_accum.gyro_sum[i] += gyro[i];
+    }
+    imu_accum.delta_time += dt;
+
+    if (++imu_accum.count < imu_decimation) {
+        return;
+    }
+
+    DSPBuffer::IMU::BUF b;
+    b.timestamp = timestamp;
+    b.delta_time = imu_accum.delta_time;
+    for (uint8_t i=0; i<3; i++) {
+        b.accel[i] = imu_accum.accel_sum[i] / imu_accum.count;
+        b.gyro[i]  = imu_accum.gyro_sum[i] / imu_accum.count;
+        b.delta_angle[i] = imu_accum.delta_angle[i];
+        b.delta_velocity[i] = imu_accum.delta_velocity[i] + imu_accum.delta_velocity_scul[i];
+        imu_accum.accel_sum[i] = 0;
+        imu_accum.gyro_sum[i] = 0;
+        imu_accum.delta_angle[i] = 0;
+        imu_accum.delta_velocity[i] = 0;
+        imu_accum.delta_velocity_alpha[i] = 0;
+        imu_accum.delta_velocity_scul[i] = 0;
+    }
+    imu_accum.delta_time = 0;
+    imu_accum.count = 0;
+    imu_buffer.push(b);
+}
+
 /*
   thread gathering sensor data from mpu9250
  */
@@ -131,15 +235,12 @@ static void *mpu_data_ready(void *ctx)
     if (ret != 0) {
         return NULL;
     }
-    DSPBuffer::IMU::BUF b;
-    b.timestamp = data.timestamp;
-    b.accel[0]  = data.accel_raw[0]*ACCEL_SCALE_1G;
-    b.accel[1]  = data.accel_raw[1]*ACCEL_SCALE_1G;
-    b.accel[2]  = data.accel_raw[2]*ACCEL_SCALE_1G;
-    b.gyro[0]   = data.gyro_raw[0]*GYRO_SCALE;
-    b.gyro[1]   = data.gyro_raw[1]*GYRO_SCALE;
-    b.gyro[2]   = data.gyro_raw[2]*GYRO_SCALE;
-    imu_buffer.push(b);
+    float accel[3], gyro[3];
+    for (uint8_t i=0; i<3; i++) {
+        accel[i] = data.accel_raw[i]*ACCEL_SCALE_1G;
+        gyro[i]  = data.gyro_raw[i]*GYRO_SCALE;
+    }
+    imu_accumulate(data.timestamp, accel, gyro);
 
     if (data.mag_data_ready) {
         DSPBuffer::MAG::BUF m;
@@ -176,6 +277,18 @@ static void mpu9250_startup(void)
     }
 }
 
+/*
+  set the number of raw IMU samples integrated into each sample
+ */
+int qflight_set_imu_decimation(uint32_t decimation)
+{
+    if (decimation < 1 || decimation > IMU_MAX_DECIMATION) {
+        return 1;
+    }
+    imu_decimation = decimation;
+    return 0;
+}
+
 /*
   get any available IMU data
  */
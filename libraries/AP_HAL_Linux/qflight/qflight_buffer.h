@@ -4,7 +4,9 @@
   shared memory structures for sensor data and peripheral control on Qualcomm flight board
  */
 struct DSPBuffer {
-    // IMU data
+    // IMU data. Each sample is the mean of the raw samples since the
+    // last one, with the delta angle and velocity integrated over them
+    // at the raw rate, all in sensor frame
     struct IMU {
         static const uint32_t max_samples = 10;
         uint32_t num_samples;
@@ -12,6 +14,9 @@ struct DSPBuffer {
             uint64_t timestamp;
             float accel[3];
             float gyro[3];
+            float delta_time;
+            float delta_angle[3];
+            float delta_velocity[3];
         } buf[max_samples];
     } imu;
 
@@ -66,9 +66,18 @@ uint8_t PX4RCInput::read(uint16_t* periods, uint8_t len)
 	if (len > RC_INPUT_MAX_CHANNELS) {
 		len = RC_INPUT_MAX_CHANNELS;
 	}
+	// take the lock once for the whole frame, rather than per channel
+	pthread_mutex_lock(&rcin_mutex);
 	for (uint8_t i = 0; i < len; i++){
-		periods[i] = read(i);
+		if (_override[i]) {
+			periods[i] = _override[i];
+		} else if (i < _rcin.channel_count) {
+			periods[i] = _rcin.values[i];
+		} else {
+			periods[i] = 0;
+		}
 	}
+	pthread_mutex_unlock(&rcin_mutex);
 	return len;
 }
 
@@ -194,7 +194,9 @@ void PX4Storage::_storage_open(void)
  */
 void PX4Storage::_mark_dirty(uint16_t loc, uint16_t length)
 {
-    uint16_t end = loc + length;
+    // end is the last byte written, so a write which finishes on a
+    // line boundary doesn't dirty the following line
+    uint16_t end = loc + length - 1;
     for (uint8_t line=loc>>PX4_STORAGE_LINE_SHIFT;
          line <= end>>PX4_STORAGE_LINE_SHIFT;
          line++) {
@@ -76,11 +76,16 @@ void PX4UARTDriver::begin(uint32_t b, uint16_t rxS, uint16_t txS)
         }
 
         _readbuf.set_size(rxS);
+        _receive_times.reset();
     }
 
     if (b != 0) {
         _baudrate = b;
     }
+    if (_baudrate != 0 && strcmp(_devpath, "/dev/ttyACM0") != 0) {
+        // start, 8 data and stop bits
+        _receive_times.set_byte_time_ns(10000000000ULL / _baudrate);
+    }
 
     /*
       allocate the write buffer
@@ -251,10 +256,36 @@ int16_t PX4UARTDriver::read()
     if (!_readbuf.read_byte(&byte)) {
         return -1;
     }
+    _receive_times.consumed(1);
 
     return byte;
 }
 
+uint16_t PX4UARTDriver::read(uint8_t *buffer, uint16_t count)
+{
+    if (_uart_owner_pid != getpid()){
+        return 0;
+    }
+    if (!_initialised) {
+        try_initialise();
+        return 0;
+    }
+
+    const uint32_t n = _readbuf.read(buffer, count);
+    _receive_times.consumed(n);
+
+    return n;
+}
+
+uint64_t PX4UARTDriver::receive_time_us()
+{
+    if (_uart_owner_pid != getpid() || !_initialised) {
+        return 0;
+    }
+
+    return _receive_times.next_byte_time_us();
+}
+
 /* 
    write one byte to the buffer
  */
@@ -460,6 +491,7 @@ void PX4UARTDriver::_timer_tick(void)
 
     // try to fill the read buffer
     ByteBuffer::IoVec vec[2];
+    uint32_t nread = 0;
 
     perf_begin(_perf_uart);
     const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
@@ -469,12 +501,16 @@ void PX4UARTDriver::_timer_tick(void)
             break;
         }
         _readbuf.commit((unsigned)ret);
+        nread += ret;
 
         /* stop reading as we read less than we asked for */
         if ((unsigned)ret < vec[i].len) {
             break;
         }
     }
+    if (nread > 0) {
+        _receive_times.received(nread, AP_HAL::micros64());
+    }
     perf_end(_perf_uart);
 
     _in_timer = false;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <AP_HAL/utility/ReceiveTimes.h>
 #include <AP_HAL/utility/RingBuffer.h>
 
 #include "AP_HAL_PX4.h"
@@ -21,6 +22,8 @@ public:
     uint32_t available() override;
     uint32_t txspace() override;
     int16_t read() override;
+    uint16_t read(uint8_t *buffer, uint16_t count) override;
+    uint64_t receive_time_us() override;
 
     /* PX4 implementations of Print virtual methods */
     size_t write(uint8_t c);
@@ -52,6 +55,8 @@ private:
     // of ::read() and ::write() in the main loop
     ByteBuffer _readbuf{0};
     ByteBuffer _writebuf{0};
+    // one mark per timer tick that read something
+    ReceiveTimes _receive_times{16};
     perf_counter_t  _perf_uart;
 
     int _write_fd(const uint8_t *buf, uint16_t n);
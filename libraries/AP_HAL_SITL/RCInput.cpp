@@ -37,8 +37,9 @@ uint8_t RCInput::read(uint16_t* periods, uint8_t len)
     if (len > SITL_RC_INPUT_CHANNELS) {
         len = SITL_RC_INPUT_CHANNELS;
     }
+    // copy the whole frame here rather than a virtual read() per channel
     for (uint8_t i=0; i<len; i++) {
-        periods[i] = read(i);
+        periods[i] = _override[i] ? _override[i] : _sitlState->pwm_input[i];
     }
     return 8;
 }
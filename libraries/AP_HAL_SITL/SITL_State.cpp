@@ -17,6 +17,7 @@
 
 #include <AP_Param/AP_Param.h>
 #include <SITL/SIM_JSBSim.h>
+#include <SITL/SIM_Noise.h>
 #include <AP_HAL/utility/Socket.h>
 
 extern const AP_HAL::HAL& hal;
@@ -101,8 +102,8 @@ void SITL_State::_sitl_setup(const char *home_str)
     }
 
     if (_synthetic_clock_mode) {
-        // start with non-zero clock
-        hal.scheduler->stop_clock(1);
+        // start with non-zero clock, or where a snapshot left it
+        hal.scheduler->stop_clock(_snapshot_hold ? _snapshot_state.time_now_us : 1);
     }
 }
 
@@ -129,12 +130,23 @@ void SITL_State::_setup_fdm(void)
 void SITL_State::_fdm_input_step(void)
 {
     static uint32_t last_pwm_input = 0;
+    static uint32_t last_parent_check;
 
     _fdm_input_local();
 
-    /* make sure we die if our parent dies */
-    if (kill(_parent_pid, 0) != 0) {
-        exit(1);
+    if (_snapshot_requested) {
+        _snapshot_requested = 0;
+        _snapshot_save(_snapshot_path);
+    }
+
+    /* make sure we die if our parent dies. In lockstep mode steps
+       can take a few microseconds, so don't make a system call on
+       every one of them */
+    if (!_lockstep || _update_count - last_parent_check >= 1000) {
+        last_parent_check = _update_count;
+        if (kill(_parent_pid, 0) != 0) {
+            exit(1);
+        }
     }
 
     if (_scheduler->interrupts_are_blocked() || _sitl == NULL) {
@@ -267,8 +279,15 @@ void SITL_State::_fdm_input_local(void)
 {
     SITL::Aircraft::sitl_input input;
 
-    // check for direct RC input
-    _fdm_input();
+    // check for direct RC input. RC input is only simulated at 50Hz,
+    // so in lockstep mode there is no point polling the socket more
+    // often than that
+    static uint64_t last_rc_poll_us;
+    const uint64_t now_us = AP_HAL::micros64();
+    if (!_lockstep || now_us - last_rc_poll_us >= 20000) {
+        last_rc_poll_us = now_us;
+        _fdm_input();
+    }
 
     // construct servos structure for FDM
     _simulator_servos(input);
@@ -276,6 +295,10 @@ void SITL_State::_fdm_input_local(void)
     // update the model
     sitl_model->update(input);
 
+    if (_snapshot_hold) {
+        _snapshot_update();
+    }
+
     // get FDM output from the model
     if (_sitl) {
         sitl_model->fill_fdm(_sitl->state);
@@ -295,7 +318,8 @@ void SITL_State::_fdm_input_local(void)
         adsb->update();
     }
 
-    if (_sitl) {
+    if (_sitl && !_lockstep) {
+        // a visualiser is of no use running faster than realtime
         _output_to_flightgear();
     }
 
@@ -433,7 +457,7 @@ void SITL_State::_simulator_servos(SITL::Aircraft::sitl_input &input)
 // generate a random float between -1 and 1
 float SITL_State::_rand_float(void)
 {
-    return ((((unsigned)random()) % 2000000) - 1.0e6) / 1.0e6;
+    return SITL::Noise::rand_float();
 }
 
 // generate a random Vector3f of size 1
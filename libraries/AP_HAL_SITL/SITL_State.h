@@ -14,6 +14,7 @@
 #include <netinet/in.h>
 #include <netinet/udp.h>
 #include <arpa/inet.h>
+#include <signal.h>
 
 #include <AP_Baro/AP_Baro.h>
 #include <AP_InertialSensor/AP_InertialSensor.h>
@@ -142,6 +143,12 @@ private:
 
     void wait_clock(uint64_t wait_time_usec);
 
+    // snapshots of the simulator state, see SITL_snapshot.cpp
+    bool _snapshot_save(const char *path);
+    bool _snapshot_restore(const char *path);
+    void _snapshot_update(void);
+    static void _sig_snapshot(int signum);
+
     // internal state
     enum vehicle_type _vehicle;
     uint16_t _framerate;
@@ -168,6 +175,9 @@ private:
 
     bool _synthetic_clock_mode;
 
+    // run the simulation as fast as possible, see --lockstep
+    bool _lockstep;
+
     bool _use_rtscts;
     
     const char *_fdm_address;
@@ -229,6 +239,17 @@ private:
     const char *defaults_path = HAL_PARAM_DEFAULTS_PATH;
 
     const char *_home_str;
+
+    // file a snapshot is written to on SIGUSR1
+    const char *_snapshot_path = "snapshot.bin";
+
+    // set by SIGUSR1 to ask for a snapshot
+    static volatile sig_atomic_t _snapshot_requested;
+
+    // aircraft state restored from a snapshot, held until the vehicle
+    // arms
+    SITL::Aircraft::snapshot _snapshot_state;
+    bool _snapshot_hold;
 };
 
 #endif // CONFIG_HAL_BOARD == HAL_BOARD_SITL
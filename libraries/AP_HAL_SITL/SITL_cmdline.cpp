@@ -26,6 +26,7 @@
 #include <SITL/SIM_FlightAxis.h>
 #include <SITL/SIM_Calibration.h>
 #include <SITL/SIM_XPlane.h>
+#include <SITL/SIM_Plugin.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -50,6 +51,7 @@ void SITL_State::_usage(void)
            "\t--console          use console instead of TCP ports\n"
            "\t--instance N       set instance of SITL (adds 10*instance to all port numbers)\n"
            "\t--speedup SPEEDUP  set simulation speedup\n"
+           "\t--lockstep         run as fast as possible, with no wall clock pacing\n"
            "\t--gimbal           enable simulated MAVLink gimbal\n"
            "\t--autotest-dir DIR set directory for additional files\n"
            "\t--uartA device     set device string for UARTA\n"
@@ -58,6 +60,8 @@ void SITL_State::_usage(void)
            "\t--uartD device     set device string for UARTD\n"
            "\t--uartE device     set device string for UARTE\n"
            "\t--defaults path    set path to defaults file\n"
+           "\t--snapshot path    set file written on SIGUSR1 (default snapshot.bin)\n"
+           "\t--restore path     start from a snapshot file\n"
         );
 }
 
@@ -86,6 +90,8 @@ static const struct {
     { "jsbsim",             JSBSim::create },
     { "flightaxis",         FlightAxis::create },
     { "gazebo",             Gazebo::create },
+    { "plugin",             Plugin::create },
+    { "shm",                Plugin::create },
     { "last_letter",        last_letter::create },
     { "tracker",            Tracker::create },
     { "balloon",            Balloon::create },
@@ -106,6 +112,12 @@ void SITL_State::_set_signal_handlers(void) const
     sigemptyset(&sa_pipe.sa_mask);
     sa_pipe.sa_handler = SIG_IGN; /* No-op SIGPIPE handler */
     sigaction(SIGPIPE, &sa_pipe, nullptr);
+
+    struct sigaction sa_snapshot = {};
+
+    sigemptyset(&sa_snapshot.sa_mask);
+    sa_snapshot.sa_handler = _sig_snapshot;
+    sigaction(SIGUSR1, &sa_snapshot, nullptr);
 }
 
 void SITL_State::_parse_command_line(int argc, char * const argv[])
@@ -114,6 +126,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     // default to CMAC
     const char *home_str = "-35.363261,149.165230,584,353";
     const char *model_str = NULL;
+    const char *restore_path = NULL;
     char *autotest_dir = NULL;
     float speedup = 1.0f;
 
@@ -127,6 +140,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     setvbuf(stderr, (char *)0, _IONBF, 0);
 
     _synthetic_clock_mode = false;
+    _lockstep = false;
     _base_port = 5760;
     _rcout_port = 5502;
     _simin_port = 5501;
@@ -145,7 +159,10 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_UARTE,
         CMDLINE_UARTF,
         CMDLINE_RTSCTS,
-        CMDLINE_DEFAULTS
+        CMDLINE_DEFAULTS,
+        CMDLINE_LOCKSTEP,
+        CMDLINE_SNAPSHOT,
+        CMDLINE_RESTORE
     };
 
     const struct GetOptLong::option options[] = {
@@ -170,6 +187,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"autotest-dir",    true,   0, CMDLINE_AUTOTESTDIR},
         {"defaults",        true,   0, CMDLINE_DEFAULTS},
         {"rtscts",          false,  0, CMDLINE_RTSCTS},
+        {"lockstep",        false,  0, CMDLINE_LOCKSTEP},
+        {"snapshot",        true,   0, CMDLINE_SNAPSHOT},
+        {"restore",         true,   0, CMDLINE_RESTORE},
         {0, false, 0, 0}
     };
 
@@ -225,6 +245,16 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_RTSCTS:
             _use_rtscts = true;
             break;
+        case CMDLINE_LOCKSTEP:
+            _lockstep = true;
+            break;
+        case CMDLINE_SNAPSHOT:
+            _snapshot_path = gopt.optarg;
+            break;
+        case CMDLINE_RESTORE:
+            restore_path = gopt.optarg;
+            _synthetic_clock_mode = true;
+            break;
         case CMDLINE_AUTOTESTDIR:
             autotest_dir = strdup(gopt.optarg);
             break;
@@ -256,6 +286,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         if (strncasecmp(model_constructors[i].name, model_str, strlen(model_constructors[i].name)) == 0) {
             sitl_model = model_constructors[i].constructor(home_str, model_str);
             sitl_model->set_speedup(speedup);
+            if (_lockstep) {
+                sitl_model->set_time_sync(false);
+            }
             sitl_model->set_instance(_instance);
             sitl_model->set_autotest_dir(autotest_dir);
             _synthetic_clock_mode = true;
@@ -268,6 +301,11 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         exit(1);
     }
 
+    if (restore_path != nullptr && !_snapshot_restore(restore_path)) {
+        printf("Failed to restore snapshot %s\n", restore_path);
+        exit(1);
+    }
+
     fprintf(stdout, "Starting sketch '%s'\n", SKETCH);
 
     if (strcmp(SKETCH, "ArduCopter") == 0) {
@@ -0,0 +1,164 @@
+/*
+  SITL handling
+
+  This saves and restores snapshots of the simulator: the aircraft
+  kinematic state, the simulation clock and the parameter storage.
+
+  The state of the vehicle code itself (EKF, flight mode, arming) is
+  not saved; a restored vehicle boots with the saved parameters and
+  clock, while the aircraft is held where the snapshot left it until
+  the vehicle arms.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "AP_HAL_SITL.h"
+#include "AP_HAL_SITL_Namespace.h"
+#include "HAL_SITL_Class.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+using namespace HALSITL;
+
+#define SNAPSHOT_MAGIC   0x534E4150
+#define SNAPSHOT_VERSION 1
+
+struct snapshot_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t storage_size;
+    char sketch[16];
+};
+
+volatile sig_atomic_t SITL_State::_snapshot_requested;
+
+void SITL_State::_sig_snapshot(int signum)
+{
+    _snapshot_requested = 1;
+}
+
+// read or write all of a buffer, returning false on error or end of file
+static bool snapshot_io(int fd, void *buf, size_t len, bool writing)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        ssize_t n = writing ? write(fd, p, len) : read(fd, p, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/*
+  write a snapshot. It goes to a temporary file first so a reader
+  never sees a partly written one
+ */
+bool SITL_State::_snapshot_save(const char *path)
+{
+    struct snapshot_header hdr {};
+    hdr.magic = SNAPSHOT_MAGIC;
+    hdr.version = SNAPSHOT_VERSION;
+    hdr.storage_size = HAL_STORAGE_SIZE;
+    strncpy(hdr.sketch, SKETCH, sizeof(hdr.sketch)-1);
+
+    SITL::Aircraft::snapshot state;
+    sitl_model->get_snapshot(state);
+
+    uint8_t *storage = new uint8_t[HAL_STORAGE_SIZE];
+    if (storage == nullptr) {
+        return false;
+    }
+    hal.storage->read_block(storage, 0, HAL_STORAGE_SIZE);
+
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd = open(tmp_path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    bool ok = fd != -1 &&
+        snapshot_io(fd, &hdr, sizeof(hdr), true) &&
+        snapshot_io(fd, &state, sizeof(state), true) &&
+        snapshot_io(fd, storage, HAL_STORAGE_SIZE, true);
+    if (fd != -1) {
+        ok = (close(fd) == 0) && ok;
+    }
+    delete[] storage;
+    if (ok) {
+        ok = rename(tmp_path, path) == 0;
+    }
+
+    if (ok) {
+        printf("Saved snapshot %s at %.3f\n", path, state.time_now_us * 1.0e-6f);
+    } else {
+        fprintf(stderr, "SITL: snapshot %s failed - %s\n", path, strerror(errno));
+        unlink(tmp_path);
+    }
+    return ok;
+}
+
+/*
+  load a snapshot before the vehicle starts. The saved storage replaces
+  the current parameters, so it must run before the vehicle loads them
+ */
+bool SITL_State::_snapshot_restore(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct snapshot_header hdr;
+    if (!snapshot_io(fd, &hdr, sizeof(hdr), false) ||
+        hdr.magic != SNAPSHOT_MAGIC ||
+        hdr.version != SNAPSHOT_VERSION ||
+        hdr.storage_size != HAL_STORAGE_SIZE ||
+        strncmp(hdr.sketch, SKETCH, sizeof(hdr.sketch)-1) != 0) {
+        fprintf(stderr, "SITL: %s is not a %s snapshot\n", path, SKETCH);
+        close(fd);
+        return false;
+    }
+
+    uint8_t *storage = new uint8_t[HAL_STORAGE_SIZE];
+    if (storage == nullptr) {
+        close(fd);
+        return false;
+    }
+    bool ok = snapshot_io(fd, &_snapshot_state, sizeof(_snapshot_state), false) &&
+        snapshot_io(fd, storage, HAL_STORAGE_SIZE, false);
+    close(fd);
+    if (ok) {
+        hal.storage->write_block(0, storage, HAL_STORAGE_SIZE);
+        sitl_model->set_snapshot(_snapshot_state, true);
+        _snapshot_hold = true;
+        printf("Restored snapshot %s at %.3f\n", path, _snapshot_state.time_now_us * 1.0e-6f);
+    }
+    delete[] storage;
+    return ok;
+}
+
+/*
+  called after each model step while holding a restored aircraft. The
+  clock keeps running so the vehicle can initialise and its estimator
+  converge, with the aircraft pinned at the saved state until arming
+ */
+void SITL_State::_snapshot_update(void)
+{
+    if (hal.util->get_soft_armed()) {
+        _snapshot_hold = false;
+        return;
+    }
+    sitl_model->set_snapshot(_snapshot_state, false);
+}
+
+#endif
@@ -87,6 +87,10 @@ void UARTDriver::begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace)
             ::printf("UART connection %s:%u\n", args1, baudrate);
             _uart_path = strdup(args1);
             _uart_baudrate = baudrate;
+            if (baudrate != 0) {
+                // start, 8 data and stop bits
+                _receive_times.set_byte_time_ns(10000000000ULL / baudrate);
+            }
             _uart_start_connection();
         } else {
             AP_HAL::panic("Invalid device path: %s", path);
@@ -128,9 +132,25 @@ int16_t UARTDriver::read(void)
     }
     uint8_t c;
     _readbuffer.read(&c, 1);
+    _receive_times.consumed(1);
     return c;
 }
 
+uint16_t UARTDriver::read(uint8_t *buffer, uint16_t count)
+{
+    if (available() <= 0) {
+        return 0;
+    }
+    const uint32_t n = _readbuffer.read(buffer, count);
+    _receive_times.consumed(n);
+    return n;
+}
+
+uint64_t UARTDriver::receive_time_us()
+{
+    return _receive_times.next_byte_time_us();
+}
+
 void UARTDriver::flush(void)
 {
 }
@@ -156,6 +176,19 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
     return size;
 }
 
+uint8_t UARTDriver::tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (txspace() < len) {
+        return 0;
+    }
+    return _writebuffer.reserve(vec, len);
+}
+
+bool UARTDriver::tx_commit(uint32_t len)
+{
+    return _writebuffer.commit(len);
+}
+
     
 /*
   start a TCP connection for the serial port. If wait_for_connection
@@ -459,7 +492,8 @@ void UARTDriver::_timer_tick(void)
         }
     }
     if (nread > 0) {
-        _readbuffer.write((uint8_t *)buf, nread);
+        const uint32_t written = _readbuffer.write((uint8_t *)buf, nread);
+        _receive_times.received(written, AP_HAL::micros64());
     }
 }
 
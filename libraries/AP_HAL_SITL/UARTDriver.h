@@ -7,6 +7,7 @@
 #include <stdarg.h>
 #include "AP_HAL_SITL_Namespace.h"
 #include <AP_HAL/utility/Socket.h>
+#include <AP_HAL/utility/ReceiveTimes.h>
 #include <AP_HAL/utility/RingBuffer.h>
 
 class HALSITL::UARTDriver : public AP_HAL::UARTDriver {
@@ -49,10 +50,14 @@ public:
     uint32_t available() override;
     uint32_t txspace() override;
     int16_t read() override;
+    uint16_t read(uint8_t *buffer, uint16_t count) override;
+    uint64_t receive_time_us() override;
 
     /* Implementations of Print virtual methods */
     size_t write(uint8_t c);
     size_t write(const uint8_t *buffer, size_t size);
+    uint8_t tx_reserve(ByteBuffer::IoVec vec[2], uint32_t len) override;
+    bool tx_commit(uint32_t len) override;
 
     // file descriptor, exposed so SITL_State::loop_hook() can use it
     int _fd;
@@ -71,6 +76,7 @@ private:
     bool _nonblocking_writes;
     ByteBuffer _readbuffer{16384};
     ByteBuffer _writebuffer{16384};
+    ReceiveTimes _receive_times{16};
 
     const char *_uart_path;
     uint32_t _uart_baudrate;
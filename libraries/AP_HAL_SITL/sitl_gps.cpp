@@ -103,24 +103,33 @@ int SITL_State::gps2_pipe(void)
  */
 void SITL_State::_gps_write(const uint8_t *p, uint16_t size)
 {
-    while (size--) {
+    // write each run of bytes surviving the simulated byte loss with
+    // one system call, rather than one per byte
+    while (size > 0) {
+        uint16_t run = size;
         if (_sitl->gps_byteloss > 0.0f) {
-            float r = ((((unsigned)random()) % 1000000)) / 1.0e4;
-            if (r < _sitl->gps_byteloss) {
-                // lose the byte
-                p++;
-                continue;
+            run = 0;
+            while (run < size && (_rand_float() + 1.0f) * 50.0f >= _sitl->gps_byteloss) {
+                run++;
             }
         }
-        if (gps_state.gps_fd != 0) {
-            write(gps_state.gps_fd, p, 1);
-        }
-        if (_sitl->gps2_enable) {
-            if (gps2_state.gps_fd != 0) {
-                write(gps2_state.gps_fd, p, 1);
+        if (run > 0) {
+            if (gps_state.gps_fd != 0) {
+                write(gps_state.gps_fd, p, run);
+            }
+            if (_sitl->gps2_enable) {
+                if (gps2_state.gps_fd != 0) {
+                    write(gps2_state.gps_fd, p, run);
+                }
             }
+            p += run;
+            size -= run;
+        }
+        if (size > 0) {
+            // lose the byte
+            p++;
+            size--;
         }
-        p++;
     }
 }
 
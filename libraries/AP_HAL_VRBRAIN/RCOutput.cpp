@@ -586,6 +586,10 @@ void VRBRAINRCOutput::set_output_mode(enum output_mode mode)
         // no change
         return;
     }
+    if (mode != MODE_PWM_NORMAL && mode != MODE_PWM_ONESHOT) {
+        // the fmu and io drivers can't generate DShot
+        return;
+    }
     if (mode == MODE_PWM_ONESHOT) {
         // when using oneshot we don't want the regular pulses. The
         // best we can do with the current PX4Firmware code is ask for
@@ -33,6 +33,7 @@ public:
     void push();
 
     void set_output_mode(enum output_mode mode) override;
+    enum output_mode get_output_mode(void) override { return _output_mode; }
     
     void _timer_tick(void);
     bool enable_sbus_out(uint16_t rate_hz) override;
@@ -194,7 +194,9 @@ void VRBRAINStorage::_storage_open(void)
  */
 void VRBRAINStorage::_mark_dirty(uint16_t loc, uint16_t length)
 {
-    uint16_t end = loc + length;
+    // end is the last byte written, so a write which finishes on a
+    // line boundary doesn't dirty the following line
+    uint16_t end = loc + length - 1;
     for (uint8_t line=loc>>VRBRAIN_STORAGE_LINE_SHIFT;
          line <= end>>VRBRAIN_STORAGE_LINE_SHIFT;
          line++) {
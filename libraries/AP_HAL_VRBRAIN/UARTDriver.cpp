@@ -255,6 +255,19 @@ int16_t VRBRAINUARTDriver::read()
     return byte;
 }
 
+uint16_t VRBRAINUARTDriver::read(uint8_t *buffer, uint16_t count)
+{
+    if (_uart_owner_pid != getpid()){
+        return 0;
+    }
+    if (!_initialised) {
+        try_initialise();
+        return 0;
+    }
+
+    return _readbuf.read(buffer, count);
+}
+
 /* 
    write one byte to the buffer
  */
@@ -21,6 +21,7 @@ public:
     uint32_t available() override;
     uint32_t txspace() override;
     int16_t read() override;
+    uint16_t read(uint8_t *buffer, uint16_t count) override;
 
     /* VRBRAIN implementations of Print virtual methods */
     size_t write(uint8_t c);
@@ -14,26 +14,29 @@
 */
 void AP_InertialNav_NavEKF::update(float dt)
 {
+    // use the navigation values the AHRS worked out for this update
+    const AP_AHRS::nav_context &nav = _ahrs_ekf.get_nav_context();
+
     // get the NE position relative to the local earth frame origin
-    Vector2f posNE;
-    if (_ahrs_ekf.get_relative_position_NE(posNE)) {
-        _relpos_cm.x = posNE.x * 100; // convert from m to cm
-        _relpos_cm.y = posNE.y * 100; // convert from m to cm
+    if (nav.have_relative_position_ne) {
+        _relpos_cm.x = nav.relative_position_ne.x * 100; // convert from m to cm
+        _relpos_cm.y = nav.relative_position_ne.y * 100; // convert from m to cm
     }
 
     // get the D position relative to the local earth frame origin
-    float posD;
-    if (_ahrs_ekf.get_relative_position_D(posD)) {
-        _relpos_cm.z = - posD * 100; // convert from m in NED to cm in NEU
+    if (nav.have_relative_position_d) {
+        _relpos_cm.z = - nav.relative_position_d * 100; // convert from m in NED to cm in NEU
     }
 
     // get the absolute WGS-84 position
-    _haveabspos = _ahrs_ekf.get_position(_abspos);
+    _haveabspos = nav.have_location;
+    if (_haveabspos) {
+        _abspos = nav.location;
+    }
 
     // get the velocity relative to the local earth frame
-    Vector3f velNED;
-    if (_ahrs_ekf.get_velocity_NED(velNED)) {
-        _velocity_cm = velNED * 100; // convert to cm/s
+    if (nav.have_velocity_ned) {
+        _velocity_cm = nav.velocity_ned * 100; // convert to cm/s
         _velocity_cm.z = -_velocity_cm.z; // convert from NED to NEU
     }
 
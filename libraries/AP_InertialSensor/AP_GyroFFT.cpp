@@ -0,0 +1,216 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_GyroFFT.h"
+
+#if HAL_INS_FFT_ENABLED
+
+#include <stdlib.h>
+#include <string.h>
+
+extern const AP_HAL::HAL& hal;
+
+// weight of each new spectrum in the smoothed spectrum
+#define INS_FFT_SPECTRUM_ALPHA  0.2f
+
+// lowest bin searched for peaks, skipping DC and slow body motion
+#define INS_FFT_FIRST_BIN       2
+
+AP_GyroFFT::AP_GyroFFT() :
+    _initialised(false),
+    _decimation(1),
+    _decimation_count(0),
+    _bin_width_hz(0),
+    _fill_count(0),
+    _frame_ready(false),
+    _re(nullptr),
+    _im(nullptr),
+    _window(nullptr),
+    _spectrum(nullptr)
+{
+    for (uint8_t i=0; i<3; i++) {
+        _fill[i] = nullptr;
+        _frame[i] = nullptr;
+    }
+    for (uint8_t i=0; i<INS_FFT_MAX_PEAKS; i++) {
+        _peak_freq_hz[i] = 0;
+        _peak_energy[i] = 0;
+    }
+}
+
+bool AP_GyroFFT::init(uint16_t sample_rate_hz)
+{
+    if (_initialised || sample_rate_hz == 0) {
+        return _initialised;
+    }
+    if (!_fft.init(INS_FFT_WINDOW)) {
+        return false;
+    }
+
+    // all buffers come from one allocation, never freed
+    const uint16_t nfloats = INS_FFT_WINDOW * 3 * 2 + INS_FFT_WINDOW * 3 + INS_FFT_WINDOW / 2;
+    float *buf = (float *)calloc(nfloats, sizeof(float));
+    if (buf == nullptr) {
+        return false;
+    }
+    for (uint8_t i=0; i<3; i++) {
+        _fill[i] = buf;
+        buf += INS_FFT_WINDOW;
+        _frame[i] = buf;
+        buf += INS_FFT_WINDOW;
+    }
+    _re = buf;
+    buf += INS_FFT_WINDOW;
+    _im = buf;
+    buf += INS_FFT_WINDOW;
+    _window = buf;
+    buf += INS_FFT_WINDOW;
+    _spectrum = buf;
+
+    // Hann window
+    for (uint16_t i=0; i<INS_FFT_WINDOW; i++) {
+        _window[i] = 0.5f - 0.5f * cosf(2 * M_PI * i / (INS_FFT_WINDOW - 1));
+    }
+
+    _decimation = constrain_int16(sample_rate_hz / INS_FFT_TARGET_RATE_HZ, 1, 255);
+    _bin_width_hz = (float)sample_rate_hz / _decimation / INS_FFT_WINDOW;
+
+    _initialised = true;
+    hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_GyroFFT::update, void));
+    return true;
+}
+
+/*
+  collect a raw sample. Averaging before decimating keeps noise above
+  the analysed band from aliasing into it
+ */
+void AP_GyroFFT::sample(const Vector3f &gyro)
+{
+    if (!_initialised) {
+        return;
+    }
+    _decimation_sum += gyro;
+    if (++_decimation_count < _decimation) {
+        return;
+    }
+    const Vector3f avg = _decimation_sum / _decimation_count;
+    _decimation_sum.zero();
+    _decimation_count = 0;
+
+    _fill[0][_fill_count] = avg.x;
+    _fill[1][_fill_count] = avg.y;
+    _fill[2][_fill_count] = avg.z;
+    if (++_fill_count < INS_FFT_WINDOW) {
+        return;
+    }
+    _fill_count = 0;
+
+    // if the IO thread is still busy with the last frame this one is
+    // dropped; the spectrum is smoothed so losing frames only slows it
+    if (!_frame_ready) {
+        for (uint8_t i=0; i<3; i++) {
+            memcpy(_frame[i], _fill[i], INS_FFT_WINDOW * sizeof(float));
+        }
+        _frame_ready = true;
+    }
+}
+
+/*
+  transform each axis of a completed frame and fold the summed power
+  into the smoothed spectrum
+ */
+void AP_GyroFFT::update(void)
+{
+    if (!_frame_ready) {
+        return;
+    }
+
+    // scale so a sine of amplitude A shows as power A^2 in its bin,
+    // allowing for the 0.5 coherent gain of the Hann window
+    const float scale = sq(4.0f / INS_FFT_WINDOW);
+
+    for (uint8_t axis=0; axis<3; axis++) {
+        const float *frame = _frame[axis];
+        float mean = 0;
+        for (uint16_t i=0; i<INS_FFT_WINDOW; i++) {
+            mean += frame[i];
+        }
+        mean /= INS_FFT_WINDOW;
+        for (uint16_t i=0; i<INS_FFT_WINDOW; i++) {
+            _re[i] = (frame[i] - mean) * _window[i];
+            _im[i] = 0;
+        }
+        if (axis == 2) {
+            // frame has been copied out, the sensor thread can refill it
+            _frame_ready = false;
+        }
+        _fft.transform(_re, _im);
+        for (uint16_t k=0; k<INS_FFT_WINDOW/2; k++) {
+            const float power = (sq(_re[k]) + sq(_im[k])) * scale;
+            if (axis == 0) {
+                _spectrum[k] -= INS_FFT_SPECTRUM_ALPHA * _spectrum[k];
+            }
+            _spectrum[k] += INS_FFT_SPECTRUM_ALPHA * power;
+        }
+    }
+
+    find_peaks();
+}
+
+/*
+  pick the strongest local maxima of the smoothed spectrum, refining
+  each with a parabola through the neighbouring bins
+ */
+void AP_GyroFFT::find_peaks(void)
+{
+    uint16_t bins[INS_FFT_MAX_PEAKS] {};
+    float energy[INS_FFT_MAX_PEAKS] {};
+
+    for (uint16_t k=INS_FFT_FIRST_BIN; k<INS_FFT_WINDOW/2-1; k++) {
+        const float p = _spectrum[k];
+        if (p <= _spectrum[k-1] || p < _spectrum[k+1] || p <= energy[INS_FFT_MAX_PEAKS-1]) {
+            continue;
+        }
+        // insert into the sorted list of peaks
+        uint8_t i = INS_FFT_MAX_PEAKS-1;
+        while (i > 0 && energy[i-1] < p) {
+            energy[i] = energy[i-1];
+            bins[i] = bins[i-1];
+            i--;
+        }
+        energy[i] = p;
+        bins[i] = k;
+    }
+
+    for (uint8_t i=0; i<INS_FFT_MAX_PEAKS; i++) {
+        if (bins[i] == 0) {
+            _peak_freq_hz[i] = 0;
+            _peak_energy[i] = 0;
+            continue;
+        }
+        const uint16_t k = bins[i];
+        const float left = _spectrum[k-1];
+        const float right = _spectrum[k+1];
+        const float denom = left - 2 * energy[i] + right;
+        float delta = 0;
+        if (!is_zero(denom)) {
+            delta = constrain_float(0.5f * (left - right) / denom, -0.5f, 0.5f);
+        }
+        _peak_freq_hz[i] = (k + delta) * _bin_width_hz;
+        _peak_energy[i] = energy[i];
+    }
+}
+
+#endif // HAL_INS_FFT_ENABLED
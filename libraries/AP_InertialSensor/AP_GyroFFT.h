@@ -0,0 +1,98 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  onboard vibration spectrum analyser. Raw gyro samples are collected
+  into frames in the sensor thread and transformed in the IO thread,
+  so the flight loop only pays for copying samples
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_FFT.h>
+
+#ifndef HAL_INS_FFT_ENABLED
+#define HAL_INS_FFT_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+#if HAL_INS_FFT_ENABLED
+
+// number of samples in each transform
+#define INS_FFT_WINDOW          128
+// raw samples are averaged down to roughly this rate before the transform
+#define INS_FFT_TARGET_RATE_HZ  1000
+// number of spectrum peaks tracked
+#define INS_FFT_MAX_PEAKS       3
+
+class AP_GyroFFT {
+public:
+    AP_GyroFFT();
+
+    // allocate buffers and start the analyser for raw samples at
+    // sample_rate_hz. Returns false if memory is short
+    bool init(uint16_t sample_rate_hz);
+
+    bool enabled(void) const { return _initialised; }
+
+    // add a raw gyro sample, called at the raw sample rate
+    void sample(const Vector3f &gyro);
+
+    // frequency in Hz and smoothed power of the peak with the given
+    // rank, 0 being the strongest. The frequency is zero if there is
+    // no such peak
+    float get_peak_freq_hz(uint8_t rank) const { return rank < INS_FFT_MAX_PEAKS ? _peak_freq_hz[rank] : 0; }
+    float get_peak_energy(uint8_t rank) const { return rank < INS_FFT_MAX_PEAKS ? _peak_energy[rank] : 0; }
+
+    // frequency resolution of the spectrum
+    float get_bin_width_hz(void) const { return _bin_width_hz; }
+
+private:
+    // IO thread callback, transforms a frame when one is ready
+    void update(void);
+    void find_peaks(void);
+
+    bool _initialised;
+    AP_FFT _fft;
+
+    // number of raw samples averaged into each analysed sample
+    uint8_t _decimation;
+    uint8_t _decimation_count;
+    Vector3f _decimation_sum;
+    float _bin_width_hz;
+
+    // samples being collected, one row of INS_FFT_WINDOW per axis
+    float *_fill[3];
+    uint16_t _fill_count;
+
+    // completed frame handed to the IO thread. The sensor thread
+    // only writes it while _frame_ready is false and the IO thread
+    // only reads it while it is true
+    float *_frame[3];
+    volatile bool _frame_ready;
+
+    // transform workspace and window, only used in the IO thread
+    float *_re;
+    float *_im;
+    float *_window;
+
+    // smoothed power spectrum, INS_FFT_WINDOW/2 bins
+    float *_spectrum;
+
+    float _peak_freq_hz[INS_FFT_MAX_PEAKS];
+    float _peak_energy[INS_FFT_MAX_PEAKS];
+};
+
+#endif // HAL_INS_FFT_ENABLED
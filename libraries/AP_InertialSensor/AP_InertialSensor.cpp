@@ -1,5 +1,6 @@
 #include <assert.h>
 
+#include <AP_Common/AP_Alloc.h>
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_HAL/I2CDevice.h>
@@ -50,6 +51,14 @@ extern const AP_HAL::HAL& hal;
 
 #define GYRO_INIT_MAX_DIFF_DPS 0.1f
 
+// gyro calibration groups samples into batches at this rate
+#define GYRO_INIT_BATCH_HZ      50
+// batches needed before convergence is tested
+#define GYRO_INIT_MIN_BATCHES   10
+#define GYRO_INIT_TIMEOUT_MS    30000
+// accel change over a quarter second that restarts gyro calibration
+#define GYRO_INIT_ACCEL_MOVE    0.2f
+
 // Class level parameters
 const AP_Param::GroupInfo AP_InertialSensor::var_info[] = {
     // @Param: PRODUCT_ID
@@ -318,6 +327,23 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] = {
     // @User: Advanced
     // @Values: 1:IMU 1,2:IMU 2,3:IMU 3
     AP_GROUPINFO("ACC_BODYFIX", 26, AP_InertialSensor, _acc_body_aligned, 2),
+
+    // @Group: NOTCH_
+    // @Path: ../Filter/NotchFilter.cpp
+    AP_SUBGROUPINFO(_gyro_notch, "NOTCH_", 27, AP_InertialSensor, NotchFilterParams),
+
+    // @Group: HNTCH_
+    // @Path: ../Filter/HarmonicNotchFilter.cpp
+    AP_SUBGROUPINFO(_harmonic_notch_filter, "HNTCH_", 28, AP_InertialSensor, HarmonicNotchFilterParams),
+
+#if HAL_INS_FFT_ENABLED
+    // @Param: FFT_ENABLE
+    // @DisplayName: Gyro FFT analyser enable
+    // @Description: Enable the onboard vibration spectrum analyser on the first gyro. The strongest peaks are logged in the FTN message. Takes effect after a reboot
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("FFT_ENABLE", 29, AP_InertialSensor, _fft_enable, 0),
+#endif
     /*
       NOTE: parameter indexes have gaps above. When adding new
       parameters check for conflicts carefully
@@ -351,6 +377,8 @@ AP_InertialSensor::AP_InertialSensor() :
     }
     _s_instance = this;
     AP_Param::setup_object_defaults(this, var_info);
+    _gyro_rotation.identity();
+    _rotation_orientation = ROTATION_NONE;
     for (uint8_t i=0; i<INS_MAX_BACKENDS; i++) {
         _backends[i] = NULL;
     }
@@ -367,6 +395,10 @@ AP_InertialSensor::AP_InertialSensor() :
 
         _delta_velocity_acc[i].zero();
         _delta_velocity_acc_dt[i] = 0;
+        _delta_velocity_scul[i].zero();
+        _delta_velocity_alpha[i].zero();
+        _last_delta_velocity[i].zero();
+        _last_accel_delta_angle[i].zero();
 
         _delta_angle_acc[i].zero();
         _delta_angle_acc_dt[i] = 0;
@@ -460,6 +492,23 @@ AP_InertialSensor_Backend *AP_InertialSensor::_find_backend(int16_t backend_id,
     return nullptr;
 }
 
+/*
+  change the main loop rate after init(). The sample schedule restarts
+  from now at the new period
+ */
+void AP_InertialSensor::set_loop_rate(uint16_t sample_rate)
+{
+    if (sample_rate == 0 || sample_rate == _sample_rate) {
+        return;
+    }
+    _sample_rate = sample_rate;
+    _loop_delta_t = 1.0f / sample_rate;
+    _sample_period_usec = 1000*1000UL / _sample_rate;
+    if (_next_sample_usec != 0) {
+        _next_sample_usec = AP_HAL::micros() + _sample_period_usec;
+    }
+}
+
 void
 AP_InertialSensor::init(uint16_t sample_rate)
 {
@@ -478,19 +527,27 @@ AP_InertialSensor::init(uint16_t sample_rate)
             _accel_scale[i].set(Vector3f(1,1,1));
         }
     }
+    _update_rotation_matrices();
+
+    // the gyro calibration samples at the full rate
+    _sample_period_usec = 1000*1000UL / _sample_rate;
 
     // calibrate gyros unless gyro calibration has been disabled
     if (gyro_calibration_timing() != GYRO_CAL_NEVER) {
         _init_gyro();
     }
 
-    _sample_period_usec = 1000*1000UL / _sample_rate;
-
     // establish the baseline time between samples
     _delta_time = 0;
     _next_sample_usec = 0;
     _last_sample_usec = 0;
     _have_sample = false;
+
+#if HAL_INS_FFT_ENABLED
+    if (_fft_enable && _gyro_count > 0) {
+        _gyro_fft.init(_gyro_raw_sample_rates[0]);
+    }
+#endif
 }
 
 void AP_InertialSensor::_add_backend(AP_InertialSensor_Backend *backend)
@@ -513,6 +570,8 @@ AP_InertialSensor::detect_backends(void)
 
     _backends_detected = true;
 
+    AP_Alloc::Tag alloc_tag("INS");
+
     if (_hil_mode) {
         _add_backend(AP_InertialSensor_HIL::detect(*this));
         return;
@@ -684,17 +743,16 @@ bool AP_InertialSensor::calibrate_trim(float &trim_roll, float &trim_pitch)
 
     _calibrating = true;
 
-    const uint8_t update_dt_milliseconds = (uint8_t)(1000.0f/get_sample_rate()+0.5f);
-
-    // wait 100ms for ins filter to rise
-    for (uint8_t k=0; k<100/update_dt_milliseconds; k++) {
+    // wait 100ms for ins filter to rise. wait_for_sample() paces the
+    // loops at the sample rate
+    for (uint16_t k=0; k<get_sample_rate()/10; k++) {
         wait_for_sample();
         update();
-        hal.scheduler->delay(update_dt_milliseconds);
     }
 
+    // average 400ms of samples
     uint32_t num_samples = 0;
-    while (num_samples < 400/update_dt_milliseconds) {
+    while (num_samples < get_sample_rate()*2U/5U) {
         wait_for_sample();
         // read samples from ins
         update();
@@ -705,7 +763,6 @@ bool AP_InertialSensor::calibrate_trim(float &trim_roll, float &trim_pitch)
         if (!get_accel_health(0)) {
             goto failed;
         }
-        hal.scheduler->delay(update_dt_milliseconds);
         num_samples++;
     }
     level_sample /= num_samples;
@@ -774,14 +831,29 @@ bool AP_InertialSensor::use_accel(uint8_t instance) const
     return (get_accel_health(instance) && _use[instance]);
 }
 
+/*
+  calibrate the gyro offsets. The gyros are read at the full sample
+  rate and the samples grouped into short batches. The offset is the
+  mean of all samples and its uncertainty comes from the spread of the
+  batch means, which allows for the correlation between successive
+  samples from filtering and vibration. A gyro has converged once the
+  95% confidence interval of its offset is within
+  GYRO_INIT_MAX_DIFF_DPS on every axis, so a still vehicle finishes in
+  a fraction of a second. Accumulation restarts whenever the
+  accelerometers show the vehicle moving.
+ */
 void
 AP_InertialSensor::_init_gyro()
 {
     uint8_t num_gyros = MIN(get_gyro_count(), INS_MAX_INSTANCES);
-    Vector3f last_average[INS_MAX_INSTANCES], best_avg[INS_MAX_INSTANCES];
-    Vector3f new_gyro_offset[INS_MAX_INSTANCES];
-    float best_diff[INS_MAX_INSTANCES];
-    bool converged[INS_MAX_INSTANCES];
+    struct {
+        Vector3f batch_sum;
+        Vector3f mean;          // running mean of the batch means
+        Vector3f m2;            // sum of squared deviations of the batch means
+        Vector3f half_width;    // 95% confidence interval of the mean
+        uint16_t batches;
+        bool converged;
+    } cal[INS_MAX_INSTANCES];
 
     // exit immediately if calibration is already in progress
     if (_calibrating) {
@@ -807,99 +879,98 @@ AP_InertialSensor::_init_gyro()
     // remove existing gyro offsets
     for (uint8_t k=0; k<num_gyros; k++) {
         _gyro_offset[k].set(Vector3f());
-        new_gyro_offset[k].zero();
-        best_diff[k] = -1.f;
-        last_average[k].zero();
-        converged[k] = false;
+        memset(&cal[k], 0, sizeof(cal[k]));
     }
 
-    for(int8_t c = 0; c < 5; c++) {
-        hal.scheduler->delay(5);
+    // let the filters settle for 25ms
+    for (uint16_t c = 0; c < MAX(_sample_rate / 40U, 1U); c++) {
+        wait_for_sample();
         update();
     }
 
-    // the strategy is to average 50 points over 0.5 seconds, then do it
-    // again and see if the 2nd average is within a small margin of
-    // the first
-
+    const uint16_t batch_samples = MAX(_sample_rate / GYRO_INIT_BATCH_HZ, 1U);
+    const uint16_t batches_per_tick = GYRO_INIT_BATCH_HZ / 4;
+    const float max_half_width = ToRad(GYRO_INIT_MAX_DIFF_DPS) * 0.5f;
+    const uint32_t start_ms = AP_HAL::millis();
+    Vector3f accel_tick = get_accel(0);
+    uint16_t batch_count = 0;
+    uint16_t batch_fill = 0;
     uint8_t num_converged = 0;
 
-    // we try to get a good calibration estimate for up to 30 seconds
-    // if the gyros are stable, we should get it in 1 second
-    for (int16_t j = 0; j <= 30*4 && num_converged < num_gyros; j++) {
-        Vector3f gyro_sum[INS_MAX_INSTANCES], gyro_avg[INS_MAX_INSTANCES], gyro_diff[INS_MAX_INSTANCES];
-        Vector3f accel_start;
-        float diff_norm[INS_MAX_INSTANCES];
-        uint8_t i;
-
-        memset(diff_norm, 0, sizeof(diff_norm));
-
-        hal.console->print("*");
-
+    while (num_converged < num_gyros && AP_HAL::millis() - start_ms < GYRO_INIT_TIMEOUT_MS) {
+        wait_for_sample();
+        update();
         for (uint8_t k=0; k<num_gyros; k++) {
-            gyro_sum[k].zero();
-        }
-        accel_start = get_accel(0);
-        for (i=0; i<50; i++) {
-            update();
-            for (uint8_t k=0; k<num_gyros; k++) {
-                gyro_sum[k] += get_gyro(k);
-            }
-            hal.scheduler->delay(5);
+            cal[k].batch_sum += get_gyro(k);
         }
-
-        Vector3f accel_diff = get_accel(0) - accel_start;
-        if (accel_diff.length() > 0.2f) {
-            // the accelerometers changed during the gyro sum. Skip
-            // this sample. This copes with doing gyro cal on a
-            // steadily moving platform. The value 0.2 corresponds
-            // with around 5 degrees/second of rotation.
+        if (++batch_fill < batch_samples) {
             continue;
         }
+        batch_fill = 0;
 
         for (uint8_t k=0; k<num_gyros; k++) {
-            gyro_avg[k] = gyro_sum[k] / i;
-            gyro_diff[k] = last_average[k] - gyro_avg[k];
-            diff_norm[k] = gyro_diff[k].length();
+            if (cal[k].converged) {
+                continue;
+            }
+            // Welford update with the batch mean
+            const Vector3f batch_mean = cal[k].batch_sum / batch_samples;
+            cal[k].batches++;
+            const Vector3f delta = batch_mean - cal[k].mean;
+            cal[k].mean += delta / cal[k].batches;
+            const Vector3f delta2 = batch_mean - cal[k].mean;
+            cal[k].m2.x += delta.x * delta2.x;
+            cal[k].m2.y += delta.y * delta2.y;
+            cal[k].m2.z += delta.z * delta2.z;
+
+            if (cal[k].batches >= GYRO_INIT_MIN_BATCHES) {
+                // 1.96 standard errors of the mean of the batch means
+                const float n = cal[k].batches;
+                const float scale = 1.96f / sqrtf(n * (n - 1));
+                cal[k].half_width = Vector3f(sqrtf(cal[k].m2.x), sqrtf(cal[k].m2.y), sqrtf(cal[k].m2.z)) * scale;
+                if (cal[k].half_width.x < max_half_width &&
+                    cal[k].half_width.y < max_half_width &&
+                    cal[k].half_width.z < max_half_width) {
+                    cal[k].converged = true;
+                    num_converged++;
+                }
+            }
         }
-
         for (uint8_t k=0; k<num_gyros; k++) {
-            if (best_diff[k] < 0) {
-                best_diff[k] = diff_norm[k];
-                best_avg[k] = gyro_avg[k];
-            } else if (gyro_diff[k].length() < ToRad(GYRO_INIT_MAX_DIFF_DPS)) {
-                // we want the average to be within 0.1 bit, which is 0.04 degrees/s
-                last_average[k] = (gyro_avg[k] * 0.5f) + (last_average[k] * 0.5f);
-                if (!converged[k] || last_average[k].length() < new_gyro_offset[k].length()) {
-                    new_gyro_offset[k] = last_average[k];
-                }
-                if (!converged[k]) {
-                    converged[k] = true;
-                    num_converged++;
+            cal[k].batch_sum.zero();
+        }
+
+        if (++batch_count % batches_per_tick != 0) {
+            continue;
+        }
+        hal.console->print("*");
+
+        Vector3f accel_diff = get_accel(0) - accel_tick;
+        accel_tick = get_accel(0);
+        if (accel_diff.length() > GYRO_INIT_ACCEL_MOVE) {
+            // the accelerometers changed during the last quarter
+            // second. Start again on the gyros still being
+            // calibrated. This copes with doing gyro cal on a
+            // steadily moving platform. The value 0.2 corresponds
+            // with around 5 degrees/second of rotation.
+            for (uint8_t k=0; k<num_gyros; k++) {
+                if (!cal[k].converged) {
+                    memset(&cal[k], 0, sizeof(cal[k]));
                 }
-            } else if (diff_norm[k] < best_diff[k]) {
-                best_diff[k] = diff_norm[k];
-                best_avg[k] = (gyro_avg[k] * 0.5f) + (last_average[k] * 0.5f);
             }
-            last_average[k] = gyro_avg[k];
         }
     }
 
-    // we've kept the user waiting long enough - use the best pair we
-    // found so far
+    // we've kept the user waiting long enough - use the best estimate
+    // we have so far
     hal.console->println();
     for (uint8_t k=0; k<num_gyros; k++) {
-        if (!converged[k]) {
+        _gyro_offset[k] = cal[k].mean;
+        _gyro_cal_ok[k] = cal[k].converged;
+        if (!cal[k].converged) {
             hal.console->printf("gyro[%u] did not converge: diff=%f dps (expected < %f)\n",
                                 (unsigned)k,
-                                (double)ToDeg(best_diff[k]),
+                                (double)ToDeg(cal[k].half_width.length() * 2),
                                 (double)GYRO_INIT_MAX_DIFF_DPS);
-            _gyro_offset[k] = best_avg[k];
-            // flag calibration as failed for this gyro
-            _gyro_cal_ok[k] = false;
-        } else {
-            _gyro_cal_ok[k] = true;
-            _gyro_offset[k] = new_gyro_offset[k];
         }
     }
 
@@ -925,6 +996,36 @@ void AP_InertialSensor::_save_parameters()
 }
 
 
+/*
+  rebuild the rotation matrices used by the backends if the board
+  orientation or an accel scale has changed since they were built
+ */
+void AP_InertialSensor::_update_rotation_matrices(void)
+{
+    bool changed = _rotation_orientation != _board_orientation;
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        if (_rotation_accel_scale[i] != _accel_scale[i].get()) {
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return;
+    }
+
+    Matrix3f rotation;
+    rotation.from_rotation(_board_orientation);
+
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        const Vector3f &scale = _accel_scale[i].get();
+        _accel_rotation[i] = Matrix3f(rotation.colx() * scale.x,
+                                      rotation.coly() * scale.y,
+                                      rotation.colz() * scale.z).transposed();
+        _rotation_accel_scale[i] = scale;
+    }
+    _gyro_rotation = rotation;
+    _rotation_orientation = _board_orientation;
+}
+
 /*
   update gyro and accel values from backends
  */
@@ -934,6 +1035,8 @@ void AP_InertialSensor::update(void)
     // wait_for_sample(), and a wait is implied
     wait_for_sample();
 
+    _update_rotation_matrices();
+
     if (!_hil_mode) {
         for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
             // mark sensors unhealthy and let update() in each backend
@@ -952,6 +1055,8 @@ void AP_InertialSensor::update(void)
         for (uint8_t i = 0; i < INS_MAX_INSTANCES; i++) {
             _delta_velocity_acc[i].zero();
             _delta_velocity_acc_dt[i] = 0;
+            _delta_velocity_scul[i].zero();
+            _delta_velocity_alpha[i].zero();
             _delta_angle_acc[i].zero();
             _delta_angle_acc_dt[i] = 0;
         }
@@ -1132,6 +1237,19 @@ check_sample:
 }
 
 
+/*
+  get the newest gyro sample. Backends that publish without raw samples
+  only update the gyro in update()
+ */
+Vector3f AP_InertialSensor::get_gyro_latest(uint8_t i) const
+{
+    SensorTopic<Vector3f>::Sample sample;
+    if (!_gyro_topic[i].read(sample)) {
+        return _gyro[i];
+    }
+    return sample.data;
+}
+
 /*
   get delta angles
  */
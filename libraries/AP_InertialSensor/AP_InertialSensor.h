@@ -20,9 +20,14 @@
 
 #include <AP_AccelCal/AP_AccelCal.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/SensorTopic.h>
 #include <AP_Math/AP_Math.h>
 #include <Filter/LowPassFilter2p.h>
+#include <Filter/LowPassFilter2pBank.h>
 #include <Filter/LowPassFilter.h>
+#include <Filter/NotchFilter.h>
+#include <Filter/HarmonicNotchFilter.h>
+#include "AP_GyroFFT.h"
 
 class AP_InertialSensor_Backend;
 class AuxiliaryBus;
@@ -88,6 +93,15 @@ public:
     const Vector3f     &get_gyro(uint8_t i) const { return _gyro[i]; }
     const Vector3f     &get_gyro(void) const { return get_gyro(_primary_gyro); }
 
+    // newest filtered gyro sample, updated at the raw sample rate rather
+    // than by update(). Safe to call from any thread
+    Vector3f get_gyro_latest(uint8_t i) const;
+
+    // filtered gyro and accel samples at the raw sample rate, stamped
+    // with the sample time, for readers on other threads
+    const SensorTopic<Vector3f> &get_gyro_topic(uint8_t i) const { return _gyro_topic[i]; }
+    const SensorTopic<Vector3f> &get_accel_topic(uint8_t i) const { return _accel_topic[i]; }
+
     // set gyro offsets in radians/sec
     const Vector3f &get_gyro_offsets(uint8_t i) const { return _gyro_offset[i]; }
     const Vector3f &get_gyro_offsets(void) const { return get_gyro_offsets(_primary_gyro); }
@@ -171,6 +185,10 @@ public:
     // return the selected sample rate
     uint16_t get_sample_rate(void) const { return _sample_rate; }
 
+    // change the rate wait_for_sample() returns samples at, for
+    // vehicles whose main loop rate changes while running
+    void set_loop_rate(uint16_t sample_rate);
+
     // return the main loop delta_t in seconds
     float get_loop_delta_t(void) const { return _loop_delta_t; }
 
@@ -189,6 +207,19 @@ public:
     // get the accel filter rate in Hz
     uint8_t get_accel_filter_hz(void) const { return _accel_filter_cutoff; }
 
+    // harmonic notch filter parameters, used by the vehicle to work
+    // out the center frequency
+    const HarmonicNotchFilterParams &get_gyro_harmonic_notch_params(void) const { return _harmonic_notch_filter; }
+
+#if HAL_INS_FFT_ENABLED
+    // vibration spectrum analyser on the first gyro
+    const AP_GyroFFT &get_gyro_fft(void) const { return _gyro_fft; }
+#endif
+
+    // set the center frequency of the gyro harmonic notch, following
+    // the motor speed
+    void update_harmonic_notch_freq_hz(float center_freq_hz) { _calculated_harmonic_notch_freq_hz = center_freq_hz; }
+
     // pass in a pointer to DataFlash for raw data logging
     void set_dataflash(DataFlash_Class *dataflash) { _dataflash = dataflash; }
 
@@ -290,12 +321,25 @@ private:
     Vector3f _delta_velocity_acc[INS_MAX_INSTANCES];
     // time accumulator for delta velocity accumulator
     float _delta_velocity_acc_dt[INS_MAX_INSTANCES];
+    // sculling and rotation correction for the delta velocity accumulator,
+    // with the delta angle and the previous raw sample deltas it needs
+    Vector3f _delta_velocity_scul[INS_MAX_INSTANCES];
+    Vector3f _delta_velocity_alpha[INS_MAX_INSTANCES];
+    Vector3f _last_delta_velocity[INS_MAX_INSTANCES];
+    Vector3f _last_accel_delta_angle[INS_MAX_INSTANCES];
 
     // Low Pass filters for gyro and accel
-    LowPassFilter2pVector3f _accel_filter[INS_MAX_INSTANCES];
-    LowPassFilter2pVector3f _gyro_filter[INS_MAX_INSTANCES];
+    LowPassFilter2pBank3f _accel_filter[INS_MAX_INSTANCES];
+    LowPassFilter2pBank3f _gyro_filter[INS_MAX_INSTANCES];
+    // notch filters applied to the raw gyro samples ahead of the low pass filter
+    NotchFilterVector3f _gyro_notch_filter[INS_MAX_INSTANCES];
+    // harmonic notch filters following the motor speed, after the fixed notch
+    HarmonicNotchFilterVector3f _gyro_harmonic_notch_filter[INS_MAX_INSTANCES];
+    float _calculated_harmonic_notch_freq_hz;
     Vector3f _accel_filtered[INS_MAX_INSTANCES];
     Vector3f _gyro_filtered[INS_MAX_INSTANCES];
+    SensorTopic<Vector3f> _gyro_topic[INS_MAX_INSTANCES];
+    SensorTopic<Vector3f> _accel_topic[INS_MAX_INSTANCES];
     bool _new_accel_data[INS_MAX_INSTANCES];
     bool _new_gyro_data[INS_MAX_INSTANCES];
 
@@ -331,6 +375,18 @@ private:
     // filtering frequency (0 means default)
     AP_Int8     _accel_filter_cutoff;
     AP_Int8     _gyro_filter_cutoff;
+
+    // gyro notch filter parameters
+    NotchFilterParams _gyro_notch;
+
+    // gyro harmonic notch filter parameters
+    HarmonicNotchFilterParams _harmonic_notch_filter;
+
+#if HAL_INS_FFT_ENABLED
+    // gyro vibration spectrum analyser
+    AP_Int8 _fft_enable;
+    AP_GyroFFT _gyro_fft;
+#endif
     AP_Int8     _gyro_cal_timing;
 
     // use for attitude, velocity, position estimates
@@ -339,6 +395,18 @@ private:
     // board orientation from AHRS
     enum Rotation _board_orientation;
 
+    /*
+      the board rotation as a matrix for the gyros, and with the accel
+      scaling folded in for each accel, so the backends correct a
+      sample with one matrix multiply. Rebuilt from update() when the
+      orientation or scaling they were built from changes
+     */
+    void _update_rotation_matrices(void);
+    Matrix3f _gyro_rotation;
+    Matrix3f _accel_rotation[INS_MAX_INSTANCES];
+    enum Rotation _rotation_orientation;
+    Vector3f _rotation_accel_scale[INS_MAX_INSTANCES];
+
     // calibrated_ok flags
     bool _gyro_cal_ok[INS_MAX_INSTANCES];
 
@@ -180,9 +180,16 @@ void AP_InertialSensor_BMI160::start()
     _accel_instance = _imu.register_accel(BMI160_ODR_TO_HZ(BMI160_ODR));
     _gyro_instance = _imu.register_gyro(BMI160_ODR_TO_HZ(BMI160_ODR));
 
-    /* Call _poll_data() at 1kHz */
-    _dev->register_periodic_callback(1000,
-        FUNCTOR_BIND_MEMBER(&AP_InertialSensor_BMI160::_poll_data, bool));
+    /*
+     * Read the FIFO as soon as INT1 signals the watermark where the HAL can
+     * wait on it, otherwise call _poll_data() at 1kHz
+     */
+    if (_int1_pin == nullptr ||
+        _dev->register_data_ready_callback(BMI160_INT1_GPIO, 2000,
+            FUNCTOR_BIND_MEMBER(&AP_InertialSensor_BMI160::_poll_data, bool)) == nullptr) {
+        _dev->register_periodic_callback(1000,
+            FUNCTOR_BIND_MEMBER(&AP_InertialSensor_BMI160::_poll_data, bool));
+    }
 }
 
 bool AP_InertialSensor_BMI160::update()
@@ -22,21 +22,33 @@ void AP_InertialSensor_Backend::_rotate_and_correct_accel(uint8_t instance, Vect
     // apply offsets
     accel -= _imu._accel_offset[instance];
 
-    // apply scaling
-    const Vector3f &accel_scale = _imu._accel_scale[instance].get();
-    accel.x *= accel_scale.x;
-    accel.y *= accel_scale.y;
-    accel.z *= accel_scale.z;
-
-    // rotate to body frame
-    accel.rotate(_imu._board_orientation);
+    // apply scaling and rotate to body frame
+    accel = _imu._accel_rotation[instance] * accel;
 }
 
 void AP_InertialSensor_Backend::_rotate_and_correct_gyro(uint8_t instance, Vector3f &gyro) 
 {
     // gyro calibration is always assumed to have been done in sensor frame
     gyro -= _imu._gyro_offset[instance];
-    gyro.rotate(_imu._board_orientation);
+    gyro = _imu._gyro_rotation * gyro;
+}
+
+/*
+  correct a delta velocity over dt the same way as an accel sample
+ */
+void AP_InertialSensor_Backend::_rotate_and_correct_delta_velocity(uint8_t instance, Vector3f &delta_velocity, float dt)
+{
+    delta_velocity -= _imu._accel_offset[instance].get() * dt;
+    delta_velocity = _imu._accel_rotation[instance] * delta_velocity;
+}
+
+/*
+  correct a delta angle over dt the same way as a gyro sample
+ */
+void AP_InertialSensor_Backend::_rotate_and_correct_delta_angle(uint8_t instance, Vector3f &delta_angle, float dt)
+{
+    delta_angle -= _imu._gyro_offset[instance].get() * dt;
+    delta_angle = _imu._gyro_rotation * delta_angle;
 }
 
 /*
@@ -75,6 +87,19 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     // compute delta angle
     Vector3f delta_angle = (gyro + _imu._last_raw_gyro[instance]) * 0.5f * dt;
 
+    _notify_new_gyro_delta_sample(instance, gyro, delta_angle, dt, sample_us);
+}
+
+/*
+  take a gyro sample with its delta angle over dt, integrated by the
+  backend at a higher rate than it delivers samples
+ */
+void AP_InertialSensor_Backend::_notify_new_gyro_delta_sample(uint8_t instance,
+                                                              const Vector3f &gyro,
+                                                              const Vector3f &delta_angle,
+                                                              float dt,
+                                                              uint64_t sample_us)
+{
     // compute coning correction
     // see page 26 of:
     // Tian et al (2010) Three-loop Integration of GPS and Strapdown INS with Coning and Sculling Compensation
@@ -96,10 +121,23 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     _imu._last_delta_angle[instance] = delta_angle;
     _imu._last_raw_gyro[instance] = gyro;
 
-    _imu._gyro_filtered[instance] = _imu._gyro_filter[instance].apply(gyro);
+#if HAL_INS_FFT_ENABLED
+    if (instance == 0) {
+        _imu._gyro_fft.sample(gyro);
+    }
+#endif
+
+    // the notch filters run at the raw sample rate so they can remove
+    // motor noise above the loop rate before the low pass filter
+    const Vector3f notched = _imu._gyro_harmonic_notch_filter[instance].apply(_imu._gyro_notch_filter[instance].apply(gyro));
+    _imu._gyro_filtered[instance] = _imu._gyro_filter[instance].apply(notched);
     if (_imu._gyro_filtered[instance].is_nan() || _imu._gyro_filtered[instance].is_inf()) {
         _imu._gyro_filter[instance].reset();
+        _imu._gyro_notch_filter[instance].reset();
+        _imu._gyro_harmonic_notch_filter[instance].reset();
     }
+    _imu._gyro_topic[instance].publish(_imu._gyro_filtered[instance],
+                                       sample_us?sample_us:AP_HAL::micros64());
 
     _imu._new_gyro_data[instance] = true;
 
@@ -114,7 +152,7 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
             GyrY      : gyro.y,
             GyrZ      : gyro.z
         };
-        dataflash->WriteBlock(&pkt, sizeof(pkt));
+        _write_raw_sample(dataflash, &pkt, sizeof(pkt));
     }
 }
 
@@ -130,8 +168,11 @@ void AP_InertialSensor_Backend::_publish_accel(uint8_t instance, const Vector3f
         return;
     }
 
-    // publish delta velocity
-    _imu._delta_velocity[instance] = _imu._delta_velocity_acc[instance];
+    // publish delta velocity, in the body frame at the start of the
+    // interval
+    const Vector3f &dv = _imu._delta_velocity_acc[instance];
+    _imu._delta_velocity[instance] = dv + (_imu._delta_velocity_alpha[instance] % dv) * 0.5f +
+                                     _imu._delta_velocity_scul[instance];
     _imu._delta_velocity_dt[instance] = _imu._delta_velocity_acc_dt[instance];
     _imu._delta_velocity_valid[instance] = true;
 
@@ -170,17 +211,50 @@ void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
 
     // call gyro_sample hook if any
     AP_Module::call_hook_accel_sample(instance, dt, accel, fsync_set);
-    
+
+    // delta velocity, with the delta angle over the same sample from
+    // the latest gyro reading, as the gyro may run at another rate
+    const Vector3f delta_velocity = accel * dt;
+    const Vector3f delta_angle = _imu._last_raw_gyro[instance] * dt;
+
+    _notify_new_accel_delta_sample(instance, accel, delta_velocity, delta_angle, dt, sample_us);
+}
+
+/*
+  take an accel sample with its delta velocity over dt, and the delta
+  angle over the same interval, integrated by the backend at a higher
+  rate than it delivers samples
+ */
+void AP_InertialSensor_Backend::_notify_new_accel_delta_sample(uint8_t instance,
+                                                               const Vector3f &accel,
+                                                               const Vector3f &delta_velocity,
+                                                               const Vector3f &delta_angle,
+                                                               float dt,
+                                                               uint64_t sample_us)
+{
     _imu.calc_vibration_and_clipping(instance, accel, dt);
 
-    // delta velocity
-    _imu._delta_velocity_acc[instance] += accel * dt;
+    // sculling correction, the velocity counterpart of the coning
+    // correction in _notify_new_gyro_raw_sample(). The rotation of the
+    // body during the interval is applied in _publish_accel()
+    // see Savage (1998) Strapdown Inertial Navigation Integration
+    // Algorithm Design Part 2: Velocity and Position Algorithms, eq 28
+    const Vector3f alpha = _imu._delta_velocity_alpha[instance] + _imu._last_accel_delta_angle[instance] * (1.0f / 6.0f);
+    const Vector3f v = _imu._delta_velocity_acc[instance] + _imu._last_delta_velocity[instance] * (1.0f / 6.0f);
+    _imu._delta_velocity_scul[instance] += ((alpha % delta_velocity) + (v % delta_angle)) * 0.5f;
+
+    _imu._delta_velocity_acc[instance] += delta_velocity;
     _imu._delta_velocity_acc_dt[instance] += dt;
+    _imu._delta_velocity_alpha[instance] += delta_angle;
+    _imu._last_delta_velocity[instance] = delta_velocity;
+    _imu._last_accel_delta_angle[instance] = delta_angle;
 
     _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(accel);
     if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
         _imu._accel_filter[instance].reset();
     }
+    _imu._accel_topic[instance].publish(_imu._accel_filtered[instance],
+                                        sample_us?sample_us:AP_HAL::micros64());
 
     _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
 
@@ -197,7 +271,28 @@ void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
             AccY      : accel.y,
             AccZ      : accel.z
         };
-        dataflash->WriteBlock(&pkt, sizeof(pkt));
+        _write_raw_sample(dataflash, &pkt, sizeof(pkt));
+    }
+}
+
+DataFlash_Class *AP_InertialSensor_Backend::get_dataflash(void) const
+{
+    DataFlash_Class *dataflash = _imu._dataflash;
+    if (dataflash == NULL) {
+        return NULL;
+    }
+    if (_imu._log_raw_data || dataflash->pretrigger_enabled(DATAFLASH_PRETRIGGER_IMU_RAW)) {
+        return dataflash;
+    }
+    return NULL;
+}
+
+void AP_InertialSensor_Backend::_write_raw_sample(DataFlash_Class *dataflash, const void *pkt, uint16_t size) const
+{
+    if (_imu._log_raw_data) {
+        dataflash->WriteBlock(pkt, size);
+    } else {
+        dataflash->WritePretriggerBlock(pkt, size);
     }
 }
 
@@ -239,6 +334,81 @@ void AP_InertialSensor_Backend::_publish_temperature(uint8_t instance, float tem
     }
 }
 
+/*
+  re-initialise the gyro notch filter when its parameters change
+ */
+void AP_InertialSensor_Backend::_update_gyro_notch_filter(uint8_t instance)
+{
+    const NotchFilterParams &notch = _imu._gyro_notch;
+    if (_last_gyro_notch_enabled[instance] == notch.enabled() &&
+        is_equal(_last_gyro_notch_hz[instance], notch.center_freq_hz()) &&
+        is_equal(_last_gyro_notch_bw_hz[instance], notch.bandwidth_hz()) &&
+        is_equal(_last_gyro_notch_att_dB[instance], notch.attenuation_dB())) {
+        return;
+    }
+
+    if (notch.enabled()) {
+        _imu._gyro_notch_filter[instance].init(_gyro_raw_sample_rate(instance),
+                                               notch.center_freq_hz(),
+                                               notch.bandwidth_hz(),
+                                               notch.attenuation_dB());
+    } else {
+        // an uninitialised notch passes samples straight through
+        _imu._gyro_notch_filter[instance].init(0, 0, 0, 0);
+    }
+    _imu._gyro_notch_filter[instance].reset();
+
+    _last_gyro_notch_enabled[instance] = notch.enabled();
+    _last_gyro_notch_hz[instance] = notch.center_freq_hz();
+    _last_gyro_notch_bw_hz[instance] = notch.bandwidth_hz();
+    _last_gyro_notch_att_dB[instance] = notch.attenuation_dB();
+}
+
+/*
+  re-initialise the gyro harmonic notch filter when its parameters
+  change, and move it when the center frequency set by the vehicle
+  changes by more than half a Hz. Moving the notch keeps the filter
+  state so there is no transient
+ */
+void AP_InertialSensor_Backend::_update_gyro_harmonic_notch_filter(uint8_t instance)
+{
+    const HarmonicNotchFilterParams &notch = _imu._harmonic_notch_filter;
+    float center_freq_hz = _imu._calculated_harmonic_notch_freq_hz;
+    if (center_freq_hz <= 0) {
+        // the vehicle has not set a frequency yet
+        center_freq_hz = notch.center_freq_hz();
+    }
+
+    if (_last_harmonic_notch_enabled[instance] == notch.enabled() &&
+        is_equal(_last_harmonic_notch_bw_hz[instance], notch.bandwidth_hz()) &&
+        is_equal(_last_harmonic_notch_att_dB[instance], notch.attenuation_dB()) &&
+        _last_harmonic_notch_harmonics[instance] == notch.harmonics()) {
+        if (notch.enabled() && fabsf(center_freq_hz - _last_harmonic_notch_hz[instance]) > 0.5f) {
+            _imu._gyro_harmonic_notch_filter[instance].update(center_freq_hz);
+            _last_harmonic_notch_hz[instance] = center_freq_hz;
+        }
+        return;
+    }
+
+    if (notch.enabled()) {
+        _imu._gyro_harmonic_notch_filter[instance].init(_gyro_raw_sample_rate(instance),
+                                                        center_freq_hz,
+                                                        notch.bandwidth_hz(),
+                                                        notch.attenuation_dB(),
+                                                        notch.harmonics());
+    } else {
+        // no harmonics selected passes samples straight through
+        _imu._gyro_harmonic_notch_filter[instance].init(0, 0, 0, 0, 0);
+    }
+    _imu._gyro_harmonic_notch_filter[instance].reset();
+
+    _last_harmonic_notch_enabled[instance] = notch.enabled();
+    _last_harmonic_notch_hz[instance] = center_freq_hz;
+    _last_harmonic_notch_bw_hz[instance] = notch.bandwidth_hz();
+    _last_harmonic_notch_att_dB[instance] = notch.attenuation_dB();
+    _last_harmonic_notch_harmonics[instance] = notch.harmonics();
+}
+
 /*
   common gyro update function for all backends
  */
@@ -257,6 +427,9 @@ void AP_InertialSensor_Backend::update_gyro(uint8_t instance)
         _last_gyro_filter_hz[instance] = _gyro_filter_cutoff();
     }
 
+    _update_gyro_notch_filter(instance);
+    _update_gyro_harmonic_notch_filter(instance);
+
     hal.scheduler->resume_timer_procs();
 }
 
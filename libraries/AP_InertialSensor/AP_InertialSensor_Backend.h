@@ -78,6 +78,10 @@ protected:
     void _rotate_and_correct_accel(uint8_t instance, Vector3f &accel);
     void _rotate_and_correct_gyro(uint8_t instance, Vector3f &gyro);
 
+    // correct delta velocities and angles integrated by the backend
+    void _rotate_and_correct_delta_velocity(uint8_t instance, Vector3f &delta_velocity, float dt);
+    void _rotate_and_correct_delta_angle(uint8_t instance, Vector3f &delta_angle, float dt);
+
     // rotate gyro vector, offset and publish
     void _publish_gyro(uint8_t instance, const Vector3f &gyro);
 
@@ -87,6 +91,12 @@ protected:
     // be rotated and corrected (_rotate_and_correct_gyro)
     void _notify_new_gyro_raw_sample(uint8_t instance, const Vector3f &accel, uint64_t sample_us=0);
 
+    // as _notify_new_gyro_raw_sample, for backends that integrate the
+    // delta angle over dt themselves at a higher rate. The sample and
+    // delta angle must be rotated and corrected
+    void _notify_new_gyro_delta_sample(uint8_t instance, const Vector3f &gyro,
+                                       const Vector3f &delta_angle, float dt, uint64_t sample_us);
+
     // rotate accel vector, scale, offset and publish
     void _publish_accel(uint8_t instance, const Vector3f &accel);
 
@@ -96,6 +106,13 @@ protected:
     // be rotated and corrected (_rotate_and_correct_accel)
     void _notify_new_accel_raw_sample(uint8_t instance, const Vector3f &accel, uint64_t sample_us=0, bool fsync_set=false);
 
+    // as _notify_new_accel_raw_sample, for backends that integrate the
+    // delta velocity over dt themselves. delta_angle is over the same
+    // interval
+    void _notify_new_accel_delta_sample(uint8_t instance, const Vector3f &accel,
+                                        const Vector3f &delta_velocity, const Vector3f &delta_angle,
+                                        float dt, uint64_t sample_us);
+
     // set accelerometer max absolute offset for calibration
     void _set_accel_max_abs_offset(uint8_t instance, float offset);
 
@@ -133,10 +150,12 @@ protected:
     // return the requested sample rate in Hz
     uint16_t get_sample_rate_hz(void) const;
 
-    // access to frontend dataflash
-    DataFlash_Class *get_dataflash(void) const {
-        return _imu._log_raw_data? _imu._dataflash : NULL;
-    }
+    // access to frontend dataflash, if raw samples are being logged
+    // or kept for the log trigger
+    DataFlash_Class *get_dataflash(void) const;
+
+    // log a raw sample, or keep it for the log trigger
+    void _write_raw_sample(DataFlash_Class *dataflash, const void *pkt, uint16_t size) const;
 
     // common gyro update function for all backends
     void update_gyro(uint8_t instance);
@@ -147,6 +166,23 @@ protected:
     // support for updating filter at runtime
     int8_t _last_accel_filter_hz[INS_MAX_INSTANCES];
     int8_t _last_gyro_filter_hz[INS_MAX_INSTANCES];
+    bool _last_gyro_notch_enabled[INS_MAX_INSTANCES];
+    float _last_gyro_notch_hz[INS_MAX_INSTANCES];
+    float _last_gyro_notch_bw_hz[INS_MAX_INSTANCES];
+    float _last_gyro_notch_att_dB[INS_MAX_INSTANCES];
+
+    // possibly update gyro notch filter parameters
+    void _update_gyro_notch_filter(uint8_t instance);
+
+    // harmonic notch settings last applied to each instance
+    bool _last_harmonic_notch_enabled[INS_MAX_INSTANCES];
+    float _last_harmonic_notch_hz[INS_MAX_INSTANCES];
+    float _last_harmonic_notch_bw_hz[INS_MAX_INSTANCES];
+    float _last_harmonic_notch_att_dB[INS_MAX_INSTANCES];
+    uint8_t _last_harmonic_notch_harmonics[INS_MAX_INSTANCES];
+
+    // possibly update gyro harmonic notch filter parameters and center frequency
+    void _update_gyro_harmonic_notch_filter(uint8_t instance);
 
     // note that each backend is also expected to have a static detect()
     // function which instantiates an instance of the backend sensor
@@ -91,6 +91,7 @@ extern const AP_HAL::HAL& hal;
 #       define BIT_SLV1_FIFO_EN                     0x02
 #       define BIT_SLV0_FIFI_EN0                    0x01
 #define MPUREG_I2C_MST_CTRL                     0x24
+#       define BIT_I2C_SLV3_FIFO_EN                 0x20
 #       define BIT_I2C_MST_P_NSR                    0x10
 #       define BIT_I2C_MST_CLK_400KHZ               0x0D
 #define MPUREG_I2C_SLV0_ADDR                    0x25
@@ -206,10 +207,14 @@ extern const AP_HAL::HAL& hal;
 
 #define MPU6000_SAMPLE_SIZE 14
 
-#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BH
-#define MPU6000_MAX_FIFO_SAMPLES 6
-#else
-#define MPU6000_MAX_FIFO_SAMPLES 3
+#define MPU6000_FIFO_SIZE 1024
+
+/*
+  maximum number of samples drained from the FIFO in one bus
+  transfer. Anything left over is picked up on the next timer tick
+ */
+#ifndef MPU6000_MAX_FIFO_SAMPLES
+#define MPU6000_MAX_FIFO_SAMPLES 24
 #endif
 #define MAX_DATA_READ (MPU6000_MAX_FIFO_SAMPLES * MPU6000_SAMPLE_SIZE)
 
@@ -237,12 +242,14 @@ AP_InertialSensor_MPU6000::AP_InertialSensor_MPU6000(AP_InertialSensor &imu,
     , _use_fifo(use_fifo)
     , _temp_filter(1000, 1)
     , _dev(std::move(dev))
+    , _fifo_buffer(nullptr)
 {
 }
 
 AP_InertialSensor_MPU6000::~AP_InertialSensor_MPU6000()
 {
     delete _auxiliary_bus;
+    delete[] _fifo_buffer;
 }
 
 AP_InertialSensor_Backend *AP_InertialSensor_MPU6000::probe(AP_InertialSensor &imu,
@@ -267,7 +274,7 @@ AP_InertialSensor_Backend *AP_InertialSensor_MPU6000::probe(AP_InertialSensor &i
 
     dev->set_read_flag(0x80);
 
-    sensor = new AP_InertialSensor_MPU6000(imu, std::move(dev), false);
+    sensor = new AP_InertialSensor_MPU6000(imu, std::move(dev), MPU6000_SPI_USE_FIFO);
     if (!sensor || !sensor->_init()) {
         delete sensor;
         return nullptr;
@@ -284,6 +291,13 @@ bool AP_InertialSensor_MPU6000::_init()
     _drdy_pin->mode(HAL_GPIO_INPUT);
 #endif
 
+    if (_use_fifo) {
+        _fifo_buffer = new uint8_t[MAX_DATA_READ];
+        if (_fifo_buffer == nullptr) {
+            return false;
+        }
+    }
+
     hal.scheduler->suspend_timer_procs();
     bool success = _hardware_init();
     hal.scheduler->resume_timer_procs();
@@ -304,12 +318,48 @@ void AP_InertialSensor_MPU6000::_fifo_reset()
 
 void AP_InertialSensor_MPU6000::_fifo_enable()
 {
-    _register_write(MPUREG_FIFO_EN, BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
-                    BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN);
+    _fifo_en = BIT_XG_FIFO_EN | BIT_YG_FIFO_EN | BIT_ZG_FIFO_EN |
+               BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN;
+    _register_write(MPUREG_FIFO_EN, _fifo_en);
     _fifo_reset();
     hal.scheduler->delay(1);
 }
 
+/*
+  have the MPU6000 append the data read from an auxiliary bus slave to
+  each FIFO sample, so it arrives in the same transfer as gyro and
+  accel. The FIFO orders slave data by slave number, which is also the
+  order periodic reads are registered in. Must be called with the bus
+  semaphore held
+ */
+void AP_InertialSensor_MPU6000::_fifo_add_slave(uint8_t instance, uint8_t size)
+{
+    switch (instance) {
+    case 0:
+        _fifo_en |= BIT_SLV0_FIFI_EN0;
+        break;
+    case 1:
+        _fifo_en |= BIT_SLV1_FIFO_EN;
+        break;
+    case 2:
+        _fifo_en |= BIT_SLV2_FIFO_EN;
+        break;
+    case 3: {
+        uint8_t mst_ctrl = _register_read(MPUREG_I2C_MST_CTRL);
+        _register_write(MPUREG_I2C_MST_CTRL, mst_ctrl | BIT_I2C_SLV3_FIFO_EN);
+        break;
+    }
+    default:
+        return;
+    }
+
+    _register_write(MPUREG_FIFO_EN, _fifo_en);
+    _fifo_ext_sens_size += size;
+
+    /* samples already in the FIFO have the old layout */
+    _fifo_reset();
+}
+
 bool AP_InertialSensor_MPU6000::_has_auxiliary_bus()
 {
     return _dev->bus_type != AP_HAL::Device::BUS_TYPE_I2C;
@@ -451,10 +501,11 @@ void AP_InertialSensor_MPU6000::_poll_data()
     _dev->get_semaphore()->give();
 }
 
-void AP_InertialSensor_MPU6000::_accumulate(uint8_t *samples, uint8_t n_samples)
+void AP_InertialSensor_MPU6000::_accumulate(uint8_t *samples, uint8_t n_samples,
+                                            uint8_t sample_size)
 {
     for (uint8_t i = 0; i < n_samples; i++) {
-        uint8_t *data = samples + MPU6000_SAMPLE_SIZE * i;
+        uint8_t *data = samples + sample_size * i;
         Vector3f accel, gyro;
         float temp;
         bool fsync_set = false;
@@ -501,13 +552,18 @@ void AP_InertialSensor_MPU6000::_accumulate(uint8_t *samples, uint8_t n_samples)
     }
 }
 
+void AP_InertialSensor_MPU6000::_update_ext_sens_data(const uint8_t *data, uint8_t size)
+{
+    memcpy(_ext_sens_cache, data, size);
+    _ext_sens_cache_size = size;
+}
+
 void AP_InertialSensor_MPU6000::_read_fifo()
 {
     uint8_t n_samples;
     uint16_t bytes_read;
-    uint8_t rx[MAX_DATA_READ];
-
-    static_assert(MAX_DATA_READ <= 100, "Too big to keep on stack");
+    uint8_t rx[2];
+    const uint8_t sample_size = MPU6000_SAMPLE_SIZE + _fifo_ext_sens_size;
 
     if (!_block_read(MPUREG_FIFO_COUNTH, rx, 2)) {
         hal.console->printf("MPU60x0: error in fifo read\n");
@@ -515,40 +571,64 @@ void AP_InertialSensor_MPU6000::_read_fifo()
     }
 
     bytes_read = uint16_val(rx, 0);
-    n_samples = bytes_read / MPU6000_SAMPLE_SIZE;
 
-    if (n_samples == 0) {
-        /* Not enough data in FIFO */
+    /*
+      a FIFO count beyond the last whole sample means the FIFO has
+      overflowed and is no longer aligned on sample boundaries
+     */
+    if (bytes_read > (MPU6000_FIFO_SIZE / sample_size) * sample_size) {
+        hal.console->printf("MPU60x0: fifo overflow, %u bytes, dropping samples\n",
+                            bytes_read);
+
+        /* FIFO has overflowed, do a FIFO RESET to realign it */
+        _fifo_reset();
         return;
     }
 
-    if (n_samples > MPU6000_MAX_FIFO_SAMPLES) {
-        hal.console->printf("bytes_read = %u, n_samples %u > %u, dropping samples\n",
-                            bytes_read, n_samples, MPU6000_MAX_FIFO_SAMPLES);
+    n_samples = bytes_read / sample_size;
 
-        /* Too many samples, do a FIFO RESET */
-        _fifo_reset();
+    if (n_samples == 0) {
+        /* Not enough data in FIFO */
         return;
     }
 
-    if (!_block_read(MPUREG_FIFO_R_W, rx, n_samples * MPU6000_SAMPLE_SIZE)) {
+    /*
+      drain everything available in a single transfer, up to the size
+      of the buffer
+     */
+    if (n_samples > MAX_DATA_READ / sample_size) {
+        n_samples = MAX_DATA_READ / sample_size;
+    }
+
+    if (!_block_read(MPUREG_FIFO_R_W, _fifo_buffer, n_samples * sample_size)) {
         hal.console->printf("MPU60x0: error in fifo read %u bytes\n",
-                            n_samples * MPU6000_SAMPLE_SIZE);
+                            n_samples * sample_size);
         return;
     }
 
-    _accumulate(rx, n_samples);
+    _accumulate(_fifo_buffer, n_samples, sample_size);
+
+    if (_fifo_ext_sens_size > 0) {
+        _update_ext_sens_data(_fifo_buffer + (n_samples - 1) * sample_size + MPU6000_SAMPLE_SIZE,
+                              _fifo_ext_sens_size);
+    }
 }
 
 void AP_InertialSensor_MPU6000::_read_sample()
 {
-    /* one register address followed by seven 2-byte registers */
+    /*
+      one register address followed by seven 2-byte registers, then
+      the EXT_SENS_DATA registers of any auxiliary bus slaves
+     */
     struct PACKED {
         uint8_t int_status;
-        uint8_t d[14];
+        uint8_t d[MPU6000_SAMPLE_SIZE];
+        uint8_t ext_sens_data[MAX_EXT_SENS_DATA];
     } rx;
+    const uint8_t ext_sens_size = _auxiliary_bus ? _auxiliary_bus->_ext_sens_data : 0;
 
-    if (!_block_read(MPUREG_INT_STATUS, (uint8_t *) &rx, sizeof(rx))) {
+    if (!_block_read(MPUREG_INT_STATUS, (uint8_t *) &rx,
+                     1 + MPU6000_SAMPLE_SIZE + ext_sens_size)) {
         if (++_error_count > 4) {
             // TODO: set bus speed low for this (and only this) device
             hal.console->printf("MPU60x0: error reading sample\n");
@@ -556,7 +636,11 @@ void AP_InertialSensor_MPU6000::_read_sample()
         }
     }
 
-    _accumulate(rx.d, 1);
+    _accumulate(rx.d, 1, MPU6000_SAMPLE_SIZE);
+
+    if (ext_sens_size > 0) {
+        _update_ext_sens_data(rx.ext_sens_data, ext_sens_size);
+    }
 }
 
 bool AP_InertialSensor_MPU6000::_block_read(uint8_t reg, uint8_t *buf,
@@ -789,6 +873,16 @@ int AP_MPU6000_AuxiliaryBusSlave::read(uint8_t *buf)
     }
 
     auto &backend = AP_InertialSensor_MPU6000::from(_bus.get_backend());
+
+    /*
+      use the copy taken with the last gyro/accel sample if it covers
+      this slave, avoiding a separate bus transfer
+     */
+    if (_ext_sens_data + _sample_size <= backend._ext_sens_cache_size) {
+        memcpy(buf, &backend._ext_sens_cache[_ext_sens_data], _sample_size);
+        return _sample_size;
+    }
+
     if (!backend._block_read(MPUREG_EXT_SENS_DATA_00 + _ext_sens_data, buf, _sample_size)) {
         return -1;
     }
@@ -853,5 +947,10 @@ int AP_MPU6000_AuxiliaryBus::_configure_periodic_read(AuxiliaryBusSlave *slave,
     mpu_slave->_ext_sens_data = _ext_sens_data;
     _ext_sens_data += size;
 
+    auto &backend = AP_InertialSensor_MPU6000::from(_ins_backend);
+    if (backend._use_fifo) {
+        backend._fifo_add_slave(mpu_slave->_instance, size);
+    }
+
     return 0;
 }
@@ -18,6 +18,12 @@
 // enable debug to see a register dump on startup
 #define MPU6000_DEBUG 0
 
+// read SPI sensors through the FIFO as well as I2C ones, so that late
+// timer ticks drain all the samples queued since the last one
+#ifndef MPU6000_SPI_USE_FIFO
+#define MPU6000_SPI_USE_FIFO (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 class AP_MPU6000_AuxiliaryBus;
 class AP_MPU6000_AuxiliaryBusSlave;
 
@@ -65,6 +71,7 @@ private:
     void _set_filter_register(uint16_t filter_hz);
     void _fifo_reset();
     void _fifo_enable();
+    void _fifo_add_slave(uint8_t instance, uint8_t size);
     bool _has_auxiliary_bus();
 
     /* Read samples from FIFO (FIFO enabled) */
@@ -85,7 +92,10 @@ private:
     uint8_t _register_read(uint8_t reg);
     void _register_write(uint8_t reg, uint8_t val );
 
-    void _accumulate(uint8_t *samples, uint8_t n_samples);
+    void _accumulate(uint8_t *samples, uint8_t n_samples, uint8_t sample_size);
+
+    /* Keep a copy of the auxiliary bus data from the last sample */
+    void _update_ext_sens_data(const uint8_t *data, uint8_t size);
 
     // instance numbers of accel and gyro data
     uint8_t _gyro_instance;
@@ -101,6 +111,20 @@ private:
     AP_HAL::DigitalSource *_drdy_pin;
     AP_HAL::OwnPtr<AP_HAL::Device> _dev;
     AP_MPU6000_AuxiliaryBus *_auxiliary_bus;
+
+    // buffer for draining the FIFO in a single transfer
+    uint8_t *_fifo_buffer;
+
+    // FIFO bits enabled in MPUREG_FIFO_EN and bytes of auxiliary bus
+    // data appended to each FIFO sample
+    uint8_t _fifo_en;
+    uint8_t _fifo_ext_sens_size;
+
+    // copy of EXT_SENS_DATA taken in the same transfer as the last
+    // gyro/accel sample, handed to the auxiliary bus slaves
+    static const uint8_t MAX_EXT_SENS_DATA = 24;
+    uint8_t _ext_sens_cache[MAX_EXT_SENS_DATA];
+    uint8_t _ext_sens_cache_size;
 };
 
 class AP_MPU6000_AuxiliaryBusSlave : public AuxiliaryBusSlave
@@ -143,6 +167,6 @@ protected:
 private:
     void _configure_slaves();
 
-    static const uint8_t MAX_EXT_SENS_DATA = 24;
+    static const uint8_t MAX_EXT_SENS_DATA = AP_InertialSensor_MPU6000::MAX_EXT_SENS_DATA;
     uint8_t _ext_sens_data = 0;
 };
@@ -416,13 +416,19 @@ void AP_InertialSensor_MPU9250::_accumulate(uint8_t *rx)
  */
 void AP_InertialSensor_MPU9250::_read_sample()
 {
-    /* one register address followed by seven 2-byte registers */
+    /*
+      one register address followed by seven 2-byte registers, then
+      the EXT_SENS_DATA registers of any auxiliary bus slaves so the
+      compass sample comes in the same transfer
+     */
     struct PACKED {
         uint8_t int_status;
         uint8_t d[14];
+        uint8_t ext_sens_data[MAX_EXT_SENS_DATA];
     } rx;
+    const uint8_t ext_sens_size = _auxiliary_bus ? _auxiliary_bus->_ext_sens_data : 0;
 
-    if (!_block_read(MPUREG_INT_STATUS, (uint8_t *) &rx, sizeof(rx))) {
+    if (!_block_read(MPUREG_INT_STATUS, (uint8_t *) &rx, 1 + sizeof(rx.d) + ext_sens_size)) {
         hal.console->printf("MPU9250: error reading sample\n");
         return;
     }
@@ -432,6 +438,11 @@ void AP_InertialSensor_MPU9250::_read_sample()
     }
 
     _accumulate(rx.d);
+
+    if (ext_sens_size > 0) {
+        memcpy(_ext_sens_cache, rx.ext_sens_data, ext_sens_size);
+        _ext_sens_cache_size = ext_sens_size;
+    }
 }
 
 bool AP_InertialSensor_MPU9250::_block_read(uint8_t reg, uint8_t *buf,
@@ -635,6 +646,16 @@ int AP_MPU9250_AuxiliaryBusSlave::read(uint8_t *buf)
     }
 
     auto &backend = AP_InertialSensor_MPU9250::from(_bus.get_backend());
+
+    /*
+      use the copy taken with the last gyro/accel sample if it covers
+      this slave, avoiding a separate bus transfer
+     */
+    if (_ext_sens_data + _sample_size <= backend._ext_sens_cache_size) {
+        memcpy(buf, &backend._ext_sens_cache[_ext_sens_data], _sample_size);
+        return _sample_size;
+    }
+
     if (!backend._block_read(MPUREG_EXT_SENS_DATA_00 + _ext_sens_data, buf, _sample_size)) {
         return -1;
     }
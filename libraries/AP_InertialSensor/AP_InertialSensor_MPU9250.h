@@ -89,6 +89,12 @@ private:
 
     AP_HAL::OwnPtr<AP_HAL::Device> _dev;
     AP_MPU9250_AuxiliaryBus *_auxiliary_bus;
+
+    // copy of EXT_SENS_DATA taken in the same transfer as the last
+    // gyro/accel sample, handed to the auxiliary bus slaves
+    static const uint8_t MAX_EXT_SENS_DATA = 24;
+    uint8_t _ext_sens_cache[MAX_EXT_SENS_DATA];
+    uint8_t _ext_sens_cache_size;
 };
 
 class AP_MPU9250_AuxiliaryBusSlave : public AuxiliaryBusSlave
@@ -131,6 +137,6 @@ protected:
 private:
     void _configure_slaves();
 
-    static const uint8_t MAX_EXT_SENS_DATA = 24;
+    static const uint8_t MAX_EXT_SENS_DATA = AP_InertialSensor_MPU9250::MAX_EXT_SENS_DATA;
     uint8_t _ext_sens_data = 0;
 };
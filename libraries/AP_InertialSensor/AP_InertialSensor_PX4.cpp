@@ -77,6 +77,11 @@ bool AP_InertialSensor_PX4::_init_sensor(void)
         return false;
     }
 
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        _accel_slot[i] = i < _num_accel_instances ? _poll.add(_accel_fd[i]) : -1;
+        _gyro_slot[i] = i < _num_gyro_instances ? _poll.add(_gyro_fd[i]) : -1;
+    }
+
     for (uint8_t i=0; i<_num_gyro_instances; i++) {
         int fd = _gyro_fd[i];
         int devid = (ioctl(fd, DEVIOCGDEVICEID, 0) & 0x00FF0000)>>16;
@@ -261,56 +266,75 @@ void AP_InertialSensor_PX4::_new_gyro_sample(uint8_t i, gyro_report &gyro_report
 
 void AP_InertialSensor_PX4::_get_sample()
 {
+    // one poll() finds the drivers with new reports, so instances
+    // without any are not read
+    if (!_poll.wait(0)) {
+        return;
+    }
+
     for (uint8_t i=0; i<MAX(_num_accel_instances,_num_gyro_instances);i++) {
-        struct accel_report accel_report;
-        struct gyro_report gyro_report;
+        struct accel_report accel_report[PX4_INS_READ_BATCH];
+        struct gyro_report gyro_report[PX4_INS_READ_BATCH];
+
+        bool gyro_more = _poll.ready(_gyro_slot[i]);
+        bool accel_more = _poll.ready(_accel_slot[i]);
 
-        bool gyro_valid = _get_gyro_sample(i,gyro_report);
-        bool accel_valid = _get_accel_sample(i,accel_report);
+        while (gyro_more || accel_more) {
+            uint8_t num_gyro = gyro_more ? _get_gyro_samples(i, gyro_report, gyro_more) : 0;
+            uint8_t num_accel = accel_more ? _get_accel_samples(i, accel_report, accel_more) : 0;
 
-        while(gyro_valid || accel_valid) {
             // interleave accel and gyro samples by time - this will allow sculling corrections later
-            // check the next gyro measurement to see if it needs to be integrated first
-            if(gyro_valid && accel_valid && gyro_report.timestamp <= accel_report.timestamp) {
-                _new_gyro_sample(i,gyro_report);
-                gyro_valid = _get_gyro_sample(i,gyro_report);
-                continue;
-            }
-            // if not, try to integrate an accelerometer sample
-            if(accel_valid) {
-                _new_accel_sample(i,accel_report);
-                accel_valid = _get_accel_sample(i,accel_report);
-                continue;
-            }
-            // if not, we've only got gyro samples left in the buffer
-            if(gyro_valid) {
-                _new_gyro_sample(i,gyro_report);
-                gyro_valid = _get_gyro_sample(i,gyro_report);
+            uint8_t g = 0, a = 0;
+            while (g < num_gyro || a < num_accel) {
+                if (g < num_gyro &&
+                    (a >= num_accel || gyro_report[g].timestamp <= accel_report[a].timestamp)) {
+                    _new_gyro_sample(i, gyro_report[g++]);
+                } else {
+                    _new_accel_sample(i, accel_report[a++]);
+                }
             }
         }
     }
 }
 
-bool AP_InertialSensor_PX4::_get_accel_sample(uint8_t i, struct accel_report &accel_report) 
+uint8_t AP_InertialSensor_PX4::_get_accel_samples(uint8_t i, struct accel_report *accel_report, bool &more)
 {
-    if (i<_num_accel_instances && 
-        _accel_fd[i] != -1 && 
-        ::read(_accel_fd[i], &accel_report, sizeof(accel_report)) == sizeof(accel_report) && 
-        accel_report.timestamp != _last_accel_timestamp[i]) {
-        return true;
+    more = false;
+    if (i >= _num_accel_instances || _accel_fd[i] == -1) {
+        return 0;
+    }
+    ssize_t ret = ::read(_accel_fd[i], accel_report, sizeof(accel_report[0])*PX4_INS_READ_BATCH);
+    uint8_t n = ret > 0 ? ret / sizeof(accel_report[0]) : 0;
+    uint64_t last_timestamp = _last_accel_timestamp[i];
+    for (uint8_t r=0; r<n; r++) {
+        if (accel_report[r].timestamp == last_timestamp) {
+            // the driver repeats its latest report when it has no new one
+            return r;
+        }
+        last_timestamp = accel_report[r].timestamp;
     }
-    return false;
+    more = (n == PX4_INS_READ_BATCH);
+    return n;
 }
 
-bool AP_InertialSensor_PX4::_get_gyro_sample(uint8_t i, struct gyro_report &gyro_report) 
+uint8_t AP_InertialSensor_PX4::_get_gyro_samples(uint8_t i, struct gyro_report *gyro_report, bool &more)
 {
-    if (i<_num_gyro_instances && 
-        _gyro_fd[i] != -1 && 
-        ::read(_gyro_fd[i], &gyro_report, sizeof(gyro_report)) == sizeof(gyro_report) && 
-        gyro_report.timestamp != _last_gyro_timestamp[i]) {
-        return true;
+    more = false;
+    if (i >= _num_gyro_instances || _gyro_fd[i] == -1) {
+        return 0;
+    }
+    ssize_t ret = ::read(_gyro_fd[i], gyro_report, sizeof(gyro_report[0])*PX4_INS_READ_BATCH);
+    uint8_t n = ret > 0 ? ret / sizeof(gyro_report[0]) : 0;
+    uint64_t last_timestamp = _last_gyro_timestamp[i];
+    for (uint8_t r=0; r<n; r++) {
+        if (gyro_report[r].timestamp == last_timestamp) {
+            // the driver repeats its latest report when it has no new one
+            return r;
+        }
+        last_timestamp = gyro_report[r].timestamp;
     }
-    return false;
+    more = (n == PX4_INS_READ_BATCH);
+    return n;
 }
 
 #endif // CONFIG_HAL_BOARD
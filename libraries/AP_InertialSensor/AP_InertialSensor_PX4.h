@@ -12,6 +12,10 @@
 
 #include <Filter/Filter.h>
 #include <Filter/LowPassFilter2p.h>
+#include <AP_HAL/utility/PollSet.h>
+
+// reports taken from each driver queue per read()
+#define PX4_INS_READ_BATCH 8
 
 class AP_InertialSensor_PX4 : public AP_InertialSensor_Backend
 {
@@ -39,8 +43,10 @@ private:
     void _new_accel_sample(uint8_t i, accel_report &accel_report);
     void _new_gyro_sample(uint8_t i, gyro_report &gyro_report);
 
-    bool _get_gyro_sample(uint8_t i, struct gyro_report &gyro_report);
-    bool _get_accel_sample(uint8_t i, struct accel_report &accel_report);
+    // read up to PX4_INS_READ_BATCH new reports, setting more if the
+    // driver may have further reports queued
+    uint8_t _get_gyro_samples(uint8_t i, struct gyro_report *gyro_report, bool &more);
+    uint8_t _get_accel_samples(uint8_t i, struct accel_report *accel_report, bool &more);
 
     // calculate right queue depth for a sensor
     uint8_t _queue_depth(uint16_t sensor_sample_rate) const;
@@ -52,6 +58,11 @@ private:
     int _accel_fd[INS_MAX_INSTANCES];
     int _gyro_fd[INS_MAX_INSTANCES];
 
+    // all driver handles, polled together for new reports
+    PollSet _poll;
+    int8_t _accel_slot[INS_MAX_INSTANCES];
+    int8_t _gyro_slot[INS_MAX_INSTANCES];
+
     // indexes in frontend object. Note that these could be different
     // from the backend indexes
     uint8_t _accel_instance[INS_MAX_INSTANCES];
@@ -1,6 +1,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include "AP_InertialSensor_SITL.h"
 #include <SITL/SITL.h>
+#include <SITL/SIM_Noise.h>
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
 
@@ -116,7 +117,7 @@ void AP_InertialSensor_SITL::timer_update(void)
 // generate a random float between -1 and 1
 float AP_InertialSensor_SITL::rand_float(void)
 {
-    return ((((unsigned)random()) % 2000000) - 1.0e6) / 1.0e6;
+    return SITL::Noise::rand_float();
 }
 
 float AP_InertialSensor_SITL::gyro_drift(void)
@@ -31,8 +31,14 @@ AP_InertialSensor_Backend *AP_InertialSensor_QFLIGHT::detect(AP_InertialSensor &
 
 bool AP_InertialSensor_QFLIGHT::init_sensor(void) 
 {
-    gyro_instance = _imu.register_gyro(1000);
-    accel_instance = _imu.register_accel(1000);
+    // the DSP integrates the 1kHz samples and hands over about one
+    // per loop, so the per sample work here runs at the loop rate
+    uint32_t decimation = constrain_int32(1000 / get_sample_rate_hz(), 1, 10);
+    if (qflight_set_imu_decimation(decimation) != 0) {
+        decimation = 1;
+    }
+    gyro_instance = _imu.register_gyro(1000 / decimation);
+    accel_instance = _imu.register_accel(1000 / decimation);
 
     hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_QFLIGHT::timer_update, void));
     _product_id = AP_PRODUCT_ID_MPU9250;
@@ -55,10 +61,14 @@ void AP_InertialSensor_QFLIGHT::timer_update(void)
         DSPBuffer::IMU::BUF &b = imubuf->buf[i];
         Vector3f accel(b.accel[0], b.accel[1], b.accel[2]);
         Vector3f gyro(b.gyro[0], b.gyro[1], b.gyro[2]);
+        Vector3f delta_angle(b.delta_angle[0], b.delta_angle[1], b.delta_angle[2]);
+        Vector3f delta_velocity(b.delta_velocity[0], b.delta_velocity[1], b.delta_velocity[2]);
         _rotate_and_correct_accel(accel_instance, accel);
         _rotate_and_correct_gyro(gyro_instance, gyro);
-        _notify_new_accel_raw_sample(accel_instance, accel, b.timestamp);
-        _notify_new_gyro_raw_sample(gyro_instance, gyro, b.timestamp);
+        _rotate_and_correct_delta_velocity(accel_instance, delta_velocity, b.delta_time);
+        _rotate_and_correct_delta_angle(gyro_instance, delta_angle, b.delta_time);
+        _notify_new_accel_delta_sample(accel_instance, accel, delta_velocity, delta_angle, b.delta_time, b.timestamp);
+        _notify_new_gyro_delta_sample(gyro_instance, gyro, delta_angle, b.delta_time, b.timestamp);
     }
 }
 
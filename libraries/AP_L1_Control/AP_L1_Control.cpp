@@ -53,6 +53,18 @@ float AP_L1_Control::get_yaw()
 /*
   Wrap AHRS yaw sensor if in reverse - centi-degress
  */
+/*
+  unit vector along the vehicle heading, from the AHRS cached trig
+  values rather than a sinf/cosf of get_yaw()
+ */
+Vector2f AP_L1_Control::get_yaw_vector() const
+{
+    if (_reverse) {
+        return Vector2f(-_ahrs.cos_yaw(), -_ahrs.sin_yaw());
+    }
+    return Vector2f(_ahrs.cos_yaw(), _ahrs.sin_yaw());
+}
+
 float AP_L1_Control::get_yaw_sensor()
 {
     if (_reverse) {
@@ -175,18 +187,19 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
         return;
     }
 
-    Vector2f _groundspeed_vector = _ahrs.groundspeed_vector();
+    const AP_AHRS::nav_context &nav = _ahrs.get_nav_context();
+    Vector2f _groundspeed_vector = nav.groundspeed_vector;
 
     // update _target_bearing_cd
     _target_bearing_cd = get_bearing_cd(_current_loc, next_WP);
 
     //Calculate groundspeed
-    float groundSpeed = _groundspeed_vector.length();
+    float groundSpeed = nav.groundspeed;
     if (groundSpeed < 0.1f) {
         // use a small ground speed vector in the right direction,
         // allowing us to use the compass heading at zero GPS velocity
         groundSpeed = 0.1f;
-        _groundspeed_vector = Vector2f(cosf(get_yaw()), sinf(get_yaw())) * groundSpeed;
+        _groundspeed_vector = get_yaw_vector() * groundSpeed;
     }
 
     // Calculate time varying control parameters
@@ -194,16 +207,26 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
     // 0.3183099 = 1/1/pipi
     _L1_dist = 0.3183099f * _L1_damping * _L1_period * groundSpeed;
 
-    // Calculate the NE position of WP B relative to WP A
-    Vector2f AB = location_diff(prev_WP, next_WP);
-    float AB_length = AB.length();
+    // Calculate the NE position of WP B relative to WP A, which only
+    // changes with the waypoints
+    if (!_leg_valid ||
+        prev_WP.lat != _leg_prev.x || prev_WP.lng != _leg_prev.y ||
+        next_WP.lat != _leg_next.x || next_WP.lng != _leg_next.y) {
+        _leg_prev = Vector2l(prev_WP.lat, prev_WP.lng);
+        _leg_next = Vector2l(next_WP.lat, next_WP.lng);
+        _leg_AB = location_diff(prev_WP, next_WP);
+        _leg_length = _leg_AB.length();
+        _leg_valid = true;
+    }
+    Vector2f AB = _leg_AB;
+    float AB_length = _leg_length;
 
     // Check for AB zero length and track directly to the destination
     // if too small
-    if (AB.length() < 1.0e-6f) {
+    if (AB_length < 1.0e-6f) {
         AB = location_diff(_current_loc, next_WP);
         if (AB.length() < 1.0e-6f) {
-            AB = Vector2f(cosf(get_yaw()), sinf(get_yaw()));
+            AB = get_yaw_vector();
         }
     }
     AB.normalize();
@@ -307,10 +330,11 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
         return;
     }
 
-    Vector2f _groundspeed_vector = _ahrs.groundspeed_vector();
+    const AP_AHRS::nav_context &nav = _ahrs.get_nav_context();
+    const Vector2f &_groundspeed_vector = nav.groundspeed_vector;
 
     //Calculate groundspeed
-    float groundSpeed = MAX(_groundspeed_vector.length() , 1.0f);
+    float groundSpeed = MAX(nav.groundspeed, 1.0f);
 
 
     // update _target_bearing_cd
@@ -333,8 +357,8 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
     if (A_air.length() > 0.1f) {
         A_air_unit = A_air.normalized();
     } else {
-        if (_groundspeed_vector.length() < 0.1f) {
-            A_air_unit = Vector2f(cosf(_ahrs.yaw), sinf(_ahrs.yaw));
+        if (nav.groundspeed < 0.1f) {
+            A_air_unit = Vector2f(_ahrs.cos_yaw(), _ahrs.sin_yaw());
         } else {
             A_air_unit = _groundspeed_vector.normalized();
         }
@@ -414,10 +438,8 @@ void AP_L1_Control::update_heading_hold(int32_t navigation_heading_cd)
     Nu_cd = wrap_180_cd(Nu_cd);
     Nu = radians(Nu_cd * 0.01f);
 
-    Vector2f _groundspeed_vector = _ahrs.groundspeed_vector();
-
     //Calculate groundspeed
-    float groundSpeed = _groundspeed_vector.length();
+    float groundSpeed = _ahrs.get_nav_context().groundspeed;
 
     // Calculate time varying control parameters
     _L1_dist = groundSpeed / omegaA; // L1 distance is adjusted to maintain a constant tracking loop frequency
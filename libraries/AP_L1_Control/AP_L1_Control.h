@@ -113,7 +113,16 @@ private:
     uint32_t _last_update_waypoint_us;
     bool _data_is_stale = true;
 
+    // waypoints of the leg last seen by update_waypoint() and the
+    // vector between them, recomputed when the waypoints change
+    Vector2l _leg_prev;
+    Vector2l _leg_next;
+    Vector2f _leg_AB;
+    float _leg_length;
+    bool _leg_valid = false;
+
     bool _reverse = false;
     float get_yaw();
     float get_yaw_sensor();
+    Vector2f get_yaw_vector() const;
 };
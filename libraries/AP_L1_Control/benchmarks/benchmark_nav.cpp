@@ -0,0 +1,156 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_L1_Control/AP_L1_Control.h>
+#include <AP_TECS/AP_TECS.h>
+#include <AP_Vehicle/AP_Vehicle.h>
+
+/*
+  per call cost of the fixed wing navigation and speed/height
+  controllers. Each iteration is one 50Hz step of a fixed trace of a
+  plane flying a 200m circle while climbing, replayed through a stub
+  AHRS, so the controllers see a moving aircraft without reading
+  sensors
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define BM_LOOP_RATE_HZ     50
+#define BM_DT               (1.0f / BM_LOOP_RATE_HZ)
+// one lap of the circle
+#define BM_TRACE_LENGTH     (BM_LOOP_RATE_HZ * 60)
+#define BM_CIRCLE_RADIUS    200.0f
+#define BM_GROUND_SPEED     21.0f
+
+struct bm_state {
+    struct Location loc;
+    Vector3f velocity;
+};
+
+static bm_state trace[BM_TRACE_LENGTH];
+static struct Location prev_wp;
+static struct Location next_wp;
+
+static void make_trace()
+{
+    struct Location origin {};
+    origin.lat = -353632620;
+    origin.lng = 1491652370;
+    origin.alt = 58400;
+
+    for (uint16_t i = 0; i < BM_TRACE_LENGTH; i++) {
+        const float angle = 2 * M_PI * i / BM_TRACE_LENGTH;
+        bm_state &s = trace[i];
+        s.loc = origin;
+        location_offset(s.loc, BM_CIRCLE_RADIUS * cosf(angle), BM_CIRCLE_RADIUS * sinf(angle));
+        s.loc.alt += 1000.0f * i / BM_TRACE_LENGTH;
+        s.velocity = Vector3f(-BM_GROUND_SPEED * sinf(angle), BM_GROUND_SPEED * cosf(angle), -0.2f);
+    }
+
+    // a leg crossing the circle
+    prev_wp = origin;
+    location_offset(prev_wp, -500.0f, -500.0f);
+    next_wp = origin;
+    location_offset(next_wp, 500.0f, 500.0f);
+}
+
+// AHRS replaying the trace position and velocity
+class BM_AHRS : public AP_AHRS_DCM {
+public:
+    using AP_AHRS_DCM::AP_AHRS_DCM;
+
+    // as an AHRS update: new state, navigation values stale
+    void step(const bm_state &s) {
+        state = s;
+        invalidate_nav_context();
+    }
+
+    bool get_position(struct Location &loc) const override {
+        loc = state.loc;
+        return true;
+    }
+    Vector2f groundspeed_vector(void) override {
+        return Vector2f(state.velocity.x, state.velocity.y);
+    }
+    bool get_velocity_NED(Vector3f &vec) const override {
+        vec = state.velocity;
+        return true;
+    }
+
+    bm_state state;
+};
+
+static AP_InertialSensor ins;
+static AP_Baro baro;
+static AP_GPS gps;
+static BM_AHRS ahrs(ins, baro, gps);
+static AP_Vehicle::FixedWing aparm;
+static AP_L1_Control L1_controller(ahrs);
+static AP_TECS TECS_controller(ahrs, aparm);
+
+static void setup_once()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    make_trace();
+    aparm.airspeed_min.set(9);
+    aparm.airspeed_max.set(22);
+    aparm.throttle_max.set(75);
+    aparm.pitch_limit_max_cd.set(2000);
+    aparm.pitch_limit_min_cd.set(-2500);
+}
+
+// waypoint following alone
+static void BM_L1UpdateWaypoint(benchmark::State& state)
+{
+    setup_once();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        ahrs.step(trace[i]);
+        L1_controller.update_waypoint(prev_wp, next_wp);
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+}
+
+// speed and height control alone
+static void BM_TECSUpdate(benchmark::State& state)
+{
+    setup_once();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        ahrs.step(trace[i]);
+        TECS_controller.update_50hz();
+        TECS_controller.update_pitch_throttle(trace[0].loc.alt + 2000, 1200, AP_SpdHgtControl::FLIGHT_NORMAL,
+                                              false, 0.0f, -2500, 0, 100.0f, 1.0f);
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+}
+
+// one step of Plane's navigation stack: both controllers every
+// step, as Plane runs TECS at 50Hz and L1 at 10Hz sharing one AHRS
+// update
+static void BM_NavStep(benchmark::State& state)
+{
+    setup_once();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        ahrs.step(trace[i]);
+        TECS_controller.update_50hz();
+        if (i % 5 == 0) {
+            L1_controller.update_waypoint(prev_wp, next_wp);
+        }
+        TECS_controller.update_pitch_throttle(trace[0].loc.alt + 2000, 1200, AP_SpdHgtControl::FLIGHT_NORMAL,
+                                              false, 0.0f, -2500, 0, 100.0f, 1.0f);
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+}
+
+BENCHMARK(BM_L1UpdateWaypoint);
+BENCHMARK(BM_TECSUpdate);
+BENCHMARK(BM_NavStep);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,100 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_FFT.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+AP_FFT::AP_FFT() :
+    _size(0),
+    _log2_size(0),
+    _twiddle_cos(nullptr),
+    _twiddle_sin(nullptr)
+{
+}
+
+AP_FFT::~AP_FFT()
+{
+    free(_twiddle_cos);
+    free(_twiddle_sin);
+}
+
+bool AP_FFT::init(uint16_t size)
+{
+    if (size < 4 || size > 1024 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    float *twiddle_cos = (float *)calloc(size / 2, sizeof(float));
+    float *twiddle_sin = (float *)calloc(size / 2, sizeof(float));
+    if (twiddle_cos == nullptr || twiddle_sin == nullptr) {
+        free(twiddle_cos);
+        free(twiddle_sin);
+        return false;
+    }
+    for (uint16_t k=0; k<size/2; k++) {
+        const double angle = -2.0 * M_PI * k / size;
+        twiddle_cos[k] = cos(angle);
+        twiddle_sin[k] = sin(angle);
+    }
+    free(_twiddle_cos);
+    free(_twiddle_sin);
+    _twiddle_cos = twiddle_cos;
+    _twiddle_sin = twiddle_sin;
+    _size = size;
+    _log2_size = 0;
+    while ((1U << _log2_size) < size) {
+        _log2_size++;
+    }
+    return true;
+}
+
+void AP_FFT::transform(float *re, float *im) const
+{
+    if (_size == 0) {
+        return;
+    }
+
+    // bit reversal permutation
+    for (uint16_t i=0; i<_size; i++) {
+        uint16_t j = 0;
+        for (uint8_t b=0; b<_log2_size; b++) {
+            j |= ((i >> b) & 1U) << (_log2_size - 1 - b);
+        }
+        if (j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // butterflies, doubling the span each stage
+    for (uint16_t span=1; span<_size; span <<= 1) {
+        const uint16_t twiddle_step = _size / (2 * span);
+        for (uint16_t start=0; start<_size; start += 2 * span) {
+            for (uint16_t k=0; k<span; k++) {
+                const float wr = _twiddle_cos[k * twiddle_step];
+                const float wi = _twiddle_sin[k * twiddle_step];
+                const uint16_t a = start + k;
+                const uint16_t b = a + span;
+                const float tr = re[b] * wr - im[b] * wi;
+                const float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+  in-place radix-2 complex FFT of a fixed power of two size, with the
+  twiddle factors computed once at init. The output is unscaled, so a
+  sine of amplitude A in a real input of size N shows as magnitude
+  A*N/2 in its bin
+ */
+class AP_FFT {
+public:
+    AP_FFT();
+    ~AP_FFT();
+
+    // allocate for a transform of size points. Returns false if size
+    // is not a power of two between 4 and 1024 or allocation fails
+    bool init(uint16_t size);
+
+    uint16_t size(void) const { return _size; }
+
+    // transform re and im in place, both holding size() elements
+    void transform(float *re, float *im) const;
+
+private:
+    uint16_t _size;
+    uint8_t _log2_size;
+
+    // cos and sin of -2*pi*k/size for k < size/2
+    float *_twiddle_cos;
+    float *_twiddle_sin;
+};
@@ -14,6 +14,7 @@
  * You should have received a copy of the GNU General Public License along
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#pragma GCC optimize("O3")
 
 /*
  * This comment section explains the basic idea behind the implementation.
@@ -105,6 +106,9 @@
 
 #include "AP_GeodesicGrid.h"
 
+/* number of vectors classified together by sections() */
+#define GEODESIC_GRID_BATCH 16
+
 /* This was generated with
  * libraries/AP_Math/tools/geodesic_grid/geodesic_grid.py */
 const struct AP_GeodesicGrid::neighbor_umbrella
@@ -149,6 +153,24 @@ const Matrix3f AP_GeodesicGrid::_inverses[10]{
      {-0.190983f, -0.309017f, -0.500000f}},
 };
 
+AP_GeodesicGrid::triangle_normals AP_GeodesicGrid::_make_triangle_normals()
+{
+    /* The plane of T_i is where the coefficients sum to one, so its normal
+     * is the sum of the rows of the i-th inverse */
+    triangle_normals n;
+    for (uint8_t i = 0; i < 10; i++) {
+        const Vector3f sum = _inverses[i][0] + _inverses[i][1] + _inverses[i][2];
+        n.x[i] = sum.x;
+        n.y[i] = sum.y;
+        n.z[i] = sum.z;
+    }
+    return n;
+}
+
+/* _inverses is constant initialized, so it is ready before this */
+const AP_GeodesicGrid::triangle_normals
+AP_GeodesicGrid::_triangle_normals = AP_GeodesicGrid::_make_triangle_normals();
+
 /* This was generated with
  * libraries/AP_Math/tools/geodesic_grid/geodesic_grid.py */
 const Matrix3f AP_GeodesicGrid::_mid_inverses[10]{
@@ -199,6 +221,87 @@ int AP_GeodesicGrid::section(const Vector3f &v, bool inclusive)
     return 4 * i + j;
 }
 
+void AP_GeodesicGrid::sections(const Vector3f *v, int8_t *out, uint16_t count,
+                               bool inclusive)
+{
+    while (count > 0) {
+        const uint8_t len = MIN(count, GEODESIC_GRID_BATCH);
+
+        /* All faces of the icosahedron are at the same distance from the
+         * origin, so the face crossed by a vector is the one whose plane
+         * normal has the largest projection onto it. The opposite faces have
+         * opposite normals, so only T_0 to T_9 need checking. The projections
+         * and their maximum have no branches, so they are vectorized across
+         * the batch. */
+        float x[GEODESIC_GRID_BATCH], y[GEODESIC_GRID_BATCH], z[GEODESIC_GRID_BATCH];
+        for (uint8_t n = 0; n < len; n++) {
+            x[n] = v[n].x;
+            y[n] = v[n].y;
+            z[n] = v[n].z;
+        }
+        float d[10][GEODESIC_GRID_BATCH];
+        float best_abs[GEODESIC_GRID_BATCH];
+        for (uint8_t n = 0; n < len; n++) {
+            best_abs[n] = 0;
+        }
+        for (uint8_t k = 0; k < 10; k++) {
+            const float nx = _triangle_normals.x[k];
+            const float ny = _triangle_normals.y[k];
+            const float nz = _triangle_normals.z[k];
+            for (uint8_t n = 0; n < len; n++) {
+                d[k][n] = nx * x[n] + ny * y[n] + nz * z[n];
+                best_abs[n] = MAX(best_abs[n], fabsf(d[k][n]));
+            }
+        }
+        uint8_t best[GEODESIC_GRID_BATCH];
+        float best_d[GEODESIC_GRID_BATCH];
+        for (uint8_t n = 0; n < len; n++) {
+            uint8_t k = 0;
+            while (k < 9 && fabsf(d[k][n]) != best_abs[n]) {
+                k++;
+            }
+            best[n] = k;
+            best_d[n] = d[k][n];
+        }
+
+        for (uint8_t n = 0; n < len; n++) {
+            /* Confirm the vector is strictly inside that triangle and not on
+             * the edge of a sub-triangle, counting only values is_zero()
+             * would not treat as zero. In that case the section is unique, so
+             * it is the one section() finds. Otherwise, fall back to it. */
+            const uint8_t t = best[n];
+            const float sign = best_d[n] < 0 ? -1.0f : 1.0f;
+            const Matrix3f &m = _inverses[t];
+            const Matrix3f &mid = _mid_inverses[t];
+            const Vector3f &p = v[n];
+            const float w0 = sign * (m.a.x * p.x + m.a.y * p.y + m.a.z * p.z);
+            const float w1 = sign * (m.b.x * p.x + m.b.y * p.y + m.b.z * p.z);
+            const float w2 = sign * (m.c.x * p.x + m.c.y * p.y + m.c.z * p.z);
+            const float u0 = sign * (mid.a.x * p.x + mid.a.y * p.y + mid.a.z * p.z);
+            const float u1 = sign * (mid.b.x * p.x + mid.b.y * p.y + mid.b.z * p.z);
+            const float u2 = sign * (mid.c.x * p.x + mid.c.y * p.y + mid.c.z * p.z);
+            const bool clear = w0 >= FLT_EPSILON && w1 >= FLT_EPSILON && w2 >= FLT_EPSILON &&
+                               fabsf(u0) >= FLT_EPSILON && fabsf(u1) >= FLT_EPSILON &&
+                               fabsf(u2) >= FLT_EPSILON;
+
+            /* same sub-triangle rules as _subtriangle_index() */
+            const int j = u0 < 0 ? 3 : u1 < 0 ? 1 : u2 < 0 ? 2 : 0;
+            const int i = best_d[n] < 0 ? t + 10 : t;
+            out[n] = clear ? 4 * i + j : -2;
+        }
+        for (uint8_t n = 0; n < len; n++) {
+            if (out[n] == -2) {
+                /* on or near an edge, or the null vector */
+                out[n] = section(v[n], inclusive);
+            }
+        }
+
+        v += len;
+        out += len;
+        count -= len;
+    }
+}
+
 int AP_GeodesicGrid::_neighbor_umbrella_component(int idx, int comp_idx)
 {
     if (idx < 3) {
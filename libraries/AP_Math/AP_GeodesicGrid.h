@@ -125,6 +125,27 @@ public:
      */
     static int section(const Vector3f &v, bool inclusive = false);
 
+    /**
+     * Find which section is crossed by each vector of an array. The result
+     * for each vector is the same as from section().
+     *
+     * The icosahedron triangle is found by projecting each vector onto all
+     * triangle normals at once, which has no branches and can be vectorized,
+     * instead of walking the neighbor umbrellas. Vectors on or near an edge
+     * or vertex fall back to section().
+     *
+     * @param v[in] The vectors to be verified.
+     *
+     * @param out[out] The section index for each vector, or -1 as for
+     * section().
+     *
+     * @param count[in] The number of vectors in \p v and \p out.
+     *
+     * @param inclusive[in] Same as for section().
+     */
+    static void sections(const Vector3f *v, int8_t *out, uint16_t count,
+                         bool inclusive = false);
+
 private:
     /*
      * The following are concepts used in the description of the private
@@ -178,6 +199,21 @@ private:
      */
     static const Matrix3f _mid_inverses[10];
 
+    /**
+     * The normals of the planes of T_0 to T_9, with the same length for
+     * all, stored by component so the compiler can vectorize their dot
+     * products with a vector. The i-th normal is the sum of the rows of the
+     * i-th element of #_inverses, and the normal of T_(i+10) is its
+     * opposite.
+     */
+    static const struct triangle_normals {
+        float x[10];
+        float y[10];
+        float z[10];
+    } _triangle_normals;
+
+    static triangle_normals _make_triangle_normals();
+
     /**
      * The representation of the neighbor umbrellas of T_0.
      *
@@ -66,6 +66,41 @@ float linear_interpolate(float low_output, float high_output,
     return low_output + p * (high_output - low_output);
 }
 
+/*
+  split the ratio into m * 2^e with m in [0.5,1). m^0.190259 comes
+  from a degree 7 Chebyshev fit over [0.5,1) and 2^(0.190259*e) from
+  a table
+ */
+float pressure_ratio_pow(float pressure_ratio)
+{
+    static const int8_t exp_min = -16;
+    static const float exp_pow[] = {
+        0.121233135f, 0.138323188f, 0.157822415f, 0.1800704f,  0.205454662f,
+        0.234417304f, 0.26746276f,  0.305166602f, 0.34818548f, 0.397268683f,
+        0.453271061f, 0.517168045f, 0.590072453f, 0.673254073f, 0.768161714f,
+        0.876448333f, 1.0f,         1.14096856f,  1.30180919f, 1.48532331f,
+        1.69470716f,  1.93360758f,  2.20618534f,  2.51718807f, 2.8720324f
+    };
+
+    int e;
+    const float m = frexpf(pressure_ratio, &e);
+    if (!(pressure_ratio > 0) || isinf(pressure_ratio) ||
+        e < exp_min || e >= exp_min + (int)ARRAY_SIZE(exp_pow)) {
+        return expf(0.190259f * logf(pressure_ratio));
+    }
+
+    const float t = (m - 0.75f) * 4;
+    float p = 8.49682965e-06f;
+    p = p * t - 3.04870136e-05f;
+    p = p * t + 9.60314937e-05f;
+    p = p * t - 0.000378531258f;
+    p = p * t + 0.00162955443f;
+    p = p * t - 0.00810364727f;
+    p = p * t + 0.0600417294f;
+    p = p * t + 0.946736872f;
+    return p * exp_pow[e - exp_min];
+}
+
 template <class T>
 float wrap_180(const T angle, float unit_mod)
 {
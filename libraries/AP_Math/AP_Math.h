@@ -59,11 +59,15 @@ bool inverse3x3(float m[], float invOut[]);
 // invOut is an inverted 3x3 matrix when returns true, otherwise matrix is Singular
 bool inverse4x4(float m[],float invOut[]);
 
-// matrix multiplication of two NxN matrices
-float *mat_mul(float *A, float *B, uint8_t n);
+// matrix multiplication of two NxN matrices into out
+void mat_mul(const float *A, const float *B, float *out, uint8_t n);
 
-// matrix algebra
+// largest matrix inverse() can handle without a caller supplied workspace
+#define MATRIX_ALG_MAX_DIM 9
+
+// matrix algebra. None of these allocate memory
 bool inverse(float x[], float y[], uint16_t dim);
+bool inverse(const float x[], float y[], uint16_t dim, float workspace[]);
 
 /*
  * Constrain an angle to be within the range: -180 to 180 degrees. The second
@@ -212,3 +216,10 @@ inline uint32_t usec_to_hz(uint32_t usec)
 float linear_interpolate(float low_output, float high_output,
                          float var_value,
                          float var_low, float var_high);
+
+/*
+  pressure_ratio^0.190259, the exponent of the barometric altitude
+  formula, without calling expf() and logf(). Within 2e-7 of the exact
+  value for ratios from 2^-17 to 2^8, library result outside that
+ */
+float pressure_ratio_pow(float pressure_ratio);
@@ -98,4 +98,51 @@ static void BM_GeodesicGridSections(benchmark::State& state)
 /* Benchmark each section */
 BENCHMARK(BM_GeodesicGridSections)->DenseRange(0, 79);
 
+/* Pseudo-random vectors, like a set of calibration samples. Unlike a
+ * repeated sequence of centroids their branches can't be learned by the
+ * branch predictor */
+#define BM_NUM_VECTORS 300
+
+static void fill_vectors(Vector3f v[BM_NUM_VECTORS])
+{
+    uint32_t seed = 1;
+    for (unsigned int i = 0; i < BM_NUM_VECTORS; i++) {
+        float c[3];
+        for (unsigned int k = 0; k < 3; k++) {
+            seed = seed * 1103515245 + 12345;
+            c[k] = (int16_t)(seed >> 16) / 100.0f;
+        }
+        v[i] = Vector3f(c[0], c[1], c[2]);
+    }
+}
+
+static void BM_GeodesicGridSectionLoop(benchmark::State& state)
+{
+    Vector3f v[BM_NUM_VECTORS];
+    int8_t out[BM_NUM_VECTORS];
+    fill_vectors(v);
+
+    while (state.KeepRunning()) {
+        for (unsigned int i = 0; i < BM_NUM_VECTORS; i++) {
+            out[i] = AP_GeodesicGrid::section(v[i]);
+        }
+        gbenchmark_escape(out);
+    }
+}
+
+static void BM_GeodesicGridSectionsBatch(benchmark::State& state)
+{
+    Vector3f v[BM_NUM_VECTORS];
+    int8_t out[BM_NUM_VECTORS];
+    fill_vectors(v);
+
+    while (state.KeepRunning()) {
+        AP_GeodesicGrid::sections(v, out, BM_NUM_VECTORS);
+        gbenchmark_escape(out);
+    }
+}
+
+BENCHMARK(BM_GeodesicGridSectionLoop);
+BENCHMARK(BM_GeodesicGridSectionsBatch);
+
 BENCHMARK_MAIN()
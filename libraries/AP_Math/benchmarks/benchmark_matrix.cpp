@@ -1,6 +1,7 @@
 #include <AP_gbenchmark.h>
 
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/matrixN.h>
 
 static void BM_MatrixMultiplication(benchmark::State& state)
 {
@@ -19,4 +20,173 @@ static void BM_MatrixMultiplication(benchmark::State& state)
 
 BENCHMARK(BM_MatrixMultiplication);
 
+/*
+  the small kernels used every loop by the AHRS, EKF output predictor
+  and attitude controllers
+ */
+static void BM_MatrixVectorMultiplication(benchmark::State& state)
+{
+    Matrix3f m;
+    m.from_euler(0.3f, -0.7f, 2.1f);
+    Vector3f v(1.0f, 2.0f, 3.0f);
+
+    while (state.KeepRunning()) {
+        v = m * v;
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_MatrixMulTranspose(benchmark::State& state)
+{
+    Matrix3f m;
+    m.from_euler(0.3f, -0.7f, 2.1f);
+    Vector3f v(1.0f, 2.0f, 3.0f);
+
+    while (state.KeepRunning()) {
+        v = m.mul_transpose(v);
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_MatrixRotateNormalize(benchmark::State& state)
+{
+    Matrix3f m;
+    m.from_euler(0.3f, -0.7f, 2.1f);
+    const Vector3f g(0.001f, -0.002f, 0.0005f);
+
+    while (state.KeepRunning()) {
+        m.rotate(g);
+        m.normalize();
+        gbenchmark_escape(&m);
+    }
+}
+
+static void BM_VectorExpression(benchmark::State& state)
+{
+    Vector3f a(1.0f, 2.0f, 3.0f), b(-0.5f, 0.25f, 4.0f);
+    const float dt = 0.0025f;
+
+    while (state.KeepRunning()) {
+        a += (a % b) * dt - b * (a * b) * dt;
+        gbenchmark_escape(&a);
+    }
+}
+
+static void BM_QuaternionMultiplication(benchmark::State& state)
+{
+    Quaternion q1, q2;
+    q1.from_euler(0.3f, -0.7f, 2.1f);
+    q2.from_euler(0.001f, -0.002f, 0.0005f);
+
+    while (state.KeepRunning()) {
+        q1 *= q2;
+        gbenchmark_escape(&q1);
+    }
+}
+
+static void BM_QuaternionEarthToBody(benchmark::State& state)
+{
+    Quaternion q;
+    q.from_euler(0.3f, -0.7f, 2.1f);
+    Vector3f v(1.0f, 2.0f, 3.0f);
+
+    while (state.KeepRunning()) {
+        q.earth_to_body(v);
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_QuaternionRotateNormalize(benchmark::State& state)
+{
+    Quaternion q;
+    q.from_euler(0.3f, -0.7f, 2.1f);
+    const Vector3f g(0.001f, -0.002f, 0.0005f);
+
+    while (state.KeepRunning()) {
+        q.rotate_fast(g);
+        q.normalize();
+        gbenchmark_escape(&q);
+    }
+}
+
+BENCHMARK(BM_MatrixVectorMultiplication);
+BENCHMARK(BM_MatrixMulTranspose);
+BENCHMARK(BM_MatrixRotateNormalize);
+BENCHMARK(BM_VectorExpression);
+BENCHMARK(BM_QuaternionMultiplication);
+BENCHMARK(BM_QuaternionEarthToBody);
+BENCHMARK(BM_QuaternionRotateNormalize);
+
+/*
+  compare the runtime sized inverse() with the fixed size MatrixN
+  kernels, at the sizes used by the compass calibrator
+ */
+
+template <uint8_t N>
+static void fill_spd(float m[N*N])
+{
+    for (uint8_t i=0; i<N; i++) {
+        for (uint8_t j=0; j<N; j++) {
+            m[i*N+j] = (i == j) ? (N + 1.0f + i) : 1.0f / (1 + i + j);
+        }
+    }
+}
+
+template <uint8_t N>
+static void BM_InverseRuntime(benchmark::State& state)
+{
+    float m[N*N], inv[N*N];
+    fill_spd<N>(m);
+
+    while (state.KeepRunning()) {
+        bool ret = inverse(m, inv, N);
+        gbenchmark_escape(&ret);
+        gbenchmark_escape(inv);
+    }
+}
+
+template <uint8_t N>
+static void BM_InverseMatrixN(benchmark::State& state)
+{
+    float a[N*N];
+    fill_spd<N>(a);
+    MatrixN<float,N,N> m, inv;
+    m.from_array(a);
+
+    while (state.KeepRunning()) {
+        bool ret = m.inverse(inv);
+        gbenchmark_escape(&ret);
+        gbenchmark_escape(&inv);
+    }
+}
+
+// solving directly, as a Levenberg-Marquardt step needs, rather than
+// inverting then multiplying
+template <uint8_t N>
+static void BM_CholeskySolveMatrixN(benchmark::State& state)
+{
+    float a[N*N], b[N], x[N];
+    fill_spd<N>(a);
+    for (uint8_t i=0; i<N; i++) {
+        b[i] = i;
+    }
+    MatrixN<float,N,N> m;
+    m.from_array(a);
+
+    while (state.KeepRunning()) {
+        MatrixN<float,N,N> l = m;
+        bool ret = l.cholesky_decompose();
+        l.cholesky_solve(b, x);
+        gbenchmark_escape(&ret);
+        gbenchmark_escape(x);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_InverseRuntime, 4);
+BENCHMARK_TEMPLATE(BM_InverseMatrixN, 4);
+BENCHMARK_TEMPLATE(BM_CholeskySolveMatrixN, 4);
+BENCHMARK_TEMPLATE(BM_InverseRuntime, 9);
+BENCHMARK_TEMPLATE(BM_InverseMatrixN, 9);
+BENCHMARK_TEMPLATE(BM_CholeskySolveMatrixN, 9);
+
 BENCHMARK_MAIN()
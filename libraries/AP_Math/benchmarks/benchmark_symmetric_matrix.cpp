@@ -0,0 +1,117 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/symmatrixN.h>
+
+/*
+  compare ways of forming a symmetric 24x24 covariance prediction of
+  the form P' = F*P*F^T + Q, as done by the EKF
+ */
+
+#define BM_SYM_N 24
+
+typedef float SymMatrix24[BM_SYM_N][BM_SYM_N];
+
+static void fill_inputs(SymMatrix24 &F, SymMatrix24 &P)
+{
+    for (uint8_t i=0; i<BM_SYM_N; i++) {
+        for (uint8_t j=0; j<BM_SYM_N; j++) {
+            F[i][j] = (i == j) ? 1.0f : 0.01f * (i + 2*j) / BM_SYM_N;
+            P[i][j] = (i == j) ? 1.0f + i : 0.001f * (i + j);
+        }
+    }
+}
+
+// element (i,j) of F*P*F^T
+static inline float fpft(const SymMatrix24 &F, const SymMatrix24 &P, uint8_t i, uint8_t j)
+{
+    float sum = 0.0f;
+    for (uint8_t k=0; k<BM_SYM_N; k++) {
+        float fp = 0.0f;
+        for (uint8_t l=0; l<BM_SYM_N; l++) {
+            fp += F[i][l] * P[l][k];
+        }
+        sum += fp * F[j][k];
+    }
+    return sum;
+}
+
+// compute every element, then average the two triangles to force symmetry
+static void BM_CovPredictFull(benchmark::State& state)
+{
+    SymMatrix24 F, P, nextP;
+    fill_inputs(F, P);
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<BM_SYM_N; i++) {
+            for (uint8_t j=0; j<BM_SYM_N; j++) {
+                nextP[i][j] = fpft(F, P, i, j);
+            }
+        }
+        for (uint8_t i=1; i<BM_SYM_N; i++) {
+            for (uint8_t j=0; j<i; j++) {
+                float temp = 0.5f*(nextP[i][j] + nextP[j][i]);
+                nextP[i][j] = nextP[j][i] = temp;
+            }
+        }
+        for (uint8_t i=0; i<BM_SYM_N; i++) {
+            nextP[i][i] += 1e-6f;
+        }
+        memcpy(P, nextP, sizeof(P));
+        gbenchmark_escape(&P);
+    }
+}
+
+// compute the upper triangle only, mirror it then copy
+static void BM_CovPredictUpperMirror(benchmark::State& state)
+{
+    SymMatrix24 F, P, nextP;
+    fill_inputs(F, P);
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<BM_SYM_N; i++) {
+            for (uint8_t j=i; j<BM_SYM_N; j++) {
+                nextP[i][j] = fpft(F, P, i, j);
+            }
+        }
+        for (uint8_t i=1; i<BM_SYM_N; i++) {
+            for (uint8_t j=0; j<i; j++) {
+                nextP[i][j] = nextP[j][i];
+            }
+        }
+        for (uint8_t i=0; i<BM_SYM_N; i++) {
+            nextP[i][i] += 1e-6f;
+        }
+        memcpy(P, nextP, sizeof(P));
+        gbenchmark_escape(&P);
+    }
+}
+
+// compute the upper triangle into packed storage and mirror it while
+// copying out, as NavEKF2 does
+static void BM_CovPredictPacked(benchmark::State& state)
+{
+    SymMatrix24 F, P;
+    SymMatrixN<float,BM_SYM_N> nextP;
+    fill_inputs(F, P);
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<BM_SYM_N; i++) {
+            float *row = nextP.upper_row(i);
+            for (uint8_t j=i; j<BM_SYM_N; j++) {
+                row[j-i] = fpft(F, P, i, j);
+            }
+        }
+        for (uint8_t i=0; i<BM_SYM_N; i++) {
+            nextP(i,i) += 1e-6f;
+        }
+        nextP.to_full(P);
+        gbenchmark_escape(&P);
+    }
+}
+
+BENCHMARK(BM_CovPredictFull);
+BENCHMARK(BM_CovPredictUpperMirror);
+BENCHMARK(BM_CovPredictPacked);
+
+BENCHMARK_MAIN()
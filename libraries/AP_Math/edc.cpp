@@ -55,3 +55,16 @@ uint16_t crc16_ccitt(const uint8_t *buf, uint32_t len, uint16_t crc)
         crc = (crc << 8) ^ crc16tab[((crc >> 8) ^ *buf++) & 0x00FF];
     return crc;
 }
+
+/* bitwise CRC32, slower than a table but costs no flash */
+uint32_t crc_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
@@ -20,3 +20,9 @@
 #include <inttypes.h>
 
 uint16_t crc16_ccitt(const uint8_t *buf, uint32_t len, uint16_t crc);
+
+/*
+  standard (zlib) CRC32. Start with crc=0, and pass the previous
+  result to continue a CRC over several buffers
+ */
+uint32_t crc_crc32(uint32_t crc, const uint8_t *buf, uint32_t len);
@@ -148,6 +148,40 @@ Vector2f location_diff(const struct Location &loc1, const struct Location &loc2)
                     (loc2.lng - loc1.lng) * LOCATION_SCALING_FACTOR * longitude_scale(loc1));
 }
 
+/*
+  set the projection origin, keeping the cached longitude scale while
+  the latitude stays within about 1km of where it was computed, as
+  longitude_scale() does on slower CPUs
+ */
+bool Location_Projector::set_origin(const struct Location &origin)
+{
+    _origin_lat = origin.lat;
+    _origin_lng = origin.lng;
+    if (_have_origin && labs(_scale_lat - origin.lat) < 100000) {
+        return false;
+    }
+    const float scale = constrain_float(cosf(origin.lat * 1.0e-7f * DEG_TO_RAD), 0.01f, 1.0f);
+    _scale_lat = origin.lat;
+    _lat_scale = LOCATION_SCALING_FACTOR;
+    _lng_scale = LOCATION_SCALING_FACTOR * scale;
+    _have_origin = true;
+    return true;
+}
+
+void Location_Projector::project(const struct Location *locs, Vector2f *ne, uint16_t count) const
+{
+    for (uint16_t i = 0; i < count; i++) {
+        ne[i].x = (locs[i].lat - _origin_lat) * _lat_scale;
+        ne[i].y = (locs[i].lng - _origin_lng) * _lng_scale;
+    }
+}
+
+void Location_Projector::unproject(const Vector2f &ne, struct Location &loc) const
+{
+    loc.lat = _origin_lat + (int32_t)(ne.x / _lat_scale);
+    loc.lng = _origin_lng + (int32_t)(ne.y / _lng_scale);
+}
+
 /*
   return true if lat and lng match. Ignores altitude and options
  */
@@ -88,3 +88,49 @@ bool        check_latlng(float lat, float lng);
 bool        check_latlng(int32_t lat, int32_t lng);
 bool        check_latlng(Location loc);
 
+
+/*
+  projection of locations onto a local North/East plane around an
+  origin. The longitude scale is cached so converting each location
+  costs two multiplies instead of a cosine, which pays off when many
+  locations are compared against the same one. The origin can be moved
+  every update; the cosine is only recomputed once the latitude has
+  moved far enough to matter
+ */
+class Location_Projector {
+public:
+    // set the origin. Returns true if the longitude scale was recomputed
+    bool set_origin(const struct Location &origin);
+
+    bool have_origin() const { return _have_origin; }
+
+    // North/East offset in meters from the origin to a location
+    Vector2f project(int32_t lat, int32_t lng) const {
+        return Vector2f((lat - _origin_lat) * _lat_scale,
+                        (lng - _origin_lng) * _lng_scale);
+    }
+    Vector2f project(const struct Location &loc) const {
+        return project(loc.lat, loc.lng);
+    }
+
+    // project count locations into ne
+    void project(const struct Location *locs, Vector2f *ne, uint16_t count) const;
+
+    // distance in meters from the origin to a location
+    float get_distance(const struct Location &loc) const {
+        return project(loc).length();
+    }
+
+    // set the latitude and longitude of loc to a North/East offset
+    // in meters from the origin
+    void unproject(const Vector2f &ne, struct Location &loc) const;
+
+private:
+    bool _have_origin = false;
+    int32_t _origin_lat;
+    int32_t _origin_lng;
+    // latitude the longitude scale was computed at
+    int32_t _scale_lat;
+    float _lat_scale;
+    float _lng_scale;
+};
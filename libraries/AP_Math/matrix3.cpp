@@ -101,18 +101,24 @@ void Matrix3<T>::from_euler312(float roll, float pitch, float yaw)
 template <typename T>
 void Matrix3<T>::rotate(const Vector3<T> &g)
 {
-    Matrix3<T> temp_matrix;
-    temp_matrix.a.x = a.y * g.z - a.z * g.y;
-    temp_matrix.a.y = a.z * g.x - a.x * g.z;
-    temp_matrix.a.z = a.x * g.y - a.y * g.x;
-    temp_matrix.b.x = b.y * g.z - b.z * g.y;
-    temp_matrix.b.y = b.z * g.x - b.x * g.z;
-    temp_matrix.b.z = b.x * g.y - b.y * g.x;
-    temp_matrix.c.x = c.y * g.z - c.z * g.y;
-    temp_matrix.c.y = c.z * g.x - c.x * g.z;
-    temp_matrix.c.z = c.x * g.y - c.y * g.x;
+    // each row only depends on itself, so it can be updated in place
+    // one row at a time without a temporary matrix
+    a += a % g;
+    b += b % g;
+    c += c % g;
+}
 
-    (*this) += temp_matrix;
+template <typename T>
+void Matrix3<T>::from_rotation(enum Rotation rotation)
+{
+    // the columns are the rotated unit vectors
+    Vector3<T> x(1, 0, 0), y(0, 1, 0), z(0, 0, 1);
+    x.rotate(rotation);
+    y.rotate(rotation);
+    z.rotate(rotation);
+    a = Vector3<T>(x.x, y.x, z.x);
+    b = Vector3<T>(x.y, y.y, z.y);
+    c = Vector3<T>(x.z, y.z, z.z);
 }
 
 /*
@@ -130,15 +136,6 @@ void Matrix3<T>::normalize(void)
     c = t2 * (1.0f / t2.length());
 }
 
-// multiplication by a vector
-template <typename T>
-Vector3<T> Matrix3<T>::operator *(const Vector3<T> &v) const
-{
-    return Vector3<T>(a.x * v.x + a.y * v.y + a.z * v.z,
-                      b.x * v.x + b.y * v.y + b.z * v.z,
-                      c.x * v.x + c.y * v.y + c.z * v.z);
-}
-
 // multiplication by a vector, extracting only the xy components
 template <typename T>
 Vector2<T> Matrix3<T>::mulXY(const Vector3<T> &v) const
@@ -147,15 +144,6 @@ Vector2<T> Matrix3<T>::mulXY(const Vector3<T> &v) const
                       b.x * v.x + b.y * v.y + b.z * v.z);
 }
 
-// multiplication of transpose by a vector
-template <typename T>
-Vector3<T> Matrix3<T>::mul_transpose(const Vector3<T> &v) const
-{
-    return Vector3<T>(a.x * v.x + b.x * v.y + c.x * v.z,
-                      a.y * v.x + b.y * v.y + c.y * v.z,
-                      a.z * v.x + b.z * v.y + c.z * v.z);
-}
-
 // multiplication by another Matrix3<T>
 template <typename T>
 Matrix3<T> Matrix3<T>::operator *(const Matrix3<T> &m) const
@@ -258,13 +246,12 @@ void Matrix3<T>::from_axis_angle(const Vector3<T> &v, float theta)
 template void Matrix3<float>::zero(void);
 template void Matrix3<float>::rotate(const Vector3<float> &g);
 template void Matrix3<float>::normalize(void);
+template void Matrix3<float>::from_rotation(enum Rotation rotation);
 template void Matrix3<float>::from_euler(float roll, float pitch, float yaw);
 template void Matrix3<float>::to_euler(float *roll, float *pitch, float *yaw) const;
 template void Matrix3<float>::from_euler312(float roll, float pitch, float yaw);
 template void Matrix3<float>::from_axis_angle(const Vector3<float> &v, float theta);
 template Vector3<float> Matrix3<float>::to_euler312(void) const;
-template Vector3<float> Matrix3<float>::operator *(const Vector3<float> &v) const;
-template Vector3<float> Matrix3<float>::mul_transpose(const Vector3<float> &v) const;
 template Matrix3<float> Matrix3<float>::operator *(const Matrix3<float> &m) const;
 template Matrix3<float> Matrix3<float>::transposed(void) const;
 template float Matrix3<float>::det() const;
@@ -274,10 +261,9 @@ template Vector2<float> Matrix3<float>::mulXY(const Vector3<float> &v) const;
 
 template void Matrix3<double>::zero(void);
 template void Matrix3<double>::rotate(const Vector3<double> &g);
+template void Matrix3<double>::from_rotation(enum Rotation rotation);
 template void Matrix3<double>::from_euler(float roll, float pitch, float yaw);
 template void Matrix3<double>::to_euler(float *roll, float *pitch, float *yaw) const;
-template Vector3<double> Matrix3<double>::operator *(const Vector3<double> &v) const;
-template Vector3<double> Matrix3<double>::mul_transpose(const Vector3<double> &v) const;
 template Matrix3<double> Matrix3<double>::operator *(const Matrix3<double> &m) const;
 template Matrix3<double> Matrix3<double>::transposed(void) const;
 template double Matrix3<double>::det() const;
@@ -145,10 +145,18 @@ public:
     }
 
     // multiplication by a vector
-    Vector3<T> operator         *(const Vector3<T> &v) const;
+    Vector3<T> operator         *(const Vector3<T> &v) const {
+        return Vector3<T>(a.x * v.x + a.y * v.y + a.z * v.z,
+                          b.x * v.x + b.y * v.y + b.z * v.z,
+                          c.x * v.x + c.y * v.y + c.z * v.z);
+    }
 
     // multiplication of transpose by a vector
-    Vector3<T>                  mul_transpose(const Vector3<T> &v) const;
+    Vector3<T>                  mul_transpose(const Vector3<T> &v) const {
+        return Vector3<T>(a.x * v.x + b.x * v.y + c.x * v.z,
+                          a.y * v.x + b.y * v.y + c.y * v.z,
+                          a.z * v.x + b.z * v.y + c.z * v.z);
+    }
 
     // multiplication by a vector giving a Vector2 result (XY components)
     Vector2<T> mulXY(const Vector3<T> &v) const;
@@ -251,6 +259,11 @@ public:
     // to a rotation matrix.
     void        rotate(const Vector3<T> &g);
 
+    // create the matrix equivalent of one of the standard rotations,
+    // so that m * v gives the same result as v.rotate(rotation). For
+    // the axis aligned rotations this is a signed permutation
+    void        from_rotation(enum Rotation rotation);
+
     // create rotation matrix for rotation about the vector v by angle theta
     // See: https://en.wikipedia.org/wiki/Rotation_matrix#General_rotations
     // "Rotation matrix from axis and angle"
@@ -0,0 +1,292 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cmath>
+#include <stdint.h>
+#include <string.h>
+#if MATH_CHECK_INDEXES
+#include <assert.h>
+#endif
+
+/*
+  RxC matrix with the dimensions fixed at compile time, stored row
+  major. All loops have constant bounds so the compiler can unroll the
+  small sizes, and the decompositions work in place on the stack
+  rather than allocating like the runtime sized inverse()
+ */
+template <typename T, uint8_t R, uint8_t C>
+class MatrixN
+{
+public:
+    inline MatrixN<T,R,C>() {
+        zero();
+    }
+
+    inline void zero() {
+        memset(_v, 0, sizeof(_v));
+    }
+
+    // set to the identity, or its leading part if not square
+    void identity() {
+        zero();
+        for (uint8_t i=0; i<R && i<C; i++) {
+            _v[i][i] = 1;
+        }
+    }
+
+    inline T & operator()(uint8_t i, uint8_t j) {
+#if MATH_CHECK_INDEXES
+        assert(i < R && j < C);
+#endif
+        return _v[i][j];
+    }
+
+    inline const T & operator()(uint8_t i, uint8_t j) const {
+#if MATH_CHECK_INDEXES
+        assert(i < R && j < C);
+#endif
+        return _v[i][j];
+    }
+
+    // pointer to row i, so m[i][j] works as for a plain array
+    inline T *operator[](uint8_t i) {
+        return _v[i];
+    }
+
+    inline const T *operator[](uint8_t i) const {
+        return _v[i];
+    }
+
+    // load from / store to a row major array of R*C elements
+    void from_array(const T *a) {
+        memcpy(_v, a, sizeof(_v));
+    }
+
+    void to_array(T *a) const {
+        memcpy(a, _v, sizeof(_v));
+    }
+
+    MatrixN<T,R,C> operator +(const MatrixN<T,R,C> &m) const {
+        MatrixN<T,R,C> ret;
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                ret._v[i][j] = _v[i][j] + m._v[i][j];
+            }
+        }
+        return ret;
+    }
+
+    MatrixN<T,R,C> operator -(const MatrixN<T,R,C> &m) const {
+        MatrixN<T,R,C> ret;
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                ret._v[i][j] = _v[i][j] - m._v[i][j];
+            }
+        }
+        return ret;
+    }
+
+    MatrixN<T,R,C> operator *(const T num) const {
+        MatrixN<T,R,C> ret;
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                ret._v[i][j] = _v[i][j] * num;
+            }
+        }
+        return ret;
+    }
+
+    // matrix product
+    template <uint8_t K>
+    MatrixN<T,R,K> operator *(const MatrixN<T,C,K> &m) const {
+        MatrixN<T,R,K> ret;
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t k=0; k<C; k++) {
+                const T a = _v[i][k];
+                for (uint8_t j=0; j<K; j++) {
+                    ret[i][j] += a * m[k][j];
+                }
+            }
+        }
+        return ret;
+    }
+
+    // multiply the vector x of C elements, giving R elements in y
+    void mul(const T x[C], T y[R]) const {
+        for (uint8_t i=0; i<R; i++) {
+            T sum = 0;
+            for (uint8_t j=0; j<C; j++) {
+                sum += _v[i][j] * x[j];
+            }
+            y[i] = sum;
+        }
+    }
+
+    MatrixN<T,C,R> transposed() const {
+        MatrixN<T,C,R> ret;
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                ret[j][i] = _v[i][j];
+            }
+        }
+        return ret;
+    }
+
+    /*
+      LU decomposition in place with partial pivoting, leaving the unit
+      lower triangle below the diagonal and the upper triangle on and
+      above it. perm records the row order. Returns false if the
+      matrix is singular
+     */
+    bool lu_decompose(uint8_t perm[R]) {
+        static_assert(R == C, "LU decomposition needs a square matrix");
+        for (uint8_t i=0; i<R; i++) {
+            perm[i] = i;
+        }
+        for (uint8_t k=0; k<R; k++) {
+            // pick the largest pivot in this column
+            uint8_t p = k;
+            T pmax = fabs(_v[k][k]);
+            for (uint8_t i=k+1; i<R; i++) {
+                if (fabs(_v[i][k]) > pmax) {
+                    pmax = fabs(_v[i][k]);
+                    p = i;
+                }
+            }
+            if (!(pmax > 0) || std::isinf(pmax)) {
+                return false;
+            }
+            if (p != k) {
+                for (uint8_t j=0; j<C; j++) {
+                    const T tmp = _v[k][j];
+                    _v[k][j] = _v[p][j];
+                    _v[p][j] = tmp;
+                }
+                const uint8_t tmp = perm[k];
+                perm[k] = perm[p];
+                perm[p] = tmp;
+            }
+            const T inv_pivot = 1 / _v[k][k];
+            for (uint8_t i=k+1; i<R; i++) {
+                const T f = _v[i][k] * inv_pivot;
+                _v[i][k] = f;
+                for (uint8_t j=k+1; j<C; j++) {
+                    _v[i][j] -= f * _v[k][j];
+                }
+            }
+        }
+        return true;
+    }
+
+    // solve A*x = b given the result of lu_decompose() on A
+    void lu_solve(const uint8_t perm[R], const T b[R], T x[R]) const {
+        static_assert(R == C, "LU solve needs a square matrix");
+        for (uint8_t i=0; i<R; i++) {
+            T sum = b[perm[i]];
+            for (uint8_t j=0; j<i; j++) {
+                sum -= _v[i][j] * x[j];
+            }
+            x[i] = sum;
+        }
+        for (int8_t i=R-1; i>=0; i--) {
+            T sum = x[i];
+            for (uint8_t j=i+1; j<C; j++) {
+                sum -= _v[i][j] * x[j];
+            }
+            x[i] = sum / _v[i][i];
+        }
+    }
+
+    /*
+      Cholesky decomposition A = L*L^T in place for a symmetric
+      positive definite matrix. Only the lower triangle is read and it
+      is replaced by L; the upper triangle is left untouched. Returns
+      false if the matrix is not positive definite
+     */
+    bool cholesky_decompose() {
+        static_assert(R == C, "Cholesky decomposition needs a square matrix");
+        for (uint8_t j=0; j<R; j++) {
+            T d = _v[j][j];
+            for (uint8_t k=0; k<j; k++) {
+                d -= _v[j][k] * _v[j][k];
+            }
+            if (!(d > 0) || std::isinf(d)) {
+                return false;
+            }
+            d = sqrt(d);
+            _v[j][j] = d;
+            const T inv_d = 1 / d;
+            for (uint8_t i=j+1; i<R; i++) {
+                T sum = _v[i][j];
+                for (uint8_t k=0; k<j; k++) {
+                    sum -= _v[i][k] * _v[j][k];
+                }
+                _v[i][j] = sum * inv_d;
+            }
+        }
+        return true;
+    }
+
+    // solve A*x = b given the result of cholesky_decompose() on A
+    void cholesky_solve(const T b[R], T x[R]) const {
+        static_assert(R == C, "Cholesky solve needs a square matrix");
+        for (uint8_t i=0; i<R; i++) {
+            T sum = b[i];
+            for (uint8_t k=0; k<i; k++) {
+                sum -= _v[i][k] * x[k];
+            }
+            x[i] = sum / _v[i][i];
+        }
+        for (int8_t i=R-1; i>=0; i--) {
+            T sum = x[i];
+            for (uint8_t k=i+1; k<R; k++) {
+                sum -= _v[k][i] * x[k];
+            }
+            x[i] = sum / _v[i][i];
+        }
+    }
+
+    // inverse via LU decomposition. Returns false if singular, in
+    // which case inv is left unchanged
+    bool inverse(MatrixN<T,R,C> &inv) const {
+        static_assert(R == C, "inverse needs a square matrix");
+        MatrixN<T,R,C> lu = *this;
+        uint8_t perm[R];
+        if (!lu.lu_decompose(perm)) {
+            return false;
+        }
+        MatrixN<T,R,C> ret;
+        T e[R];
+        T x[R];
+        for (uint8_t j=0; j<C; j++) {
+            for (uint8_t i=0; i<R; i++) {
+                e[i] = (i == j) ? 1 : 0;
+            }
+            lu.lu_solve(perm, e, x);
+            for (uint8_t i=0; i<R; i++) {
+                if (std::isnan(x[i]) || std::isinf(x[i])) {
+                    return false;
+                }
+                ret._v[i][j] = x[i];
+            }
+        }
+        inv = ret;
+        return true;
+    }
+
+private:
+    T _v[R][C];
+};
@@ -35,201 +35,117 @@ extern const AP_HAL::HAL& hal;
  *
  *    @param     A,           Matrix A
  *    @param     B,           Matrix B
+ *    @param     out,         Output matrix A*B, must not be A or B
  *    @param     n,           dimemsion of square matrices
- *    @returns                multiplied matrix i.e. A*B
  */
 
-float* mat_mul(float *A, float *B, uint8_t n)
+void mat_mul(const float *A, const float *B, float *out, uint8_t n)
 {
-    float* ret = new float[n*n];
-    memset(ret,0.0f,n*n*sizeof(float));
+    memset(out,0,n*n*sizeof(float));
 
     for(uint8_t i = 0; i < n; i++) {
-        for(uint8_t j = 0; j < n; j++) {
-            for(uint8_t k = 0;k < n; k++) {
-                ret[i*n + j] += A[i*n + k] * B[k*n + j];
+        for(uint8_t k = 0; k < n; k++) {
+            const float a = A[i*n + k];
+            for(uint8_t j = 0; j < n; j++) {
+                out[i*n + j] += a * B[k*n + j];
             }
         }
     }
-    return ret;
-}
-
-static inline void swap(float &a, float &b)
-{
-    float c;
-    c = a;
-    a = b;
-    b = c;
 }
 
 /*
- *    calculates pivot matrix such that all the larger elements in the row are on diagonal
- *
- *    @param     A,           input matrix matrix
- *    @param     pivot
- *    @param     n,           dimenstion of square matrix
- *    @returns                false = matrix is Singular or non positive definite, true = matrix inversion successful
+ *    Decomposes square matrix in place into Lower and Upper triangular matrices such that
+ *    P*A = L*U, where P is the row permutation. L has a unit diagonal which is not stored
+ *    ref: http://rosettacode.org/wiki/LU_decomposition
+ *    @param     A,           input matrix, replaced by L below the diagonal and U on and above it
+ *    @param     perm,        Output row order, n elements
+ *    @param     n,           dimension of matrix
+ *    @returns                false = matrix is Singular
  */
 
-static void mat_pivot(float* A, float* pivot, uint8_t n)
+static bool mat_LU_decompose(float *A, uint8_t *perm, uint8_t n)
 {
-    for(uint8_t i = 0;i<n;i++){
-        for(uint8_t j=0;j<n;j++) {
-            pivot[i*n+j] = (i==j);
-        }
+    for(uint8_t i = 0; i < n; i++) {
+        perm[i] = i;
     }
-
-    for(uint8_t i = 0;i < n; i++) {
-        uint8_t max_j = i;
-        for(uint8_t j=i;j<n;j++){
-            if(fabsf(A[j*n + i]) > fabsf(A[max_j*n + i])) {
-                max_j = j;
+    for(uint8_t k = 0; k < n; k++) {
+        // partial pivoting, move the largest element of the column onto the diagonal
+        uint8_t max_i = k;
+        for(uint8_t i = k+1; i < n; i++) {
+            if(fabsf(A[i*n + k]) > fabsf(A[max_i*n + k])) {
+                max_i = i;
             }
         }
-
-        if(max_j != i) {
-            for(uint8_t k = 0; k < n; k++) {
-                swap(pivot[i*n + k], pivot[max_j*n + k]);
-            }
+        if(!(fabsf(A[max_i*n + k]) > 0.0f)) {
+            return false;
         }
-    }
-}
-
-/*
- *    calculates matrix inverse of Lower trangular matrix using forward substitution
- *
- *    @param     L,           lower triangular matrix
- *    @param     out,         Output inverted lower triangular matrix
- *    @param     n,           dimension of matrix
- */
-
-static void mat_forward_sub(float *L, float *out, uint8_t n)
-{
-    // Forward substitution solve LY = I
-    for(int i = 0; i < n; i++) {
-        out[i*n + i] = 1/L[i*n + i];
-        for (int j = i+1; j < n; j++) {
-            for (int k = i; k < j; k++) {
-                out[j*n + i] -= L[j*n + k] * out[k*n + i];
+        if(max_i != k) {
+            for(uint8_t j = 0; j < n; j++) {
+                const float tmp = A[k*n + j];
+                A[k*n + j] = A[max_i*n + j];
+                A[max_i*n + j] = tmp;
             }
-            out[j*n + i] /= L[j*n + j];
+            const uint8_t tmp = perm[k];
+            perm[k] = perm[max_i];
+            perm[max_i] = tmp;
         }
-    }
-}
-
-/*
- *    calculates matrix inverse of Upper trangular matrix using backward substitution
- *
- *    @param     U,           upper triangular matrix
- *    @param     out,         Output inverted upper triangular matrix
- *    @param     n,           dimension of matrix
- */
-
-static void mat_back_sub(float *U, float *out, uint8_t n)
-{
-    // Backward Substitution solve UY = I
-    for(int i = n-1; i >= 0; i--) {
-        out[i*n + i] = 1/U[i*n + i];
-        for (int j = i - 1; j >= 0; j--) {
-            for (int k = i; k > j; k--) {
-                out[j*n + i] -= U[j*n + k] * out[k*n + i];
+        for(uint8_t i = k+1; i < n; i++) {
+            const float f = A[i*n + k] / A[k*n + k];
+            A[i*n + k] = f;
+            for(uint8_t j = k+1; j < n; j++) {
+                A[i*n + j] -= f * A[k*n + j];
             }
-            out[j*n + i] /= U[j*n + j];
         }
     }
-}
-
-/*
- *    Decomposes square matrix into Lower and Upper triangular matrices such that
- *    A*P = L*U, where P is the pivot matrix
- *    ref: http://rosettacode.org/wiki/LU_decomposition
- *    @param     U,           upper triangular matrix
- *    @param     out,         Output inverted upper triangular matrix
- *    @param     n,           dimension of matrix
- */
-
-static void mat_LU_decompose(float* A, float* L, float* U, float *P, uint8_t n)
-{
-    memset(L,0,n*n*sizeof(float));
-    memset(U,0,n*n*sizeof(float));
-    memset(P,0,n*n*sizeof(float));
-    mat_pivot(A,P,n);
-
-    float *APrime = mat_mul(P,A,n);
-    for(uint8_t i = 0; i < n; i++) {
-        L[i*n + i] = 1;
-    }
-    for(uint8_t i = 0; i < n; i++) {
-        for(uint8_t j = 0; j < n; j++) {
-            if(j <= i) {    
-                U[j*n + i] = APrime[j*n + i];
-                for(uint8_t k = 0; k < j; k++) {
-                    U[j*n + i] -= L[j*n + k] * U[k*n + i]; 
-                }
-            }
-            if(j >= i) {
-                L[j*n + i] = APrime[j*n + i];
-                for(uint8_t k = 0; k < i; k++) {
-                    L[j*n + i] -= L[j*n + k] * U[k*n + i]; 
-                }
-                L[j*n + i] /= U[i*n + i];
-            }
-        }
-    }
-    delete[] APrime;
+    return true;
 }
 
 /*
  *    matrix inverse code for any square matrix using LU decomposition
- *    inv = inv(U)*inv(L)*P, where L and U are triagular matrices and P the pivot matrix
+ *    each column of the inverse is found by forward and backward substitution
  *    ref: http://www.cl.cam.ac.uk/teaching/1314/NumMethods/supporting/mcmaster-kiruba-ludecomp.pdf
- *    @param     m,           input 4x4 matrix
- *    @param     inv,      Output inverted 4x4 matrix
+ *    @param     A,           input nxn matrix
+ *    @param     inv,         Output inverted nxn matrix, may be A
  *    @param     n,           dimension of square matrix
+ *    @param     workspace,   n*n floats of scratch space
  *    @returns                false = matrix is Singular, true = matrix inversion successful
  */
-static bool mat_inverse(float* A, float* inv, uint8_t n)
+static bool mat_inverse(const float *A, float *inv, uint8_t n, float *workspace)
 {
-    float *L, *U, *P;
-    bool ret = true;
-    L = new float[n*n];
-    U = new float[n*n];
-    P = new float[n*n];
-    mat_LU_decompose(A,L,U,P,n);
-
-    float *L_inv = new float[n*n];
-    float *U_inv = new float[n*n];
-
-    memset(L_inv,0,n*n*sizeof(float));
-    mat_forward_sub(L,L_inv,n);
-
-    memset(U_inv,0,n*n*sizeof(float));
-    mat_back_sub(U,U_inv,n);
+    uint8_t perm[UINT8_MAX];
+    float *LU = workspace;
 
-    // decomposed matrices no longer required
-    delete[] L;
-    delete[] U;
+    memcpy(LU,A,n*n*sizeof(float));
+    if(!mat_LU_decompose(LU,perm,n)) {
+        return false;
+    }
 
-    float *inv_unpivoted = mat_mul(U_inv,L_inv,n);
-    float *inv_pivoted = mat_mul(inv_unpivoted, P, n);
+    for(uint8_t col = 0; col < n; col++) {
+        // forward substitution solve L*y = P*e(col)
+        for(uint8_t i = 0; i < n; i++) {
+            float sum = (perm[i] == col) ? 1.0f : 0.0f;
+            for(uint8_t k = 0; k < i; k++) {
+                sum -= LU[i*n + k] * inv[k*n + col];
+            }
+            inv[i*n + col] = sum;
+        }
+        // backward substitution solve U*x = y
+        for(int16_t i = n-1; i >= 0; i--) {
+            float sum = inv[i*n + col];
+            for(uint8_t k = i+1; k < n; k++) {
+                sum -= LU[i*n + k] * inv[k*n + col];
+            }
+            inv[i*n + col] = sum / LU[i*n + i];
+        }
+    }
 
     //check sanity of results
-    for(uint8_t i = 0; i < n; i++) {
-        for(uint8_t j = 0; j < n; j++) {
-            if(isnan(inv_pivoted[i*n+j]) || isinf(inv_pivoted[i*n+j])){
-                ret = false;
-            }
+    for(uint16_t i = 0; i < n*n; i++) {
+        if(isnan(inv[i]) || isinf(inv[i])) {
+            return false;
         }
     }
-    memcpy(inv,inv_pivoted,n*n*sizeof(float));
-
-    //free memory
-    delete[] inv_pivoted;
-    delete[] inv_unpivoted;
-    delete[] P;
-    delete[] U_inv;
-    delete[] L_inv;
-    return ret;
+    return true;
 }
 
 /*
@@ -427,7 +343,7 @@ bool inverse4x4(float m[],float invOut[])
  *
  *    @param     x,     input nxn matrix
  *    @param     y,     Output inverted nxn matrix
- *    @param     n,     dimension of square matrix
+ *    @param     n,     dimension of square matrix, at most MATRIX_ALG_MAX_DIM
  *    @returns          false = matrix is Singular, true = matrix inversion successful
  */
 bool inverse(float x[], float y[], uint16_t dim)
@@ -435,6 +351,27 @@ bool inverse(float x[], float y[], uint16_t dim)
     switch(dim){
         case 3: return inverse3x3(x,y);
         case 4: return inverse4x4(x,y);
-        default: return mat_inverse(x,y,dim);
     }
+    if (dim > MATRIX_ALG_MAX_DIM) {
+        return false;
+    }
+    float workspace[MATRIX_ALG_MAX_DIM*MATRIX_ALG_MAX_DIM];
+    return mat_inverse(x,y,dim,workspace);
+}
+
+/*
+ *    generic matrix inverse code for any size, without a size limit
+ *
+ *    @param     x,           input nxn matrix
+ *    @param     y,           Output inverted nxn matrix
+ *    @param     n,           dimension of square matrix, at most 255
+ *    @param     workspace,   n*n floats of scratch space
+ *    @returns                false = matrix is Singular, true = matrix inversion successful
+ */
+bool inverse(const float x[], float y[], uint16_t dim, float workspace[])
+{
+    if (dim > UINT8_MAX) {
+        return false;
+    }
+    return mat_inverse(x,y,dim,workspace);
 }
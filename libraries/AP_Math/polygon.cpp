@@ -24,6 +24,54 @@
  */
 
 
+/*
+ *  Polygon_edge_crossed(): one step of the point in polygon test
+ *     Input:   P = a point,
+ *              A, B = end points of a polygon edge
+ *     Return:  true if the edge changes whether P is inside, i.e. a
+ *              ray from P crosses the edge. The test is exact for
+ *              integer coordinates
+ */
+template <typename T>
+bool Polygon_edge_crossed(const Vector2<T> &P, const Vector2<T> &A, const Vector2<T> &B)
+{
+    if ((A.y > P.y) == (B.y > P.y)) {
+        return false;
+    }
+    int32_t dx1, dx2, dy1, dy2;
+    dx1 = P.x - A.x;
+    dx2 = B.x - A.x;
+    dy1 = P.y - A.y;
+    dy2 = B.y - A.y;
+    int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
+#define sign(x) ((x)<0 ? -1 : 1)
+    dx1s = sign(dx1);
+    dx2s = sign(dx2);
+    dy1s = sign(dy1);
+    dy2s = sign(dy2);
+    m1 = dx1s * dy2s;
+    m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        } else if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
+            return true;
+        }
+    } else {
+        if (m1 < m2) {
+            return true;
+        } else if (m1 > m2) {
+            return false;
+        } else if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*
  *  Polygon_outside(): test for a point in a polygon
  *     Input:   P = a point,
@@ -40,39 +88,8 @@ bool Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n)
     unsigned i, j;
     bool outside = true;
     for (i = 0, j = n-1; i < n; j = i++) {
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        int32_t dx1, dx2, dy1, dy2;
-        dx1 = P.x - V[i].x;
-        dx2 = V[j].x - V[i].x;
-        dy1 = P.y - V[i].y;
-        dy2 = V[j].y - V[i].y;
-        int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
-#define sign(x) ((x)<0 ? -1 : 1)
-        dx1s = sign(dx1);
-        dx2s = sign(dx2);
-        dy1s = sign(dy1);
-        dy2s = sign(dy2);
-        m1 = dx1s * dy2s;
-        m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
+        if (Polygon_edge_crossed(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -92,6 +109,8 @@ bool Polygon_complete(const Vector2<T> *V, unsigned n)
 }
 
 // Necessary to avoid linker errors
+template bool Polygon_edge_crossed<int32_t>(const Vector2l &P, const Vector2l &A, const Vector2l &B);
+template bool Polygon_edge_crossed<float>(const Vector2f &P, const Vector2f &A, const Vector2f &B);
 template bool Polygon_outside<int32_t>(const Vector2l &P, const Vector2l *V, unsigned n);
 template bool Polygon_complete<int32_t>(const Vector2l *V, unsigned n);
 template bool Polygon_outside<float>(const Vector2f &P, const Vector2f *V, unsigned n);
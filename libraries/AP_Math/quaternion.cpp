@@ -121,9 +121,12 @@ void Quaternion::from_rotation_matrix(const Matrix3f &m)
 // convert a vector from earth to body frame
 void Quaternion::earth_to_body(Vector3f &v) const
 {
-    Matrix3f m;
-    rotation_matrix(m);
-    v = m * v;
+    // v + 2w(u x v) + 2u x (u x v), with u the vector part. This is
+    // the same rotation as rotation_matrix(m); v = m * v without
+    // building the matrix
+    const Vector3f u(q2, q3, q4);
+    const Vector3f t = (u % v) * 2.0f;
+    v += t * q1 + u % t;
 }
 
 // create a quaternion from Euler angles
@@ -304,47 +307,6 @@ void Quaternion::normalize(void)
     }
 }
 
-Quaternion Quaternion::operator*(const Quaternion &v) const
-{
-    Quaternion ret;
-    const float &w1 = q1;
-    const float &x1 = q2;
-    const float &y1 = q3;
-    const float &z1 = q4;
-
-    float w2 = v.q1;
-    float x2 = v.q2;
-    float y2 = v.q3;
-    float z2 = v.q4;
-
-    ret.q1 = w1*w2 - x1*x2 - y1*y2 - z1*z2;
-    ret.q2 = w1*x2 + x1*w2 + y1*z2 - z1*y2;
-    ret.q3 = w1*y2 - x1*z2 + y1*w2 + z1*x2;
-    ret.q4 = w1*z2 + x1*y2 - y1*x2 + z1*w2;
-
-    return ret;
-}
-
-Quaternion &Quaternion::operator*=(const Quaternion &v)
-{
-    float w1 = q1;
-    float x1 = q2;
-    float y1 = q3;
-    float z1 = q4;
-
-    float w2 = v.q1;
-    float x2 = v.q2;
-    float y2 = v.q3;
-    float z2 = v.q4;
-
-    q1 = w1*w2 - x1*x2 - y1*y2 - z1*z2;
-    q2 = w1*x2 + x1*w2 + y1*z2 - z1*y2;
-    q3 = w1*y2 - x1*z2 + y1*w2 + z1*x2;
-    q4 = w1*z2 + x1*y2 - y1*x2 + z1*w2;
-
-    return *this;
-}
-
 Quaternion Quaternion::operator/(const Quaternion &v) const
 {
     Quaternion ret;
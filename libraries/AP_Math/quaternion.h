@@ -131,7 +131,15 @@ public:
         return _v[i];
     }
 
-    Quaternion operator*(const Quaternion &v) const;
-    Quaternion &operator*=(const Quaternion &v);
+    Quaternion operator*(const Quaternion &v) const {
+        return Quaternion(q1*v.q1 - q2*v.q2 - q3*v.q3 - q4*v.q4,
+                          q1*v.q2 + q2*v.q1 + q3*v.q4 - q4*v.q3,
+                          q1*v.q3 - q2*v.q4 + q3*v.q1 + q4*v.q2,
+                          q1*v.q4 + q2*v.q3 - q3*v.q2 + q4*v.q1);
+    }
+    Quaternion &operator*=(const Quaternion &v) {
+        *this = *this * v;
+        return *this;
+    }
     Quaternion operator/(const Quaternion &v) const;
 };
@@ -0,0 +1,97 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#if MATH_CHECK_INDEXES
+#include <assert.h>
+#endif
+
+/*
+  symmetric NxN matrix stored as its packed upper triangle, row by
+  row. Uses N*(N+1)/2 elements instead of N*N, and element (i,j) and
+  (j,i) are the same storage so the matrix can never lose symmetry
+ */
+template <typename T, uint8_t N>
+class SymMatrixN
+{
+public:
+    static const uint16_t num_elements = (uint16_t)N * (N + 1) / 2;
+
+    inline SymMatrixN<T,N>() {
+        zero();
+    }
+
+    inline void zero() {
+        memset(_v, 0, sizeof(_v));
+    }
+
+    // offset in the packed array of element (i,j) where i <= j
+    static inline uint16_t upper_index(uint8_t i, uint8_t j) {
+#if MATH_CHECK_INDEXES
+        assert(i <= j && j < N);
+#endif
+        return (uint16_t)i * (2 * N - i - 1) / 2 + j;
+    }
+
+    static inline uint16_t index(uint8_t i, uint8_t j) {
+        return i <= j ? upper_index(i, j) : upper_index(j, i);
+    }
+
+    inline T & operator()(uint8_t i, uint8_t j) {
+        return _v[index(i, j)];
+    }
+
+    inline const T & operator()(uint8_t i, uint8_t j) const {
+        return _v[index(i, j)];
+    }
+
+    // pointer to the packed row i, holding elements (i,i) to (i,N-1)
+    inline T *upper_row(uint8_t i) {
+        return &_v[upper_index(i, i)];
+    }
+
+    inline const T *upper_row(uint8_t i) const {
+        return &_v[upper_index(i, i)];
+    }
+
+    // load from the upper triangle of a square matrix. Only elements
+    // (i,j) with i <= j are read
+    template <typename M>
+    void from_upper(const M &m) {
+        uint16_t k = 0;
+        for (uint8_t i=0; i<N; i++) {
+            for (uint8_t j=i; j<N; j++) {
+                _v[k++] = m[i][j];
+            }
+        }
+    }
+
+    // expand into a full square matrix, writing both triangles
+    template <typename M>
+    void to_full(M &m) const {
+        uint16_t k = 0;
+        for (uint8_t i=0; i<N; i++) {
+            m[i][i] = _v[k++];
+            for (uint8_t j=i+1; j<N; j++) {
+                m[i][j] = m[j][i] = _v[k++];
+            }
+        }
+    }
+
+private:
+    T _v[num_elements];
+};
@@ -0,0 +1,67 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/AP_FFT.h>
+
+#define FFT_TEST_SIZE 64
+
+TEST(FFTTest, InitSize)
+{
+    AP_FFT fft;
+    EXPECT_FALSE(fft.init(0));
+    EXPECT_FALSE(fft.init(48));
+    EXPECT_FALSE(fft.init(2048));
+    EXPECT_TRUE(fft.init(FFT_TEST_SIZE));
+    EXPECT_EQ(FFT_TEST_SIZE, fft.size());
+}
+
+// a sine centred on a bin has all its energy in that bin and its mirror
+TEST(FFTTest, SinePeak)
+{
+    AP_FFT fft;
+    ASSERT_TRUE(fft.init(FFT_TEST_SIZE));
+
+    float re[FFT_TEST_SIZE], im[FFT_TEST_SIZE];
+    for (uint16_t i=0; i<FFT_TEST_SIZE; i++) {
+        re[i] = 2.0f * sinf(2.0f * M_PI * 5 * i / FFT_TEST_SIZE);
+        im[i] = 0.0f;
+    }
+    fft.transform(re, im);
+
+    for (uint16_t k=0; k<FFT_TEST_SIZE; k++) {
+        const float mag = norm(re[k], im[k]);
+        if (k == 5 || k == FFT_TEST_SIZE - 5) {
+            EXPECT_NEAR(FFT_TEST_SIZE, mag, 1.0e-3f);
+        } else {
+            EXPECT_NEAR(0.0f, mag, 1.0e-3f);
+        }
+    }
+}
+
+// matches a direct DFT on arbitrary input
+TEST(FFTTest, MatchesDFT)
+{
+    AP_FFT fft;
+    ASSERT_TRUE(fft.init(FFT_TEST_SIZE));
+
+    float re[FFT_TEST_SIZE], im[FFT_TEST_SIZE];
+    float in_re[FFT_TEST_SIZE], in_im[FFT_TEST_SIZE];
+    for (uint16_t i=0; i<FFT_TEST_SIZE; i++) {
+        in_re[i] = re[i] = sinf(i * 0.7f) + 0.3f * (i % 5);
+        in_im[i] = im[i] = cosf(i * 1.3f);
+    }
+    fft.transform(re, im);
+
+    for (uint16_t k=0; k<FFT_TEST_SIZE; k++) {
+        double sum_re = 0, sum_im = 0;
+        for (uint16_t n=0; n<FFT_TEST_SIZE; n++) {
+            const double angle = -2.0 * M_PI * k * n / FFT_TEST_SIZE;
+            sum_re += in_re[n] * cos(angle) - in_im[n] * sin(angle);
+            sum_im += in_re[n] * sin(angle) + in_im[n] * cos(angle);
+        }
+        EXPECT_NEAR(sum_re, re[k], 1.0e-3f);
+        EXPECT_NEAR(sum_im, im[k], 1.0e-3f);
+    }
+}
+
+AP_GTEST_MAIN()
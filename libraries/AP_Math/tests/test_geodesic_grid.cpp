@@ -143,6 +143,12 @@ TEST_P(GeodesicGridTest, Sections)
     test_triangles_indexes(p);
     EXPECT_EQ(p.section, AP_GeodesicGrid::section(p.v));
 
+    int8_t batch_section;
+    AP_GeodesicGrid::sections(&p.v, &batch_section, 1);
+    EXPECT_EQ(p.section, batch_section);
+    AP_GeodesicGrid::sections(&p.v, &batch_section, 1, true);
+    EXPECT_EQ(AP_GeodesicGrid::section(p.v, true), batch_section);
+
     if (p.section < 0) {
         int s = AP_GeodesicGrid::section(p.v, true);
         int i;
@@ -232,4 +238,29 @@ INSTANTIATE_TEST_CASE_P(HardcodedVectors,
                         GeodesicGridTest,
                         ::testing::ValuesIn(hardcoded_vectors));
 
+/* The batch classification must agree with section() for arbitrary vectors */
+TEST(GeodesicGridBatchTest, MatchesSection)
+{
+    static const uint16_t count = 1000;
+    Vector3f v[count];
+    int8_t out[count];
+    uint32_t seed = 1;
+    for (uint16_t i = 0; i < count; i++) {
+        float c[3];
+        for (uint8_t k = 0; k < 3; k++) {
+            seed = seed * 1103515245 + 12345;
+            c[k] = (int16_t)(seed >> 16) / 100.0f;
+        }
+        v[i] = Vector3f(c[0], c[1], c[2]);
+    }
+    v[0].zero();
+
+    for (uint8_t inclusive = 0; inclusive < 2; inclusive++) {
+        AP_GeodesicGrid::sections(v, out, count, inclusive);
+        for (uint16_t i = 0; i < count; i++) {
+            EXPECT_EQ(AP_GeodesicGrid::section(v[i], inclusive), out[i]);
+        }
+    }
+}
+
 AP_GTEST_MAIN()
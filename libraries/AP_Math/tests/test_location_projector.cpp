@@ -0,0 +1,81 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+static Location make_loc(int32_t lat, int32_t lng)
+{
+    Location loc {};
+    loc.lat = lat;
+    loc.lng = lng;
+    return loc;
+}
+
+TEST(LocationProjectorTest, MatchesLocationDiff)
+{
+    const Location origin = make_loc(-353632610, 1491652300);
+    Location_Projector projector;
+    EXPECT_FALSE(projector.have_origin());
+    EXPECT_TRUE(projector.set_origin(origin));
+    EXPECT_TRUE(projector.have_origin());
+
+    for (int32_t i = -5; i <= 5; i++) {
+        const Location loc = make_loc(origin.lat + i * 17321, origin.lng - i * 23456);
+        const Vector2f expected = location_diff(origin, loc);
+        const Vector2f ne = projector.project(loc);
+        EXPECT_FLOAT_EQ(expected.x, ne.x);
+        EXPECT_NEAR(expected.y, ne.y, 1.0e-3f);
+        // get_distance() scales longitude at its second argument
+        EXPECT_NEAR(get_distance(loc, origin), projector.get_distance(loc), 1.0e-3f);
+    }
+}
+
+TEST(LocationProjectorTest, Batch)
+{
+    Location_Projector projector;
+    projector.set_origin(make_loc(515000000, -1000000));
+
+    Location locs[8];
+    for (uint8_t i = 0; i < 8; i++) {
+        locs[i] = make_loc(515000000 + i * 5000, -1000000 + i * 7000);
+    }
+    Vector2f ne[8];
+    projector.project(locs, ne, 8);
+    for (uint8_t i = 0; i < 8; i++) {
+        const Vector2f expected = projector.project(locs[i]);
+        EXPECT_FLOAT_EQ(expected.x, ne[i].x);
+        EXPECT_FLOAT_EQ(expected.y, ne[i].y);
+    }
+}
+
+TEST(LocationProjectorTest, Unproject)
+{
+    Location_Projector projector;
+    projector.set_origin(make_loc(473977420, 85455940));
+
+    const Vector2f ne(123.4f, -567.8f);
+    Location loc {};
+    projector.unproject(ne, loc);
+    const Vector2f back = projector.project(loc);
+    // lat/lng resolution is about 1cm
+    EXPECT_NEAR(ne.x, back.x, 0.02f);
+    EXPECT_NEAR(ne.y, back.y, 0.02f);
+
+    Location expected = make_loc(473977420, 85455940);
+    location_offset(expected, ne.x, ne.y);
+    EXPECT_NEAR(expected.lat, loc.lat, 1);
+    EXPECT_NEAR(expected.lng, loc.lng, 1);
+}
+
+TEST(LocationProjectorTest, ScaleRefresh)
+{
+    Location_Projector projector;
+    EXPECT_TRUE(projector.set_origin(make_loc(400000000, 0)));
+    // small moves keep the cached scale
+    EXPECT_FALSE(projector.set_origin(make_loc(400050000, 10000)));
+    const Vector2f ne = projector.project(make_loc(400050000, 20000));
+    EXPECT_FLOAT_EQ(0.0f, ne.x);
+    // moving over 0.01 degrees recomputes it
+    EXPECT_TRUE(projector.set_origin(make_loc(400200000, 0)));
+}
+
+AP_GTEST_MAIN()
@@ -259,4 +259,100 @@ TEST(MathWrapTest, Angle2PI)
     EXPECT_NEAR(0,    wrap_2PI(-M_2PI), accuracy);
 }
 
+TEST(MathTest, CRC32)
+{
+    const uint8_t check[] = "123456789";
+
+    EXPECT_EQ(0u, crc_crc32(0, check, 0));
+    EXPECT_EQ(0xCBF43926u, crc_crc32(0, check, 9));
+    // continuing a CRC over a split buffer gives the same result
+    EXPECT_EQ(0xCBF43926u, crc_crc32(crc_crc32(0, check, 4), &check[4], 5));
+}
+
+/*
+  the inline and matrix-free kernels must match the matrix forms used
+  elsewhere in the code
+ */
+TEST(VectorTest, MatrixRotate)
+{
+    Matrix3f m;
+    m.from_euler(0.3f, -0.7f, 2.1f);
+    const Vector3f g(0.01f, -0.02f, 0.005f);
+
+    Matrix3f expected = m;
+    expected += Matrix3f(m.a % g, m.b % g, m.c % g);
+    m.rotate(g);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        EXPECT_FLOAT_EQ(expected[i].x, m[i].x);
+        EXPECT_FLOAT_EQ(expected[i].y, m[i].y);
+        EXPECT_FLOAT_EQ(expected[i].z, m[i].z);
+    }
+}
+
+TEST(VectorTest, MatrixFromRotation)
+{
+    const float accuracy = 1.0e-6;
+    const Vector3f v(0.3f, -1.7f, 9.2f);
+
+    for (uint8_t r = 0; r < ROTATION_MAX; r++) {
+        Matrix3f m;
+        m.from_rotation((enum Rotation)r);
+        Vector3f expected = v;
+        expected.rotate((enum Rotation)r);
+        const Vector3f result = m * v;
+
+        EXPECT_NEAR(expected.x, result.x, accuracy * v.length()) << "rotation " << (unsigned)r;
+        EXPECT_NEAR(expected.y, result.y, accuracy * v.length()) << "rotation " << (unsigned)r;
+        EXPECT_NEAR(expected.z, result.z, accuracy * v.length()) << "rotation " << (unsigned)r;
+    }
+}
+
+TEST(QuaternionTest, EarthToBody)
+{
+    const float accuracy = 1.0e-6;
+    Quaternion q;
+    q.from_euler(0.3f, -0.7f, 2.1f);
+    Matrix3f m;
+    q.rotation_matrix(m);
+
+    const Vector3f v(1.5f, -2.0f, 9.8f);
+    const Vector3f expected = m * v;
+    Vector3f result = v;
+    q.earth_to_body(result);
+
+    EXPECT_NEAR(expected.x, result.x, accuracy * v.length());
+    EXPECT_NEAR(expected.y, result.y, accuracy * v.length());
+    EXPECT_NEAR(expected.z, result.z, accuracy * v.length());
+}
+
+TEST(QuaternionTest, Multiply)
+{
+    const float accuracy = 1.0e-5;
+    Quaternion q1, q2;
+    q1.from_euler(0.3f, -0.7f, 2.1f);
+    q2.from_euler(-1.1f, 0.2f, -0.4f);
+
+    // composing quaternions is the same as composing their matrices
+    Matrix3f m1, m2, m;
+    q1.rotation_matrix(m1);
+    q2.rotation_matrix(m2);
+    (q1 * q2).rotation_matrix(m);
+    const Matrix3f expected = m1 * m2;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        EXPECT_NEAR(expected[i].x, m[i].x, accuracy);
+        EXPECT_NEAR(expected[i].y, m[i].y, accuracy);
+        EXPECT_NEAR(expected[i].z, m[i].z, accuracy);
+    }
+
+    Quaternion q3 = q1;
+    q3 *= q2;
+    const Quaternion q4 = q1 * q2;
+    EXPECT_FLOAT_EQ(q4.q1, q3.q1);
+    EXPECT_FLOAT_EQ(q4.q2, q3.q2);
+    EXPECT_FLOAT_EQ(q4.q3, q3.q3);
+    EXPECT_FLOAT_EQ(q4.q4, q3.q4);
+}
+
 AP_GTEST_MAIN()
@@ -0,0 +1,143 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/matrixN.h>
+
+// symmetric positive definite test matrix, diagonally dominant
+template <uint8_t N>
+static void fill_spd(MatrixN<float,N,N> &m)
+{
+    for (uint8_t i=0; i<N; i++) {
+        for (uint8_t j=0; j<N; j++) {
+            m[i][j] = (i == j) ? (N + 1.0f + i) : 1.0f / (1 + i + j);
+        }
+    }
+}
+
+TEST(MatrixNTest, Multiply)
+{
+    MatrixN<float,2,3> a;
+    MatrixN<float,3,2> b;
+    for (uint8_t i=0; i<2; i++) {
+        for (uint8_t j=0; j<3; j++) {
+            a[i][j] = i * 3 + j + 1;
+            b[j][i] = j * 2 + i + 1;
+        }
+    }
+    MatrixN<float,2,2> c = a * b;
+    EXPECT_FLOAT_EQ(22.0f, c[0][0]);
+    EXPECT_FLOAT_EQ(28.0f, c[0][1]);
+    EXPECT_FLOAT_EQ(49.0f, c[1][0]);
+    EXPECT_FLOAT_EQ(64.0f, c[1][1]);
+
+    MatrixN<float,3,2> at = a.transposed();
+    EXPECT_FLOAT_EQ(a[1][2], at[2][1]);
+}
+
+TEST(MatrixNTest, InverseMatchesRuntime)
+{
+    MatrixN<float,5,5> m;
+    for (uint8_t i=0; i<5; i++) {
+        for (uint8_t j=0; j<5; j++) {
+            m[i][j] = (i == j) ? 4.0f : (float)(i + 2*j) / 10 - 0.5f;
+        }
+    }
+    // the first row needs pivoting
+    m[0][0] = 0.0f;
+
+    MatrixN<float,5,5> inv;
+    EXPECT_TRUE(m.inverse(inv));
+
+    float a[25], b[25];
+    m.to_array(a);
+    EXPECT_TRUE(inverse(a, b, 5));
+    for (uint8_t i=0; i<25; i++) {
+        EXPECT_NEAR(b[i], inv[i/5][i%5], 1e-5);
+    }
+
+    MatrixN<float,5,5> id = m * inv;
+    for (uint8_t i=0; i<5; i++) {
+        for (uint8_t j=0; j<5; j++) {
+            EXPECT_NEAR((i == j) ? 1.0f : 0.0f, id[i][j], 1e-5);
+        }
+    }
+}
+
+TEST(MatrixNTest, RuntimeInverseInPlace)
+{
+    MatrixN<float,9,9> m;
+    fill_spd(m);
+    float a[81], ws[81];
+    m.to_array(a);
+    EXPECT_TRUE(inverse(a, a, 9));
+
+    MatrixN<float,9,9> inv;
+    inv.from_array(a);
+    MatrixN<float,9,9> id = m * inv;
+    for (uint8_t i=0; i<9; i++) {
+        for (uint8_t j=0; j<9; j++) {
+            EXPECT_NEAR((i == j) ? 1.0f : 0.0f, id[i][j], 1e-5);
+        }
+    }
+
+    // the workspace variant gives the same result
+    float b[81], c[81];
+    m.to_array(b);
+    EXPECT_TRUE(inverse(b, c, 9, ws));
+    for (uint8_t i=0; i<81; i++) {
+        EXPECT_FLOAT_EQ(a[i], c[i]);
+    }
+
+    // beyond the stack workspace a caller supplied one is needed
+    float big[100];
+    EXPECT_FALSE(inverse(big, big, 10));
+}
+
+TEST(MatrixNTest, Singular)
+{
+    MatrixN<float,3,3> m;
+    m[0][0] = 1; m[0][1] = 2; m[0][2] = 3;
+    m[1][0] = 2; m[1][1] = 4; m[1][2] = 6;
+    m[2][2] = 1;
+    MatrixN<float,3,3> inv;
+    inv.identity();
+    EXPECT_FALSE(m.inverse(inv));
+    // left unchanged on failure
+    EXPECT_FLOAT_EQ(1.0f, inv[0][0]);
+
+    MatrixN<float,3,3> c = m;
+    EXPECT_FALSE(c.cholesky_decompose());
+
+    float a[9], b[9];
+    m.to_array(a);
+    EXPECT_FALSE(inverse(a, b, 3));
+    float ws[9];
+    EXPECT_FALSE(inverse(a, b, 3, ws));
+}
+
+TEST(MatrixNTest, CholeskySolve)
+{
+    MatrixN<float,9,9> m;
+    fill_spd(m);
+    float x_true[9], b[9], x[9], x_lu[9];
+    for (uint8_t i=0; i<9; i++) {
+        x_true[i] = 0.5f * i - 2;
+    }
+    m.mul(x_true, b);
+
+    MatrixN<float,9,9> l = m;
+    ASSERT_TRUE(l.cholesky_decompose());
+    l.cholesky_solve(b, x);
+
+    MatrixN<float,9,9> lu = m;
+    uint8_t perm[9];
+    ASSERT_TRUE(lu.lu_decompose(perm));
+    lu.lu_solve(perm, b, x_lu);
+
+    for (uint8_t i=0; i<9; i++) {
+        EXPECT_NEAR(x_true[i], x[i], 1e-5);
+        EXPECT_NEAR(x_true[i], x_lu[i], 1e-5);
+    }
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,48 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+// the exact altitude formula exponent, in double precision
+static double exact_pow(float ratio)
+{
+    return pow((double)ratio, 0.190259);
+}
+
+TEST(PressureRatioTest, MatchesPow)
+{
+    double max_rel_error = 0;
+    for (float ratio = 0.05f; ratio <= 2.0f; ratio += 0.0001f) {
+        const double exact = exact_pow(ratio);
+        const double rel_error = fabs(pressure_ratio_pow(ratio) - exact) / exact;
+        if (rel_error > max_rel_error) {
+            max_rel_error = rel_error;
+        }
+    }
+    EXPECT_LT(max_rel_error, 2.0e-7);
+}
+
+TEST(PressureRatioTest, Altitude)
+{
+    // altitude difference at 15C from sea level to well above 11km
+    const float temp = 288.15f;
+    for (float ratio = 0.2f; ratio <= 1.1f; ratio += 0.00005f) {
+        const double exact = 153.8462 * temp * (1.0 - exact_pow(ratio));
+        const float alt = 153.8462f * temp * (1.0f - pressure_ratio_pow(ratio));
+        EXPECT_NEAR(exact, alt, 0.01);
+    }
+}
+
+TEST(PressureRatioTest, Limits)
+{
+    EXPECT_FLOAT_EQ(1.0f, pressure_ratio_pow(1.0f));
+    EXPECT_FLOAT_EQ(0.0f, pressure_ratio_pow(0.0f));
+    EXPECT_TRUE(isnan(pressure_ratio_pow(-1.0f)));
+    EXPECT_TRUE(isnan(pressure_ratio_pow(NAN)));
+    EXPECT_TRUE(isinf(pressure_ratio_pow(INFINITY)));
+
+    // outside the table the library result is used
+    EXPECT_NEAR(exact_pow(1.0e-6f), pressure_ratio_pow(1.0e-6f), 1.0e-6);
+    EXPECT_NEAR(exact_pow(1000.0f), pressure_ratio_pow(1000.0f), 1.0e-4);
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,58 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/symmatrixN.h>
+
+TEST(SymMatrixNTest, PackedSize)
+{
+    EXPECT_EQ(1u, (SymMatrixN<float,1>::num_elements));
+    EXPECT_EQ(6u, (SymMatrixN<float,3>::num_elements));
+    EXPECT_EQ(300u, (SymMatrixN<float,24>::num_elements));
+}
+
+TEST(SymMatrixNTest, UpperIndexIsDense)
+{
+    // walking the upper triangle row by row must visit every packed
+    // element exactly once, in order
+    uint16_t k = 0;
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=i; j<24; j++) {
+            EXPECT_EQ(k, (SymMatrixN<float,24>::upper_index(i, j)));
+            k++;
+        }
+    }
+    EXPECT_EQ((SymMatrixN<float,24>::num_elements), k);
+}
+
+TEST(SymMatrixNTest, Symmetric)
+{
+    SymMatrixN<float,4> m;
+    m(1,3) = 2.5f;
+    EXPECT_FLOAT_EQ(2.5f, m(3,1));
+    m(3,1) = -1.0f;
+    EXPECT_FLOAT_EQ(-1.0f, m(1,3));
+    EXPECT_FLOAT_EQ(0.0f, m(0,0));
+}
+
+TEST(SymMatrixNTest, RoundTrip)
+{
+    float full[5][5];
+    for (uint8_t i=0; i<5; i++) {
+        for (uint8_t j=0; j<5; j++) {
+            full[i][j] = (i <= j) ? (i * 10 + j) : -1.0f;
+        }
+    }
+    SymMatrixN<float,5> m;
+    m.from_upper(full);
+
+    float out[5][5];
+    m.to_full(out);
+    for (uint8_t i=0; i<5; i++) {
+        for (uint8_t j=0; j<5; j++) {
+            uint8_t lo = MIN(i, j), hi = MAX(i, j);
+            EXPECT_FLOAT_EQ(lo * 10 + hi, out[i][j]);
+        }
+    }
+}
+
+AP_GTEST_MAIN()
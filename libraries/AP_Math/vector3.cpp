@@ -254,48 +254,12 @@ void Vector3<T>::rotate_inverse(enum Rotation rotation)
     (*this) = M.mul_transpose(*this);
 }
 
-// vector cross product
-template <typename T>
-Vector3<T> Vector3<T>::operator %(const Vector3<T> &v) const
-{
-    Vector3<T> temp(y*v.z - z*v.y, z*v.x - x*v.z, x*v.y - y*v.x);
-    return temp;
-}
-
-// dot product
-template <typename T>
-T Vector3<T>::operator *(const Vector3<T> &v) const
-{
-    return x*v.x + y*v.y + z*v.z;
-}
-
 template <typename T>
 float Vector3<T>::length(void) const
 {
     return norm(x, y, z);
 }
 
-template <typename T>
-Vector3<T> &Vector3<T>::operator *=(const T num)
-{
-    x*=num; y*=num; z*=num;
-    return *this;
-}
-
-template <typename T>
-Vector3<T> &Vector3<T>::operator /=(const T num)
-{
-    x /= num; y /= num; z /= num;
-    return *this;
-}
-
-template <typename T>
-Vector3<T> &Vector3<T>::operator -=(const Vector3<T> &v)
-{
-    x -= v.x; y -= v.y; z -= v.z;
-    return *this;
-}
-
 template <typename T>
 bool Vector3<T>::is_nan(void) const
 {
@@ -308,43 +272,6 @@ bool Vector3<T>::is_inf(void) const
     return isinf(x) || isinf(y) || isinf(z);
 }
 
-template <typename T>
-Vector3<T> &Vector3<T>::operator +=(const Vector3<T> &v)
-{
-    x+=v.x; y+=v.y; z+=v.z;
-    return *this;
-}
-
-template <typename T>
-Vector3<T> Vector3<T>::operator /(const T num) const
-{
-    return Vector3<T>(x/num, y/num, z/num);
-}
-
-template <typename T>
-Vector3<T> Vector3<T>::operator *(const T num) const
-{
-    return Vector3<T>(x*num, y*num, z*num);
-}
-
-template <typename T>
-Vector3<T> Vector3<T>::operator -(const Vector3<T> &v) const
-{
-    return Vector3<T>(x-v.x, y-v.y, z-v.z);
-}
-
-template <typename T>
-Vector3<T> Vector3<T>::operator +(const Vector3<T> &v) const
-{
-    return Vector3<T>(x+v.x, y+v.y, z+v.z);
-}
-
-template <typename T>
-Vector3<T> Vector3<T>::operator -(void) const
-{
-    return Vector3<T>(-x,-y,-z);
-}
-
 template <typename T>
 bool Vector3<T>::operator ==(const Vector3<T> &v) const
 {
@@ -394,19 +321,8 @@ Matrix3<T> Vector3<T>::mul_rowcol(const Vector3<T> &v2) const
 template void Vector3<float>::rotate(enum Rotation);
 template void Vector3<float>::rotate_inverse(enum Rotation);
 template float Vector3<float>::length(void) const;
-template Vector3<float> Vector3<float>::operator %(const Vector3<float> &v) const;
-template float Vector3<float>::operator *(const Vector3<float> &v) const;
 template Vector3<float> Vector3<float>::operator *(const Matrix3<float> &m) const;
 template Matrix3<float> Vector3<float>::mul_rowcol(const Vector3<float> &v) const;
-template Vector3<float> &Vector3<float>::operator *=(const float num);
-template Vector3<float> &Vector3<float>::operator /=(const float num);
-template Vector3<float> &Vector3<float>::operator -=(const Vector3<float> &v);
-template Vector3<float> &Vector3<float>::operator +=(const Vector3<float> &v);
-template Vector3<float> Vector3<float>::operator /(const float num) const;
-template Vector3<float> Vector3<float>::operator *(const float num) const;
-template Vector3<float> Vector3<float>::operator +(const Vector3<float> &v) const;
-template Vector3<float> Vector3<float>::operator -(const Vector3<float> &v) const;
-template Vector3<float> Vector3<float>::operator -(void) const;
 template bool Vector3<float>::operator ==(const Vector3<float> &v) const;
 template bool Vector3<float>::operator !=(const Vector3<float> &v) const;
 template bool Vector3<float>::is_nan(void) const;
@@ -416,19 +332,8 @@ template float Vector3<float>::angle(const Vector3<float> &v) const;
 template void Vector3<double>::rotate(enum Rotation);
 template void Vector3<double>::rotate_inverse(enum Rotation);
 template float Vector3<double>::length(void) const;
-template Vector3<double> Vector3<double>::operator %(const Vector3<double> &v) const;
-template double Vector3<double>::operator *(const Vector3<double> &v) const;
 template Vector3<double> Vector3<double>::operator *(const Matrix3<double> &m) const;
 template Matrix3<double> Vector3<double>::mul_rowcol(const Vector3<double> &v) const;
-template Vector3<double> &Vector3<double>::operator *=(const double num);
-template Vector3<double> &Vector3<double>::operator /=(const double num);
-template Vector3<double> &Vector3<double>::operator -=(const Vector3<double> &v);
-template Vector3<double> &Vector3<double>::operator +=(const Vector3<double> &v);
-template Vector3<double> Vector3<double>::operator /(const double num) const;
-template Vector3<double> Vector3<double>::operator *(const double num) const;
-template Vector3<double> Vector3<double>::operator +(const Vector3<double> &v) const;
-template Vector3<double> Vector3<double>::operator -(const Vector3<double> &v) const;
-template Vector3<double> Vector3<double>::operator -(void) const;
 template bool Vector3<double>::operator ==(const Vector3<double> &v) const;
 template bool Vector3<double>::operator !=(const Vector3<double> &v) const;
 template bool Vector3<double>::is_nan(void) const;
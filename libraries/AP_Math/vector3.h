@@ -90,32 +90,61 @@ public:
     // test for inequality
     bool operator !=(const Vector3<T> &v) const;
 
+    /*
+      the element-wise operators below are defined inline so that
+      expressions in the attitude and EKF code can be fused by the
+      compiler instead of going through a call and a returned
+      temporary for every operator
+     */
+
     // negation
-    Vector3<T> operator -(void) const;
+    Vector3<T> operator -(void) const {
+        return Vector3<T>(-x, -y, -z);
+    }
 
     // addition
-    Vector3<T> operator +(const Vector3<T> &v) const;
+    Vector3<T> operator +(const Vector3<T> &v) const {
+        return Vector3<T>(x+v.x, y+v.y, z+v.z);
+    }
 
     // subtraction
-    Vector3<T> operator -(const Vector3<T> &v) const;
+    Vector3<T> operator -(const Vector3<T> &v) const {
+        return Vector3<T>(x-v.x, y-v.y, z-v.z);
+    }
 
     // uniform scaling
-    Vector3<T> operator *(const T num) const;
+    Vector3<T> operator *(const T num) const {
+        return Vector3<T>(x*num, y*num, z*num);
+    }
 
     // uniform scaling
-    Vector3<T> operator  /(const T num) const;
+    Vector3<T> operator  /(const T num) const {
+        return Vector3<T>(x/num, y/num, z/num);
+    }
 
     // addition
-    Vector3<T> &operator +=(const Vector3<T> &v);
+    Vector3<T> &operator +=(const Vector3<T> &v) {
+        x += v.x; y += v.y; z += v.z;
+        return *this;
+    }
 
     // subtraction
-    Vector3<T> &operator -=(const Vector3<T> &v);
+    Vector3<T> &operator -=(const Vector3<T> &v) {
+        x -= v.x; y -= v.y; z -= v.z;
+        return *this;
+    }
 
     // uniform scaling
-    Vector3<T> &operator *=(const T num);
+    Vector3<T> &operator *=(const T num) {
+        x *= num; y *= num; z *= num;
+        return *this;
+    }
 
     // uniform scaling
-    Vector3<T> &operator /=(const T num);
+    Vector3<T> &operator /=(const T num) {
+        x /= num; y /= num; z /= num;
+        return *this;
+    }
 
     // allow a vector3 to be used as an array, 0 indexed
     T & operator[](uint8_t i) {
@@ -135,7 +164,9 @@ public:
     }
 
     // dot product
-    T operator *(const Vector3<T> &v) const;
+    T operator *(const Vector3<T> &v) const {
+        return x*v.x + y*v.y + z*v.z;
+    }
 
     // multiply a row vector by a matrix, to give a row vector
     Vector3<T> operator *(const Matrix3<T> &m) const;
@@ -144,7 +175,9 @@ public:
     Matrix3<T> mul_rowcol(const Vector3<T> &v) const;
 
     // cross product
-    Vector3<T> operator %(const Vector3<T> &v) const;
+    Vector3<T> operator %(const Vector3<T> &v) const {
+        return Vector3<T>(y*v.z - z*v.y, z*v.x - x*v.z, x*v.y - y*v.x);
+    }
 
     // computes the angle between this vector and another vector
     float angle(const Vector3<T> &v2) const;
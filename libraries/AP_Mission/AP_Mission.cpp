@@ -194,6 +194,11 @@ void AP_Mission::truncate(uint16_t index)
 ///     should be called at 10hz or higher
 void AP_Mission::update()
 {
+#if AP_MISSION_ANALYSIS
+    // redo the analysis here after a change, rather than in a query
+    analysis_update();
+#endif
+
     // exit immediately if not running or no mission commands
     if (_flags.state != MISSION_RUNNING || _cmd_total == 0) {
         return;
@@ -269,6 +274,77 @@ bool AP_Mission::replace_cmd(uint16_t index, Mission_Command& cmd)
     return write_cmd_to_storage(index, cmd);
 }
 
+/// upload_start - prepare to stage a mission of count commands
+///     returns false if the mission can't be staged
+bool AP_Mission::upload_start(uint16_t count)
+{
+#if AP_MISSION_UPLOAD_BUFFER
+    if (count == 0 || count > num_commands_max()) {
+        return false;
+    }
+    if (_upload_size < count) {
+        delete[] _upload;
+        _upload_size = 0;
+        _upload = new Mission_Command[count];
+        if (_upload == nullptr) {
+            return false;
+        }
+        _upload_size = count;
+    }
+    _upload_count = count;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// upload_set - stage the command at position 'index'
+bool AP_Mission::upload_set(uint16_t index, const Mission_Command& cmd)
+{
+#if AP_MISSION_UPLOAD_BUFFER
+    if (_upload == nullptr || index >= _upload_count) {
+        return false;
+    }
+    _upload[index] = cmd;
+    _upload[index].index = index;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// upload_commit - replace the stored mission with the staged commands
+///     returns false, leaving the stored mission as it was, if there is
+///     no staged mission
+bool AP_Mission::upload_commit()
+{
+#if AP_MISSION_UPLOAD_BUFFER
+    if (_upload == nullptr || _upload_count == 0 || _upload_count > num_commands_max()) {
+        upload_abort();
+        return false;
+    }
+    for (uint16_t i=0; i<_upload_count; i++) {
+        write_cmd_to_storage(i, _upload[i]);
+    }
+    _cmd_total.set_and_save(_upload_count);
+    upload_abort();
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// upload_abort - discard any staged commands
+void AP_Mission::upload_abort()
+{
+#if AP_MISSION_UPLOAD_BUFFER
+    delete[] _upload;
+    _upload = nullptr;
+    _upload_count = 0;
+    _upload_size = 0;
+#endif
+}
+
 /// is_nav_cmd - returns true if the command's id is a "navigation" command, false if "do" or "conditional" command
 bool AP_Mission::is_nav_cmd(const Mission_Command& cmd)
 {
@@ -449,19 +525,36 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         // read WP position
         uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
 
-        uint8_t b1 = _storage.read_byte(pos_in_storage);
-        if (b1 == 0) {
-            cmd.id = _storage.read_uint16(pos_in_storage+1);
-            cmd.p1 = _storage.read_uint16(pos_in_storage+3);
-            _storage.read_block(cmd.content.bytes, pos_in_storage+5, 10);
+#if AP_MISSION_CMD_CACHE
+        const bool cached = cmd_cache_alloc() && index < num_commands_max();
+        if (cached && (_cmd_cache_valid[index/32] & (1U<<(index%32)))) {
+            cmd = _cmd_cache[index];
+            return true;
+        }
+#endif
+
+        // read the whole command in one go
+        uint8_t b[AP_MISSION_EEPROM_COMMAND_SIZE];
+        _storage.read_block(b, pos_in_storage, sizeof(b));
+        if (b[0] == 0) {
+            memcpy(&cmd.id, &b[1], 2);
+            memcpy(&cmd.p1, &b[3], 2);
+            memcpy(cmd.content.bytes, &b[5], 10);
         } else {
-            cmd.id = b1;
-            cmd.p1 = _storage.read_uint16(pos_in_storage+1);
-            _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
+            cmd.id = b[0];
+            memcpy(&cmd.p1, &b[1], 2);
+            memcpy(cmd.content.bytes, &b[3], 12);
         }
 
         // set command's index to it's position in eeprom
         cmd.index = index;
+
+#if AP_MISSION_CMD_CACHE
+        if (cached) {
+            _cmd_cache[index] = cmd;
+            _cmd_cache_valid[index/32] |= (1U<<(index%32));
+        }
+#endif
     }
 
     // return success
@@ -481,17 +574,26 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     // calculate where in storage the command should be placed
     uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
 
+    // build the whole command so it reaches storage as one write
+    uint8_t b[AP_MISSION_EEPROM_COMMAND_SIZE];
     if (cmd.id < 256) {
-        _storage.write_byte(pos_in_storage, cmd.id);
-        _storage.write_uint16(pos_in_storage+1, cmd.p1);
-        _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
+        b[0] = cmd.id;
+        memcpy(&b[1], &cmd.p1, 2);
+        memcpy(&b[3], cmd.content.bytes, 12);
     } else {
         // if the command ID is above 256 we store a 0 followed by the 16 bit command ID
-        _storage.write_byte(pos_in_storage, 0);
-        _storage.write_uint16(pos_in_storage+1, cmd.id);
-        _storage.write_uint16(pos_in_storage+3, cmd.p1);
-        _storage.write_block(pos_in_storage+5, cmd.content.bytes, 10);
+        b[0] = 0;
+        memcpy(&b[1], &cmd.id, 2);
+        memcpy(&b[3], &cmd.p1, 2);
+        memcpy(&b[5], cmd.content.bytes, 10);
+    }
+    _storage.write_block(pos_in_storage, b, sizeof(b));
+
+#if AP_MISSION_CMD_CACHE
+    if (_cmd_cache_valid != nullptr) {
+        _cmd_cache_valid[index/32] &= ~(1U<<(index%32));
     }
+#endif
 
     // remember when the mission last changed
     _last_change_time_ms = AP_HAL::millis();
@@ -500,6 +602,34 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     return true;
 }
 
+#if AP_MISSION_CMD_CACHE
+/*
+  allocate the decoded command cache, sized for the whole mission area
+ */
+bool AP_Mission::cmd_cache_alloc(void) const
+{
+    if (_cmd_cache != nullptr) {
+        return true;
+    }
+    if (_cmd_cache_failed) {
+        return false;
+    }
+    const uint16_t n = num_commands_max();
+    _cmd_cache = new Mission_Command[n];
+    _cmd_cache_valid = new uint32_t[(n+31)/32];
+    if (_cmd_cache == nullptr || _cmd_cache_valid == nullptr) {
+        delete[] _cmd_cache;
+        delete[] _cmd_cache_valid;
+        _cmd_cache = nullptr;
+        _cmd_cache_valid = nullptr;
+        _cmd_cache_failed = true;
+        return false;
+    }
+    memset(_cmd_cache_valid, 0, ((n+31)/32) * sizeof(uint32_t));
+    return true;
+}
+#endif
+
 /// write_home_to_storage - writes the special purpose cmd 0 (home) to storage
 ///     home is taken directly from ahrs
 void AP_Mission::write_home_to_storage()
@@ -1596,6 +1726,24 @@ uint16_t AP_Mission::get_landing_sequence_start()
     uint16_t landing_start_index = 0;
     float min_distance = -1;
 
+#if AP_MISSION_ANALYSIS
+    // only look at the landing start commands found by the analysis
+    if (analysis_update() && _analysis_land_start_count <= AP_MISSION_ANALYSIS_MAX_LAND_START) {
+        for (uint8_t i = 0; i < _analysis_land_start_count; i++) {
+            Mission_Command tmp;
+            if (!read_cmd_from_storage(_analysis_land_start[i], tmp)) {
+                continue;
+            }
+            float tmp_distance = get_distance(tmp.content.location, current_loc);
+            if (min_distance < 0 || tmp_distance < min_distance) {
+                min_distance = tmp_distance;
+                landing_start_index = tmp.index;
+            }
+        }
+        return landing_start_index;
+    }
+#endif
+
     // Go through mission looking for nearest landing start command
     for (uint16_t i = 0; i < num_commands(); i++) {
         Mission_Command tmp;
@@ -1614,3 +1762,141 @@ uint16_t AP_Mission::get_landing_sequence_start()
     return landing_start_index;
 }
 
+#if AP_MISSION_ANALYSIS
+/*
+  work out the running totals for each command if the mission has
+  changed since the last analysis
+ */
+bool AP_Mission::analysis_update(void)
+{
+    const uint16_t count = num_commands();
+    if (_analysis_valid &&
+        _analysis_change_ms == _last_change_time_ms &&
+        _analysis_count == count) {
+        return true;
+    }
+    _analysis_valid = false;
+    if (count == 0) {
+        return false;
+    }
+
+    if (_analysis_size < count) {
+        delete[] _analysis_legs;
+        _analysis_legs = new analysis_leg[count];
+        if (_analysis_legs == nullptr) {
+            _analysis_size = 0;
+            return false;
+        }
+        _analysis_size = count;
+    }
+
+    Mission_Command cmd;
+    if (!read_cmd_from_storage(0, cmd)) {
+        return false;
+    }
+    // legs start from home
+    Location prev = cmd.content.location;
+    float speed = -1;
+    _analysis_legs[0] = { 0, 0, 0, -1 };
+    _analysis_land_start_count = 0;
+
+    for (uint16_t i = 1; i < count; i++) {
+        if (!read_cmd_from_storage(i, cmd)) {
+            return false;
+        }
+        analysis_leg leg = _analysis_legs[i-1];
+        leg.speed = speed;
+        if (is_nav_cmd(cmd) &&
+            (cmd.content.location.lat != 0 || cmd.content.location.lng != 0)) {
+            // a zero location means the vehicle's current position
+            const float d = get_distance(prev, cmd.content.location);
+            leg.distance += d;
+            if (speed > 0) {
+                leg.fixed_time += d / speed;
+            } else {
+                leg.default_distance += d;
+            }
+            prev = cmd.content.location;
+        }
+        switch (cmd.id) {
+        case MAV_CMD_NAV_LOITER_TIME:
+            leg.fixed_time += cmd.p1;
+            break;
+        case MAV_CMD_DO_CHANGE_SPEED:
+            if (cmd.content.speed.target_ms > 0) {
+                speed = cmd.content.speed.target_ms;
+            }
+            break;
+        case MAV_CMD_DO_LAND_START:
+            if (_analysis_land_start_count < AP_MISSION_ANALYSIS_MAX_LAND_START) {
+                _analysis_land_start[_analysis_land_start_count] = i;
+            }
+            if (_analysis_land_start_count <= AP_MISSION_ANALYSIS_MAX_LAND_START) {
+                _analysis_land_start_count++;
+            }
+            break;
+        }
+        _analysis_legs[i] = leg;
+    }
+
+    _analysis_count = count;
+    _analysis_change_ms = _last_change_time_ms;
+    _analysis_valid = true;
+    return true;
+}
+#endif
+
+bool AP_Mission::get_mission_distance(float &distance)
+{
+#if AP_MISSION_ANALYSIS
+    if (!analysis_update()) {
+        return false;
+    }
+    distance = _analysis_legs[_analysis_count-1].distance;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AP_Mission::get_distance_remaining(const Location &loc, uint16_t index, float &distance)
+{
+#if AP_MISSION_ANALYSIS
+    Mission_Command cmd;
+    if (!analysis_update() || index >= _analysis_count || !read_cmd_from_storage(index, cmd)) {
+        return false;
+    }
+    distance = get_distance(loc, cmd.content.location) +
+        _analysis_legs[_analysis_count-1].distance - _analysis_legs[index].distance;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AP_Mission::get_time_remaining(const Location &loc, uint16_t index, float default_speed, float &time_s)
+{
+#if AP_MISSION_ANALYSIS
+    Mission_Command cmd;
+    if (default_speed <= 0 ||
+        !analysis_update() || index >= _analysis_count || !read_cmd_from_storage(index, cmd)) {
+        return false;
+    }
+    const analysis_leg &here = _analysis_legs[index];
+    const analysis_leg &end = _analysis_legs[_analysis_count-1];
+
+    // the leg to the current target, then the rest of the mission
+    const float d = get_distance(loc, cmd.content.location);
+    const float speed = here.speed > 0 ? here.speed : default_speed;
+    time_s = d / speed +
+        (end.default_distance - here.default_distance) / default_speed +
+        end.fixed_time - here.fixed_time;
+    if (cmd.id == MAV_CMD_NAV_LOITER_TIME) {
+        // still to do the loiter at the target
+        time_s += cmd.p1;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
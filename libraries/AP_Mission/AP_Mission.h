@@ -37,6 +37,27 @@
 
 #define AP_MISSION_RESTART_DEFAULT          0       // resume the mission from the last command run by default
 
+// keep decoded commands in RAM on boards with memory to spare, so
+// navigation doesn't re-read and decode storage on every lookup
+#ifndef AP_MISSION_CMD_CACHE
+#define AP_MISSION_CMD_CACHE (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// collect uploaded missions in RAM and write them to storage once
+// complete, on boards with the memory for it
+#ifndef AP_MISSION_UPLOAD_BUFFER
+#define AP_MISSION_UPLOAD_BUFFER (HAL_CPU_CLASS > HAL_CPU_CLASS_150)
+#endif
+
+// work out leg lengths and times once per mission change so
+// navigation and failsafe code can query them without reading the
+// whole mission
+#ifndef AP_MISSION_ANALYSIS
+#define AP_MISSION_ANALYSIS (HAL_CPU_CLASS > HAL_CPU_CLASS_150)
+#endif
+
+#define AP_MISSION_ANALYSIS_MAX_LAND_START  8       // DO_LAND_START commands remembered by the analysis
+
 /// @class    AP_Mission
 /// @brief    Object managing Mission
 class AP_Mission {
@@ -269,6 +290,24 @@ public:
         _prev_nav_cmd_index(AP_MISSION_CMD_INDEX_NONE),
         _prev_nav_cmd_wp_index(AP_MISSION_CMD_INDEX_NONE),
         _last_change_time_ms(0)
+#if AP_MISSION_UPLOAD_BUFFER
+        ,_upload(nullptr),
+        _upload_count(0),
+        _upload_size(0)
+#endif
+#if AP_MISSION_CMD_CACHE
+        ,_cmd_cache(nullptr),
+        _cmd_cache_valid(nullptr),
+        _cmd_cache_failed(false)
+#endif
+#if AP_MISSION_ANALYSIS
+        ,_analysis_legs(nullptr),
+        _analysis_size(0),
+        _analysis_count(0),
+        _analysis_change_ms(0),
+        _analysis_valid(false),
+        _analysis_land_start_count(0)
+#endif
     {
         // load parameter defaults
         AP_Param::setup_object_defaults(this, var_info);
@@ -339,6 +378,16 @@ public:
     ///     cmd.index is updated with it's new position in the mission
     bool add_cmd(Mission_Command& cmd);
 
+    /// staged upload - commands are collected in RAM with upload_set()
+    ///     and replace the stored mission only when upload_commit() is
+    ///     called, so an incomplete upload leaves the mission untouched.
+    ///     upload_start returns false if the mission can't be staged, in
+    ///     which case commands should be written with add_cmd/replace_cmd
+    bool upload_start(uint16_t count);
+    bool upload_set(uint16_t index, const Mission_Command& cmd);
+    bool upload_commit();
+    void upload_abort();
+
     /// replace_cmd - replaces the command at position 'index' in the command list with the provided cmd
     ///     replacing the current active command will have no effect until the command is restarted
     ///     returns true if successfully replaced, false on failure
@@ -422,6 +471,24 @@ public:
     // be found.
     uint16_t get_landing_sequence_start();
 
+    /// mission analysis - worked out from the stored commands once per
+    ///     mission change, following the commands in index order (the
+    ///     repeats of DO_JUMP are not counted). All return false if the
+    ///     analysis is not available
+
+    /// get_mission_distance - total length of the mission legs in meters, from home
+    bool get_mission_distance(float &distance);
+
+    /// get_distance_remaining - distance in meters left to fly from loc,
+    ///     going to the nav command at index and then on through the
+    ///     rest of the mission
+    bool get_distance_remaining(const Location &loc, uint16_t index, float &distance);
+
+    /// get_time_remaining - expected time in seconds for the same path.
+    ///     Legs are flown at the speed set by the last DO_CHANGE_SPEED or
+    ///     at default_speed (m/s) before any, and loiter times are added
+    bool get_time_remaining(const Location &loc, uint16_t index, float default_speed, float &time_s);
+
     // user settable parameters
     static const struct AP_Param::GroupInfo var_info[];
 
@@ -509,4 +576,43 @@ private:
 
     // last time that mission changed
     uint32_t _last_change_time_ms;
+
+#if AP_MISSION_UPLOAD_BUFFER
+    // commands of a staged upload
+    Mission_Command *_upload;
+    uint16_t _upload_count;
+    uint16_t _upload_size;
+#endif
+
+#if AP_MISSION_CMD_CACHE
+    // decoded copies of stored commands, indexed by command
+    // number. An entry is only used if its bit in _cmd_cache_valid is
+    // set. Writes clear the bit so the next read decodes storage again
+    mutable Mission_Command *_cmd_cache;
+    mutable uint32_t *_cmd_cache_valid;
+    mutable bool _cmd_cache_failed;
+
+    // allocate the cache on first use, returns false if unavailable
+    bool cmd_cache_alloc(void) const;
+#endif
+
+#if AP_MISSION_ANALYSIS
+    // running totals at the end of each command, indexed by command number
+    struct analysis_leg {
+        float distance;         // meters flown since home
+        float default_distance; // part of distance flown at the default speed
+        float fixed_time;       // seconds for the rest of distance and for loiters
+        float speed;            // speed in m/s set for the leg ending here, or -1 for default
+    };
+    analysis_leg *_analysis_legs;
+    uint16_t _analysis_size;            // number of entries allocated
+    uint16_t _analysis_count;           // number of commands analysed
+    uint32_t _analysis_change_ms;       // _last_change_time_ms when analysed
+    bool _analysis_valid;
+    uint16_t _analysis_land_start[AP_MISSION_ANALYSIS_MAX_LAND_START];
+    uint8_t _analysis_land_start_count; // above AP_MISSION_ANALYSIS_MAX_LAND_START if the list is incomplete
+
+    // bring the analysis up to date with the mission, returns false if unavailable
+    bool analysis_update(void);
+#endif
 };
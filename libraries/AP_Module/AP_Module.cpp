@@ -21,11 +21,16 @@
 #include <dirent.h>
 #if defined(HAVE_LIBDL)
 #include <dlfcn.h>
+#include <pthread.h>
+#include <unistd.h>
 #endif
 #include <AP_Module/AP_Module.h>
 #include <AP_Module/AP_Module_Structures.h>
 
 struct AP_Module::hook_list *AP_Module::hooks[NUM_HOOKS];
+struct AP_Module::async_module *AP_Module::async_modules;
+AP_Module::sample_ring<struct gyro_sample> *AP_Module::gyro_rings[INS_MAX_INSTANCES];
+AP_Module::sample_ring<struct accel_sample> *AP_Module::accel_rings[INS_MAX_INSTANCES];
 
 const char *AP_Module::hook_names[AP_Module::NUM_HOOKS] = {
     "ap_hook_setup_start",
@@ -33,6 +38,8 @@ const char *AP_Module::hook_names[AP_Module::NUM_HOOKS] = {
     "ap_hook_AHRS_update",
     "ap_hook_gyro_sample",
     "ap_hook_accel_sample",
+    "ap_hook_gyro_block",
+    "ap_hook_accel_block",
 };
 
 /*
@@ -47,6 +54,12 @@ void AP_Module::module_scan(const char *path)
         return;
     }
     uint8_t found_hooks = 0;
+    void *gyro_async = dlsym(m, "ap_hook_gyro_sample_async");
+    void *accel_async = dlsym(m, "ap_hook_accel_sample_async");
+    if (gyro_async != nullptr || accel_async != nullptr) {
+        async_start(path, gyro_async, accel_async);
+        found_hooks += (gyro_async != nullptr) + (accel_async != nullptr);
+    }
     for (uint16_t i=0; i<NUM_HOOKS; i++) {
         void *s = dlsym(m, hook_names[i]);
         if (s != nullptr) {
@@ -59,6 +72,15 @@ void AP_Module::module_scan(const char *path)
             h->symbol = s;
             hooks[i] = h;
             found_hooks++;
+            // the block hooks share one ring per instance
+            for (uint8_t j=0; j<INS_MAX_INSTANCES; j++) {
+                if (i == HOOK_GYRO_BLOCK && gyro_rings[j] == nullptr) {
+                    gyro_rings[j] = new sample_ring<struct gyro_sample>;
+                }
+                if (i == HOOK_ACCEL_BLOCK && accel_rings[j] == nullptr) {
+                    accel_rings[j] = new sample_ring<struct accel_sample>;
+                }
+            }
         }
     }
     if (found_hooks == 0) {
@@ -70,6 +92,117 @@ void AP_Module::module_scan(const char *path)
 #endif
 }
 
+/*
+  set up the sample queues for a module with asynchronous hooks, and
+  start the thread that calls them
+ */
+void AP_Module::async_start(const char *path, void *gyro_symbol, void *accel_symbol)
+{
+#if defined(HAVE_LIBDL)
+    struct async_module *m = new async_module {};
+    if (m == nullptr) {
+        AP_HAL::panic("Failed to allocate async module %s", path);
+    }
+    m->name = strdup(path);
+    m->gyro_symbol = gyro_symbol;
+    m->accel_symbol = accel_symbol;
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        if (gyro_symbol != nullptr) {
+            m->gyro_queue[i] = new ObjectBuffer<struct gyro_sample>(AP_MODULE_ASYNC_QUEUE_LEN);
+        }
+        if (accel_symbol != nullptr) {
+            m->accel_queue[i] = new ObjectBuffer<struct accel_sample>(AP_MODULE_ASYNC_QUEUE_LEN);
+        }
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, nullptr, async_thread, m) != 0) {
+        AP_HAL::panic("Failed to start thread for %s", path);
+    }
+    pthread_detach(thread);
+
+    // only publish the module once its queues exist
+    m->next = async_modules;
+    __atomic_store_n(&async_modules, m, __ATOMIC_RELEASE);
+#endif
+}
+
+/*
+  call a module's asynchronous hooks with the queued samples, oldest
+  first for each sensor instance
+ */
+void *AP_Module::async_thread(void *arg)
+{
+#if AP_MODULE_SUPPORTED
+    struct async_module *m = (struct async_module *)arg;
+    ap_hook_gyro_sample_fn_t gyro_fn = reinterpret_cast<ap_hook_gyro_sample_fn_t>(m->gyro_symbol);
+    ap_hook_accel_sample_fn_t accel_fn = reinterpret_cast<ap_hook_accel_sample_fn_t>(m->accel_symbol);
+    uint32_t last_dropped = 0;
+    uint32_t last_report_ms = 0;
+
+    while (true) {
+        bool idle = true;
+        for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+            struct gyro_sample gyro;
+            while (m->gyro_queue[i] != nullptr && m->gyro_queue[i]->pop(gyro)) {
+                gyro_fn(&gyro);
+                idle = false;
+            }
+            struct accel_sample accel;
+            while (m->accel_queue[i] != nullptr && m->accel_queue[i]->pop(accel)) {
+                accel_fn(&accel);
+                idle = false;
+            }
+        }
+
+        uint32_t now = AP_HAL::millis();
+        if (now - last_report_ms > 5000) {
+            uint32_t dropped = async_dropped(m);
+            if (dropped != last_dropped) {
+                printf("AP_Module: %s dropped %u samples\n", m->name, (unsigned)(dropped - last_dropped));
+                last_dropped = dropped;
+            }
+            last_report_ms = now;
+        }
+
+        if (idle) {
+            usleep(250);
+        }
+    }
+#endif
+    return nullptr;
+}
+
+uint32_t AP_Module::async_dropped(const struct async_module *m)
+{
+    uint32_t dropped = 0;
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        dropped += m->gyro_dropped[i] + m->accel_dropped[i];
+    }
+    return dropped;
+}
+
+/*
+  number of samples dropped by all asynchronous modules, and because the
+  block hooks weren't called often enough
+ */
+uint32_t AP_Module::async_samples_dropped(void)
+{
+    uint32_t dropped = 0;
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        if (gyro_rings[i] != nullptr) {
+            dropped += gyro_rings[i]->dropped;
+        }
+        if (accel_rings[i] != nullptr) {
+            dropped += accel_rings[i]->dropped;
+        }
+    }
+    for (const struct async_module *m=__atomic_load_n(&async_modules, __ATOMIC_ACQUIRE); m; m=m->next) {
+        dropped += async_dropped(m);
+    }
+    return dropped;
+}
+
 /*
   initialise AP_Module, looking for shared libraries in the given module path
 */
@@ -126,12 +259,50 @@ void AP_Module::call_hook_setup_complete(void)
 #endif
 }
 
+/*
+  call the gyro_block and accel_block hooks with the samples queued
+  since the last call, up to two runs per instance when the ring wraps
+*/
+void AP_Module::call_hook_blocks(void)
+{
+#if AP_MODULE_SUPPORTED
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        if (gyro_rings[i] != nullptr) {
+            const struct gyro_sample *samples;
+            uint16_t n;
+            while ((n = gyro_rings[i]->run(samples)) > 0) {
+                for (const struct hook_list *h=hooks[HOOK_GYRO_BLOCK]; h; h=h->next) {
+                    ap_hook_gyro_block_fn_t fn = reinterpret_cast<ap_hook_gyro_block_fn_t>(h->symbol);
+                    fn(i, samples, n);
+                }
+                gyro_rings[i]->consume(n);
+            }
+        }
+        if (accel_rings[i] != nullptr) {
+            const struct accel_sample *samples;
+            uint16_t n;
+            while ((n = accel_rings[i]->run(samples)) > 0) {
+                for (const struct hook_list *h=hooks[HOOK_ACCEL_BLOCK]; h; h=h->next) {
+                    ap_hook_accel_block_fn_t fn = reinterpret_cast<ap_hook_accel_block_fn_t>(h->symbol);
+                    fn(i, samples, n);
+                }
+                accel_rings[i]->consume(n);
+            }
+        }
+    }
+#endif
+}
+
 /*
   call any AHRS_update hooks
 */
 void AP_Module::call_hook_AHRS_update(const AP_AHRS_NavEKF &ahrs)
 {
 #if AP_MODULE_SUPPORTED
+    // the block hooks are run once per frame, ahead of the AHRS
+    // state for it
+    call_hook_blocks();
+
     if (hooks[HOOK_AHRS_UPDATE] == nullptr) {
         // avoid filling in AHRS_state
         return;
@@ -224,7 +395,7 @@ void AP_Module::call_hook_AHRS_update(const AP_AHRS_NavEKF &ahrs)
 void AP_Module::call_hook_gyro_sample(uint8_t instance, float dt, const Vector3f &gyro)
 {
 #if AP_MODULE_SUPPORTED
-    if (hooks[HOOK_GYRO_SAMPLE] == nullptr) {
+    if (hooks[HOOK_GYRO_SAMPLE] == nullptr && async_modules == nullptr && hooks[HOOK_GYRO_BLOCK] == nullptr) {
         // avoid filling in struct
         return;
     }
@@ -245,6 +416,17 @@ void AP_Module::call_hook_gyro_sample(uint8_t instance, float dt, const Vector3f
         ap_hook_gyro_sample_fn_t fn = reinterpret_cast<ap_hook_gyro_sample_fn_t>(h->symbol);
         fn(&state);
     }
+
+    if (instance < INS_MAX_INSTANCES) {
+        for (struct async_module *m=__atomic_load_n(&async_modules, __ATOMIC_ACQUIRE); m; m=m->next) {
+            if (m->gyro_queue[instance] != nullptr && !m->gyro_queue[instance]->push(state)) {
+                m->gyro_dropped[instance]++;
+            }
+        }
+        if (gyro_rings[instance] != nullptr) {
+            gyro_rings[instance]->push(state);
+        }
+    }
 #endif
 }
 
@@ -254,7 +436,7 @@ void AP_Module::call_hook_gyro_sample(uint8_t instance, float dt, const Vector3f
 void AP_Module::call_hook_accel_sample(uint8_t instance, float dt, const Vector3f &accel, bool fsync_set)
 {
 #if AP_MODULE_SUPPORTED
-    if (hooks[HOOK_ACCEL_SAMPLE] == nullptr) {
+    if (hooks[HOOK_ACCEL_SAMPLE] == nullptr && async_modules == nullptr && hooks[HOOK_ACCEL_BLOCK] == nullptr) {
         // avoid filling in struct
         return;
     }
@@ -276,5 +458,16 @@ void AP_Module::call_hook_accel_sample(uint8_t instance, float dt, const Vector3
         ap_hook_accel_sample_fn_t fn = reinterpret_cast<ap_hook_accel_sample_fn_t>(h->symbol);
         fn(&state);
     }
+
+    if (instance < INS_MAX_INSTANCES) {
+        for (struct async_module *m=__atomic_load_n(&async_modules, __ATOMIC_ACQUIRE); m; m=m->next) {
+            if (m->accel_queue[instance] != nullptr && !m->accel_queue[instance]->push(state)) {
+                m->accel_dropped[instance]++;
+            }
+        }
+        if (accel_rings[instance] != nullptr) {
+            accel_rings[instance]->push(state);
+        }
+    }
 #endif
 }
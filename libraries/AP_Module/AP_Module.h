@@ -24,11 +24,22 @@
   handling
   ******************************************************************
 
+  A module may instead export ap_hook_gyro_sample_async() and
+  ap_hook_accel_sample_async(). Samples for those are queued and the
+  hooks are called from a thread AP_Module starts for the module, so a
+  slow module loses samples rather than holding up the sensor drivers.
+
+  ap_hook_gyro_block() and ap_hook_accel_block() are handed all the
+  samples of a sensor instance since the last main loop frame at once,
+  straight from the ring they were queued in, just before the
+  AHRS_update hooks are called.
+
  */
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
 #include <AP_AHRS/AP_AHRS.h>
+#include <AP_HAL/utility/RingBuffer.h>
 
 #ifdef HAVE_LIBDL
 #define AP_MODULE_SUPPORTED 1
@@ -40,6 +51,20 @@
 #define AP_MODULE_DEFAULT_DIRECTORY "/usr/lib/ardupilot/modules"
 #endif
 
+// samples queued per sensor instance for an asynchronous module
+#ifndef AP_MODULE_ASYNC_QUEUE_LEN
+#define AP_MODULE_ASYNC_QUEUE_LEN 256
+#endif
+
+// samples held per sensor instance for the block hooks, must be a
+// power of two
+#ifndef AP_MODULE_BLOCK_LEN
+#define AP_MODULE_BLOCK_LEN 512
+#endif
+
+struct gyro_sample;
+struct accel_sample;
+
 class AP_Module {
 public:
 
@@ -60,7 +85,10 @@ public:
 
     // call any accel_sample hooks
     static void call_hook_accel_sample(uint8_t instance, float dt, const Vector3f &accel, bool fsync_set);
-    
+
+    // number of samples dropped because an asynchronous module fell
+    // behind
+    static uint32_t async_samples_dropped(void);
     
 private:
 
@@ -70,6 +98,8 @@ private:
         HOOK_AHRS_UPDATE,
         HOOK_GYRO_SAMPLE,
         HOOK_ACCEL_SAMPLE,
+        HOOK_GYRO_BLOCK,
+        HOOK_ACCEL_BLOCK,
         NUM_HOOKS
     };
 
@@ -87,6 +117,72 @@ private:
     // match the ModuleHooks enum
     static const char *hook_names[NUM_HOOKS];
     
+    /*
+      a module with asynchronous sample hooks. Each sensor instance
+      gets its own queue, as each is fed by a single driver thread
+     */
+    struct async_module {
+        struct async_module *next;
+        const char *name;
+        void *gyro_symbol;
+        void *accel_symbol;
+        ObjectBuffer<struct gyro_sample> *gyro_queue[INS_MAX_INSTANCES];
+        ObjectBuffer<struct accel_sample> *accel_queue[INS_MAX_INSTANCES];
+        // samples lost to full queues, each only written by the
+        // thread feeding the queue
+        uint32_t gyro_dropped[INS_MAX_INSTANCES];
+        uint32_t accel_dropped[INS_MAX_INSTANCES];
+    };
+    static struct async_module *async_modules;
+
+    /*
+      samples of one sensor instance for the block hooks, filled by
+      the driver thread and handed to the hooks in place from the main
+      thread
+     */
+    template <class T>
+    struct sample_ring {
+        T samples[AP_MODULE_BLOCK_LEN];
+        std::atomic<uint32_t> head{0}; // next sample to hand over
+        std::atomic<uint32_t> tail{0}; // next sample to fill
+        uint32_t dropped;
+
+        void push(const T &sample) {
+            const uint32_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) >= AP_MODULE_BLOCK_LEN) {
+                dropped++;
+                return;
+            }
+            samples[t & (AP_MODULE_BLOCK_LEN-1)] = sample;
+            tail.store(t+1, std::memory_order_release);
+        }
+
+        // oldest contiguous run of samples, returning its length
+        uint16_t run(const T *&first) const {
+            const uint32_t h = head.load(std::memory_order_relaxed);
+            const uint32_t ofs = h & (AP_MODULE_BLOCK_LEN-1);
+            first = &samples[ofs];
+            return MIN(tail.load(std::memory_order_acquire) - h, AP_MODULE_BLOCK_LEN - ofs);
+        }
+
+        // release samples handed over by run()
+        void consume(uint16_t n) {
+            head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        }
+    };
+    static sample_ring<struct gyro_sample> *gyro_rings[INS_MAX_INSTANCES];
+    static sample_ring<struct accel_sample> *accel_rings[INS_MAX_INSTANCES];
+
+    // pass queued samples to the block hooks
+    static void call_hook_blocks(void);
+
     // scan a module for hooks
     static void module_scan(const char *path);
+
+    // set up the queues and thread for a module's asynchronous hooks
+    static void async_start(const char *path, void *gyro_symbol, void *accel_symbol);
+
+    // thread calling a module's asynchronous hooks
+    static void *async_thread(void *arg);
+    static uint32_t async_dropped(const struct async_module *m);
 };
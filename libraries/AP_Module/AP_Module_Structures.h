@@ -157,6 +157,27 @@ void ap_hook_gyro_sample(const struct gyro_sample *state);
 
 typedef void (*ap_hook_accel_sample_fn_t)(const struct accel_sample *);
 void ap_hook_accel_sample(const struct accel_sample *state);
+
+/*
+  asynchronous versions of the sample hooks, called from a thread of
+  the module's own with samples queued by the sensor drivers. Samples
+  from different instances may arrive out of time order. If the module
+  falls behind, new samples are dropped
+ */
+void ap_hook_gyro_sample_async(const struct gyro_sample *state);
+void ap_hook_accel_sample_async(const struct accel_sample *state);
+
+/*
+  blocks of samples from one sensor instance, oldest first, called
+  once or twice per main loop frame just before the AHRS_update
+  hooks. The samples are read in place from the ring they were queued
+  in, and are only valid for the duration of the call
+ */
+typedef void (*ap_hook_gyro_block_fn_t)(uint8_t, const struct gyro_sample *, uint16_t);
+void ap_hook_gyro_block(uint8_t instance, const struct gyro_sample *samples, uint16_t count);
+
+typedef void (*ap_hook_accel_block_fn_t)(uint8_t, const struct accel_sample *, uint16_t);
+void ap_hook_accel_block(uint8_t instance, const struct accel_sample *samples, uint16_t count);
     
 #ifdef __cplusplus
 }
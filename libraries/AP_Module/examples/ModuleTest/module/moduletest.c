@@ -71,3 +71,21 @@ void ap_hook_accel_sample(const struct accel_sample *state)
            (unsigned long)counter,
            (unsigned long)fsync_count);
 }
+
+void ap_hook_gyro_block(uint8_t instance, const struct gyro_sample *samples, uint16_t count)
+{
+    static uint64_t last_print_us;
+    static uint32_t blocks, total;
+    if (instance != 0 || count == 0) {
+        return;
+    }
+    blocks++;
+    total += count;
+    if (samples[count-1].time_us - last_print_us < 1000000UL) {
+        return;
+    }
+    last_print_us = samples[count-1].time_us;
+    // print the average block size once per second
+    printf("gyro_block %.1f samples/block\n", total / (float)blocks);
+    blocks = total = 0;
+}
@@ -193,21 +193,18 @@ void AP_MotorsMatrix::output_armed_stabilizing()
 
     // calculate roll and pitch for each motor
     // calculate the amount of yaw input that each motor can accept
-    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = roll_thrust * _roll_factor[i] + pitch_thrust * _pitch_factor[i];
-            if (!is_zero(_yaw_factor[i])){
-                if (yaw_thrust * _yaw_factor[i] > 0.0f) {
-                    unused_range = fabsf((1.0f - (throttle_thrust_best_rpy + _thrust_rpyt_out[i]))/_yaw_factor[i]);
-                    if (yaw_allowed > unused_range) {
-                        yaw_allowed = unused_range;
-                    }
-                } else {
-                    unused_range = fabsf((throttle_thrust_best_rpy + _thrust_rpyt_out[i])/_yaw_factor[i]);
-                    if (yaw_allowed > unused_range) {
-                        yaw_allowed = unused_range;
-                    }
-                }
+    float rpy_out[AP_MOTORS_MAX_NUM_MOTORS];
+    for (i=0; i<_mix_count; i++) {
+        const mix_factor &mix = _mix[i];
+        rpy_out[i] = roll_thrust * mix.roll + pitch_thrust * mix.pitch;
+        if (mix.yaw_inv > 0.0f) {
+            if (yaw_thrust * mix.yaw > 0.0f) {
+                unused_range = fabsf(1.0f - (throttle_thrust_best_rpy + rpy_out[i])) * mix.yaw_inv;
+            } else {
+                unused_range = fabsf(throttle_thrust_best_rpy + rpy_out[i]) * mix.yaw_inv;
+            }
+            if (yaw_allowed > unused_range) {
+                yaw_allowed = unused_range;
             }
         }
     }
@@ -223,19 +220,12 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     // add yaw to intermediate numbers for each motor
     rpy_low = 0.0f;
     rpy_high = 0.0f;
-    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = _thrust_rpyt_out[i] + yaw_thrust * _yaw_factor[i];
+    for (i=0; i<_mix_count; i++) {
+        rpy_out[i] += yaw_thrust * _mix[i].yaw;
 
-            // record lowest roll+pitch+yaw command
-            if (_thrust_rpyt_out[i] < rpy_low) {
-                rpy_low = _thrust_rpyt_out[i];
-            }
-            // record highest roll+pitch+yaw command
-            if (_thrust_rpyt_out[i] > rpy_high) {
-                rpy_high = _thrust_rpyt_out[i];
-            }
-        }
+        // record lowest and highest roll+pitch+yaw command
+        rpy_low = MIN(rpy_low, rpy_out[i]);
+        rpy_high = MAX(rpy_high, rpy_out[i]);
     }
 
     // check everything fits
@@ -268,18 +258,11 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     }
 
     // add scaled roll, pitch, constrained yaw and throttle for each motor
-    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = throttle_thrust_best_rpy + thr_adj + rpy_scale*_thrust_rpyt_out[i];
-        }
-    }
-
-    // constrain all outputs to 0.0f to 1.0f
-    // test code should be run with these lines commented out as they should not do anything
-    for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = constrain_float(_thrust_rpyt_out[i], 0.0f, 1.0f);
-        }
+    // and constrain all outputs to 0.0f to 1.0f
+    // test code should be run without the constrain as it should not do anything
+    const float thr_out = throttle_thrust_best_rpy + thr_adj;
+    for (i=0; i<_mix_count; i++) {
+        _thrust_rpyt_out[_mix_motor[i]] = constrain_float(thr_out + rpy_scale*rpy_out[i], 0.0f, 1.0f);
     }
 }
 
@@ -325,6 +308,8 @@ void AP_MotorsMatrix::add_motor_raw(int8_t motor_num, float roll_fac, float pitc
 
         // call parent class method
         add_motor_num(motor_num);
+
+        compile_mix();
     }
 }
 
@@ -355,6 +340,8 @@ void AP_MotorsMatrix::remove_motor(int8_t motor_num)
         _roll_factor[motor_num] = 0;
         _pitch_factor[motor_num] = 0;
         _yaw_factor[motor_num] = 0;
+
+        compile_mix();
     }
 }
 
@@ -402,6 +389,29 @@ void AP_MotorsMatrix::normalise_rpy_factors()
             }
         }
     }
+
+    compile_mix();
+}
+
+/*
+  pack the factors of the enabled motors into one table so the mixer
+  makes dense passes over it, and replace the per motor division in
+  the yaw headroom check with a multiply
+ */
+void AP_MotorsMatrix::compile_mix()
+{
+    _mix_count = 0;
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (motor_enabled[i]) {
+            mix_factor &mix = _mix[_mix_count];
+            mix.roll = _roll_factor[i];
+            mix.pitch = _pitch_factor[i];
+            mix.yaw = _yaw_factor[i];
+            mix.yaw_inv = is_zero(_yaw_factor[i]) ? 0.0f : 1.0f / fabsf(_yaw_factor[i]);
+            _mix_motor[_mix_count] = i;
+            _mix_count++;
+        }
+    }
 }
 
 
@@ -71,10 +71,24 @@ protected:
 
     // call vehicle supplied thrust compensation if set
     void                thrust_compensation(void) override;
+
+    // packs the factors of the enabled motors into _mix
+    void                compile_mix();
     
     float               _roll_factor[AP_MOTORS_MAX_NUM_MOTORS]; // each motors contribution to roll
     float               _pitch_factor[AP_MOTORS_MAX_NUM_MOTORS]; // each motors contribution to pitch
     float               _yaw_factor[AP_MOTORS_MAX_NUM_MOTORS];  // each motors contribution to yaw (normally 1 or -1)
     float               _thrust_rpyt_out[AP_MOTORS_MAX_NUM_MOTORS]; // combined roll, pitch, yaw and throttle outputs to motors in 0~1 range
     uint8_t             _test_order[AP_MOTORS_MAX_NUM_MOTORS];  // order of the motors in the test sequence
+
+    // factors of the enabled motors packed together so the mixer can
+    // run over them without skipping disabled slots
+    struct mix_factor {
+        float roll;
+        float pitch;
+        float yaw;
+        float yaw_inv;      // 1/|yaw|, zero for motors that give no yaw
+    } _mix[AP_MOTORS_MAX_NUM_MOTORS];
+    uint8_t             _mix_motor[AP_MOTORS_MAX_NUM_MOTORS];   // motor number of each _mix entry
+    uint8_t             _mix_count = 0;                         // number of enabled motors in _mix
 };
@@ -82,8 +82,8 @@ const AP_Param::GroupInfo AP_MotorsMulticopter::var_info[] = {
 
     // @Param: PWM_TYPE
     // @DisplayName: Output PWM type
-    // @Description: This selects the output PWM type, allowing for normal PWM continuous output or OneShot125
-    // @Values: 0:Normal,1:OneShot,2:OneShot125
+    // @Description: This selects the output PWM type, allowing for normal PWM continuous output, OneShot125 or the DShot digital protocol. Arming is refused if the board can't generate DShot
+    // @Values: 0:Normal,1:OneShot,2:OneShot125,3:DShot150,4:DShot300,5:DShot600
     // @User: Advanced
     AP_GROUPINFO("PWM_TYPE", 15, AP_MotorsMulticopter, _pwm_type, PWM_TYPE_NORMAL),
 
@@ -151,7 +151,11 @@ AP_MotorsMulticopter::AP_MotorsMulticopter(uint16_t loop_rate, uint16_t speed_hz
     _batt_timer(0),
     _lift_max(1.0f),
     _throttle_limit(1.0f),
-    _throttle_thrust_max(0.0f)
+    _throttle_thrust_max(0.0f),
+    _thrust_curve_table_ok(false),
+    _thrust_curve_table_expo(-1.0f),
+    _thrust_curve_table_lift_max(0.0f),
+    _thrust_curve_table_batt(0.0f)
 {
     AP_Param::setup_object_defaults(this, var_info);
 
@@ -178,6 +182,9 @@ void AP_MotorsMulticopter::output()
     // calc filtered battery voltage and lift_max
     update_lift_max_from_batt_voltage();
 
+    // refresh the thrust curve table for the new lift_max
+    update_thrust_curve_table();
+
     // run spool logic
     output_logic();
 
@@ -252,16 +259,69 @@ float AP_MotorsMulticopter::apply_thrust_curve_and_volt_scaling(float thrust) co
     float throttle_ratio = thrust;
     // apply thrust curve - domain 0.0 to 1.0, range 0.0 to 1.0
     if (_thrust_curve_expo > 0.0f){
-        if(!is_zero(_batt_voltage_filt.get())) {
-            throttle_ratio = ((_thrust_curve_expo-1.0f) + safe_sqrt((1.0f-_thrust_curve_expo)*(1.0f-_thrust_curve_expo) + 4.0f*_thrust_curve_expo*_lift_max*thrust))/(2.0f*_thrust_curve_expo*_batt_voltage_filt.get());
+        if (_thrust_curve_table_ok && is_equal(_thrust_curve_table_expo, _thrust_curve_expo.get())) {
+            // interpolate the lookup table
+            const float pos = constrain_float(thrust, 0.0f, 1.0f) * AP_MOTORS_THST_CURVE_SEGMENTS;
+            const uint8_t i = MIN((uint8_t)pos, AP_MOTORS_THST_CURVE_SEGMENTS-1);
+            throttle_ratio = _thrust_curve_table[i] + (_thrust_curve_table[i+1] - _thrust_curve_table[i]) * (pos - i);
         } else {
-            throttle_ratio = ((_thrust_curve_expo-1.0f) + safe_sqrt((1.0f-_thrust_curve_expo)*(1.0f-_thrust_curve_expo) + 4.0f*_thrust_curve_expo*_lift_max*thrust))/(2.0f*_thrust_curve_expo);
+            throttle_ratio = thrust_curve(thrust);
         }
     }
 
     return constrain_float(throttle_ratio, 0.0f, 1.0f);
 }
 
+// thrust_curve - thrust curve and voltage scaling computed directly, not constrained
+float AP_MotorsMulticopter::thrust_curve(float thrust) const
+{
+    float throttle_ratio = ((_thrust_curve_expo-1.0f) + safe_sqrt((1.0f-_thrust_curve_expo)*(1.0f-_thrust_curve_expo) + 4.0f*_thrust_curve_expo*_lift_max*thrust))/(2.0f*_thrust_curve_expo);
+    if (!is_zero(_batt_voltage_filt.get())) {
+        throttle_ratio /= _batt_voltage_filt.get();
+    }
+    return throttle_ratio;
+}
+
+/*
+  update_thrust_curve_table - the curve only changes with the expo and
+  the filtered battery voltage, which moves slowly, so it is sampled
+  into a table here and interpolated per motor instead of taking a
+  square root per motor per loop. High expos bend the curve too
+  sharply near zero thrust for the table, those use the exact curve
+ */
+void AP_MotorsMulticopter::update_thrust_curve_table()
+{
+    const float expo = _thrust_curve_expo;
+    const float batt = _batt_voltage_filt.get();
+    if (is_equal(expo, _thrust_curve_table_expo) &&
+        fabsf(_lift_max - _thrust_curve_table_lift_max) <= AP_MOTORS_THST_CURVE_REBUILD &&
+        fabsf(batt - _thrust_curve_table_batt) <= AP_MOTORS_THST_CURVE_REBUILD) {
+        return;
+    }
+    _thrust_curve_table_expo = expo;
+    _thrust_curve_table_lift_max = _lift_max;
+    _thrust_curve_table_batt = batt;
+    _thrust_curve_table_ok = false;
+
+    if (expo <= 0.0f) {
+        // linear, no table needed
+        return;
+    }
+
+    for (uint8_t i=0; i<=AP_MOTORS_THST_CURVE_SEGMENTS; i++) {
+        _thrust_curve_table[i] = thrust_curve((float)i / AP_MOTORS_THST_CURVE_SEGMENTS);
+    }
+
+    // check the worst interpolation error, which is near the middle of a segment
+    for (uint8_t i=0; i<AP_MOTORS_THST_CURVE_SEGMENTS; i++) {
+        const float mid = thrust_curve((i + 0.5f) / AP_MOTORS_THST_CURVE_SEGMENTS);
+        if (fabsf(mid - 0.5f*(_thrust_curve_table[i] + _thrust_curve_table[i+1])) > AP_MOTORS_THST_CURVE_TOL) {
+            return;
+        }
+    }
+    _thrust_curve_table_ok = true;
+}
+
 // update_lift_max from battery voltage - used for voltage compensation
 void AP_MotorsMulticopter::update_lift_max_from_batt_voltage()
 {
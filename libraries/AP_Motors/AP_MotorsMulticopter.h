@@ -25,6 +25,9 @@
 #define AP_MOTORS_BAT_CURR_MAX_DEFAULT  0.0f    // current limiting max default
 #define AP_MOTORS_BAT_CURR_TC_DEFAULT   5.0f    // Time constant used to limit the maximum current
 #define AP_MOTORS_BATT_VOLT_FILT_HZ     0.5f    // battery voltage filtered at 0.5hz
+#define AP_MOTORS_THST_CURVE_SEGMENTS   64      // number of segments in the thrust curve lookup table
+#define AP_MOTORS_THST_CURVE_TOL        0.001f  // largest interpolation error allowed before falling back to the exact curve
+#define AP_MOTORS_THST_CURVE_REBUILD    0.002f  // change in lift max or battery voltage ratio that rebuilds the thrust curve table
 
 // spool definition
 #define AP_MOTORS_SPOOL_UP_TIME         0.5f    // time (in seconds) for throttle to increase from zero to min throttle, and min throttle to full throttle.
@@ -122,6 +125,12 @@ protected:
     // update_lift_max_from_batt_voltage - used for voltage compensation
     void                update_lift_max_from_batt_voltage();
 
+    // thrust_curve - thrust curve and voltage scaling computed directly, not constrained
+    float               thrust_curve(float thrust) const;
+
+    // update_thrust_curve_table - rebuild the thrust curve lookup table if the expo or voltage scaling moved
+    void                update_thrust_curve_table();
+
     // update_battery_resistance - calculate battery resistance when throttle is above hover_out
     void                update_battery_resistance();
 
@@ -181,6 +190,13 @@ protected:
     float               _throttle_limit;        // ratio of throttle limit between hover and maximum
     float               _throttle_thrust_max;   // the maximum allowed throttle thrust 0.0 to 1.0 in the range throttle_min to throttle_max
 
+    // thrust curve lookup table, sampled at even steps of thrust
+    float               _thrust_curve_table[AP_MOTORS_THST_CURVE_SEGMENTS+1];
+    bool                _thrust_curve_table_ok;         // true if the table is within AP_MOTORS_THST_CURVE_TOL of the exact curve
+    float               _thrust_curve_table_expo;       // expo the table was built with
+    float               _thrust_curve_table_lift_max;   // lift max the table was built with
+    float               _thrust_curve_table_batt;       // battery voltage ratio the table was built with
+
     // vehicle supplied callback for thrust compensation. Used for tiltrotors and tiltwings
     thrust_compensation_fn_t _thrust_compensation_callback;
 };
@@ -38,7 +38,8 @@ AP_Motors::AP_Motors(uint16_t loop_rate, uint16_t speed_hz) :
     _batt_current(0.0f),
     _air_density_ratio(1.0f),
     _motor_map_mask(0),
-    _motor_fast_mask(0)
+    _motor_fast_mask(0),
+    _pwm_type_unsupported(false)
 {
     // init other flags
     _flags.armed = false;
@@ -119,6 +120,24 @@ void AP_Motors::rc_set_freq(uint32_t mask, uint16_t freq_hz)
         // tell HAL to do immediate output
         hal.rcout->set_output_mode(AP_HAL::RCOutput::MODE_PWM_ONESHOT);
     }
+    if (_pwm_type >= PWM_TYPE_DSHOT150 &&
+        _pwm_type <= PWM_TYPE_DSHOT600 &&
+        freq_hz > 50 &&
+        mask != 0) {
+        AP_HAL::RCOutput::output_mode mode = AP_HAL::RCOutput::MODE_DSHOT600;
+        if (_pwm_type == PWM_TYPE_DSHOT150) {
+            mode = AP_HAL::RCOutput::MODE_DSHOT150;
+        } else if (_pwm_type == PWM_TYPE_DSHOT300) {
+            mode = AP_HAL::RCOutput::MODE_DSHOT300;
+        }
+        hal.rcout->set_output_mode(mode);
+        if (hal.rcout->get_output_mode() != mode) {
+            // the board can't do DShot, stay on normal PWM at the
+            // requested rate and have the vehicle refuse to arm
+            hal.rcout->set_output_mode(AP_HAL::RCOutput::MODE_PWM_NORMAL);
+            _pwm_type_unsupported = true;
+        }
+    }
 }
 
 void AP_Motors::rc_enable_ch(uint8_t chan)
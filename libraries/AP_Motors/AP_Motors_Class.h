@@ -134,8 +134,17 @@ public:
     // set loop rate. Used to support loop rate as a parameter
     void                set_loop_rate(uint16_t loop_rate) { _loop_rate = loop_rate; }
 
-    enum pwm_type { PWM_TYPE_NORMAL=0, PWM_TYPE_ONESHOT=1, PWM_TYPE_ONESHOT125=2 };
+    enum pwm_type { PWM_TYPE_NORMAL=0,
+                    PWM_TYPE_ONESHOT=1,
+                    PWM_TYPE_ONESHOT125=2,
+                    PWM_TYPE_DSHOT150=3,
+                    PWM_TYPE_DSHOT300=4,
+                    PWM_TYPE_DSHOT600=5 };
     pwm_type            get_pwm_type(void) const { return (pwm_type)_pwm_type.get(); }
+
+    // true if MOT_PWM_TYPE asks for an output type the board can't produce. The motors
+    // then get normal PWM, which digital ESCs don't respond to, so arming should be refused
+    bool                pwm_type_unsupported(void) const { return _pwm_type_unsupported; }
     
 protected:
     // output functions that should be overloaded by child classes
@@ -195,4 +204,5 @@ protected:
     float _yaw_radio_passthrough = 0.0f;      // yaw input from pilot in -1 ~ +1 range.  used for setup and providing servo feedback while landed
 
     AP_Int8             _pwm_type;            // PWM output type
+    bool                _pwm_type_unsupported; // true if the board rejected the _pwm_type output mode
 };
@@ -0,0 +1,106 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Motors/AP_Motors.h>
+
+/*
+  per call cost of mixing roll, pitch, yaw and throttle into motor
+  outputs for the common matrix frames. output_armed_stabilizing() is
+  timed on its own, without the PWM writes of output()
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define BM_LOOP_RATE_HZ     400
+#define BM_DT               (1.0f / BM_LOOP_RATE_HZ)
+// one second of inputs
+#define BM_TRACE_LENGTH     BM_LOOP_RATE_HZ
+
+struct bm_input {
+    float roll;
+    float pitch;
+    float yaw;
+    float throttle;
+};
+
+static bm_input trace[BM_TRACE_LENGTH];
+
+// sweeps large enough to hit the rpy limits some of the time
+static void make_trace()
+{
+    for (uint16_t i = 0; i < BM_TRACE_LENGTH; i++) {
+        const float t = i * BM_DT;
+        trace[i].roll = 0.6f * sinf(2 * M_PI * 1.3f * t);
+        trace[i].pitch = 0.5f * sinf(2 * M_PI * 0.7f * t + 1.0f);
+        trace[i].yaw = 0.4f * sinf(2 * M_PI * 0.4f * t);
+        trace[i].throttle = 0.5f + 0.4f * sinf(2 * M_PI * 2.1f * t);
+    }
+}
+
+// exposes the mixer of a frame class to the benchmark
+template <typename Motors>
+class BM_Motors : public Motors {
+public:
+    BM_Motors() : Motors(BM_LOOP_RATE_HZ) {
+        this->set_frame_orientation(AP_MOTORS_X_FRAME);
+        this->Init();
+        this->armed(true);
+        // as if spooled up to full throttle range
+        this->_throttle_thrust_max = 1.0f;
+    }
+
+    using Motors::output_armed_stabilizing;
+    using Motors::update_throttle_filter;
+    using Motors::update_thrust_curve_table;
+    using Motors::calc_thrust_to_pwm;
+};
+
+template <typename Motors>
+static void BM_OutputArmedStabilizing(benchmark::State& state)
+{
+    static bool trace_made;
+    if (!trace_made) {
+        make_trace();
+        trace_made = true;
+    }
+    BM_Motors<Motors> motors;
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        const bm_input &in = trace[i];
+        motors.set_roll(in.roll);
+        motors.set_pitch(in.pitch);
+        motors.set_yaw(in.yaw);
+        motors.set_throttle(in.throttle);
+        motors.update_throttle_filter();
+        motors.output_armed_stabilizing();
+        i = (i + 1) % BM_TRACE_LENGTH;
+    }
+}
+
+// thrust to PWM for every motor of an octa, as done by output_to_motors()
+static void BM_ThrustToPwm(benchmark::State& state)
+{
+    BM_Motors<AP_MotorsOcta> motors;
+    motors.update_thrust_curve_table();
+    float thrust = 0.0f;
+    int16_t out[8];
+    while (state.KeepRunning()) {
+        for (uint8_t m = 0; m < 8; m++) {
+            out[m] = motors.calc_thrust_to_pwm(thrust + m * 0.1f);
+        }
+        gbenchmark_escape(out);
+        thrust += 0.01f;
+        if (thrust > 0.3f) {
+            thrust = 0.0f;
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_OutputArmedStabilizing, AP_MotorsQuad);
+BENCHMARK_TEMPLATE(BM_OutputArmedStabilizing, AP_MotorsHexa);
+BENCHMARK_TEMPLATE(BM_OutputArmedStabilizing, AP_MotorsY6);
+BENCHMARK_TEMPLATE(BM_OutputArmedStabilizing, AP_MotorsOcta);
+BENCHMARK_TEMPLATE(BM_OutputArmedStabilizing, AP_MotorsOctaQuad);
+BENCHMARK(BM_ThrustToPwm);
+
+BENCHMARK_MAIN()
@@ -68,6 +68,7 @@ void SoloGimbal::receive_feedback(mavlink_channel_t chan, mavlink_message_t *msg
                 _filtered_joint_angles = _measurement.joint_angles;
                 _vehicle_to_gimbal_quat_filt.from_vector312(_filtered_joint_angles.x,_filtered_joint_angles.y,_filtered_joint_angles.z);
                 _ekf.reset();
+                memset(&_ekf_accum, 0, sizeof(_ekf_accum));
                 _state = GIMBAL_STATE_PRESENT_ALIGNING;
             }
             break;
@@ -203,11 +204,43 @@ void SoloGimbal::update_estimators()
         return;
     }
 
-    // Run the gimbal attitude and gyro bias estimator
-    _ekf.RunEKF(_measurement.delta_time, _measurement.delta_angles, _measurement.delta_velocity, _measurement.joint_angles);
+    // Run the gimbal attitude and gyro bias estimator, on several
+    // reports at once if it is taking too much time
+    _ekf_accum.delta_time += _measurement.delta_time;
+    _ekf_accum.delta_angles += _measurement.delta_angles;
+    _ekf_accum.delta_velocity += _measurement.delta_velocity;
+    if (++_ekf_accum.count >= _ekf_decimation) {
+        uint32_t start_us = AP_HAL::micros();
+        _ekf.RunEKF(_ekf_accum.delta_time, _ekf_accum.delta_angles, _ekf_accum.delta_velocity, _measurement.joint_angles);
+        update_ekf_decimation(AP_HAL::micros() - start_us, _ekf_accum.delta_time);
+        memset(&_ekf_accum, 0, sizeof(_ekf_accum));
+    }
     update_joint_angle_est();
 }
 
+/*
+  adjust the number of reports per EKF step to keep the EKF's share of
+  the CPU under SOLOGIMBAL_EKF_MAX_LOAD, coming back to one report per
+  step once there is room for it again
+ */
+void SoloGimbal::update_ekf_decimation(uint32_t ekf_time_us, float delta_time)
+{
+    if (delta_time <= 0) {
+        return;
+    }
+    float load = ekf_time_us * 1.0e-6f / delta_time;
+    _ekf_load_filt += (load - _ekf_load_filt) * 0.05f;
+
+    if (_ekf_load_filt > SOLOGIMBAL_EKF_MAX_LOAD && _ekf_decimation < SOLOGIMBAL_EKF_MAX_DECIMATION) {
+        _ekf_load_filt *= _ekf_decimation / (float)(_ekf_decimation+1);
+        _ekf_decimation++;
+    } else if (_ekf_decimation > 1 &&
+               _ekf_load_filt * _ekf_decimation / (_ekf_decimation-1) < 0.5f * SOLOGIMBAL_EKF_MAX_LOAD) {
+        _ekf_load_filt *= _ekf_decimation / (float)(_ekf_decimation-1);
+        _ekf_decimation--;
+    }
+}
+
 void SoloGimbal::readVehicleDeltaAngle(uint8_t ins_index, Vector3f &dAng) {
     const AP_InertialSensor &ins = _ahrs.get_ins();
 
@@ -21,6 +21,11 @@
 
 #include "SoloGimbal_Parameters.h"
 
+// while running the gimbal EKF on every GIMBAL_REPORT costs more than
+// this share of the CPU, it is run on several reports accumulated
+#define SOLOGIMBAL_EKF_MAX_LOAD         0.05f
+#define SOLOGIMBAL_EKF_MAX_DECIMATION   4
+
 enum gimbal_state_t {
     GIMBAL_STATE_NOT_PRESENT = 0,
     GIMBAL_STATE_PRESENT_INITIALIZING,
@@ -54,7 +59,10 @@ public:
         _lockedToBody(false),
         _log_dt(0),
         _log_del_ang(),
-        _log_del_vel()
+        _log_del_vel(),
+        _ekf_accum(),
+        _ekf_decimation(1),
+        _ekf_load_filt(0)
     {
         AP_AccelCal::register_client(this);
     }
@@ -107,6 +115,8 @@ private:
 
     bool joints_near_limits();
 
+    void update_ekf_decimation(uint32_t ekf_time_us, float delta_time);
+
     // private member variables
     SoloGimbalEKF            _ekf;      // state of small EKF for gimbal
     const AP_AHRS_NavEKF    &_ahrs;     //  Main EKF
@@ -152,6 +162,16 @@ private:
     float _log_dt;
     Vector3f _log_del_ang;
     Vector3f _log_del_vel;
+
+    // reports accumulated for the next EKF step
+    struct {
+        float delta_time;
+        Vector3f delta_angles;
+        Vector3f delta_velocity;
+        uint8_t count;
+    } _ekf_accum;
+    uint8_t _ekf_decimation;    // reports per EKF step
+    float _ekf_load_filt;       // share of the CPU taken by the EKF
 };
 
 #endif // AP_AHRS_NAVEKF_AVAILABLE
@@ -57,6 +57,13 @@ void SoloGimbalEKF::reset()
 void SoloGimbalEKF::RunEKF(float delta_time, const Vector3f &delta_angles, const Vector3f &delta_velocity, const Vector3f &joint_angles)
 {
     imuSampleTime_ms = AP_HAL::millis();
+
+    // the bias states are delta angles over one step, so rescale them
+    // when the step length changes, e.g. when several gimbal reports
+    // are run at once
+    if (FiltInit && dtIMU > 1.0e-6f && fabsf(delta_time - dtIMU) > 0.2f*dtIMU) {
+        rescaleBiasStates(delta_time / dtIMU);
+    }
     dtIMU = delta_time;
 
     // initialise variables and constants
@@ -153,6 +160,22 @@ void SoloGimbalEKF::RunEKF(float delta_time, const Vector3f &delta_angles, const
     
 }
 
+// scale the delta angle bias states and their covariances
+void SoloGimbalEKF::rescaleBiasStates(float scale)
+{
+    state.delAngBias *= scale;
+    for (uint8_t i=6; i<=8; i++) {
+        for (uint8_t j=0; j<=8; j++) {
+            Cov[i][j] *= scale;
+        }
+    }
+    for (uint8_t j=6; j<=8; j++) {
+        for (uint8_t i=0; i<=8; i++) {
+            Cov[i][j] *= scale;
+        }
+    }
+}
+
 // state prediction
 void SoloGimbalEKF::predictStates()
 {
@@ -310,14 +333,8 @@ void SoloGimbalEKF::predictCovariance()
     float t1453 = Cov[1][6]*t1411;
     float t1628 = Cov[6][6]*t1402;
     float t1454 = t1452+t1453-t1628-Cov[2][6]*t1419;
-    float t1455 = Cov[0][7]*t1397;
-    float t1456 = Cov[1][7]*t1411;
     float t1629 = Cov[6][7]*t1402;
-    float t1457 = t1455+t1456-t1629-Cov[2][7]*t1419;
-    float t1458 = Cov[0][8]*t1397;
-    float t1459 = Cov[1][8]*t1411;
     float t1630 = Cov[6][8]*t1402;
-    float t1460 = t1458+t1459-t1630-Cov[2][8]*t1419;
     float t1461 = q0*t1390*2.0f;
     float t1462 = q1*t1391*2.0f;
     float t1463 = q3*t1395*2.0f;
@@ -394,7 +411,6 @@ void SoloGimbalEKF::predictCovariance()
     float t1529 = Cov[7][7]*t1402;
     float t1530 = Cov[0][7]*t1464;
     float t1531 = Cov[7][8]*t1402;
-    float t1532 = Cov[0][8]*t1464;
     float t1536 = Cov[8][0]*t1402;
     float t1537 = Cov[1][0]*t1497;
     float t1545 = Cov[0][0]*t1491;
@@ -435,8 +451,6 @@ void SoloGimbalEKF::predictCovariance()
     float t1575 = Cov[3][0]+t1561-t1567+t1574;
     float t1576 = Cov[1][1]*t1573;
     float t1577 = Cov[3][1]+t1563-t1569+t1576;
-    float t1578 = Cov[1][2]*t1573;
-    float t1579 = Cov[3][2]+t1565-t1571+t1578;
     float t1580 = Cov[0][6]*t1510;
     float t1581 = Cov[0][7]*t1510;
     float t1582 = Cov[0][8]*t1510;
@@ -495,7 +509,6 @@ void SoloGimbalEKF::predictCovariance()
     nextCov[6][0] = -t1628+Cov[6][0]*t1397+Cov[6][1]*t1411-Cov[6][2]*t1419;
     nextCov[7][0] = -t1527+Cov[7][0]*t1397+Cov[7][1]*t1411-Cov[7][2]*t1419;
     nextCov[8][0] = -t1553+Cov[8][0]*t1397+Cov[8][1]*t1411-Cov[8][2]*t1419;
-    nextCov[0][1] = -t1402*t1457-t1424*t1464+t1431*t1468+t1432*t1472;
     nextCov[1][1] = dayNoise*t1485+t1464*t1478-t1468*t1481-t1472*t1484+t1402*(t1529+t1530-Cov[1][7]*t1468-Cov[2][7]*t1472);
     nextCov[2][1] = t1464*t1538-t1468*t1541-t1472*t1544+t1402*(t1555+t1556-Cov[0][7]*t1491-Cov[2][7]*t1503);
     nextCov[3][1] = -t1402*(Cov[3][7]+t1581-Cov[2][7]*t1506-Cov[1][7]*t1559)-t1464*t1562+t1468*t1564+t1472*t1566;
@@ -504,8 +517,6 @@ void SoloGimbalEKF::predictCovariance()
     nextCov[6][1] = -t1629-Cov[6][0]*t1464+Cov[6][1]*t1468+Cov[6][2]*t1472;
     nextCov[7][1] = -t1529-Cov[7][0]*t1464+Cov[7][1]*t1468+Cov[7][2]*t1472;
     nextCov[8][1] = -t1555-Cov[8][0]*t1464+Cov[8][1]*t1468+Cov[8][2]*t1472;
-    nextCov[0][2] = -t1402*t1460-t1431*t1497+t1432*t1503+t1491*(t1422+t1423-t1429-t1430);
-    nextCov[1][2] = -t1478*t1491+t1481*t1497-t1484*t1503+t1402*(t1531+t1532-Cov[1][8]*t1468-Cov[2][8]*t1472);
     nextCov[2][2] = dazNoise*t1485-t1491*t1538+t1497*t1541-t1503*t1544+t1402*(t1557+t1558-Cov[0][8]*t1491-Cov[2][8]*t1503);
     nextCov[3][2] = -t1402*(Cov[3][8]+t1582-Cov[2][8]*t1506-Cov[1][8]*t1559)+t1491*t1562-t1497*t1564+t1503*t1566;
     nextCov[4][2] = -t1402*t1604+t1491*t1585-t1497*t1588+t1503*t1591;
@@ -513,68 +524,30 @@ void SoloGimbalEKF::predictCovariance()
     nextCov[6][2] = -t1630+Cov[6][0]*t1491-Cov[6][1]*t1497+Cov[6][2]*t1503;
     nextCov[7][2] = -t1531+Cov[7][0]*t1491-Cov[7][1]*t1497+Cov[7][2]*t1503;
     nextCov[8][2] = -t1557+Cov[8][0]*t1491-Cov[8][1]*t1497+Cov[8][2]*t1503;
-    nextCov[0][3] = Cov[0][3]*t1397+Cov[1][3]*t1411-Cov[2][3]*t1419-Cov[6][3]*t1402-t1432*t1506+t1510*(t1422+t1423-t1429-t1430)-t1559*(t1425+t1426-t1434-t1435);
-    nextCov[1][3] = -Cov[0][3]*t1464-Cov[7][3]*t1402+Cov[1][3]*t1468+Cov[2][3]*t1472-t1478*t1510+t1484*t1506+t1481*t1559;
-    nextCov[2][3] = -Cov[8][3]*t1402+Cov[0][3]*t1491-Cov[1][3]*t1497+Cov[2][3]*t1503-t1510*t1538+t1506*t1544+t1541*t1559;
     nextCov[3][3] = Cov[3][3]+Cov[0][3]*t1510-Cov[2][3]*t1506+Cov[1][3]*t1573-t1506*t1566+t1510*t1575+t1573*t1577+dvxNoise*sq(t1433)+dvyNoise*sq(t1440)+dvzNoise*sq(t1438);
     nextCov[4][3] = Cov[4][3]+t1595-Cov[0][3]*t1515+Cov[1][3]*t1518+Cov[2][3]*t1512+t1510*t1585-t1506*t1591+t1573*t1588-dvyNoise*t1440*t1444-dvzNoise*t1438*t1446;
     nextCov[5][3] = Cov[5][3]+t1617+Cov[0][3]*t1523-Cov[1][3]*t1521+Cov[2][3]*t1526+t1510*t1607-t1506*t1613+t1573*t1610-dvxNoise*t1433*t1451-dvyNoise*t1440*t1450;
     nextCov[6][3] = Cov[6][3]-Cov[6][2]*t1506+Cov[6][0]*t1510+Cov[6][1]*t1573;
     nextCov[7][3] = Cov[7][3]-Cov[7][2]*t1506+Cov[7][0]*t1510+Cov[7][1]*t1573;
     nextCov[8][3] = Cov[8][3]-Cov[8][2]*t1506+Cov[8][0]*t1510+Cov[8][1]*t1573;
-    nextCov[0][4] = Cov[0][4]*t1397+Cov[1][4]*t1411-Cov[2][4]*t1419-Cov[6][4]*t1402-t1424*t1515+t1432*t1512+t1518*(t1425+t1426-t1434-t1435);
-    nextCov[1][4] = -Cov[0][4]*t1464-Cov[7][4]*t1402+Cov[1][4]*t1468+Cov[2][4]*t1472+t1478*t1515-t1484*t1512-t1481*t1518;
-    nextCov[2][4] = -Cov[8][4]*t1402+Cov[0][4]*t1491-Cov[1][4]*t1497+Cov[2][4]*t1503+t1515*t1538-t1512*t1544-t1518*t1541;
-    nextCov[3][4] = Cov[3][4]+t1595+Cov[0][4]*t1510-Cov[2][4]*t1506+Cov[1][4]*t1573-t1515*t1575+t1512*t1579+t1518*t1577-dvyNoise*t1440*t1444-dvzNoise*t1438*t1446;
     nextCov[4][4] = Cov[4][4]-Cov[0][4]*t1515+Cov[1][4]*t1518+Cov[2][4]*t1512-t1515*t1585+t1512*t1591+t1518*t1588+dvxNoise*sq(t1447)+dvyNoise*sq(t1444)+dvzNoise*sq(t1446);
     nextCov[5][4] = Cov[5][4]+t1618+Cov[0][4]*t1523-Cov[1][4]*t1521+Cov[2][4]*t1526-t1515*t1607+t1512*t1613+t1518*t1610-dvxNoise*t1447*t1451-dvzNoise*t1446*t1448;
     nextCov[6][4] = Cov[6][4]+Cov[6][2]*t1512-Cov[6][0]*t1515+Cov[6][1]*t1518;
     nextCov[7][4] = Cov[7][4]+Cov[7][2]*t1512-Cov[7][0]*t1515+Cov[7][1]*t1518;
     nextCov[8][4] = Cov[8][4]+Cov[8][2]*t1512-Cov[8][0]*t1515+Cov[8][1]*t1518;
-    nextCov[0][5] = Cov[0][5]*t1397+Cov[1][5]*t1411-Cov[2][5]*t1419-Cov[6][5]*t1402+t1424*t1523-t1431*t1521+t1526*(t1427+t1428-t1442-t1443);
-    nextCov[1][5] = -Cov[0][5]*t1464-Cov[7][5]*t1402+Cov[1][5]*t1468+Cov[2][5]*t1472-t1478*t1523+t1481*t1521-t1484*t1526;
-    nextCov[2][5] = -Cov[8][5]*t1402+Cov[0][5]*t1491-Cov[1][5]*t1497+Cov[2][5]*t1503-t1523*t1538+t1521*t1541-t1526*t1544;
-    nextCov[3][5] = Cov[3][5]+t1617+Cov[0][5]*t1510-Cov[2][5]*t1506+Cov[1][5]*t1573-t1521*t1577+t1523*t1575+t1526*t1579-dvxNoise*t1433*t1451-dvyNoise*t1440*t1450;
-    nextCov[4][5] = Cov[4][5]+t1618-Cov[0][5]*t1515+Cov[1][5]*t1518+Cov[2][5]*t1512+t1523*t1585-t1521*t1588+t1526*t1591-dvxNoise*t1447*t1451-dvzNoise*t1446*t1448;
     nextCov[5][5] = Cov[5][5]+Cov[0][5]*t1523-Cov[1][5]*t1521+Cov[2][5]*t1526+t1523*t1607-t1521*t1610+t1526*t1613+dvxNoise*sq(t1451)+dvyNoise*sq(t1450)+dvzNoise*sq(t1448);
     nextCov[6][5] = Cov[6][5]-Cov[6][1]*t1521+Cov[6][0]*t1523+Cov[6][2]*t1526;
     nextCov[7][5] = Cov[7][5]-Cov[7][1]*t1521+Cov[7][0]*t1523+Cov[7][2]*t1526;
     nextCov[8][5] = Cov[8][5]-Cov[8][1]*t1521+Cov[8][0]*t1523+Cov[8][2]*t1526;
-    nextCov[0][6] = t1454;
-    nextCov[1][6] = -t1527-t1528+Cov[1][6]*t1468+Cov[2][6]*t1472;
-    nextCov[2][6] = -t1553-t1554+Cov[0][6]*t1491+Cov[2][6]*t1503;
-    nextCov[3][6] = Cov[3][6]+t1580-Cov[2][6]*t1506+Cov[1][6]*t1573;
-    nextCov[4][6] = t1598;
-    nextCov[5][6] = t1621;
-    nextCov[6][6] = Cov[6][6];
-    nextCov[7][6] = Cov[7][6];
-    nextCov[8][6] = Cov[8][6];
-    nextCov[0][7] = t1457;
-    nextCov[1][7] = -t1529-t1530+Cov[1][7]*t1468+Cov[2][7]*t1472;
-    nextCov[2][7] = -t1555-t1556+Cov[0][7]*t1491+Cov[2][7]*t1503;
-    nextCov[3][7] = Cov[3][7]+t1581-Cov[2][7]*t1506+Cov[1][7]*t1573;
-    nextCov[4][7] = t1601;
-    nextCov[5][7] = t1624;
-    nextCov[6][7] = Cov[6][7];
-    nextCov[7][7] = Cov[7][7];
-    nextCov[8][7] = Cov[8][7];
-    nextCov[0][8] = t1460;
-    nextCov[1][8] = -t1531-t1532+Cov[1][8]*t1468+Cov[2][8]*t1472;
-    nextCov[2][8] = -t1557-t1558+Cov[0][8]*t1491+Cov[2][8]*t1503;
-    nextCov[3][8] = Cov[3][8]+t1582-Cov[2][8]*t1506+Cov[1][8]*t1573;
-    nextCov[4][8] = t1604;
-    nextCov[5][8] = t1627;
-    nextCov[6][8] = Cov[6][8];
-    nextCov[7][8] = Cov[7][8];
-    nextCov[8][8] = Cov[8][8];
-
-    // Add the gyro bias state noise
+
+    // the bias block is not changed by the prediction, apart from
+    // the gyro bias state noise
     for (uint8_t i=6;i<=8;i++) {
-        nextCov[i][i] = nextCov[i][i] + delAngBiasVariance;
+        Cov[i][i] += delAngBiasVariance;
     }
 
     // copy predicted variances whilst constraining to be non-negative
-    for (uint8_t index=0; index<=8; index++) {
+    for (uint8_t index=0; index<=5; index++) {
         if (nextCov[index][index] < 0.0f) {
             Cov[index][index] = 0.0f;
         } else {
@@ -582,10 +555,11 @@ void SoloGimbalEKF::predictCovariance()
         }
     }
 
-    // copy elements to covariance matrix whilst enforcing symmetry
+    // only the lower triangle is predicted, copy it to both halves to
+    // keep the matrix symmetric
     for (uint8_t rowIndex=1; rowIndex<=8; rowIndex++) {
-        for (uint8_t colIndex=0; colIndex<=rowIndex-1; colIndex++) {
-            Cov[rowIndex][colIndex] = 0.5f*(nextCov[rowIndex][colIndex] + nextCov[colIndex][rowIndex]);
+        for (uint8_t colIndex=0; colIndex<=MIN(rowIndex-1,5); colIndex++) {
+            Cov[rowIndex][colIndex] = nextCov[rowIndex][colIndex];
             Cov[colIndex][rowIndex] = Cov[rowIndex][colIndex];
         }
     }
@@ -145,6 +145,9 @@ private:
     float innovationIncrement;
     float lastInnovation;
 
+    // scale the bias states to a new step length
+    void rescaleBiasStates(float scale);
+
     // state prediction
     void predictStates();
 
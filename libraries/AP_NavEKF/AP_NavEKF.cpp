@@ -461,6 +461,16 @@ void NavEKF::UpdateFilter(void)
     }
 }
 
+/*
+  free the filter core. It is allocated again by the next
+  initialisation once the filter is enabled
+ */
+void NavEKF::release_core(void)
+{
+    delete core;
+    core = nullptr;
+}
+
 // Check basic filter health metrics and return a consolidated health status
 bool NavEKF::healthy(void) const
 {
@@ -67,6 +67,9 @@ public:
     // Update Filter States - this should be called whenever new IMU data is available
     void UpdateFilter(void);
 
+    // free the filter core, for when the filter has been disabled
+    void release_core(void);
+
     // Check basic filter health metrics and return a consolidated health status
     bool healthy(void) const;
 
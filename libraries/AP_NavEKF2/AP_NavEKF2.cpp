@@ -1,4 +1,5 @@
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Alloc.h>
 #if HAL_CPU_CLASS >= HAL_CPU_CLASS_150
 
 #include "AP_NavEKF2_core.h"
@@ -6,6 +7,83 @@
 #include <GCS_MAVLink/GCS.h>
 #include <DataFlash/DataFlash.h>
 
+#if EK2_CORE_THREADS
+#include <pthread.h>
+#include <AP_HAL_Linux/Thread.h>
+
+// run the core threads at the same priority as the main thread
+#define EK2_CORE_THREAD_POLICY SCHED_FIFO
+#define EK2_CORE_THREAD_PRIO   12
+#define EK2_CORE_THREAD_STACK  (64 * 1024)
+
+/*
+  a worker thread which runs one core's UpdateFilter() each frame
+ */
+class NavEKF2_CoreThread : public Linux::Thread {
+public:
+    NavEKF2_CoreThread() : Linux::Thread(nullptr) { }
+
+    void setup(NavEKF2_core *core, pthread_barrier_t *frame_start, pthread_barrier_t *frame_end) {
+        _core = core;
+        _frame_start = frame_start;
+        _frame_end = frame_end;
+    }
+
+protected:
+    bool _run() override {
+        while (true) {
+            pthread_barrier_wait(_frame_start);
+            _core->UpdateFilter(true);
+            pthread_barrier_wait(_frame_end);
+        }
+        return true;
+    }
+
+private:
+    NavEKF2_core *_core;
+    pthread_barrier_t *_frame_start;
+    pthread_barrier_t *_frame_end;
+};
+
+/*
+  the set of worker threads for cores 1 and up. Core 0 is run on the
+  calling thread, then we wait at a barrier for all other cores to
+  finish the frame
+ */
+class NavEKF2_CoreThreads {
+public:
+    bool start(NavEKF2_core *cores, uint8_t num_cores) {
+        if (num_cores < 2) {
+            return false;
+        }
+        _threads = new NavEKF2_CoreThread[num_cores-1];
+        if (_threads == nullptr) {
+            return false;
+        }
+        pthread_barrier_init(&_frame_start, nullptr, num_cores);
+        pthread_barrier_init(&_frame_end, nullptr, num_cores);
+        for (uint8_t i=1; i<num_cores; i++) {
+            NavEKF2_CoreThread &t = _threads[i-1];
+            t.setup(&cores[i], &_frame_start, &_frame_end);
+            t.set_stack_size(EK2_CORE_THREAD_STACK);
+            t.start(i==1?"ap-ekf2-core1":"ap-ekf2-coreN", EK2_CORE_THREAD_POLICY, EK2_CORE_THREAD_PRIO);
+        }
+        return true;
+    }
+
+    void update(NavEKF2_core *cores) {
+        pthread_barrier_wait(&_frame_start);
+        cores[0].UpdateFilter(true);
+        pthread_barrier_wait(&_frame_end);
+    }
+
+private:
+    NavEKF2_CoreThread *_threads;
+    pthread_barrier_t _frame_start;
+    pthread_barrier_t _frame_end;
+};
+#endif // EK2_CORE_THREADS
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -491,6 +569,25 @@ const AP_Param::GroupInfo NavEKF2::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("TERR_GRAD", 43, NavEKF2, _terrGradMax, 0.1f),
 
+    // @Param: THREADS
+    // @DisplayName: Run EKF cores on separate threads
+    // @Description: When enabled on multi-core boards that support it, each EKF core after the first is run on its own thread in parallel with the first core, and all cores do a state prediction on every IMU frame. When disabled the cores are run one after the other.
+    // @Values: 0:Disabled,1:Enabled
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("THREADS", 44, NavEKF2, _coreThreads, 0),
+
+    // @Param: PREDICT_MS
+    // @DisplayName: Target time between state predictions
+    // @Description: The IMU data is downsampled to this interval before each state prediction, so this sets the rate the state and covariance predictions and the sensor fusion run at. The delta angles and velocities are corrected for coning and sculling at the raw IMU rate, so a longer interval costs little accuracy and saves processor time. The output observer still runs on every IMU sample. The interval is never shorter than the main loop period.
+    // @Values: 5:200Hz,10:100Hz,20:50Hz
+    // @Range: 5 40
+    // @Increment: 5
+    // @Units: ms
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("PREDICT_MS", 45, NavEKF2, _predictInterval_ms, 10),
+
     AP_GROUPEND
 };
 
@@ -567,6 +664,7 @@ bool NavEKF2::InitialiseFilter(void)
     }
 
     imuSampleTime_us = AP_HAL::micros64();
+    readSensorFrame();
 
     // see if we will be doing logging
     DataFlash_Class *dataflash = DataFlash_Class::instance();
@@ -575,6 +673,7 @@ bool NavEKF2::InitialiseFilter(void)
     }
     
     if (core == nullptr) {
+        AP_Alloc::Tag alloc_tag("EKF2");
 
         // don't run multiple filters for 1 IMU
         const AP_InertialSensor &ins = _ahrs->get_ins();
@@ -615,6 +714,16 @@ bool NavEKF2::InitialiseFilter(void)
 
         // Set the primary initially to be the lowest index
         primary = 0;
+
+#if EK2_CORE_THREADS
+        if (_coreThreads && num_cores > 1) {
+            core_threads = new NavEKF2_CoreThreads;
+            if (core_threads != nullptr && !core_threads->start(core, num_cores)) {
+                delete core_threads;
+                core_threads = nullptr;
+            }
+        }
+#endif
     }
 
     // initialse the cores. We return success only if all cores
@@ -628,6 +737,26 @@ bool NavEKF2::InitialiseFilter(void)
     return ret;
 }
 
+/*
+  free the filter cores and their buffers. They are allocated again,
+  for the IMUs then in EK2_IMU_MASK, by the next InitialiseFilter()
+  once the filter is enabled. Cores run by worker threads can't be
+  freed as the threads never exit
+ */
+bool NavEKF2::release_cores(void)
+{
+#if EK2_CORE_THREADS
+    if (core_threads != nullptr) {
+        return false;
+    }
+#endif
+    delete[] core;
+    core = nullptr;
+    num_cores = 0;
+    primary = 0;
+    return true;
+}
+
 // Update Filter States - this should be called whenever new IMU data is available
 void NavEKF2::UpdateFilter(void)
 {
@@ -636,15 +765,25 @@ void NavEKF2::UpdateFilter(void)
     }
 
     imuSampleTime_us = AP_HAL::micros64();
-    
+
+    // read each sensor once for all the cores
+    readSensorFrame();
+
     const AP_InertialSensor &ins = _ahrs->get_ins();
 
+#if EK2_CORE_THREADS
+    if (core_threads != nullptr) {
+        // all cores predict every frame, in parallel
+        core_threads->update(core);
+    } else
+#endif
     for (uint8_t i=0; i<num_cores; i++) {
         // if the previous core has only recently finished a new state prediction cycle, then
-        // don't start a new cycle to allow time for fusion operations to complete if the update
-        // rate is higher than 200Hz
+        // don't start a new cycle to allow time for fusion operations to complete if there are
+        // at least four IMU frames in each prediction interval
+        const bool stagger = ins.get_sample_rate() * constrain_int16(_predictInterval_ms, 5, 40) >= 4000;
         bool statePredictEnabled;
-        if ((i > 0) && (core[i-1].getFramesSincePredict() < 2) && (ins.get_sample_rate() > 200)) {
+        if ((i > 0) && (core[i-1].getFramesSincePredict() < 2) && stagger) {
             statePredictEnabled = false;
         } else {
             statePredictEnabled = true;
@@ -675,6 +814,61 @@ void NavEKF2::UpdateFilter(void)
     check_log_write();
 }
 
+/*
+  read the GPS, baro, compass and airspeed data the cores use. The
+  cores share the same sensors, so reading them here once saves each
+  core from calling into the sensor libraries, and gives all cores the
+  same view of the sensors for this frame
+ */
+void NavEKF2::readSensorFrame(void)
+{
+    const AP_GPS &gps = _ahrs->get_gps();
+    sensorFrame.gpsTime_ms = gps.last_message_time_ms();
+    sensorFrame.gpsStatus = gps.status();
+    if (sensorFrame.gpsStatus >= AP_GPS::GPS_OK_FIX_3D) {
+        sensorFrame.gpsLoc = gps.location();
+        sensorFrame.gpsVel = gps.velocity();
+        sensorFrame.gpsHaveSpdAcc = gps.speed_accuracy(sensorFrame.gpsSpdAcc);
+        sensorFrame.gpsHavePosAcc = gps.horizontal_accuracy(sensorFrame.gpsPosAcc);
+        sensorFrame.gpsHaveHgtAcc = gps.vertical_accuracy(sensorFrame.gpsHgtAcc);
+        sensorFrame.gpsHaveVertVel = gps.have_vertical_velocity();
+        sensorFrame.gpsNumSats = gps.num_sats();
+    }
+
+    // height and its time from the same reading
+    SensorTopic<AP_Baro::baro_sample>::Sample baro;
+    sensorFrame.baroValid = _baro.get_topic().read(baro);
+    if (sensorFrame.baroValid) {
+        sensorFrame.baroTime_ms = baro.timestamp_us / 1000;
+        sensorFrame.baroHgt = baro.data.altitude;
+    }
+
+    const Compass *compass = _ahrs->get_compass();
+    sensorFrame.magCount = compass ? compass->get_count() : 0;
+    if (sensorFrame.magCount > 0) {
+        sensorFrame.magConsistent = compass->consistent();
+        sensorFrame.magPrimaryTime_us = compass->last_update_usec();
+        for (uint8_t i=0; i<sensorFrame.magCount; i++) {
+            sensorFrame.mag[i].time_us = compass->last_update_usec(i);
+            SensorTopic<Vector3f>::Sample field;
+            if (compass->get_field_topic(i).read(field)) {
+                sensorFrame.mag[i].field = field.data;
+            } else {
+                sensorFrame.mag[i].field = compass->get_field(i);
+            }
+            sensorFrame.mag[i].offsets = compass->get_offsets(i);
+            sensorFrame.mag[i].useForYaw = compass->use_for_yaw(i);
+        }
+    }
+
+    const AP_Airspeed *aspeed = _ahrs->get_airspeed();
+    sensorFrame.tasValid = aspeed && aspeed->use();
+    if (sensorFrame.tasValid) {
+        sensorFrame.tasTime_ms = aspeed->last_update_ms();
+        sensorFrame.tas = aspeed->get_airspeed() * aspeed->get_EAS2TAS();
+    }
+}
+
 // Check basic filter health metrics and return a consolidated health status
 bool NavEKF2::healthy(void) const
 {
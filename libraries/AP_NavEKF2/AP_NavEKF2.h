@@ -26,10 +26,19 @@
 #include <AP_Baro/AP_Baro.h>
 #include <AP_Airspeed/AP_Airspeed.h>
 #include <AP_Compass/AP_Compass.h>
+#include <AP_GPS/AP_GPS.h>
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
 
+/*
+  cores can be run on their own threads on multi-core Linux boards
+ */
+#ifndef EK2_CORE_THREADS
+#define EK2_CORE_THREADS (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 class NavEKF2_core;
+class NavEKF2_CoreThreads;
 class AP_AHRS;
 
 class NavEKF2
@@ -51,6 +60,15 @@ public:
     // Update Filter States - this should be called whenever new IMU data is available
     void UpdateFilter(void);
 
+    // true if EK2_ENABLE is set
+    bool enabled(void) const {
+        return (_enable != 0);
+    }
+
+    // free the filter cores, for when the filter has been disabled.
+    // Returns false if they can't be freed
+    bool release_cores(void);
+
     // check if we should write log messages
     void check_log_write(void);
     
@@ -292,6 +310,7 @@ private:
     uint8_t num_cores; // number of allocated cores
     uint8_t primary;   // current primary core
     NavEKF2_core *core = nullptr;
+    NavEKF2_CoreThreads *core_threads = nullptr; // worker threads for cores 1 and up, if enabled
     const AP_AHRS *_ahrs;
     AP_Baro &_baro;
     const RangeFinder &_rng;
@@ -340,6 +359,8 @@ private:
     AP_Int8 _tauVelPosOutput;       // Time constant of output complementary filter : csec (centi-seconds)
     AP_Int8 _useRngSwHgt;           // Maximum valid range of the range finder in metres
     AP_Float _terrGradMax;          // Maximum terrain gradient below the vehicle
+    AP_Int8 _coreThreads;           // non-zero to run each core on its own thread
+    AP_Int8 _predictInterval_ms;    // target time between state predictions (msec)
 
     // Tuning parameters
     const float gpsNEVelVarAccScale;    // Scale factor applied to NE velocity measurement variance due to manoeuvre acceleration
@@ -369,16 +390,55 @@ private:
     const uint8_t gndGradientSigma;     // RMS terrain gradient percentage assumed by the terrain height estimation
     const uint8_t fusionTimeStep_ms;    // The minimum time interval between covariance predictions and measurement fusions in msec
 
+    // not bitfields as the flags may be set from several core threads at once
     struct {
-        bool enabled:1;
-        bool log_compass:1;
-        bool log_gps:1;
-        bool log_baro:1;
-        bool log_imu:1;
+        bool enabled;
+        bool log_compass;
+        bool log_gps;
+        bool log_baro;
+        bool log_imu;
     } logging;
 
     // time at start of current filter update
     uint64_t imuSampleTime_us;
+
+    // measurements read from the sensor libraries once per filter
+    // update, before the cores run, and shared read-only between them
+    struct {
+        uint32_t gpsTime_ms;            // time of the last GPS message (msec)
+        AP_GPS::GPS_Status gpsStatus;   // GPS fix status
+        Location gpsLoc;                // GPS location
+        Vector3f gpsVel;                // GPS NED velocity (m/s)
+        float gpsSpdAcc;                // GPS speed accuracy (m/s)
+        float gpsPosAcc;                // GPS horizontal position accuracy (m)
+        float gpsHgtAcc;                // GPS vertical position accuracy (m)
+        bool gpsHaveSpdAcc;
+        bool gpsHavePosAcc;
+        bool gpsHaveHgtAcc;
+        bool gpsHaveVertVel;            // true if the GPS reports a vertical velocity
+        uint8_t gpsNumSats;
+
+        bool baroValid;                 // true once the primary baro has a reading
+        uint32_t baroTime_ms;           // time of the primary baro reading (msec)
+        float baroHgt;                  // primary baro height (m)
+
+        uint8_t magCount;               // number of compasses, zero if there is no compass
+        bool magConsistent;             // true if the compasses agree
+        uint32_t magPrimaryTime_us;     // time of the primary compass reading (usec)
+        struct {
+            uint32_t time_us;           // time of the reading (usec)
+            Vector3f field;             // corrected field (mGauss)
+            Vector3f offsets;           // compass offset parameters (mGauss)
+            bool useForYaw;
+        } mag[COMPASS_MAX_INSTANCES];
+
+        bool tasValid;                  // true if the airspeed sensor is in use
+        uint32_t tasTime_ms;            // time of the airspeed reading (msec)
+        float tas;                      // true airspeed (m/s)
+    } sensorFrame;
+
+    // read the sensors into sensorFrame
+    void readSensorFrame(void);
     
     struct {
         uint32_t last_function_call;  // last time getLastYawYawResetAngle was called
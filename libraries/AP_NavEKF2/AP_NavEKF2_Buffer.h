@@ -3,6 +3,8 @@
 // this buffer model is to be used for observation buffers,
 // the data is pushed into buffer like any standard ring buffer
 // return is based on the sample time provided
+// the memory is only allocated when the first observation is pushed,
+// so a core doesn't use RAM for sensors that are not fitted
 template <typename element_type>
 class obs_ring_buffer_t
 {
@@ -11,19 +13,36 @@ public:
         element_type element;
     } *buffer;
 
-    // initialise buffer, returns false when allocation has failed
+    obs_ring_buffer_t() :
+        buffer(NULL),
+        _size(0),
+        _head(0),
+        _tail(0),
+        _new_data(false)
+    {}
+
+    ~obs_ring_buffer_t()
+    {
+        delete[] buffer;
+    }
+
+    // set the buffer size, returns false if the size can't be held
     bool init(uint32_t size)
     {
-        buffer = new element_t[size];
-        if(buffer == NULL)
-        {
+        if (size == 0 || size > 255) {
             return false;
         }
-        memset(buffer,0,size*sizeof(element_t));
+        if (buffer != NULL && size != _size) {
+            delete[] buffer;
+            buffer = NULL;
+        }
         _size = size;
         _head = 0;
         _tail = 0;
         _new_data = false;
+        if (buffer != NULL) {
+            memset(buffer,0,_size*sizeof(element_t));
+        }
         return true;
     }
 
@@ -85,6 +104,9 @@ public:
     */
     inline void push(element_type element)
     {
+        if (buffer == NULL && !allocate()) {
+            return;
+        }
         // Advance head to next available index
         _head = (_head+1)%_size;
         // New data is written at the head
@@ -93,6 +115,9 @@ public:
     }
     // writes the same data to all elements in the ring buffer
     inline void reset_history(element_type element, uint32_t sample_time) {
+        if (buffer == NULL) {
+            return;
+        }
         for (uint8_t index=0; index<_size; index++) {
             buffer[index].element = element;
         }
@@ -103,10 +128,25 @@ public:
         _head = 0;
         _tail = 0;
         _new_data = false;
-        memset(buffer,0,_size*sizeof(element_t));
+        if (buffer != NULL) {
+            memset(buffer,0,_size*sizeof(element_t));
+        }
     }
 
 private:
+    bool allocate()
+    {
+        if (_size == 0) {
+            return false;
+        }
+        buffer = new element_t[_size];
+        if (buffer == NULL) {
+            return false;
+        }
+        memset(buffer,0,_size*sizeof(element_t));
+        return true;
+    }
+
     uint8_t _size,_head,_tail,_new_data;
 };
 
@@ -114,23 +154,39 @@ private:
 // Following buffer model is for IMU data,
 // it achieves a distance of sample size
 // between youngest and oldest
+// The elements are stored contiguously from the start of a cache
+// line and are read and written in place through references
+#define EK2_IMU_BUFFER_ALIGN 64
+
 template <typename element_type>
 class imu_ring_buffer_t
 {
 public:
-    struct element_t{
-        element_type element;
-    } *buffer;
+    imu_ring_buffer_t() :
+        _storage(NULL),
+        _buffer(NULL),
+        _size(0),
+        _oldest(0),
+        _youngest(0)
+    {}
+
+    ~imu_ring_buffer_t()
+    {
+        delete[] _storage;
+    }
 
     // initialise buffer, returns false when allocation has failed
     bool init(uint32_t size)
     {
-        buffer = new element_t[size];
-        if(buffer == NULL)
+        delete[] _storage;
+        _buffer = NULL;
+        _storage = new uint8_t[size*sizeof(element_type) + EK2_IMU_BUFFER_ALIGN - 1];
+        if(_storage == NULL)
         {
             return false;
         }
-        memset(buffer,0,size*sizeof(element_t));
+        _buffer = (element_type *)(((uintptr_t)_storage + EK2_IMU_BUFFER_ALIGN - 1) & ~(uintptr_t)(EK2_IMU_BUFFER_ALIGN - 1));
+        memset(_buffer,0,size*sizeof(element_type));
         _size = size;
         _youngest = 0;
         _oldest = 0;
@@ -140,25 +196,24 @@ public:
      * Writes data to a Ring buffer and advances indices that
      * define the location of the newest and oldest data
     */
-    inline void push_youngest_element(element_type element)
+    inline void push_youngest_element(const element_type &element)
     {
         // push youngest to the buffer
-        _youngest = (_youngest+1)%_size;
-        buffer[_youngest].element = element;
+        _youngest = _youngest+1 < _size ? _youngest+1 : 0;
+        _buffer[_youngest] = element;
         // set oldest data index
-        _oldest = (_youngest+1)%_size;
+        _oldest = _youngest+1 < _size ? _youngest+1 : 0;
     }
 
-    // retrieve the oldest data from the ring buffer tail
-    inline element_type pop_oldest_element() {
-        element_type ret = buffer[_oldest].element;
-        return ret;
+    // the oldest data in the ring buffer
+    inline const element_type &get_oldest_element() const {
+        return _buffer[_oldest];
     }
 
     // writes the same data to all elements in the ring buffer
-    inline void reset_history(element_type element) {
+    inline void reset_history(const element_type &element) {
         for (uint8_t index=0; index<_size; index++) {
-            buffer[index].element = element;
+            _buffer[index] = element;
         }
     }
 
@@ -166,23 +221,25 @@ public:
     inline void reset() {
         _youngest = 0;
         _oldest = 0;
-        memset(buffer,0,_size*sizeof(element_t));
+        memset(_buffer,0,_size*sizeof(element_type));
     }
 
     // retrieves data from the ring buffer at a specified index
     inline element_type& operator[](uint32_t index) {
-        return buffer[index].element;
+        return _buffer[index];
     }
 
     // returns the index for the ring buffer oldest data
-    inline uint8_t get_oldest_index(){
+    inline uint8_t get_oldest_index() const {
         return _oldest;
     }
 
     // returns the index for the ring buffer youngest data
-    inline uint8_t get_youngest_index(){
+    inline uint8_t get_youngest_index() const {
         return _youngest;
     }
 private:
+    uint8_t *_storage;
+    element_type *_buffer;
     uint8_t _size,_oldest,_youngest;
 };
\ No newline at end of file
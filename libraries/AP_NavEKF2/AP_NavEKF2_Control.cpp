@@ -322,7 +322,8 @@ bool NavEKF2_core::readyToUseGPS(void) const
 // return true if we should use the compass
 bool NavEKF2_core::use_compass(void) const
 {
-    return _ahrs->get_compass() && _ahrs->get_compass()->use_for_yaw(magSelectIndex) && !allMagSensorsFailed;
+    return magSelectIndex < frontend->sensorFrame.magCount &&
+        frontend->sensorFrame.mag[magSelectIndex].useForYaw && !allMagSensorsFailed;
 }
 
 /*
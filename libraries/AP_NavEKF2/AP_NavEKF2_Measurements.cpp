@@ -26,6 +26,21 @@ void NavEKF2_core::readRangeFinder(void)
     // get theoretical correct range when the vehicle is on the ground
     rngOnGnd = frontend->_rng.ground_clearance_cm() * 0.01f;
 
+    // store the timestamped samples of range finders that queue them
+    // as they arrive, so the median below uses their measurement times
+    for (uint8_t sensorIndex = 0; sensorIndex <= 1; sensorIndex++) {
+        if (frontend->_rng.status(sensorIndex) != RangeFinder::RangeFinder_Good) {
+            continue;
+        }
+        RangeFinder::RangeFinder_Sample samples[RANGEFINDER_SAMPLE_HISTORY];
+        const uint8_t numSamples = frontend->_rng.get_samples(sensorIndex, lastRngSampleTime_ms[sensorIndex], samples, RANGEFINDER_SAMPLE_HISTORY);
+        for (uint8_t i = 0; i < numSamples; i++) {
+            lastRngSampleTime_ms[sensorIndex] = samples[i].time_ms;
+            // the IMU sample may be slightly older than the range sample
+            storeRngMeas(sensorIndex, MIN(samples[i].time_ms, imuSampleTime_ms), samples[i].distance_cm * 0.01f);
+        }
+    }
+
     // read range finder at 20Hz
     // TODO better way of knowing if it has new data
     if ((imuSampleTime_ms - lastRngMeasTime_ms) > 50) {
@@ -37,13 +52,10 @@ void NavEKF2_core::readRangeFinder(void)
         // use data from two range finders if available
 
         for (uint8_t sensorIndex = 0; sensorIndex <= 1; sensorIndex++) {
-            if (frontend->_rng.status(sensorIndex) == RangeFinder::RangeFinder_Good) {
-                rngMeasIndex[sensorIndex] ++;
-                if (rngMeasIndex[sensorIndex] > 2) {
-                    rngMeasIndex[sensorIndex] = 0;
-                }
-                storedRngMeasTime_ms[sensorIndex][rngMeasIndex[sensorIndex]] = imuSampleTime_ms - 25;
-                storedRngMeas[sensorIndex][rngMeasIndex[sensorIndex]] = frontend->_rng.distance_cm(sensorIndex) * 0.01f;
+            if (frontend->_rng.status(sensorIndex) == RangeFinder::RangeFinder_Good &&
+                lastRngSampleTime_ms[sensorIndex] == 0) {
+                // no queued samples, assume the reading is 25msec old
+                storeRngMeas(sensorIndex, imuSampleTime_ms - 25, frontend->_rng.distance_cm(sensorIndex) * 0.01f);
             }
 
             // check for three fresh samples
@@ -105,6 +117,17 @@ void NavEKF2_core::readRangeFinder(void)
     }
 }
 
+// store a range measurement in the three sample median filter of a sensor
+void NavEKF2_core::storeRngMeas(uint8_t sensorIndex, uint32_t time_ms, float rng)
+{
+    rngMeasIndex[sensorIndex] ++;
+    if (rngMeasIndex[sensorIndex] > 2) {
+        rngMeasIndex[sensorIndex] = 0;
+    }
+    storedRngMeasTime_ms[sensorIndex][rngMeasIndex[sensorIndex]] = time_ms;
+    storedRngMeas[sensorIndex][rngMeasIndex[sensorIndex]] = rng;
+}
+
 // write the raw optical flow measurements
 // this needs to be called externally.
 void NavEKF2_core::writeOptFlowMeas(uint8_t &rawFlowQuality, Vector2f &rawFlowRates, Vector2f &rawGyroRates, uint32_t &msecFlowMeas)
@@ -165,13 +188,13 @@ void NavEKF2_core::writeOptFlowMeas(uint8_t &rawFlowQuality, Vector2f &rawFlowRa
 // check for new magnetometer data and update store measurements if available
 void NavEKF2_core::readMagData()
 {
-    if (!_ahrs->get_compass()) {
+    const uint8_t maxCount = frontend->sensorFrame.magCount;
+    if (maxCount == 0) {
         allMagSensorsFailed = true;
-        return;        
+        return;
     }
     // If we are a vehicle with a sideslip constraint to aid yaw estimation and we have timed out on our last avialable
     // magnetometer, then declare the magnetometers as failed for this flight
-    uint8_t maxCount = _ahrs->get_compass()->get_count();
     if (allMagSensorsFailed || (magTimeout && assume_zero_sideslip() && magSelectIndex >= maxCount-1 && inFlight)) {
         allMagSensorsFailed = true;
         return;
@@ -179,7 +202,7 @@ void NavEKF2_core::readMagData()
 
     // do not accept new compass data faster than 14Hz (nominal rate is 10Hz) to prevent high processor loading
     // because magnetometer fusion is an expensive step and we could overflow the FIFO buffer
-    if (use_compass() && _ahrs->get_compass()->last_update_usec() - lastMagUpdate_us > 70000) {
+    if (use_compass() && frontend->sensorFrame.magPrimaryTime_us - lastMagUpdate_us > 70000) {
         frontend->logging.log_compass = true;
 
         // If the magnetometer has timed out (been rejected too long) we find another magnetometer to use if available
@@ -195,7 +218,7 @@ void NavEKF2_core::readMagData()
                     tempIndex -= maxCount;
                 }
                 // if the magnetometer is allowed to be used for yaw and has a different index, we start using it
-                if (_ahrs->get_compass()->use_for_yaw(tempIndex) && tempIndex != magSelectIndex) {
+                if (frontend->sensorFrame.mag[tempIndex].useForYaw && tempIndex != magSelectIndex) {
                     magSelectIndex = tempIndex;
                     GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_INFO, "EKF2 IMU%u switching to compass %u",(unsigned)imu_index,magSelectIndex);
                     // reset the timeout flag and timer
@@ -216,7 +239,7 @@ void NavEKF2_core::readMagData()
         }
 
         // detect changes to magnetometer offset parameters and reset states
-        Vector3f nowMagOffsets = _ahrs->get_compass()->get_offsets(magSelectIndex);
+        const Vector3f &nowMagOffsets = frontend->sensorFrame.mag[magSelectIndex].offsets;
         bool changeDetected = lastMagOffsetsValid && (nowMagOffsets != lastMagOffsets);
         if (changeDetected) {
             // zero the learned magnetometer bias states
@@ -228,7 +251,7 @@ void NavEKF2_core::readMagData()
         lastMagOffsetsValid = true;
 
         // store time of last measurement update
-        lastMagUpdate_us = _ahrs->get_compass()->last_update_usec(magSelectIndex);
+        lastMagUpdate_us = frontend->sensorFrame.mag[magSelectIndex].time_us;
 
         // estimate of time magnetometer measurement was taken, allowing for delays
         magDataNew.time_ms = imuSampleTime_ms - frontend->magDelay_ms;
@@ -237,10 +260,10 @@ void NavEKF2_core::readMagData()
         magDataNew.time_ms -= localFilterTimeStep_ms/2;
 
         // read compass data and scale to improve numerical conditioning
-        magDataNew.mag = _ahrs->get_compass()->get_field(magSelectIndex) * 0.001f;
+        magDataNew.mag = frontend->sensorFrame.mag[magSelectIndex].field * 0.001f;
 
         // check for consistent data between magnetometers
-        consistentMagData = _ahrs->get_compass()->consistent();
+        consistentMagData = frontend->sensorFrame.magConsistent;
 
         // save magnetometer measurement to buffer to be fused later
         storedMag.push(magDataNew);
@@ -262,8 +285,10 @@ void NavEKF2_core::readIMUData()
 {
     const AP_InertialSensor &ins = _ahrs->get_ins();
 
-    // average IMU sampling rate
+    // average IMU sampling rate. This follows the main loop rate when
+    // the scheduler adapts it to the load
     dtIMUavg = ins.get_loop_delta_t();
+    localFilterTimeStep_ms = MAX((uint8_t)(1000*dtIMUavg), 10);
 
     // the imu sample time is used as a common time reference throughout the filter
     imuSampleTime_ms = AP_HAL::millis();
@@ -290,24 +315,30 @@ void NavEKF2_core::readIMUData()
     imuDataDownSampledNew.delAngDT += imuDataNew.delAngDT;
     imuDataDownSampledNew.delVelDT += imuDataNew.delVelDT;
 
-    // Rotate quaternon atitude from previous to new and normalise.
-    // Accumulation using quaternions prevents introduction of coning errors due to downsampling
-    imuQuatDownSampleNew.rotate(imuDataNew.delAng);
-    imuQuatDownSampleNew.normalize();
-
-    // Rotate the latest delta velocity into body frame at the start of accumulation
+    // Rotate the latest delta velocity into body frame at the start of accumulation.
+    // The IMU has already corrected it for rotation during the IMU frame, so it is
+    // in the body frame at the start of that frame
     Matrix3f deltaRotMat;
     imuQuatDownSampleNew.rotation_matrix(deltaRotMat);
 
     // Apply the delta velocity to the delta velocity accumulator
     imuDataDownSampledNew.delVel += deltaRotMat*imuDataNew.delVel;
 
+    // Rotate quaternon atitude from previous to new and normalise.
+    // Accumulation using quaternions prevents introduction of coning errors due to downsampling
+    imuQuatDownSampleNew.rotate(imuDataNew.delAng);
+    imuQuatDownSampleNew.normalize();
+
     // Keep track of the number of IMU frames since the last state prediction
     framesSincePredict++;
 
-    // If 10msec has elapsed, and the frontend has allowed us to start a new predict cycle, then store the accumulated IMU data
-    // to be used by the state prediction, ignoring the frontend permission if more than 20msec has lapsed
-    if ((dtIMUavg*(float)framesSincePredict >= EKF_TARGET_DT && startPredictEnabled) || (dtIMUavg*(float)framesSincePredict >= 2.0f*EKF_TARGET_DT)) {
+    // If the accumulated data spans the target interval, and the frontend has allowed us to start a new predict cycle, then store
+    // the accumulated IMU data to be used by the state prediction, ignoring the frontend permission if twice the interval has lapsed.
+    // The interval is measured from the accumulated IMU time and allowed to fall short by half an IMU frame, so that jitter in the
+    // IMU timing doesn't delay a prediction by a whole frame
+    const float accumulatedDT = 0.5f*(imuDataDownSampledNew.delAngDT+imuDataDownSampledNew.delVelDT);
+    const float predictDT = ekfTargetDt - 0.5f*dtIMUavg;
+    if ((accumulatedDT >= predictDT && startPredictEnabled) || (accumulatedDT >= predictDT + ekfTargetDt)) {
 
         // convert the accumulated quaternion to an equivalent delta angle
         imuQuatDownSampleNew.to_axis_angle(imuDataDownSampledNew.delAng);
@@ -319,7 +350,7 @@ void NavEKF2_core::readIMUData()
         storedIMU.push_youngest_element(imuDataDownSampledNew);
 
         // calculate the achieved average time step rate for the EKF
-        float dtNow = constrain_float(0.5f*(imuDataDownSampledNew.delAngDT+imuDataDownSampledNew.delVelDT),0.0f,10.0f*EKF_TARGET_DT);
+        float dtNow = constrain_float(accumulatedDT,0.0f,10.0f*ekfTargetDt);
         dtEkfAvg = 0.98f * dtEkfAvg + 0.02f * dtNow;
 
         // zero the accumulated IMU data and quaternion
@@ -337,7 +368,7 @@ void NavEKF2_core::readIMUData()
         runUpdates = true;
 
         // extract the oldest available data from the FIFO buffer
-        imuDataDelayed = storedIMU.pop_oldest_element();
+        imuDataDelayed = storedIMU.get_oldest_element();
 
         // protect against delta time going to zero
         // TODO - check if calculations can tolerate 0
@@ -379,8 +410,9 @@ void NavEKF2_core::readGpsData()
 {
     // check for new GPS data
     // do not accept data at a faster rate than 14Hz to avoid overflowing the FIFO buffer
-    if (_ahrs->get_gps().last_message_time_ms() - lastTimeGpsReceived_ms > 70) {
-        if (_ahrs->get_gps().status() >= AP_GPS::GPS_OK_FIX_3D) {
+    const auto &frame = frontend->sensorFrame;
+    if (frame.gpsTime_ms - lastTimeGpsReceived_ms > 70) {
+        if (frame.gpsStatus >= AP_GPS::GPS_OK_FIX_3D) {
             // report GPS fix status
             gpsCheckStatus.bad_fix = false;
 
@@ -388,7 +420,7 @@ void NavEKF2_core::readGpsData()
             secondLastGpsTime_ms = lastTimeGpsReceived_ms;
 
             // get current fix time
-            lastTimeGpsReceived_ms = _ahrs->get_gps().last_message_time_ms();
+            lastTimeGpsReceived_ms = frame.gpsTime_ms;
 
             // estimate when the GPS fix was valid, allowing for GPS processing and other delays
             // ideally we should be using a timing signal from the GPS receiver to set this time
@@ -401,47 +433,44 @@ void NavEKF2_core::readGpsData()
             gpsDataNew.time_ms = MAX(gpsDataNew.time_ms,imuDataDelayed.time_ms);
 
             // read the NED velocity from the GPS
-            gpsDataNew.vel = _ahrs->get_gps().velocity();
+            gpsDataNew.vel = frame.gpsVel;
 
             // Use the speed and position accuracy from the GPS if available, otherwise set it to zero.
             // Apply a decaying envelope filter with a 5 second time constant to the raw accuracy data
             float alpha = constrain_float(0.0002f * (lastTimeGpsReceived_ms - secondLastGpsTime_ms),0.0f,1.0f);
             gpsSpdAccuracy *= (1.0f - alpha);
-            float gpsSpdAccRaw;
-            if (!_ahrs->get_gps().speed_accuracy(gpsSpdAccRaw)) {
+            if (!frame.gpsHaveSpdAcc) {
                 gpsSpdAccuracy = 0.0f;
             } else {
-                gpsSpdAccuracy = MAX(gpsSpdAccuracy,gpsSpdAccRaw);
+                gpsSpdAccuracy = MAX(gpsSpdAccuracy,frame.gpsSpdAcc);
                 gpsSpdAccuracy = MIN(gpsSpdAccuracy,50.0f);
             }
             gpsPosAccuracy *= (1.0f - alpha);
-            float gpsPosAccRaw;
-            if (!_ahrs->get_gps().horizontal_accuracy(gpsPosAccRaw)) {
+            if (!frame.gpsHavePosAcc) {
                 gpsPosAccuracy = 0.0f;
             } else {
-                gpsPosAccuracy = MAX(gpsPosAccuracy,gpsPosAccRaw);
+                gpsPosAccuracy = MAX(gpsPosAccuracy,frame.gpsPosAcc);
                 gpsPosAccuracy = MIN(gpsPosAccuracy,100.0f);
             }
             gpsHgtAccuracy *= (1.0f - alpha);
-            float gpsHgtAccRaw;
-            if (!_ahrs->get_gps().vertical_accuracy(gpsHgtAccRaw)) {
+            if (!frame.gpsHaveHgtAcc) {
                 gpsHgtAccuracy = 0.0f;
             } else {
-                gpsHgtAccuracy = MAX(gpsHgtAccuracy,gpsHgtAccRaw);
+                gpsHgtAccuracy = MAX(gpsHgtAccuracy,frame.gpsHgtAcc);
                 gpsHgtAccuracy = MIN(gpsHgtAccuracy,100.0f);
             }
 
             // check if we have enough GPS satellites and increase the gps noise scaler if we don't
-            if (_ahrs->get_gps().num_sats() >= 6 && (PV_AidingMode == AID_ABSOLUTE)) {
+            if (frame.gpsNumSats >= 6 && (PV_AidingMode == AID_ABSOLUTE)) {
                 gpsNoiseScaler = 1.0f;
-            } else if (_ahrs->get_gps().num_sats() == 5 && (PV_AidingMode == AID_ABSOLUTE)) {
+            } else if (frame.gpsNumSats == 5 && (PV_AidingMode == AID_ABSOLUTE)) {
                 gpsNoiseScaler = 1.4f;
             } else { // <= 4 satellites or in constant position mode
                 gpsNoiseScaler = 2.0f;
             }
 
             // Check if GPS can output vertical velocity and set GPS fusion mode accordingly
-            if (_ahrs->get_gps().have_vertical_velocity() && frontend->_fusionModeGPS == 0) {
+            if (frame.gpsHaveVertVel && frontend->_fusionModeGPS == 0) {
                 useGpsVertVel = true;
             } else {
                 useGpsVertVel = false;
@@ -459,7 +488,7 @@ void NavEKF2_core::readGpsData()
             calcGpsGoodForFlight();
 
             // Read the GPS locaton in WGS-84 lat,long,height coordinates
-            const struct Location &gpsloc = _ahrs->get_gps().location();
+            const struct Location &gpsloc = frame.gpsLoc;
 
             // Set the EKF origin and magnetic field declination if not previously set  and GPS checks have passed
             if (gpsGoodToAlign && !validOrigin) {
@@ -516,12 +545,18 @@ bool NavEKF2_core::readDeltaAngle(uint8_t ins_index, Vector3f &dAng) {
 // check for new pressure altitude measurement data and update stored measurement if available
 void NavEKF2_core::readBaroData()
 {
+    // the height and its time come from one reading of the primary sensor
+    if (!frontend->sensorFrame.baroValid) {
+        return;
+    }
+    const uint32_t baro_ms = frontend->sensorFrame.baroTime_ms;
+
     // check to see if baro measurement has changed so we know if a new measurement has arrived
     // do not accept data at a faster rate than 14Hz to avoid overflowing the FIFO buffer
-    if (frontend->_baro.get_last_update() - lastBaroReceived_ms > 70) {
+    if (baro_ms - lastBaroReceived_ms > 70) {
         frontend->logging.log_baro = true;
 
-        baroDataNew.hgt = frontend->_baro.get_altitude();
+        baroDataNew.hgt = frontend->sensorFrame.baroHgt;
 
         // If we are in takeoff mode, the height measurement is limited to be no less than the measurement at start of takeoff
         // This prevents negative baro disturbances due to copter downwash corrupting the EKF altitude during initial ascent
@@ -530,7 +565,7 @@ void NavEKF2_core::readBaroData()
         }
 
         // time stamp used to check for new measurement
-        lastBaroReceived_ms = frontend->_baro.get_last_update();
+        lastBaroReceived_ms = baro_ms;
 
         // estimate of time height measurement was taken, allowing for delays
         baroDataNew.time_ms = lastBaroReceived_ms - frontend->_hgtDelay_ms;
@@ -609,12 +644,10 @@ void NavEKF2_core::readAirSpdData()
     // if airspeed reading is valid and is set by the user to be used and has been updated then
     // we take a new reading, convert from EAS to TAS and set the flag letting other functions
     // know a new measurement is available
-    const AP_Airspeed *aspeed = _ahrs->get_airspeed();
-    if (aspeed &&
-            aspeed->use() &&
-            aspeed->last_update_ms() != timeTasReceived_ms) {
-        tasDataNew.tas = aspeed->get_airspeed() * aspeed->get_EAS2TAS();
-        timeTasReceived_ms = aspeed->last_update_ms();
+    if (frontend->sensorFrame.tasValid &&
+            frontend->sensorFrame.tasTime_ms != timeTasReceived_ms) {
+        tasDataNew.tas = frontend->sensorFrame.tas;
+        timeTasReceived_ms = frontend->sensorFrame.tasTime_ms;
         tasDataNew.time_ms = timeTasReceived_ms - frontend->tasDelay_ms;
 
         // Correct for the average intersampling delay due to the filter update rate
@@ -27,6 +27,7 @@
 #include "AP_NavEKF2.h"
 #include <stdio.h>
 #include <AP_Math/vectorN.h>
+#include <AP_Math/symmatrixN.h>
 #include <AP_NavEKF2/AP_NavEKF2_Buffer.h>
 
 // GPS pre-flight check bit locations
@@ -413,6 +414,18 @@ private:
     // force symmetry on the state covariance matrix
     void ForceSymmetry();
 
+    // calculate the H*P row vector for a scalar observation whose Jacobian H is only non zero at the listed state indexes
+    void CalcScalarHP(const ftype *H, const uint8_t *Hidx, uint8_t Hcount);
+
+    // calculate the H*P row vector for a direct observation of a single state
+    void CalcScalarHP(uint8_t stateIndex);
+
+    // return true if the covariance update using Kfusion and HP will not drive any variances negative
+    bool ScalarCovarianceUpdateHealthy() const;
+
+    // correct the covariance P = P - K*H*P using Kfusion and HP
+    void ScalarCovarianceUpdate();
+
     // copy covariances across from covariance prediction calculation and fix numerical errors
     void CopyCovariances();
 
@@ -616,6 +629,9 @@ private:
     // Apply a median filter to range finder data
     void readRangeFinder();
 
+    // store a range measurement in the median filter of a sensor
+    void storeRngMeas(uint8_t sensorIndex, uint32_t time_ms, float rng);
+
     // check if the vehicle has taken off during optical flow navigation by looking at inertial and range finder data
     void detectOptFlowTakeoff(void);
 
@@ -673,12 +689,11 @@ private:
     bool badMagYaw;                 // boolean true if the magnetometer is declared to be producing bad data
     bool badIMUdata;                // boolean true if the bad IMU data is detected
 
-    const float EKF_TARGET_DT = 0.01f;    // target EKF update time step
+    float ekfTargetDt;              // target EKF update time step (sec)
 
     float gpsNoiseScaler;           // Used to scale the  GPS measurement noise and consistency gates to compensate for operation with small satellite counts
     Vector28 Kfusion;               // Kalman gain vector
-    Matrix24 KH;                    // intermediate result used for covariance updates
-    Matrix24 KHP;                   // intermediate result used for covariance updates
+    Vector24 HP;                    // H*P row vector for the scalar observation being fused, shared by all fusion steps
     Matrix24 P;                     // covariance matrix
     imu_ring_buffer_t<imu_elements> storedIMU;      // IMU data buffer
     obs_ring_buffer_t<gps_elements> storedGPS;      // GPS data buffer
@@ -732,7 +747,7 @@ private:
     bool allMagSensorsFailed;       // true if all magnetometer sensors have timed out on this flight and we are no longer using magnetometer data
     uint32_t lastSynthYawTime_ms;   // time stamp when synthetic yaw measurement was last fused to maintain covariance health (msec)
     uint32_t ekfStartTime_ms;       // time the EKF was started (msec)
-    Matrix24 nextP;                 // Predicted covariance matrix before addition of process noise to diagonals
+    SymMatrixN<ftype,24> nextP;     // Predicted covariance matrix before addition of process noise to diagonals, packed upper triangle
     Vector24 processNoise;          // process noise added to diagonals of predicted covariance matrix
     Vector25 SF;                    // intermediate variables used to calculate predicted covariance matrix
     Vector5 SG;                     // intermediate variables used to calculate predicted covariance matrix
@@ -912,6 +927,7 @@ private:
     uint32_t storedRngMeasTime_ms[2][3];    // Ringbuffers of stored range measurement times for dual range sensors
     uint32_t lastRngMeasTime_ms;            // Timestamp of last range measurement
     uint8_t rngMeasIndex[2];                // Current range measurement ringbuffer index for dual range sensors
+    uint32_t lastRngSampleTime_ms[2];       // Time of the last queued sample read from each range sensor, 0 if none yet
     bool terrainHgtStable;                  // true when the terrain height is stable enough to be used as a height reference
     uint32_t terrainHgtStableSet_ms;        // system time at which terrainHgtStable was set
 
@@ -1007,6 +1023,7 @@ private:
     AP_HAL::Util::perf_counter_t  _perf_FuseSideslip;
     AP_HAL::Util::perf_counter_t  _perf_TerrainOffset;
     AP_HAL::Util::perf_counter_t  _perf_FuseOptFlow;
+    AP_HAL::Util::perf_counter_t  _perf_calcOutputStates;
     AP_HAL::Util::perf_counter_t  _perf_test[10];
 
     // should we assume zero sideslip?
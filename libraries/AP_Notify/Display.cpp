@@ -338,9 +338,9 @@ void Display::update()
         _flags.ekf_bad = AP_Notify::flags.ekf_bad;
     }
 
-    // if somethings has changed, update display
-    if (_need_update) {
-        hw_update();
+    // if somethings has changed, update display, trying again on
+    // the next update if the display isn't ready for it
+    if (_need_update && hw_update()) {
         _need_update = false;
     }
 }
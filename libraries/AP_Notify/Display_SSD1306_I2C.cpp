@@ -49,40 +49,113 @@ bool Display_SSD1306_I2C::hw_init()
     // give back i2c semaphore
     _dev->get_semaphore()->give();
 
+    // the frame buffer is sent from the bus thread, a page at a time
+    // so sensors sharing the bus aren't held up for long
+    _timer_handle = _dev->register_periodic_callback(10 * USEC_PER_MSEC,
+                                                     FUNCTOR_BIND_MEMBER(&Display_SSD1306_I2C::_timer, bool));
+
     // clear display
+    for (uint8_t i = 0; i < SSD1306_PAGES; i++) {
+        _damage(0, i * 8);
+        _damage(SSD1306_ROWS-1, i * 8);
+    }
     hw_update();
 
     return true;
 }
 
+/*
+  hand the pages that have changed to the bus thread. Returns false if
+  it is still sending the last ones, in which case the caller should
+  try again later
+ */
 bool Display_SSD1306_I2C::hw_update()
 {
+    if (!_dev) {
+        return false;
+    }
+    if (_dirty_pages == 0) {
+        return true;
+    }
+    if (__atomic_load_n(&_tx_pages, __ATOMIC_ACQUIRE) != 0) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < SSD1306_PAGES; i++) {
+        if (_dirty_pages & (1U << i)) {
+            const uint16_t ofs = i * SSD1306_ROWS + _dirty[i].lo;
+            memcpy(&_txbuffer[ofs], &_displaybuffer[ofs], _dirty[i].hi - _dirty[i].lo + 1);
+            _tx[i] = _dirty[i];
+        }
+    }
+    __atomic_store_n(&_tx_pages, _dirty_pages, __ATOMIC_RELEASE);
+    _dirty_pages = 0;
+
+    if (_timer_handle == nullptr) {
+        // no bus thread, send them from here
+        if (!_dev->get_semaphore()->take(5)) {
+            return true;
+        }
+        while (__atomic_load_n(&_tx_pages, __ATOMIC_ACQUIRE) != 0) {
+            _timer();
+        }
+        _dev->get_semaphore()->give();
+    }
+
+    return true;
+}
+
+/*
+  note a changed pixel
+ */
+void Display_SSD1306_I2C::_damage(uint16_t x, uint16_t y)
+{
+    const uint8_t page = y / 8;
+    if (!(_dirty_pages & (1U << page))) {
+        _dirty_pages |= 1U << page;
+        _dirty[page].lo = x;
+        _dirty[page].hi = x;
+    } else if (x < _dirty[page].lo) {
+        _dirty[page].lo = x;
+    } else if (x > _dirty[page].hi) {
+        _dirty[page].hi = x;
+    }
+}
+
+/*
+  send the changed rows of one of the pages handed over by
+  hw_update(). Called with the bus semaphore held
+ */
+bool Display_SSD1306_I2C::_timer(void)
+{
+    const uint8_t pages = __atomic_load_n(&_tx_pages, __ATOMIC_ACQUIRE);
+    if (pages == 0) {
+        return true;
+    }
+    uint8_t i = 0;
+    while (!(pages & (1U << i))) {
+        i++;
+    }
+
+    // set the column and page address window to the changed rows
     struct PACKED {
         uint8_t reg;
         uint8_t cmd[6];
-    } command = { 0x0, {0x21, 0, 127, 0x22, 0, 7} };
+    } command = { 0x0, {0x21, _tx[i].lo, _tx[i].hi, 0x22, i, i} };
 
     struct PACKED {
         uint8_t reg;
         uint8_t db[SSD1306_ROWS];
     } display_buffer = { 0x40, {} };
 
-    if (!_dev || !_dev->get_semaphore()->take(5)) {
-        return false;
-    }
+    const uint8_t len = _tx[i].hi - _tx[i].lo + 1;
 
-    // write buffer to display
-    for (uint8_t i = 0; i < (SSD1306_COLUMNS / SSD1306_COLUMNS_PER_PAGE); i++) {
-        command.cmd[4] = i;
+    _dev->transfer((uint8_t *)&command, sizeof(command), nullptr, 0);
 
-        _dev->transfer((uint8_t *)&command, sizeof(command), nullptr, 0);
+    memcpy(&display_buffer.db[0], &_txbuffer[i * SSD1306_ROWS + _tx[i].lo], len);
+    _dev->transfer((uint8_t *)&display_buffer, 1 + len, nullptr, 0);
 
-        memcpy(&display_buffer.db[0], &_displaybuffer[i * SSD1306_ROWS], SSD1306_ROWS);
-        _dev->transfer((uint8_t *)&display_buffer, sizeof(display_buffer), nullptr, 0);
-    }
-
-    // give back i2c semaphore
-    _dev->get_semaphore()->give();
+    __atomic_fetch_and(&_tx_pages, (uint8_t)~(1U << i), __ATOMIC_RELEASE);
 
     return true;
 }
@@ -94,7 +167,12 @@ bool Display_SSD1306_I2C::set_pixel(uint16_t x, uint16_t y)
         return false;
     }
     // set pixel in buffer
-    _displaybuffer[x + (y / 8 * SSD1306_ROWS)] |= 1 << (y % 8);
+    uint8_t &b = _displaybuffer[x + (y / 8 * SSD1306_ROWS)];
+    const uint8_t bit = 1 << (y % 8);
+    if (!(b & bit)) {
+        b |= bit;
+        _damage(x, y);
+    }
 
     return true;
 }
@@ -106,7 +184,12 @@ bool Display_SSD1306_I2C::clear_pixel(uint16_t x, uint16_t y)
         return false;
     }
     // clear pixel in buffer
-    _displaybuffer[x + (y / 8 * SSD1306_ROWS)] &= ~(1 << (y % 8));
+    uint8_t &b = _displaybuffer[x + (y / 8 * SSD1306_ROWS)];
+    const uint8_t bit = 1 << (y % 8);
+    if (b & bit) {
+        b &= ~bit;
+        _damage(x, y);
+    }
 
     return true;
 }
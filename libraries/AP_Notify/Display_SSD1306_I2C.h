@@ -6,6 +6,7 @@
 #define SSD1306_ROWS 128		    // display rows
 #define SSD1306_COLUMNS 64		    // display columns
 #define SSD1306_COLUMNS_PER_PAGE 8
+#define SSD1306_PAGES (SSD1306_COLUMNS / SSD1306_COLUMNS_PER_PAGE)
 
 class Display_SSD1306_I2C: public Display {
 public:
@@ -16,5 +17,25 @@ public:
 
 private:
     AP_HAL::OwnPtr<AP_HAL::I2CDevice> _dev;
+    AP_HAL::Device::PeriodicHandle _timer_handle = nullptr;
     uint8_t _displaybuffer[SSD1306_ROWS * SSD1306_COLUMNS_PER_PAGE];
+
+    // range of display rows changed in each page of _displaybuffer
+    // since the last hw_update()
+    struct damage {
+        uint8_t lo;
+        uint8_t hi;
+    };
+    void _damage(uint16_t x, uint16_t y);
+    uint8_t _dirty_pages = 0;
+    struct damage _dirty[SSD1306_PAGES];
+
+    // copy of the damage handed to the bus thread, and which pages
+    // those are. The bus thread sends a page per call, clearing its
+    // bit in _tx_pages once it is sent
+    uint8_t _txbuffer[SSD1306_ROWS * SSD1306_COLUMNS_PER_PAGE];
+    struct damage _tx[SSD1306_PAGES];
+    uint8_t _tx_pages = 0;
+
+    bool _timer(void);
 };
@@ -22,6 +22,8 @@
 #define PCA9685_ADDRESS 0x40
 #define PCA9685_PWM 0x6
 
+#define LED_RGB_PENDING (1U<<24)
+
 extern const AP_HAL::HAL& hal;
 
 bool NavioLED_I2C::hw_init()
@@ -39,17 +41,49 @@ bool NavioLED_I2C::hw_init()
     // give back i2c semaphore
     _dev->get_semaphore()->give();
 
+    // colour changes are written from the bus thread
+    _timer_handle = _dev->register_periodic_callback(20 * USEC_PER_MSEC,
+                                                     FUNCTOR_BIND_MEMBER(&NavioLED_I2C::_timer, bool));
+
     return ret;
 }
 
 // set_rgb - set color as a combination of red, green and blue values
 bool NavioLED_I2C::hw_set_rgb(uint8_t red, uint8_t green, uint8_t blue)
 {
-    // exit immediately if we can't take the semaphore
-    if (!_dev || !_dev->get_semaphore()->take(5)) {
+    if (!_dev) {
         return false;
     }
 
+    __atomic_store_n(&_rgb_pending, LED_RGB_PENDING | (red << 16) | (green << 8) | blue,
+                     __ATOMIC_RELEASE);
+
+    if (_timer_handle == nullptr) {
+        // no bus thread, write it from here
+        if (!_dev->get_semaphore()->take(5)) {
+            return false;
+        }
+        _timer();
+        _dev->get_semaphore()->give();
+    }
+
+    return true;
+}
+
+/*
+  write the latest colour, if it has changed. Called with the bus
+  semaphore held
+ */
+bool NavioLED_I2C::_timer(void)
+{
+    uint32_t rgb = __atomic_exchange_n(&_rgb_pending, 0, __ATOMIC_ACQUIRE);
+    if (rgb == 0) {
+        return true;
+    }
+    uint8_t red = (rgb >> 16) & 0xFF;
+    uint8_t green = (rgb >> 8) & 0xFF;
+    uint8_t blue = rgb & 0xFF;
+
     uint16_t red_adjusted = red * 0x10;
     uint16_t green_adjusted = green * 0x10;
     uint16_t blue_adjusted = blue * 0x10;
@@ -68,9 +102,12 @@ bool NavioLED_I2C::hw_set_rgb(uint8_t red, uint8_t green, uint8_t blue)
 			     0x00, 0x00, green_channel_lsb, green_channel_msb,
 			     0x00, 0x00, red_channel_lsb, red_channel_msb};
 
-    bool success = _dev->transfer(transaction, sizeof(transaction), nullptr, 0);
+    if (!_dev->transfer(transaction, sizeof(transaction), nullptr, 0)) {
+        // try again next time, unless a newer colour has been set
+        uint32_t none = 0;
+        __atomic_compare_exchange_n(&_rgb_pending, &none, rgb, false,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
 
-    // give back i2c semaphore
-    _dev->get_semaphore()->give();
-    return success;
+    return true;
 }
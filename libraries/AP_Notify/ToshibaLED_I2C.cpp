@@ -34,6 +34,8 @@ extern const AP_HAL::HAL& hal;
 #define TOSHIBA_LED_PWM2    0x03    // pwm2 register
 #define TOSHIBA_LED_ENABLE  0x04    // enable register
 
+#define LED_RGB_PENDING     (1U<<24)
+
 bool ToshibaLED_I2C::hw_init()
 {
     _dev = std::move(hal.i2c_mgr->get_device(TOSHIBA_LED_I2C_BUS, TOSHIBA_LED_I2C_ADDR));
@@ -53,22 +55,58 @@ bool ToshibaLED_I2C::hw_init()
     // give back i2c semaphore
     _dev->get_semaphore()->give();
 
+    // colour changes are written from the bus thread
+    _timer_handle = _dev->register_periodic_callback(20 * USEC_PER_MSEC,
+                                                     FUNCTOR_BIND_MEMBER(&ToshibaLED_I2C::_timer, bool));
+
     return ret;
 }
 
 // set_rgb - set color as a combination of red, green and blue values
 bool ToshibaLED_I2C::hw_set_rgb(uint8_t red, uint8_t green, uint8_t blue)
 {
-    if (!_dev || !_dev->get_semaphore()->take(5)) {
+    if (!_dev) {
         return false;
     }
 
+    __atomic_store_n(&_rgb_pending, LED_RGB_PENDING | (red << 16) | (green << 8) | blue,
+                     __ATOMIC_RELEASE);
+
+    if (_timer_handle == nullptr) {
+        // no bus thread, write it from here
+        if (!_dev->get_semaphore()->take(5)) {
+            return false;
+        }
+        _timer();
+        _dev->get_semaphore()->give();
+    }
+
+    return true;
+}
+
+/*
+  write the latest colour, if it has changed. Called with the bus
+  semaphore held
+ */
+bool ToshibaLED_I2C::_timer(void)
+{
+    uint32_t rgb = __atomic_exchange_n(&_rgb_pending, 0, __ATOMIC_ACQUIRE);
+    if (rgb == 0) {
+        return true;
+    }
+    uint8_t red = (rgb >> 16) & 0xFF;
+    uint8_t green = (rgb >> 8) & 0xFF;
+    uint8_t blue = rgb & 0xFF;
+
     /* 4-bit for each color */
     uint8_t val[4] = { TOSHIBA_LED_PWM0, (uint8_t)(blue >> 4),
                        (uint8_t)(green / 16), (uint8_t)(red / 16) };
-    bool ret = _dev->transfer(val, sizeof(val), nullptr, 0);
-
-    _dev->get_semaphore()->give();
+    if (!_dev->transfer(val, sizeof(val), nullptr, 0)) {
+        // try again next time, unless a newer colour has been set
+        uint32_t none = 0;
+        __atomic_compare_exchange_n(&_rgb_pending, &none, rgb, false,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
 
-    return ret;
+    return true;
 }
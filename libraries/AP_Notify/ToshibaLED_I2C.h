@@ -27,4 +27,11 @@ public:
 
 private:
     AP_HAL::OwnPtr<AP_HAL::I2CDevice> _dev;
+    AP_HAL::Device::PeriodicHandle _timer_handle = nullptr;
+
+    // colour waiting to be written from the bus thread, with
+    // LED_RGB_PENDING set
+    uint32_t _rgb_pending = 0;
+
+    bool _timer(void);
 };
@@ -61,6 +61,21 @@ uint16_t AP_Param::_num_vars;
 
 // cached parameter count
 uint16_t AP_Param::_parameter_count;
+AP_Param *AP_Param::_index_cursor;
+AP_Param::ParamToken AP_Param::_index_cursor_token;
+enum ap_var_type AP_Param::_index_cursor_type;
+uint16_t AP_Param::_index_cursor_idx;
+struct AP_Param::storage_index_entry *AP_Param::_storage_index;
+uint16_t AP_Param::_storage_index_count;
+uint16_t AP_Param::_storage_index_size;
+uint16_t AP_Param::_sentinal_ofs;
+uint32_t AP_Param::_load_all_us;
+#if AP_PARAM_NAME_INDEX
+struct AP_Param::name_index_entry *AP_Param::_name_index;
+uint16_t AP_Param::_name_index_count;
+uint32_t AP_Param::_name_index_built_ms;
+bool AP_Param::_name_index_stale;
+#endif
 
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
@@ -105,6 +120,104 @@ void AP_Param::erase_all(void)
 
     // add a sentinal directly after the header
     write_sentinal(sizeof(struct EEPROM_header));
+
+    // the next load_all() rebuilds the storage index
+    storage_index_free();
+}
+
+// the header as a single value, for sorting the storage index
+uint32_t AP_Param::header_value(const Param_header &phdr)
+{
+    return (uint32_t)get_key(phdr) << 23 | (uint32_t)phdr.type << 18 | phdr.group_element;
+}
+
+// sort by header, keeping the first stored copy first
+int AP_Param::storage_index_compare(const void *a, const void *b)
+{
+    const struct storage_index_entry *e1 = (const struct storage_index_entry *)a;
+    const struct storage_index_entry *e2 = (const struct storage_index_entry *)b;
+    if (e1->header != e2->header) {
+        return e1->header < e2->header ? -1 : 1;
+    }
+    return (int)e1->ofs - (int)e2->ofs;
+}
+
+void AP_Param::storage_index_free(void)
+{
+    delete[] _storage_index;
+    _storage_index = nullptr;
+    _storage_index_count = 0;
+    _storage_index_size = 0;
+    _sentinal_ofs = 0;
+}
+
+/*
+  add an entry at the end of the storage index, growing it as needed
+ */
+bool AP_Param::storage_index_append(const Param_header &phdr, uint16_t ofs)
+{
+    if (_storage_index_count == _storage_index_size) {
+        const uint16_t new_size = _storage_index_size + 64;
+        struct storage_index_entry *new_index = new storage_index_entry[new_size];
+        if (new_index == nullptr) {
+            return false;
+        }
+        if (_storage_index != nullptr) {
+            memcpy(new_index, _storage_index, _storage_index_count * sizeof(new_index[0]));
+            delete[] _storage_index;
+        }
+        _storage_index = new_index;
+        _storage_index_size = new_size;
+    }
+    _storage_index[_storage_index_count].header = header_value(phdr);
+    _storage_index[_storage_index_count].ofs = ofs;
+    _storage_index_count++;
+    return true;
+}
+
+/*
+  insert a newly stored variable into the sorted storage index
+ */
+bool AP_Param::storage_index_insert(const Param_header &phdr, uint16_t ofs)
+{
+    if (!storage_index_append(phdr, ofs)) {
+        return false;
+    }
+    // new records go after all others in storage, so the new entry
+    // belongs after any with the same header
+    const struct storage_index_entry e = _storage_index[_storage_index_count-1];
+    uint16_t i = _storage_index_count-1;
+    while (i > 0 && _storage_index[i-1].header > e.header) {
+        i--;
+    }
+    memmove(&_storage_index[i+1], &_storage_index[i],
+            (_storage_index_count-1-i) * sizeof(_storage_index[0]));
+    _storage_index[i] = e;
+    return true;
+}
+
+/*
+  find the first stored copy of a header in the storage index. On
+  failure pofs is set to the sentinal
+ */
+bool AP_Param::storage_index_find(uint32_t header, uint16_t *pofs)
+{
+    uint16_t lo = 0;
+    uint16_t hi = _storage_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_storage_index[mid].header < header) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < _storage_index_count && _storage_index[lo].header == header) {
+        *pofs = _storage_index[lo].ofs;
+        return true;
+    }
+    *pofs = _sentinal_ofs;
+    return false;
 }
 
 /* the 'group_id' of a element of a group is the 18 bit identifier
@@ -589,6 +702,10 @@ bool AP_Param::is_sentinal(const Param_header &phdr)
 // if the sentinal isn't found either, the offset is set to 0xFFFF
 bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
 {
+    if (_storage_index != nullptr) {
+        return storage_index_find(header_value(*target), pofs);
+    }
+
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
@@ -739,6 +856,146 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype)
+{
+#if AP_PARAM_NAME_INDEX
+    AP_Param *ap = find_in_name_index(name, ptype);
+    if (ap != nullptr) {
+        return ap;
+    }
+    ap = find_by_scan(name, ptype);
+    if (ap != nullptr) {
+        // the index is missing this variable, probably because its
+        // object was allocated after the index was built
+        _name_index_stale = true;
+    }
+    return ap;
+#else
+    return find_by_scan(name, ptype);
+#endif
+}
+
+#if AP_PARAM_NAME_INDEX
+/*
+  FNV-1a hash of a parameter name
+ */
+uint32_t AP_Param::name_hash(const char *name)
+{
+    uint32_t h = 2166136261U;
+    while (*name) {
+        h = (h ^ (uint8_t)*name++) * 16777619U;
+    }
+    return h;
+}
+
+// sort by hash, keeping tree order for equal hashes
+int AP_Param::name_index_compare(const void *a, const void *b)
+{
+    const struct name_index_entry *e1 = (const struct name_index_entry *)a;
+    const struct name_index_entry *e2 = (const struct name_index_entry *)b;
+    if (e1->hash != e2->hash) {
+        return e1->hash < e2->hash ? -1 : 1;
+    }
+    return (int)e1->order - (int)e2->order;
+}
+
+/*
+  build the name index from the scalar parameters currently in the
+  tree. Rebuilds are limited to one every 10 seconds so a variable
+  that can never be indexed can't trigger one on every lookup
+ */
+bool AP_Param::build_name_index(void)
+{
+    const uint32_t now = AP_HAL::millis();
+    if (_name_index != nullptr &&
+        (!_name_index_stale || now - _name_index_built_ms < 10000)) {
+        return true;
+    }
+    if (_name_index == nullptr && _name_index_built_ms != 0 &&
+        now - _name_index_built_ms < 10000) {
+        // a previous allocation failed
+        return false;
+    }
+    _name_index_built_ms = now;
+    _name_index_stale = false;
+
+    delete[] _name_index;
+    _name_index = nullptr;
+    _name_index_count = 0;
+
+    ParamToken token;
+    enum ap_var_type type;
+    uint16_t count = 0;
+    for (AP_Param *ap = first(&token, &type); ap != nullptr; ap = next_scalar(&token, &type)) {
+        count++;
+    }
+    if (count == 0) {
+        return false;
+    }
+    _name_index = new name_index_entry[count];
+    if (_name_index == nullptr) {
+        return false;
+    }
+
+    for (AP_Param *ap = first(&token, &type);
+         ap != nullptr && _name_index_count < count;
+         ap = next_scalar(&token, &type)) {
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, sizeof(name), true);
+        name[AP_MAX_NAME_SIZE] = 0;
+        struct name_index_entry &e = _name_index[_name_index_count];
+        e.hash = name_hash(name);
+        e.order = _name_index_count;
+        e.type = type;
+        e.token = token;
+        e.ap = ap;
+        _name_index_count++;
+    }
+    qsort(_name_index, _name_index_count, sizeof(_name_index[0]), name_index_compare);
+    return true;
+}
+
+/*
+  look up a scalar variable in the name index. Returns nullptr if it
+  is not indexed, in which case the caller falls back to a full scan
+ */
+AP_Param *AP_Param::find_in_name_index(const char *name, enum ap_var_type *ptype)
+{
+    if (!build_name_index()) {
+        return nullptr;
+    }
+    const uint32_t h = name_hash(name);
+
+    // find the first entry with a matching hash
+    uint16_t lo = 0;
+    uint16_t hi = _name_index_count;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (_name_index[mid].hash < h) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // confirm the name, as different names can share a hash
+    for (; lo < _name_index_count && _name_index[lo].hash == h; lo++) {
+        const struct name_index_entry &e = _name_index[lo];
+        char vname[AP_MAX_NAME_SIZE+1];
+        e.ap->copy_name_token(e.token, vname, sizeof(vname), true);
+        vname[AP_MAX_NAME_SIZE] = 0;
+        if (strcmp(name, vname) == 0) {
+            *ptype = (enum ap_var_type)e.type;
+            return e.ap;
+        }
+    }
+    return nullptr;
+}
+#endif // AP_PARAM_NAME_INDEX
+
+// Find a variable by name by walking the whole tree.
+//
+AP_Param *
+AP_Param::find_by_scan(const char *name, enum ap_var_type *ptype)
 {
     for (uint16_t i=0; i<_num_vars; i++) {
         uint8_t type = _var_info[i].type;
@@ -792,19 +1049,39 @@ AP_Param::find_def_value_ptr(const char *name)
     return &info->def_value;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index. This walks the tree, so is slow unless
+// idx is at or after the previous lookup, which is the usual case
+// when a GCS fetches parameters it missed from a list download.
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
     AP_Param *ap;
-    uint16_t count=0;
-    for (ap=AP_Param::first(token, ptype);
-         ap && count < idx;
-         ap=AP_Param::next_scalar(token, ptype)) {
+    enum ap_var_type type;
+    uint16_t count;
+    if (_index_cursor != nullptr && idx >= _index_cursor_idx) {
+        ap = _index_cursor;
+        *token = _index_cursor_token;
+        type = _index_cursor_type;
+        count = _index_cursor_idx;
+    } else {
+        ap = AP_Param::first(token, &type);
+        count = 0;
+    }
+    while (ap && count < idx) {
+        ap = AP_Param::next_scalar(token, &type);
         count++;
     }
-    return ap;    
+    if (ap != nullptr) {
+        _index_cursor = ap;
+        _index_cursor_token = *token;
+        _index_cursor_type = type;
+        _index_cursor_idx = idx;
+        if (ptype != nullptr) {
+            *ptype = type;
+        }
+    }
+    return ap;
 }
 
 
@@ -948,8 +1225,10 @@ bool AP_Param::save(bool force_save)
     }
 
     if (phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
-        // clear cached parameter count
+        // clear cached parameter count, and the index cursor as
+        // the set of visible parameters may have changed
         _parameter_count = 0;
+        _index_cursor = nullptr;
     }
     
     char name[AP_MAX_NAME_SIZE+1];
@@ -1001,6 +1280,15 @@ bool AP_Param::save(bool force_save)
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
 
+    if (_storage_index != nullptr) {
+        if (storage_index_insert(phdr, ofs)) {
+            _sentinal_ofs = ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type);
+        } else {
+            // out of memory, go back to scanning storage
+            storage_index_free();
+        }
+    }
+
     send_parameter(name, (enum ap_var_type)phdr.type, idx);
     return true;
 }
@@ -1207,27 +1495,123 @@ void AP_Param::setup_sketch_defaults(void)
 }
 
 
-// Load all variables from EEPROM
-//
-bool AP_Param::load_all(void)
+/*
+  build the storage index with a single pass over the headers in
+  storage, without loading any values. Returns false if the index
+  could not be allocated or there is no sentinal
+ */
+bool AP_Param::storage_index_build(void)
 {
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
 
-#if HAL_OS_POSIX_IO == 1
-    /*
-      if the HAL specifies a defaults parameter file then override
-      defaults using that file
-     */
-    const char *default_file = hal.util->get_custom_defaults_file();
-    if (default_file) {
-        if (load_defaults_file(default_file)) {
-            printf("Loaded defaults from %s\n", default_file);
-        } else {
-            printf("Failed to load defaults from %s\n", default_file);
+    storage_index_free();
+    _storage_index = new storage_index_entry[64];
+    if (_storage_index == nullptr) {
+        return false;
+    }
+    _storage_index_size = 64;
+
+    while (ofs < _storage.size()) {
+        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        // note that this is an || not an && for robustness
+        // against power off while adding a variable
+        if (is_sentinal(phdr)) {
+            // we've reached the sentinal
+            if (_storage_index_count > 1) {
+                qsort(_storage_index, _storage_index_count, sizeof(_storage_index[0]), storage_index_compare);
+            }
+            _sentinal_ofs = ofs;
+            return true;
+        }
+        if (!storage_index_append(phdr, ofs)) {
+            break;
         }
+        ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
-#endif
+
+    storage_index_free();
+    return false;
+}
+
+/*
+  load every element of a group, looking up each one in the storage
+  index. This walks the group the same way find_by_header_group() does
+ */
+void AP_Param::load_group_from_index(uint16_t vindex,
+                                     const struct GroupInfo *group_info,
+                                     uint32_t group_base,
+                                     uint8_t group_shift,
+                                     ptrdiff_t group_offset,
+                                     ptrdiff_t base)
+{
+    uint8_t type;
+    for (uint8_t i=0;
+         (type=group_info[i].type) != AP_PARAM_NONE;
+         i++) {
+        if (type == AP_PARAM_GROUP) {
+            // a nested group
+            if (group_shift + _group_level_shift >= _group_bits) {
+                // too deeply nested - this should have been caught by
+                // setup() !
+                return;
+            }
+            ptrdiff_t new_offset = group_offset;
+            if (!adjust_group_offset(vindex, group_info[i], new_offset)) {
+                continue;
+            }
+            load_group_from_index(vindex, group_info[i].group_info,
+                                  group_id(group_info, group_base, i, group_shift),
+                                  group_shift + _group_level_shift, new_offset, base);
+            continue;
+        }
+        struct Param_header phdr;
+        set_key(phdr, _var_info[vindex].key);
+        phdr.type = type;
+        phdr.group_element = group_id(group_info, group_base, i, group_shift);
+        uint16_t ofs;
+        if (storage_index_find(header_value(phdr), &ofs)) {
+            void *ptr = (void*)(base + group_info[i].offset + group_offset);
+            _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)type));
+        }
+    }
+}
+
+/*
+  load all variables that have a stored value, resolving each var_info
+  entry directly from the storage index
+ */
+void AP_Param::load_from_index(void)
+{
+    for (uint16_t i=0; i<_num_vars; i++) {
+        const uint8_t type = _var_info[i].type;
+        ptrdiff_t base;
+        if (!get_base(_var_info[i], base)) {
+            continue;
+        }
+        if (type == AP_PARAM_GROUP) {
+            load_group_from_index(i, _var_info[i].group_info, 0, 0, 0, base);
+            continue;
+        }
+        struct Param_header phdr;
+        set_key(phdr, _var_info[i].key);
+        phdr.type = type;
+        phdr.group_element = 0;
+        uint16_t ofs;
+        if (storage_index_find(header_value(phdr), &ofs)) {
+            _storage.read_block((void*)base, ofs+sizeof(phdr), type_size((enum ap_var_type)type));
+        }
+    }
+}
+
+/*
+  load all variables by walking storage and finding the variable for
+  each record. Used when the storage index can't be built
+ */
+bool AP_Param::load_all_scan(void)
+{
+    struct Param_header phdr;
+    uint16_t ofs = sizeof(AP_Param::EEPROM_header);
 
     while (ofs < _storage.size()) {
         _storage.read_block(&phdr, ofs, sizeof(phdr));
@@ -1254,6 +1638,49 @@ bool AP_Param::load_all(void)
     return false;
 }
 
+// Load all variables from EEPROM
+//
+bool AP_Param::load_all(void)
+{
+#if HAL_OS_POSIX_IO == 1
+    /*
+      if the HAL specifies a defaults parameter file then override
+      defaults using that file
+     */
+    const char *default_file = hal.util->get_custom_defaults_file();
+    if (default_file) {
+        if (load_defaults_file(default_file)) {
+            printf("Loaded defaults from %s\n", default_file);
+        } else {
+            printf("Failed to load defaults from %s\n", default_file);
+        }
+    }
+#endif
+
+    const uint32_t start_us = AP_HAL::micros();
+
+    /*
+      one pass over storage builds the index, then each variable is
+      looked up in it. Only the first stored copy of a variable is
+      loaded, which is the copy that save() updates
+     */
+    bool ret;
+    if (storage_index_build()) {
+        load_from_index();
+        ret = true;
+    } else {
+        // without a sentinal the index can't say where to add
+        // variables, so fall back to loading record by record
+        ret = load_all_scan();
+    }
+
+    _load_all_us = AP_HAL::micros() - start_us;
+#if HAL_OS_POSIX_IO == 1
+    printf("Loaded parameters in %u usec\n", (unsigned)_load_all_us);
+#endif
+    return ret;
+}
+
 
 
 /* 
@@ -1849,6 +2276,30 @@ uint16_t AP_Param::count_parameters(void)
     return _parameter_count;
 }
 
+/*
+  CRC32 over the name and value of every parameter, in index
+  order. This lets a GCS holding a cached parameter list check it is
+  still current without downloading the whole list. It is computed on
+  each call as parameters can change without going through AP_Param
+ */
+uint32_t AP_Param::checksum_parameters(void)
+{
+    uint32_t crc = 0;
+    AP_Param::ParamToken token;
+    enum ap_var_type type;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(&token, &type)) {
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, sizeof(name), true);
+        name[AP_MAX_NAME_SIZE] = 0;
+        crc = crc_crc32(crc, (const uint8_t *)name, strlen(name));
+        const float value = ap->cast_to_float(type);
+        crc = crc_crc32(crc, (const uint8_t *)&value, sizeof(value));
+    }
+    return crc;
+}
+
 /*
   set a default value by name
  */
@@ -31,6 +31,15 @@
 
 #define AP_MAX_NAME_SIZE 16
 
+/*
+  keep a sorted index of parameter name hashes in RAM so find() is a
+  binary search rather than a walk of the whole tree. Only enabled
+  where memory is plentiful
+ */
+#ifndef AP_PARAM_NAME_INDEX
+#define AP_PARAM_NAME_INDEX (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
 /*
   flags for variables in var_info and group tables
  */
@@ -58,22 +67,22 @@
 #define AP_CLASSTYPE(clazz, element) ((uint8_t)(((const clazz *) 1)->element.vtype))
 
 // declare a group var_info line
-#define AP_GROUPINFO_FLAGS(name, idx, clazz, element, def, flags) { AP_CLASSTYPE(clazz, element), idx, name, AP_VAROFFSET(clazz, element), {def_value : def}, flags }
+#define AP_GROUPINFO_FLAGS(name, idx, clazz, element, def, flags) { AP_CLASSTYPE(clazz, element), idx, flags, name, AP_VAROFFSET(clazz, element), {def_value : def} }
 
 // declare a group var_info line
 #define AP_GROUPINFO(name, idx, clazz, element, def) AP_GROUPINFO_FLAGS(name, idx, clazz, element, def, 0)
 
 // declare a nested group entry in a group var_info
-#define AP_NESTEDGROUPINFO(clazz, idx) { AP_PARAM_GROUP, idx, "", 0, { group_info : clazz::var_info }, 0 }
+#define AP_NESTEDGROUPINFO(clazz, idx) { AP_PARAM_GROUP, idx, 0, "", 0, { group_info : clazz::var_info } }
 
 // declare a subgroup entry in a group var_info. This is for having another arbitrary object as a member of the parameter list of
 // an object
-#define AP_SUBGROUPINFO(element, name, idx, thisclazz, elclazz) { AP_PARAM_GROUP, idx, name, AP_VAROFFSET(thisclazz, element), { group_info : elclazz::var_info }, AP_PARAM_FLAG_NESTED_OFFSET }
+#define AP_SUBGROUPINFO(element, name, idx, thisclazz, elclazz) { AP_PARAM_GROUP, idx, AP_PARAM_FLAG_NESTED_OFFSET, name, AP_VAROFFSET(thisclazz, element), { group_info : elclazz::var_info } }
 
 // declare a pointer subgroup entry in a group var_info
-#define AP_SUBGROUPPTR(element, name, idx, thisclazz, elclazz) { AP_PARAM_GROUP, idx, name, AP_VAROFFSET(thisclazz, element), { group_info : elclazz::var_info }, AP_PARAM_FLAG_POINTER }
+#define AP_SUBGROUPPTR(element, name, idx, thisclazz, elclazz) { AP_PARAM_GROUP, idx, AP_PARAM_FLAG_POINTER, name, AP_VAROFFSET(thisclazz, element), { group_info : elclazz::var_info } }
 
-#define AP_GROUPEND     { AP_PARAM_NONE, 0xFF, "", 0, { group_info : NULL } }
+#define AP_GROUPEND     { AP_PARAM_NONE, 0xFF, 0, "", 0, { group_info : NULL } }
 #define AP_VAREND       { AP_PARAM_NONE, "", 0, NULL, { group_info : NULL } }
 
 enum ap_var_type {
@@ -97,16 +106,23 @@ public:
     // the Info and GroupInfo structures are passed by the main
     // program in setup() to give information on how variables are
     // named and their location in memory
+    //
+    // GroupInfo is most of the parameter table in flash, so the byte
+    // sized fields are kept together to avoid padding. A class's
+    // var_info is one table shared by all its instances, so per
+    // instance groups don't repeat their defaults. The default shares
+    // a union with the nested group pointer, so a narrower encoding
+    // of it would save nothing
     struct GroupInfo {
         uint8_t type; // AP_PARAM_*
         uint8_t idx;  // identifier within the group
+        uint8_t flags;
         const char *name;
         ptrdiff_t offset; // offset within the object
         union {
             const struct GroupInfo *group_info;
             const float def_value;
         };
-        uint8_t flags;
     };
     struct Info {
         uint8_t type; // AP_PARAM_*
@@ -209,8 +225,8 @@ public:
     /// @return                 true if the variable is found
     static bool set_default_by_name(const char *name, float value);
     
-    /// Find a variable by index.
-    ///
+    /// Find a variable by index. Lookups continue from the previous
+    /// one when idx is not lower, so ascending requests are cheap.
     ///
     /// @param  idx             The index of the variable
     /// @return                 A pointer to the variable, or NULL if
@@ -264,6 +280,9 @@ public:
     ///
     static bool load_all(void);
 
+    /// time taken by the last load_all(), in microseconds
+    static uint32_t load_all_time_us(void) { return _load_all_us; }
+
     static void load_object_from_eeprom(const void *object_pointer, const struct GroupInfo *group_info);
     
     // set a AP_Param variable to a specified value
@@ -346,6 +365,9 @@ public:
     // count of parameters in tree
     static uint16_t count_parameters(void);
 
+    // CRC32 over the name and value of every parameter in index order
+    static uint32_t checksum_parameters(void);
+
     static void set_hide_disabled_groups(bool value) { _hide_disabled_groups = value; }
 
 private:
@@ -460,6 +482,61 @@ private:
     // find a default value given a pointer to a default value in flash
     static float get_default_value(const float *def_value_ptr);
 
+    /*
+      index of the storage offset of each stored variable, sorted by
+      header. Built by load_all() and kept up to date by save(), so
+      neither save() nor load() has to scan storage. When it is not
+      available scan() walks storage as before
+     */
+    struct storage_index_entry {
+        uint32_t header;
+        uint16_t ofs;
+    };
+    static struct storage_index_entry *_storage_index;
+    static uint16_t             _storage_index_count;
+    static uint16_t             _storage_index_size;
+    static uint16_t             _sentinal_ofs;
+
+    static uint32_t             header_value(const Param_header &phdr);
+    static int                  storage_index_compare(const void *a, const void *b);
+    static void                 storage_index_free(void);
+    static bool                 storage_index_append(const Param_header &phdr, uint16_t ofs);
+    static bool                 storage_index_insert(const Param_header &phdr, uint16_t ofs);
+    static bool                 storage_index_find(uint32_t header, uint16_t *pofs);
+    static bool                 storage_index_build(void);
+    static void                 load_from_index(void);
+    static void                 load_group_from_index(
+                                    uint16_t vindex,
+                                    const struct GroupInfo *group_info,
+                                    uint32_t group_base,
+                                    uint8_t group_shift,
+                                    ptrdiff_t group_offset,
+                                    ptrdiff_t base);
+    static bool                 load_all_scan(void);
+    static uint32_t             _load_all_us;
+
+    // find a variable by name by walking the whole tree
+    static AP_Param *find_by_scan(const char *name, enum ap_var_type *ptype);
+
+#if AP_PARAM_NAME_INDEX
+    struct name_index_entry {
+        uint32_t hash;
+        uint16_t order;
+        uint8_t type;
+        ParamToken token;
+        AP_Param *ap;
+    };
+    static struct name_index_entry *_name_index;
+    static uint16_t             _name_index_count;
+    static uint32_t             _name_index_built_ms;
+    static bool                 _name_index_stale;
+
+    static uint32_t name_hash(const char *name);
+    static int name_index_compare(const void *a, const void *b);
+    static bool build_name_index(void);
+    static AP_Param *find_in_name_index(const char *name, enum ap_var_type *ptype);
+#endif
+
     /*
       find the def_value for a variable by name
     */
@@ -479,6 +556,12 @@ private:
     static StorageAccess        _storage;
     static uint16_t             _num_vars;
     static uint16_t             _parameter_count;
+
+    // where the last find_by_index() finished
+    static AP_Param *           _index_cursor;
+    static ParamToken           _index_cursor_token;
+    static enum ap_var_type     _index_cursor_type;
+    static uint16_t             _index_cursor_idx;
     static const struct Info *  _var_info;
 
     /*
@@ -15,6 +15,7 @@
 
 #include "AP_Proximity.h"
 #include "AP_Proximity_LightWareSF40C.h"
+#include "AP_Proximity_RangeFinder.h"
 
 extern const AP_HAL::HAL &hal;
 
@@ -25,7 +26,7 @@ const AP_Param::GroupInfo AP_Proximity::var_info[] = {
     // @Param: _TYPE
     // @DisplayName: Proximity type
     // @Description: What type of proximity sensor is connected
-    // @Values: 0:None,1:LightWareSF40C
+    // @Values: 0:None,1:LightWareSF40C,2:RangeFinder
     // @User: Standard
     AP_GROUPINFO("_TYPE",   1, AP_Proximity, _type[0], 0),
 
@@ -47,7 +48,7 @@ const AP_Param::GroupInfo AP_Proximity::var_info[] = {
     // @Param: 2_TYPE
     // @DisplayName: Second Proximity type
     // @Description: What type of proximity sensor is connected
-    // @Values: 0:None,1:LightWareSF40C
+    // @Values: 0:None,1:LightWareSF40C,2:RangeFinder
     // @User: Advanced
     AP_GROUPINFO("2_TYPE", 4, AP_Proximity, _type[1], 0),
 
@@ -69,12 +70,14 @@ const AP_Param::GroupInfo AP_Proximity::var_info[] = {
     AP_GROUPEND
 };
 
-AP_Proximity::AP_Proximity(AP_SerialManager &_serial_manager) :
+AP_Proximity::AP_Proximity(AP_SerialManager &_serial_manager, const RangeFinder &_rangefinder) :
     primary_instance(0),
     num_instances(0),
-    serial_manager(_serial_manager)
+    serial_manager(_serial_manager),
+    rangefinder(_rangefinder)
 {
     AP_Param::setup_object_defaults(this, var_info);
+    _map.clear();
 }
 
 // initialise the Proximity class. We do detection of attached sensors here
@@ -167,13 +170,20 @@ void AP_Proximity::detect_instance(uint8_t instance)
             return;
         }
     }
+    if (type == Proximity_Type_RangeFinder) {
+        if (AP_Proximity_RangeFinder::detect(rangefinder)) {
+            state[instance].instance = instance;
+            drivers[instance] = new AP_Proximity_RangeFinder(*this, state[instance], rangefinder);
+            return;
+        }
+    }
 }
 
 // get distance in meters in a particular direction in degrees (0 is forward, clockwise)
 // returns true on successful read and places distance in distance
 bool AP_Proximity::get_horizontal_distance(uint8_t instance, float angle_deg, float &distance) const
 {
-    if ((drivers[instance] == NULL) || (_type[instance] == Proximity_Type_None)) {
+    if ((instance >= num_instances) || (drivers[instance] == NULL) || (_type[instance] == Proximity_Type_None)) {
         return false;
     }
     // get distance from backend
@@ -184,5 +194,5 @@ bool AP_Proximity::get_horizontal_distance(uint8_t instance, float angle_deg, fl
 // returns true on successful read and places distance in distance
 bool AP_Proximity::get_horizontal_distance(float angle_deg, float &distance) const
 {
-    return get_horizontal_distance(primary_instance, angle_deg, distance);
+    return _map.get_horizontal_distance(angle_deg, distance);
 }
@@ -19,9 +19,11 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_SerialManager/AP_SerialManager.h>
+#include <AP_RangeFinder/RangeFinder.h>
+#include "AP_Proximity_Map.h"
 
 
-#define PROXIMITY_MAX_INSTANCES             1   // Maximum number of proximity sensor instances available on this platform
+#define PROXIMITY_MAX_INSTANCES             2   // Maximum number of proximity sensor instances available on this platform
 #define PROXIMITY_YAW_CORRECTION_DEFAULT    22  // default correction for sensor error in yaw
 
 class AP_Proximity_Backend;
@@ -31,12 +33,13 @@ class AP_Proximity
 public:
     friend class AP_Proximity_Backend;
 
-    AP_Proximity(AP_SerialManager &_serial_manager);
+    AP_Proximity(AP_SerialManager &_serial_manager, const RangeFinder &_rangefinder);
 
     // Proximity driver types
     enum Proximity_Type {
         Proximity_Type_None  = 0,
         Proximity_Type_SF40C = 1,
+        Proximity_Type_RangeFinder = 2,
     };
 
     enum Proximity_Status {
@@ -65,10 +68,14 @@ public:
     }
 
     // get distance in meters in a particular direction in degrees (0 is forward, clockwise)
-    // returns true on successful read and places distance in distance
+    // returns true on successful read and places distance in distance.
+    // Without an instance the closest reading of all sensors is returned
     bool get_horizontal_distance(uint8_t instance, float angle_deg, float &distance) const;
     bool get_horizontal_distance(float angle_deg, float &distance) const;
 
+    // map of the closest obstacles seen by all sensors
+    const AP_Proximity_Map &get_map() const { return _map; }
+
     // The Proximity_State structure is filled in by the backend driver
     struct Proximity_State {
         uint8_t                 instance;   // the instance number of this proximity sensor
@@ -84,6 +91,10 @@ private:
     uint8_t primary_instance:3;
     uint8_t num_instances:3;
     AP_SerialManager &serial_manager;
+    const RangeFinder &rangefinder;
+
+    // fused readings of all instances
+    AP_Proximity_Map _map;
 
     // parameters for all instances
     AP_Int8  _type[PROXIMITY_MAX_INSTANCES];
@@ -40,6 +40,11 @@ protected:
     // set status and update valid_count
     void set_status(AP_Proximity::Proximity_Status status);
 
+    // add a reading to the map shared by all sensors
+    void update_map(float angle_deg, float elevation_deg, float distance_m) {
+        frontend._map.update(angle_deg, elevation_deg, distance_m);
+    }
+
     AP_Proximity &frontend;
     AP_Proximity::Proximity_State &state;   // reference to this instances state
 };
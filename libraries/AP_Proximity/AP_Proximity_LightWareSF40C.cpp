@@ -351,6 +351,7 @@ bool AP_Proximity_LightWareSF40C::process_reply()
                 _distance[sector] = distance_m;
                 _distance_valid[sector] = true;
                 _last_distance_received_ms = AP_HAL::millis();
+                update_map(angle_deg, 0.0f, distance_m);
                 success = true;
             }
             break;
@@ -0,0 +1,79 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include "AP_Proximity_Map.h"
+
+// sector whose middle is closest to angle_deg
+uint8_t AP_Proximity_Map::angle_to_sector(float angle_deg)
+{
+    const float sector = wrap_360(angle_deg + PROXIMITY_MAP_SECTOR_WIDTH_DEG * 0.5f) / PROXIMITY_MAP_SECTOR_WIDTH_DEG;
+    return ((uint8_t)sector) % PROXIMITY_MAP_SECTORS;
+}
+
+void AP_Proximity_Map::update(float angle_deg, float elevation_deg, float distance_m)
+{
+    if (distance_m <= 0.0f) {
+        return;
+    }
+    enum Layer layer = Layer_Level;
+    if (elevation_deg > PROXIMITY_MAP_ELEVATION_DEG) {
+        layer = Layer_Above;
+    } else if (elevation_deg < -PROXIMITY_MAP_ELEVATION_DEG) {
+        layer = Layer_Below;
+    }
+    const uint8_t sector = angle_to_sector(angle_deg);
+    const uint32_t now = AP_HAL::millis();
+
+    // a closer obstacle always wins, a further one only once the
+    // closer reading has had time to be refreshed
+    const uint32_t age = now - _time_ms[layer][sector];
+    if (_time_ms[layer][sector] == 0 ||
+        distance_m <= _distance_m[layer][sector] ||
+        age > PROXIMITY_MAP_REFRESH_MS) {
+        _distance_m[layer][sector] = distance_m;
+        _time_ms[layer][sector] = MAX(now, 1U);
+    }
+}
+
+bool AP_Proximity_Map::get_distance(enum Layer layer, uint8_t sector, float &distance_m) const
+{
+    if (layer >= Layer_Count || sector >= PROXIMITY_MAP_SECTORS ||
+        _time_ms[layer][sector] == 0 ||
+        AP_HAL::millis() - _time_ms[layer][sector] > PROXIMITY_MAP_TIMEOUT_MS) {
+        return false;
+    }
+    distance_m = _distance_m[layer][sector];
+    return true;
+}
+
+uint8_t AP_Proximity_Map::get_horizontal_distances(float distance_m[PROXIMITY_MAP_SECTORS]) const
+{
+    const uint32_t now = AP_HAL::millis();
+    uint8_t valid = 0;
+    for (uint8_t i=0; i<PROXIMITY_MAP_SECTORS; i++) {
+        distance_m[i] = _distance_m[Layer_Level][i];
+        if (_time_ms[Layer_Level][i] != 0 &&
+            now - _time_ms[Layer_Level][i] <= PROXIMITY_MAP_TIMEOUT_MS) {
+            valid |= 1U << i;
+        }
+    }
+    return valid;
+}
+
+void AP_Proximity_Map::clear()
+{
+    memset(_time_ms, 0, sizeof(_time_ms));
+}
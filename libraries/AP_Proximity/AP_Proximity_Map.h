@@ -0,0 +1,71 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+#define PROXIMITY_MAP_SECTORS           8       // sectors around the vehicle, 0 is forward
+#define PROXIMITY_MAP_SECTOR_WIDTH_DEG  (360/PROXIMITY_MAP_SECTORS)
+#define PROXIMITY_MAP_ELEVATION_DEG     30      // readings further than this above or below level go in the upper or lower layer
+#define PROXIMITY_MAP_TIMEOUT_MS        500     // readings older than this are forgotten
+#define PROXIMITY_MAP_REFRESH_MS        100     // a further reading only replaces a closer one older than this
+
+/*
+  polar map of the closest obstacle around the vehicle, shared by all
+  proximity sensors. Each cell holds the closest distance reported in
+  its direction, so overlapping sensors fuse to the most cautious
+  reading, and cells expire when no sensor has refreshed them
+ */
+class AP_Proximity_Map
+{
+public:
+    enum Layer {
+        Layer_Below = 0,
+        Layer_Level,
+        Layer_Above,
+        Layer_Count
+    };
+
+    // add a reading at angle_deg (0 is forward, clockwise) and
+    // elevation_deg (positive up) in the body frame
+    void update(float angle_deg, float elevation_deg, float distance_m);
+
+    // distance to the closest obstacle in a cell, false if no
+    // recent reading
+    bool get_distance(enum Layer layer, uint8_t sector, float &distance_m) const;
+
+    // distance to the closest level obstacle in the direction angle_deg
+    bool get_horizontal_distance(float angle_deg, float &distance_m) const {
+        return get_distance(Layer_Level, angle_to_sector(angle_deg), distance_m);
+    }
+
+    // copy the level distances of all sectors in one pass. Returns a
+    // bitmask of the sectors holding a recent reading
+    uint8_t get_horizontal_distances(float distance_m[PROXIMITY_MAP_SECTORS]) const;
+
+    // forget all readings
+    void clear();
+
+    static uint8_t angle_to_sector(float angle_deg);
+    static float sector_to_angle(uint8_t sector) {
+        return sector * PROXIMITY_MAP_SECTOR_WIDTH_DEG;
+    }
+
+private:
+    float _distance_m[Layer_Count][PROXIMITY_MAP_SECTORS];
+    // system time of the last reading, zero if there is none
+    uint32_t _time_ms[Layer_Count][PROXIMITY_MAP_SECTORS];
+};
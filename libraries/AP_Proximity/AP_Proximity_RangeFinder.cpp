@@ -0,0 +1,89 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include "AP_Proximity_RangeFinder.h"
+
+extern const AP_HAL::HAL& hal;
+
+AP_Proximity_RangeFinder::AP_Proximity_RangeFinder(AP_Proximity &_frontend,
+                                                   AP_Proximity::Proximity_State &_state,
+                                                   const RangeFinder &rangefinder) :
+    AP_Proximity_Backend(_frontend, _state),
+    _rangefinder(rangefinder),
+    _last_distance_received_ms(0)
+{
+    memset(_last_update_ms, 0, sizeof(_last_update_ms));
+}
+
+// detect if any range finder is set up to face somewhere other than down
+bool AP_Proximity_RangeFinder::detect(const RangeFinder &rangefinder)
+{
+    for (uint8_t i=0; i<rangefinder.num_sensors(); i++) {
+        if (rangefinder.orientation(i) != ROTATION_PITCH_270) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// copy the latest readings of the horizontal, upward and downward
+// facing range finders into the proximity map
+void AP_Proximity_RangeFinder::update(void)
+{
+    const uint32_t now = AP_HAL::millis();
+
+    for (uint8_t i=0; i<_rangefinder.num_sensors(); i++) {
+        const enum Rotation orientation = _rangefinder.orientation(i);
+        if (orientation == ROTATION_PITCH_270 ||
+            _rangefinder.status(i) != RangeFinder::RangeFinder_Good) {
+            // altitude sensors are left to the altitude controllers
+            continue;
+        }
+        const float distance_m = _rangefinder.distance_cm(i) * 0.01f;
+        if (orientation == ROTATION_PITCH_90) {
+            update_map(0.0f, 90.0f, distance_m);
+        } else if (orientation <= ROTATION_YAW_315) {
+            // the yaw rotations are 45 degrees apart, clockwise from forward
+            const float angle_deg = orientation * 45.0f;
+            const uint8_t sector = AP_Proximity_Map::angle_to_sector(angle_deg);
+            if (_last_update_ms[sector] != now || distance_m < _distance[sector]) {
+                _distance[sector] = distance_m;
+            }
+            _last_update_ms[sector] = now;
+            _last_distance_received_ms = now;
+            update_map(angle_deg, 0.0f, distance_m);
+        }
+    }
+
+    // check for timeout and set health status
+    if ((_last_distance_received_ms == 0) || (now - _last_distance_received_ms > PROXIMITY_RANGEFINDER_TIMEOUT_MS)) {
+        set_status(AP_Proximity::Proximity_NoData);
+    } else {
+        set_status(AP_Proximity::Proximity_Good);
+    }
+}
+
+// get distance in meters in a particular direction in degrees (0 is forward, angles increase in the clockwise direction)
+bool AP_Proximity_RangeFinder::get_horizontal_distance(float angle_deg, float &distance) const
+{
+    const uint8_t sector = AP_Proximity_Map::angle_to_sector(angle_deg);
+    if (_last_update_ms[sector] == 0 ||
+        AP_HAL::millis() - _last_update_ms[sector] > PROXIMITY_RANGEFINDER_TIMEOUT_MS) {
+        return false;
+    }
+    distance = _distance[sector];
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <AP_RangeFinder/RangeFinder.h>
+#include "AP_Proximity.h"
+#include "AP_Proximity_Backend.h"
+
+#define PROXIMITY_RANGEFINDER_TIMEOUT_MS  200   // no data if no horizontal range finder has reported for this long
+
+/*
+  proximity backend built from the range finders that are not facing
+  down, each of which covers the sector it is pointing at
+ */
+class AP_Proximity_RangeFinder : public AP_Proximity_Backend
+{
+
+public:
+    // constructor
+    AP_Proximity_RangeFinder(AP_Proximity &_frontend, AP_Proximity::Proximity_State &_state, const RangeFinder &rangefinder);
+
+    // static detection function
+    static bool detect(const RangeFinder &rangefinder);
+
+    // get distance in meters in a particular direction in degrees (0 is forward, clockwise)
+    // returns true on successful read and places distance in distance
+    bool get_horizontal_distance(float angle_deg, float &distance) const;
+
+    // update state
+    void update(void);
+
+private:
+    const RangeFinder &_rangefinder;
+
+    // closest reading in each sector from this backend's range finders
+    float _distance[PROXIMITY_MAP_SECTORS];
+    uint32_t _last_update_ms[PROXIMITY_MAP_SECTORS];
+    uint32_t _last_distance_received_ms;
+};
@@ -30,6 +30,11 @@ StorageAccess AP_Rally::_storage(StorageManager::StorageRally);
 #define RALLY_INCLUDE_HOME_DEFAULT 0
 #endif
 
+// how long, and how far from where it was made, the result of
+// update() is used for
+#define RALLY_BEST_MAX_AGE_MS   1000
+#define RALLY_BEST_MAX_MOVE_M   50.0f
+
 const AP_Param::GroupInfo AP_Rally::var_info[] = {
     // @Param: TOTAL
     // @DisplayName: Rally Total
@@ -59,10 +64,40 @@ const AP_Param::GroupInfo AP_Rally::var_info[] = {
 AP_Rally::AP_Rally(AP_AHRS &ahrs) 
     : _ahrs(ahrs)
     , _last_change_time_ms(0xFFFFFFFF)
+    , _cache(nullptr)
+    , _cache_valid(nullptr)
+    , _cache_failed(false)
+    , _best{}
 {
     AP_Param::setup_object_defaults(this, var_info);
 }
 
+/*
+  allocate the decoded rally point cache, sized for the whole rally area
+ */
+bool AP_Rally::cache_alloc(void) const
+{
+    if (_cache != nullptr) {
+        return true;
+    }
+    if (_cache_failed) {
+        return false;
+    }
+    const uint8_t n = get_rally_max();
+    _cache = new RallyLocation[n];
+    _cache_valid = new uint32_t[(n+31)/32];
+    if (_cache == nullptr || _cache_valid == nullptr) {
+        delete[] _cache;
+        delete[] _cache_valid;
+        _cache = nullptr;
+        _cache_valid = nullptr;
+        _cache_failed = true;
+        return false;
+    }
+    memset(_cache_valid, 0, ((n+31)/32) * sizeof(uint32_t));
+    return true;
+}
+
 // get a rally point from EEPROM
 bool AP_Rally::get_rally_point_with_index(uint8_t i, RallyLocation &ret) const
 {
@@ -70,7 +105,16 @@ bool AP_Rally::get_rally_point_with_index(uint8_t i, RallyLocation &ret) const
         return false;
     }
 
-    _storage.read_block(&ret, i * sizeof(RallyLocation), sizeof(RallyLocation));
+    const bool cached = cache_alloc() && i < get_rally_max();
+    if (cached && (_cache_valid[i/32] & (1U<<(i%32)))) {
+        ret = _cache[i];
+    } else {
+        _storage.read_block(&ret, i * sizeof(RallyLocation), sizeof(RallyLocation));
+        if (cached) {
+            _cache[i] = ret;
+            _cache_valid[i/32] |= (1U<<(i%32));
+        }
+    }
 
     if (ret.lat == 0 && ret.lng == 0) {
         return false; // sanity check
@@ -92,6 +136,10 @@ bool AP_Rally::set_rally_point_with_index(uint8_t i, const RallyLocation &rallyL
 
     _storage.write_block(i * sizeof(RallyLocation), &rallyLoc, sizeof(RallyLocation));
 
+    if (_cache_valid != nullptr) {
+        _cache_valid[i/32] &= ~(1U<<(i%32));
+    }
+
     _last_change_time_ms = AP_HAL::millis();
 
     return true;
@@ -118,6 +166,35 @@ Location AP_Rally::rally_location_to_location(const RallyLocation &rally_loc) co
 
 // returns true if a valid rally point is found, otherwise returns false to indicate home position should be used
 bool AP_Rally::find_nearest_rally_point(const Location &current_loc, RallyLocation &return_loc) const
+{
+    // use the result of update() if nothing has changed since
+    const struct Location &home_loc = _ahrs.get_home();
+    if (_best.valid &&
+        _best.change_time_ms == _last_change_time_ms &&
+        _best.total == (uint8_t)_rally_point_total_count &&
+        AP_HAL::millis() - _best.time_ms < RALLY_BEST_MAX_AGE_MS &&
+        _best.home.lat == home_loc.lat && _best.home.lng == home_loc.lng &&
+        get_distance(current_loc, _best.loc) < RALLY_BEST_MAX_MOVE_M) {
+        if (_best.found) {
+            return_loc = _best.rally;
+        }
+        return _best.found;
+    }
+    return search_nearest_rally_point(current_loc, return_loc);
+}
+
+void AP_Rally::update(const Location &current_loc)
+{
+    _best.found = search_nearest_rally_point(current_loc, _best.rally);
+    _best.loc = current_loc;
+    _best.home = _ahrs.get_home();
+    _best.time_ms = AP_HAL::millis();
+    _best.change_time_ms = _last_change_time_ms;
+    _best.total = _rally_point_total_count;
+    _best.valid = true;
+}
+
+bool AP_Rally::search_nearest_rally_point(const Location &current_loc, RallyLocation &return_loc) const
 {
     float min_dis = -1;
     const struct Location &home_loc = _ahrs.get_home();
@@ -53,6 +53,10 @@ public:
     Location calc_best_rally_or_home_location(const Location &current_loc, float rtl_home_alt) const;
     bool find_nearest_rally_point(const Location &myloc, RallyLocation &ret) const;
 
+    // refresh the nearest rally point for the current location. Called
+    // from a low rate task so a failsafe gets its answer without a search
+    void update(const Location &current_loc);
+
     // last time rally points changed
     uint32_t last_change_time_ms(void) const { return _last_change_time_ms; }
 
@@ -73,4 +77,27 @@ private:
     AP_Int8  _rally_incl_home;
 
     uint32_t _last_change_time_ms;
+
+    // decoded copies of stored rally points, indexed by rally point
+    // number. An entry is only used if its bit in _cache_valid is set
+    mutable RallyLocation *_cache;
+    mutable uint32_t *_cache_valid;
+    mutable bool _cache_failed;
+
+    // allocate the cache on first use, returns false if unavailable
+    bool cache_alloc(void) const;
+
+    // result of the last update()
+    struct {
+        Location loc;           // location the search was made from
+        Location home;          // home at the time of the search
+        RallyLocation rally;
+        uint32_t time_ms;
+        uint32_t change_time_ms;
+        uint8_t total;
+        bool found:1;
+        bool valid:1;
+    } _best;
+
+    bool search_nearest_rally_point(const Location &current_loc, RallyLocation &return_loc) const;
 };
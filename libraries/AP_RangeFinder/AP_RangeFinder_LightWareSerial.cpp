@@ -58,11 +58,20 @@ bool AP_RangeFinder_LightWareSerial::get_reading(uint16_t &reading_cm)
     uint16_t count = 0;
     int16_t nbytes = uart->available();
     while (nbytes-- > 0) {
+        if (linebuf_len == 0) {
+            // each line is a measurement, timed by its first byte
+            const uint64_t time_us = uart->receive_time_us();
+            line_time_ms = time_us != 0 ? (uint32_t)(time_us / 1000) : AP_HAL::millis();
+        }
         char c = uart->read();
         if (c == '\r') {
             linebuf[linebuf_len] = 0;
-            sum += (float)atof(linebuf);
+            const float distance_m = (float)atof(linebuf);
+            sum += distance_m;
             count++;
+            if (linebuf_len > 0) {
+                add_sample(line_time_ms, 100 * distance_m);
+            }
             linebuf_len = 0;
         } else if (isdigit(c) || c == '.') {
             linebuf[linebuf_len++] = c;
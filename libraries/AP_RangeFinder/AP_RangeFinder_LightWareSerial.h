@@ -25,4 +25,6 @@ private:
     uint32_t last_reading_ms = 0;
     char linebuf[10];
     uint8_t linebuf_len = 0;
+    // receive time of the first byte of linebuf
+    uint32_t line_time_ms = 0;
 };
@@ -30,6 +30,12 @@ AP_RangeFinder_PulsedLightLRF::AP_RangeFinder_PulsedLightLRF(RangeFinder &_range
                                                              RangeFinder::RangeFinder_State &_state)
     : AP_RangeFinder_Backend(_ranger, instance, _state)
     , _dev(hal.i2c_mgr->get_device(1, AP_RANGEFINDER_PULSEDLIGHTLRF_ADDR))
+    , _sem(nullptr)
+    , _distance_cm(0)
+    , _last_reading_ms(0)
+    , _new_reading(false)
+    , _measure_start_us(0)
+    , _measuring(false)
 {
 }
 
@@ -56,19 +62,37 @@ AP_RangeFinder_Backend *AP_RangeFinder_PulsedLightLRF::detect(RangeFinder &_rang
         return nullptr;
     }
 
+    if (!sensor->init()) {
+        delete sensor;
+        return nullptr;
+    }
+
     return sensor;
 }
 
+/*
+   from now on read the sensor on the timer thread, as fast as it
+   measures, rather than at the rate update() is called
+*/
+bool AP_RangeFinder_PulsedLightLRF::init()
+{
+    _sem = hal.util->new_semaphore();
+    if (_sem == nullptr) {
+        return false;
+    }
+    _measure_start_us = AP_HAL::micros();
+    _measuring = true;
+    hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_RangeFinder_PulsedLightLRF::_timer, void));
+    return true;
+}
+
 // start_reading() - ask sensor to make a range reading
 bool AP_RangeFinder_PulsedLightLRF::start_reading()
 {
     if (!_dev || !_dev->get_semaphore()->take(1)) {
         return false;
     }
-
-    // send command to take reading
-    bool ret = _dev->write_register(AP_RANGEFINDER_PULSEDLIGHTLRF_MEASURE_REG,
-                                    AP_RANGEFINDER_PULSEDLIGHTLRF_MSRREG_ACQUIRE);
+    bool ret = _start_reading();
     _dev->get_semaphore()->give();
 
     return ret;
@@ -77,30 +101,87 @@ bool AP_RangeFinder_PulsedLightLRF::start_reading()
 // read - return last value measured by sensor
 bool AP_RangeFinder_PulsedLightLRF::get_reading(uint16_t &reading_cm)
 {
-    be16_t val;
-
     if (!_dev->get_semaphore()->take(1)) {
         return false;
     }
-
-    // read the high and low byte distance registers
-    bool ret = _dev->read_registers(AP_RANGEFINDER_PULSEDLIGHTLRF_DISTHIGH_REG,
-                                    (uint8_t *) &val, sizeof(val));
+    bool ret = _read_distance(reading_cm);
+    if (ret) {
+        // kick off another reading for next time
+        // To-Do: replace this with continuous mode
+        hal.scheduler->delay_microseconds(200);
+        _start_reading();
+    }
     _dev->get_semaphore()->give();
 
-    if (!ret) {
+    return ret;
+}
+
+// send command to take reading, bus semaphore must be taken
+bool AP_RangeFinder_PulsedLightLRF::_start_reading()
+{
+    return _dev->write_register(AP_RANGEFINDER_PULSEDLIGHTLRF_MEASURE_REG,
+                                AP_RANGEFINDER_PULSEDLIGHTLRF_MSRREG_ACQUIRE);
+}
+
+// read the high and low byte distance registers, bus semaphore must
+// be taken
+bool AP_RangeFinder_PulsedLightLRF::_read_distance(uint16_t &reading_cm)
+{
+    be16_t val;
+
+    if (!_dev->read_registers(AP_RANGEFINDER_PULSEDLIGHTLRF_DISTHIGH_REG,
+                              (uint8_t *) &val, sizeof(val))) {
         return false;
     }
 
     // combine results into distance
     reading_cm = be16toh(val);
+    return true;
+}
 
-    // kick off another reading for next time
-    // To-Do: replace this with continuous mode
-    hal.scheduler->delay_microseconds(200);
-    start_reading();
+/*
+   read the sensor on the timer thread. A measurement is read on one
+   call and the next one started on the following call, which leaves
+   the sensor time between the two without blocking the thread
+*/
+void AP_RangeFinder_PulsedLightLRF::_timer(void)
+{
+    const uint32_t now_us = AP_HAL::micros();
+    if (_measuring && now_us - _measure_start_us < AP_RANGEFINDER_PULSEDLIGHTLRF_PERIOD_US) {
+        return;
+    }
+    if (!_dev->get_semaphore()->take_nonblocking()) {
+        return;
+    }
 
-    return true;
+    if (!_measuring) {
+        if (_start_reading()) {
+            _measure_start_us = now_us;
+            _measuring = true;
+        }
+        _dev->get_semaphore()->give();
+        return;
+    }
+
+    uint16_t reading_cm;
+    const bool ret = _read_distance(reading_cm);
+    _dev->get_semaphore()->give();
+
+    // start again on the next call even if this read failed
+    _measuring = false;
+    if (!ret) {
+        return;
+    }
+
+    const uint32_t now = AP_HAL::millis();
+    add_sample(now, reading_cm);
+
+    if (_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        _distance_cm = reading_cm;
+        _last_reading_ms = now;
+        _new_reading = true;
+        _sem->give();
+    }
 }
 
 /*
@@ -108,10 +189,21 @@ bool AP_RangeFinder_PulsedLightLRF::get_reading(uint16_t &reading_cm)
 */
 void AP_RangeFinder_PulsedLightLRF::update(void)
 {
-    if (get_reading(state.distance_cm)) {
+    if (!_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+    const bool new_reading = _new_reading;
+    const uint32_t last_reading_ms = _last_reading_ms;
+    if (new_reading) {
+        state.distance_cm = _distance_cm;
+        _new_reading = false;
+    }
+    _sem->give();
+
+    if (new_reading) {
         // update range_valid state based on distance measured
         update_status();
-    } else {
+    } else if (AP_HAL::millis() - last_reading_ms > 200) {
         set_status(RangeFinder::RangeFinder_NoData);
     }
 }
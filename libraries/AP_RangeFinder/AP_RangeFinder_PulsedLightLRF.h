@@ -28,6 +28,9 @@
 // command register values
 #define AP_RANGEFINDER_PULSEDLIGHTLRF_MSRREG_ACQUIRE        0x04    // Varies based on sensor revision, 0x04 is newest, 0x61 is older
 
+// time allowed for each measurement once detected
+#define AP_RANGEFINDER_PULSEDLIGHTLRF_PERIOD_US     10000
+
 class AP_RangeFinder_PulsedLightLRF : public AP_RangeFinder_Backend
 {
 
@@ -45,8 +48,29 @@ private:
     AP_RangeFinder_PulsedLightLRF(RangeFinder &ranger, uint8_t instance,
                                   RangeFinder::RangeFinder_State &_state);
 
+    // start reading on the timer thread
+    bool init(void);
+
     // start a reading
     bool start_reading(void);
     bool get_reading(uint16_t &reading_cm);
+
+    // register access, with the bus semaphore already taken
+    bool _start_reading(void);
+    bool _read_distance(uint16_t &reading_cm);
+
+    // read the sensor on the timer thread
+    void _timer(void);
+
     AP_HAL::OwnPtr<AP_HAL::I2CDevice> _dev;
+
+    // latest measurement from _timer()
+    AP_HAL::Semaphore *_sem;
+    uint16_t _distance_cm;
+    uint32_t _last_reading_ms;
+    bool _new_reading;
+
+    // state of the timer thread
+    uint32_t _measure_start_us;
+    bool _measuring;
 };
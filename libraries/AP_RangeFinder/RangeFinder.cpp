@@ -130,6 +130,13 @@ const AP_Param::GroupInfo RangeFinder::var_info[] = {
     // @User: Standard
     AP_GROUPINFO("_ADDR", 23, RangeFinder, _address[0], 0),
 
+    // @Param: _ORIENT
+    // @DisplayName: Range finder orientation
+    // @Description: Direction the range finder is facing. Only downward facing range finders are used for altitude; the others can feed the proximity map
+    // @Values: 0:Forward, 1:Forward-Right, 2:Right, 3:Back-Right, 4:Back, 5:Back-Left, 6:Left, 7:Forward-Left, 24:Up, 25:Down
+    // @User: Advanced
+    AP_GROUPINFO("_ORIENT", 49, RangeFinder, _orientation[0], ROTATION_PITCH_270),
+
 #if RANGEFINDER_MAX_INSTANCES > 1
     // @Param: 2_TYPE
     // @DisplayName: Second Rangefinder type
@@ -223,6 +230,13 @@ const AP_Param::GroupInfo RangeFinder::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("2_ADDR", 24, RangeFinder, _address[1], 0),
 
+    // @Param: 2_ORIENT
+    // @DisplayName: Second range finder orientation
+    // @Description: Direction the second range finder is facing. Only downward facing range finders are used for altitude; the others can feed the proximity map
+    // @Values: 0:Forward, 1:Forward-Right, 2:Right, 3:Back-Right, 4:Back, 5:Back-Left, 6:Left, 7:Forward-Left, 24:Up, 25:Down
+    // @User: Advanced
+    AP_GROUPINFO("2_ORIENT", 50, RangeFinder, _orientation[1], ROTATION_PITCH_270),
+
 #endif
 
 #if RANGEFINDER_MAX_INSTANCES > 2
@@ -309,6 +323,13 @@ const AP_Param::GroupInfo RangeFinder::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("3_ADDR", 36, RangeFinder, _address[2], 0),
 
+    // @Param: 3_ORIENT
+    // @DisplayName: Third range finder orientation
+    // @Description: Direction the third range finder is facing. Only downward facing range finders are used for altitude; the others can feed the proximity map
+    // @Values: 0:Forward, 1:Forward-Right, 2:Right, 3:Back-Right, 4:Back, 5:Back-Left, 6:Left, 7:Forward-Left, 24:Up, 25:Down
+    // @User: Advanced
+    AP_GROUPINFO("3_ORIENT", 51, RangeFinder, _orientation[2], ROTATION_PITCH_270),
+
 #endif
 
 #if RANGEFINDER_MAX_INSTANCES > 3
@@ -394,6 +415,13 @@ const AP_Param::GroupInfo RangeFinder::var_info[] = {
     // @Increment: 1
     // @User: Advanced
     AP_GROUPINFO("4_ADDR", 48, RangeFinder, _address[3], 0),
+
+    // @Param: 4_ORIENT
+    // @DisplayName: Fourth range finder orientation
+    // @Description: Direction the fourth range finder is facing. Only downward facing range finders are used for altitude; the others can feed the proximity map
+    // @Values: 0:Forward, 1:Forward-Right, 2:Right, 3:Back-Right, 4:Back, 5:Back-Left, 6:Left, 7:Forward-Left, 24:Up, 25:Down
+    // @User: Advanced
+    AP_GROUPINFO("4_ORIENT", 52, RangeFinder, _orientation[3], ROTATION_PITCH_270),
 #endif
     
     AP_GROUPEND
@@ -457,17 +485,44 @@ void RangeFinder::update(void)
             }
             drivers[i]->update();
             update_pre_arm_check(i);
+
+            // publish the samples queued by the driver
+            RangeFinder_Sample sample;
+            while (drivers[i]->get_sample(sample)) {
+                _sample_topic[i].publish(sample, sample.time_ms * 1000ULL);
+            }
         }
     }
 
-    // work out primary instance - first sensor returning good data
+    // work out primary instance - first downward facing sensor returning good data
     for (int8_t i=num_instances-1; i>=0; i--) {
-        if (drivers[i] != NULL && (state[i].status == RangeFinder_Good)) {
+        if (drivers[i] != NULL && (state[i].status == RangeFinder_Good) &&
+            _orientation[i] == ROTATION_PITCH_270) {
             primary_instance = i;
         }
     }
 }
 
+/*
+  copy out the samples measured after after_ms, oldest first
+ */
+uint8_t RangeFinder::get_samples(uint8_t instance, uint32_t after_ms, RangeFinder_Sample *samples, uint8_t max) const
+{
+    if (instance >= num_instances) {
+        return 0;
+    }
+    SampleTopic::Sample history[RANGEFINDER_SAMPLE_HISTORY];
+    uint32_t since = 0;
+    const uint8_t count = _sample_topic[instance].read_history(history, RANGEFINDER_SAMPLE_HISTORY, since);
+    uint8_t n = 0;
+    for (uint8_t i=0; i<count && n<max; i++) {
+        if ((int32_t)(history[i].data.time_ms - after_ms) > 0) {
+            samples[n++] = history[i].data;
+        }
+    }
+    return n;
+}
+
 void RangeFinder::_add_backend(AP_RangeFinder_Backend *backend)
 {
     if (!backend) {
@@ -493,18 +548,24 @@ void RangeFinder::detect_instance(uint8_t instance)
         type = RangeFinder_TYPE_PX4;
     }
 #endif
+#if AP_RANGEFINDER_PULSEDLIGHT_ENABLED
     if (type == RangeFinder_TYPE_PLI2C) {
         _add_backend(AP_RangeFinder_PulsedLightLRF::detect(*this, instance, state[instance]));
     }
+#endif
+#if AP_RANGEFINDER_MAXSONARI2CXL_ENABLED
     if (type == RangeFinder_TYPE_MBI2C) {
         _add_backend(AP_RangeFinder_MaxsonarI2CXL::detect(*this, instance, state[instance]));
     }
+#endif
+#if AP_RANGEFINDER_LIGHTWAREI2C_ENABLED
     if (type == RangeFinder_TYPE_LWI2C) {
         if (_address[instance]) {
             _add_backend(AP_RangeFinder_LightWareI2C::detect(*this, instance, state[instance],
                 hal.i2c_mgr->get_device(HAL_RANGEFINDER_LIGHTWARE_I2C_BUS, _address[instance])));
         }
     }
+#endif
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4  || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
     if (type == RangeFinder_TYPE_PX4) {
         if (AP_RangeFinder_PX4::detect(*this, instance)) {
@@ -530,6 +591,7 @@ void RangeFinder::detect_instance(uint8_t instance)
         }
     }
 #endif
+#if AP_RANGEFINDER_LIGHTWARESERIAL_ENABLED
     if (type == RangeFinder_TYPE_LWSER) {
         if (AP_RangeFinder_LightWareSerial::detect(*this, instance, serial_manager)) {
             state[instance].instance = instance;
@@ -537,6 +599,8 @@ void RangeFinder::detect_instance(uint8_t instance)
             return;
         }
     }
+#endif
+#if AP_RANGEFINDER_LEDDARONE_ENABLED
     if (type == RangeFinder_TYPE_LEDDARONE) {
         if (AP_RangeFinder_LeddarOne::detect(*this, instance, serial_manager)) {
             state[instance].instance = instance;
@@ -544,6 +608,7 @@ void RangeFinder::detect_instance(uint8_t instance)
             return;
         }
     }
+#endif
 #if (CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BEBOP || \
      CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_DISCO) && defined(HAVE_LIBIIO)
     if (type == RangeFinder_TYPE_BEBOP) {
@@ -554,6 +619,7 @@ void RangeFinder::detect_instance(uint8_t instance)
         }
     }
 #endif
+#if AP_RANGEFINDER_MAVLINK_ENABLED
     if (type == RangeFinder_TYPE_MAVLink) {
         if (AP_RangeFinder_MAVLink::detect(*this, instance)) {
             state[instance].instance = instance;
@@ -561,6 +627,8 @@ void RangeFinder::detect_instance(uint8_t instance)
             return;
         }
     }
+#endif
+#if AP_RANGEFINDER_ANALOG_ENABLED
     if (type == RangeFinder_TYPE_ANALOG) {
         // note that analog must be the last to be checked, as it will
         // always come back as present if the pin is valid
@@ -570,6 +638,7 @@ void RangeFinder::detect_instance(uint8_t instance)
             return;
         }
     }
+#endif
 }
 
 // query status
@@ -615,7 +684,9 @@ bool RangeFinder::pre_arm_check() const
 {
     for (uint8_t i=0; i<num_instances; i++) {
         // if driver is valid but pre_arm_check is false, return false
-        if ((drivers[i] != NULL) && (_type[i] != RangeFinder_TYPE_NONE) && !state[i].pre_arm_check) {
+        // only sensors measuring altitude can be exercised by lifting the vehicle
+        if ((drivers[i] != NULL) && (_type[i] != RangeFinder_TYPE_NONE) &&
+            _orientation[i] == ROTATION_PITCH_270 && !state[i].pre_arm_check) {
             return false;
         }
     }
@@ -16,15 +16,47 @@
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/SensorTopic.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_SerialManager/AP_SerialManager.h>
 
+/*
+  rangefinder drivers built into the firmware. A board can leave a
+  driver out by defining AP_RANGEFINDER_<DRIVER>_ENABLED to 0
+ */
+#ifndef AP_RANGEFINDER_PULSEDLIGHT_ENABLED
+#define AP_RANGEFINDER_PULSEDLIGHT_ENABLED 1
+#endif
+#ifndef AP_RANGEFINDER_MAXSONARI2CXL_ENABLED
+#define AP_RANGEFINDER_MAXSONARI2CXL_ENABLED 1
+#endif
+#ifndef AP_RANGEFINDER_LIGHTWAREI2C_ENABLED
+#define AP_RANGEFINDER_LIGHTWAREI2C_ENABLED 1
+#endif
+#ifndef AP_RANGEFINDER_LIGHTWARESERIAL_ENABLED
+#define AP_RANGEFINDER_LIGHTWARESERIAL_ENABLED 1
+#endif
+#ifndef AP_RANGEFINDER_LEDDARONE_ENABLED
+#define AP_RANGEFINDER_LEDDARONE_ENABLED 1
+#endif
+#ifndef AP_RANGEFINDER_MAVLINK_ENABLED
+#define AP_RANGEFINDER_MAVLINK_ENABLED 1
+#endif
+#ifndef AP_RANGEFINDER_ANALOG_ENABLED
+#define AP_RANGEFINDER_ANALOG_ENABLED 1
+#endif
+
 // Maximum number of range finder instances available on this platform
 #define RANGEFINDER_MAX_INSTANCES 2
 #define RANGEFINDER_GROUND_CLEARANCE_CM_DEFAULT 10
 #define RANGEFINDER_PREARM_ALT_MAX_CM           200
 #define RANGEFINDER_PREARM_REQUIRED_CHANGE_CM   50
+// timestamped samples kept for each instance
+#define RANGEFINDER_SAMPLE_HISTORY              8
+// backends average the measurements falling in windows of this length
+// into one sample
+#define RANGEFINDER_SAMPLE_PERIOD_MS            20
 
 class AP_RangeFinder_Backend; 
  
@@ -78,6 +110,12 @@ public:
         uint16_t               pre_arm_distance_max;    // max distance captured during pre-arm checks
     };
 
+    // a distance measurement with the time it was taken
+    struct RangeFinder_Sample {
+        uint32_t               time_ms;     // AP_HAL::millis() when measured
+        uint16_t               distance_cm; // distance: in cm
+    };
+
     // parameters for each instance
     AP_Int8  _type[RANGEFINDER_MAX_INSTANCES];
     AP_Int8  _pin[RANGEFINDER_MAX_INSTANCES];
@@ -91,6 +129,7 @@ public:
     AP_Int16 _max_distance_cm[RANGEFINDER_MAX_INSTANCES];
     AP_Int8  _ground_clearance_cm[RANGEFINDER_MAX_INSTANCES];
     AP_Int8  _address[RANGEFINDER_MAX_INSTANCES];
+    AP_Int8  _orientation[RANGEFINDER_MAX_INSTANCES];
     AP_Int16 _powersave_range;
 
     static const struct AP_Param::GroupInfo var_info[];
@@ -146,6 +185,11 @@ public:
         return _ground_clearance_cm[primary_instance];
     }
 
+    // direction the sensor is facing, ROTATION_PITCH_270 for down
+    enum Rotation orientation(uint8_t instance) const {
+        return (instance<num_instances? (enum Rotation)_orientation[instance].get() : ROTATION_NONE);
+    }
+
     // query status
     RangeFinder_Status status(uint8_t instance) const;
     RangeFinder_Status status(void) const {
@@ -181,6 +225,19 @@ public:
      */
     bool pre_arm_check() const;
 
+    /*
+      copy to samples, oldest first, up to max of the samples measured
+      after time after_ms. Only backends measuring faster than update()
+      is called queue samples, so this returns the number copied, zero
+      for the others
+     */
+    uint8_t get_samples(uint8_t instance, uint32_t after_ms, RangeFinder_Sample *samples, uint8_t max) const;
+
+    // the same samples, for readers on other threads. Sized to the
+    // power of two above the history, as one slot is the writer's
+    typedef SensorTopic<RangeFinder_Sample, RANGEFINDER_SAMPLE_HISTORY*2> SampleTopic;
+    const SampleTopic &get_sample_topic(uint8_t instance) const { return _sample_topic[instance]; }
+
 private:
     RangeFinder_State state[RANGEFINDER_MAX_INSTANCES];
     AP_RangeFinder_Backend *drivers[RANGEFINDER_MAX_INSTANCES];
@@ -189,6 +246,9 @@ private:
     float estimated_terrain_height;
     AP_SerialManager &serial_manager;
 
+    // recent samples of each instance
+    SampleTopic _sample_topic[RANGEFINDER_MAX_INSTANCES];
+
     void detect_instance(uint8_t instance);
     void update_instance(uint8_t instance);  
 
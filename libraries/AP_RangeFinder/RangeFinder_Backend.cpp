@@ -24,7 +24,11 @@
 */
 AP_RangeFinder_Backend::AP_RangeFinder_Backend(RangeFinder &_ranger, uint8_t instance, RangeFinder::RangeFinder_State &_state) :
         ranger(_ranger),
-        state(_state) 
+        state(_state),
+        _window_start_ms(0),
+        _window_time_sum(0),
+        _window_distance_sum(0),
+        _window_count(0)
 {
 }
 
@@ -55,3 +59,36 @@ void AP_RangeFinder_Backend::set_status(RangeFinder::RangeFinder_Status status)
         state.range_valid_count = 0;
     }
 }
+
+// queue a measurement, averaging it with the others in its window
+void AP_RangeFinder_Backend::add_sample(uint32_t time_ms, uint16_t distance_cm)
+{
+    if ((int16_t)distance_cm > ranger._max_distance_cm[state.instance] ||
+        (int16_t)distance_cm < ranger._min_distance_cm[state.instance]) {
+        return;
+    }
+
+    if (_window_count > 0 && time_ms - _window_start_ms >= RANGEFINDER_SAMPLE_PERIOD_MS) {
+        // window complete
+        RangeFinder::RangeFinder_Sample sample;
+        sample.time_ms = _window_start_ms + _window_time_sum / _window_count;
+        sample.distance_cm = _window_distance_sum / _window_count;
+        // only the consumer may pop, so drop the sample if the queue
+        // is full rather than forcing it in
+        _samples.push(sample);
+        _window_count = 0;
+    }
+
+    if (_window_count == UINT8_MAX) {
+        // a sensor can't really measure this fast, but don't overflow
+        return;
+    }
+    if (_window_count == 0) {
+        _window_start_ms = time_ms;
+        _window_time_sum = 0;
+        _window_distance_sum = 0;
+    }
+    _window_time_sum += time_ms - _window_start_ms;
+    _window_distance_sum += distance_cm;
+    _window_count++;
+}
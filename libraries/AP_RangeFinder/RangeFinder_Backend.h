@@ -16,6 +16,7 @@
 
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
 #include "RangeFinder.h"
 
 class AP_RangeFinder_Backend
@@ -38,8 +39,22 @@ public:
 
     virtual void handle_msg(mavlink_message_t *msg) { return; }
 
+    // pop the oldest sample queued by add_sample()
+    bool get_sample(RangeFinder::RangeFinder_Sample &sample) {
+        return _samples.pop(sample);
+    }
+
 protected:
 
+    /*
+      queue a distance measured at time_ms, for drivers reading the
+      sensor faster than update() is called. Measurements within
+      RANGEFINDER_SAMPLE_PERIOD_MS of each other are averaged into one
+      sample and those out of range are dropped. May be called from
+      the driver's own thread
+     */
+    void add_sample(uint32_t time_ms, uint16_t distance_cm);
+
     // update status based on distance measurement
     void update_status();
 
@@ -48,4 +63,15 @@ protected:
 
     RangeFinder &ranger;
     RangeFinder::RangeFinder_State &state;
+
+private:
+    // averaged samples waiting for RangeFinder::update()
+    ObjectBuffer<RangeFinder::RangeFinder_Sample> _samples{RANGEFINDER_SAMPLE_HISTORY};
+
+    // measurements of the window being averaged, times relative to
+    // the first one
+    uint32_t _window_start_ms;
+    uint32_t _window_time_sum;
+    uint32_t _window_distance_sum;
+    uint8_t _window_count;
 };
@@ -0,0 +1,81 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_LoopTrace.h"
+
+#include <AP_Math/AP_Math.h>
+
+#include <string.h>
+
+extern const AP_HAL::HAL& hal;
+
+void AP_LoopTrace::init(const char * const names[], uint8_t num_spans)
+{
+    _num_spans = MIN(num_spans, AP_LOOPTRACE_MAX_SPANS);
+    for (uint8_t i=0; i<_num_spans; i++) {
+        _perf[i] = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, names[i]);
+    }
+    memset(&_current, 0, sizeof(_current));
+    _current.start_us = AP_HAL::micros64();
+}
+
+void AP_LoopTrace::begin(uint8_t id)
+{
+    if (id >= _num_spans) {
+        return;
+    }
+    if (_perf[id] != nullptr) {
+        hal.util->perf_begin(_perf[id]);
+    }
+    _span_start_us[id] = AP_HAL::micros();
+}
+
+void AP_LoopTrace::end(uint8_t id)
+{
+    if (id >= _num_spans) {
+        return;
+    }
+    const uint32_t dt = AP_HAL::micros() - _span_start_us[id];
+    _current.span_us[id] = MIN(dt, UINT16_MAX);
+    if (_perf[id] != nullptr) {
+        hal.util->perf_end(_perf[id]);
+    }
+}
+
+void AP_LoopTrace::new_loop(uint32_t loop_us, bool overrun)
+{
+    if (overrun) {
+        if (_ring_count < AP_LOOPTRACE_RING_SIZE) {
+            _current.loop_us = loop_us;
+            _ring[(_ring_head + _ring_count) % AP_LOOPTRACE_RING_SIZE] = _current;
+            _ring_count++;
+        } else {
+            _dropped++;
+        }
+    }
+    memset(_current.span_us, 0, sizeof(_current.span_us));
+    _current.start_us = AP_HAL::micros64();
+}
+
+bool AP_LoopTrace::pop(Frame &frame)
+{
+    if (_ring_count == 0) {
+        return false;
+    }
+    frame = _ring[_ring_head];
+    _ring_head = (_ring_head + 1) % AP_LOOPTRACE_RING_SIZE;
+    _ring_count--;
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+// maximum number of spans traced in each loop
+#define AP_LOOPTRACE_MAX_SPANS  16
+
+// number of overrunning loops held until they are read out
+#define AP_LOOPTRACE_RING_SIZE  4
+
+/*
+  lightweight tracer for the fixed stages of a main loop. Each stage
+  is a span with a small static id. Only the current loop's durations
+  are kept, and loops that overrun are copied into a small ring so the
+  stage that caused them can be logged later from a slower task. When
+  the HAL provides performance counters (perf on PX4, LTTng on Linux)
+  every span is reported through them as well
+ */
+class AP_LoopTrace {
+public:
+    struct Frame {
+        uint64_t start_us;
+        uint32_t loop_us;
+        uint16_t span_us[AP_LOOPTRACE_MAX_SPANS];
+    };
+
+    // names are used for the HAL performance counters and must be
+    // static. Spans with ids from num_spans up are ignored
+    void init(const char * const names[], uint8_t num_spans);
+
+    // mark the start and end of a span in the current loop
+    void begin(uint8_t id);
+    void end(uint8_t id);
+
+    // finish the current loop, which took loop_us, keeping it if it
+    // overran, and start the next
+    void new_loop(uint32_t loop_us, bool overrun);
+
+    // take the oldest kept loop. Returns false if there is none
+    bool pop(Frame &frame);
+
+    // number of overrunning loops lost because the ring was full
+    uint32_t num_dropped() const { return _dropped; }
+
+private:
+    uint8_t _num_spans = 0;
+    AP_HAL::Util::perf_counter_t _perf[AP_LOOPTRACE_MAX_SPANS];
+    uint32_t _span_start_us[AP_LOOPTRACE_MAX_SPANS];
+    Frame _current;
+
+    // written by new_loop() and read by pop(), which must not run
+    // at the same time
+    Frame _ring[AP_LOOPTRACE_RING_SIZE];
+    uint8_t _ring_head = 0;
+    uint8_t _ring_count = 0;
+    uint32_t _dropped = 0;
+};
@@ -21,6 +21,7 @@
 #include "AP_Scheduler.h"
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_Vehicle/AP_Vehicle.h>
 #include <stdio.h>
@@ -31,6 +32,23 @@
 #define SCHEDULER_DEFAULT_LOOP_RATE  50
 #endif
 
+// only vehicles whose main loop follows get_loop_rate_hz() while
+// running can have the loop rate adapted to the load. Copter's main
+// loop rate is fixed at compile time
+#define SCHEDULER_ADAPTIVE_LOOP_RATE (APM_BUILD_TYPE(APM_BUILD_ArduPlane) || APM_BUILD_TYPE(APM_BUILD_APMrover2))
+
+// the loop rate is stepped by this much at the end of an adaptation
+// window, which lasts about a second
+#define SCHEDULER_ADAPT_STEP_HZ         50
+
+// step down when less than this percentage of the loop is spare
+#define SCHEDULER_ADAPT_LOW_PCT         10
+
+// step up when the next rate up would still leave this percentage of
+// the loop spare, for SCHEDULER_ADAPT_GOOD_WINDOWS windows in a row
+#define SCHEDULER_ADAPT_HIGH_PCT        25
+#define SCHEDULER_ADAPT_GOOD_WINDOWS    5
+
 extern const AP_HAL::HAL& hal;
 
 int8_t AP_Scheduler::current_task = -1;
@@ -51,6 +69,29 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("LOOP_RATE",  1, AP_Scheduler, _loop_rate_hz, SCHEDULER_DEFAULT_LOOP_RATE),
 
+    // @Param: EDF
+    // @DisplayName: Earliest deadline first scheduling
+    // @Description: When enabled the tasks that are due in each loop are run in order of how close they are to missing a whole run, rather than in task table order. This stops fast tasks late in the table from being starved by slower tasks earlier in the table.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("EDF",  2, AP_Scheduler, _edf, 0),
+
+    // @Param: WORKER
+    // @DisplayName: Worker thread tasks
+    // @Description: When enabled, non-critical tasks such as logging are run from a separate worker thread on boards which support it. The worker only runs a task while the main loop is idle and the task fits in the remaining loop time, freeing main loop time for the fast tasks. This only takes effect on restart
+    // @Values: 0:Disabled,1:Enabled
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("WORKER",  3, AP_Scheduler, _worker_enable, 0),
+
+    // @Param: LOOP_MIN
+    // @DisplayName: Minimum adaptive main loop rate
+    // @Description: When set above 0 the main loop rate is lowered in 50Hz steps, down to this rate, while the scheduler measures less than 10% spare time in the loop or tasks slip a whole run. It is raised back towards SCHED_LOOP_RATE once the higher rate would leave enough spare time. Controller time steps follow the loop rate. Set to 0 to always run at SCHED_LOOP_RATE. Not used by Copter, whose loop rate is fixed
+    // @Values: 0:Disabled,50:50Hz,100:100Hz,150:150Hz,200:200Hz,250:250Hz,300:300Hz
+    // @Units: Hz
+    // @User: Advanced
+    AP_GROUPINFO("LOOP_MIN",  4, AP_Scheduler, _loop_rate_min, 0),
+
     AP_GROUPEND
 };
 
@@ -75,7 +116,26 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks)
     _num_tasks = num_tasks;
     _last_run = new uint16_t[_num_tasks];
     memset(_last_run, 0, sizeof(_last_run[0]) * _num_tasks);
-    _tick_counter = 0;
+    _task_stats = new TaskStats[_num_tasks];
+    reset_task_stats();
+    _edf_order = new uint8_t[_num_tasks];
+    _edf_slack = new int32_t[_num_tasks];
+
+#if SCHEDULER_ADAPTIVE_LOOP_RATE
+    // the IMU sample period, EKF buffers and controller time steps
+    // were set up for this rate, so never adapt above it
+    _adapt_max_rate_hz = _loop_rate_hz;
+#endif
+
+    if (_worker_enable &&
+        hal.scheduler->register_worker_process(FUNCTOR_BIND_MEMBER(&AP_Scheduler::worker_run, void))) {
+        AP_HAL::Semaphore *sem = hal.util->new_semaphore();
+        // start paused; the main loop opens a window after each run()
+        if (sem != nullptr && sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+            _worker_paused = true;
+            _worker_sem = sem;
+        }
+    }
 }
 
 // one tick has passed
@@ -102,18 +162,26 @@ void AP_Scheduler::run(uint32_t time_available)
         }
     }
     
-    for (uint8_t i=0; i<_num_tasks; i++) {
-        uint16_t dt = _tick_counter - _last_run[i];
-        uint16_t interval_ticks = _loop_rate_hz / _tasks[i].rate_hz;
-        if (interval_ticks < 1) {
-            interval_ticks = 1;
+    const bool use_edf = _edf && _edf_order != nullptr && _edf_slack != nullptr;
+    const uint8_t num_candidates = use_edf ? edf_order_tasks() : _num_tasks;
+
+    for (uint8_t n=0; n<num_candidates; n++) {
+        const uint8_t i = use_edf ? _edf_order[n] : n;
+        if (worker_active() && (_tasks[i].flags & TASK_FLAG_WORKER)) {
+            // run from worker_run()
+            continue;
         }
+        uint16_t dt = _tick_counter - _last_run[i];
+        uint16_t interval_ticks = task_interval_ticks(i);
         if (dt >= interval_ticks) {
             // this task is due to run. Do we have enough time to run it?
             _task_time_allowed = _tasks[i].max_time_micros;
 
             if (dt >= interval_ticks*2) {
                 // we've slipped a whole run of this task!
+                if (_adapt_slips < UINT16_MAX) {
+                    _adapt_slips++;
+                }
                 if (_debug > 1) {
                     ::printf("Scheduler slip task[%u-%s] (%u/%u/%u)\n",
                              (unsigned)i,
@@ -124,7 +192,12 @@ void AP_Scheduler::run(uint32_t time_available)
                 }
             }
 
-            if (_task_time_allowed <= time_available) {
+            if (_task_time_allowed > time_available) {
+                // due, but there is not enough time left in this tick
+                if (_task_stats != nullptr && _task_stats[i].skipped < UINT16_MAX) {
+                    _task_stats[i].skipped++;
+                }
+            } else {
                 // run it
                 _task_time_started = now;
                 current_task = i;
@@ -145,6 +218,8 @@ void AP_Scheduler::run(uint32_t time_available)
                 now = AP_HAL::micros();
                 uint32_t time_taken = now - _task_time_started;
 
+                update_task_stats(i, time_taken);
+
                 if (time_taken > _task_time_allowed) {
                     // the event overran!
                     if (_debug > 4) {
@@ -156,7 +231,8 @@ void AP_Scheduler::run(uint32_t time_available)
                     }
                 }
                 if (time_taken >= time_available) {
-                    goto update_spare_ticks;
+                    time_available = 0;
+                    break;
                 }
                 time_available -= time_taken;
             }
@@ -166,12 +242,278 @@ void AP_Scheduler::run(uint32_t time_available)
     // update number of spare microseconds
     _spare_micros += time_available;
 
-update_spare_ticks:
     _spare_ticks++;
     if (_spare_ticks == 32) {
         _spare_ticks /= 2;
         _spare_micros /= 2;
     }
+
+    adapt_loop_rate(time_available);
+}
+
+/*
+  adapt the main loop rate to the load. Spare time is measured over a
+  window of about a second. The rate steps down when little time is
+  spare or tasks slip a whole run, and steps up only once the time
+  used per loop would still leave plenty spare at the higher rate, so
+  it does not oscillate between two rates. The vehicle picks the new
+  rate up from get_loop_rate_hz() before its next loop
+ */
+void AP_Scheduler::adapt_loop_rate(uint32_t spare_micros)
+{
+#if SCHEDULER_ADAPTIVE_LOOP_RATE
+    const uint16_t max_rate = _adapt_max_rate_hz;
+    const uint16_t min_rate = constrain_int16(_loop_rate_min, 50, max_rate);
+    if (_loop_rate_min <= 0 || min_rate >= max_rate) {
+        if (_active_loop_rate_hz != 0) {
+            // adaptation turned off, go back to the rate we started at
+            _active_loop_rate_hz = max_rate;
+            _adapt_ticks = 0;
+        }
+        return;
+    }
+
+    const uint16_t rate = get_loop_rate_hz();
+    _adapt_spare_micros += spare_micros;
+    _adapt_ticks++;
+    if (_adapt_ticks < rate) {
+        return;
+    }
+
+    // time in one loop and the part of it used by the vehicle
+    const uint32_t loop_us = 1000000UL / rate;
+    const uint32_t spare_us = MIN(_adapt_spare_micros / _adapt_ticks, loop_us);
+    const uint32_t used_us = loop_us - spare_us;
+
+    uint16_t new_rate = constrain_int16(rate, min_rate, max_rate);
+    if (spare_us * 100 < loop_us * SCHEDULER_ADAPT_LOW_PCT || _adapt_slips > 0) {
+        _adapt_good_windows = 0;
+        new_rate = MAX(rate - SCHEDULER_ADAPT_STEP_HZ, min_rate);
+    } else if (rate < max_rate) {
+        const uint16_t up_rate = MIN(rate + SCHEDULER_ADAPT_STEP_HZ, max_rate);
+        const uint32_t up_loop_us = 1000000UL / up_rate;
+        if (used_us * 100 < up_loop_us * (100 - SCHEDULER_ADAPT_HIGH_PCT)) {
+            if (++_adapt_good_windows >= SCHEDULER_ADAPT_GOOD_WINDOWS) {
+                _adapt_good_windows = 0;
+                new_rate = up_rate;
+            }
+        } else {
+            _adapt_good_windows = 0;
+        }
+    }
+
+    if (new_rate != rate && _debug > 1) {
+        ::printf("Scheduler loop rate %u -> %uHz (spare %u/%u)\n",
+                 (unsigned)rate, (unsigned)new_rate,
+                 (unsigned)spare_us, (unsigned)loop_us);
+    }
+    _active_loop_rate_hz = new_rate;
+    _adapt_spare_micros = 0;
+    _adapt_ticks = 0;
+    _adapt_slips = 0;
+#endif
+}
+
+/*
+  stop worker tasks from running
+ */
+void AP_Scheduler::worker_pause(void)
+{
+    if (_worker_sem == nullptr || _worker_paused) {
+        return;
+    }
+    // blocks only if a worker task overran its window
+    if (!_worker_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+    _worker_paused = true;
+}
+
+/*
+  open a window of time_available microseconds for worker tasks
+ */
+void AP_Scheduler::worker_resume(uint32_t time_available)
+{
+    if (_worker_sem == nullptr || !_worker_paused) {
+        return;
+    }
+    _worker_deadline_usec = AP_HAL::micros() + time_available;
+    _worker_paused = false;
+    _worker_sem->give();
+}
+
+/*
+  run the worker tasks which are due, as long as each fits in the
+  window left by the main loop. Called from the HAL worker thread
+ */
+void AP_Scheduler::worker_run(void)
+{
+    if (_worker_sem == nullptr) {
+        return;
+    }
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        if (!(_tasks[i].flags & TASK_FLAG_WORKER)) {
+            continue;
+        }
+        const uint16_t tick_counter = _tick_counter;
+        const uint16_t dt = tick_counter - _last_run[i];
+        if (dt < task_interval_ticks(i)) {
+            continue;
+        }
+        if (!_worker_sem->take_nonblocking()) {
+            // main loop is running
+            return;
+        }
+        const uint32_t start = AP_HAL::micros();
+        if ((int32_t)(_worker_deadline_usec - start) < (int32_t)_tasks[i].max_time_micros) {
+            // not enough time left before the next main loop
+            _worker_sem->give();
+            return;
+        }
+        _tasks[i].function();
+        _last_run[i] = tick_counter;
+        update_task_stats(i, AP_HAL::micros() - start);
+        _worker_sem->give();
+    }
+}
+
+/*
+  return the number of ticks between runs of a task
+ */
+uint16_t AP_Scheduler::task_interval_ticks(uint8_t i) const
+{
+    uint16_t interval_ticks = get_loop_rate_hz() / _tasks[i].rate_hz;
+    if (interval_ticks < 1) {
+        interval_ticks = 1;
+    }
+    if (_shed_divisor > 1 && (_tasks[i].flags & TASK_FLAG_SHED)) {
+        interval_ticks = MIN((uint32_t)interval_ticks * _shed_divisor, UINT16_MAX/2);
+    }
+    return interval_ticks;
+}
+
+/*
+  fill _edf_order with the tasks which are due to run, most urgent
+  first. A task's deadline is the tick at which it would slip a whole
+  run, so the slack is the number of ticks left until then. Faster
+  tasks have less slack and so naturally come first; ties keep task
+  table order. Returns the number of due tasks
+ */
+uint8_t AP_Scheduler::edf_order_tasks(void)
+{
+    uint8_t num_due = 0;
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const uint16_t dt = _tick_counter - _last_run[i];
+        const uint16_t interval_ticks = task_interval_ticks(i);
+        if (dt < interval_ticks) {
+            continue;
+        }
+        const int32_t slack = 2*(int32_t)interval_ticks - (int32_t)dt;
+        // insertion sort keeps equal slack in table order
+        uint8_t n = num_due;
+        while (n > 0 && _edf_slack[n-1] > slack) {
+            _edf_order[n] = _edf_order[n-1];
+            _edf_slack[n] = _edf_slack[n-1];
+            n--;
+        }
+        _edf_order[n] = i;
+        _edf_slack[n] = slack;
+        num_due++;
+    }
+    return num_due;
+}
+
+/*
+  record the time taken by one run of a task into its histogram
+ */
+void AP_Scheduler::update_task_stats(uint8_t i, uint32_t time_taken)
+{
+    if (_task_stats == nullptr) {
+        return;
+    }
+    TaskStats &stats = _task_stats[i];
+    const uint16_t time_us = MIN(time_taken, (uint32_t)UINT16_MAX);
+
+    uint32_t bucket_width = _tasks[i].max_time_micros / AP_SCHEDULER_HIST_BUCKETS_PER_BUDGET;
+    if (bucket_width < 1) {
+        bucket_width = 1;
+    }
+    const uint8_t bucket = MIN(time_taken / bucket_width, (uint32_t)(AP_SCHEDULER_HIST_BUCKETS-1));
+
+    if (stats.hist[bucket] == UINT16_MAX) {
+        // age the histogram rather than saturate it
+        for (uint8_t b=0; b<AP_SCHEDULER_HIST_BUCKETS; b++) {
+            stats.hist[b] /= 2;
+        }
+    }
+    stats.hist[bucket]++;
+
+    if (stats.num_runs == 0 || time_us < stats.min_time_us) {
+        stats.min_time_us = time_us;
+    }
+    if (time_us > stats.max_time_us) {
+        stats.max_time_us = time_us;
+    }
+    if (stats.num_runs < UINT16_MAX) {
+        stats.num_runs++;
+    }
+    if (time_taken > _tasks[i].max_time_micros && stats.overruns < UINT16_MAX) {
+        stats.overruns++;
+    }
+}
+
+/*
+  return timing statistics for a task
+ */
+const AP_Scheduler::TaskStats *AP_Scheduler::task_stats(uint8_t i) const
+{
+    if (_task_stats == nullptr || i >= _num_tasks) {
+        return nullptr;
+    }
+    return &_task_stats[i];
+}
+
+/*
+  estimate a percentile of a task's run time. The result is the upper
+  edge of the histogram bucket containing the percentile, clamped to
+  the observed maximum
+ */
+uint16_t AP_Scheduler::task_percentile_us(uint8_t i, uint8_t percentile) const
+{
+    const TaskStats *stats = task_stats(i);
+    if (stats == nullptr) {
+        return 0;
+    }
+    uint32_t total = 0;
+    for (uint8_t b=0; b<AP_SCHEDULER_HIST_BUCKETS; b++) {
+        total += stats->hist[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint32_t bucket_width = _tasks[i].max_time_micros / AP_SCHEDULER_HIST_BUCKETS_PER_BUDGET;
+    if (bucket_width < 1) {
+        bucket_width = 1;
+    }
+    const uint32_t threshold = (total * MIN(percentile, 100U) + 99) / 100;
+    uint32_t count = 0;
+    for (uint8_t b=0; b<AP_SCHEDULER_HIST_BUCKETS-1; b++) {
+        count += stats->hist[b];
+        if (count >= threshold) {
+            return MIN((b+1) * bucket_width, (uint32_t)stats->max_time_us);
+        }
+    }
+    return stats->max_time_us;
+}
+
+/*
+  clear the timing statistics of all tasks
+ */
+void AP_Scheduler::reset_task_stats(void)
+{
+    if (_task_stats != nullptr) {
+        memset(_task_stats, 0, sizeof(_task_stats[0]) * _num_tasks);
+    }
 }
 
 /*
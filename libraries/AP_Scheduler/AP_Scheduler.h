@@ -25,6 +25,13 @@
 
 #define AP_SCHEDULER_NAME_INITIALIZER(_name) .name = #_name,
 
+// number of buckets in the per-task execution time histogram. Each
+// bucket covers 1/AP_SCHEDULER_HIST_BUCKETS_PER_BUDGET of the task's
+// max_time_micros, so the histogram spans twice the budget and the
+// last bucket collects everything beyond that.
+#define AP_SCHEDULER_HIST_BUCKETS 16
+#define AP_SCHEDULER_HIST_BUCKETS_PER_BUDGET 8
+
 /*
   useful macro for creating scheduler task table
  */
@@ -35,6 +42,30 @@
     .max_time_micros = _max_time_micros\
 }
 
+/*
+  as SCHED_TASK_CLASS, but for a non-critical task which may be run
+  from the HAL worker thread when SCHED_WORKER is enabled
+ */
+#define SCHED_TASK_CLASS_WORKER(classname, classptr, func, _rate_hz, _max_time_micros) { \
+    .function = FUNCTOR_BIND(classptr, &classname::func, void),\
+    AP_SCHEDULER_NAME_INITIALIZER(func)\
+    .rate_hz = _rate_hz,\
+    .max_time_micros = _max_time_micros,\
+    .flags = AP_Scheduler::TASK_FLAG_WORKER\
+}
+
+/*
+  as SCHED_TASK_CLASS, but for a non-essential task which is run less
+  often while the vehicle asks the scheduler to shed load
+ */
+#define SCHED_TASK_CLASS_SHED(classname, classptr, func, _rate_hz, _max_time_micros) { \
+    .function = FUNCTOR_BIND(classptr, &classname::func, void),\
+    AP_SCHEDULER_NAME_INITIALIZER(func)\
+    .rate_hz = _rate_hz,\
+    .max_time_micros = _max_time_micros,\
+    .flags = AP_Scheduler::TASK_FLAG_SHED\
+}
+
 /*
   A task scheduler for APM main loops
 
@@ -56,11 +87,19 @@ public:
     
     FUNCTOR_TYPEDEF(task_fn_t, void);
 
+    enum TaskFlags {
+        // task may run on the worker thread
+        TASK_FLAG_WORKER = (1U<<0),
+        // task is slowed down while shedding load
+        TASK_FLAG_SHED = (1U<<1),
+    };
+
     struct Task {
         task_fn_t function;
         const char *name;
         float rate_hz;
         uint16_t max_time_micros;
+        uint8_t flags;
     };
 
     // initialise scheduler
@@ -77,6 +116,26 @@ public:
     // return the number of microseconds available for the current task
     uint16_t time_available_usec(void);
 
+    // stop worker tasks from running. The main loop calls this before
+    // touching the vehicle state, and the worker thread never runs a
+    // task while it is paused
+    void worker_pause(void);
+
+    // let worker tasks run until the given number of microseconds
+    // from now, normally the start of the next main loop
+    void worker_resume(uint32_t time_available);
+
+    // true if worker tasks are being run by the worker thread
+    bool worker_active(void) const { return _worker_sem != nullptr; }
+
+    // run tasks flagged TASK_FLAG_SHED at 1/divisor of their normal
+    // rate, for vehicles to call while their controllers need the
+    // time. A divisor of 0 or 1 runs them normally
+    void set_shed_divisor(uint8_t divisor) { _shed_divisor = divisor; }
+
+    // true if tasks are being shed
+    bool shedding(void) const { return _shed_divisor > 1; }
+
     // return debug parameter
     uint8_t debug(void) { return _debug; }
 
@@ -85,9 +144,10 @@ public:
     // end of a run()
     float load_average(uint32_t tick_time_usec) const;
 
-    // get the configured main loop rate
+    // get the main loop rate. This is the configured rate unless
+    // SCHED_LOOP_MIN lets the scheduler lower it under load
     uint16_t get_loop_rate_hz(void) const {
-        return _loop_rate_hz;
+        return _active_loop_rate_hz != 0 ? _active_loop_rate_hz : (uint16_t)_loop_rate_hz.get();
     }
     
     static const struct AP_Param::GroupInfo var_info[];
@@ -95,12 +155,73 @@ public:
     // current running task, or -1 if none. Used to debug stuck tasks
     static int8_t current_task;
 
+    /*
+      execution time statistics for one task, gathered since the last
+      call to reset_task_stats()
+     */
+    struct TaskStats {
+        uint16_t hist[AP_SCHEDULER_HIST_BUCKETS];
+        uint16_t num_runs;
+        uint16_t min_time_us;
+        uint16_t max_time_us;
+        uint16_t overruns;
+        uint16_t skipped;
+    };
+
+    // number of tasks in the task table
+    uint8_t get_num_tasks(void) const { return _num_tasks; }
+
+    // name of a task in the task table
+    const char *task_name(uint8_t i) const { return _tasks[i].name; }
+
+    // time budget of a task in the task table
+    uint16_t task_budget_us(uint8_t i) const { return _tasks[i].max_time_micros; }
+
+    // timing statistics for a task, or nullptr if not available
+    const TaskStats *task_stats(uint8_t i) const;
+
+    // estimate the given percentile (0 to 100) of a task's run time
+    // in microseconds from its histogram
+    uint16_t task_percentile_us(uint8_t i, uint8_t percentile) const;
+
+    // clear the timing statistics of all tasks
+    void reset_task_stats(void);
+
 private:
     // used to enable scheduler debugging
     AP_Int8 _debug;
 
+    // run due tasks in earliest deadline first order
+    AP_Int8 _edf;
+
+    // run worker tasks on the HAL worker thread
+    AP_Int8 _worker_enable;
+
     // overall scheduling rate in Hz
     AP_Int16 _loop_rate_hz;  // The value of this variable can be changed with the non-initialization. (Ex. Tuning by GDB)
+
+    // lowest rate the main loop may be stepped down to under load, or
+    // 0 to always run at _loop_rate_hz
+    AP_Int16 _loop_rate_min;
+
+    // main loop rate while adapting to load, 0 until the first window
+    uint16_t _active_loop_rate_hz;
+
+    // _loop_rate_hz at init(), the highest rate adaptation may use
+    uint16_t _adapt_max_rate_hz;
+
+    // spare time, ticks and slipped task runs over the current
+    // adaptation window
+    uint32_t _adapt_spare_micros;
+    uint16_t _adapt_ticks;
+    uint16_t _adapt_slips;
+
+    // number of windows in a row with room for a higher rate
+    uint8_t _adapt_good_windows;
+
+    // step the main loop rate between _loop_rate_min and
+    // _loop_rate_hz based on the spare time in each window
+    void adapt_loop_rate(uint32_t spare_micros);
     
     // progmem list of tasks to run
     const struct Task *_tasks;
@@ -127,6 +248,39 @@ private:
     // number of ticks that _spare_micros is counted over
     uint8_t _spare_ticks;
 
+    // per-task execution time statistics, allocated alongside _last_run
+    TaskStats *_task_stats;
+
     // performance counters
     AP_HAL::Util::perf_counter_t *_perf_counters;
+
+    // task indexes and their slack in ticks, sorted most urgent
+    // first, for earliest deadline first scheduling
+    uint8_t *_edf_order;
+    int32_t *_edf_slack;
+
+    // record the time taken by one run of a task
+    void update_task_stats(uint8_t i, uint32_t time_taken);
+
+    // number of ticks between runs of a task
+    uint16_t task_interval_ticks(uint8_t i) const;
+
+    // sort the due tasks by deadline into _edf_order
+    uint8_t edf_order_tasks(void);
+
+    // held by the main loop while worker tasks must not run. nullptr
+    // when worker tasks are run from the main loop
+    AP_HAL::Semaphore *_worker_sem;
+
+    // end of the current worker time window
+    volatile uint32_t _worker_deadline_usec;
+
+    // true if the main loop holds _worker_sem
+    bool _worker_paused;
+
+    // rate divisor for TASK_FLAG_SHED tasks
+    uint8_t _shed_divisor;
+
+    // called regularly from the HAL worker thread
+    void worker_run(void);
 };
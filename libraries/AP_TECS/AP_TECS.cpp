@@ -291,10 +291,10 @@ void AP_TECS::update_50hz(void)
     _update_50hz_last_usec = now;
 
     // Use inertial nav verical velocity and height if available
-    Vector3f velned;
-    if (_ahrs.get_velocity_NED(velned)) {
+    const AP_AHRS::nav_context &nav = _ahrs.get_nav_context();
+    if (nav.have_velocity_ned) {
         // if possible use the EKF vertical velocity
-        _climb_rate = -velned.z;
+        _climb_rate = -nav.velocity_ned.z;
     } else {
         /*
           use a complimentary filter to calculate climb_rate. This is
@@ -344,7 +344,7 @@ void AP_TECS::_update_speed(float load_factor)
 
     // Convert equivalent airspeeds to true airspeeds
 
-    float EAS2TAS = _ahrs.get_EAS2TAS();
+    float EAS2TAS = _ahrs.get_nav_context().EAS2TAS;
     _TAS_dem = _EAS_dem * EAS2TAS;
     _TASmax   = aparm.airspeed_max * EAS2TAS;
     _TASmin   = aparm.airspeed_min * EAS2TAS;
@@ -15,6 +15,7 @@
 
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/AP_Alloc.h>
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <GCS_MAVLink/GCS.h>
@@ -48,6 +49,22 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Increment: 1
     AP_GROUPINFO("SPACING",   1, AP_Terrain, grid_spacing, 100),
 
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: Number of terrain grid blocks to keep in memory. Each block takes about 1.8 kilobytes. A larger cache lets fast aircraft hold more of the terrain ahead of them, which is loaded from the SD card as the mission progresses.
+    // @Range: 4 128
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  2, AP_Terrain, cache_blocks, TERRAIN_GRID_BLOCK_CACHE_SIZE),
+
+    // @Param: FORMAT
+    // @DisplayName: Terrain file format
+    // @Description: Format of the terrain data stored on the SD card. The compressed format stores each grid block in half the space, so reading it is faster and more of an area fits on the card. Existing uncompressed data is still used, and is converted to the compressed format as it is loaded. Older firmware only reads the uncompressed format.
+    // @Values: 1:Uncompressed,2:Compressed
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("FORMAT",    3, AP_Terrain, format, TERRAIN_GRID_FORMAT_VERSION),
+
     AP_GROUPEND
 };
 
@@ -57,7 +74,11 @@ AP_Terrain::AP_Terrain(AP_AHRS &_ahrs, const AP_Mission &_mission, const AP_Rall
     mission(_mission),
     rally(_rally),
     disk_io_state(DiskIoIdle),
+    disk_batch_count(0),
+    file_format(TERRAIN_GRID_FORMAT_VERSION),
+    compact_io(nullptr),
     fd(-1),
+    fd_compact(-1),
     timer_setup(false),
     file_lat_degrees(0),
     file_lon_degrees(0),
@@ -69,7 +90,9 @@ AP_Terrain::AP_Terrain(AP_AHRS &_ahrs, const AP_Mission &_mission, const AP_Rall
 {
     AP_Param::setup_object_defaults(this, var_info);
     memset(&home_loc, 0, sizeof(home_loc));
-    memset(&disk_block, 0, sizeof(disk_block));
+    memset(disk_blocks, 0, sizeof(disk_blocks));
+    memset(disk_convert, 0, sizeof(disk_convert));
+    memset(cache_index, TERRAIN_CACHE_INDEX_EMPTY, sizeof(cache_index));
     memset(last_request_time_ms, 0, sizeof(last_request_time_ms));
 }
 
@@ -106,6 +129,38 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     // find the grid
     const struct grid_block &grid = find_grid_cache(info).grid;
 
+    if (!interpolate_height(grid, info, height)) {
+        return false;
+    }
+
+    if (loc.lat == ahrs.get_home().lat &&
+        loc.lng == ahrs.get_home().lng) {
+        // remember home altitude as a special case
+        home_height = height;
+        home_loc = loc;
+    }
+
+    // apply correction which assumes home altitude is at terrain altitude
+    if (corrected) {
+        height += home_correction();
+    }
+
+    return true;
+}
+
+/*
+  height correction which assumes home altitude is at terrain altitude
+ */
+float AP_Terrain::home_correction(void) const
+{
+    return (ahrs.get_home().alt * 0.01f) - home_height;
+}
+
+/*
+  interpolate the terrain height within a grid block
+ */
+bool AP_Terrain::interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height)
+{
     /*
       note that we rely on the one square overlap to ensure these
       calculations don't go past the end of the arrays
@@ -139,21 +194,89 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
 
     height = avg;
 
-    if (loc.lat == ahrs.get_home().lat &&
-        loc.lng == ahrs.get_home().lng) {
-        // remember home altitude as a special case
-        home_height = height;
-        home_loc = loc;
-    }
+    return true;
+}
 
-    // apply correction which assumes home altitude is at terrain altitude
-    if (corrected) {
-        height += (ahrs.get_home().alt * 0.01f) - home_height;
+/*
+  return terrain heights for an array of locations. Points along a
+  path mostly fall in the same grid block as the point before, so the
+  grid found for one point is reused for the next one while it
+  matches, saving the cache lookup
+ */
+bool AP_Terrain::height_amsl_batch(const Location *locs, float *heights, uint16_t count, bool corrected)
+{
+    if (!enable || !allocate()) {
+        return false;
     }
 
+    const struct grid_block *grid = nullptr;
+    const float correction = corrected ? home_correction() : 0;
+
+    for (uint16_t i=0; i<count; i++) {
+        const Location &loc = locs[i];
+        if (loc.lat == home_loc.lat &&
+            loc.lng == home_loc.lng) {
+            heights[i] = home_height + correction;
+            continue;
+        }
+
+        struct grid_info info;
+        calculate_grid_info(loc, info);
+
+        if (grid == nullptr ||
+            grid->lat != info.grid_lat ||
+            grid->lon != info.grid_lon ||
+            grid->spacing != grid_spacing) {
+            grid = &find_grid_cache(info).grid;
+        }
+        if (!interpolate_height(*grid, info, heights[i])) {
+            return false;
+        }
+        heights[i] += correction;
+    }
     return true;
 }
 
+/*
+  find the highest terrain along a straight path. The path is sampled
+  in chunks so the stack use stays bounded on long legs
+ */
+bool AP_Terrain::max_height_along_path(const Location &from, const Location &to, float step_m, float &max_height)
+{
+    if (!enable || grid_spacing <= 0) {
+        return false;
+    }
+    if (step_m <= 0) {
+        step_m = grid_spacing;
+    }
+    const float dist = get_distance(from, to);
+    const float bearing = get_bearing_cd(from, to) * 0.01f;
+    const uint32_t npoints = (uint32_t)(dist / step_m) + 2;
+
+    const uint8_t chunk = 16;
+    Location locs[chunk];
+    float heights[chunk];
+    bool found = false;
+
+    for (uint32_t i=0; i<npoints; i += chunk) {
+        const uint8_t n = MIN(npoints - i, chunk);
+        for (uint8_t j=0; j<n; j++) {
+            locs[j] = from;
+            location_update(locs[j], bearing, MIN((i+j)*step_m, dist));
+        }
+        if (!height_amsl_batch(locs, heights, n, false)) {
+            return false;
+        }
+        for (uint8_t j=0; j<n; j++) {
+            if (!found || heights[j] > max_height) {
+                max_height = heights[j];
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
 
 /* 
    find difference between home terrain height and the terrain
@@ -326,6 +449,11 @@ void AP_Terrain::update(void)
     // check for pending rally data
     update_rally_data();
 
+    // load grids ahead of us on the mission
+    if (pos_valid) {
+        update_lookahead(loc);
+    }
+
     // update capabilities and status
     if (enable) {
         hal.util->set_capabilities(MAV_PROTOCOL_CAPABILITY_TERRAIN);
@@ -393,13 +521,23 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
+    const uint8_t size = constrain_int16(cache_blocks, 4, TERRAIN_GRID_BLOCK_CACHE_MAX);
+    AP_Alloc::Tag alloc_tag("Terrain");
+    cache = new grid_cache[size];
     if (cache == nullptr) {
         enable.set(0);
         GCS_MAVLINK::send_statustext_all(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    cache_size = size;
+    memset(cache_index, TERRAIN_CACHE_INDEX_EMPTY, sizeof(cache_index));
+
+    if (format == TERRAIN_GRID_FORMAT_VERSION_COMPACT) {
+        compact_io = new grid_compact_block;
+        if (compact_io != nullptr) {
+            file_format = TERRAIN_GRID_FORMAT_VERSION_COMPACT;
+        }
+    }
     return true;
 }
 
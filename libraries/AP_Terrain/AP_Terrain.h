@@ -52,12 +52,36 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default number of grid_blocks in the LRU memory cache
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 
+// largest allowed cache. The hash index holds twice this many slots
+#define TERRAIN_GRID_BLOCK_CACHE_MAX 128
+#define TERRAIN_CACHE_INDEX_SIZE (2*TERRAIN_GRID_BLOCK_CACHE_MAX)
+#define TERRAIN_CACHE_INDEX_EMPTY 0xFF
+
+// number of blocks read or written in one pass of the IO thread. Each
+// slot costs a 2k IO buffer
+#ifndef TERRAIN_IO_BATCH_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define TERRAIN_IO_BATCH_SIZE 8
+#else
+#define TERRAIN_IO_BATCH_SIZE 1
+#endif
+#endif
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
+// compressed format, in 1k slots of a .DTZ file for each degree. A
+// block whose heights don't compress into a slot stays in the .DAT
+// file, and its slot is marked TERRAIN_COMPACT_FLAG_OVERFLOW
+#define TERRAIN_GRID_FORMAT_VERSION_COMPACT 2
+#define TERRAIN_COMPACT_SLOT_SIZE 1024
+#define TERRAIN_COMPACT_HEADER_SIZE 34
+#define TERRAIN_COMPACT_DATA_SIZE (TERRAIN_COMPACT_SLOT_SIZE-TERRAIN_COMPACT_HEADER_SIZE)
+#define TERRAIN_COMPACT_FLAG_OVERFLOW 1
+
 #if TERRAIN_DEBUG
 #define ASSERT_RANGE(v,minv,maxv) assert((v)<=(maxv)&&(v)>=(minv))
 #else
@@ -113,6 +137,25 @@ public:
      */
     bool height_amsl(const Location &loc, float &height, bool corrected);
 
+    /*
+      find the terrain height in meters above sea level for an array
+      of locations, such as points along a path. Consecutive points in
+      the same grid block share one cache lookup.
+
+      return false if any height is not available. Heights are filled
+      in up to the first missing point
+     */
+    bool height_amsl_batch(const Location *locs, float *heights, uint16_t count, bool corrected);
+
+    /*
+      find the highest terrain in meters above sea level along the
+      straight line between two locations, sampled every step_m
+      meters (grid spacing if zero)
+
+      return false if terrain is not available along the whole path
+     */
+    bool max_height_along_path(const Location &from, const Location &to, float step_m, float &max_height);
+
     /* 
        find difference between home terrain height and the terrain
        height at the current location in meters. A positive result
@@ -220,6 +263,40 @@ private:
         uint8_t buffer[2048];
     };
 
+    /*
+      a grid_block in the compressed format. Each height is predicted
+      from its north, east and north-east neighbours, and the
+      residuals are zigzag coded and bit packed a row at a time: one
+      byte giving the bit width of the row, then 32 residuals of that
+      width
+     */
+    struct PACKED grid_compact_block {
+        uint64_t bitmap;
+        int32_t lat;
+        int32_t lon;
+
+        // crc of the uncompressed grid_block
+        uint16_t crc;
+
+        // TERRAIN_GRID_FORMAT_VERSION_COMPACT
+        uint16_t version;
+
+        uint16_t spacing;
+        uint16_t grid_idx_x;
+        uint16_t grid_idx_y;
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+
+        // TERRAIN_COMPACT_FLAG_*
+        uint8_t flags;
+
+        // height of the first grid point, and bytes used in data[]
+        int16_t base;
+        uint16_t length;
+
+        uint8_t data[TERRAIN_COMPACT_DATA_SIZE];
+    };
+
     enum GridCacheState {
         GRID_CACHE_INVALID=0,    // when first initialised
         GRID_CACHE_DISKWAIT=1,   // when waiting for disk read
@@ -236,8 +313,8 @@ private:
 
         volatile enum GridCacheState state;
 
-        // the last time access was requested to this block, used for LRU
-        uint32_t last_access_ms;
+        // value of access_counter when this block was last used, for LRU
+        uint32_t last_access;
     };
 
     /*
@@ -277,6 +354,24 @@ private:
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      interpolate the height at a grid_info within its grid block
+     */
+    bool interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height);
+
+    /*
+      height correction to apply when corrected heights are wanted
+     */
+    float home_correction(void) const;
+
+    /*
+      hash index of the cache, keyed on grid lat/lon/spacing
+     */
+    static uint8_t cache_hash(int32_t lat, int32_t lon, uint16_t spacing);
+    int16_t cache_lookup(int32_t lat, int32_t lon, uint16_t spacing) const;
+    void cache_index_add(uint8_t idx);
+    void cache_index_remove(uint8_t idx);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -295,6 +390,13 @@ private:
     bool request_missing(mavlink_channel_t chan, struct grid_cache &gcache);
     bool request_missing(mavlink_channel_t chan, const struct grid_info &info);
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    /*
+      fill missing 4x4 grids from the simulator's SRTM cache
+     */
+    bool fill_from_simulator(struct grid_cache &gcache);
+#endif
+
     /*
       look for blocks that need to be read/written to disk
      */
@@ -308,15 +410,28 @@ private:
     /*
       disk IO functions
      */
-    int16_t find_io_idx(enum GridCacheState state);
+    int16_t find_io_idx(const struct grid_block &block, enum GridCacheState state);
     uint16_t get_block_crc(struct grid_block &block);
+    void collect_disk_io(enum GridCacheState state);
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
     void open_file(void);
-    void seek_offset(void);
-    void write_block(void);
-    void read_block(void);
+    int open_degree_file(const char *ext, int flags);
+    uint32_t block_file_offset(const struct grid_block &block) const;
+    bool seek_offset(int &file_fd, uint32_t file_offset);
+    ssize_t read_at(int &file_fd, void *buf, uint16_t len, uint32_t file_offset);
+    bool write_at(int &file_fd, const void *buf, uint16_t len, uint32_t file_offset);
+    void write_block(union grid_io_block &disk_block, uint32_t file_offset);
+    bool read_block(union grid_io_block &disk_block, uint32_t file_offset);
+
+    /*
+      compressed format, see grid_compact_block
+     */
+    static bool compress_block(const struct grid_block &block, struct grid_compact_block &compact);
+    static bool decompress_block(const struct grid_compact_block &compact, struct grid_block &block);
+    static void compact_header(const struct grid_block &block, struct grid_compact_block &compact);
+    static int32_t predict_height(const struct grid_block &block, uint8_t x, uint8_t y, int16_t base);
 
     /*
       check for missing mission terrain data
@@ -328,10 +443,18 @@ private:
      */
     void update_rally_data(void);
 
+    /*
+      load grids along the mission ahead of the vehicle
+     */
+    void update_lookahead(const Location &loc);
+    uint8_t lookahead_leg(const Location &from, const Location &to, uint8_t steps);
+
 
     // parameters
     AP_Int8  enable;
     AP_Int16 grid_spacing; // meters between grid points
+    AP_Int16 cache_blocks; // number of grid blocks to keep in memory
+    AP_Int8  format;       // TERRAIN_GRID_FORMAT_VERSION* of new files
 
     // reference to AHRS, so we can ask for our position,
     // heading and speed
@@ -349,7 +472,18 @@ private:
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
-    // a grid_cache block waiting for disk IO
+    // open-addressed hash index from grid to cache slot, using
+    // linear probing
+    uint8_t cache_index[TERRAIN_CACHE_INDEX_SIZE];
+
+    // incremented on each cache access, for LRU replacement
+    uint32_t access_counter;
+
+    // last time we prefetched along the mission
+    uint32_t last_lookahead_ms;
+
+    // a batch of grid_cache blocks waiting for disk IO. All blocks in
+    // a batch are in the same degree file and sorted by file offset
     enum DiskIoState {
         DiskIoIdle      = 0,
         DiskIoWaitWrite = 1,
@@ -358,15 +492,27 @@ private:
         DiskIoDoneWrite = 4
     };
     volatile enum DiskIoState disk_io_state;
-    union grid_io_block disk_block;
+    union grid_io_block disk_blocks[TERRAIN_IO_BATCH_SIZE];
+    uint32_t disk_offsets[TERRAIN_IO_BATCH_SIZE];
+    uint8_t disk_batch_count;
+
+    // blocks of the batch read from a .DAT file that should be
+    // rewritten in the compressed format
+    bool disk_convert[TERRAIN_IO_BATCH_SIZE];
+
+    // format used for disk IO, fixed at allocation, and the IO
+    // thread's buffer for a compressed block
+    uint8_t file_format;
+    struct grid_compact_block *compact_io;
 
     // last time we asked for more grids
     uint32_t last_request_time_ms[MAVLINK_COMM_NUM_BUFFERS];
 
     static const uint64_t bitmap_mask = (((uint64_t)1U)<<(TERRAIN_GRID_BLOCK_MUL_X*TERRAIN_GRID_BLOCK_MUL_Y)) - 1;
 
-    // open file handle on degree file
+    // open file handles on the .DAT and .DTZ degree files
     int fd;
+    int fd_compact;
 
     // has the timer been setup?
     bool timer_setup;
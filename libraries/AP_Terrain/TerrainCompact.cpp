@@ -0,0 +1,164 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  compressed terrain grid blocks, for TERRAIN_FORMAT=2
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+#include <GCS_MAVLink/GCS.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE
+
+// the residual of a height from its prediction spans 18 bits
+#define TERRAIN_COMPACT_MAX_WIDTH 18
+
+/*
+  predict a height from the neighbours already coded, as on a plane
+  through them. Along the first row and column the slope is carried on
+  from the two previous heights
+ */
+int32_t AP_Terrain::predict_height(const struct grid_block &block, uint8_t x, uint8_t y, int16_t base)
+{
+    if (x == 0) {
+        if (y < 2) {
+            return y == 0 ? base : block.height[0][0];
+        }
+        return 2 * (int32_t)block.height[0][y-1] - block.height[0][y-2];
+    }
+    if (y == 0) {
+        if (x < 2) {
+            return block.height[0][0];
+        }
+        return 2 * (int32_t)block.height[x-1][0] - block.height[x-2][0];
+    }
+    return (int32_t)block.height[x-1][y] + block.height[x][y-1] - block.height[x-1][y-1];
+}
+
+void AP_Terrain::compact_header(const struct grid_block &block, struct grid_compact_block &compact)
+{
+    compact.bitmap = block.bitmap;
+    compact.lat = block.lat;
+    compact.lon = block.lon;
+    compact.crc = block.crc;
+    compact.version = TERRAIN_GRID_FORMAT_VERSION_COMPACT;
+    compact.spacing = block.spacing;
+    compact.grid_idx_x = block.grid_idx_x;
+    compact.grid_idx_y = block.grid_idx_y;
+    compact.lon_degrees = block.lon_degrees;
+    compact.lat_degrees = block.lat_degrees;
+    compact.flags = 0;
+    compact.base = block.height[0][0];
+    compact.length = 0;
+}
+
+/*
+  compress a block, which must already have its crc set. Returns
+  false if the heights don't fit in a slot
+ */
+bool AP_Terrain::compress_block(const struct grid_block &block, struct grid_compact_block &compact)
+{
+    static_assert(sizeof(struct grid_compact_block) == TERRAIN_COMPACT_SLOT_SIZE,
+                  "grid_compact_block must fill a slot");
+    static_assert((TERRAIN_GRID_BLOCK_SIZE_Y % 8) == 0, "rows must pack into whole bytes");
+
+    compact_header(block, compact);
+
+    uint16_t len = 0;
+    for (uint8_t x=0; x<TERRAIN_GRID_BLOCK_SIZE_X; x++) {
+        uint32_t zigzag[TERRAIN_GRID_BLOCK_SIZE_Y];
+        uint32_t all_bits = 0;
+        for (uint8_t y=0; y<TERRAIN_GRID_BLOCK_SIZE_Y; y++) {
+            const int32_t residual = block.height[x][y] - predict_height(block, x, y, compact.base);
+            zigzag[y] = ((uint32_t)residual << 1) ^ (uint32_t)(residual >> 31);
+            all_bits |= zigzag[y];
+        }
+        const uint8_t width = all_bits ? 32 - __builtin_clz(all_bits) : 0;
+        const uint16_t row_bytes = (TERRAIN_GRID_BLOCK_SIZE_Y * width) / 8;
+        if (len + 1 + row_bytes > TERRAIN_COMPACT_DATA_SIZE) {
+            return false;
+        }
+        compact.data[len++] = width;
+
+        uint64_t acc = 0;
+        uint8_t nbits = 0;
+        for (uint8_t y=0; y<TERRAIN_GRID_BLOCK_SIZE_Y; y++) {
+            acc |= (uint64_t)zigzag[y] << nbits;
+            nbits += width;
+            while (nbits >= 8) {
+                compact.data[len++] = acc & 0xFF;
+                acc >>= 8;
+                nbits -= 8;
+            }
+        }
+    }
+    compact.length = len;
+    return true;
+}
+
+/*
+  decompress a block. The caller checks the crc of the result, which
+  covers the whole decoded block
+ */
+bool AP_Terrain::decompress_block(const struct grid_compact_block &compact, struct grid_block &block)
+{
+    if (compact.length > TERRAIN_COMPACT_DATA_SIZE) {
+        return false;
+    }
+
+    const uint8_t *data = compact.data;
+    const uint8_t *end = &compact.data[compact.length];
+    for (uint8_t x=0; x<TERRAIN_GRID_BLOCK_SIZE_X; x++) {
+        if (data >= end) {
+            return false;
+        }
+        const uint8_t width = *data++;
+        if (width > TERRAIN_COMPACT_MAX_WIDTH ||
+            data + (TERRAIN_GRID_BLOCK_SIZE_Y * width) / 8 > end) {
+            return false;
+        }
+        const uint32_t mask = (1U << width) - 1;
+        uint64_t acc = 0;
+        uint8_t nbits = 0;
+        for (uint8_t y=0; y<TERRAIN_GRID_BLOCK_SIZE_Y; y++) {
+            while (nbits < width) {
+                acc |= (uint64_t)(*data++) << nbits;
+                nbits += 8;
+            }
+            const uint32_t zigzag = acc & mask;
+            acc >>= width;
+            nbits -= width;
+            const int32_t residual = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            block.height[x][y] = residual + predict_height(block, x, y, compact.base);
+        }
+    }
+
+    block.bitmap = compact.bitmap;
+    block.lat = compact.lat;
+    block.lon = compact.lon;
+    block.crc = compact.crc;
+    block.version = TERRAIN_GRID_FORMAT_VERSION;
+    block.spacing = compact.spacing;
+    block.grid_idx_x = compact.grid_idx_x;
+    block.grid_idx_y = compact.grid_idx_y;
+    block.lon_degrees = compact.lon_degrees;
+    block.lat_degrees = compact.lat_degrees;
+    return true;
+}
+
+#endif // AP_TERRAIN_AVAILABLE
@@ -28,8 +28,55 @@
 #include <assert.h>
 #include <stdio.h>
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#include <SITL/SIM_SRTM.h>
+#endif
+
 extern const AP_HAL::HAL& hal;
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+/*
+  fill any missing 4x4 grids of a block from the simulator's SRTM
+  cache, sampling the same points a GCS would send. The data is
+  already on disk in the shared cache, so the block is not marked
+  dirty. Return false if the simulator has no data for the whole block
+ */
+bool AP_Terrain::fill_from_simulator(struct grid_cache &gcache)
+{
+    struct grid_block &grid = gcache.grid;
+    if (!SITL::SRTM::available()) {
+        return false;
+    }
+    struct grid_block filled = grid;
+    for (uint8_t gridbit=0; gridbit<TERRAIN_GRID_BLOCK_MUL_X*TERRAIN_GRID_BLOCK_MUL_Y; gridbit++) {
+        if (grid.bitmap & (((uint64_t)1) << gridbit)) {
+            continue;
+        }
+        uint8_t idx_x = (gridbit / TERRAIN_GRID_BLOCK_MUL_Y) * TERRAIN_GRID_MAVLINK_SIZE;
+        uint8_t idx_y = (gridbit % TERRAIN_GRID_BLOCK_MUL_Y) * TERRAIN_GRID_MAVLINK_SIZE;
+        for (uint8_t x=0; x<TERRAIN_GRID_MAVLINK_SIZE; x++) {
+            for (uint8_t y=0; y<TERRAIN_GRID_MAVLINK_SIZE; y++) {
+                Location loc;
+                loc.lat = grid.lat;
+                loc.lng = grid.lon;
+                location_offset(loc, (idx_x+x)*(float)grid_spacing, (idx_y+y)*(float)grid_spacing);
+                float height;
+                if (!SITL::SRTM::height_amsl(loc.lat, loc.lng, height)) {
+                    return false;
+                }
+                filled.height[idx_x+x][idx_y+y] = height;
+            }
+        }
+        filled.bitmap |= ((uint64_t)1) << gridbit;
+    }
+    grid = filled;
+    if (gcache.state != GRID_CACHE_DIRTY) {
+        gcache.state = GRID_CACHE_VALID;
+    }
+    return true;
+}
+#endif
+
 /*
   request any missing 4x4 grids from a block, given a grid_cache
  */
@@ -54,6 +101,13 @@ bool AP_Terrain::request_missing(mavlink_channel_t chan, struct grid_cache &gcac
         return false;
     }
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    if (fill_from_simulator(gcache)) {
+        // nothing to ask the GCS for
+        return false;
+    }
+#endif
+
     if (!HAVE_PAYLOAD_SPACE(chan, TERRAIN_REQUEST)) {
         // not enough buffer space
         return false;
@@ -259,17 +313,13 @@ void AP_Terrain::handle_terrain_data(mavlink_message_t *msg)
     mavlink_terrain_data_t packet;
     mavlink_msg_terrain_data_decode(msg, &packet);
 
-    uint16_t i;
-    for (i=0; i<cache_size; i++) {
-        if (cache[i].grid.lat == packet.lat && 
-            cache[i].grid.lon == packet.lon && 
-            cache[i].grid.spacing == packet.grid_spacing &&
-            grid_spacing == packet.grid_spacing &&
-            packet.gridbit < 56) {
-            break;
-        }
+    if (cache == nullptr ||
+        grid_spacing != packet.grid_spacing || packet.gridbit >= 56) {
+        // not allocated yet, or not for our grid
+        return;
     }
-    if (i == cache_size) {
+    const int16_t i = cache_lookup(packet.lat, packet.lon, packet.grid_spacing);
+    if (i == -1) {
         // we don't have that grid, ignore data
         return;
     }
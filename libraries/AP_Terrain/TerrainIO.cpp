@@ -35,18 +35,49 @@
 
 extern const AP_HAL::HAL& hal;
 
+/*
+  gather up to TERRAIN_IO_BATCH_SIZE cache blocks in the given state
+  into disk_blocks[]. All blocks come from the same degree file as the
+  first one found, and are sorted by file offset so the IO thread
+  moves through the file in one direction
+ */
+void AP_Terrain::collect_disk_io(enum GridCacheState state)
+{
+    disk_batch_count = 0;
+    for (uint16_t i=0; i<cache_size && disk_batch_count < TERRAIN_IO_BATCH_SIZE; i++) {
+        const struct grid_block &grid = cache[i].grid;
+        if (cache[i].state != state) {
+            continue;
+        }
+        if (disk_batch_count > 0 &&
+            (grid.lat_degrees != disk_blocks[0].block.lat_degrees ||
+             grid.lon_degrees != disk_blocks[0].block.lon_degrees)) {
+            // a different file, leave for a later batch
+            continue;
+        }
+        const uint32_t ofs = block_file_offset(grid);
+        // insertion sort on file offset
+        uint8_t j = disk_batch_count;
+        while (j > 0 && disk_offsets[j-1] > ofs) {
+            disk_blocks[j] = disk_blocks[j-1];
+            disk_offsets[j] = disk_offsets[j-1];
+            j--;
+        }
+        disk_blocks[j].block = grid;
+        disk_offsets[j] = ofs;
+        disk_batch_count++;
+    }
+}
+
 /*
   check for blocks that need to be read from disk
  */
 void AP_Terrain::check_disk_read(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
-        }
-    }    
+    collect_disk_io(GRID_CACHE_DISKWAIT);
+    if (disk_batch_count > 0) {
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -54,13 +85,10 @@ void AP_Terrain::check_disk_read(void)
  */
 void AP_Terrain::check_disk_write(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].state == GRID_CACHE_DIRTY) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitWrite;
-            return;
-        }
-    }    
+    collect_disk_io(GRID_CACHE_DIRTY);
+    if (disk_batch_count > 0) {
+        disk_io_state = DiskIoWaitWrite;
+    }
 }
 
 /*
@@ -74,7 +102,9 @@ void AP_Terrain::schedule_disk_io(void)
 
     if (!timer_setup) {
         timer_setup = true;
-        hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_Terrain::io_timer, void));
+        if (!hal.scheduler->register_storage_process(FUNCTOR_BIND_MEMBER(&AP_Terrain::io_timer, void))) {
+            hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_Terrain::io_timer, void));
+        }
     }
 
     switch (disk_io_state) {
@@ -87,33 +117,38 @@ void AP_Terrain::schedule_disk_io(void)
         }
         break;
         
-    case DiskIoDoneRead: {
-        // a read has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
-        if (cache_idx != -1) {
-            if (disk_block.block.bitmap != 0) {
-                // when bitmap is zero we read an empty block
-                cache[cache_idx].grid = disk_block.block;
+    case DiskIoDoneRead:
+        // a batch of reads has completed
+        for (uint8_t i=0; i<disk_batch_count; i++) {
+            const struct grid_block &block = disk_blocks[i].block;
+            int16_t cache_idx = find_io_idx(block, GRID_CACHE_DISKWAIT);
+            if (cache_idx != -1) {
+                if (block.bitmap != 0) {
+                    // when bitmap is zero we read an empty block
+                    cache[cache_idx].grid = block;
+                }
+                // blocks found in a .DAT file are rewritten compressed
+                cache[cache_idx].state = disk_convert[i] ? GRID_CACHE_DIRTY : GRID_CACHE_VALID;
+                cache[cache_idx].last_access = ++access_counter;
             }
-            cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
         }
         disk_io_state = DiskIoIdle;
         break;
-    }
 
-    case DiskIoDoneWrite: {
-        // a write has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DIRTY);
-        if (cache_idx != -1) {
-            if (cache[cache_idx].grid.bitmap == disk_block.block.bitmap) {
-                // only mark valid if more grids haven't been added
-                cache[cache_idx].state = GRID_CACHE_VALID;
+    case DiskIoDoneWrite:
+        // a batch of writes has completed
+        for (uint8_t i=0; i<disk_batch_count; i++) {
+            const struct grid_block &block = disk_blocks[i].block;
+            int16_t cache_idx = find_io_idx(block, GRID_CACHE_DIRTY);
+            if (cache_idx != -1) {
+                if (cache[cache_idx].grid.bitmap == block.bitmap) {
+                    // only mark valid if more grids haven't been added
+                    cache[cache_idx].state = GRID_CACHE_VALID;
+                }
             }
         }
         disk_io_state = DiskIoIdle;
         break;
-    }
         
     case DiskIoWaitWrite:
     case DiskIoWaitRead:
@@ -138,17 +173,12 @@ All file operations are done by the IO thread.
 
 
 /*
-  open the current degree file
+  open a file of the degree of the current batch, with the given
+  extension. Returns -1 on failure
  */
-void AP_Terrain::open_file(void)
+int AP_Terrain::open_degree_file(const char *ext, int flags)
 {
-    struct grid_block &block = disk_block.block;
-    if (fd != -1 && 
-        block.lat_degrees == file_lat_degrees &&
-        block.lon_degrees == file_lon_degrees) {
-        // already open on right file
-        return;
-    }
+    const struct grid_block &block = disk_blocks[0].block;
     if (file_path == NULL) {
         const char* terrain_dir = hal.util->get_custom_terrain_directory();
         if (terrain_dir == NULL) {
@@ -157,23 +187,24 @@ void AP_Terrain::open_file(void)
         if (asprintf(&file_path, "%s/NxxExxx.DAT", terrain_dir) <= 0) {
             io_failure = true;
             file_path = NULL;
-            return;
+            return -1;
         }
     }
     if (file_path == NULL) {
         io_failure = true;
-        return;
+        return -1;
     }
     char *p = &file_path[strlen(file_path)-12];
     if (*p != '/') {
         io_failure = true;
-        return;        
+        return -1;
     }
-    snprintf(p, 13, "/%c%02u%c%03u.DAT",
+    snprintf(p, 13, "/%c%02u%c%03u.%.3s",
              block.lat_degrees<0?'S':'N',
              abs(block.lat_degrees),
              block.lon_degrees<0?'W':'E',
-             abs(block.lon_degrees));
+             abs(block.lon_degrees),
+             ext);
 
     // create directory if need be
     if (!directory_created) {
@@ -183,29 +214,65 @@ void AP_Terrain::open_file(void)
         *p = '/';
     }
 
-    if (fd != -1) {
-        ::close(fd);
-    }
-    fd = ::open(file_path, O_RDWR|O_CREAT, 0644);
-    if (fd == -1) {
+    const int ret = ::open(file_path, flags, 0644);
 #if TERRAIN_DEBUG
+    if (ret == -1) {
         hal.console->printf("Open %s failed - %s\n",
                             file_path, strerror(errno));
+    }
 #endif
-        io_failure = true;
+    return ret;
+}
+
+/*
+  open the degree files for the current batch. With the compressed
+  format the .DAT file is only read for blocks that don't compress
+  and for data stored before the format changed, so it isn't created
+  until a block needs it
+ */
+void AP_Terrain::open_file(void)
+{
+    struct grid_block &block = disk_blocks[0].block;
+    const bool compact = (file_format == TERRAIN_GRID_FORMAT_VERSION_COMPACT);
+    if ((compact ? fd_compact : fd) != -1 &&
+        block.lat_degrees == file_lat_degrees &&
+        block.lon_degrees == file_lon_degrees) {
+        // already open on right file
         return;
     }
 
+    if (fd != -1) {
+        ::close(fd);
+    }
+    if (fd_compact != -1) {
+        ::close(fd_compact);
+        fd_compact = -1;
+    }
+    if (compact) {
+        fd_compact = open_degree_file("DTZ", O_RDWR|O_CREAT);
+        if (fd_compact == -1) {
+            io_failure = true;
+            return;
+        }
+        fd = open_degree_file("DAT", O_RDWR);
+    } else {
+        fd = open_degree_file("DAT", O_RDWR|O_CREAT);
+        if (fd == -1) {
+            io_failure = true;
+            return;
+        }
+    }
+
     file_lat_degrees = block.lat_degrees;
     file_lon_degrees = block.lon_degrees;
 }
 
 /*
-  seek to the right offset for disk_block
+  get the offset of a block within its degree file. This may be called
+  from either thread
  */
-void AP_Terrain::seek_offset(void)
+uint32_t AP_Terrain::block_file_offset(const struct grid_block &block) const
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
     Location loc1, loc2;
     loc1.lat = block.lat_degrees*10*1000*1000L;
@@ -218,65 +285,141 @@ void AP_Terrain::seek_offset(void)
     Vector2f offset = location_diff(loc1, loc2);
     uint16_t east_blocks = offset.y / (grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
 
-    uint32_t file_offset = (east_blocks * block.grid_idx_x + 
-                            block.grid_idx_y) * sizeof(union grid_io_block);
-    if (::lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
+    return (east_blocks * block.grid_idx_x + 
+            block.grid_idx_y) * sizeof(union grid_io_block);
+}
+
+/*
+  seek to a block offset in an open file
+ */
+bool AP_Terrain::seek_offset(int &file_fd, uint32_t file_offset)
+{
+    if (::lseek(file_fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
         hal.console->printf("Seek %lu failed - %s\n",
                             (unsigned long)file_offset, strerror(errno));
 #endif
-        ::close(fd);
-        fd = -1;
+        ::close(file_fd);
+        file_fd = -1;
         io_failure = true;
+        return false;
     }
+    return true;
 }
 
 /*
-  write out disk_block
+  read from an offset in an open file. A short read is not an IO
+  failure, just a missing block on disk
  */
-void AP_Terrain::write_block(void)
+ssize_t AP_Terrain::read_at(int &file_fd, void *buf, uint16_t len, uint32_t file_offset)
 {
-    seek_offset();
-    if (io_failure) {
-        return;
+    if (!seek_offset(file_fd, file_offset)) {
+        return -1;
     }
+    return ::read(file_fd, buf, len);
+}
 
-    disk_block.block.crc = get_block_crc(disk_block.block);
-
-    ssize_t ret = ::write(fd, &disk_block, sizeof(disk_block));
-    if (ret  != sizeof(disk_block)) {
+/*
+  write to an offset in an open file
+ */
+bool AP_Terrain::write_at(int &file_fd, const void *buf, uint16_t len, uint32_t file_offset)
+{
+    if (!seek_offset(file_fd, file_offset)) {
+        return false;
+    }
+    if (::write(file_fd, buf, len) != len) {
 #if TERRAIN_DEBUG
         hal.console->printf("write failed - %s\n", strerror(errno));
 #endif
-        ::close(fd);
-        fd = -1;
+        ::close(file_fd);
+        file_fd = -1;
         io_failure = true;
+        return false;
+    }
+    return true;
+}
+
+/*
+  write out one block of the batch
+ */
+void AP_Terrain::write_block(union grid_io_block &disk_block, uint32_t file_offset)
+{
+    disk_block.block.crc = get_block_crc(disk_block.block);
+
+    if (file_format == TERRAIN_GRID_FORMAT_VERSION_COMPACT) {
+        if (!compress_block(disk_block.block, *compact_io)) {
+            // keep the heights in the .DAT file, and point there
+            if (fd == -1) {
+                fd = open_degree_file("DAT", O_RDWR|O_CREAT);
+                if (fd == -1) {
+                    io_failure = true;
+                    return;
+                }
+            }
+            if (!write_at(fd, &disk_block, sizeof(disk_block), file_offset)) {
+                return;
+            }
+            compact_header(disk_block.block, *compact_io);
+            compact_io->flags = TERRAIN_COMPACT_FLAG_OVERFLOW;
+        }
+        write_at(fd_compact, compact_io, sizeof(*compact_io),
+                 file_offset / (sizeof(disk_block) / TERRAIN_COMPACT_SLOT_SIZE));
     } else {
-        ::fsync(fd);
+        write_at(fd, &disk_block, sizeof(disk_block), file_offset);
+    }
+
 #if TERRAIN_DEBUG
-        printf("wrote block at %ld %ld ret=%d mask=%07llx\n",
+    if (!io_failure) {
+        printf("wrote block at %ld %ld mask=%07llx\n",
                (long)disk_block.block.lat,
                (long)disk_block.block.lon,
-               (int)ret,
                (unsigned long long)disk_block.block.bitmap);
-#endif
     }
-    disk_io_state = DiskIoDoneWrite;
+#endif
 }
 
 /*
-  read in disk_block
+  read in one block of the batch. Returns true if the block was found
+  in the .DAT file but belongs in the .DTZ file
  */
-void AP_Terrain::read_block(void)
+bool AP_Terrain::read_block(union grid_io_block &disk_block, uint32_t file_offset)
 {
-    seek_offset();
-    if (io_failure) {
-        return;
-    }
     int32_t lat = disk_block.block.lat;
     int32_t lon = disk_block.block.lon;
+    bool from_dat = true;
+    bool convert = false;
+    ssize_t ret = -1;
+
+    if (file_format == TERRAIN_GRID_FORMAT_VERSION_COMPACT) {
+        const uint32_t compact_offset = file_offset / (sizeof(disk_block) / TERRAIN_COMPACT_SLOT_SIZE);
+        ret = read_at(fd_compact, compact_io, sizeof(*compact_io), compact_offset);
+        if (io_failure) {
+            return false;
+        }
+        if (ret == sizeof(*compact_io) &&
+            compact_io->version == TERRAIN_GRID_FORMAT_VERSION_COMPACT &&
+            compact_io->lat == lat &&
+            compact_io->lon == lon) {
+            if (compact_io->flags & TERRAIN_COMPACT_FLAG_OVERFLOW) {
+                // too big to compress, read from the .DAT file
+            } else {
+                from_dat = false;
+                ret = decompress_block(*compact_io, disk_block.block) ? sizeof(disk_block) : 0;
+            }
+        } else {
+            // not stored compressed yet
+            convert = true;
+        }
+        if (from_dat) {
+            ret = (fd == -1) ? 0 : read_at(fd, &disk_block, sizeof(disk_block), file_offset);
+        }
+    } else {
+        ret = read_at(fd, &disk_block, sizeof(disk_block), file_offset);
+    }
+    if (io_failure) {
+        return false;
+    }
 
-    ssize_t ret = ::read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
         disk_block.block.lat != lat || 
         disk_block.block.lon != lon ||
@@ -296,16 +439,16 @@ void AP_Terrain::read_block(void)
         disk_block.block.lat = lat;
         disk_block.block.lon = lon;
         disk_block.block.bitmap = 0;
-    } else {
+        return false;
+    }
 #if TERRAIN_DEBUG
-        printf("read block at %ld %ld ret=%d mask=%07llx\n",
-               (long)lat,
-               (long)lon,
-               (int)ret,
-               (unsigned long long)disk_block.block.bitmap);
+    printf("read block at %ld %ld ret=%d mask=%07llx\n",
+           (long)lat,
+           (long)lon,
+           (int)ret,
+           (unsigned long long)disk_block.block.bitmap);
 #endif
-    }
-    disk_io_state = DiskIoDoneRead;
+    return convert;
 }
 
 /*
@@ -327,21 +470,39 @@ void AP_Terrain::io_timer(void)
         break;
         
     case DiskIoWaitWrite:
-        // need to write out the block
+        // need to write out the batch, with a single sync at the end
         open_file();
-        if (fd == -1) {
+        if (io_failure) {
             return;
         }
-        write_block();
+        for (uint8_t i=0; i<disk_batch_count; i++) {
+            write_block(disk_blocks[i], disk_offsets[i]);
+            if (io_failure) {
+                return;
+            }
+        }
+        if (fd != -1) {
+            ::fsync(fd);
+        }
+        if (fd_compact != -1) {
+            ::fsync(fd_compact);
+        }
+        disk_io_state = DiskIoDoneWrite;
         break;
 
     case DiskIoWaitRead:
-        // need to read in the block
+        // need to read in the batch
         open_file();
-        if (fd == -1) {
+        if (io_failure) {
             return;
         }
-        read_block();
+        for (uint8_t i=0; i<disk_batch_count; i++) {
+            disk_convert[i] = read_block(disk_blocks[i], disk_offsets[i]);
+            if (io_failure) {
+                return;
+            }
+        }
+        disk_io_state = DiskIoDoneRead;
         break;
     }
 }
@@ -105,6 +105,70 @@ void AP_Terrain::update_mission_data(void)
     }
 }
 
+/*
+  touch the grids along a leg so any that are not in memory are read
+  from disk, or requested from the GCS if not on disk. Samples are one
+  grid block apart. Returns the number of steps left
+ */
+uint8_t AP_Terrain::lookahead_leg(const Location &from, const Location &to, uint8_t steps)
+{
+    const float leg_dist = get_distance(from, to);
+    const float step = grid_spacing * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y);
+    const float bearing = get_bearing_cd(from, to) * 0.01f;
+    float d = step;
+    while (steps > 0) {
+        Location loc = from;
+        location_update(loc, bearing, MIN(d, leg_dist));
+        struct grid_info info;
+        calculate_grid_info(loc, info);
+        find_grid_cache(info);
+        steps--;
+        if (d >= leg_dist) {
+            break;
+        }
+        d += step;
+    }
+    return steps;
+}
+
+/*
+  prefetch terrain along the current mission leg and the one after
+  it, about once a second. The lookahead is limited to a quarter of
+  the cache so it never pushes out the grids around the vehicle
+ */
+void AP_Terrain::update_lookahead(const Location &loc)
+{
+    if (!enable || !allocate() || grid_spacing <= 0 ||
+        mission.state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+    const uint32_t now = AP_HAL::millis();
+    if (now - last_lookahead_ms < 1000) {
+        return;
+    }
+    last_lookahead_ms = now;
+
+    const AP_Mission::Mission_Command &nav_cmd = mission.get_current_nav_cmd();
+    if (nav_cmd.content.location.lat == 0 && nav_cmd.content.location.lng == 0) {
+        return;
+    }
+    uint8_t steps = MAX(cache_size / 4, 1);
+    steps = lookahead_leg(loc, nav_cmd.content.location, steps);
+    if (steps == 0) {
+        return;
+    }
+
+    // continue onto the following waypoint leg
+    AP_Mission::Mission_Command cmd;
+    for (uint16_t i=nav_cmd.index+1; mission.read_cmd_from_storage(i, cmd); i++) {
+        if ((cmd.id == MAV_CMD_NAV_WAYPOINT || cmd.id == MAV_CMD_NAV_SPLINE_WAYPOINT) &&
+            (cmd.content.location.lat != 0 || cmd.content.location.lng != 0)) {
+            lookahead_leg(nav_cmd.content.location, cmd.content.location, steps);
+            break;
+        }
+    }
+}
+
 /*
   check that we have fetched all rally terrain data
  */
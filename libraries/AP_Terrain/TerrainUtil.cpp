@@ -116,24 +116,31 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
  */
 AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
-
     // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].grid.lat == info.grid_lat && 
-            cache[i].grid.lon == info.grid_lon &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
-        }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
+    const int16_t found = cache_lookup(info.grid_lat, info.grid_lon, grid_spacing);
+    if (found != -1) {
+        cache[found].last_access = ++access_counter;
+        return cache[found];
+    }
+
+    // Not found. Replace the least recently used grid, avoiding
+    // ones with data not yet written to disk if we can
+    uint8_t oldest_i = 0;
+    bool oldest_dirty = true;
+    for (uint8_t i=0; i<cache_size; i++) {
+        const bool dirty = (cache[i].state == GRID_CACHE_DIRTY);
+        if ((oldest_dirty && !dirty) ||
+            (dirty == oldest_dirty && cache[i].last_access < cache[oldest_i].last_access)) {
             oldest_i = i;
+            oldest_dirty = dirty;
         }
     }
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
+    // make it this grid, initially unpopulated
     struct grid_cache &grid = cache[oldest_i];
+    if (grid.grid.spacing != 0) {
+        cache_index_remove(oldest_i);
+    }
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -144,7 +151,8 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lat_degrees = info.lat_degrees;
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
-    grid.last_access_ms = AP_HAL::millis();
+    grid.last_access = ++access_counter;
+    cache_index_add(oldest_i);
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
@@ -153,22 +161,97 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
 }
 
 /*
-  find cache index of disk_block
+  hash of a grid position, as a starting slot in cache_index
+ */
+uint8_t AP_Terrain::cache_hash(int32_t lat, int32_t lon, uint16_t spacing)
+{
+    uint32_t h = (uint32_t)lat * 2654435761U;
+    h ^= (uint32_t)lon * 40503U;
+    h ^= spacing;
+    return (uint8_t)((h ^ (h >> 16)) & (TERRAIN_CACHE_INDEX_SIZE-1));
+}
+
+/*
+  find the cache slot holding a grid, or -1
+ */
+int16_t AP_Terrain::cache_lookup(int32_t lat, int32_t lon, uint16_t spacing) const
+{
+    if (cache == nullptr) {
+        return -1;
+    }
+    uint8_t h = cache_hash(lat, lon, spacing);
+    // the index is never more than half full, so an empty slot
+    // always ends the search
+    while (cache_index[h] != TERRAIN_CACHE_INDEX_EMPTY) {
+        const struct grid_block &grid = cache[cache_index[h]].grid;
+        if (grid.lat == lat && grid.lon == lon && grid.spacing == spacing) {
+            return cache_index[h];
+        }
+        h = (h + 1) & (TERRAIN_CACHE_INDEX_SIZE-1);
+    }
+    return -1;
+}
+
+void AP_Terrain::cache_index_add(uint8_t idx)
+{
+    const struct grid_block &grid = cache[idx].grid;
+    uint8_t h = cache_hash(grid.lat, grid.lon, grid.spacing);
+    while (cache_index[h] != TERRAIN_CACHE_INDEX_EMPTY) {
+        h = (h + 1) & (TERRAIN_CACHE_INDEX_SIZE-1);
+    }
+    cache_index[h] = idx;
+}
+
+/*
+  remove a cache slot from the index. Later members of the probe
+  sequence are shifted back so lookups never stop early
+ */
+void AP_Terrain::cache_index_remove(uint8_t idx)
+{
+    const struct grid_block &grid = cache[idx].grid;
+    uint8_t hole = cache_hash(grid.lat, grid.lon, grid.spacing);
+    while (cache_index[hole] != idx) {
+        if (cache_index[hole] == TERRAIN_CACHE_INDEX_EMPTY) {
+            // not indexed
+            return;
+        }
+        hole = (hole + 1) & (TERRAIN_CACHE_INDEX_SIZE-1);
+    }
+    uint8_t j = hole;
+    while (true) {
+        j = (j + 1) & (TERRAIN_CACHE_INDEX_SIZE-1);
+        if (cache_index[j] == TERRAIN_CACHE_INDEX_EMPTY) {
+            break;
+        }
+        const struct grid_block &g = cache[cache_index[j]].grid;
+        const uint8_t home = cache_hash(g.lat, g.lon, g.spacing);
+        // entries whose home slot lies cyclically in (hole, j] stay put
+        const bool stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!stays) {
+            cache_index[hole] = cache_index[j];
+            hole = j;
+        }
+    }
+    cache_index[hole] = TERRAIN_CACHE_INDEX_EMPTY;
+}
+
+/*
+  find cache index of a block that has been through disk IO
  */
-int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
+int16_t AP_Terrain::find_io_idx(const struct grid_block &block, enum GridCacheState state)
 {
     // try first with given state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (disk_block.block.lat == cache[i].grid.lat &&
-            disk_block.block.lon == cache[i].grid.lon && 
+        if (block.lat == cache[i].grid.lat &&
+            block.lon == cache[i].grid.lon && 
             cache[i].state == state) {
             return i;
         }
     }    
     // then any state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (disk_block.block.lat == cache[i].grid.lat &&
-            disk_block.block.lon == cache[i].grid.lon) {
+        if (block.lat == cache[i].grid.lat &&
+            block.lon == cache[i].grid.lon) {
             return i;
         }
     }    
@@ -2,6 +2,16 @@
 
 #include "DataFlash_Backend.h"
 
+#include <stdio.h>
+#include <AP_Common/AP_Alloc.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+// most pre-trigger data logged per call to periodic_tasks(), and the
+// space left in each backend for messages being logged as usual
+#define DATAFLASH_PRETRIGGER_DRAIN_BYTES 512
+#define DATAFLASH_PRETRIGGER_RESERVE 1024
+
 DataFlash_Class *DataFlash_Class::_instance;
 
 const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
@@ -31,6 +41,35 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
     // @Values: 0:Disabled,1:Enabled
     // @User: Standard
     AP_GROUPINFO("_REPLAY",  3, DataFlash_Class, _params.log_replay,       0),
+
+    // @Param: _FILE_COMPRESS
+    // @DisplayName: Compress DataFlash File Backend logs
+    // @Description: If LOG_FILE_COMPRESS is set to 1 then log files are written as LZ4-compressed blocks, which typically halves the amount of data written to the microSD card. Compressed logs are decoded by Replay and need to be decompressed before being loaded into tools that do not understand the format. Takes effect when the next log is started.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_COMPRESS",  4, DataFlash_Class, _params.file_compress,       0),
+
+    // @Param: _PRETRIG_SECS
+    // @DisplayName: Pre-trigger logging time
+    // @Description: If non-zero, high rate messages selected by LOG_PRETRIG_MASK which are not otherwise being logged are kept in RAM. When an event such as a crash or an EKF failsafe triggers the log, the last LOG_PRETRIG_SECS seconds of them are written to the log, and they are logged as they arrive for LOG_PRETRIG_SECS seconds after the trigger. Zero disables pre-trigger logging
+    // @Units: seconds
+    // @Range: 0 30
+    // @User: Advanced
+    AP_GROUPINFO("_PRETRIG_SECS",  5, DataFlash_Class, _params.pretrig_secs,       0),
+
+    // @Param: _PRETRIG_MASK
+    // @DisplayName: Pre-trigger logging messages
+    // @Description: Bitmask of the messages kept for pre-trigger logging, see LOG_PRETRIG_SECS. Raw IMU samples are logged at the sensor rate and need a large LOG_PRETRIG_KB to cover more than a short time
+    // @Bitmask: 0:Raw IMU samples,1:IMU,2:Attitude and EKF
+    // @User: Advanced
+    AP_GROUPINFO("_PRETRIG_MASK",  6, DataFlash_Class, _params.pretrig_mask,       DATAFLASH_PRETRIGGER_IMU | DATAFLASH_PRETRIGGER_ATTITUDE),
+
+    // @Param: _PRETRIG_KB
+    // @DisplayName: Pre-trigger logging buffer size (in kilobytes)
+    // @Description: RAM used to keep messages for pre-trigger logging. When it fills the oldest messages are dropped, so this can limit how much of LOG_PRETRIG_SECS is logged before a trigger. Takes effect after a reboot
+    // @Range: 1 127
+    // @User: Advanced
+    AP_GROUPINFO("_PRETRIG_KB",  7, DataFlash_Class, _params.pretrig_kb,       16),
     
     AP_GROUPEND
 };
@@ -78,6 +117,10 @@ void DataFlash_Class::set_mission(const AP_Mission *mission) {
 
 // start functions pass straight through to backend:
 void DataFlash_Class::WriteBlock(const void *pBuffer, uint16_t size) {
+    if (_pretrigger_capture) {
+        WritePretriggerBlock(pBuffer, size);
+        return;
+    }
     FOR_EACH_BACKEND(WriteBlock(pBuffer, size));
 }
 
@@ -89,6 +132,115 @@ void DataFlash_Class::WritePrioritisedBlock(const void *pBuffer, uint16_t size,
     FOR_EACH_BACKEND(WritePrioritisedBlock(pBuffer, size, is_critical));
 }
 
+/*
+  keep a message in the pre-trigger buffer, dropping the oldest
+  messages to make room. Inside the window after a trigger the message
+  is logged straight away, unless the buffer is still being written out
+ */
+void DataFlash_Class::WritePretriggerBlock(const void *pBuffer, uint16_t size)
+{
+    if (_params.pretrig_secs <= 0 || size > UINT8_MAX) {
+        return;
+    }
+    const uint32_t now = AP_HAL::millis();
+    if (_pretrigger_triggered && !_pretrigger_draining) {
+        if ((int32_t)(now - _pretrigger_until_ms) < 0) {
+            FOR_EACH_BACKEND(WriteBlock(pBuffer, size));
+            return;
+        }
+        _pretrigger_triggered = false;
+    }
+
+    if (_pretrigger_buf == nullptr) {
+        AP_Alloc::Tag alloc_tag("DataFlash");
+        _pretrigger_buf = new ByteBuffer(_params.pretrig_kb * 1024);
+        if (_pretrigger_buf == nullptr) {
+            return;
+        }
+    }
+    struct pretrigger_header hdr = { now, (uint8_t)size };
+    if (_pretrigger_buf->get_size() < sizeof(hdr) + size) {
+        // no memory, or a tiny buffer
+        return;
+    }
+    while (_pretrigger_buf->space() < sizeof(hdr) + size) {
+        struct pretrigger_header old;
+        if (_pretrigger_buf->peekbytes((uint8_t *)&old, sizeof(old)) != sizeof(old)) {
+            return;
+        }
+        _pretrigger_buf->advance(sizeof(old) + old.size);
+    }
+    _pretrigger_buf->write((const uint8_t *)&hdr, sizeof(hdr));
+    _pretrigger_buf->write((const uint8_t *)pBuffer, size);
+}
+
+/*
+  log the pre-trigger messages from the last LOG_PRETRIG_SECS, and
+  carry on logging them for LOG_PRETRIG_SECS. A trigger inside that
+  window extends it
+ */
+void DataFlash_Class::trigger(const char *reason)
+{
+    if (_params.pretrig_secs <= 0) {
+        return;
+    }
+    char msg[50];
+    snprintf(msg, sizeof(msg), "Log trigger: %s", reason);
+    Log_Write_Message(msg);
+
+    const uint32_t now = AP_HAL::millis();
+    const uint32_t window_ms = _params.pretrig_secs * 1000UL;
+    if (!_pretrigger_triggered) {
+        _pretrigger_from_ms = now - window_ms;
+        _pretrigger_draining = (_pretrigger_buf != nullptr);
+    }
+    _pretrigger_triggered = true;
+    _pretrigger_until_ms = now + window_ms;
+}
+
+/*
+  write out some of the pre-trigger buffer, leaving room in the
+  backends for the messages being logged as usual
+ */
+void DataFlash_Class::pretrigger_drain(void)
+{
+    if (!_pretrigger_draining) {
+        return;
+    }
+    uint32_t space = UINT32_MAX;
+    for (uint8_t i=0; i<_next_backend; i++) {
+        const uint32_t backend_space = backends[i]->bufferspace_available();
+        if (backend_space < space) {
+            space = backend_space;
+        }
+    }
+
+    uint8_t pkt[UINT8_MAX];
+    uint16_t written = 0;
+    while (written < DATAFLASH_PRETRIGGER_DRAIN_BYTES) {
+        struct pretrigger_header hdr;
+        if (_pretrigger_buf->peekbytes((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr)) {
+            // caught up, log messages as they arrive from now on
+            _pretrigger_draining = false;
+            if (_pretrigger_writes_off) {
+                _pretrigger_writes_off = false;
+                FOR_EACH_BACKEND(EnableWrites(false));
+            }
+            return;
+        }
+        if ((uint32_t)hdr.size + DATAFLASH_PRETRIGGER_RESERVE > space) {
+            return;
+        }
+        _pretrigger_buf->advance(sizeof(hdr));
+        _pretrigger_buf->read(pkt, hdr.size);
+        if ((int32_t)(hdr.time_ms - _pretrigger_from_ms) >= 0) {
+            FOR_EACH_BACKEND(WriteBlock(pkt, hdr.size));
+            written += hdr.size;
+            space -= hdr.size;
+        }
+    }
+}
+
 // change me to "DoTimeConsumingPreparations"?
 void DataFlash_Class::EraseAll() {
     FOR_EACH_BACKEND(EraseAll());
@@ -195,6 +347,12 @@ bool DataFlash_Class::logging_started(void) {
 }
 
 void DataFlash_Class::EnableWrites(bool enable) {
+    // finish writing out a trigger first, it is most likely to be
+    // wanted when the vehicle has just disarmed after a crash
+    _pretrigger_writes_off = !enable && _pretrigger_draining;
+    if (_pretrigger_writes_off) {
+        return;
+    }
     FOR_EACH_BACKEND(EnableWrites(enable));
 }
 
@@ -206,6 +364,7 @@ void DataFlash_Class::remote_log_block_status_msg(mavlink_channel_t chan,
 // end for DataFlash_MAVLink
 
 void DataFlash_Class::periodic_tasks() {
+     pretrigger_drain();
      FOR_EACH_BACKEND(periodic_tasks());
 }
 
@@ -251,6 +410,14 @@ uint32_t DataFlash_Class::num_dropped() const
     return backends[0]->num_dropped();
 }
 
+uint32_t DataFlash_Class::num_dropped(uint8_t backend) const
+{
+    if (backend >= _next_backend) {
+        return 0;
+    }
+    return backends[backend]->num_dropped();
+}
+
 
 // end functions pass straight through to backend
 
@@ -274,6 +441,16 @@ void DataFlash_Class::Log_Write(const char *name, const char *labels, const char
         return;
     }
 
+    if (_next_backend == 0) {
+        return;
+    }
+
+    // serialise the message once and hand the same bytes to every backend
+    uint8_t buffer[f->msg_len];
+    va_start(arg_list, fmt);
+    Log_Write_serialise(buffer, f, arg_list);
+    va_end(arg_list);
+
     for (uint8_t i=0; i<_next_backend; i++) {
         if (!(f->sent_mask & (1U<<i))) {
             if (!backends[i]->Log_Write_Emit_FMT(f->msg_type)) {
@@ -281,13 +458,110 @@ void DataFlash_Class::Log_Write(const char *name, const char *labels, const char
             }
             f->sent_mask |= (1U<<i);
         }
-        va_start(arg_list, fmt);
-        backends[i]->Log_Write(f->msg_type, arg_list);
-        va_end(arg_list);
+        backends[i]->WritePrioritisedBlock(buffer, f->msg_len, false);
+    }
+}
+
+/*
+  serialise a Log_Write() message into buffer, which must be at least
+  f->msg_len bytes long
+ */
+void DataFlash_Class::Log_Write_serialise(uint8_t *buffer, const struct log_write_fmt *f, va_list arg_list)
+{
+    uint8_t offset = 0;
+    buffer[offset++] = HEAD_BYTE1;
+    buffer[offset++] = HEAD_BYTE2;
+    buffer[offset++] = f->msg_type;
+    for (uint8_t i=0; i<strlen(f->fmt); i++) {
+        uint8_t charlen = 0;
+        switch(f->fmt[i]) {
+        case 'b': {
+            int8_t tmp = va_arg(arg_list, int);
+            memcpy(&buffer[offset], &tmp, sizeof(int8_t));
+            offset += sizeof(int8_t);
+            break;
+        }
+        case 'h':
+        case 'c': {
+            int16_t tmp = va_arg(arg_list, int);
+            memcpy(&buffer[offset], &tmp, sizeof(int16_t));
+            offset += sizeof(int16_t);
+            break;
+        }
+        case 'd': {
+            double tmp = va_arg(arg_list, double);
+            memcpy(&buffer[offset], &tmp, sizeof(double));
+            offset += sizeof(double);
+            break;
+        }
+        case 'i':
+        case 'L':
+        case 'e': {
+            int32_t tmp = va_arg(arg_list, int);
+            memcpy(&buffer[offset], &tmp, sizeof(int32_t));
+            offset += sizeof(int32_t);
+            break;
+        }
+        case 'f': {
+            float tmp = va_arg(arg_list, double);
+            memcpy(&buffer[offset], &tmp, sizeof(float));
+            offset += sizeof(float);
+            break;
+        }
+        case 'n':
+            charlen = 4;
+            break;
+        case 'M':
+        case 'B': {
+            uint8_t tmp = va_arg(arg_list, int);
+            memcpy(&buffer[offset], &tmp, sizeof(uint8_t));
+            offset += sizeof(uint8_t);
+            break;
+        }
+        case 'H':
+        case 'C': {
+            uint16_t tmp = va_arg(arg_list, int);
+            memcpy(&buffer[offset], &tmp, sizeof(uint16_t));
+            offset += sizeof(uint16_t);
+            break;
+        }
+        case 'I':
+        case 'E': {
+            uint32_t tmp = va_arg(arg_list, uint32_t);
+            memcpy(&buffer[offset], &tmp, sizeof(uint32_t));
+            offset += sizeof(uint32_t);
+            break;
+        }
+        case 'N':
+            charlen = 16;
+            break;
+        case 'Z':
+            charlen = 64;
+            break;
+        case 'q': {
+            int64_t tmp = va_arg(arg_list, int64_t);
+            memcpy(&buffer[offset], &tmp, sizeof(int64_t));
+            offset += sizeof(int64_t);
+            break;
+        }
+        case 'Q': {
+            uint64_t tmp = va_arg(arg_list, uint64_t);
+            memcpy(&buffer[offset], &tmp, sizeof(uint64_t));
+            offset += sizeof(uint64_t);
+            break;
+        }
+        }
+        if (charlen != 0) {
+            char *tmp = va_arg(arg_list, char*);
+            memcpy(&buffer[offset], tmp, charlen);
+            offset += charlen;
+        }
     }
+
 }
 
 
+
 DataFlash_Class::log_write_fmt *DataFlash_Class::msg_fmt_for_name(const char *name, const char *labels, const char *fmt)
 {
     struct log_write_fmt *f;
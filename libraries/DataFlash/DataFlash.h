@@ -20,6 +20,7 @@
 #include <DataFlash/LogStructure.h>
 #include <AP_Motors/AP_Motors.h>
 #include <AP_Rally/AP_Rally.h>
+#include <AP_Scheduler/AP_Scheduler.h>
 #include <stdint.h>
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4
@@ -37,7 +38,16 @@ enum DataFlash_Backend_Type {
     DATAFLASH_BACKEND_BOTH = 3,
 };
 
+// sources of messages which can be kept for the log trigger, see
+// LOG_PRETRIG_MASK
+enum DataFlash_Pretrigger_Source {
+    DATAFLASH_PRETRIGGER_IMU_RAW  = (1<<0),
+    DATAFLASH_PRETRIGGER_IMU      = (1<<1),
+    DATAFLASH_PRETRIGGER_ATTITUDE = (1<<2),
+};
+
 // fwd declarations to avoid include errors
+class ByteBuffer;
 class AC_AttitudeControl;
 class AC_PosControl;
 
@@ -88,6 +98,21 @@ public:
     /* Write an *important* block of data at current offset */
     void WriteCriticalBlock(const void *pBuffer, uint16_t size);
 
+    /*
+      pre-trigger logging. High rate messages which are not otherwise
+      being logged are kept in RAM, and the last LOG_PRETRIG_SECS of
+      them are written to the log when trigger() is called. Messages
+      are then logged as they arrive for LOG_PRETRIG_SECS more
+     */
+    bool pretrigger_enabled(DataFlash_Pretrigger_Source source) const {
+        return _params.pretrig_secs > 0 && (_params.pretrig_mask & source);
+    }
+    /* Write a block of data which is only logged around a trigger */
+    void WritePretriggerBlock(const void *pBuffer, uint16_t size);
+    // while capture is set, WriteBlock() behaves as WritePretriggerBlock()
+    void set_pretrigger_capture(bool capture) { _pretrigger_capture = capture; }
+    void trigger(const char *reason);
+
     // high level interface
     uint16_t find_last_log() const;
     void get_log_boundaries(uint16_t log_num, uint16_t & start_page, uint16_t & end_page);
@@ -149,6 +174,12 @@ public:
                         const AC_AttitudeControl &attitude_control,
                         const AC_PosControl &pos_control);
     void Log_Write_Rally(const AP_Rally &rally);
+    void Log_Write_Scheduler(const AP_Scheduler &scheduler);
+    void Log_Write_Perf_Counters();
+    void Log_Write_Thread_Stats();
+#if HAL_INS_FFT_ENABLED
+    void Log_Write_GyroFFT(const AP_InertialSensor &ins);
+#endif
 
     void Log_Write(const char *name, const char *labels, const char *fmt, ...);
 
@@ -178,9 +209,13 @@ public:
 
     void periodic_tasks(); // may want to split this into GCS/non-GCS duties
 
-    // number of blocks that have been dropped
+    // number of blocks that have been dropped by the first backend
     uint32_t num_dropped(void) const;
 
+    // number of backends in use and the blocks dropped by each
+    uint8_t get_num_backends(void) const { return _next_backend; }
+    uint32_t num_dropped(uint8_t backend) const;
+
     // accesss to public parameters
     bool log_while_disarmed(void) const { return _params.log_disarmed != 0; }
     uint8_t log_replay(void) const { return _params.log_replay; }
@@ -194,6 +229,10 @@ public:
         AP_Int8 file_bufsize; // in kilobytes
         AP_Int8 log_disarmed;
         AP_Int8 log_replay;
+        AP_Int8 file_compress;
+        AP_Int8 pretrig_secs;
+        AP_Int8 pretrig_mask;
+        AP_Int8 pretrig_kb;
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
@@ -224,6 +263,25 @@ private:
 
     void internal_error() const;
 
+    // pre-trigger messages, each after a pretrigger_header
+    struct PACKED pretrigger_header {
+        uint32_t time_ms;
+        uint8_t size;
+    };
+    ByteBuffer *_pretrigger_buf;
+    bool _pretrigger_capture;
+    // inside the window after a trigger
+    bool _pretrigger_triggered;
+    // the buffer is being written to the log
+    bool _pretrigger_draining;
+    // EnableWrites(false) has been held off until the buffer is written
+    bool _pretrigger_writes_off;
+    // messages from _pretrigger_from_ms are logged, and they are
+    // logged as they arrive until _pretrigger_until_ms
+    uint32_t _pretrigger_from_ms;
+    uint32_t _pretrigger_until_ms;
+    void pretrigger_drain(void);
+
     /*
      * support for dynamic Log_Write; user-supplies name, format,
      * labels and values in a single function call.
@@ -242,6 +300,9 @@ private:
         const char *labels;
     } *log_write_fmts;
 
+    // serialise a Log_Write() message for all backends
+    void Log_Write_serialise(uint8_t *buffer, const struct log_write_fmt *f, va_list arg_list);
+
     // return (possibly allocating) a log_write_fmt for a name
     struct log_write_fmt *msg_fmt_for_name(const char *name, const char *labels, const char *fmt);
     
@@ -142,119 +142,3 @@ bool DataFlash_Backend::Log_Write_Emit_FMT(uint8_t msg_type)
     return true;
 }
 
-bool DataFlash_Backend::Log_Write(const uint8_t msg_type, va_list arg_list, bool is_critical)
-{
-    // stack-allocate a buffer so we can WriteBlock(); this could be
-    // 255 bytes!  If we were willing to lose the WriteBlock
-    // abstraction we could do WriteBytes() here instead?
-    const char *fmt  = NULL;
-    uint8_t msg_len;
-    DataFlash_Class::log_write_fmt *f;
-    for (f = _front.log_write_fmts; f; f=f->next) {
-        if (f->msg_type == msg_type) {
-            fmt = f->fmt;
-            msg_len = f->msg_len;
-            break;
-        }
-    }
-    if (fmt == NULL) {
-        // this is a bug.
-        internal_error();
-        return false;
-    }
-    if (bufferspace_available() < msg_len) {
-        return false;
-    }
-    uint8_t buffer[msg_len];
-    uint8_t offset = 0;
-    buffer[offset++] = HEAD_BYTE1;
-    buffer[offset++] = HEAD_BYTE2;
-    buffer[offset++] = msg_type;
-    for (uint8_t i=0; i<strlen(fmt); i++) {
-        uint8_t charlen = 0;
-        switch(fmt[i]) {
-        case 'b': {
-            int8_t tmp = va_arg(arg_list, int);
-            memcpy(&buffer[offset], &tmp, sizeof(int8_t));
-            offset += sizeof(int8_t);
-            break;
-        }
-        case 'h':
-        case 'c': {
-            int16_t tmp = va_arg(arg_list, int);
-            memcpy(&buffer[offset], &tmp, sizeof(int16_t));
-            offset += sizeof(int16_t);
-            break;
-        }
-        case 'd': {
-            double tmp = va_arg(arg_list, double);
-            memcpy(&buffer[offset], &tmp, sizeof(double));
-            offset += sizeof(double);
-            break;
-        }
-        case 'i':
-        case 'L':
-        case 'e': {
-            int32_t tmp = va_arg(arg_list, int);
-            memcpy(&buffer[offset], &tmp, sizeof(int32_t));
-            offset += sizeof(int32_t);
-            break;
-        }
-        case 'f': {
-            float tmp = va_arg(arg_list, double);
-            memcpy(&buffer[offset], &tmp, sizeof(float));
-            offset += sizeof(float);
-            break;
-        }
-        case 'n':
-            charlen = 4;
-            break;
-        case 'M':
-        case 'B': {
-            uint8_t tmp = va_arg(arg_list, int);
-            memcpy(&buffer[offset], &tmp, sizeof(uint8_t));
-            offset += sizeof(uint8_t);
-            break;
-        }
-        case 'H':
-        case 'C': {
-            uint16_t tmp = va_arg(arg_list, int);
-            memcpy(&buffer[offset], &tmp, sizeof(uint16_t));
-            offset += sizeof(uint16_t);
-            break;
-        }
-        case 'I':
-        case 'E': {
-            uint32_t tmp = va_arg(arg_list, uint32_t);
-            memcpy(&buffer[offset], &tmp, sizeof(uint32_t));
-            offset += sizeof(uint32_t);
-            break;
-        }
-        case 'N':
-            charlen = 16;
-            break;
-        case 'Z':
-            charlen = 64;
-            break;
-        case 'q': {
-            int64_t tmp = va_arg(arg_list, int64_t);
-            memcpy(&buffer[offset], &tmp, sizeof(int64_t));
-            offset += sizeof(int64_t);
-            break;
-        }
-        case 'Q': {
-            uint64_t tmp = va_arg(arg_list, uint64_t);
-            memcpy(&buffer[offset], &tmp, sizeof(uint64_t));
-            offset += sizeof(uint64_t);
-            break;
-        }
-        }
-        if (charlen != 0) {
-            char *tmp = va_arg(arg_list, char*);
-            memcpy(&buffer[offset], tmp, charlen);
-            offset += charlen;
-        }
-    }
-
-    return WritePrioritisedBlock(buffer, msg_len, is_critical);
-}
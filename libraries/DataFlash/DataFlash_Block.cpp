@@ -22,16 +22,55 @@ uint32_t DataFlash_Block::bufferspace_available()
 // *** DATAFLASH PUBLIC FUNCTIONS ***
 void DataFlash_Block::StartWrite(uint16_t PageAdr)
 {
+    ProgramPending(true);
     df_BufferIdx  = 0;
     df_BufferNum  = 0;
     df_PageAdr    = PageAdr;
+    df_Read_AheadPage = 0;
     WaitReady();
+    df_Busy_BufferNum = DF_NO_BUFFER;
 }
 
-void DataFlash_Block::FinishWrite(void)
+/*
+  program the pending page from its chip buffer. The chip programs one
+  page at a time, so unless we are told to wait this leaves the page
+  pending while the chip is busy, for periodic_fullrate() to retry
+ */
+void DataFlash_Block::ProgramPending(bool wait)
 {
+    if (df_Pending_PageAdr == 0) {
+        return;
+    }
+    if (!IsReady()) {
+        if (!wait) {
+            return;
+        }
+        WaitReady();
+    }
     // Write Buffer to flash, NO WAIT
-    BufferToPage(df_BufferNum, df_PageAdr, 0);      
+    BufferToPage(df_Pending_BufferNum, df_Pending_PageAdr, 0);
+    df_Busy_BufferNum = df_Pending_BufferNum;
+    df_Pending_PageAdr = 0;
+}
+
+void DataFlash_Block::periodic_fullrate(const uint32_t now)
+{
+    ProgramPending(false);
+}
+
+/*
+  finish the page in the current chip buffer and carry on in the
+  other one. The page is programmed later if the chip is still busy
+  with the last one, so logging only waits on the chip when both
+  buffers are full
+ */
+void DataFlash_Block::FinishWrite(void)
+{
+    ProgramPending(true);
+    df_Pending_BufferNum = df_BufferNum;
+    df_Pending_PageAdr = df_PageAdr;
+    ProgramPending(false);
+
     df_PageAdr++;
     // If we reach the end of the memory, start from the beginning    
     if (df_PageAdr > df_NumPages)
@@ -63,6 +102,12 @@ bool DataFlash_Block::WritePrioritisedBlock(const void *pBuffer, uint16_t size,
         }
 
         if (df_BufferIdx == 0) {
+            // the chip may still be programming a page from this
+            // buffer
+            if (df_BufferNum == df_Busy_BufferNum) {
+                WaitReady();
+                df_Busy_BufferNum = DF_NO_BUFFER;
+            }
             // if we are at the start of a page we need to insert a
             // page header
             if (n > df_PageSize - sizeof(struct PageHeader)) {
@@ -103,8 +148,12 @@ uint16_t DataFlash_Block::GetPage()
 
 void DataFlash_Block::StartRead(uint16_t PageAdr)
 {
+    // the chip buffers are about to be overwritten
+    ProgramPending(true);
+
     df_Read_BufferNum = 0;
     df_Read_PageAdr   = PageAdr;
+    df_Read_AheadPage = 0;
 
     // disable writing while reading
     log_write_started = false;
@@ -112,7 +161,7 @@ void DataFlash_Block::StartRead(uint16_t PageAdr)
     WaitReady();
 
     // copy flash page to buffer
-    PageToBuffer(df_Read_BufferNum, df_Read_PageAdr);
+    PageToBuffer(df_Read_BufferNum, df_Read_PageAdr, 1);
 
     // We are starting a new page - read FileNumber and FilePage
     struct PageHeader ph;
@@ -122,16 +171,33 @@ void DataFlash_Block::StartRead(uint16_t PageAdr)
     df_Read_BufferIdx = sizeof(ph);
 }
 
+/*
+  start copying the next page into the other chip buffer, so the read
+  can carry straight on into it at the end of this page
+ */
+void DataFlash_Block::StartReadAhead(void)
+{
+    uint16_t PageAdr = df_Read_PageAdr + 1;
+    if (PageAdr > df_NumPages) {
+        PageAdr = 1;
+    }
+    WaitReady();
+    PageToBuffer(df_Read_BufferNum ^ 1, PageAdr, 0);
+    df_Read_AheadPage = PageAdr;
+}
+
 bool DataFlash_Block::ReadBlock(void *pBuffer, uint16_t size)
 {
+    if (size > 0 && df_Read_AheadPage == 0) {
+        StartReadAhead();
+    }
+
     while (size > 0) {
         uint16_t n = df_PageSize - df_Read_BufferIdx;
         if (n > size) {
             n = size;
         }
 
-        WaitReady();
-
         if (!BlockRead(df_Read_BufferNum, df_Read_BufferIdx, pBuffer, n)) {
             return false;
         }
@@ -145,7 +211,14 @@ bool DataFlash_Block::ReadBlock(void *pBuffer, uint16_t size)
             if (df_Read_PageAdr > df_NumPages) {
                 df_Read_PageAdr = 1;
             }
-            PageToBuffer(df_Read_BufferNum, df_Read_PageAdr);
+            WaitReady();
+            if (df_Read_AheadPage == df_Read_PageAdr) {
+                // the page is already in the other buffer
+                df_Read_BufferNum ^= 1;
+            } else {
+                PageToBuffer(df_Read_BufferNum, df_Read_PageAdr, 1);
+            }
+            df_Read_AheadPage = 0;
 
             // We are starting a new page - read FileNumber and FilePage
             struct PageHeader ph;
@@ -156,6 +229,10 @@ bool DataFlash_Block::ReadBlock(void *pBuffer, uint16_t size)
             df_FilePage   = ph.FilePage;
 
             df_Read_BufferIdx = sizeof(ph);
+
+            if (size > 0) {
+                StartReadAhead();
+            }
         }
     }
     return true;
@@ -180,6 +257,7 @@ uint16_t DataFlash_Block::GetFilePage()
 void DataFlash_Block::EraseAll()
 {
     log_write_started = false;
+    df_Read_AheadPage = 0;
     for (uint16_t j = 1; j <= (df_NumPages+1)/8; j++) {
         BlockErase(j);
         if (j%6 == 0) {
@@ -7,11 +7,18 @@
 
 #include <stdint.h>
 
+// chip buffer number meaning no buffer
+#define DF_NO_BUFFER 0xFF
+
 class DataFlash_Block : public DataFlash_Backend
 {
 public:
     DataFlash_Block(DataFlash_Class &front, DFMessageWriter_DFLogStart *writer) :
-        DataFlash_Backend(front, writer) { }
+        DataFlash_Backend(front, writer),
+        df_Pending_BufferNum(DF_NO_BUFFER),
+        df_Pending_PageAdr(0),
+        df_Busy_BufferNum(DF_NO_BUFFER),
+        df_Read_AheadPage(0) { }
 
     virtual bool CardInserted(void) = 0;
 
@@ -42,6 +49,10 @@ public:
 
     uint32_t bufferspace_available();
 
+protected:
+    // hand a filled page to the chip once it has finished the last one
+    void periodic_fullrate(const uint32_t now) override;
+
 private:
     struct PageHeader {
         uint16_t FileNumber;
@@ -58,6 +69,16 @@ private:
     uint16_t df_FileNumber;
     uint16_t df_FilePage;
 
+    // a filled chip buffer waiting for the chip to be ready before it
+    // is programmed, and the buffer the chip was last told to program
+    // from. Pages are numbered from 1, so 0 is no page
+    uint8_t df_Pending_BufferNum;
+    uint16_t df_Pending_PageAdr;
+    uint8_t df_Busy_BufferNum;
+
+    // the page being read ahead into the other chip buffer, or 0
+    uint16_t df_Read_AheadPage;
+
     // offset from adding FMT messages to log data
     bool adding_fmt_headers;
 
@@ -65,8 +86,10 @@ private:
       functions implemented by the board specific backends
      */
     virtual void WaitReady() = 0;
+    // true if the chip can take a page program or transfer command
+    virtual bool IsReady() = 0;
     virtual void BufferToPage (uint8_t BufferNum, uint16_t PageAdr, uint8_t wait) = 0;
-    virtual void PageToBuffer(uint8_t BufferNum, uint16_t PageAdr) = 0;
+    virtual void PageToBuffer(uint8_t BufferNum, uint16_t PageAdr, uint8_t wait) = 0;
     virtual void PageErase(uint16_t PageAdr) = 0;
     virtual void BlockErase(uint16_t BlockAdr) = 0;
     virtual void ChipErase() = 0;
@@ -80,12 +103,20 @@ private:
     
     // read size bytes of data to a page. The caller must ensure that
     // the data fits within the page, otherwise it will wrap to the
-    // start of the page
+    // start of the page. This may be called while the chip is moving
+    // a page to or from the other buffer
     virtual bool BlockRead(uint8_t BufferNum, uint16_t IntPageAdr, void *pBuffer, uint16_t size) = 0;
 
     // erase handling
     bool NeedErase(void);
 
+    // program the pending page, if any. With wait false this only
+    // happens if the chip is already ready
+    void ProgramPending(bool wait);
+    // start moving the page after the one being read into the other
+    // chip buffer
+    void StartReadAhead(void);
+
     // internal high level functions
     void StartRead(uint16_t PageAdr);
     uint16_t find_last_page(void);
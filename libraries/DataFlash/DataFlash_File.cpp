@@ -29,6 +29,9 @@
 #include <stdio.h>
 #include <time.h>
 #include <dirent.h>
+#if DATAFLASH_FILE_USE_WRITEV
+#include <sys/uio.h>
+#endif
 #if defined(__APPLE__) && defined(__MACH__)
 #include <sys/param.h>
 #include <sys/mount.h>
@@ -56,26 +59,69 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
     _open_error(false),
     _log_directory(log_directory),
     _cached_oldest_log(0),
+    _housekeeping_last_us(0),
+    _housekeeping_removed(0),
+#if DATAFLASH_FILE_PREALLOCATE
+    _prepared_fd(-1),
+    _prealloc_end(0),
+#endif
     _writebuf(0),
 #if defined(CONFIG_ARCH_BOARD_PX4FMU_V1)
     // V1 gets IO errors with larger than 512 byte writes
     _writebuf_chunk(512),
+    _writebuf_chunk_max(512),
 #elif defined(CONFIG_ARCH_BOARD_VRBRAIN_V45)
     _writebuf_chunk(512),
+    _writebuf_chunk_max(512),
 #elif defined(CONFIG_ARCH_BOARD_VRBRAIN_V51)
     _writebuf_chunk(512),
+    _writebuf_chunk_max(512),
 #elif defined(CONFIG_ARCH_BOARD_VRBRAIN_V52)
     _writebuf_chunk(512),
+    _writebuf_chunk_max(512),
 #elif defined(CONFIG_ARCH_BOARD_VRUBRAIN_V51)
     _writebuf_chunk(512),
+    _writebuf_chunk_max(512),
 #elif defined(CONFIG_ARCH_BOARD_VRUBRAIN_V52)
     _writebuf_chunk(512),
+    _writebuf_chunk_max(512),
 #elif defined(CONFIG_ARCH_BOARD_VRHERO_V10)
     _writebuf_chunk(512),
+    _writebuf_chunk_max(512),
 #else
     _writebuf_chunk(4096),
+    _writebuf_chunk_max(16384),
 #endif
     _last_write_time(0),
+    _write_chunk(_writebuf_chunk),
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+    _read_ahead(),
+    _read_ahead_buf(nullptr),
+    _read_ahead_generation(0),
+    _read_ahead_fd(-1),
+    _read_ahead_fd_log_num(0),
+    _read_ahead_fd_generation(0),
+#endif
+#if DATAFLASH_FILE_LOG_INDEX
+    _index(nullptr),
+    _index_last_log(0),
+    _index_pending(nullptr),
+    _index_pending_last_log(0),
+    _index_pending_changes(0),
+    _index_changes(0),
+    _index_wanted(true),
+#endif
+#if DATAFLASH_FILE_SUMMARY
+    _summary_log_num(0),
+    _summary_last_ms(0),
+    _summary_text(nullptr),
+    _summary_io_text(nullptr),
+    _summary_text_len(0),
+    _summary_text_log_num(0),
+    _summary_due(false),
+#endif
+    _compress(false),
+    _lz_buf(nullptr),
     _perf_write(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_write")),
     _perf_fsync(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_fsync")),
     _perf_errors(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_errors")),
@@ -148,7 +194,9 @@ void DataFlash_File::Init()
     hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)bufsize);
 
     _initialised = true;
-    hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
+    if (!hal.scheduler->register_storage_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void))) {
+        hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
+    }
 }
 
 bool DataFlash_File::file_exists(const char *filename) const
@@ -170,8 +218,14 @@ bool DataFlash_File::file_exists(const char *filename) const
     return true;
 }
 
-bool DataFlash_File::log_exists(const uint16_t lognum) const
+bool DataFlash_File::log_exists(const uint16_t lognum)
 {
+#if DATAFLASH_FILE_LOG_INDEX
+    const struct log_index_entry *entry = _index_entry(lognum);
+    if (entry != nullptr) {
+        return entry->exists;
+    }
+#endif
     char *filename = _log_file_name(lognum);
     if (filename == NULL) {
         // internal_error();
@@ -185,6 +239,19 @@ bool DataFlash_File::log_exists(const uint16_t lognum) const
 void DataFlash_File::periodic_fullrate(const uint32_t now)
 {
     DataFlash_Backend::push_log_blocks();
+
+    const uint16_t removed = __atomic_load_n(&_housekeeping_removed, __ATOMIC_ACQUIRE);
+    if (removed != 0) {
+        // the IO thread removed an old log
+        _cached_oldest_log = 0;
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+        _read_ahead_reset();
+#endif
+#if DATAFLASH_FILE_LOG_INDEX
+        _index_update(removed);
+#endif
+        __atomic_store_n(&_housekeeping_removed, 0, __ATOMIC_RELEASE);
+    }
 }
 
 uint32_t DataFlash_File::bufferspace_available()
@@ -268,6 +335,39 @@ uint16_t DataFlash_File::find_oldest_log()
 
     uint16_t current_oldest_log = 0; // 0 is invalid
 
+#if DATAFLASH_FILE_LOG_INDEX
+    if (_index_ready()) {
+        // the oldest log is the first one after the last log
+        for (uint16_t n=1; n<=MAX_LOG_FILES; n++) {
+            const uint16_t log_num = (last_log_num + n - 1) % MAX_LOG_FILES + 1;
+            if (log_exists(log_num)) {
+                current_oldest_log = log_num;
+                break;
+            }
+        }
+        _cached_oldest_log = current_oldest_log;
+        return current_oldest_log;
+    }
+#endif
+
+    current_oldest_log = _scan_oldest_log(last_log_num);
+    _cached_oldest_log = current_oldest_log;
+
+    return current_oldest_log;
+#endif
+}
+
+/*
+  find the oldest log by reading the log directory. This doesn't use
+  the caches, so it is safe to call from the IO thread
+ */
+uint16_t DataFlash_File::_scan_oldest_log(const uint16_t last_log_num) const
+{
+#if DATAFLASH_FILE_MINIMAL
+    return 0;
+#else
+    uint16_t current_oldest_log = 0; // 0 is invalid
+
     // We could count up to find_last_log(), but if people start
     // relying on the min_avail_space_percent feature we could end up
     // doing a *lot* of asprintf()s and stat()s
@@ -313,7 +413,6 @@ uint16_t DataFlash_File::find_oldest_log()
         }
     }
     closedir(d);
-    _cached_oldest_log = current_oldest_log;
 
     return current_oldest_log;
 #endif
@@ -329,6 +428,9 @@ void DataFlash_File::Prep_MinSpace()
     }
 
     _cached_oldest_log = 0;
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+    _read_ahead_reset();
+#endif
 
     uint16_t log_to_remove = first_log_to_remove;
 
@@ -368,6 +470,12 @@ void DataFlash_File::Prep_MinSpace()
                 }
             } else {
                 free(filename_to_remove);
+#if DATAFLASH_FILE_SUMMARY
+                _summary_remove(log_to_remove);
+#endif
+#if DATAFLASH_FILE_LOG_INDEX
+                _index_update(log_to_remove);
+#endif
             }
         }
         log_to_remove++;
@@ -376,15 +484,140 @@ void DataFlash_File::Prep_MinSpace()
         }
     } while (log_to_remove != first_log_to_remove);
 }
+
+/*
+  remove old logs from the IO thread while disarmed, so Prep() doesn't
+  stall the main loop deleting files at arming. One log goes per pass,
+  and the main thread updates its caches before the next
+ */
+void DataFlash_File::_io_housekeeping(void)
+{
+    const uint32_t now = AP_HAL::micros();
+    if (now - _housekeeping_last_us < 1000000UL) {
+        return;
+    }
+    _housekeeping_last_us = now;
+
+    if (hal.util->get_soft_armed() || _read_fd != -1) {
+        return;
+    }
+
+#if DATAFLASH_FILE_PREALLOCATE
+    _prepare_next_log();
+#endif
+
+    if (__atomic_load_n(&_housekeeping_removed, __ATOMIC_ACQUIRE) != 0) {
+        // main thread hasn't seen the last removal yet
+        return;
+    }
+    const float avail = avail_space_percent();
+    if (is_equal(avail, -1.0f) || avail >= min_avail_space_percent) {
+        return;
+    }
+    const uint16_t last_log = _read_lastlog();
+    const uint16_t log_to_remove = _scan_oldest_log(last_log);
+    if (log_to_remove == 0 || log_to_remove == last_log) {
+        // never remove the log being written
+        return;
+    }
+    char *filename_to_remove = _log_file_name(log_to_remove);
+    if (filename_to_remove == NULL) {
+        return;
+    }
+    hal.console->printf("Removing (%s) for minimum-space requirements (%.2f%% < %.0f%%)\n",
+                        filename_to_remove, (double)avail, (double)min_avail_space_percent);
+    if (unlink(filename_to_remove) == -1) {
+        hal.console->printf("Failed to remove %s: %s\n", filename_to_remove, strerror(errno));
+    } else {
+#if DATAFLASH_FILE_SUMMARY
+        _summary_remove(log_to_remove);
+#endif
+        __atomic_store_n(&_housekeeping_removed, log_to_remove, __ATOMIC_RELEASE);
+    }
+    free(filename_to_remove);
+}
 #endif
 
+#if DATAFLASH_FILE_PREALLOCATE
+/*
+  name of the file prepared for the next log.
+  Note: Caller must free.
+ */
+char *DataFlash_File::_prepared_file_name() const
+{
+    char *buf = NULL;
+    if (asprintf(&buf, "%s/NEXT.TMP", _log_directory) == -1) {
+        return NULL;
+    }
+    return buf;
+}
+
+/*
+  create the file for the next log and reserve its first extent, so
+  starting a log at arming is just a rename. Called from the IO thread
+ */
+void DataFlash_File::_prepare_next_log(void)
+{
+    if (__atomic_load_n(&_prepared_fd, __ATOMIC_ACQUIRE) != -1) {
+        return;
+    }
+    if (disk_space_avail() < _free_space_min_avail + (int64_t)DATAFLASH_FILE_PREALLOCATE_EXTENT) {
+        return;
+    }
+    if (!semaphore->take_nonblocking()) {
+        return;
+    }
+    char *fname = _prepared_file_name();
+    if (fname != NULL) {
+        int fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+        free(fname);
+        if (fd != -1) {
+            // reserve the space without changing the file size, so
+            // the block count doesn't show up as log data
+            (void)fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, DATAFLASH_FILE_PREALLOCATE_EXTENT);
+            __atomic_store_n(&_prepared_fd, fd, __ATOMIC_RELEASE);
+        }
+    }
+    semaphore->give();
+}
+
+/*
+  rename the prepared file to fname and return its descriptor, or -1
+  if there isn't one
+ */
+int DataFlash_File::_open_prepared_log(const char *fname)
+{
+    if (!semaphore->take_nonblocking()) {
+        return -1;
+    }
+    int fd = __atomic_exchange_n(&_prepared_fd, -1, __ATOMIC_ACQ_REL);
+    semaphore->give();
+    if (fd == -1) {
+        return -1;
+    }
+    char *prepared = _prepared_file_name();
+    if (prepared == NULL || rename(prepared, fname) != 0) {
+        free(prepared);
+        ::close(fd);
+        return -1;
+    }
+    free(prepared);
+    _prealloc_end = DATAFLASH_FILE_PREALLOCATE_EXTENT;
+    return fd;
+}
+#endif // DATAFLASH_FILE_PREALLOCATE
+
 void DataFlash_File::Prep() {
     if (hal.util->get_soft_armed()) {
         // do not want to do any filesystem operations while we are e.g. flying
         return;
     }
 #if !DATAFLASH_FILE_MINIMAL
-    Prep_MinSpace();
+    // the IO thread removes old logs in the background, only stop to
+    // do it here if there isn't room to start a log at all
+    if (disk_space_avail() < _free_space_min_avail) {
+        Prep_MinSpace();
+    }
 #endif
 }
 
@@ -428,6 +661,113 @@ char *DataFlash_File::_lastlog_file_name(void) const
     return buf;
 }
 
+#if DATAFLASH_FILE_SUMMARY
+/*
+  construct a summary file name given a log number.
+  Note: Caller must free.
+ */
+char *DataFlash_File::_summary_file_name(const uint16_t log_num) const
+{
+    char *buf = NULL;
+    if (asprintf(&buf, "%s/%u.SUM", _log_directory, (unsigned)log_num) == 0) {
+        return NULL;
+    }
+    return buf;
+}
+
+/*
+  format the metrics of the current log for the IO thread to write.
+  Called from the main thread
+ */
+void DataFlash_File::_summary_queue(void)
+{
+    if (_summary_log_num == 0) {
+        return;
+    }
+    if (_summary_text == nullptr) {
+        // one half for the main thread, one for the IO thread
+        _summary_text = (char *)malloc(2 * DATAFLASH_SUMMARY_MAX_TEXT);
+        if (_summary_text == nullptr) {
+            return;
+        }
+        _summary_io_text = &_summary_text[DATAFLASH_SUMMARY_MAX_TEXT];
+    }
+    if (!semaphore->take(1)) {
+        return;
+    }
+    _summary_text_len = _summary.format(_summary_text, DATAFLASH_SUMMARY_MAX_TEXT);
+    _summary_text_log_num = _summary_log_num;
+    _summary_due = true;
+    semaphore->give();
+}
+
+/*
+  write out the last formatted summary. Called from the IO thread
+ */
+void DataFlash_File::_summary_write(void)
+{
+    if (!semaphore->take(1)) {
+        return;
+    }
+    const uint16_t len = _summary_text_len;
+    const uint16_t log_num = _summary_text_log_num;
+    memcpy(_summary_io_text, _summary_text, len);
+    _summary_due = false;
+    semaphore->give();
+
+    char *fname = _summary_file_name(log_num);
+    if (fname == NULL) {
+        return;
+    }
+    int fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    free(fname);
+    if (fd == -1) {
+        return;
+    }
+    if (::write(fd, _summary_io_text, len) != len) {
+        hal.util->perf_count(_perf_errors);
+    }
+    ::close(fd);
+}
+
+void DataFlash_File::_summary_remove(const uint16_t log_num) const
+{
+    char *fname = _summary_file_name(log_num);
+    if (fname != NULL) {
+        unlink(fname);
+        free(fname);
+    }
+}
+
+// print the summary of a log, if it has one
+void DataFlash_File::_summary_print(const uint16_t log_num, AP_HAL::BetterStream *port) const
+{
+    char *fname = _summary_file_name(log_num);
+    if (fname == NULL) {
+        return;
+    }
+    int fd = ::open(fname, O_RDONLY);
+    free(fname);
+    if (fd == -1) {
+        return;
+    }
+    uint8_t buf[128];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+        // the console wants CRLF line endings
+        ssize_t start = 0;
+        for (ssize_t i=0; i<n; i++) {
+            if (buf[i] == '\n') {
+                port->write(&buf[start], i - start);
+                port->println();
+                start = i + 1;
+            }
+        }
+        port->write(&buf[start], n - start);
+    }
+    ::close(fd);
+}
+#endif
 
 // remove all log files
 void DataFlash_File::EraseAll()
@@ -435,6 +775,10 @@ void DataFlash_File::EraseAll()
     uint16_t log_num;
     const bool was_logging = (_write_fd != -1);
     stop_logging();
+#if DATAFLASH_FILE_SUMMARY
+    // don't bring back the summary of the log stop_logging() closed
+    _summary_due = false;
+#endif
 #if !DATAFLASH_FILE_MINIMAL
     for (log_num=1; log_num<=MAX_LOG_FILES; log_num++) {
         char *fname = _log_file_name(log_num);
@@ -443,6 +787,9 @@ void DataFlash_File::EraseAll()
         }
         unlink(fname);
         free(fname);
+#if DATAFLASH_FILE_SUMMARY
+        _summary_remove(log_num);
+#endif
     }
     char *fname = _lastlog_file_name();
     if (fname != NULL) {
@@ -451,6 +798,16 @@ void DataFlash_File::EraseAll()
     }
 #endif
     _cached_oldest_log = 0;
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+    _read_ahead_reset();
+#endif
+#if DATAFLASH_FILE_LOG_INDEX
+    _index_changes++;
+    if (_index_ready()) {
+        memset(_index, 0, (MAX_LOG_FILES+1) * sizeof(_index[0]));
+        _index_last_log = 0;
+    }
+#endif
 
     if (was_logging) {
         start_new_log();
@@ -504,6 +861,13 @@ bool DataFlash_File::WritePrioritisedBlock(const void *pBuffer, uint16_t size, b
     }
 
     _writebuf.write((uint8_t*)pBuffer, size);
+#if DATAFLASH_FILE_SUMMARY
+    _summary.update((const uint8_t *)pBuffer, size);
+#endif
+    const uint32_t used = _writebuf.get_size() - (space - size);
+    if (used > _writebuf_hwm) {
+        _writebuf_hwm = used;
+    }
     semaphore->give();
     return true;
 }
@@ -530,6 +894,19 @@ bool DataFlash_File::ReadBlock(void *pkt, uint16_t size)
   find the highest log number
  */
 uint16_t DataFlash_File::find_last_log()
+{
+#if DATAFLASH_FILE_LOG_INDEX
+    if (_index_ready()) {
+        return _index_last_log;
+    }
+#endif
+    return _read_lastlog();
+}
+
+/*
+  read the highest log number from LASTLOG.TXT
+ */
+uint16_t DataFlash_File::_read_lastlog(void) const
 {
     unsigned ret = 0;
     char *fname = _lastlog_file_name();
@@ -549,11 +926,15 @@ uint16_t DataFlash_File::find_last_log()
     return ret;
 }
 
-uint32_t DataFlash_File::_get_log_size(const uint16_t log_num) const
+uint32_t DataFlash_File::_get_log_size(const uint16_t log_num)
 {
 #if DATAFLASH_FILE_MINIMAL
     return 1;
 #else
+    const struct log_index_entry *entry = _index_entry(log_num);
+    if (entry != nullptr) {
+        return entry->size;
+    }
     char *fname = _log_file_name(log_num);
     if (fname == NULL) {
         return 0;
@@ -568,11 +949,15 @@ uint32_t DataFlash_File::_get_log_size(const uint16_t log_num) const
 #endif
 }
 
-uint32_t DataFlash_File::_get_log_time(const uint16_t log_num) const
+uint32_t DataFlash_File::_get_log_time(const uint16_t log_num)
 {
 #if DATAFLASH_FILE_MINIMAL
     return 0;
 #else
+    const struct log_index_entry *entry = _index_entry(log_num);
+    if (entry != nullptr) {
+        return entry->time_utc;
+    }
     char *fname = _log_file_name(log_num);
     if (fname == NULL) {
         return 0;
@@ -668,6 +1053,13 @@ int16_t DataFlash_File::get_log_data(const uint16_t list_entry, const uint16_t p
     }
     uint32_t ofs = page * (uint32_t)DATAFLASH_PAGE_SIZE + offset;
 
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+    const int16_t ahead = _read_ahead_get(log_num, ofs, len, data);
+    if (ahead >= 0) {
+        return ahead;
+    }
+#endif
+
     /*
       this rather strange bit of code is here to work around a bug
       in file offsets in NuttX. Every few hundred blocks of reads
@@ -758,9 +1150,19 @@ uint16_t DataFlash_File::get_num_logs()
 void DataFlash_File::stop_logging(void)
 {
     if (_write_fd != -1) {
+#if DATAFLASH_FILE_SUMMARY
+        _summary_queue();
+#endif
         int fd = _write_fd;
         _write_fd = -1;
         log_write_started = false;
+#if DATAFLASH_FILE_PREALLOCATE
+        // give back the space reserved past the end of the log
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            (void)ftruncate(fd, st.st_size);
+        }
+#endif
         ::close(fd);
     }
 }
@@ -772,6 +1174,9 @@ void DataFlash_File::stop_logging(void)
 uint16_t DataFlash_File::start_new_log(void)
 {
     stop_logging();
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+    _read_ahead_reset();
+#endif
 
     start_new_log_reset_variables();
 
@@ -804,7 +1209,15 @@ uint16_t DataFlash_File::start_new_log(void)
     if (fname == NULL) {
         return 0xFFFF;
     }
-    _write_fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+#if DATAFLASH_FILE_PREALLOCATE
+    _write_fd = _open_prepared_log(fname);
+#endif
+    if (_write_fd == -1) {
+        _write_fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+#if DATAFLASH_FILE_PREALLOCATE
+        _prealloc_end = 0;
+#endif
+    }
     _cached_oldest_log = 0;
 
     if (_write_fd == -1) {
@@ -821,6 +1234,17 @@ uint16_t DataFlash_File::start_new_log(void)
     free(fname);
     _write_offset = 0;
     _writebuf.clear();
+
+    _compress = _compress_start();
+    if (_compress) {
+        const ssize_t magic_len = DATAFLASH_LZ_FILE_MAGIC_LEN;
+        if (::write(_write_fd, DATAFLASH_LZ_FILE_MAGIC, magic_len) != magic_len) {
+            stop_logging();
+            _open_error = true;
+            return 0xFFFF;
+        }
+        _write_offset = magic_len;
+    }
     log_write_started = true;
 
     // now update lastlog.txt with the new log number
@@ -844,9 +1268,73 @@ uint16_t DataFlash_File::start_new_log(void)
         return 0xFFFF;
     }
 
+#if DATAFLASH_FILE_LOG_INDEX
+    // the previous last log is finished, so its entry can be trusted
+    // again
+    const uint16_t previous_log = find_last_log();
+    _index_last_log = log_num;
+    _index_update(previous_log);
+    _index_update(log_num);
+#endif
+
+#if DATAFLASH_FILE_SUMMARY
+    _summary_log_num = 0;
+    if (semaphore->take(1)) {
+        _summary.init(structure(0), num_types());
+        _summary_log_num = log_num;
+        _summary_last_ms = AP_HAL::millis();
+        semaphore->give();
+    }
+#endif
+
     return log_num;
 }
 
+/*
+  prepare for writing a compressed log if LOG_FILE_COMPRESS is set.
+  The buffers are only allocated the first time compression is used
+ */
+bool DataFlash_File::_compress_start(void)
+{
+    if (_front._params.file_compress == 0) {
+        return false;
+    }
+    if (_lz_buf == nullptr) {
+        _lz_buf = (uint8_t *)malloc(DATAFLASH_LZ_HEADER_LEN + _writebuf_chunk_max);
+        if (_lz_buf == nullptr) {
+            hal.console->printf("DataFlash_File: no memory for compression\n");
+            return false;
+        }
+    }
+    if (!_lz.init()) {
+        hal.console->printf("DataFlash_File: no memory for compression\n");
+        return false;
+    }
+    return true;
+}
+
+/*
+  write one compressed block holding len bytes of log data. Returns
+  len on success. A short write would leave a truncated block in the
+  file, so it is treated as an error
+ */
+ssize_t DataFlash_File::_write_compressed(const uint8_t *data, uint16_t len)
+{
+    uint8_t *out = &_lz_buf[DATAFLASH_LZ_HEADER_LEN];
+    uint16_t stored_len = _lz.compress(data, len, out, len - 1);
+    if (stored_len == 0) {
+        // incompressible; store it raw
+        memcpy(out, data, len);
+        stored_len = len;
+    }
+    DataFlash_LZ::pack_header(_lz_buf, len, stored_len);
+    const ssize_t to_write = DATAFLASH_LZ_HEADER_LEN + stored_len;
+    if (::write(_write_fd, _lz_buf, to_write) != to_write) {
+        return -1;
+    }
+    return len;
+}
+
 /*
   Read the log and print it on port
 */
@@ -880,14 +1368,21 @@ void DataFlash_File::LogReadProcess(const uint16_t list_entry,
     }
     _read_fd_log_num = log_num;
     _read_offset = 0;
-    if (start_page != 0) {
-        if (::lseek(_read_fd, start_page * DATAFLASH_PAGE_SIZE, SEEK_SET) == (off_t)-1) {
-            close(_read_fd);
-            _read_fd = -1;
-            return;
-        }
-        _read_offset = start_page * DATAFLASH_PAGE_SIZE;
+
+    char magic[DATAFLASH_LZ_FILE_MAGIC_LEN];
+    if (::read(_read_fd, magic, sizeof(magic)) == sizeof(magic) &&
+        memcmp(magic, DATAFLASH_LZ_FILE_MAGIC, sizeof(magic)) == 0) {
+        port->printf("Log %u is compressed\n", (unsigned)log_num);
+        ::close(_read_fd);
+        _read_fd = -1;
+        return;
+    }
+    if (::lseek(_read_fd, start_page * DATAFLASH_PAGE_SIZE, SEEK_SET) == (off_t)-1) {
+        close(_read_fd);
+        _read_fd = -1;
+        return;
     }
+    _read_offset = start_page * DATAFLASH_PAGE_SIZE;
 
     uint8_t log_counter = 0;
 
@@ -975,19 +1470,22 @@ void DataFlash_File::ListAvailableLogs(AP_HAL::BetterStream *port)
         uint16_t log_num = _log_num_from_list_entry(i);
         char *filename = _log_file_name(log_num);
         if (filename != NULL) {
-                struct stat st;
-                if (stat(filename, &st) == 0) {
-                    struct tm *tm = gmtime(&st.st_mtime);
-                    port->printf("Log %u in %s of size %u %u/%u/%u %u:%u\n",
-                                   (unsigned)i,
-                                   filename,
-                                   (unsigned)st.st_size,
-                                   (unsigned)tm->tm_year+1900,
-                                   (unsigned)tm->tm_mon+1,
-                                   (unsigned)tm->tm_mday,
-                                   (unsigned)tm->tm_hour,
-                                   (unsigned)tm->tm_min);
-                }
+            if (log_exists(log_num)) {
+                const time_t mtime = _get_log_time(log_num);
+                struct tm *tm = gmtime(&mtime);
+                port->printf("Log %u in %s of size %u %u/%u/%u %u:%u\n",
+                               (unsigned)i,
+                               filename,
+                               (unsigned)_get_log_size(log_num),
+                               (unsigned)tm->tm_year+1900,
+                               (unsigned)tm->tm_mon+1,
+                               (unsigned)tm->tm_mday,
+                               (unsigned)tm->tm_hour,
+                               (unsigned)tm->tm_min);
+#if DATAFLASH_FILE_SUMMARY
+                _summary_print(log_num, port);
+#endif
+            }
             free(filename);
         }
     }
@@ -1015,8 +1513,299 @@ void DataFlash_File::flush(void)
 }
 #endif
 
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+/*
+  serve a log download request from the read-ahead blocks, asking the
+  IO thread for the blocks after it. Returns -1 if the data isn't
+  there yet, in which case the caller reads it directly
+ */
+int16_t DataFlash_File::_read_ahead_get(const uint16_t log_num, const uint32_t ofs, const uint16_t len, uint8_t *data)
+{
+    if (_read_ahead_buf == nullptr) {
+        _read_ahead_buf = (uint8_t *)malloc(DATAFLASH_FILE_READ_AHEAD_BLOCKS * DATAFLASH_FILE_READ_AHEAD_SIZE);
+        if (_read_ahead_buf == nullptr) {
+            return -1;
+        }
+        for (uint8_t i=0; i<DATAFLASH_FILE_READ_AHEAD_BLOCKS; i++) {
+            _read_ahead[i].data = &_read_ahead_buf[i * DATAFLASH_FILE_READ_AHEAD_SIZE];
+        }
+    }
+
+    _read_ahead_request(log_num, ofs);
+
+    int16_t ret = _read_ahead_copy(log_num, ofs, len, data);
+    if (ret < 0) {
+        return -1;
+    }
+    if (ret < len && (ofs + ret) % DATAFLASH_FILE_READ_AHEAD_SIZE == 0) {
+        // the request straddles two blocks
+        const int16_t ret2 = _read_ahead_copy(log_num, ofs + ret, len - ret, &data[ret]);
+        if (ret2 < 0) {
+            return -1;
+        }
+        ret += ret2;
+    }
+    return ret;
+}
+
+/*
+  copy from the filled block holding ofs; a block shorter than
+  DATAFLASH_FILE_READ_AHEAD_SIZE ends at the end of the file
+ */
+int16_t DataFlash_File::_read_ahead_copy(const uint16_t log_num, const uint32_t ofs, const uint16_t len, uint8_t *data) const
+{
+    for (uint8_t i=0; i<DATAFLASH_FILE_READ_AHEAD_BLOCKS; i++) {
+        const struct read_ahead_block &b = _read_ahead[i];
+        if (__atomic_load_n(&b.state, __ATOMIC_ACQUIRE) != READ_AHEAD_FULL ||
+            b.generation != _read_ahead_generation ||
+            b.log_num != log_num ||
+            ofs < b.ofs || ofs >= b.ofs + DATAFLASH_FILE_READ_AHEAD_SIZE) {
+            continue;
+        }
+        if (b.len < 0) {
+            // read failed; let the caller find out why
+            return -1;
+        }
+        const uint32_t start = ofs - b.ofs;
+        if (start >= (uint32_t)b.len) {
+            return 0;
+        }
+        const uint16_t n = MIN(len, b.len - start);
+        memcpy(data, &b.data[start], n);
+        return n;
+    }
+    return -1;
+}
+
+/*
+  make sure the blocks from the one holding ofs onwards are filled or
+  being filled, reusing blocks the download has moved past
+ */
+void DataFlash_File::_read_ahead_request(const uint16_t log_num, const uint32_t ofs)
+{
+    const uint32_t base = ofs - (ofs % DATAFLASH_FILE_READ_AHEAD_SIZE);
+    const uint32_t end = base + DATAFLASH_FILE_READ_AHEAD_BLOCKS * DATAFLASH_FILE_READ_AHEAD_SIZE;
+
+    for (uint8_t n=0; n<DATAFLASH_FILE_READ_AHEAD_BLOCKS; n++) {
+        const uint32_t want = base + n * DATAFLASH_FILE_READ_AHEAD_SIZE;
+        bool held = false;
+        int8_t spare = -1;
+        for (uint8_t i=0; i<DATAFLASH_FILE_READ_AHEAD_BLOCKS; i++) {
+            struct read_ahead_block &b = _read_ahead[i];
+            const uint8_t state = __atomic_load_n(&b.state, __ATOMIC_ACQUIRE);
+            const bool current = (state != READ_AHEAD_FREE &&
+                                  b.generation == _read_ahead_generation &&
+                                  b.log_num == log_num);
+            if (current && b.ofs == want) {
+                held = true;
+                break;
+            }
+            if (state == READ_AHEAD_WANTED) {
+                continue;
+            }
+            if (!current || b.ofs < base || b.ofs >= end) {
+                spare = i;
+            }
+        }
+        if (held || spare == -1) {
+            continue;
+        }
+        struct read_ahead_block &b = _read_ahead[spare];
+        b.generation = _read_ahead_generation;
+        b.log_num = log_num;
+        b.ofs = want;
+        __atomic_store_n(&b.state, READ_AHEAD_WANTED, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+  forget what has been read ahead, as log numbers are about to be
+  reused. Blocks still being read are ignored when they arrive
+ */
+void DataFlash_File::_read_ahead_reset(void)
+{
+    _read_ahead_generation++;
+    for (uint8_t i=0; i<DATAFLASH_FILE_READ_AHEAD_BLOCKS; i++) {
+        if (__atomic_load_n(&_read_ahead[i].state, __ATOMIC_ACQUIRE) == READ_AHEAD_FULL) {
+            __atomic_store_n(&_read_ahead[i].state, READ_AHEAD_FREE, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/*
+  fill the blocks the main thread has asked for. Called from the IO
+  thread
+ */
+void DataFlash_File::_read_ahead_service(void)
+{
+    for (uint8_t i=0; i<DATAFLASH_FILE_READ_AHEAD_BLOCKS; i++) {
+        struct read_ahead_block &b = _read_ahead[i];
+        if (__atomic_load_n(&b.state, __ATOMIC_ACQUIRE) != READ_AHEAD_WANTED) {
+            continue;
+        }
+        if (_read_ahead_fd != -1 &&
+            (_read_ahead_fd_log_num != b.log_num || _read_ahead_fd_generation != b.generation)) {
+            ::close(_read_ahead_fd);
+            _read_ahead_fd = -1;
+        }
+        if (_read_ahead_fd == -1) {
+            char *fname = _log_file_name(b.log_num);
+            if (fname != nullptr) {
+                _read_ahead_fd = ::open(fname, O_RDONLY);
+                free(fname);
+            }
+            _read_ahead_fd_log_num = b.log_num;
+            _read_ahead_fd_generation = b.generation;
+        }
+        if (_read_ahead_fd == -1) {
+            b.len = -1;
+        } else {
+            b.len = (int16_t)::pread(_read_ahead_fd, b.data, DATAFLASH_FILE_READ_AHEAD_SIZE, b.ofs);
+        }
+        __atomic_store_n(&b.state, READ_AHEAD_FULL, __ATOMIC_RELEASE);
+    }
+}
+#endif // DATAFLASH_FILE_READ_AHEAD_BLOCKS
+
+#if DATAFLASH_FILE_LOG_INDEX
+/*
+  adopt the index built by the IO thread, if there is one. Returns
+  true if the index can be used
+ */
+bool DataFlash_File::_index_ready(void)
+{
+    if (_index != nullptr) {
+        return true;
+    }
+    struct log_index_entry *pending = __atomic_load_n(&_index_pending, __ATOMIC_ACQUIRE);
+    if (pending == nullptr) {
+        return false;
+    }
+    if (_index_pending_changes == _index_changes) {
+        _index = pending;
+        _index_last_log = _index_pending_last_log;
+    } else {
+        // logs came or went during the scan
+        free(pending);
+    }
+    __atomic_store_n(&_index_pending, (struct log_index_entry *)nullptr, __ATOMIC_RELEASE);
+    if (_index == nullptr) {
+        _index_wanted = true;
+    }
+    return _index != nullptr;
+}
+
+/*
+  index entry for a finished log, or nullptr if the card has to be
+  asked
+ */
+const struct DataFlash_File::log_index_entry *DataFlash_File::_index_entry(const uint16_t log_num)
+{
+    if (log_num == 0 || log_num > MAX_LOG_FILES || !_index_ready() ||
+        log_num == _index_last_log) {
+        return nullptr;
+    }
+    return &_index[log_num];
+}
+
+/*
+  refresh the entry for a log that has been created or removed
+ */
+void DataFlash_File::_index_update(const uint16_t log_num)
+{
+    _index_changes++;
+    if (log_num == 0 || log_num > MAX_LOG_FILES || !_index_ready()) {
+        return;
+    }
+    struct log_index_entry &entry = _index[log_num];
+    memset(&entry, 0, sizeof(entry));
+    char *fname = _log_file_name(log_num);
+    if (fname == NULL) {
+        return;
+    }
+    struct stat st;
+    if (::stat(fname, &st) == 0) {
+        entry.exists = true;
+        entry.size = st.st_size;
+        entry.time_utc = st.st_mtime;
+    }
+    free(fname);
+}
+
+/*
+  scan the log directory once into a new index. Called from the IO
+  thread
+ */
+void DataFlash_File::_index_build(void)
+{
+    const uint16_t changes = _index_changes;
+    struct log_index_entry *index = (struct log_index_entry *)calloc(MAX_LOG_FILES+1, sizeof(*index));
+    if (index == nullptr) {
+        // carry on without an index
+        _index_wanted = false;
+        return;
+    }
+    DIR *d = opendir(_log_directory);
+    if (d == NULL) {
+        free(index);
+        return;
+    }
+    for (struct dirent *de=readdir(d); de; de=readdir(d)) {
+        uint8_t length = strlen(de->d_name);
+        if (length < 5 || strncmp(&de->d_name[length-4], ".BIN", 4)) {
+            // not \d+[.]BIN
+            continue;
+        }
+        const uint16_t log_num = strtoul(de->d_name, NULL, 10);
+        if (log_num == 0 || log_num > MAX_LOG_FILES) {
+            continue;
+        }
+        char *fname = _log_file_name(log_num);
+        if (fname == NULL) {
+            continue;
+        }
+        struct stat st;
+        if (::stat(fname, &st) == 0) {
+            index[log_num].exists = true;
+            index[log_num].size = st.st_size;
+            index[log_num].time_utc = st.st_mtime;
+        }
+        free(fname);
+    }
+    closedir(d);
+
+    _index_pending_last_log = _read_lastlog();
+    _index_pending_changes = changes;
+    _index_wanted = false;
+    __atomic_store_n(&_index_pending, index, __ATOMIC_RELEASE);
+}
+#endif // DATAFLASH_FILE_LOG_INDEX
+
 void DataFlash_File::_io_timer(void)
 {
+#if DATAFLASH_FILE_SUMMARY
+    if (_summary_due) {
+        _summary_write();
+    }
+#endif
+#if DATAFLASH_FILE_LOG_INDEX
+    if (_initialised && _index_wanted &&
+        __atomic_load_n(&_index_pending, __ATOMIC_ACQUIRE) == nullptr) {
+        _index_build();
+    }
+#endif
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+    if (_initialised) {
+        // log download happens with logging stopped
+        _read_ahead_service();
+    }
+#endif
+#if !DATAFLASH_FILE_MINIMAL
+    if (_initialised && _write_fd == -1) {
+        _io_housekeeping();
+    }
+#endif
+
     if (_write_fd == -1 || !_initialised || _open_error) {
         return;
     }
@@ -1025,6 +1814,16 @@ void DataFlash_File::_io_timer(void)
     if (nbytes == 0) {
         return;
     }
+
+    // grow the write size while a backlog is building, so a slow
+    // card gets fewer, larger writes. Shrink it again once caught up
+    const uint32_t bufsize = _writebuf.get_size();
+    if (nbytes > bufsize/2 && _write_chunk < _writebuf_chunk_max) {
+        _write_chunk = MIN(_write_chunk * 2, _writebuf_chunk_max);
+    } else if (nbytes < bufsize/8 && _write_chunk > _writebuf_chunk) {
+        _write_chunk = MAX(_write_chunk / 2, _writebuf_chunk);
+    }
+
     uint32_t tnow = AP_HAL::micros();
     if (nbytes < _writebuf_chunk && 
         tnow - _last_write_time < 2000000UL) {
@@ -1045,24 +1844,51 @@ void DataFlash_File::_io_timer(void)
     hal.util->perf_begin(_perf_write);
 
     _last_write_time = tnow;
-    if (nbytes > _writebuf_chunk) {
+    if (nbytes > _write_chunk) {
         // be kind to the FAT PX4 filesystem
-        nbytes = _writebuf_chunk;
+        nbytes = _write_chunk;
     }
 
-    uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
+    ssize_t nwritten;
+    if (_compress) {
+        // compressed blocks need contiguous input; block sizes vary
+        // so there is no point aligning the writes
+        uint32_t contig;
+        const uint8_t *data = _writebuf.readptr(contig);
+        nbytes = MIN(nbytes, contig);
+        nwritten = _write_compressed(data, nbytes);
+    } else {
+#if !DATAFLASH_FILE_USE_WRITEV
+        uint32_t size;
+        const uint8_t *head = _writebuf.readptr(size);
+        nbytes = MIN(nbytes, size);
+#endif
+
+        // try to align writes on a 512 byte boundary to avoid filesystem reads
+        if ((nbytes + _write_offset) % 512 != 0) {
+            uint32_t ofs = (nbytes + _write_offset) % 512;
+            if (ofs < nbytes) {
+                nbytes -= ofs;
+            }
+        }
 
-    // try to align writes on a 512 byte boundary to avoid filesystem reads
-    if ((nbytes + _write_offset) % 512 != 0) {
-        uint32_t ofs = (nbytes + _write_offset) % 512;
-        if (ofs < nbytes) {
-            nbytes -= ofs;
+#if DATAFLASH_FILE_USE_WRITEV
+        // write straight from the ring buffer, in two parts if the data
+        // wraps around its end, so a wrapped chunk is not split into two
+        // short unaligned writes
+        ByteBuffer::IoVec vec[2];
+        struct iovec iov[2];
+        const uint8_t n_vec = _writebuf.peekiovec(vec, nbytes);
+        for (uint8_t i = 0; i < n_vec; i++) {
+            iov[i].iov_base = vec[i].data;
+            iov[i].iov_len = vec[i].len;
         }
+        nwritten = ::writev(_write_fd, iov, n_vec);
+#else
+        nwritten = ::write(_write_fd, head, nbytes);
+#endif
     }
 
-    ssize_t nwritten = ::write(_write_fd, head, nbytes);
     if (nwritten <= 0) {
         hal.util->perf_count(_perf_errors);
         close(_write_fd);
@@ -1071,6 +1897,18 @@ void DataFlash_File::_io_timer(void)
     } else {
         _write_offset += nwritten;
         _writebuf.advance(nwritten);
+#if DATAFLASH_FILE_PREALLOCATE
+        if (_write_offset + _writebuf_chunk_max > _prealloc_end) {
+            // reserve the next extent before the writes reach it
+            if (fallocate(_write_fd, FALLOC_FL_KEEP_SIZE, _prealloc_end,
+                          DATAFLASH_FILE_PREALLOCATE_EXTENT) == 0) {
+                _prealloc_end += DATAFLASH_FILE_PREALLOCATE_EXTENT;
+            } else {
+                // not supported by this filesystem, don't keep trying
+                _prealloc_end = UINT32_MAX;
+            }
+        }
+#endif
         /*
           the best strategy for minimizing corruption on microSD cards
           seems to be to write in 4k chunks and fsync the file on each
@@ -1078,12 +1916,101 @@ void DataFlash_File::_io_timer(void)
           write.
          */
 #if CONFIG_HAL_BOARD != HAL_BOARD_SITL && CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_QURT
-        ::fsync(_write_fd);
+        const uint32_t fsync_start = AP_HAL::micros();
+        if (_fsync_due(fsync_start, _writebuf.available())) {
+            hal.util->perf_begin(_perf_fsync);
+            ::fsync(_write_fd);
+            hal.util->perf_end(_perf_fsync);
+            const uint32_t fsync_end = AP_HAL::micros();
+            _fsync_avg_us = (_fsync_avg_us * 7 + (fsync_end - fsync_start)) / 8;
+            _last_fsync_us = fsync_end;
+        }
 #endif
+        _update_write_stats(AP_HAL::micros() - tnow);
     }
     hal.util->perf_end(_perf_write);
 }
 
+/*
+  decide whether to fsync after a write. While the card keeps up we
+  fsync every chunk. With a backlog, fsyncs are spaced so they take
+  roughly a tenth of the IO time at their measured cost, but never
+  more than a second apart
+ */
+bool DataFlash_File::_fsync_due(uint32_t now_us, uint32_t backlog) const
+{
+    if (backlog < _writebuf.get_size() / 4) {
+        return true;
+    }
+    const uint32_t interval = MIN(_fsync_avg_us * 10, 1000000UL);
+    return now_us - _last_fsync_us >= interval;
+}
+
+/*
+  record the time taken for one write (including any fsync)
+ */
+void DataFlash_File::_update_write_stats(uint32_t elapsed_us)
+{
+    static const uint32_t bucket_limits_us[DATAFLASH_FILE_LATENCY_BUCKETS-1] = {
+        1000, 2000, 5000, 10000, 20000, 50000
+    };
+    uint8_t b = 0;
+    while (b < DATAFLASH_FILE_LATENCY_BUCKETS-1 && elapsed_us >= bucket_limits_us[b]) {
+        b++;
+    }
+    _write_latency_hist[b]++;
+    if (elapsed_us > _write_max_us) {
+        _write_max_us = elapsed_us;
+    }
+}
+
+/*
+  log buffer high-water mark and write latency statistics so SD cards
+  can be qualified. The latency buckets are cumulative counts of
+  writes taking <1, <2, <5, <10, <20, <50 and >=50 milliseconds
+ */
+void DataFlash_File::periodic_1Hz(const uint32_t now)
+{
+    DataFlash_Backend::periodic_1Hz(now);
+
+    if (!log_write_started || !_initialised || _open_error) {
+        return;
+    }
+    if (!semaphore->take(1)) {
+        return;
+    }
+    const uint32_t hwm = _writebuf_hwm;
+    _writebuf_hwm = 0;
+    semaphore->give();
+
+    const uint32_t max_us = _write_max_us;
+    _write_max_us = 0;
+
+#if DATAFLASH_FILE_SUMMARY
+    if (now - _summary_last_ms >= DATAFLASH_FILE_SUMMARY_INTERVAL_MS) {
+        _summary_last_ms = now;
+        _summary_queue();
+    }
+#endif
+
+    _front.Log_Write("DFIO",
+                     "TimeUS,Hwm,Size,Chunk,Drop,Max,L1,L2,L5,L10,L20,L50,LHi",
+                     "QIIHIIIIIIIII",
+                     AP_HAL::micros64(),
+                     hwm,
+                     _writebuf.get_size(),
+                     _write_chunk,
+                     num_dropped(),
+                     max_us,
+                     _write_latency_hist[0],
+                     _write_latency_hist[1],
+                     _write_latency_hist[2],
+                     _write_latency_hist[3],
+                     _write_latency_hist[4],
+                     _write_latency_hist[5],
+                     _write_latency_hist[6]);
+}
+
 // this sensor is enabled if we should be logging at the moment
 bool DataFlash_File::logging_enabled() const
 {
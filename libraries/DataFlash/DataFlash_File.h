@@ -10,6 +10,8 @@
 
 #include <AP_HAL/utility/RingBuffer.h>
 #include "DataFlash_Backend.h"
+#include "DataFlash_LZ.h"
+#include "DataFlash_Summary.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_QURT
 /*
@@ -23,6 +25,44 @@
 #define DATAFLASH_FILE_MINIMAL 0
 #endif
 
+// use writev() to write log data that wraps around the end of the
+// write buffer in a single system call
+#ifndef DATAFLASH_FILE_USE_WRITEV
+#define DATAFLASH_FILE_USE_WRITEV (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// number of buckets in the write latency histogram
+#define DATAFLASH_FILE_LATENCY_BUCKETS 7
+
+// blocks of the log being downloaded that the IO thread reads ahead
+// of the requests, so LOG_DATA can be sent without the main thread
+// waiting on the card
+#ifndef DATAFLASH_FILE_READ_AHEAD_BLOCKS
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define DATAFLASH_FILE_READ_AHEAD_BLOCKS 4
+#else
+#define DATAFLASH_FILE_READ_AHEAD_BLOCKS 0
+#endif
+#endif
+#define DATAFLASH_FILE_READ_AHEAD_SIZE 4096U
+
+// keep the size and time of every log in memory, so listing logs
+// doesn't stat each file
+#define DATAFLASH_FILE_LOG_INDEX (!DATAFLASH_FILE_MINIMAL)
+
+// create the next log file ahead of time in the IO thread, and reserve
+// space for a log in large extents as it grows, so the filesystem
+// isn't allocating blocks on every write
+#ifndef DATAFLASH_FILE_PREALLOCATE
+#define DATAFLASH_FILE_PREALLOCATE (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+#define DATAFLASH_FILE_PREALLOCATE_EXTENT (4*1024*1024UL)
+
+// keep flight metrics for each log in a small NN.SUM text file next
+// to it, so a flight can be judged without downloading the log
+#define DATAFLASH_FILE_SUMMARY (!DATAFLASH_FILE_MINIMAL)
+#define DATAFLASH_FILE_SUMMARY_INTERVAL_MS 10000
+
 class DataFlash_File : public DataFlash_Backend
 {
 public:
@@ -65,6 +105,7 @@ public:
     void flush(void);
 #endif
     void periodic_fullrate(const uint32_t now);
+    void periodic_1Hz(const uint32_t now) override;
 
     // this method is used when reporting system status over mavlink
     bool logging_enabled() const;
@@ -82,6 +123,26 @@ private:
 
     uint16_t _cached_oldest_log;
 
+    /*
+      the IO thread removes old logs while disarmed, one at a time,
+      and hands each removed log number to the main thread so it can
+      update its caches before the next one goes
+     */
+    uint32_t _housekeeping_last_us;
+    volatile uint16_t _housekeeping_removed;
+    void _io_housekeeping(void);
+
+#if DATAFLASH_FILE_PREALLOCATE
+    // the file prepared for the next log, owned by whichever thread
+    // holds the semaphore
+    int _prepared_fd;
+    // end of the space reserved for the log being written
+    uint32_t _prealloc_end;
+    char *_prepared_file_name() const;
+    void _prepare_next_log(void);
+    int _open_prepared_log(const char *fname);
+#endif
+
     /*
       read a block
     */
@@ -92,12 +153,13 @@ private:
     // possibly time-consuming preparations handling
     void Prep_MinSpace();
     uint16_t find_oldest_log();
+    uint16_t _scan_oldest_log(uint16_t last_log_num) const;
     int64_t disk_space_avail();
     int64_t disk_space();
     float avail_space_percent();
 
     bool file_exists(const char *filename) const;
-    bool log_exists(const uint16_t lognum) const;
+    bool log_exists(const uint16_t lognum);
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
     // I always seem to have less than 10% free space on my laptop:
@@ -107,22 +169,131 @@ private:
 #endif
     // write buffer
     ByteBuffer _writebuf;
+    // writes are at least _writebuf_chunk bytes (unless data has been
+    // waiting a while), and grow up to _writebuf_chunk_max while the
+    // card is falling behind
     const uint16_t _writebuf_chunk;
+    const uint16_t _writebuf_chunk_max;
     uint32_t _last_write_time;
+    uint16_t _write_chunk;
+
+    // fsync scheduling
+    uint32_t _last_fsync_us;
+    uint32_t _fsync_avg_us;
+    bool _fsync_due(uint32_t now_us, uint32_t backlog) const;
+
+    // IO statistics logged as DFIO messages
+    uint32_t _writebuf_hwm;
+    uint32_t _write_max_us;
+    uint32_t _write_latency_hist[DATAFLASH_FILE_LATENCY_BUCKETS];
+    void _update_write_stats(uint32_t elapsed_us);
 
     /* construct a file name given a log number. Caller must free. */
     char *_log_file_name(const uint16_t log_num) const;
     char *_lastlog_file_name() const;
-    uint32_t _get_log_size(const uint16_t log_num) const;
-    uint32_t _get_log_time(const uint16_t log_num) const;
+    uint32_t _get_log_size(const uint16_t log_num);
+    uint32_t _get_log_time(const uint16_t log_num);
+    uint16_t _read_lastlog(void) const;
+
+#if DATAFLASH_FILE_LOG_INDEX
+    struct log_index_entry {
+        uint32_t size;
+        uint32_t time_utc;
+        bool exists;
+    };
+    /*
+      indexed by log number. The IO thread scans the log directory
+      into _index_pending at startup and the main thread adopts it
+      unless logs changed during the scan. Only the main thread
+      touches _index. The last log may still be growing, so it is
+      always looked up on the card
+     */
+    struct log_index_entry *_index;
+    uint16_t _index_last_log;
+    struct log_index_entry *_index_pending;
+    uint16_t _index_pending_last_log;
+    uint16_t _index_pending_changes;
+    volatile uint16_t _index_changes;
+    volatile bool _index_wanted;
+
+    bool _index_ready(void);
+    const struct log_index_entry *_index_entry(uint16_t log_num);
+    void _index_update(uint16_t log_num);
+    void _index_build(void);
+#endif
+
+#if DATAFLASH_FILE_SUMMARY
+    /*
+      the metrics are gathered in WritePrioritisedBlock() under the
+      semaphore. The main thread formats them into _summary_text
+      every few seconds and when the log stops, and the IO thread
+      copies that out under the semaphore and writes the file
+     */
+    DataFlash_Summary _summary;
+    uint16_t _summary_log_num;
+    uint32_t _summary_last_ms;
+    char *_summary_text;
+    char *_summary_io_text;
+    uint16_t _summary_text_len;
+    uint16_t _summary_text_log_num;
+    volatile bool _summary_due;
+
+    char *_summary_file_name(const uint16_t log_num) const;
+    void _summary_queue(void);
+    void _summary_write(void);
+    void _summary_remove(const uint16_t log_num) const;
+    void _summary_print(const uint16_t log_num, AP_HAL::BetterStream *port) const;
+#endif
 
     void stop_logging(void);
 
     void _io_timer(void);
 
+#if DATAFLASH_FILE_READ_AHEAD_BLOCKS
+    /*
+      a block is handed between the threads through its state: the
+      main thread owns FREE and FULL blocks, the IO thread owns
+      WANTED blocks
+     */
+    enum read_ahead_state {
+        READ_AHEAD_FREE = 0,
+        READ_AHEAD_WANTED,
+        READ_AHEAD_FULL,
+    };
+    struct read_ahead_block {
+        uint8_t state;
+        uint8_t generation;
+        uint16_t log_num;
+        uint32_t ofs;
+        int16_t len;
+        uint8_t *data;
+    } _read_ahead[DATAFLASH_FILE_READ_AHEAD_BLOCKS];
+    uint8_t *_read_ahead_buf;
+    // bumped when log numbers may have been reused
+    uint8_t _read_ahead_generation;
+    // IO thread file descriptor
+    int _read_ahead_fd;
+    uint16_t _read_ahead_fd_log_num;
+    uint8_t _read_ahead_fd_generation;
+
+    int16_t _read_ahead_get(uint16_t log_num, uint32_t ofs, uint16_t len, uint8_t *data);
+    int16_t _read_ahead_copy(uint16_t log_num, uint32_t ofs, uint16_t len, uint8_t *data) const;
+    void _read_ahead_request(uint16_t log_num, uint32_t ofs);
+    void _read_ahead_reset(void);
+    void _read_ahead_service(void);
+#endif
+
+    // block compression of the log file, see LOG_FILE_COMPRESS
+    bool _compress;
+    DataFlash_LZ _lz;
+    uint8_t *_lz_buf;
+    bool _compress_start(void);
+    ssize_t _write_compressed(const uint8_t *data, uint16_t len);
+
     uint32_t critical_message_reserved_space() const {
-        // possibly make this a proportional to buffer size?
-        uint32_t ret = 1024;
+        // an eighth of the buffer, so bursts of ordinary messages
+        // while the card stalls can't crowd out critical ones
+        uint32_t ret = MIN(MAX(_writebuf.get_size() / 8, 1024U), 8192U);
         if (ret > _writebuf.get_size()) {
             // in this case you will only get critical messages
             ret = _writebuf.get_size();
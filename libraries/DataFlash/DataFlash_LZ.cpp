@@ -0,0 +1,214 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "DataFlash_LZ.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ_MIN_MATCH     4
+// the LZ4 block format requires the last 5 bytes to be literals, and
+// the last match to start at least 12 bytes before the end
+#define LZ_LAST_LITERALS 5
+#define LZ_MF_LIMIT      12
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+bool DataFlash_LZ::init()
+{
+    if (_table == nullptr) {
+        _table = (uint16_t *)calloc(1U << hash_bits, sizeof(uint16_t));
+    }
+    return _table != nullptr;
+}
+
+/*
+  write a variable length count of 15 or more as a run of bytes
+ */
+static inline uint8_t *put_length(uint8_t *op, uint32_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+uint16_t DataFlash_LZ::compress(const uint8_t *src, uint16_t len, uint8_t *dst, uint16_t dst_len)
+{
+    if (_table == nullptr) {
+        return 0;
+    }
+    memset(_table, 0, sizeof(uint16_t) << hash_bits);
+
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *const iend = src + len;
+    const uint8_t *const mflimit = len > LZ_MF_LIMIT ? iend - LZ_MF_LIMIT : src;
+    const uint8_t *const matchlimit = iend - (len > LZ_LAST_LITERALS ? LZ_LAST_LITERALS : len);
+    uint8_t *op = dst;
+    uint8_t *const oend = dst + dst_len;
+
+    while (ip < mflimit) {
+        const uint32_t seq = read32(ip);
+        const uint16_t h = (seq * 2654435761U) >> (32 - hash_bits);
+        const uint16_t pos = _table[h];
+        _table[h] = (ip - src) + 1;
+        if (pos == 0 || read32(src + pos - 1) != seq) {
+            ip++;
+            continue;
+        }
+        const uint8_t *ref = src + pos - 1;
+
+        // extend the match forwards
+        const uint8_t *mp = ip + LZ_MIN_MATCH;
+        const uint8_t *rp = ref + LZ_MIN_MATCH;
+        while (mp < matchlimit && *mp == *rp) {
+            mp++;
+            rp++;
+        }
+
+        const uint32_t lit_len = ip - anchor;
+        const uint32_t match_len = (mp - ip) - LZ_MIN_MATCH;
+        // worst case size of this sequence
+        const uint32_t need = 1 + lit_len/255 + 1 + lit_len + 2 + match_len/255 + 1;
+        if (need > (uint32_t)(oend - op)) {
+            return 0;
+        }
+
+        uint8_t *token = op++;
+        *token = (lit_len >= 15 ? 15 : lit_len) << 4;
+        if (lit_len >= 15) {
+            op = put_length(op, lit_len - 15);
+        }
+        memcpy(op, anchor, lit_len);
+        op += lit_len;
+
+        const uint16_t offset = ip - ref;
+        *op++ = offset & 0xFF;
+        *op++ = offset >> 8;
+
+        *token |= match_len >= 15 ? 15 : match_len;
+        if (match_len >= 15) {
+            op = put_length(op, match_len - 15);
+        }
+
+        ip = mp;
+        anchor = ip;
+    }
+
+    // trailing literals
+    const uint32_t lit_len = iend - anchor;
+    if (1 + lit_len/255 + 1 + lit_len > (uint32_t)(oend - op)) {
+        return 0;
+    }
+    *op++ = (lit_len >= 15 ? 15 : lit_len) << 4;
+    if (lit_len >= 15) {
+        op = put_length(op, lit_len - 15);
+    }
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    return op - dst;
+}
+
+/*
+  read a variable length count. Returns false on truncated input
+ */
+static inline bool get_length(const uint8_t *&ip, const uint8_t *iend, uint32_t &len)
+{
+    uint8_t b;
+    do {
+        if (ip >= iend) {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+int32_t DataFlash_LZ::decompress(const uint8_t *src, uint16_t len, uint8_t *dst, uint16_t dst_len)
+{
+    const uint8_t *ip = src;
+    const uint8_t *const iend = src + len;
+    uint8_t *op = dst;
+    uint8_t *const oend = dst + dst_len;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        uint32_t lit_len = token >> 4;
+        if (lit_len == 15 && !get_length(ip, iend, lit_len)) {
+            return -1;
+        }
+        if (lit_len > (uint32_t)(iend - ip) || lit_len > (uint32_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == iend) {
+            // the last sequence has no match
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        const uint16_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - dst) {
+            return -1;
+        }
+
+        uint32_t match_len = token & 0x0F;
+        if (match_len == 15 && !get_length(ip, iend, match_len)) {
+            return -1;
+        }
+        match_len += LZ_MIN_MATCH;
+        if (match_len > (uint32_t)(oend - op)) {
+            return -1;
+        }
+
+        // byte by byte as the match may overlap the output
+        const uint8_t *ref = op - offset;
+        while (match_len--) {
+            *op++ = *ref++;
+        }
+    }
+
+    return op - dst;
+}
+
+void DataFlash_LZ::pack_header(uint8_t *hdr, uint16_t raw_len, uint16_t stored_len)
+{
+    hdr[0] = raw_len & 0xFF;
+    hdr[1] = raw_len >> 8;
+    hdr[2] = stored_len & 0xFF;
+    hdr[3] = stored_len >> 8;
+}
+
+void DataFlash_LZ::unpack_header(const uint8_t *hdr, uint16_t &raw_len, uint16_t &stored_len)
+{
+    raw_len = hdr[0] | (hdr[1] << 8);
+    stored_len = hdr[2] | (hdr[3] << 8);
+}
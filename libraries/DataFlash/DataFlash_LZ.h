@@ -0,0 +1,75 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  small LZ77 block compressor for on-board logs.
+
+  The block format is the LZ4 block format: a sequence of tokens, each
+  a run of literal bytes followed by a back-reference of at least 4
+  bytes within the same block. This keeps the compressor cheap enough
+  to run in the IO thread and lets logs be decoded with stock tools.
+
+  A compressed log file starts with DATAFLASH_LZ_FILE_MAGIC and is
+  followed by blocks of the form:
+
+    uint16_t raw_len;     // bytes of log data in the block
+    uint16_t stored_len;  // bytes following this header
+    uint8_t  data[stored_len];
+
+  with both lengths little-endian. When stored_len == raw_len the data
+  is stored uncompressed.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define DATAFLASH_LZ_FILE_MAGIC     "APLZ"
+#define DATAFLASH_LZ_FILE_MAGIC_LEN 4
+#define DATAFLASH_LZ_HEADER_LEN     4
+
+// largest raw block the format can carry
+#define DATAFLASH_LZ_MAX_BLOCK      0xFFFF
+
+class DataFlash_LZ
+{
+public:
+    // allocate the match table. Returns false if out of memory
+    bool init();
+
+    bool initialised() const { return _table != nullptr; }
+
+    /*
+      compress len bytes from src into dst. Returns the compressed
+      length, or 0 if the output would not fit in dst_len bytes (the
+      caller should then store the block raw)
+     */
+    uint16_t compress(const uint8_t *src, uint16_t len, uint8_t *dst, uint16_t dst_len);
+
+    /*
+      decompress len bytes from src into dst. Returns the number of
+      bytes produced, or -1 if the input is malformed or does not fit
+      in dst_len bytes
+     */
+    static int32_t decompress(const uint8_t *src, uint16_t len, uint8_t *dst, uint16_t dst_len);
+
+    // write a block header for a block of raw_len bytes stored in stored_len bytes
+    static void pack_header(uint8_t *hdr, uint16_t raw_len, uint16_t stored_len);
+    static void unpack_header(const uint8_t *hdr, uint16_t &raw_len, uint16_t &stored_len);
+
+private:
+    static const uint8_t hash_bits = 12;
+
+    // position+1 of the last occurrence of each hashed 4-byte sequence
+    uint16_t *_table = nullptr;
+};
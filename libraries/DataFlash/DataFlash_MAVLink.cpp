@@ -27,6 +27,11 @@ void DataFlash_MAVLink::Init()
 {
     DataFlash_Backend::Init();
 
+    // size the pool from the free memory so boards with plenty to
+    // spare can have enough blocks in flight to cover the link latency
+    uint32_t count = hal.util->available_memory() / (DF_MAVLINK_MEMORY_FRACTION * sizeof(_blocks[0]));
+    _blockcount = constrain_int32(count, DF_MAVLINK_MIN_BLOCKS, DF_MAVLINK_MAX_BLOCKS);
+
     _blocks = NULL;
     while (_blockcount >= 8) { // 8 is a *magic* number
         _blocks = (struct dm_block *) malloc(_blockcount * sizeof(_blocks[0]));
@@ -40,6 +45,13 @@ void DataFlash_MAVLink::Init()
         return;
     }
 
+    // without the map blocks are found by walking the queues
+    _seqno_map_size = 2 * _blockcount;
+    _seqno_map = (struct dm_block **) calloc(_seqno_map_size, sizeof(_seqno_map[0]));
+    if (_seqno_map == NULL) {
+        _seqno_map_size = 0;
+    }
+
     free_all_blocks();
     stats_init();
 
@@ -66,40 +78,71 @@ uint8_t DataFlash_MAVLink::remaining_space_in_current_block() {
 
 void DataFlash_MAVLink::enqueue_block(dm_block_queue_t &queue, struct dm_block *block)
 {
+    block->next = NULL;
+    block->prev = queue.youngest;
     if (queue.youngest != NULL) {
         queue.youngest->next = block;
     } else {
         queue.oldest = block;
     }
     queue.youngest = block;
+    block->queue = &queue;
+    queue.count++;
 }
 
-struct DataFlash_MAVLink::dm_block *DataFlash_MAVLink::dequeue_seqno(DataFlash_MAVLink::dm_block_queue_t &queue, uint32_t seqno)
+// remove a block from whichever queue holds it
+void DataFlash_MAVLink::unlink_block(struct dm_block *block)
 {
-    struct dm_block *prev = NULL;
-    for (struct dm_block *block=queue.oldest; block != NULL; block=block->next) {
-        if (block->seqno == seqno) {
-            if (prev == NULL) {
-                if (queue.youngest == queue.oldest) {
-                    queue.oldest = NULL;
-                    queue.youngest = NULL;
-                } else {
-                    queue.oldest = block->next;
-                }
-            } else {
-                if (queue.youngest == block) {
-                    queue.youngest = prev;
-                }
-                prev->next = block->next;
-            }
-            block->next = NULL;
-            return block;
+    dm_block_queue_t &queue = *block->queue;
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        queue.oldest = block->next;
+    }
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    } else {
+        queue.youngest = block->prev;
+    }
+    block->next = NULL;
+    block->prev = NULL;
+    block->queue = NULL;
+    queue.count--;
+}
+
+// find the queued block carrying seqno
+struct DataFlash_MAVLink::dm_block *DataFlash_MAVLink::find_block(uint32_t seqno)
+{
+    if (_seqno_map_size != 0) {
+        struct dm_block *block = _seqno_map[seqno % _seqno_map_size];
+        if (block != NULL && block->seqno == seqno) {
+            // NULL queue means it is already free (e.g. a duplicate ack)
+            return (block->queue != NULL) ? block : NULL;
+        }
+        if (block == NULL) {
+            return NULL;
+        }
+        // the slot was reused by a later seqno; very old blocks can
+        // still be queued, so fall through to the search
+    }
+    for (uint8_t i=0; i<_blockcount; i++) {
+        if (_blocks[i].seqno == seqno && _blocks[i].queue != NULL) {
+            return &_blocks[i];
         }
-        prev = block;
     }
     return NULL;
 }
 
+struct DataFlash_MAVLink::dm_block *DataFlash_MAVLink::dequeue_seqno(DataFlash_MAVLink::dm_block_queue_t &queue, uint32_t seqno)
+{
+    struct dm_block *block = find_block(seqno);
+    if (block == NULL || !queue_has_block(queue, block)) {
+        return NULL;
+    }
+    unlink_block(block);
+    return block;
+}
+
 bool DataFlash_MAVLink::free_seqno_from_queue(uint32_t seqno, dm_block_queue_t &queue)
 {
     struct dm_block *block = dequeue_seqno(queue, seqno);
@@ -129,6 +172,7 @@ bool DataFlash_MAVLink::WritePrioritisedBlock(const void *pBuffer, uint16_t size
         if (_startup_messagewriter->finished()) {
             // do not count the startup packets as being dropped...
             dropped++;
+            _dropped++;
         }
         return false;
     }
@@ -174,6 +218,11 @@ struct DataFlash_MAVLink::dm_block *DataFlash_MAVLink::next_block()
         ret->seqno = _next_seq_num++;
         ret->last_sent = 0;
         ret->next = NULL;
+        ret->prev = NULL;
+        ret->queue = NULL;
+        if (_seqno_map_size != 0) {
+            _seqno_map[ret->seqno % _seqno_map_size] = ret;
+        }
         _latest_block_len = 0;
     }
     return ret;
@@ -184,16 +233,21 @@ void DataFlash_MAVLink::free_all_blocks()
     _blocks_free = NULL;
     _current_block = NULL;
 
-    _blocks_pending.sent_count = 0;
-    _blocks_pending.oldest = _blocks_pending.youngest = NULL;
-    _blocks_retry.sent_count = 0;
-    _blocks_retry.oldest = _blocks_retry.youngest = NULL;
-    _blocks_sent.sent_count = 0;
-    _blocks_sent.oldest = _blocks_sent.youngest = NULL;
+    memset(&_blocks_pending, 0, sizeof(_blocks_pending));
+    memset(&_blocks_retry, 0, sizeof(_blocks_retry));
+    memset(&_blocks_sent, 0, sizeof(_blocks_sent));
+    if (_seqno_map_size != 0) {
+        memset(_seqno_map, 0, _seqno_map_size * sizeof(_seqno_map[0]));
+    }
+
+    _send_window = DF_MAVLINK_INITIAL_WINDOW;
+    _last_window_decrease_ms = 0;
 
     // add blocks to the free stack:
     for(uint8_t i=0; i < _blockcount; i++) {
         _blocks[i].next = _blocks_free;
+        _blocks[i].prev = NULL;
+        _blocks[i].queue = NULL;
         _blocks_free = &_blocks[i];
         // this value doesn't really matter, but it stops valgrind
         // complaining when acking blocks (we check seqno before
@@ -248,10 +302,10 @@ void DataFlash_MAVLink::handle_ack(mavlink_channel_t chan,
         return;
     }
 
-    // check SENT blocks (VERY likely to be first on the list):
     if (free_seqno_from_queue(seqno, _blocks_sent)) {
         // celebrate
         _last_response_time = AP_HAL::millis();
+        window_increase();
     } else if(free_seqno_from_queue(seqno, _blocks_retry)) {
         // party
         _last_response_time = AP_HAL::millis();
@@ -282,6 +336,29 @@ void DataFlash_MAVLink::handle_retry(uint32_t seqno)
     if (victim != NULL) {
         _last_response_time = AP_HAL::millis();
         enqueue_block(_blocks_retry, victim);
+        window_decrease(_last_response_time);
+    }
+}
+
+// additive increase: one block per window's worth of acks
+void DataFlash_MAVLink::window_increase()
+{
+    _send_window += 1.0f / _send_window;
+    if (_send_window > _blockcount) {
+        _send_window = _blockcount;
+    }
+}
+
+// multiplicative decrease on loss, once per resend interval
+void DataFlash_MAVLink::window_decrease(uint32_t now)
+{
+    if (now - _last_window_decrease_ms < DF_MAVLINK_RESEND_MS) {
+        return;
+    }
+    _last_window_decrease_ms = now;
+    _send_window *= 0.5f;
+    if (_send_window < DF_MAVLINK_MIN_WINDOW) {
+        _send_window = DF_MAVLINK_MIN_WINDOW;
     }
 }
 
@@ -385,10 +462,6 @@ uint8_t DataFlash_MAVLink::stack_size(struct dm_block *stack)
     }
     return ret;
 }
-uint8_t DataFlash_MAVLink::queue_size(dm_block_queue_t queue)
-{
-    return stack_size(queue.oldest);
-}
 
 void DataFlash_MAVLink::stats_collect()
 {
@@ -446,16 +519,17 @@ bool DataFlash_MAVLink::send_log_blocks_from_queue(dm_block_queue_t &queue)
         if (sent_count++ > _max_blocks_per_send_blocks) {
             return false;
         }
-        if (! send_log_block(*queue.oldest)) {
+        if (_blocks_sent.count >= (uint8_t)_send_window) {
+            // window full; wait for acks
             return false;
         }
-        queue.sent_count++;
-        struct DataFlash_MAVLink::dm_block *tmp = dequeue_seqno(queue,queue.oldest->seqno);
-        if (tmp != NULL) { // should never be NULL
-            enqueue_block(_blocks_sent, tmp);
-        } else {
-            internal_error();
+        struct DataFlash_MAVLink::dm_block *tmp = queue.oldest;
+        if (! send_log_block(*tmp)) {
+            return false;
         }
+        queue.sent_count++;
+        unlink_block(tmp);
+        enqueue_block(_blocks_sent, tmp);
     }
     return true;
 }
@@ -487,17 +561,20 @@ void DataFlash_MAVLink::do_resends(uint32_t now)
     if (_blockcount < count_to_send) {
         count_to_send = _blockcount;
     }
-    uint32_t oldest = now - 100; // 100 milliseconds before resend.  Hmm.
-    while (count_to_send-- > 0) {
-        for (struct dm_block *block=_blocks_sent.oldest; block != NULL; block=block->next) {
-            // only want to send blocks every now-and-then:
-            if (block->last_sent < oldest) {
-                if (! send_log_block(*block)) {
-                    // failed to send the block; try again later....
-                    return;
-                }
-                stats.resends++;
+    uint32_t oldest = now - DF_MAVLINK_RESEND_MS;
+    for (struct dm_block *block=_blocks_sent.oldest;
+         block != NULL && count_to_send > 0;
+         block=block->next) {
+        // only want to send blocks every now-and-then:
+        if (block->last_sent < oldest) {
+            // an unacknowledged block is a loss the client didn't report
+            window_decrease(now);
+            if (! send_log_block(*block)) {
+                // failed to send the block; try again later....
+                return;
             }
+            stats.resends++;
+            count_to_send--;
         }
     }
 }
@@ -17,6 +17,18 @@ extern const AP_HAL::HAL& hal;
 
 #define DF_MAVLINK_DISABLE_INTERRUPTS 0
 
+// the block pool is sized to use at most this fraction of free memory
+#define DF_MAVLINK_MEMORY_FRACTION  4
+#define DF_MAVLINK_MIN_BLOCKS       32
+#define DF_MAVLINK_MAX_BLOCKS       255
+
+// limits of the congestion window, in unacknowledged blocks
+#define DF_MAVLINK_MIN_WINDOW       2
+#define DF_MAVLINK_INITIAL_WINDOW   8
+
+// blocks not acknowledged within this time are resent
+#define DF_MAVLINK_RESEND_MS        100
+
 class DataFlash_MAVLink : public DataFlash_Backend
 {
     friend class DataFlash_Class; // for access to stats on Log_Df_Mav_Stats
@@ -24,8 +36,8 @@ public:
     // constructor
     DataFlash_MAVLink(DataFlash_Class &front, DFMessageWriter_DFLogStart *writer) :
         DataFlash_Backend(front, writer),
-        _max_blocks_per_send_blocks(8),
-        _blockcount(32) // this may get reduced in Init if allocation fails
+        _max_blocks_per_send_blocks(32),
+        _blockcount(DF_MAVLINK_MIN_BLOCKS) // this may get changed in Init to fit memory
         ,_perf_packing(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DM_packing"))
         { }
 
@@ -71,11 +83,15 @@ public:
     //     BLOCK_STATE_SEND_RETRY,
     //     BLOCK_STATE_SENT
     // };
+    struct dm_block_queue;
     struct dm_block {
         uint32_t seqno;
         uint8_t buf[MAVLINK_MSG_REMOTE_LOG_DATA_BLOCK_FIELD_DATA_LEN];
         uint32_t last_sent;
         struct dm_block *next;
+        struct dm_block *prev;
+        // queue holding the block, NULL when free or being filled
+        struct dm_block_queue *queue;
     };
     void push_log_blocks();
     virtual bool send_log_block(struct dm_block &block);
@@ -86,20 +102,26 @@ public:
     virtual void remote_log_block_status_msg(mavlink_channel_t chan, mavlink_message_t* msg) override;
     void free_all_blocks();
 
-    // a stack for free blocks, queues for pending, sent, retries and sent
+    // a stack for free blocks, doubly linked queues for pending,
+    // sent and retry blocks so any block can be removed in O(1)
     struct dm_block_queue {
         uint32_t sent_count;
         struct dm_block *oldest;
         struct dm_block *youngest;
+        uint8_t count;
     };
     typedef struct dm_block_queue dm_block_queue_t ;
     void enqueue_block(dm_block_queue_t &queue, struct dm_block *block);
-    bool queue_has_block(dm_block_queue_t &queue, struct dm_block *block);
+    void unlink_block(struct dm_block *block);
+    bool queue_has_block(dm_block_queue_t &queue, struct dm_block *block) const {
+        return block->queue == &queue;
+    }
+    struct dm_block *find_block(uint32_t seqno);
     struct dm_block *dequeue_seqno(dm_block_queue_t &queue, uint32_t seqno);
     bool free_seqno_from_queue(uint32_t seqno, dm_block_queue_t &queue);
     bool send_log_blocks_from_queue(dm_block_queue_t &queue);
     uint8_t stack_size(struct dm_block *stack);
-    uint8_t queue_size(dm_block_queue_t queue);
+    uint8_t queue_size(const dm_block_queue_t &queue) const { return queue.count; }
     
     struct dm_block *_blocks_free;
     dm_block_queue_t _blocks_sent;
@@ -143,8 +165,25 @@ private:
     // means we will push at most 2*50*200 == 20KB of logs per second
     // _max_blocks_per_send_blocks has to be high enough to push all
     // of the logs, but low enough that we don't spend way too much
-    // time packing messages in any one loop
+    // time packing messages in any one loop. The rate actually sent
+    // is set by the congestion window below
     const uint8_t _max_blocks_per_send_blocks;
+
+    /*
+      congestion window: the number of blocks sent but not yet
+      acknowledged. It grows by one block per window of acks and
+      halves on loss (a retry request or a resend timeout), at most
+      once per resend interval so a burst of losses from one event
+      only counts once
+     */
+    float _send_window;
+    uint32_t _last_window_decrease_ms;
+    void window_increase();
+    void window_decrease(uint32_t now);
+
+    // seqno to block lookup, indexed by seqno modulo the map size
+    struct dm_block **_seqno_map;
+    uint16_t _seqno_map_size;
     
     uint32_t _next_seq_num;
     uint16_t _latest_block_len;
@@ -87,7 +87,12 @@ void DataFlash_SITL::WaitReady()
 	while(!ReadStatus());
 }
 
-void DataFlash_SITL::PageToBuffer(unsigned char BufferNum, uint16_t PageAdr)
+bool DataFlash_SITL::IsReady()
+{
+	return ReadStatus() != 0;
+}
+
+void DataFlash_SITL::PageToBuffer(unsigned char BufferNum, uint16_t PageAdr, unsigned char wait)
 {
     assert(PageAdr>=1);
 	pread(flash_fd, buffer[BufferNum], DF_PAGE_SIZE, (PageAdr-1)*DF_PAGE_SIZE);
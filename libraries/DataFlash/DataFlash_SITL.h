@@ -15,8 +15,9 @@ private:
     //Methods
     void              BufferWrite (uint8_t BufferNum, uint16_t IntPageAdr, uint8_t Data);
     void              BufferToPage (uint8_t BufferNum, uint16_t PageAdr, uint8_t wait);
-    void              PageToBuffer(uint8_t BufferNum, uint16_t PageAdr);
+    void              PageToBuffer(uint8_t BufferNum, uint16_t PageAdr, uint8_t wait);
     void              WaitReady();
+    bool              IsReady();
     uint8_t           ReadStatusReg();
     uint8_t           ReadStatus();
     uint16_t          PageSize();
@@ -0,0 +1,239 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DataFlash_Summary.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <AP_Math/AP_Math.h>
+
+const struct DataFlash_Summary::metric_def DataFlash_Summary::metric_defs[] = {
+    { "VIBE", "VibeX",   METRIC_MAX,     false },
+    { "VIBE", "VibeY",   METRIC_MAX,     false },
+    { "VIBE", "VibeZ",   METRIC_MAX,     false },
+    { "VIBE", "Clip0",   METRIC_LAST,    false },
+    { "VIBE", "Clip1",   METRIC_LAST,    false },
+    { "VIBE", "Clip2",   METRIC_LAST,    false },
+    // EKF2 velocity and position innovations, m/s and m
+    { "NKF3", "IVN",     METRIC_MAX_ABS, false },
+    { "NKF3", "IVE",     METRIC_MAX_ABS, false },
+    { "NKF3", "IVD",     METRIC_MAX_ABS, false },
+    { "NKF3", "IPN",     METRIC_MAX_ABS, false },
+    { "NKF3", "IPE",     METRIC_MAX_ABS, false },
+    { "NKF3", "IPD",     METRIC_MAX_ABS, false },
+    // EKF2 test ratios
+    { "NKF4", "SV",      METRIC_MAX,     false },
+    { "NKF4", "SP",      METRIC_MAX,     false },
+    { "NKF4", "SH",      METRIC_MAX,     false },
+    { "NKF4", "SM",      METRIC_MAX,     false },
+    // main loop overruns
+    { "PM",   "NLon",    METRIC_SUM,     false },
+    { "PM",   "NLoop",   METRIC_SUM,     false },
+    { "PM",   "MaxT",    METRIC_MAX,     false },
+    { "CURR", "Volt",    METRIC_MIN,     false },
+    { "CURR", "Curr",    METRIC_MAX,     false },
+    { "CURR", "CurrTot", METRIC_LAST,    false },
+    { "GPS",  "NSats",   METRIC_MIN,     true },
+    { "GPS",  "HDop",    METRIC_MAX,     true },
+};
+
+static const char *kind_names[] = { "max", "maxabs", "min", "last", "sum" };
+
+// size in a message of a field of the given format character, or 0
+static uint8_t field_size(char type)
+{
+    switch (type) {
+    case 'b': case 'B': case 'M':
+        return 1;
+    case 'c': case 'C': case 'h': case 'H':
+        return 2;
+    case 'e': case 'E': case 'f': case 'i': case 'I': case 'L': case 'n':
+        return 4;
+    case 'd': case 'q': case 'Q':
+        return 8;
+    case 'N':
+        return 16;
+    case 'Z':
+        return 64;
+    default:
+        return 0;
+    }
+}
+
+/*
+  find the offset and type of the field with the given label, walking
+  the comma separated labels alongside the format characters
+ */
+bool DataFlash_Summary::find_field(const struct LogStructure &s, const char *label, struct field &f)
+{
+    const size_t label_len = strlen(label);
+    const size_t num_fields = strnlen(s.format, sizeof(s.format));
+    const char *labels = s.labels;
+    const char *labels_end = s.labels + strnlen(s.labels, sizeof(s.labels));
+    uint16_t offset = LOG_PACKET_HEADER_LEN;
+
+    for (size_t i=0; i<num_fields && labels < labels_end; i++) {
+        const char *comma = (const char *)memchr(labels, ',', labels_end - labels);
+        const char *end = comma ? comma : labels_end;
+        if ((size_t)(end - labels) == label_len && strncmp(labels, label, label_len) == 0) {
+            if (field_size(s.format[i]) == 0 || offset > UINT8_MAX) {
+                return false;
+            }
+            f.msg_type = s.msg_type;
+            f.offset = offset;
+            f.type = s.format[i];
+            return true;
+        }
+        const uint8_t size = field_size(s.format[i]);
+        if (size == 0) {
+            return false;
+        }
+        offset += size;
+        labels = end + 1;
+    }
+    return false;
+}
+
+// read a numeric field, scaled to its logged units
+bool DataFlash_Summary::read_field(const uint8_t *msg, uint16_t size, const struct field &f, float &value)
+{
+    if (f.offset + field_size(f.type) > size) {
+        return false;
+    }
+    const uint8_t *p = &msg[f.offset];
+    switch (f.type) {
+    case 'b': { int8_t v;   memcpy(&v, p, sizeof(v)); value = v; break; }
+    case 'B':
+    case 'M': { uint8_t v;  memcpy(&v, p, sizeof(v)); value = v; break; }
+    case 'h': { int16_t v;  memcpy(&v, p, sizeof(v)); value = v; break; }
+    case 'H': { uint16_t v; memcpy(&v, p, sizeof(v)); value = v; break; }
+    case 'c': { int16_t v;  memcpy(&v, p, sizeof(v)); value = v * 0.01f; break; }
+    case 'C': { uint16_t v; memcpy(&v, p, sizeof(v)); value = v * 0.01f; break; }
+    case 'i':
+    case 'L': { int32_t v;  memcpy(&v, p, sizeof(v)); value = v; break; }
+    case 'I': { uint32_t v; memcpy(&v, p, sizeof(v)); value = v; break; }
+    case 'e': { int32_t v;  memcpy(&v, p, sizeof(v)); value = v * 0.01f; break; }
+    case 'E': { uint32_t v; memcpy(&v, p, sizeof(v)); value = v * 0.01f; break; }
+    case 'f': { float v;    memcpy(&v, p, sizeof(v)); value = v; break; }
+    default:
+        return false;
+    }
+    return true;
+}
+
+void DataFlash_Summary::init(const struct LogStructure *structures, uint8_t num_types)
+{
+    static_assert(ARRAY_SIZE(metric_defs) == NUM_METRICS, "NUM_METRICS doesn't match metric_defs");
+
+    memset(fields, 0, sizeof(fields));
+    memset(wanted, 0, sizeof(wanted));
+    memset(&gps_status, 0, sizeof(gps_status));
+
+    for (uint8_t i=0; i<num_types; i++) {
+        const struct LogStructure &s = structures[i];
+        for (uint8_t m=0; m<NUM_METRICS; m++) {
+            if (strncmp(s.name, metric_defs[m].msg, sizeof(s.name)) != 0) {
+                continue;
+            }
+            if (find_field(s, metric_defs[m].label, fields[m])) {
+                wanted[s.msg_type/8] |= 1U << (s.msg_type%8);
+            }
+            if (metric_defs[m].need_fix && gps_status.msg_type == 0) {
+                find_field(s, "Status", gps_status);
+            }
+        }
+    }
+    reset();
+}
+
+void DataFlash_Summary::reset(void)
+{
+    memset(values, 0, sizeof(values));
+    memset(have_value, 0, sizeof(have_value));
+    first_us = 0;
+    last_us = 0;
+}
+
+void DataFlash_Summary::update(const uint8_t *msg, uint16_t size)
+{
+    if (size < LOG_PACKET_HEADER_LEN) {
+        return;
+    }
+    const uint8_t msg_type = msg[2];
+    if (!(wanted[msg_type/8] & (1U << (msg_type%8)))) {
+        return;
+    }
+
+    last_us = AP_HAL::micros64();
+    if (first_us == 0) {
+        first_us = last_us;
+    }
+
+    bool have_fix = false;
+    if (msg_type == gps_status.msg_type) {
+        float status;
+        have_fix = read_field(msg, size, gps_status, status) && status >= 3;
+    }
+
+    for (uint8_t m=0; m<NUM_METRICS; m++) {
+        float v;
+        if (fields[m].msg_type != msg_type ||
+            (metric_defs[m].need_fix && !have_fix) ||
+            !read_field(msg, size, fields[m], v)) {
+            continue;
+        }
+        if (!have_value[m]) {
+            values[m] = (metric_defs[m].kind == METRIC_MAX_ABS) ? fabsf(v) : v;
+            have_value[m] = true;
+            continue;
+        }
+        switch (metric_defs[m].kind) {
+        case METRIC_MAX:
+            values[m] = MAX(values[m], v);
+            break;
+        case METRIC_MAX_ABS:
+            values[m] = MAX(values[m], fabsf(v));
+            break;
+        case METRIC_MIN:
+            values[m] = MIN(values[m], v);
+            break;
+        case METRIC_LAST:
+            values[m] = v;
+            break;
+        case METRIC_SUM:
+            values[m] += v;
+            break;
+        }
+    }
+}
+
+uint16_t DataFlash_Summary::format(char *buf, uint16_t buflen) const
+{
+    int len = snprintf(buf, buflen, "DURATION_S %.1f\n", (double)((last_us - first_us) * 1.0e-6f));
+    for (uint8_t m=0; m<NUM_METRICS && len >= 0 && len < buflen; m++) {
+        if (!have_value[m]) {
+            continue;
+        }
+        const struct metric_def &def = metric_defs[m];
+        len += snprintf(&buf[len], buflen - len, "%s.%s.%s %.2f\n",
+                        def.msg, def.label, kind_names[def.kind], (double)values[m]);
+    }
+    if (len < 0) {
+        return 0;
+    }
+    return MIN((uint16_t)len, (uint16_t)(buflen - 1));
+}
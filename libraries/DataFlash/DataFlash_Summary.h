@@ -0,0 +1,87 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  per-log flight metrics (vibration, EKF innovations and test ratios,
+  scheduler overruns, battery use, GPS quality), gathered from the
+  messages as they are logged so the log never has to be read back.
+
+  Fields are found by message name and label in the log structures,
+  so the metrics work with each vehicle's own PM message, and are
+  left out where a vehicle doesn't log them
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/AP_HAL.h>
+
+#include "LogStructure.h"
+
+// longest summary text format() produces
+#define DATAFLASH_SUMMARY_MAX_TEXT 768
+
+class DataFlash_Summary
+{
+public:
+    // find the fields of the metrics in the log structures
+    void init(const struct LogStructure *structures, uint8_t num_types);
+
+    // forget the metrics, for a new log
+    void reset(void);
+
+    // add a message that is being logged
+    void update(const uint8_t *msg, uint16_t size);
+
+    // write the metrics as "NAME VALUE" lines, returns the length
+    uint16_t format(char *buf, uint16_t buflen) const;
+
+private:
+    enum metric_kind {
+        METRIC_MAX,
+        METRIC_MAX_ABS,
+        METRIC_MIN,
+        METRIC_LAST,
+        METRIC_SUM,
+    };
+
+    struct metric_def {
+        const char *msg;
+        const char *label;
+        enum metric_kind kind;
+        bool need_fix;          // only with a 3D GPS fix
+    };
+    static const struct metric_def metric_defs[];
+    static const uint8_t NUM_METRICS = 24;
+
+    struct field {
+        uint8_t msg_type;
+        uint8_t offset;
+        char type;
+    };
+    struct field fields[NUM_METRICS] {};
+    float values[NUM_METRICS];
+    bool have_value[NUM_METRICS];
+
+    // the GPS status field, for need_fix metrics
+    struct field gps_status {};
+
+    // message types any metric is taken from
+    uint8_t wanted[256/8] {};
+
+    uint64_t first_us;
+    uint64_t last_us;
+
+    static bool find_field(const struct LogStructure &s, const char *label, struct field &f);
+    static bool read_field(const uint8_t *msg, uint16_t size, const struct field &f, float &value);
+};
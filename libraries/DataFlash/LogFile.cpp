@@ -5,6 +5,7 @@
 #include <AP_BattMonitor/AP_BattMonitor.h>
 #include <AP_Compass/AP_Compass.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Alloc.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_Motors/AP_Motors.h>
@@ -20,12 +21,30 @@
 
 extern const AP_HAL::HAL& hal;
 
+// the structures common to all vehicles are checked when the library
+// is built, so a structure can't disagree with its format string
+static constexpr struct LogStructure log_common_structures[] = {
+    LOG_COMMON_STRUCTURES
+};
+static_assert(log_structures_first_invalid(log_common_structures, ARRAY_SIZE(log_common_structures)) ==
+              ARRAY_SIZE(log_common_structures),
+              "log structure length or labels do not match its format");
+
 void DataFlash_Class::Init(const struct LogStructure *structures, uint8_t num_types)
 {
+    AP_Alloc::Tag alloc_tag("DataFlash");
+
     if (_next_backend == DATAFLASH_MAX_BACKENDS) {
         AP_HAL::panic("Too many backends");
         return;
     }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    // vehicle structures are only known here, check them in SITL
+    const uint16_t bad = log_structures_first_invalid(structures, num_types);
+    if (bad != num_types) {
+        AP_HAL::panic("Log structure %.4s does not match its format", structures[bad].name);
+    }
+#endif
     _num_types = num_types;
     _structures = structures;
 
@@ -1104,19 +1123,19 @@ void DataFlash_Class::Log_Write_AHRS2(AP_AHRS &ahrs)
 // Write a POS packet
 void DataFlash_Class::Log_Write_POS(AP_AHRS &ahrs)
 {
-    Location loc;
-    if (!ahrs.get_position(loc)) {
+    const AP_AHRS::nav_context &nav = ahrs.get_nav_context();
+    if (!nav.have_location) {
         return;
     }
-    Vector3f pos;
-    ahrs.get_relative_position_NED(pos);
+    const Location &loc = nav.location;
+    const float rel_alt = nav.have_relative_position_ned ? -nav.relative_position_ned.z : 0;
     struct log_POS pkt = {
         LOG_PACKET_HEADER_INIT(LOG_POS_MSG),
         time_us : AP_HAL::micros64(),
         lat     : loc.lat,
         lng     : loc.lng,
         alt     : loc.alt*1.0e-2f,
-        rel_alt : -pos.z
+        rel_alt : rel_alt
     };
     WriteBlock(&pkt, sizeof(pkt));
 }
@@ -1903,3 +1922,95 @@ void DataFlash_Class::Log_Write_Rally(const AP_Rally &rally)
         }
     }
 }
+
+// Write scheduler per-task timing statistics
+void DataFlash_Class::Log_Write_Scheduler(const AP_Scheduler &scheduler)
+{
+    const uint64_t now = AP_HAL::micros64();
+    for (uint8_t i=0; i<scheduler.get_num_tasks(); i++) {
+        const AP_Scheduler::TaskStats *stats = scheduler.task_stats(i);
+        if (stats == nullptr) {
+            return;
+        }
+        struct log_SchedTask pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_SCHED_MSG),
+            time_us         : now,
+            task            : i,
+            name            : {},
+            num_runs        : stats->num_runs,
+            min_time_us     : stats->min_time_us,
+            p50_us          : scheduler.task_percentile_us(i, 50),
+            p99_us          : scheduler.task_percentile_us(i, 99),
+            max_time_us     : stats->max_time_us,
+            budget_us       : scheduler.task_budget_us(i),
+            overruns        : stats->overruns,
+            skipped         : stats->skipped
+        };
+        strncpy(pkt.name, scheduler.task_name(i), sizeof(pkt.name));
+        WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+// Write the latency distribution of each HAL elapsed perf counter
+void DataFlash_Class::Log_Write_Perf_Counters()
+{
+    const uint64_t now = AP_HAL::micros64();
+    AP_HAL::Util::perf_counter_info info;
+    for (uint16_t i=0; hal.util->perf_get_info(i, info); i++) {
+        struct log_Perf pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_PERF_MSG),
+            time_us         : now,
+            name            : {},
+            count           : info.count,
+            p50_us          : info.p50_us,
+            p99_us          : info.p99_us,
+            p999_us         : info.p999_us,
+            max_us          : info.max_us
+        };
+        strncpy(pkt.name, info.name, sizeof(pkt.name));
+        WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+// Write the stack high-water mark and run-time statistics of each HAL thread
+void DataFlash_Class::Log_Write_Thread_Stats()
+{
+    const uint64_t now = AP_HAL::micros64();
+    AP_HAL::Util::thread_info info;
+    for (uint8_t i=0; hal.util->thread_get_info(i, info); i++) {
+        struct log_Thread pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_THREAD_MSG),
+            time_us              : now,
+            name                 : {},
+            stack_used           : info.stack_used,
+            stack_size           : info.stack_size,
+            cpu_ms               : info.cpu_ms,
+            voluntary_switches   : info.voluntary_switches,
+            involuntary_switches : info.involuntary_switches
+        };
+        strncpy(pkt.name, info.name, sizeof(pkt.name));
+        WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+#if HAL_INS_FFT_ENABLED
+// Write the strongest peaks of the gyro vibration spectrum
+void DataFlash_Class::Log_Write_GyroFFT(const AP_InertialSensor &ins)
+{
+    const AP_GyroFFT &fft = ins.get_gyro_fft();
+    if (!fft.enabled()) {
+        return;
+    }
+    struct log_GyroFFT pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_GYRO_FFT_MSG),
+        time_us     : AP_HAL::micros64(),
+        freq1       : fft.get_peak_freq_hz(0),
+        energy1     : fft.get_peak_energy(0),
+        freq2       : fft.get_peak_freq_hz(1),
+        energy2     : fft.get_peak_energy(1),
+        freq3       : fft.get_peak_freq_hz(2),
+        energy3     : fft.get_peak_energy(2)
+    };
+    WriteBlock(&pkt, sizeof(pkt));
+}
+#endif
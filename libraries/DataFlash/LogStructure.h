@@ -22,6 +22,65 @@ struct LogStructure {
     const char labels[64];
 };
 
+/*
+  compile time description of a log structure's layout, derived from
+  its format string (see the format characters near the end of this
+  file). These are constexpr so a table of structures can be checked
+  with static_assert: the message length has to match the packed size
+  of the fields and there has to be one label per field
+ */
+constexpr uint8_t log_field_size(char c)
+{
+    return (c == 'b' || c == 'B' || c == 'M') ? 1 :
+        (c == 'h' || c == 'H' || c == 'c' || c == 'C') ? 2 :
+        (c == 'i' || c == 'I' || c == 'e' || c == 'E' || c == 'L' ||
+         c == 'f' || c == 'n') ? 4 :
+        (c == 'd' || c == 'q' || c == 'Q') ? 8 :
+        (c == 'N') ? 16 :
+        (c == 'Z') ? 64 : 0;
+}
+
+// number of fields in a format, which need not be null terminated
+constexpr uint8_t log_format_fields(const char (&fmt)[16], uint8_t i=0)
+{
+    return (i < sizeof(fmt) && fmt[i] != 0) ? log_format_fields(fmt, i+1) : i;
+}
+
+// true if every field in a format is known
+constexpr bool log_format_known(const char (&fmt)[16], uint8_t i=0)
+{
+    return i == log_format_fields(fmt) ||
+        (log_field_size(fmt[i]) != 0 && log_format_known(fmt, i+1));
+}
+
+// packed size of the fields in a format
+constexpr uint16_t log_format_size(const char (&fmt)[16], uint8_t i=0)
+{
+    return (i == log_format_fields(fmt)) ? 0 :
+        log_field_size(fmt[i]) + log_format_size(fmt, i+1);
+}
+
+// number of comma separated labels
+constexpr uint8_t log_label_count(const char (&labels)[64], uint8_t i=0)
+{
+    return (i == sizeof(labels) || labels[i] == 0) ? (i == 0 ? 0 : 1) :
+        (labels[i] == ',') + log_label_count(labels, i+1);
+}
+
+constexpr bool log_structure_valid(const struct LogStructure &s)
+{
+    return log_format_known(s.format) &&
+        s.msg_len == LOG_PACKET_HEADER_LEN + log_format_size(s.format) &&
+        log_label_count(s.labels) == log_format_fields(s.format);
+}
+
+// index of the first invalid structure in a table, or num if all are valid
+constexpr uint16_t log_structures_first_invalid(const struct LogStructure *s, uint16_t num, uint16_t i=0)
+{
+    return (i == num || !log_structure_valid(s[i])) ? i :
+        log_structures_first_invalid(s, num, i+1);
+}
+
 /*
   log structures common to all vehicle types
  */
@@ -560,6 +619,15 @@ struct PACKED log_GPS_RAWS {
     uint8_t trkStat;
 };
 
+// a chunk of the byte stream received from a GPS, for post processing
+struct PACKED log_GPS_RAW_STREAM {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t instance;
+    uint8_t length;
+    uint8_t data[64];
+};
+
 struct PACKED log_GPS_SBF_EVENT {  
 	LOG_PACKET_HEADER; 
 	uint64_t time_us;
@@ -715,6 +783,54 @@ struct PACKED log_Rally {
 
 // #endif // SBP_HW_LOGGING
 
+struct PACKED log_SchedTask {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t  task;
+    char     name[16];
+    uint16_t num_runs;
+    uint16_t min_time_us;
+    uint16_t p50_us;
+    uint16_t p99_us;
+    uint16_t max_time_us;
+    uint16_t budget_us;
+    uint16_t overruns;
+    uint16_t skipped;
+};
+
+struct PACKED log_Perf {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    char     name[16];
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t p999_us;
+    uint32_t max_us;
+};
+
+struct PACKED log_Thread {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    char     name[16];
+    uint32_t stack_used;
+    uint32_t stack_size;
+    uint32_t cpu_ms;
+    uint32_t voluntary_switches;
+    uint32_t involuntary_switches;
+};
+
+struct PACKED log_GyroFFT {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    float    freq1;
+    float    energy1;
+    float    freq2;
+    float    energy2;
+    float    freq3;
+    float    energy3;
+};
+
 /*
 Format characters in the format string for binary log messages
   b   : int8_t
@@ -847,6 +963,8 @@ Format characters in the format string for binary log messages
       "GRXH", "QdHbBB", "TimeUS,rcvTime,week,leapS,numMeas,recStat" }, \
     { LOG_GPS_RAWS_MSG, sizeof(log_GPS_RAWS), \
       "GRXS", "QddfBBBHBBBBB", "TimeUS,prMes,cpMes,doMes,gnss,sv,freq,lock,cno,prD,cpD,doD,trk" }, \
+    { LOG_GPS_RAW_STREAM_MSG, sizeof(log_GPS_RAW_STREAM), \
+      "GRWS", "QBBZ", "TimeUS,I,Len,Data" }, \
     { LOG_GPS_SBF_EVENT_MSG, sizeof(log_GPS_SBF_EVENT), \
       "SBFE", "QIHBBdddfffff", "TimeUS,TOW,WN,Mode,Err,Lat,Lng,Height,Undul,Vn,Ve,Vu,COG" }, \
     { LOG_ESC1_MSG, sizeof(log_Esc), \
@@ -894,7 +1012,7 @@ Format characters in the format string for binary log messages
     { LOG_BAR2_MSG, sizeof(log_BARO), \
       "BAR2",  "QffcfIf", "TimeUS,Alt,Press,Temp,CRt,SMS,Offset" }, \
     { LOG_BAR3_MSG, sizeof(log_BARO), \
-      "BAR3",  "QffcfI", "TimeUS,Alt,Press,Temp,CRt,SMS" }, \
+      "BAR3",  "QffcfIf", "TimeUS,Alt,Press,Temp,CRt,SMS,Offset" }, \
     { LOG_VIBE_MSG, sizeof(log_Vibe), \
       "VIBE", "QfffIII",     "TimeUS,VibeX,VibeY,VibeZ,Clip0,Clip1,Clip2" }, \
     { LOG_IMUDT_MSG, sizeof(log_IMUDT), \
@@ -916,7 +1034,15 @@ Format characters in the format string for binary log messages
     { LOG_RATE_MSG, sizeof(log_Rate), \
       "RATE", "Qffffffffffff",  "TimeUS,RDes,R,ROut,PDes,P,POut,YDes,Y,YOut,ADes,A,AOut" }, \
     { LOG_RALLY_MSG, sizeof(log_Rally), \
-      "RALY", "QBBLLh", "TimeUS,Tot,Seq,Lat,Lng,Alt" }
+      "RALY", "QBBLLh", "TimeUS,Tot,Seq,Lat,Lng,Alt" }, \
+    { LOG_SCHED_MSG, sizeof(log_SchedTask), \
+      "SCHD", "QBNHHHHHHHH", "TimeUS,Id,Name,N,Min,P50,P99,Max,Bud,Ovr,Skp" }, \
+    { LOG_GYRO_FFT_MSG, sizeof(log_GyroFFT), \
+      "FTN", "Qffffff", "TimeUS,F1,E1,F2,E2,F3,E3" }, \
+    { LOG_PERF_MSG, sizeof(log_Perf), \
+      "PERF", "QNIIIII", "TimeUS,Name,N,P50,P99,P999,Max" }, \
+    { LOG_THREAD_MSG, sizeof(log_Thread), \
+      "THRD", "QNIIIII", "TimeUS,Name,Stk,StkSz,CPU,VCS,ICS" }
 
 // #if SBP_HW_LOGGING
 #define LOG_SBP_STRUCTURES \
@@ -1032,6 +1158,11 @@ enum LogMessages {
     LOG_GIMBAL3_MSG,
     LOG_RATE_MSG,
     LOG_RALLY_MSG,
+    LOG_SCHED_MSG,
+    LOG_GYRO_FFT_MSG,
+    LOG_PERF_MSG,
+    LOG_GPS_RAW_STREAM_MSG,
+    LOG_THREAD_MSG,
 };
 
 enum LogOriginType {
@@ -8,4 +8,6 @@
 #include "FilterWithBuffer.h"
 #include "LowPassFilter.h"
 #include "ModeFilter.h"
+#include "MedianFilter.h"
 #include "Butter.h"
+#include "WindowStats.h"
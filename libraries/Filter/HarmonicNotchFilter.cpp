@@ -0,0 +1,131 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HarmonicNotchFilter.h"
+
+template <class T>
+void HarmonicNotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB, uint8_t harmonics)
+{
+    _sample_freq_hz = sample_freq_hz;
+    _bandwidth_hz = bandwidth_hz;
+    _attenuation_dB = attenuation_dB;
+    _harmonics = harmonics;
+    update(center_freq_hz);
+}
+
+/*
+  recalculate each harmonic's notch. The filter state is kept so a
+  moving center frequency does not cause a transient. Harmonics at or
+  above the Nyquist frequency are left uninitialised and pass samples
+  straight through
+ */
+template <class T>
+void HarmonicNotchFilter<T>::update(float center_freq_hz)
+{
+    for (uint8_t i=0; i<HNF_MAX_HARMONICS; i++) {
+        if (_harmonics & (1U<<i)) {
+            const float mult = i + 1;
+            _filters[i].init(_sample_freq_hz, center_freq_hz * mult, _bandwidth_hz * mult, _attenuation_dB);
+        } else {
+            _filters[i].init(0, 0, 0, 0);
+        }
+    }
+}
+
+template <class T>
+T HarmonicNotchFilter<T>::apply(const T &sample)
+{
+    T output = sample;
+    for (uint8_t i=0; i<HNF_MAX_HARMONICS; i++) {
+        if (_filters[i].initialised()) {
+            output = _filters[i].apply(output);
+        }
+    }
+    return output;
+}
+
+template <class T>
+void HarmonicNotchFilter<T>::reset()
+{
+    for (uint8_t i=0; i<HNF_MAX_HARMONICS; i++) {
+        _filters[i].reset();
+    }
+}
+
+const AP_Param::GroupInfo HarmonicNotchFilterParams::var_info[] = {
+    // @Param: ENABLE
+    // @DisplayName: Enable
+    // @Description: Enable harmonic notch filter
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO_FLAGS("ENABLE", 1, HarmonicNotchFilterParams, _enable, 0, AP_PARAM_FLAG_ENABLE),
+
+    // @Param: FREQ
+    // @DisplayName: Base frequency
+    // @Description: Notch center frequency in Hz. With throttle or RPM tracking this is the lowest center frequency used, and with throttle tracking it is the frequency at the reference throttle
+    // @Range: 10 400
+    // @Units: Hz
+    // @User: Advanced
+    AP_GROUPINFO("FREQ", 2, HarmonicNotchFilterParams, _center_freq_hz, 80),
+
+    // @Param: BW
+    // @DisplayName: Bandwidth
+    // @Description: Notch bandwidth in Hz at the center frequency. Each harmonic has its bandwidth scaled with its frequency
+    // @Range: 5 100
+    // @Units: Hz
+    // @User: Advanced
+    AP_GROUPINFO("BW", 3, HarmonicNotchFilterParams, _bandwidth_hz, 40),
+
+    // @Param: ATT
+    // @DisplayName: Attenuation
+    // @Description: Notch attenuation in dB
+    // @Range: 5 50
+    // @Units: dB
+    // @User: Advanced
+    AP_GROUPINFO("ATT", 4, HarmonicNotchFilterParams, _attenuation_dB, 40),
+
+    // @Param: HMNCS
+    // @DisplayName: Harmonics
+    // @Description: Bitmask of harmonics to filter. The first harmonic is the center frequency itself
+    // @Bitmask: 0:1st harmonic,1:2nd harmonic,2:3rd harmonic
+    // @User: Advanced
+    AP_GROUPINFO("HMNCS", 5, HarmonicNotchFilterParams, _harmonics, 1),
+
+    // @Param: MODE
+    // @DisplayName: Tracking mode
+    // @Description: How the center frequency is kept on the motor noise. Throttle tracking scales the base frequency by the square root of throttle over the reference throttle. RPM tracking uses the first RPM sensor
+    // @Values: 0:Fixed,1:Throttle,2:RPM sensor
+    // @User: Advanced
+    AP_GROUPINFO("MODE", 6, HarmonicNotchFilterParams, _mode, TRACK_THROTTLE),
+
+    // @Param: REF
+    // @DisplayName: Reference throttle
+    // @Description: Throttle at which the motor noise is at the base frequency, used by throttle tracking. Zero uses the learned hover throttle
+    // @Range: 0 1
+    // @User: Advanced
+    AP_GROUPINFO("REF", 7, HarmonicNotchFilterParams, _reference, 0),
+
+    AP_GROUPEND
+};
+
+HarmonicNotchFilterParams::HarmonicNotchFilterParams(void)
+{
+    AP_Param::setup_object_defaults(this, var_info);
+}
+
+/*
+  instantiate template classes
+ */
+template class HarmonicNotchFilter<Vector3f>;
@@ -0,0 +1,81 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  a set of notch filters at a center frequency and its harmonics,
+  where the center frequency can move at runtime. Used to follow
+  motor noise as the motor speed changes
+ */
+
+#include "NotchFilter.h"
+
+#define HNF_MAX_HARMONICS 3
+
+template <class T>
+class HarmonicNotchFilter {
+public:
+    // set parameters. harmonics is a bitmask of the harmonics to
+    // filter, bit 0 being the center frequency itself. Each harmonic
+    // has its bandwidth scaled with it so all have the same shape
+    void init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB, uint8_t harmonics);
+    // move the center frequency, keeping the other parameters
+    void update(float center_freq_hz);
+    T apply(const T &sample);
+    void reset();
+
+private:
+    NotchFilter<T> _filters[HNF_MAX_HARMONICS];
+    float _sample_freq_hz;
+    float _bandwidth_hz;
+    float _attenuation_dB;
+    uint8_t _harmonics;
+};
+
+/*
+  harmonic notch filter parameters, shared by all instances of a
+  sensor type
+ */
+class HarmonicNotchFilterParams {
+public:
+    enum tracking_mode {
+        TRACK_FIXED    = 0, // center frequency is FREQ
+        TRACK_THROTTLE = 1, // center frequency follows the square root of throttle
+        TRACK_RPM      = 2, // center frequency follows the first RPM sensor
+    };
+
+    HarmonicNotchFilterParams(void);
+
+    bool enabled(void) const { return _enable; }
+    float center_freq_hz(void) const { return _center_freq_hz; }
+    float bandwidth_hz(void) const { return _bandwidth_hz; }
+    float attenuation_dB(void) const { return _attenuation_dB; }
+    uint8_t harmonics(void) const { return _harmonics; }
+    enum tracking_mode mode(void) const { return (enum tracking_mode)_mode.get(); }
+    float reference(void) const { return _reference; }
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+private:
+    AP_Int8 _enable;
+    AP_Int16 _center_freq_hz;
+    AP_Int16 _bandwidth_hz;
+    AP_Float _attenuation_dB;
+    AP_Int8 _harmonics;
+    AP_Int8 _mode;
+    AP_Float _reference;
+};
+
+typedef HarmonicNotchFilter<Vector3f> HarmonicNotchFilterVector3f;
@@ -0,0 +1,58 @@
+#include "LowPassFilter2pBank.h"
+
+template <uint8_t N>
+LowPassFilter2pBank<N>::LowPassFilter2pBank()
+{
+    memset(&_params, 0, sizeof(_params));
+    reset();
+}
+
+template <uint8_t N>
+void LowPassFilter2pBank<N>::set_cutoff_frequency(float sample_freq, float cutoff_freq)
+{
+    DigitalBiquadFilter<float>::compute_params(sample_freq, cutoff_freq, _params);
+}
+
+template <uint8_t N>
+void LowPassFilter2pBank<N>::apply(const float *sample, float *output)
+{
+    if (is_zero(_params.cutoff_freq) || is_zero(_params.sample_freq)) {
+        memcpy(output, sample, sizeof(float)*N);
+        return;
+    }
+
+    // local copies so the coefficients stay in registers for the loop
+    const float a1 = _params.a1;
+    const float a2 = _params.a2;
+    const float b0 = _params.b0;
+    const float b1 = _params.b1;
+    const float b2 = _params.b2;
+
+    for (uint8_t i=0; i<N; i++) {
+        const float delay_element_0 = sample[i] - _delay_element_1[i] * a1 - _delay_element_2[i] * a2;
+        output[i] = delay_element_0 * b0 + _delay_element_1[i] * b1 + _delay_element_2[i] * b2;
+        _delay_element_2[i] = _delay_element_1[i];
+        _delay_element_1[i] = delay_element_0;
+    }
+}
+
+template <uint8_t N>
+Vector3f LowPassFilter2pBank<N>::apply(const Vector3f &sample)
+{
+    static_assert(N == 3, "vector apply needs a three channel bank");
+    Vector3f output;
+    apply(&sample.x, &output.x);
+    return output;
+}
+
+template <uint8_t N>
+void LowPassFilter2pBank<N>::reset(void)
+{
+    memset(_delay_element_1, 0, sizeof(_delay_element_1));
+    memset(_delay_element_2, 0, sizeof(_delay_element_2));
+}
+
+/*
+  instantiate template classes
+ */
+template class LowPassFilter2pBank<3>;
@@ -0,0 +1,48 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  second order low pass filter over N channels sharing one set of
+  coefficients. The filter state is kept as one array per delay
+  element rather than per channel, so apply() is a single loop over
+  the channels with no temporaries, which the compiler can unroll and
+  vectorise. Filters the same as N LowPassFilter2p<float> objects
+ */
+
+#include "LowPassFilter2p.h"
+
+template <uint8_t N>
+class LowPassFilter2pBank {
+public:
+    LowPassFilter2pBank();
+    // change parameters
+    void set_cutoff_frequency(float sample_freq, float cutoff_freq);
+    // return the cutoff frequency
+    float get_cutoff_freq(void) const { return _params.cutoff_freq; }
+    float get_sample_freq(void) const { return _params.sample_freq; }
+    // filter one sample on each of the N channels
+    void apply(const float *sample, float *output);
+    // filter a vector, for banks of three channels
+    Vector3f apply(const Vector3f &sample);
+    void reset(void);
+
+private:
+    struct DigitalBiquadFilter<float>::biquad_params _params;
+    float _delay_element_1[N];
+    float _delay_element_2[N];
+};
+
+typedef LowPassFilter2pBank<3> LowPassFilter2pBank3f;
@@ -0,0 +1,215 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//
+/// @file	MedianFilter.h
+/// @brief	Median of the last FILTER_SIZE samples, updated in O(log n)
+///         per sample. Unlike ModeFilter the oldest sample is always
+///         the one dropped, so the output is the true median of a
+///         sliding window. For an even FILTER_SIZE, or while the window
+///         is filling to an even count, the upper middle sample is returned
+#pragma once
+
+#include <inttypes.h>
+#include "FilterClass.h"
+
+/*
+  the samples are kept in a ring buffer in arrival order and indexed
+  by a single array holding two heaps either side of the median: a
+  max-heap of the samples below it at negative positions and a min-heap
+  of the samples above it at positive positions, with the median itself
+  at position zero. A new sample replaces the oldest one in place and
+  is sifted through its heap, crossing over the median when needed.
+ */
+template <class T, uint8_t FILTER_SIZE>
+class MedianFilter : public Filter<T>
+{
+public:
+    MedianFilter() {
+        reset();
+    }
+
+    // apply - Add a new raw value to the filter, retrieve the filtered result
+    virtual T apply(T sample);
+
+    // get - get latest filtered value from filter (equal to the value returned by latest call to apply method)
+    T get() const {
+        return _output;
+    }
+
+    // reset - clear the filter
+    virtual void reset();
+
+    // get filter size
+    uint8_t get_filter_size() const {
+        return FILTER_SIZE;
+    }
+
+private:
+    // offset from a heap position to its index in _heap
+    static const int16_t HEAP_OFFSET = FILTER_SIZE / 2;
+
+    // number of samples in the min-heap and the max-heap
+    int16_t min_count() const { return (_count - 1) / 2; }
+    int16_t max_count() const { return _count / 2; }
+
+    uint8_t &heap(int16_t i) { return _heap[i + HEAP_OFFSET]; }
+    const T &value(int16_t i) const { return _samples[_heap[i + HEAP_OFFSET]]; }
+
+    bool less(int16_t i, int16_t j) const { return value(i) < value(j); }
+    bool swap_if_less(int16_t i, int16_t j);
+
+    void min_sort_down(int16_t i);
+    void max_sort_down(int16_t i);
+    bool min_sort_up(int16_t i);
+    bool max_sort_up(int16_t i);
+
+    T       _samples[FILTER_SIZE];  // samples in arrival order
+    uint8_t _heap[FILTER_SIZE];     // sample index at each heap position
+    int16_t _pos[FILTER_SIZE];      // heap position of each sample
+    uint8_t _next;                  // sample to be replaced next
+    uint8_t _count;
+    T       _output;
+};
+
+// Typedef for convenience
+typedef MedianFilter<int16_t,9> MedianFilterInt16_Size9;
+typedef MedianFilter<int16_t,15> MedianFilterInt16_Size15;
+typedef MedianFilter<int16_t,31> MedianFilterInt16_Size31;
+typedef MedianFilter<float,9> MedianFilterFloat_Size9;
+typedef MedianFilter<float,15> MedianFilterFloat_Size15;
+typedef MedianFilter<float,31> MedianFilterFloat_Size31;
+
+// Public Methods //////////////////////////////////////////////////////////////
+
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::reset()
+{
+    // lay out the sample slots alternately below and above the median
+    // so the heaps fill evenly while the buffer is filling
+    for (uint8_t i=0; i<FILTER_SIZE; i++) {
+        _pos[i] = ((i+1)/2) * ((i & 1) ? -1 : 1);
+        heap(_pos[i]) = i;
+        _samples[i] = T();
+    }
+    _next = 0;
+    _count = 0;
+    _output = T();
+}
+
+template <class T, uint8_t FILTER_SIZE>
+T MedianFilter<T,FILTER_SIZE>::apply(T sample)
+{
+    const bool filling = _count < FILTER_SIZE;
+    const int16_t p = _pos[_next];
+    const T old = _samples[_next];
+
+    _samples[_next] = sample;
+    _next = (_next + 1) % FILTER_SIZE;
+    if (filling) {
+        _count++;
+    }
+
+    if (p > 0) {
+        // replaced a sample in the min-heap
+        if (!filling && old < sample) {
+            min_sort_down(p*2);
+        } else if (min_sort_up(p)) {
+            max_sort_down(-1);
+        }
+    } else if (p < 0) {
+        // replaced a sample in the max-heap
+        if (!filling && sample < old) {
+            max_sort_down(p*2);
+        } else if (max_sort_up(p)) {
+            min_sort_down(1);
+        }
+    } else {
+        // replaced the median
+        if (max_count() > 0) {
+            max_sort_down(-1);
+        }
+        if (min_count() > 0) {
+            min_sort_down(1);
+        }
+    }
+
+    return _output = value(0);
+}
+
+// Private Methods //////////////////////////////////////////////////////////////
+
+// swap the samples at heap positions i and j if value(i) < value(j)
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::swap_if_less(int16_t i, int16_t j)
+{
+    if (!less(i, j)) {
+        return false;
+    }
+    const uint8_t t = heap(i);
+    heap(i) = heap(j);
+    heap(j) = t;
+    _pos[heap(i)] = i;
+    _pos[heap(j)] = j;
+    return true;
+}
+
+// sift down the min-heap, starting at child position i
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::min_sort_down(int16_t i)
+{
+    for (; i <= min_count(); i *= 2) {
+        if (i > 1 && i < min_count() && less(i+1, i)) {
+            i++;
+        }
+        if (!swap_if_less(i, i/2)) {
+            break;
+        }
+    }
+}
+
+// sift down the max-heap, starting at child position i
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::max_sort_down(int16_t i)
+{
+    for (; i >= -max_count(); i *= 2) {
+        if (i < -1 && i > -max_count() && less(i, i-1)) {
+            i--;
+        }
+        if (!swap_if_less(i/2, i)) {
+            break;
+        }
+    }
+}
+
+// sift up the min-heap, returns true if the sample reached the median
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::min_sort_up(int16_t i)
+{
+    while (i > 0 && swap_if_less(i, i/2)) {
+        i /= 2;
+    }
+    return i == 0;
+}
+
+// sift up the max-heap, returns true if the sample reached the median
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::max_sort_up(int16_t i)
+{
+    while (i < 0 && swap_if_less(i/2, i)) {
+        i /= 2;
+    }
+    return i == 0;
+}
@@ -0,0 +1,118 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "NotchFilter.h"
+
+/*
+  calculate the biquad coefficients of the notch. The bandwidth is
+  converted to a quality factor and the attenuation sets the depth of
+  the notch at the center frequency
+ */
+template <class T>
+void NotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB)
+{
+    _initialised = false;
+
+    if (sample_freq_hz <= 0 || bandwidth_hz <= 0 ||
+        center_freq_hz - 0.5f * bandwidth_hz <= 0 ||
+        center_freq_hz >= 0.5f * sample_freq_hz) {
+        return;
+    }
+
+    const float omega = 2.0f * M_PI * center_freq_hz / sample_freq_hz;
+    const float octaves = log2f(center_freq_hz / (center_freq_hz - 0.5f * bandwidth_hz)) * 2.0f;
+    const float A = powf(10.0f, -attenuation_dB / 40.0f);
+    const float Q = sqrtf(powf(2.0f, octaves)) / (powf(2.0f, octaves) - 1.0f);
+    const float alpha = sinf(omega) / (2.0f * Q / A);
+    const float a0_inv = 1.0f / (1.0f + alpha / A);
+
+    // normalise by a0 so apply() needs no division
+    _b0 = (1.0f + alpha * A) * a0_inv;
+    _b1 = -2.0f * cosf(omega) * a0_inv;
+    _b2 = (1.0f - alpha * A) * a0_inv;
+    _a1 = _b1;
+    _a2 = (1.0f - alpha / A) * a0_inv;
+
+    _initialised = true;
+}
+
+template <class T>
+T NotchFilter<T>::apply(const T &sample)
+{
+    if (!_initialised) {
+        return sample;
+    }
+
+    T output = sample * _b0 + _ntchsig1 * _b1 + _ntchsig2 * _b2 - _signal1 * _a1 - _signal2 * _a2;
+
+    _ntchsig2 = _ntchsig1;
+    _ntchsig1 = sample;
+    _signal2 = _signal1;
+    _signal1 = output;
+
+    return output;
+}
+
+template <class T>
+void NotchFilter<T>::reset()
+{
+    _ntchsig1 = _ntchsig2 = _signal1 = _signal2 = T();
+}
+
+const AP_Param::GroupInfo NotchFilterParams::var_info[] = {
+    // @Param: ENABLE
+    // @DisplayName: Enable
+    // @Description: Enable notch filter
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO_FLAGS("ENABLE", 1, NotchFilterParams, _enable, 0, AP_PARAM_FLAG_ENABLE),
+
+    // @Param: FREQ
+    // @DisplayName: Frequency
+    // @Description: Notch center frequency in Hz
+    // @Range: 10 400
+    // @Units: Hz
+    // @User: Advanced
+    AP_GROUPINFO("FREQ", 2, NotchFilterParams, _center_freq_hz, 80),
+
+    // @Param: BW
+    // @DisplayName: Bandwidth
+    // @Description: Notch bandwidth in Hz
+    // @Range: 5 100
+    // @Units: Hz
+    // @User: Advanced
+    AP_GROUPINFO("BW", 3, NotchFilterParams, _bandwidth_hz, 20),
+
+    // @Param: ATT
+    // @DisplayName: Attenuation
+    // @Description: Notch attenuation in dB
+    // @Range: 5 30
+    // @Units: dB
+    // @User: Advanced
+    AP_GROUPINFO("ATT", 4, NotchFilterParams, _attenuation_dB, 15),
+
+    AP_GROUPEND
+};
+
+NotchFilterParams::NotchFilterParams(void)
+{
+    AP_Param::setup_object_defaults(this, var_info);
+}
+
+/*
+  instantiate template classes
+ */
+template class NotchFilter<float>;
+template class NotchFilter<Vector3f>;
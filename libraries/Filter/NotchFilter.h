@@ -0,0 +1,68 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  notch filter with settable sample rate, center frequency, bandwidth
+  and attenuation. Used to remove narrow band noise such as motor
+  vibration from high rate sensor data
+ */
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Param/AP_Param.h>
+#include <cmath>
+#include <inttypes.h>
+
+template <class T>
+class NotchFilter {
+public:
+    // set parameters. The filter passes samples through unchanged if
+    // the parameters do not describe a valid notch
+    void init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB);
+    T apply(const T &sample);
+    void reset();
+
+    bool initialised(void) const { return _initialised; }
+
+private:
+    bool _initialised;
+    float _b0, _b1, _b2, _a1, _a2;
+    T _ntchsig1, _ntchsig2, _signal1, _signal2;
+};
+
+/*
+  notch filter enable and parameters, shared by all instances of a
+  sensor type
+ */
+class NotchFilterParams {
+public:
+    NotchFilterParams(void);
+
+    bool enabled(void) const { return _enable; }
+    float center_freq_hz(void) const { return _center_freq_hz; }
+    float bandwidth_hz(void) const { return _bandwidth_hz; }
+    float attenuation_dB(void) const { return _attenuation_dB; }
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+private:
+    AP_Int8 _enable;
+    AP_Int16 _center_freq_hz;
+    AP_Int16 _bandwidth_hz;
+    AP_Float _attenuation_dB;
+};
+
+typedef NotchFilter<float>    NotchFilterFloat;
+typedef NotchFilter<Vector3f> NotchFilterVector3f;
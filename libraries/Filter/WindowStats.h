@@ -0,0 +1,186 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//
+/// @file	WindowStats.h
+/// @brief	Running mean, variance, min and max of a signal over a
+///         sliding window
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+/*
+  samples are accumulated into blocks of a fixed number of samples and
+  each completed block is summarised (count, mean, sum of squared
+  deviations, min and max) into a ring of NUM_BLOCKS entries. Adding a
+  sample is O(1) and a query combines at most NUM_BLOCKS summaries, so
+  a window of many seconds at the main loop rate costs a few hundred
+  bytes rather than a buffer of every sample.
+
+  A query over N blocks covers the N most recent complete blocks plus
+  the samples of the block currently being filled, so it always spans
+  at least N blocks worth of samples.
+ */
+template <uint8_t NUM_BLOCKS>
+class WindowStats
+{
+public:
+    struct Stats {
+        uint32_t count;
+        float mean;
+        float variance;
+        float min;
+        float max;
+    };
+
+    WindowStats() {
+        reset();
+    }
+
+    // set the number of samples per block, clearing the window if it changes
+    void set_block_samples(uint16_t samples) {
+        samples = MAX(samples, 1U);
+        if (samples != _block_samples) {
+            _block_samples = samples;
+            reset();
+        }
+    }
+
+    // add a new sample to the window
+    void apply(float sample);
+
+    // clear all samples
+    void reset() {
+        clear_block(_current);
+        _head = 0;
+        _num_blocks = 0;
+        _last = 0;
+    }
+
+    // most recent sample
+    float last() const { return _last; }
+
+    // number of complete blocks available to a query
+    uint8_t num_blocks() const { return _num_blocks; }
+
+    // statistics over the latest blocks complete blocks and the
+    // partially filled block. Returns false if fewer than blocks
+    // complete blocks have been collected since the last reset
+    bool get(uint8_t blocks, Stats &stats) const;
+
+private:
+    struct Block {
+        uint16_t count;
+        float mean;
+        float m2;       // sum of squared deviations from the mean
+        float min;
+        float max;
+    };
+
+    static void clear_block(Block &block) {
+        block.count = 0;
+        block.mean = 0;
+        block.m2 = 0;
+        block.min = 0;
+        block.max = 0;
+    }
+
+    Block _blocks[NUM_BLOCKS];
+    Block _current;
+    uint16_t _block_samples = 1;
+    uint8_t _head;              // index of the next block to be written
+    uint8_t _num_blocks;        // number of valid entries in _blocks
+    float _last;
+};
+
+template <uint8_t NUM_BLOCKS>
+void WindowStats<NUM_BLOCKS>::apply(float sample)
+{
+    _last = sample;
+
+    // Welford update of the block being filled
+    if (_current.count == 0) {
+        _current.min = sample;
+        _current.max = sample;
+    } else {
+        _current.min = MIN(_current.min, sample);
+        _current.max = MAX(_current.max, sample);
+    }
+    _current.count++;
+    const float delta = sample - _current.mean;
+    _current.mean += delta / _current.count;
+    _current.m2 += delta * (sample - _current.mean);
+
+    if (_current.count < _block_samples) {
+        return;
+    }
+
+    // block complete, push it into the ring
+    _blocks[_head] = _current;
+    _head = (_head + 1) % NUM_BLOCKS;
+    if (_num_blocks < NUM_BLOCKS) {
+        _num_blocks++;
+    }
+    clear_block(_current);
+}
+
+template <uint8_t NUM_BLOCKS>
+bool WindowStats<NUM_BLOCKS>::get(uint8_t blocks, Stats &stats) const
+{
+    if (blocks > _num_blocks) {
+        return false;
+    }
+
+    // combine the block summaries newest first, seeded with the
+    // partial block (Chan et al. parallel variance). Counts are kept
+    // as float as the window may exceed the 16 bit block count
+    float count = _current.count;
+    float mean = _current.mean;
+    float m2 = _current.m2;
+    float min_v = _current.min;
+    float max_v = _current.max;
+
+    uint8_t idx = _head;
+    for (uint8_t i=0; i<blocks; i++) {
+        idx = (idx + NUM_BLOCKS - 1) % NUM_BLOCKS;
+        const Block &b = _blocks[idx];
+        if (count <= 0) {
+            count = b.count;
+            mean = b.mean;
+            m2 = b.m2;
+            min_v = b.min;
+            max_v = b.max;
+            continue;
+        }
+        const float total = count + b.count;
+        const float delta = b.mean - mean;
+        mean += delta * b.count / total;
+        m2 += b.m2 + delta * delta * count * b.count / total;
+        min_v = MIN(min_v, b.min);
+        max_v = MAX(max_v, b.max);
+        count = total;
+    }
+
+    if (count <= 0) {
+        return false;
+    }
+
+    stats.count = (uint32_t)count;
+    stats.mean = mean;
+    stats.variance = m2 / count;
+    stats.min = min_v;
+    stats.max = max_v;
+    return true;
+}
@@ -0,0 +1,37 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/LowPassFilter2pBank.h>
+
+/*
+  compare filtering a three axis IMU sample with the Vector3f biquad
+  and with the three channel filter bank
+ */
+
+static void BM_LowPassFilter2pVector3f(benchmark::State& state)
+{
+    LowPassFilter2pVector3f filter(1000, 20);
+    Vector3f sample(0.1f, -0.2f, 9.8f);
+
+    while (state.KeepRunning()) {
+        Vector3f out = filter.apply(sample);
+        gbenchmark_escape(&out);
+    }
+}
+
+static void BM_LowPassFilter2pBank3f(benchmark::State& state)
+{
+    LowPassFilter2pBank3f filter;
+    filter.set_cutoff_frequency(1000, 20);
+    Vector3f sample(0.1f, -0.2f, 9.8f);
+
+    while (state.KeepRunning()) {
+        Vector3f out = filter.apply(sample);
+        gbenchmark_escape(&out);
+    }
+}
+
+BENCHMARK(BM_LowPassFilter2pVector3f);
+BENCHMARK(BM_LowPassFilter2pBank3f);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,65 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/ModeFilter.h>
+#include <Filter/MedianFilter.h>
+
+/*
+  compare the insertion sort mode filter with the sliding window
+  median filter over a range of window sizes. The input is a noisy
+  signal with occasional spikes, as seen from a rangefinder
+ */
+
+#define NUM_INPUTS 1024
+
+static float inputs[NUM_INPUTS];
+
+static void setup_inputs()
+{
+    uint32_t seed = 1;
+    for (uint16_t i=0; i<NUM_INPUTS; i++) {
+        seed = seed * 1664525U + 1013904223U;
+        inputs[i] = 5.0f + (seed >> 24) * 0.001f;
+        if ((seed & 0x1f) == 0) {
+            inputs[i] *= 10;
+        }
+    }
+}
+
+template <uint8_t FILTER_SIZE>
+static void BM_ModeFilter(benchmark::State& state)
+{
+    ModeFilter<float,FILTER_SIZE> filter(FILTER_SIZE/2);
+    uint16_t i = 0;
+    setup_inputs();
+
+    while (state.KeepRunning()) {
+        float out = filter.apply(inputs[i]);
+        gbenchmark_escape(&out);
+        i = (i + 1) % NUM_INPUTS;
+    }
+}
+
+template <uint8_t FILTER_SIZE>
+static void BM_MedianFilter(benchmark::State& state)
+{
+    MedianFilter<float,FILTER_SIZE> filter;
+    uint16_t i = 0;
+    setup_inputs();
+
+    while (state.KeepRunning()) {
+        float out = filter.apply(inputs[i]);
+        gbenchmark_escape(&out);
+        i = (i + 1) % NUM_INPUTS;
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_ModeFilter, 5);
+BENCHMARK_TEMPLATE(BM_MedianFilter, 5);
+BENCHMARK_TEMPLATE(BM_ModeFilter, 15);
+BENCHMARK_TEMPLATE(BM_MedianFilter, 15);
+BENCHMARK_TEMPLATE(BM_ModeFilter, 31);
+BENCHMARK_TEMPLATE(BM_MedianFilter, 31);
+BENCHMARK_TEMPLATE(BM_ModeFilter, 101);
+BENCHMARK_TEMPLATE(BM_MedianFilter, 101);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,89 @@
+#include <AP_gtest.h>
+
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/LowPassFilter2pBank.h>
+
+#define BANK_TEST_SAMPLES 5000
+
+// a deterministic input with content above and below the cutoff
+static float bank_test_input(uint16_t i, uint8_t channel)
+{
+    return sinf(i * (0.05f + 0.11f * channel)) + 0.5f * sinf(i * 1.9f + channel) + 0.1f * (i % 7);
+}
+
+// each channel of the bank matches its own LowPassFilter2p<float>. The
+// arithmetic is the same, but allow for the compiler contracting it
+// differently into fused multiply-adds
+TEST(LowPassFilter2pBankTest, MatchesScalarFilter)
+{
+    LowPassFilter2pBank3f bank;
+    LowPassFilter2pFloat scalar[3];
+    bank.set_cutoff_frequency(1000.0f, 80.0f);
+    for (uint8_t c=0; c<3; c++) {
+        scalar[c].set_cutoff_frequency(1000.0f, 80.0f);
+    }
+
+    for (uint16_t i=0; i<BANK_TEST_SAMPLES; i++) {
+        float in[3], out[3];
+        for (uint8_t c=0; c<3; c++) {
+            in[c] = bank_test_input(i, c);
+        }
+        bank.apply(in, out);
+        for (uint8_t c=0; c<3; c++) {
+            EXPECT_FLOAT_EQ(scalar[c].apply(in[c]), out[c]);
+        }
+    }
+}
+
+// the vector apply matches LowPassFilter2pVector3f
+TEST(LowPassFilter2pBankTest, MatchesVectorFilter)
+{
+    LowPassFilter2pBank3f bank;
+    LowPassFilter2pVector3f vector;
+    bank.set_cutoff_frequency(400.0f, 20.0f);
+    vector.set_cutoff_frequency(400.0f, 20.0f);
+
+    for (uint16_t i=0; i<BANK_TEST_SAMPLES; i++) {
+        const Vector3f in(bank_test_input(i, 0), bank_test_input(i, 1), bank_test_input(i, 2));
+        const Vector3f expected = vector.apply(in);
+        const Vector3f out = bank.apply(in);
+        EXPECT_FLOAT_EQ(expected.x, out.x);
+        EXPECT_FLOAT_EQ(expected.y, out.y);
+        EXPECT_FLOAT_EQ(expected.z, out.z);
+    }
+}
+
+// with no cutoff set the samples pass straight through
+TEST(LowPassFilter2pBankTest, PassThroughWithoutCutoff)
+{
+    LowPassFilter2pBank3f bank;
+    const float in[3] = { 1.5f, -2.0f, 0.25f };
+    float out[3];
+    bank.apply(in, out);
+    for (uint8_t c=0; c<3; c++) {
+        EXPECT_EQ(in[c], out[c]);
+    }
+}
+
+// reset() clears the state so the output starts again from zero
+TEST(LowPassFilter2pBankTest, Reset)
+{
+    LowPassFilter2pBank3f bank;
+    LowPassFilter2pBank3f fresh;
+    bank.set_cutoff_frequency(1000.0f, 80.0f);
+    fresh.set_cutoff_frequency(1000.0f, 80.0f);
+
+    const float in[3] = { 1.0f, 2.0f, 3.0f };
+    float out[3], expected[3];
+    for (uint8_t i=0; i<50; i++) {
+        bank.apply(in, out);
+    }
+    bank.reset();
+    bank.apply(in, out);
+    fresh.apply(in, expected);
+    for (uint8_t c=0; c<3; c++) {
+        EXPECT_FLOAT_EQ(expected[c], out[c]);
+    }
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,110 @@
+#include <AP_gtest.h>
+
+#include <AP_Common/AP_Common.h>
+#include <Filter/MedianFilter.h>
+
+#include <algorithm>
+
+#define MEDIAN_TEST_SAMPLES 2000
+
+// a deterministic pseudo-random input in [-range/2, range/2). A small
+// range makes repeated values common
+static int16_t median_test_input(uint32_t &state, int16_t range)
+{
+    state = state * 1664525UL + 1013904223UL;
+    return (int16_t)((state >> 16) % range) - range/2;
+}
+
+// the median of the last min(n, FILTER_SIZE) samples. While the window
+// is filling, and for an even FILTER_SIZE, the filter returns the upper
+// of the two middle samples
+template <class T>
+static T median_reference(const T *history, uint16_t n, uint8_t size)
+{
+    const uint16_t count = std::min<uint16_t>(n, size);
+    T window[256];
+    std::copy(history + n - count, history + n, window);
+    std::sort(window, window + count);
+    return window[count / 2];
+}
+
+// feed enough samples for the ring buffer to wrap many times and
+// compare every output with a sorted copy of the window
+template <class T, uint8_t FILTER_SIZE>
+static void check_against_reference(int16_t range, uint32_t seed)
+{
+    MedianFilter<T,FILTER_SIZE> filter;
+    T history[MEDIAN_TEST_SAMPLES];
+
+    for (uint16_t i=0; i<MEDIAN_TEST_SAMPLES; i++) {
+        history[i] = (T)median_test_input(seed, range);
+        const T out = filter.apply(history[i]);
+        ASSERT_EQ(median_reference(history, i+1, FILTER_SIZE), out)
+            << "size " << (int)FILTER_SIZE << " sample " << i;
+        ASSERT_EQ(out, filter.get());
+    }
+}
+
+TEST(MedianFilterTest, OddSizes)
+{
+    check_against_reference<int16_t,1>(1000, 1);
+    check_against_reference<int16_t,3>(1000, 2);
+    check_against_reference<int16_t,5>(1000, 3);
+    check_against_reference<int16_t,9>(1000, 4);
+    check_against_reference<int16_t,31>(1000, 5);
+    check_against_reference<float,15>(1000, 6);
+    check_against_reference<float,101>(1000, 7);
+}
+
+TEST(MedianFilterTest, EvenSizes)
+{
+    check_against_reference<int16_t,2>(1000, 11);
+    check_against_reference<int16_t,4>(1000, 12);
+    check_against_reference<int16_t,8>(1000, 13);
+    check_against_reference<int16_t,16>(1000, 14);
+    check_against_reference<float,10>(1000, 15);
+    check_against_reference<float,100>(1000, 16);
+}
+
+// many equal samples exercise the ties in the heap comparisons
+TEST(MedianFilterTest, RepeatedValues)
+{
+    check_against_reference<int16_t,5>(3, 21);
+    check_against_reference<int16_t,8>(3, 22);
+    check_against_reference<int16_t,31>(4, 23);
+}
+
+// monotonic input makes every new sample cross the median
+TEST(MedianFilterTest, Ramp)
+{
+    MedianFilterInt16_Size9 filter;
+    for (int16_t i=0; i<100; i++) {
+        const int16_t out = filter.apply(i);
+        // window is [max(0,i-8), i], the median is its middle sample
+        const int16_t first = std::max<int16_t>(0, i - 8);
+        EXPECT_EQ(first + (i - first + 1) / 2, out);
+    }
+    for (int16_t i=100; i>0; i--) {
+        filter.apply(i);
+    }
+    EXPECT_EQ(5, filter.get());
+}
+
+// reset() empties the window so the filter behaves as if freshly made
+TEST(MedianFilterTest, Reset)
+{
+    MedianFilterFloat_Size9 filter;
+    MedianFilterFloat_Size9 fresh;
+    for (uint8_t i=0; i<50; i++) {
+        filter.apply(i * 3.5f);
+    }
+    filter.reset();
+    EXPECT_EQ(0.0f, filter.get());
+
+    const float in[] = { 7.0f, -1.0f, 4.0f, 2.5f, 9.0f, 0.0f };
+    for (uint8_t i=0; i<ARRAY_SIZE(in); i++) {
+        EXPECT_EQ(fresh.apply(in[i]), filter.apply(in[i]));
+    }
+}
+
+AP_GTEST_MAIN()
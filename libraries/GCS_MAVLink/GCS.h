@@ -21,12 +21,34 @@
 #define CHECK_PAYLOAD_SIZE(id) if (comm_get_txspace(chan) < packet_overhead()+MAVLINK_MSG_ID_ ## id ## _LEN) return false
 #define CHECK_PAYLOAD_SIZE2(id) if (!HAVE_PAYLOAD_SPACE(chan, id)) return false
 
+// share of the link bandwidth that streamed messages may use
+#define GCS_STREAM_BUDGET_PERCENT 80
+
+// interval value for a message that should not be sent
+#define GCS_MESSAGE_INTERVAL_DISABLED 0xFFFF
+
+// number of mission items requested ahead during a staged mission
+// upload (at most 32)
+#define GCS_MISSION_UPLOAD_WINDOW 8
+
 #if HAL_CPU_CLASS <= HAL_CPU_CLASS_150 || CONFIG_HAL_BOARD == HAL_BOARD_SITL
     #define GCS_MAVLINK_PAYLOAD_STATUS_CAPACITY          5
 #else
     #define GCS_MAVLINK_PAYLOAD_STATUS_CAPACITY          30
 #endif
 
+// PARAM_SETs waiting to be applied on each channel, and how many are
+// applied per update
+#if HAL_CPU_CLASS <= HAL_CPU_CLASS_150
+    #define GCS_PARAM_SET_QUEUE_LEN                      4
+#else
+    #define GCS_PARAM_SET_QUEUE_LEN                      16
+#endif
+#define GCS_PARAM_SET_BATCH                              4
+
+// bytes read from storage at a time by the FTP file server
+#define GCS_FTP_READAHEAD_SIZE                           1024
+
 //  GCS Message ID's
 /// NOTE: to ensure we never block on sending MAVLink messages
 /// please keep each MSG_ to a single MAVLink message. If need be
@@ -136,6 +158,15 @@ public:
     // see if we should send a stream now. Called at 50Hz
     bool        stream_trigger(enum streams stream_num);
 
+    // send a message at its own interval instead of with its
+    // stream. 0 returns it to its stream, GCS_MESSAGE_INTERVAL_DISABLED
+    // stops it. Returns false for messages which can't be scheduled
+    bool        set_message_interval(enum ap_message id, uint16_t interval_ms);
+
+    // number of messages that had to wait for link space, and how
+    // long they waited
+    void        deferred_latency(uint32_t &count, uint32_t &avg_ms, uint32_t &max_ms) const;
+
     // call to reset the timeout window for entering the cli
     void reset_cli_timeout();
 
@@ -163,7 +194,7 @@ public:
     void send_opticalflow(AP_AHRS_NavEKF &ahrs, const OpticalFlow &optflow);
 #endif
     void send_autopilot_version(uint8_t major_version, uint8_t minor_version, uint8_t patch_version, uint8_t version_type) const;
-    void send_local_position(const AP_AHRS &ahrs) const;
+    void send_local_position(AP_AHRS &ahrs) const;
     void send_vibration(const AP_InertialSensor &ins) const;
     void send_home(const Location &home) const;
     static void send_home_all(const Location &home);
@@ -255,6 +286,8 @@ protected:
     bool handle_mission_item(mavlink_message_t *msg, AP_Mission &mission);
 
     void handle_param_set(mavlink_message_t *msg, DataFlash_Class *DataFlash);
+    void param_set(const char *key, float value, DataFlash_Class *DataFlash);
+    void process_param_set_queue(void);
     void handle_param_request_list(mavlink_message_t *msg);
     void handle_param_request_read(mavlink_message_t *msg);
 
@@ -265,9 +298,11 @@ protected:
     void handle_gps_inject(const mavlink_message_t *msg, AP_GPS &gps);
 
     void handle_log_message(mavlink_message_t *msg, DataFlash_Class &dataflash);
+    void handle_file_transfer_protocol(mavlink_message_t *msg);
     void handle_setup_signing(const mavlink_message_t *msg);
     uint8_t handle_preflight_reboot(const mavlink_command_long_t &packet, bool disable_overrides);
     uint8_t handle_rc_bind(const mavlink_command_long_t &packet);
+    uint8_t handle_command_set_message_interval(const mavlink_command_long_t &packet);
 
 private:
 
@@ -314,12 +349,40 @@ private:
     uint32_t        waypoint_timelast_request; // milliseconds
     const uint16_t  waypoint_receive_timeout = 8000; // milliseconds
 
+    // items from waypoint_request_i onwards that may be outstanding
+    // at once. Staged uploads request a window of items and accept
+    // them in any order; otherwise items are requested one at a time
+    uint8_t         waypoint_window = 1;
+    // bit n is set once item waypoint_request_i+n has been received,
+    // or requested
+    uint32_t        waypoint_window_received;
+    uint32_t        waypoint_window_requested;
+
     // number of 50Hz ticks until we next send this stream
     uint8_t         stream_ticks[NUM_STREAMS];
 
     // number of extra ticks to add to slow things down for the radio
     uint8_t         stream_slowdown;
 
+    /*
+      bandwidth budget. A token bucket is refilled at
+      GCS_STREAM_BUDGET_PERCENT of the link rate and drained by every
+      byte sent. Streamed and interval messages are held back while
+      it is empty, leaving headroom for replies such as command acks
+     */
+    uint32_t        _baudrate;
+    int32_t         _budget_tokens;
+    uint32_t        _budget_last_ms;
+    uint32_t        _budget_last_tx_bytes;
+    bool            stream_budget_ok(void);
+
+    // per-message send intervals, see set_message_interval()
+    uint16_t        _message_interval_ms[MSG_RETRY_DEFERRED];
+    uint32_t        _message_last_ms[MSG_RETRY_DEFERRED];
+    bool            _have_message_intervals;
+    bool            _sending_interval_message;
+    void            send_interval_messages(void);
+
     // millis value to calculate cli timeout relative to.
     // exists so we can separate the cli entry time from the system start time
     uint32_t _cli_timeout;
@@ -351,10 +414,130 @@ private:
     // start page of log data
     uint16_t _log_data_page;
 
-    // deferred message handling
-    enum ap_message deferred_messages[MSG_RETRY_DEFERRED];
-    uint8_t next_deferred_message;
-    uint8_t num_deferred_messages;
+    // PARAM_SETs not yet applied, oldest first. A repeated set of a
+    // queued parameter just updates its value
+    struct pending_param_set {
+        char key[AP_MAX_NAME_SIZE+1];
+        float value;
+    } _param_set_queue[GCS_PARAM_SET_QUEUE_LEN];
+    uint8_t _param_set_count;
+
+    // next AP_Alloc tag and HAL thread to report with MEMINFO
+    uint8_t _mem_tag_index;
+    uint8_t _thread_info_index;
+
+    /*
+      link statistics. Counts are gathered over a second at a time by
+      update_link_stats(), which logs each second as a MAVS message.
+      send_link_stats() reports the last second one value at a time
+     */
+    struct link_stats {
+        uint32_t tx_bytes;
+        uint32_t rx_bytes;
+        uint16_t rx_packets;
+        uint16_t rx_errors;     // framing and CRC errors
+        uint16_t rx_lost;       // gaps in the received sequence numbers
+        uint32_t drop_bytes;
+        uint16_t drop_frames;
+        uint8_t deferred;       // messages waiting for link space
+        // the message IDs which took the most bytes
+        uint32_t top_msgid[2];
+        uint32_t top_bytes[2];
+    };
+    struct {
+        struct link_stats count;
+        struct link_stats last;
+        uint32_t last_ms;
+        uint32_t last_tx_bytes;
+        uint16_t last_rx_drop_count;
+        uint8_t report_index;
+    } _link_stats;
+    void update_link_stats(void);
+    void send_link_stats(void);
+
+    /*
+      SERIAL_CONTROL streaming passthrough. While a ground station
+      holds a device exclusively with multi-packet replies, data
+      arriving from the device is streamed back from update() as fast
+      as the link allows rather than only in reply to each request
+     */
+    struct {
+        AP_HAL::Stream *stream;
+        uint8_t device;
+        uint32_t last_request_ms;
+    } _serial_passthru;
+    void serial_passthru_update(void);
+    bool send_serial_control_reply(AP_HAL::Stream *stream, uint8_t device, uint8_t flags);
+
+#if HAL_OS_POSIX_IO
+    /*
+      FILE_TRANSFER_PROTOCOL read-only file server, one session per
+      channel. Burst reads are streamed from ftp_update()
+     */
+    struct PACKED ftp_payload {
+        uint16_t seq_number;
+        uint8_t session;
+        uint8_t opcode;
+        uint8_t size;
+        uint8_t req_opcode;
+        uint8_t burst_complete;
+        uint8_t padding;
+        uint32_t offset;
+        uint8_t data[MAVLINK_MSG_FILE_TRANSFER_PROTOCOL_FIELD_PAYLOAD_LEN - 12];
+    };
+    struct {
+        bool open;
+        bool bursting;
+        uint8_t session;
+        int fd;                 // -1 for the parameter file
+        uint32_t size;
+        uint8_t *readahead;     // GCS_FTP_READAHEAD_SIZE bytes while open
+        uint32_t readahead_offset;
+        uint16_t readahead_len;
+        struct ftp_payload burst_request;
+        uint32_t burst_offset;
+        uint32_t last_request_ms;
+        uint8_t target_system;
+        uint8_t target_component;
+        // the parameter file line where the last read stopped
+        AP_Param *param_vp;
+        AP_Param::ParamToken param_token;
+        enum ap_var_type param_type;
+        uint16_t param_index;
+    } _ftp;
+    void ftp_update(void);
+    void ftp_send_reply(const struct ftp_payload &request, uint8_t opcode,
+                        uint32_t offset, const uint8_t *data, uint8_t len);
+    void ftp_send_nak(const struct ftp_payload &request, uint8_t error);
+    void ftp_list_directory(const struct ftp_payload &request);
+    void ftp_open(const struct ftp_payload &request);
+    void ftp_close(void);
+    int16_t ftp_read(uint32_t offset, uint8_t *data, uint8_t len);
+    uint32_t ftp_param_size(void);
+    int32_t ftp_param_read(uint32_t offset, uint8_t *data, uint16_t len);
+#endif
+
+    /*
+      deferred message handling. Messages that couldn't be sent are
+      kept as a set, so each is queued at most once, and are retried
+      highest priority first
+     */
+    enum deferred_priority {
+        DEFERRED_PRIORITY_HIGH = 0,
+        DEFERRED_PRIORITY_NORMAL,
+        DEFERRED_PRIORITY_LOW,
+        DEFERRED_PRIORITY_COUNT
+    };
+    static enum deferred_priority deferred_message_priority(enum ap_message id);
+    static_assert(MSG_RETRY_DEFERRED <= 64, "deferred message mask too small");
+    uint64_t _deferred_mask;
+    uint32_t _deferred_since_ms[MSG_RETRY_DEFERRED];
+    void send_deferred_messages(enum ap_message fresh_id);
+
+    // time messages spent waiting in the deferred set
+    uint32_t _deferred_latency_count;
+    uint32_t _deferred_latency_total_ms;
+    uint32_t _deferred_latency_max_ms;
 
     // time when we missed sending a parameter for GCS
     static uint32_t reserve_param_space_start_ms;
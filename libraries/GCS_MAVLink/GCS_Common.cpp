@@ -15,6 +15,7 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <AP_AHRS/AP_AHRS.h>
+#include <AP_Common/AP_Alloc.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_OpticalFlow/AP_OpticalFlow.h>
 #include <AP_Vehicle/AP_Vehicle.h>
@@ -105,10 +106,12 @@ GCS_MAVLINK::setup_uart(const AP_SerialManager& serial_manager, AP_SerialManager
     uart->set_flow_control(old_flow_control);
 
     // now change back to desired baudrate
-    uart->begin(serial_manager.find_baudrate(protocol, instance));
+    const uint32_t baudrate = serial_manager.find_baudrate(protocol, instance);
+    uart->begin(baudrate);
 
     // and init the gcs instance
     init(uart, mav_chan);
+    _baudrate = baudrate;
 
     AP_SerialManager::SerialProtocol mavlink_protocol = serialmanager_p->get_mavlink_protocol(mav_chan);
     mavlink_status_t *status = mavlink_get_channel_status(chan);
@@ -195,20 +198,33 @@ GCS_MAVLINK::queued_param_send()
 }
 
 /**
- * @brief Send the next pending waypoint, called from deferred message
- * handling code
+ * @brief Request the waypoints in the receive window that haven't
+ * been asked for yet, called from deferred message handling code
  */
 void
 GCS_MAVLINK::queued_waypoint_send()
 {
-    if (initialised &&
-        waypoint_receiving &&
-        waypoint_request_i <= waypoint_request_last) {
+    if (!initialised || !waypoint_receiving) {
+        return;
+    }
+    for (uint8_t i=0; i<waypoint_window; i++) {
+        const uint16_t seq = waypoint_request_i + i;
+        if (seq > waypoint_request_last || (i > 0 && seq == waypoint_request_last)) {
+            break;
+        }
+        const uint32_t bit = 1U << i;
+        if ((waypoint_window_received | waypoint_window_requested) & bit) {
+            continue;
+        }
+        if (i > 0 && !HAVE_PAYLOAD_SPACE(chan, MISSION_REQUEST)) {
+            break;
+        }
         mavlink_msg_mission_request_send(
             chan,
             waypoint_dest_sysid,
             waypoint_dest_compid,
-            waypoint_request_i);
+            seq);
+        waypoint_window_requested |= bit;
     }
 }
 
@@ -221,6 +237,45 @@ void GCS_MAVLINK::send_meminfo(void)
     unsigned __brkval = 0;
     uint32_t memory = hal.util->available_memory();
     mavlink_msg_meminfo_send(chan, __brkval, memory & 0xFFFF, memory);
+
+    /*
+      report the stack high-water mark in bytes of one HAL thread per
+      call as a NAMED_VALUE_INT named after the thread
+     */
+    AP_HAL::Util::thread_info thread;
+    if (HAVE_PAYLOAD_SPACE(chan, NAMED_VALUE_INT)) {
+        if (!hal.util->thread_get_info(_thread_info_index, thread)) {
+            _thread_info_index = 0;
+        } else {
+            char name[10];
+            strncpy(name, thread.name, sizeof(name));
+            mavlink_msg_named_value_int_send(chan, AP_HAL::millis(), name, thread.stack_used);
+            _thread_info_index++;
+        }
+    }
+
+    send_link_stats();
+
+    /*
+      report the memory allocated by one subsystem per call as a
+      NAMED_VALUE_INT, followed by the number of allocations made after
+      boot. The named value holds boot and runtime bytes together
+     */
+    const uint8_t num_tags = AP_Alloc::num_tags();
+    if (num_tags == 0 || !HAVE_PAYLOAD_SPACE(chan, NAMED_VALUE_INT)) {
+        return;
+    }
+    if (_mem_tag_index >= num_tags) {
+        mavlink_msg_named_value_int_send(chan, AP_HAL::millis(), "RT_ALLOCS", AP_Alloc::runtime_count());
+        _mem_tag_index = 0;
+        return;
+    }
+    AP_Alloc::tag_info info;
+    if (AP_Alloc::get_tag(_mem_tag_index++, info)) {
+        char name[10];
+        strncpy(name, info.name, sizeof(name));
+        mavlink_msg_named_value_int_send(chan, AP_HAL::millis(), name, info.boot_bytes + info.runtime_bytes);
+    }
 }
 
 // report power supply status
@@ -413,8 +468,16 @@ void GCS_MAVLINK::handle_mission_count(AP_Mission &mission, mavlink_message_t *m
         return;
     }
 
-    // new mission arriving, truncate mission to be the same length
-    mission.truncate(packet.count);
+    if (mission.upload_start(packet.count)) {
+        // the stored mission is replaced once every item has arrived
+        waypoint_window = GCS_MISSION_UPLOAD_WINDOW;
+    } else {
+        // new mission arriving, truncate mission to be the same length
+        mission.truncate(packet.count);
+        waypoint_window = 1;
+    }
+    waypoint_window_received = 0;
+    waypoint_window_requested = 0;
 
     // set variables to help handle the expected receiving of commands from the GCS
     waypoint_timelast_receive = AP_HAL::millis();    // set time we last received commands to now
@@ -460,6 +523,12 @@ void GCS_MAVLINK::handle_mission_write_partial_list(AP_Mission &mission, mavlink
         return;
     }
 
+    // partial updates write to the stored mission as they arrive
+    mission.upload_abort();
+    waypoint_window = 1;
+    waypoint_window_received = 0;
+    waypoint_window_requested = 0;
+
     waypoint_timelast_receive = AP_HAL::millis();
     waypoint_timelast_request = 0;
     waypoint_receiving   = true;
@@ -614,6 +683,24 @@ void GCS_MAVLINK::handle_param_request_read(mavlink_message_t *msg)
     } else {
         strncpy(param_name, packet.param_id, AP_MAX_NAME_SIZE);
         param_name[AP_MAX_NAME_SIZE] = 0;
+        if (strcmp(param_name, "_HASH_CHECK") == 0) {
+            // a GCS with a cached parameter list can compare this
+            // against its own CRC and skip the full download
+            union {
+                uint32_t crc;
+                float f;
+            } hash;
+            hash.crc = AP_Param::checksum_parameters();
+            mavlink_msg_param_value_send_buf(
+                msg,
+                chan,
+                param_name,
+                hash.f,
+                MAV_PARAM_TYPE_UINT32,
+                AP_Param::count_parameters(),
+                -1);
+            return;
+        }
         vp = AP_Param::find(param_name, &p_type);
         if (vp == NULL) {
             return;
@@ -635,23 +722,65 @@ void GCS_MAVLINK::handle_param_set(mavlink_message_t *msg, DataFlash_Class *Data
 {
     mavlink_param_set_t packet;
     mavlink_msg_param_set_decode(msg, &packet);
-    enum ap_var_type var_type;
 
-    // set parameter
-    AP_Param *vp;
     char key[AP_MAX_NAME_SIZE+1];
     strncpy(key, (char *)packet.param_id, AP_MAX_NAME_SIZE);
     key[AP_MAX_NAME_SIZE] = 0;
 
+    // a newer value for a parameter that is still queued replaces it
+    for (uint8_t i=0; i<_param_set_count; i++) {
+        if (strcmp(_param_set_queue[i].key, key) == 0) {
+            _param_set_queue[i].value = packet.param_value;
+            return;
+        }
+    }
+
+    if (_param_set_count == GCS_PARAM_SET_QUEUE_LEN) {
+        // make room by applying the oldest now
+        param_set(_param_set_queue[0].key, _param_set_queue[0].value, DataFlash);
+        memmove(&_param_set_queue[0], &_param_set_queue[1], sizeof(_param_set_queue[0])*(_param_set_count-1));
+        _param_set_count--;
+    }
+    struct pending_param_set &p = _param_set_queue[_param_set_count++];
+    memcpy(p.key, key, sizeof(p.key));
+    p.value = packet.param_value;
+}
+
+/*
+  apply up to GCS_PARAM_SET_BATCH queued PARAM_SETs. Called from
+  update()
+ */
+void GCS_MAVLINK::process_param_set_queue(void)
+{
+    if (_param_set_count == 0) {
+        return;
+    }
+    const uint8_t n = MIN(_param_set_count, GCS_PARAM_SET_BATCH);
+    DataFlash_Class *dataflash = DataFlash_Class::instance();
+    for (uint8_t i=0; i<n; i++) {
+        param_set(_param_set_queue[i].key, _param_set_queue[i].value, dataflash);
+    }
+    _param_set_count -= n;
+    memmove(&_param_set_queue[0], &_param_set_queue[n], sizeof(_param_set_queue[0])*_param_set_count);
+}
+
+/*
+  set and save a parameter. Saving sends the new value to every
+  channel and logs it
+ */
+void GCS_MAVLINK::param_set(const char *key, float value, DataFlash_Class *DataFlash)
+{
+    enum ap_var_type var_type;
+
     // find existing param so we can get the old value
-    vp = AP_Param::find(key, &var_type);
+    AP_Param *vp = AP_Param::find(key, &var_type);
     if (vp == NULL) {
         return;
     }
     float old_value = vp->cast_to_float(var_type);
 
     // set the value
-    vp->set_float(packet.param_value, var_type);
+    vp->set_float(value, var_type);
 
     /*
       we force the save if the value is not equal to the old
@@ -660,12 +789,11 @@ void GCS_MAVLINK::handle_param_set(mavlink_message_t *msg, DataFlash_Class *Data
       default value which differs from the constructor value doesn't
       save the change
      */
-    bool force_save = !is_equal(packet.param_value, old_value);
+    bool force_save = !is_equal(value, old_value);
 
     // save the change
-    vp->save(force_save);
-
-    if (DataFlash != NULL) {
+    if (!vp->save(force_save) && DataFlash != NULL) {
+        // record the change even though it couldn't be stored
         DataFlash->Log_Write_Parameter(key, vp->cast_to_float(var_type));
     }
 }
@@ -701,6 +829,10 @@ bool GCS_MAVLINK::stream_trigger(enum streams stream_num)
     }
 
     if (stream_ticks[stream_num] == 0) {
+        if (!stream_budget_ok()) {
+            // stay due and try again on the next tick
+            return false;
+        }
         // we're triggering now, setup the next trigger point
         if (rate > 50) {
             rate = 50;
@@ -714,6 +846,149 @@ bool GCS_MAVLINK::stream_trigger(enum streams stream_num)
     return false;
 }
 
+/*
+  return true if the bandwidth budget allows more streamed messages
+ */
+bool GCS_MAVLINK::stream_budget_ok(void)
+{
+    if (_baudrate == 0) {
+        // no serial link rate known (e.g. USB or network); the
+        // radio based slowdown still applies
+        return true;
+    }
+    const uint32_t now = AP_HAL::millis();
+    const uint32_t tx_bytes = mavlink_tx_bytes[chan];
+    // 10 bits per byte on a UART
+    const int32_t bytes_per_s = (_baudrate / 10) * GCS_STREAM_BUDGET_PERCENT / 100;
+    // allow bursts of up to 100ms worth of data
+    const int32_t max_tokens = MAX(bytes_per_s / 10, MAVLINK_MAX_PACKET_LEN);
+
+    const uint32_t dt = MIN(now - _budget_last_ms, 1000U);
+    _budget_tokens += (int32_t)(((uint64_t)bytes_per_s * dt) / 1000);
+    _budget_tokens -= (int32_t)(tx_bytes - _budget_last_tx_bytes);
+    _budget_tokens = constrain_int32(_budget_tokens, -max_tokens, max_tokens);
+    _budget_last_ms = now;
+    _budget_last_tx_bytes = tx_bytes;
+
+    return _budget_tokens > 0;
+}
+
+/*
+  map from MAVLink message IDs to the ap_message which sends them,
+  for the telemetry messages that may be given their own interval
+ */
+static const struct {
+    uint32_t mavlink_id;
+    enum ap_message msg;
+} interval_messages[] = {
+    { MAVLINK_MSG_ID_ATTITUDE,                   MSG_ATTITUDE },
+    { MAVLINK_MSG_ID_GLOBAL_POSITION_INT,        MSG_LOCATION },
+    { MAVLINK_MSG_ID_SYS_STATUS,                 MSG_EXTENDED_STATUS1 },
+    { MAVLINK_MSG_ID_MEMINFO,                    MSG_EXTENDED_STATUS2 },
+    { MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT,      MSG_NAV_CONTROLLER_OUTPUT },
+    { MAVLINK_MSG_ID_MISSION_CURRENT,            MSG_CURRENT_WAYPOINT },
+    { MAVLINK_MSG_ID_VFR_HUD,                    MSG_VFR_HUD },
+    { MAVLINK_MSG_ID_SERVO_OUTPUT_RAW,           MSG_RADIO_OUT },
+    { MAVLINK_MSG_ID_RC_CHANNELS,                MSG_RADIO_IN },
+    { MAVLINK_MSG_ID_RAW_IMU,                    MSG_RAW_IMU1 },
+    { MAVLINK_MSG_ID_SCALED_PRESSURE,            MSG_RAW_IMU2 },
+    { MAVLINK_MSG_ID_SENSOR_OFFSETS,             MSG_RAW_IMU3 },
+    { MAVLINK_MSG_ID_GPS_RAW_INT,                MSG_GPS_RAW },
+    { MAVLINK_MSG_ID_SYSTEM_TIME,                MSG_SYSTEM_TIME },
+    { MAVLINK_MSG_ID_RC_CHANNELS_SCALED,         MSG_SERVO_OUT },
+    { MAVLINK_MSG_ID_AHRS,                       MSG_AHRS },
+    { MAVLINK_MSG_ID_HWSTATUS,                   MSG_HWSTATUS },
+    { MAVLINK_MSG_ID_WIND,                       MSG_WIND },
+    { MAVLINK_MSG_ID_RANGEFINDER,                MSG_RANGEFINDER },
+    { MAVLINK_MSG_ID_BATTERY2,                   MSG_BATTERY2 },
+    { MAVLINK_MSG_ID_MOUNT_STATUS,               MSG_MOUNT_STATUS },
+    { MAVLINK_MSG_ID_OPTICAL_FLOW,               MSG_OPTICAL_FLOW },
+    { MAVLINK_MSG_ID_EKF_STATUS_REPORT,          MSG_EKF_STATUS_REPORT },
+    { MAVLINK_MSG_ID_LOCAL_POSITION_NED,         MSG_LOCAL_POSITION },
+    { MAVLINK_MSG_ID_PID_TUNING,                 MSG_PID_TUNING },
+    { MAVLINK_MSG_ID_VIBRATION,                  MSG_VIBRATION },
+    { MAVLINK_MSG_ID_RPM,                        MSG_RPM },
+    { MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT, MSG_POSITION_TARGET_GLOBAL_INT },
+};
+
+bool GCS_MAVLINK::set_message_interval(enum ap_message id, uint16_t interval_ms)
+{
+    bool schedulable = false;
+    for (uint8_t i=0; i<ARRAY_SIZE(interval_messages); i++) {
+        if (interval_messages[i].msg == id) {
+            schedulable = true;
+            break;
+        }
+    }
+    if (!schedulable) {
+        return false;
+    }
+    _message_interval_ms[id] = interval_ms;
+    _message_last_ms[id] = 0;
+
+    _have_message_intervals = false;
+    for (uint8_t i=0; i<MSG_RETRY_DEFERRED; i++) {
+        if (_message_interval_ms[i] != 0) {
+            _have_message_intervals = true;
+            break;
+        }
+    }
+    return true;
+}
+
+/*
+  handle MAV_CMD_SET_MESSAGE_INTERVAL. param1 is the MAVLink message
+  ID and param2 the interval in microseconds, with -1 meaning disable
+  and 0 meaning the default (stream) rate
+ */
+uint8_t GCS_MAVLINK::handle_command_set_message_interval(const mavlink_command_long_t &packet)
+{
+    const uint32_t mavlink_id = (uint32_t)packet.param1;
+    uint16_t interval_ms;
+    if (packet.param2 < -0.5f) {
+        interval_ms = GCS_MESSAGE_INTERVAL_DISABLED;
+    } else if (packet.param2 < 1000) {
+        interval_ms = 0;
+    } else {
+        interval_ms = MIN(packet.param2 * 0.001f, 60000);
+    }
+    for (uint8_t i=0; i<ARRAY_SIZE(interval_messages); i++) {
+        if (interval_messages[i].mavlink_id == mavlink_id) {
+            if (!set_message_interval(interval_messages[i].msg, interval_ms)) {
+                return MAV_RESULT_FAILED;
+            }
+            return MAV_RESULT_ACCEPTED;
+        }
+    }
+    return MAV_RESULT_UNSUPPORTED;
+}
+
+/*
+  send any messages with their own interval that are due
+ */
+void GCS_MAVLINK::send_interval_messages(void)
+{
+    if (!_have_message_intervals) {
+        return;
+    }
+    const uint32_t now = AP_HAL::millis();
+    for (uint8_t i=0; i<MSG_RETRY_DEFERRED; i++) {
+        const uint16_t interval = _message_interval_ms[i];
+        if (interval == 0 || interval == GCS_MESSAGE_INTERVAL_DISABLED ||
+            now - _message_last_ms[i] < interval) {
+            continue;
+        }
+        if (!stream_budget_ok()) {
+            // leave the rest due until there is room
+            return;
+        }
+        _message_last_ms[i] = now;
+        _sending_interval_message = true;
+        send_message((enum ap_message)i);
+        _sending_interval_message = false;
+    }
+}
+
 void
 GCS_MAVLINK::send_text(MAV_SEVERITY severity, const char *str)
 {
@@ -819,22 +1094,39 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
         goto mission_ack;
     }
 
-    // check if this is the requested waypoint
-    if (seq != waypoint_request_i) {
+    // check if this is a requested waypoint
+    if (seq < waypoint_request_i && waypoint_window > 1) {
+        // a repeat of one we already have
+        return false;
+    }
+    if (seq < waypoint_request_i ||
+        seq >= waypoint_request_i + waypoint_window ||
+        seq >= waypoint_request_last) {
         result = MAV_MISSION_INVALID_SEQUENCE;
         goto mission_ack;
     }
+    if (waypoint_window_received & (1U << (seq - waypoint_request_i))) {
+        return false;
+    }
 
     // sanity check for DO_JUMP command
     if (cmd.id == MAV_CMD_DO_JUMP) {
-        if ((cmd.content.jump.target >= mission.num_commands() && cmd.content.jump.target >= waypoint_request_last) || cmd.content.jump.target == 0) {
+        // a staged upload replaces the whole stored mission
+        const bool beyond_stored = (waypoint_window > 1 || cmd.content.jump.target >= mission.num_commands());
+        if ((beyond_stored && cmd.content.jump.target >= waypoint_request_last) || cmd.content.jump.target == 0) {
             result = MAV_MISSION_ERROR;
             goto mission_ack;
         }
     }
     
+    if (waypoint_window > 1) {
+        // staged upload, items may arrive out of order
+        if (!mission.upload_set(seq, cmd)) {
+            result = MAV_MISSION_ERROR;
+            goto mission_ack;
+        }
     // if command index is within the existing list, replace the command
-    if (seq < mission.num_commands()) {
+    } else if (seq < mission.num_commands()) {
         if (mission.replace_cmd(seq,cmd)) {
             result = MAV_MISSION_ACCEPTED;
         }else{
@@ -855,11 +1147,22 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
         goto mission_ack;
     }
     
-    // update waypoint receiving state machine
+    // update waypoint receiving state machine, moving the window
+    // past the items received in order
     waypoint_timelast_receive = AP_HAL::millis();
-    waypoint_request_i++;
+    waypoint_window_received |= 1U << (seq - waypoint_request_i);
+    while (waypoint_window_received & 1U) {
+        waypoint_window_received >>= 1;
+        waypoint_window_requested >>= 1;
+        waypoint_request_i++;
+    }
     
     if (waypoint_request_i >= waypoint_request_last) {
+        if (waypoint_window > 1 && !mission.upload_commit()) {
+            waypoint_receiving = false;
+            result = MAV_MISSION_ERROR;
+            goto mission_ack;
+        }
         mavlink_msg_mission_ack_send_buf(
             msg,
             chan,
@@ -909,53 +1212,235 @@ GCS_MAVLINK::handle_gps_inject(const mavlink_message_t *msg, AP_GPS &gps)
 // send a message using mavlink, handling message queueing
 void GCS_MAVLINK::send_message(enum ap_message id)
 {
-    uint8_t i, nextid;
-
     if (id == MSG_HEARTBEAT) {
         save_signing_timestamp(false);
     }
+
+    if (id < MSG_RETRY_DEFERRED &&
+        _message_interval_ms[id] != 0 &&
+        !_sending_interval_message) {
+        // this message is sent at its own interval, not with its stream
+        id = MSG_RETRY_DEFERRED;
+    }
     
-    // see if we can send the deferred messages, if any
-    while (num_deferred_messages != 0) {
-        if (!try_send_message(deferred_messages[next_deferred_message])) {
-            break;
-        }
-        next_deferred_message++;
-        if (next_deferred_message == MSG_RETRY_DEFERRED) {
-            next_deferred_message = 0;
+    if (id != MSG_RETRY_DEFERRED) {
+        const uint64_t bit = 1ULL << id;
+        if (_deferred_mask & bit) {
+            // it's already deferred, discard
+            id = MSG_RETRY_DEFERRED;
+        } else {
+            _deferred_mask |= bit;
+            _deferred_since_ms[id] = AP_HAL::millis();
         }
-        num_deferred_messages--;
     }
 
-    if (id == MSG_RETRY_DEFERRED) {
-        return;
+    send_deferred_messages(id);
+}
+
+/*
+  priority of a message waiting for link space. Messages reporting
+  state changes go ahead of regular telemetry, and bulky or
+  diagnostic messages wait until everything else has gone
+ */
+enum GCS_MAVLINK::deferred_priority GCS_MAVLINK::deferred_message_priority(enum ap_message id)
+{
+    switch (id) {
+    case MSG_HEARTBEAT:
+    case MSG_STATUSTEXT:
+    case MSG_NEXT_PARAM:
+    case MSG_NEXT_WAYPOINT:
+    case MSG_CURRENT_WAYPOINT:
+    case MSG_MISSION_ITEM_REACHED:
+    case MSG_MAG_CAL_REPORT:
+        return DEFERRED_PRIORITY_HIGH;
+    case MSG_RAW_IMU1:
+    case MSG_RAW_IMU2:
+    case MSG_RAW_IMU3:
+    case MSG_SERVO_OUT:
+    case MSG_RADIO_OUT:
+    case MSG_SIMSTATE:
+    case MSG_HWSTATUS:
+    case MSG_PID_TUNING:
+    case MSG_VIBRATION:
+    case MSG_RPM:
+    case MSG_TERRAIN:
+    case MSG_GIMBAL_REPORT:
+    case MSG_ADSB_VEHICLE:
+    case MSG_MAG_CAL_PROGRESS:
+        return DEFERRED_PRIORITY_LOW;
+    default:
+        return DEFERRED_PRIORITY_NORMAL;
     }
+}
 
-    // this message id might already be deferred
-    for (i=0, nextid = next_deferred_message; i < num_deferred_messages; i++) {
-        if (deferred_messages[nextid] == id) {
-            // it's already deferred, discard
-            return;
+/*
+  send deferred messages, highest priority first, until one doesn't
+  fit. fresh_id was queued by this call, so its wait isn't counted
+ */
+void GCS_MAVLINK::send_deferred_messages(enum ap_message fresh_id)
+{
+    if (_deferred_mask == 0) {
+        return;
+    }
+    if (fresh_id != MSG_RETRY_DEFERRED && _deferred_mask == (1ULL << fresh_id)) {
+        // nothing else is waiting
+        if (try_send_message(fresh_id)) {
+            _deferred_mask = 0;
         }
-        nextid++;
-        if (nextid == MSG_RETRY_DEFERRED) {
-            nextid = 0;
+        return;
+    }
+    const uint32_t now = AP_HAL::millis();
+    for (uint8_t prio=0; prio<DEFERRED_PRIORITY_COUNT; prio++) {
+        for (uint8_t i=0; i<MSG_RETRY_DEFERRED; i++) {
+            const uint64_t bit = 1ULL << i;
+            if (!(_deferred_mask & bit)) {
+                continue;
+            }
+            const enum ap_message id = (enum ap_message)i;
+            if (deferred_message_priority(id) != prio) {
+                continue;
+            }
+            if (!try_send_message(id)) {
+                return;
+            }
+            _deferred_mask &= ~bit;
+            if (id != fresh_id) {
+                const uint32_t waited_ms = now - _deferred_since_ms[i];
+                _deferred_latency_count++;
+                _deferred_latency_total_ms += waited_ms;
+                _deferred_latency_max_ms = MAX(_deferred_latency_max_ms, waited_ms);
+            }
         }
     }
+}
 
-    if (num_deferred_messages != 0 ||
-        !try_send_message(id)) {
-        // can't send it now, so defer it
-        if (num_deferred_messages == MSG_RETRY_DEFERRED) {
-            // the defer buffer is full, discard
-            return;
-        }
-        nextid = next_deferred_message + num_deferred_messages;
-        if (nextid >= MSG_RETRY_DEFERRED) {
-            nextid -= MSG_RETRY_DEFERRED;
+void GCS_MAVLINK::deferred_latency(uint32_t &count, uint32_t &avg_ms, uint32_t &max_ms) const
+{
+    count = _deferred_latency_count;
+    avg_ms = count ? _deferred_latency_total_ms / count : 0;
+    max_ms = _deferred_latency_max_ms;
+}
+
+/*
+  close the second of link statistics being gathered, once a second
+ */
+void GCS_MAVLINK::update_link_stats(void)
+{
+    const uint32_t now = AP_HAL::millis();
+    if (now - _link_stats.last_ms < 1000) {
+        return;
+    }
+    const uint32_t dt_ms = now - _link_stats.last_ms;
+    _link_stats.last_ms = now;
+
+    struct link_stats &count = _link_stats.count;
+    struct mavlink_tx_stats &tx = mavlink_tx_stats[chan];
+
+    count.tx_bytes = mavlink_tx_bytes[chan] - _link_stats.last_tx_bytes;
+    _link_stats.last_tx_bytes = mavlink_tx_bytes[chan];
+    const mavlink_status_t *cstatus = mavlink_get_channel_status(chan);
+    if (cstatus != NULL) {
+        count.rx_lost = cstatus->packet_rx_drop_count - _link_stats.last_rx_drop_count;
+        _link_stats.last_rx_drop_count = cstatus->packet_rx_drop_count;
+    }
+    count.drop_bytes = tx.drop_bytes;
+    count.drop_frames = tx.drop_frames;
+    count.deferred = __builtin_popcountll(_deferred_mask);
+    for (uint8_t i=0; i<tx.num_msgs; i++) {
+        if (tx.msg[i].bytes > count.top_bytes[0]) {
+            count.top_msgid[1] = count.top_msgid[0];
+            count.top_bytes[1] = count.top_bytes[0];
+            count.top_msgid[0] = tx.msg[i].msgid;
+            count.top_bytes[0] = tx.msg[i].bytes;
+        } else if (tx.msg[i].bytes > count.top_bytes[1]) {
+            count.top_msgid[1] = tx.msg[i].msgid;
+            count.top_bytes[1] = tx.msg[i].bytes;
         }
-        deferred_messages[nextid] = id;
-        num_deferred_messages++;
+    }
+    memset(&tx, 0, sizeof(tx));
+
+    if (dt_ms > 1100) {
+        // the first second, or update() wasn't called for a while;
+        // the counts don't cover a second, so drop them
+        memset(&count, 0, sizeof(count));
+        return;
+    }
+
+    _link_stats.last = count;
+    memset(&count, 0, sizeof(count));
+
+    if (dataflash_p != NULL) {
+        const struct link_stats &last = _link_stats.last;
+        dataflash_p->Log_Write("MAVS",
+                               "TimeUS,Chan,TxB,RxB,RxP,RxE,RxL,DrB,DrF,Def,M1,B1,M2,B2",
+                               "QBIIHHHIHBIIII",
+                               AP_HAL::micros64(),
+                               (uint8_t)chan,
+                               last.tx_bytes,
+                               last.rx_bytes,
+                               last.rx_packets,
+                               last.rx_errors,
+                               last.rx_lost,
+                               last.drop_bytes,
+                               last.drop_frames,
+                               last.deferred,
+                               last.top_msgid[0],
+                               last.top_bytes[0],
+                               last.top_msgid[1],
+                               last.top_bytes[1]);
+    }
+}
+
+/*
+  report one value of the last second of link statistics per call as
+  a NAMED_VALUE_INT, in bytes or counts per second. TXM<id> is the
+  bytes sent of one of the two busiest message IDs
+ */
+void GCS_MAVLINK::send_link_stats(void)
+{
+    if (!HAVE_PAYLOAD_SPACE(chan, NAMED_VALUE_INT)) {
+        return;
+    }
+    const struct link_stats &last = _link_stats.last;
+    const uint8_t num_values = 8;
+    char name[11];
+    int32_t value = 0;
+    switch (_link_stats.report_index) {
+    case 0:
+        strncpy(name, "TX_BPS", sizeof(name));
+        value = last.tx_bytes;
+        break;
+    case 1:
+        strncpy(name, "RX_BPS", sizeof(name));
+        value = last.rx_bytes;
+        break;
+    case 2:
+        strncpy(name, "RX_ERR", sizeof(name));
+        value = last.rx_errors;
+        break;
+    case 3:
+        strncpy(name, "RX_LOST", sizeof(name));
+        value = last.rx_lost;
+        break;
+    case 4:
+        strncpy(name, "TX_DROP", sizeof(name));
+        value = last.drop_bytes;
+        break;
+    case 5:
+        strncpy(name, "DEFERRED", sizeof(name));
+        value = last.deferred;
+        break;
+    default: {
+        const uint8_t i = _link_stats.report_index - 6;
+        hal.util->snprintf(name, sizeof(name), "TXM%u", (unsigned)last.top_msgid[i]);
+        value = last.top_bytes[i];
+        break;
+    }
+    }
+    const bool have_value = _link_stats.report_index < 6 || value != 0;
+    _link_stats.report_index = (_link_stats.report_index + 1) % num_values;
+    if (have_value) {
+        mavlink_msg_named_value_int_send(chan, AP_HAL::millis(), name, value);
     }
 }
 
@@ -967,6 +1452,7 @@ void GCS_MAVLINK::packetReceived(const mavlink_status_t &status,
     if (msg.msgid != MAVLINK_MSG_ID_RADIO && msg.msgid != MAVLINK_MSG_ID_RADIO_STATUS) {
         mavlink_active |= (1U<<(chan-MAVLINK_COMM_0));
     }
+    _link_stats.count.rx_packets++;
     if (!(status.flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) &&
         (status.flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1) &&
         serialmanager_p &&
@@ -999,6 +1485,7 @@ GCS_MAVLINK::update(run_cli_fn run_cli)
 
     // process received bytes
     uint16_t nbytes = comm_get_available(chan);
+    _link_stats.count.rx_bytes += nbytes;
     for (uint16_t i=0; i<nbytes; i++)
     {
         uint8_t c = comm_receive_ch(chan);
@@ -1023,8 +1510,22 @@ GCS_MAVLINK::update(run_cli_fn run_cli)
         if (mavlink_parse_char(chan, c, &msg, &status)) {
             packetReceived(status, msg);
         }
+        // the parser reports the errors since the previous byte here
+        _link_stats.count.rx_errors += status.packet_rx_drop_count;
     }
 
+    update_link_stats();
+
+    serial_passthru_update();
+
+#if HAL_OS_POSIX_IO
+    ftp_update();
+#endif
+
+    send_interval_messages();
+
+    process_param_set_queue();
+
     if (!waypoint_receiving) {
         return;
     }
@@ -1038,6 +1539,8 @@ GCS_MAVLINK::update(run_cli_fn run_cli)
     } else if (waypoint_receiving &&
                (tnow - waypoint_timelast_request) > wp_recv_time) {
         waypoint_timelast_request = tnow;
+        // ask again for everything still missing
+        waypoint_window_requested = 0;
         send_message(MSG_NEXT_WAYPOINT);
     }
 
@@ -1578,14 +2081,15 @@ void GCS_MAVLINK::send_autopilot_version(uint8_t major_version, uint8_t minor_ve
 /*
   send LOCAL_POSITION_NED message
  */
-void GCS_MAVLINK::send_local_position(const AP_AHRS &ahrs) const
+void GCS_MAVLINK::send_local_position(AP_AHRS &ahrs) const
 {
-    Vector3f local_position, velocity;
-    if (!ahrs.get_relative_position_NED(local_position) ||
-        !ahrs.get_velocity_NED(velocity)) {
+    const AP_AHRS::nav_context &nav = ahrs.get_nav_context();
+    if (!nav.have_relative_position_ned || !nav.have_velocity_ned) {
         // we don't know the position and velocity
         return;
     }
+    const Vector3f &local_position = nav.relative_position_ned;
+    const Vector3f &velocity = nav.velocity_ned;
 
     mavlink_msg_local_position_ned_send(
         chan,
@@ -0,0 +1,489 @@
+/*
+  MAVLink FILE_TRANSFER_PROTOCOL file server
+ */
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  A read-only server for the FTP protocol used by QGroundControl and
+  PX4, giving ground tools one bulk channel for the log directory, the
+  terrain directory and the parameters. Parameters are served as the
+  virtual text file GCS_FTP_PARAM_FILE with one "NAME,VALUE" line per
+  parameter, padded with spaces to GCS_FTP_PARAM_LINE_LEN bytes so the
+  file size and the line at an offset are known without formatting
+  every parameter. Nothing outside those directories can be listed or opened.
+
+  Each channel has a single session. Burst reads are streamed from
+  update() as fast as the link allows, from a read-ahead buffer so the
+  storage sees large sequential reads
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include "GCS.h"
+
+#if HAL_OS_POSIX_IO
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+// close a session that sees no requests, and sends no burst, for this long
+#define GCS_FTP_TIMEOUT_MS 10000
+
+// most burst packets sent in one update()
+#define GCS_FTP_BURST_MAX 8
+
+#define GCS_FTP_PARAM_FILE "@PARAM/params.txt"
+
+// length of each line of the parameter file, with its newline. Holds
+// the longest name and a %g value
+#define GCS_FTP_PARAM_LINE_LEN 32
+
+// opcodes
+enum {
+    FTP_OP_NONE = 0,
+    FTP_OP_TERMINATE_SESSION = 1,
+    FTP_OP_RESET_SESSIONS = 2,
+    FTP_OP_LIST_DIRECTORY = 3,
+    FTP_OP_OPEN_FILE_RO = 4,
+    FTP_OP_READ_FILE = 5,
+    FTP_OP_BURST_READ_FILE = 15,
+    FTP_OP_ACK = 128,
+    FTP_OP_NAK = 129,
+};
+
+// NAK error codes
+enum {
+    FTP_ERR_FAIL = 1,
+    FTP_ERR_FAIL_ERRNO = 2,
+    FTP_ERR_INVALID_DATA_SIZE = 3,
+    FTP_ERR_INVALID_SESSION = 4,
+    FTP_ERR_NO_SESSIONS_AVAILABLE = 5,
+    FTP_ERR_EOF = 6,
+    FTP_ERR_UNKNOWN_COMMAND = 7,
+    FTP_ERR_FILE_NOT_FOUND = 10,
+};
+
+/**
+   handle a FILE_TRANSFER_PROTOCOL message
+ */
+void GCS_MAVLINK::handle_file_transfer_protocol(mavlink_message_t *msg)
+{
+    mavlink_file_transfer_protocol_t packet;
+    mavlink_msg_file_transfer_protocol_decode(msg, &packet);
+    if (packet.target_system != mavlink_system.sysid) {
+        return;
+    }
+
+    struct ftp_payload request;
+    memcpy(&request, packet.payload, sizeof(request));
+    if (request.size > sizeof(request.data)) {
+        ftp_send_nak(request, FTP_ERR_INVALID_DATA_SIZE);
+        return;
+    }
+
+    _ftp.last_request_ms = AP_HAL::millis();
+    _ftp.target_system = msg->sysid;
+    _ftp.target_component = msg->compid;
+
+    switch (request.opcode) {
+    case FTP_OP_NONE:
+        ftp_send_reply(request, FTP_OP_ACK, 0, NULL, 0);
+        break;
+
+    case FTP_OP_TERMINATE_SESSION:
+    case FTP_OP_RESET_SESSIONS:
+        ftp_close();
+        ftp_send_reply(request, FTP_OP_ACK, 0, NULL, 0);
+        break;
+
+    case FTP_OP_LIST_DIRECTORY:
+        ftp_list_directory(request);
+        break;
+
+    case FTP_OP_OPEN_FILE_RO:
+        ftp_open(request);
+        break;
+
+    case FTP_OP_READ_FILE: {
+        if (!_ftp.open || request.session != _ftp.session) {
+            ftp_send_nak(request, FTP_ERR_INVALID_SESSION);
+            break;
+        }
+        // a read stops any burst in progress
+        _ftp.bursting = false;
+        uint8_t data[sizeof(request.data)];
+        const uint8_t len = request.size > 0 ? request.size : sizeof(data);
+        const int16_t n = ftp_read(request.offset, data, len);
+        if (n < 0) {
+            ftp_send_nak(request, FTP_ERR_FAIL);
+        } else if (n == 0) {
+            ftp_send_nak(request, FTP_ERR_EOF);
+        } else {
+            ftp_send_reply(request, FTP_OP_ACK, request.offset, data, n);
+        }
+        break;
+    }
+
+    case FTP_OP_BURST_READ_FILE:
+        if (!_ftp.open || request.session != _ftp.session) {
+            ftp_send_nak(request, FTP_ERR_INVALID_SESSION);
+            break;
+        }
+        // packets are sent from ftp_update()
+        _ftp.bursting = true;
+        _ftp.burst_request = request;
+        _ftp.burst_offset = request.offset;
+        break;
+
+    default:
+        // the server is read-only
+        ftp_send_nak(request, FTP_ERR_UNKNOWN_COMMAND);
+        break;
+    }
+}
+
+/*
+  send the next packets of a burst read
+ */
+void GCS_MAVLINK::ftp_update(void)
+{
+    if (!_ftp.open) {
+        return;
+    }
+    if (AP_HAL::millis() - _ftp.last_request_ms > GCS_FTP_TIMEOUT_MS) {
+        // the ground station has gone away
+        ftp_close();
+        return;
+    }
+    for (uint8_t i=0; i<GCS_FTP_BURST_MAX && _ftp.bursting; i++) {
+        if (!HAVE_PAYLOAD_SPACE(chan, FILE_TRANSFER_PROTOCOL)) {
+            return;
+        }
+        struct ftp_payload &request = _ftp.burst_request;
+        uint8_t data[sizeof(request.data)];
+        const int16_t n = ftp_read(_ftp.burst_offset, data, sizeof(data));
+        if (n <= 0) {
+            _ftp.bursting = false;
+            ftp_send_nak(request, n < 0 ? FTP_ERR_FAIL : FTP_ERR_EOF);
+            return;
+        }
+        const bool complete = (_ftp.burst_offset + n >= _ftp.size);
+        request.burst_complete = complete;
+        ftp_send_reply(request, FTP_OP_ACK, _ftp.burst_offset, data, n);
+        // the ground station sends no requests during a burst
+        _ftp.last_request_ms = AP_HAL::millis();
+        request.seq_number++;
+        _ftp.burst_offset += n;
+        if (complete) {
+            _ftp.bursting = false;
+        }
+    }
+}
+
+void GCS_MAVLINK::ftp_send_reply(const struct ftp_payload &request, uint8_t opcode,
+                                 uint32_t offset, const uint8_t *data, uint8_t len)
+{
+    struct ftp_payload reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.seq_number = request.seq_number + 1;
+    reply.session = _ftp.session;
+    reply.opcode = opcode;
+    reply.req_opcode = request.opcode;
+    reply.burst_complete = request.burst_complete;
+    reply.offset = offset;
+    reply.size = len;
+    if (len > 0) {
+        memcpy(reply.data, data, len);
+    }
+
+    uint8_t payload[MAVLINK_MSG_FILE_TRANSFER_PROTOCOL_FIELD_PAYLOAD_LEN] {};
+    memcpy(payload, &reply, sizeof(reply));
+    mavlink_msg_file_transfer_protocol_send(chan, 0, _ftp.target_system, _ftp.target_component, payload);
+}
+
+void GCS_MAVLINK::ftp_send_nak(const struct ftp_payload &request, uint8_t error)
+{
+    uint8_t data[2] = { error, (uint8_t)errno };
+    ftp_send_reply(request, FTP_OP_NAK, 0, data, error == FTP_ERR_FAIL_ERRNO ? 2 : 1);
+}
+
+// the directories which may be served, and the parameter file
+static const char *ftp_roots[] = {
+#ifdef HAL_BOARD_LOG_DIRECTORY
+    HAL_BOARD_LOG_DIRECTORY,
+#endif
+#ifdef HAL_BOARD_TERRAIN_DIRECTORY
+    HAL_BOARD_TERRAIN_DIRECTORY,
+#endif
+    GCS_FTP_PARAM_FILE,
+};
+
+/*
+  copy the path from a request, which may not be nul terminated.
+  Returns false unless it is one of ftp_roots or below one. A path
+  may give a relative root with a leading slash
+ */
+static bool ftp_path(const uint8_t *data, uint8_t size, char *path, uint8_t path_len)
+{
+    uint8_t len = MIN(size, path_len-1);
+    memcpy(path, data, len);
+    path[len] = 0;
+
+    if (strstr(path, "..") != NULL) {
+        return false;
+    }
+    for (uint8_t i=0; i<ARRAY_SIZE(ftp_roots); i++) {
+        const char *root = ftp_roots[i];
+        const char *p = path;
+        if (root[0] != '/' && p[0] == '/') {
+            p++;
+        }
+        const size_t root_len = strlen(root);
+        if (strncmp(p, root, root_len) == 0 && (p[root_len] == 0 || p[root_len] == '/')) {
+            memmove(path, p, strlen(p) + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  list a directory, one entry per nul terminated string starting at
+  entry number offset: "F<name>\t<size>" for files, "D<name>" for
+  directories
+ */
+void GCS_MAVLINK::ftp_list_directory(const struct ftp_payload &request)
+{
+    char path[sizeof(request.data)+1];
+    if (!ftp_path(request.data, request.size, path, sizeof(path))) {
+        ftp_send_nak(request, FTP_ERR_FILE_NOT_FOUND);
+        return;
+    }
+
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        ftp_send_nak(request, FTP_ERR_FILE_NOT_FOUND);
+        return;
+    }
+
+    uint8_t data[sizeof(request.data)];
+    uint8_t len = 0;
+    uint32_t entry = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (entry++ < request.offset) {
+            continue;
+        }
+        char full[sizeof(path) + sizeof(de->d_name) + 1];
+        snprintf(full, sizeof(full), "%s/%s", path, de->d_name);
+        struct stat st;
+        if (stat(full, &st) != 0) {
+            continue;
+        }
+        char item[sizeof(de->d_name) + 16];
+        int n;
+        if (S_ISDIR(st.st_mode)) {
+            n = snprintf(item, sizeof(item), "D%s", de->d_name);
+        } else {
+            n = snprintf(item, sizeof(item), "F%s\t%u", de->d_name, (unsigned)st.st_size);
+        }
+        if (n < 0 || len + n + 1 > (int)sizeof(data)) {
+            // the rest is sent in reply to the next request
+            break;
+        }
+        memcpy(&data[len], item, n + 1);
+        len += n + 1;
+    }
+    closedir(dir);
+
+    if (len == 0) {
+        ftp_send_nak(request, FTP_ERR_EOF);
+    } else {
+        ftp_send_reply(request, FTP_OP_ACK, request.offset, data, len);
+    }
+}
+
+/*
+  open a file for reading, replying with its size
+ */
+void GCS_MAVLINK::ftp_open(const struct ftp_payload &request)
+{
+    if (_ftp.open) {
+        ftp_send_nak(request, FTP_ERR_NO_SESSIONS_AVAILABLE);
+        return;
+    }
+    char path[sizeof(request.data)+1];
+    if (!ftp_path(request.data, request.size, path, sizeof(path))) {
+        ftp_send_nak(request, FTP_ERR_FILE_NOT_FOUND);
+        return;
+    }
+
+    _ftp.readahead = (uint8_t *)malloc(GCS_FTP_READAHEAD_SIZE);
+    if (_ftp.readahead == NULL) {
+        ftp_send_nak(request, FTP_ERR_FAIL);
+        return;
+    }
+    _ftp.readahead_offset = 0;
+    _ftp.readahead_len = 0;
+
+    if (strcmp(path, GCS_FTP_PARAM_FILE) == 0) {
+        _ftp.fd = -1;
+        _ftp.size = ftp_param_size();
+        _ftp.param_vp = NULL;
+    } else {
+        _ftp.fd = ::open(path, O_RDONLY);
+        struct stat st;
+        if (_ftp.fd == -1 || fstat(_ftp.fd, &st) != 0) {
+            if (_ftp.fd != -1) {
+                ::close(_ftp.fd);
+            }
+            free(_ftp.readahead);
+            _ftp.readahead = NULL;
+            ftp_send_nak(request, FTP_ERR_FAIL_ERRNO);
+            return;
+        }
+        _ftp.size = st.st_size;
+    }
+    _ftp.open = true;
+    _ftp.bursting = false;
+    _ftp.session++;
+
+    uint32_t size = _ftp.size;
+    ftp_send_reply(request, FTP_OP_ACK, 0, (const uint8_t *)&size, sizeof(size));
+}
+
+void GCS_MAVLINK::ftp_close(void)
+{
+    if (_ftp.open && _ftp.fd != -1) {
+        ::close(_ftp.fd);
+    }
+    _ftp.fd = -1;
+    free(_ftp.readahead);
+    _ftp.readahead = NULL;
+    _ftp.open = false;
+    _ftp.bursting = false;
+}
+
+/*
+  read from the open file through the read-ahead buffer. Returns the
+  number of bytes read, 0 at end of file or -1 on error
+ */
+int16_t GCS_MAVLINK::ftp_read(uint32_t offset, uint8_t *data, uint8_t len)
+{
+    if (offset >= _ftp.size) {
+        return 0;
+    }
+    if (offset < _ftp.readahead_offset ||
+        offset >= _ftp.readahead_offset + _ftp.readahead_len) {
+        // refill the buffer starting at offset
+        int32_t n;
+        if (_ftp.fd == -1) {
+            n = ftp_param_read(offset, _ftp.readahead, GCS_FTP_READAHEAD_SIZE);
+        } else if (::lseek(_ftp.fd, offset, SEEK_SET) != (off_t)offset) {
+            n = -1;
+        } else {
+            n = ::read(_ftp.fd, _ftp.readahead, GCS_FTP_READAHEAD_SIZE);
+        }
+        if (n <= 0) {
+            _ftp.readahead_len = 0;
+            return n;
+        }
+        _ftp.readahead_offset = offset;
+        _ftp.readahead_len = n;
+    }
+    const uint32_t ofs = offset - _ftp.readahead_offset;
+    len = MIN(len, _ftp.readahead_len - ofs);
+    memcpy(data, &_ftp.readahead[ofs], len);
+    return len;
+}
+
+/*
+  format one parameter line of the virtual parameter file, into a
+  buffer of GCS_FTP_PARAM_LINE_LEN+1 bytes
+ */
+static void ftp_param_line(AP_Param *vp, const AP_Param::ParamToken &token,
+                           enum ap_var_type type, char *line)
+{
+    static_assert(AP_MAX_NAME_SIZE + 14 < GCS_FTP_PARAM_LINE_LEN, "parameter lines too short");
+    char name[AP_MAX_NAME_SIZE+1];
+    vp->copy_name_token(token, name, sizeof(name), true);
+    name[AP_MAX_NAME_SIZE] = 0;
+    int n = hal.util->snprintf(line, GCS_FTP_PARAM_LINE_LEN, "%s,%g", name, (double)vp->cast_to_float(type));
+    n = constrain_int32(n, 0, GCS_FTP_PARAM_LINE_LEN-1);
+    memset(&line[n], ' ', GCS_FTP_PARAM_LINE_LEN-1 - n);
+    line[GCS_FTP_PARAM_LINE_LEN-1] = '\n';
+    line[GCS_FTP_PARAM_LINE_LEN] = 0;
+}
+
+/*
+  size of the virtual parameter file
+ */
+uint32_t GCS_MAVLINK::ftp_param_size(void)
+{
+    return (uint32_t)AP_Param::count_parameters() * GCS_FTP_PARAM_LINE_LEN;
+}
+
+/*
+  read the virtual parameter file. Reads carry on from the line where
+  the last one stopped, and only go back to the first parameter when
+  the ground station asks for an earlier part again
+ */
+int32_t GCS_MAVLINK::ftp_param_read(uint32_t offset, uint8_t *data, uint16_t len)
+{
+    const uint16_t index = offset / GCS_FTP_PARAM_LINE_LEN;
+    uint8_t skip = offset % GCS_FTP_PARAM_LINE_LEN;
+    if (_ftp.param_vp == NULL || index < _ftp.param_index) {
+        _ftp.param_vp = AP_Param::first(&_ftp.param_token, &_ftp.param_type);
+        _ftp.param_index = 0;
+    }
+    while (_ftp.param_vp != NULL && _ftp.param_index < index) {
+        _ftp.param_vp = AP_Param::next_scalar(&_ftp.param_token, &_ftp.param_type);
+        _ftp.param_index++;
+    }
+
+    uint16_t copied = 0;
+    char line[GCS_FTP_PARAM_LINE_LEN+1];
+    while (_ftp.param_vp != NULL && copied < len) {
+        ftp_param_line(_ftp.param_vp, _ftp.param_token, _ftp.param_type, line);
+        const uint16_t count = MIN(GCS_FTP_PARAM_LINE_LEN - skip, len - copied);
+        memcpy(&data[copied], &line[skip], count);
+        copied += count;
+        if (skip + count < GCS_FTP_PARAM_LINE_LEN) {
+            // the next read starts part way through this line
+            break;
+        }
+        skip = 0;
+        _ftp.param_vp = AP_Param::next_scalar(&_ftp.param_token, &_ftp.param_type);
+        _ftp.param_index++;
+    }
+    return copied;
+}
+
+#else
+
+void GCS_MAVLINK::handle_file_transfer_protocol(mavlink_message_t *msg)
+{
+    // no filesystem to serve
+}
+
+#endif // HAL_OS_POSIX_IO
@@ -151,17 +151,25 @@ void GCS_MAVLINK::handle_log_send(DataFlash_Class &dataflash)
         return;
     }
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // reads are served from the DataFlash_File read-ahead, so on a
+    // fast link keep sending until the transmit buffer is full
+    const uint8_t fast_sends = 250;
+#else
+    const uint8_t fast_sends = 40;
+#endif
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     // assume USB speeds in SITL for the purposes of log download
-    const uint8_t num_sends = 40;
+    const uint8_t num_sends = fast_sends;
 #else
     uint8_t num_sends = 1;
     if (chan == MAVLINK_COMM_0 && hal.gpio->usb_connected()) {
         // when on USB we can send a lot more data
-        num_sends = 40;
+        num_sends = fast_sends;
     } else if (have_flow_control()) {
     #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
-        num_sends = 80;
+        num_sends = fast_sends;
     #else
         num_sends = 10;
     #endif
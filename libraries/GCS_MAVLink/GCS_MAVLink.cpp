@@ -32,6 +32,8 @@ This provides some support code and variables for MAVLink enabled sketches
 #endif
 
 AP_HAL::UARTDriver	*mavlink_comm_port[MAVLINK_COMM_NUM_BUFFERS];
+uint32_t mavlink_tx_bytes[MAVLINK_COMM_NUM_BUFFERS];
+struct mavlink_tx_stats mavlink_tx_stats[MAVLINK_COMM_NUM_BUFFERS];
 
 mavlink_system_t mavlink_system = {7,1};
 
@@ -66,6 +68,44 @@ void GCS_MAVLINK::lock_channel(mavlink_channel_t _chan, bool lock)
     }
 }
 
+#if GCS_MAVLINK_CRC_TABLE
+// X.25 CRC (reflected polynomial 0x8408) of each byte value
+const uint16_t mavlink_crc_table[256] = {
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+    0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+    0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+    0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+    0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+    0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+    0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+    0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+    0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+    0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+    0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+    0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+    0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+    0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+    0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+    0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+    0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78,
+};
+#endif
+
 // return a MAVLink variable type given a AP_Param type
 uint8_t mav_var_type(enum ap_var_type t)
 {
@@ -135,6 +175,73 @@ uint16_t comm_get_available(mavlink_channel_t chan)
     return (uint16_t)bytes;
 }
 
+// frame being written in place, see comm_send_start()
+static struct {
+    ByteBuffer::IoVec vec[2];
+    uint8_t nvec;
+    uint16_t len;
+    uint16_t ofs;
+    bool at_header;     // next buffer starts the frame
+    bool dropped;
+    uint8_t stats_idx;  // entry of mavlink_tx_stats.msg, or MAVLINK_TX_STATS_MSGS
+} comm_tx_frame[MAVLINK_COMM_NUM_BUFFERS];
+
+/*
+  find the link statistics entry for the message in a frame header,
+  adding it if there is room
+ */
+static uint8_t comm_tx_stats_index(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
+{
+    uint32_t msgid;
+    if (len >= 10 && buf[0] == MAVLINK_STX) {
+        msgid = buf[7] | (buf[8]<<8) | ((uint32_t)buf[9]<<16);
+    } else if (len >= 6 && buf[0] == MAVLINK_STX_MAVLINK1) {
+        msgid = buf[5];
+    } else {
+        return MAVLINK_TX_STATS_MSGS;
+    }
+    struct mavlink_tx_stats &stats = mavlink_tx_stats[chan];
+    for (uint8_t i=0; i<stats.num_msgs; i++) {
+        if (stats.msg[i].msgid == msgid) {
+            return i;
+        }
+    }
+    if (stats.num_msgs == MAVLINK_TX_STATS_MSGS) {
+        return MAVLINK_TX_STATS_MSGS;
+    }
+    stats.msg[stats.num_msgs].msgid = msgid;
+    stats.msg[stats.num_msgs].bytes = 0;
+    return stats.num_msgs++;
+}
+
+void comm_send_start(mavlink_channel_t chan, uint16_t len)
+{
+    if (!valid_channel(chan)) {
+        return;
+    }
+    comm_tx_frame[chan].nvec = mavlink_comm_port[chan]->tx_reserve(comm_tx_frame[chan].vec, len);
+    comm_tx_frame[chan].len = comm_tx_frame[chan].nvec ? len : 0;
+    comm_tx_frame[chan].ofs = 0;
+    comm_tx_frame[chan].at_header = true;
+    comm_tx_frame[chan].dropped = false;
+}
+
+void comm_send_end(mavlink_channel_t chan)
+{
+    if (!valid_channel(chan)) {
+        return;
+    }
+    if (comm_tx_frame[chan].dropped) {
+        mavlink_tx_stats[chan].drop_frames++;
+    }
+    comm_tx_frame[chan].at_header = false;
+    if (comm_tx_frame[chan].nvec == 0) {
+        return;
+    }
+    mavlink_comm_port[chan]->tx_commit(comm_tx_frame[chan].ofs);
+    comm_tx_frame[chan].nvec = 0;
+}
+
 /*
   send a buffer out a MAVLink channel
  */
@@ -143,7 +250,43 @@ void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len)
     if (!valid_channel(chan)) {
         return;
     }
-    mavlink_comm_port[chan]->write(buf, len);
+    mavlink_tx_bytes[chan] += len;
+    if (comm_tx_frame[chan].at_header) {
+        comm_tx_frame[chan].at_header = false;
+        comm_tx_frame[chan].stats_idx = comm_tx_stats_index(chan, buf, len);
+    }
+    if (comm_tx_frame[chan].stats_idx < MAVLINK_TX_STATS_MSGS) {
+        mavlink_tx_stats[chan].msg[comm_tx_frame[chan].stats_idx].bytes += len;
+    } else {
+        mavlink_tx_stats[chan].other_bytes += len;
+    }
+    if (comm_tx_frame[chan].nvec == 0) {
+        const size_t written = mavlink_comm_port[chan]->write(buf, len);
+        if (written < len) {
+            mavlink_tx_stats[chan].drop_bytes += len - written;
+            comm_tx_frame[chan].dropped = true;
+        }
+        return;
+    }
+    // copy into the reserved space, which may wrap around the end of
+    // the ring
+    if (comm_tx_frame[chan].ofs + len > comm_tx_frame[chan].len) {
+        len = comm_tx_frame[chan].len - comm_tx_frame[chan].ofs;
+    }
+    uint32_t ofs = comm_tx_frame[chan].ofs;
+    comm_tx_frame[chan].ofs += len;
+    for (uint8_t i=0; i<comm_tx_frame[chan].nvec && len > 0; i++) {
+        const ByteBuffer::IoVec &v = comm_tx_frame[chan].vec[i];
+        if (ofs >= v.len) {
+            ofs -= v.len;
+            continue;
+        }
+        const uint32_t n = MIN(v.len - ofs, len);
+        memcpy(v.data + ofs, buf, n);
+        buf += n;
+        len -= n;
+        ofs = 0;
+    }
 }
 
 extern const AP_HAL::HAL& hal;
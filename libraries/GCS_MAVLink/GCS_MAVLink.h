@@ -12,6 +12,11 @@
 
 #define MAVLINK_SEND_UART_BYTES(chan, buf, len) comm_send_buffer(chan, buf, len)
 
+// write each frame straight into the port's transmit buffer where the
+// port supports it
+#define MAVLINK_START_UART_SEND(chan, len) comm_send_start(chan, len)
+#define MAVLINK_END_UART_SEND(chan, len) comm_send_end(chan)
+
 // allow five telemetry ports
 #define MAVLINK_COMM_NUM_BUFFERS 5
 
@@ -26,11 +31,51 @@
 
 #define MAVLINK_MAX_PAYLOAD_LEN 255
 
+// use a table for the X.25 frame CRC instead of the bitwise version
+// in checksum.h, on boards where the 512 byte table is cheap to read
+#ifndef GCS_MAVLINK_CRC_TABLE
+#define GCS_MAVLINK_CRC_TABLE (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+#if GCS_MAVLINK_CRC_TABLE
+extern const uint16_t mavlink_crc_table[256];
+
+#define HAVE_CRC_ACCUMULATE
+static inline void crc_accumulate(uint8_t data, uint16_t *crcAccum)
+{
+    *crcAccum = (*crcAccum >> 8) ^ mavlink_crc_table[(*crcAccum ^ data) & 0xff];
+}
+#endif
+
 #include "include/mavlink/v2.0/mavlink_types.h"
 
 /// MAVLink stream used for uartA
 extern AP_HAL::UARTDriver	*mavlink_comm_port[MAVLINK_COMM_NUM_BUFFERS];
 
+/// count of bytes sent on each channel, used for bandwidth budgeting
+extern uint32_t mavlink_tx_bytes[MAVLINK_COMM_NUM_BUFFERS];
+
+// number of message IDs whose bytes are counted on each channel
+#define MAVLINK_TX_STATS_MSGS 16
+
+/*
+  what was sent on each channel since GCS_MAVLINK last collected it
+  for the link statistics. Bytes are counted against the message ID
+  of their frame, in the order IDs are first sent, with the rest
+  counted as other_bytes once the table is full
+ */
+struct mavlink_tx_stats {
+    struct {
+        uint32_t msgid;
+        uint32_t bytes;
+    } msg[MAVLINK_TX_STATS_MSGS];
+    uint8_t num_msgs;
+    uint32_t other_bytes;
+    uint32_t drop_bytes;        // bytes the port had no room for
+    uint16_t drop_frames;       // frames which lost any bytes
+};
+extern struct mavlink_tx_stats mavlink_tx_stats[MAVLINK_COMM_NUM_BUFFERS];
+
 /// MAVLink system definition
 extern mavlink_system_t mavlink_system;
 
@@ -55,11 +100,20 @@ static inline void comm_send_ch(mavlink_channel_t chan, uint8_t ch)
     if (!valid_channel(chan)) {
         return;
     }
+    mavlink_tx_bytes[chan]++;
     mavlink_comm_port[chan]->write(ch);
 }
 
 void comm_send_buffer(mavlink_channel_t chan, const uint8_t *buf, uint8_t len);
 
+/*
+  bracket the writes of one frame of len bytes. If the port can take
+  the whole frame, comm_send_buffer() copies into the reserved space
+  and comm_send_end() commits it in one go
+ */
+void comm_send_start(mavlink_channel_t chan, uint16_t len);
+void comm_send_end(mavlink_channel_t chan);
+
 /// Read a byte from the nominated MAVLink channel
 ///
 /// @param chan		Channel to receive on
@@ -24,6 +24,16 @@
 
 extern const AP_HAL::HAL& hal;
 
+// buffer sizes requested when a passthrough sets the baudrate
+#define SERIAL_PASSTHRU_RX_BUFSIZE 2048
+#define SERIAL_PASSTHRU_TX_BUFSIZE 2048
+
+// streaming stops if the ground station sends nothing for this long
+#define SERIAL_PASSTHRU_TIMEOUT_MS 3000
+
+// longest a streaming write waits for space in the device buffer
+#define SERIAL_PASSTHRU_WRITE_WAIT_MS 20
+
 /**
    handle a SERIAL_CONTROL message
  */
@@ -74,33 +84,65 @@ void GCS_MAVLINK::handle_serial_control(mavlink_message_t *msg, AP_GPS &gps)
         port->set_flow_control(AP_HAL::UARTDriver::FLOW_CONTROL_DISABLE);
     }
 
+    // streaming passthrough from the device is used when the ground
+    // station holds it exclusively and accepts multiple replies
+    const bool streaming = exclusive &&
+        (packet.flags & SERIAL_CONTROL_FLAG_RESPOND) &&
+        (packet.flags & SERIAL_CONTROL_FLAG_MULTI);
+
     // optionally change the baudrate
     if (packet.baudrate != 0 && port != NULL) {
-        port->begin(packet.baudrate);
+        if (streaming) {
+            // large buffers let bulk transfers run without stalls
+            port->begin(packet.baudrate, SERIAL_PASSTHRU_RX_BUFSIZE, SERIAL_PASSTHRU_TX_BUFSIZE);
+        } else {
+            port->begin(packet.baudrate);
+        }
     }
 
     // write the data
     if (packet.count != 0) {
-        if ((packet.flags & SERIAL_CONTROL_FLAG_BLOCKING) == 0) {
+        if ((packet.flags & SERIAL_CONTROL_FLAG_BLOCKING) == 0 && !streaming) {
             stream->write(packet.data, packet.count);
         } else {
+            // wait for space in the device buffer. A streaming write
+            // gives up after a short wait so a stalled device can't
+            // stall the vehicle
             const uint8_t *data = &packet.data[0];
             uint8_t count = packet.count;
+            const uint32_t start_ms = AP_HAL::millis();
             while (count > 0) {
-                while (stream->txspace() <= 0) {
-                    hal.scheduler->delay(5);
+                int16_t space = stream->txspace();
+                if (space <= 0) {
+                    if (streaming && AP_HAL::millis() - start_ms > SERIAL_PASSTHRU_WRITE_WAIT_MS) {
+                        break;
+                    }
+                    hal.scheduler->delay(streaming?1:5);
+                    continue;
                 }
-                uint16_t n = stream->txspace();
-                if (n > packet.count) {
-                    n = packet.count;
+                uint16_t n = space;
+                if (n > count) {
+                    n = count;
                 }
-                stream->write(data, n);                
+                stream->write(data, n);
                 data += n;
                 count -= n;
             }
         }
     }
 
+    if (streaming) {
+        // replies are sent from serial_passthru_update()
+        _serial_passthru.stream = stream;
+        _serial_passthru.device = packet.device;
+        _serial_passthru.last_request_ms = AP_HAL::millis();
+        return;
+    }
+    if (_serial_passthru.stream != NULL && _serial_passthru.device == packet.device) {
+        // the ground station has released the device
+        _serial_passthru.stream = NULL;
+    }
+
     if ((packet.flags & SERIAL_CONTROL_FLAG_RESPOND) == 0) {
         // no response expected
         return;
@@ -163,3 +205,50 @@ more_data:
         goto more_data;
     }
 }
+
+/*
+  send one SERIAL_CONTROL reply with the data available from a
+  stream. Returns false if there was no data or no space to send it
+ */
+bool GCS_MAVLINK::send_serial_control_reply(AP_HAL::Stream *stream, uint8_t device, uint8_t flags)
+{
+    int16_t available = stream->available();
+    if (available <= 0 || !HAVE_PAYLOAD_SPACE(chan, SERIAL_CONTROL)) {
+        return false;
+    }
+    mavlink_serial_control_t packet {};
+    packet.device = device;
+    packet.flags = flags;
+    while (available > 0 && packet.count < sizeof(packet.data)) {
+        packet.data[packet.count++] = (uint8_t)stream->read();
+        available--;
+    }
+    _mav_finalize_message_chan_send(chan,
+                                    MAVLINK_MSG_ID_SERIAL_CONTROL,
+                                    (const char *)&packet,
+                                    MAVLINK_MSG_ID_SERIAL_CONTROL_MIN_LEN,
+                                    MAVLINK_MSG_ID_SERIAL_CONTROL_LEN,
+                                    MAVLINK_MSG_ID_SERIAL_CONTROL_CRC);
+    return true;
+}
+
+/*
+  stream data from a passthrough device back to the ground station,
+  called on every GCS update. Replies are sent back to back while
+  there is data and space on the link, so throughput is set by the
+  link rather than by the ground station's request rate
+ */
+void GCS_MAVLINK::serial_passthru_update(void)
+{
+    if (_serial_passthru.stream == NULL) {
+        return;
+    }
+    if (AP_HAL::millis() - _serial_passthru.last_request_ms > SERIAL_PASSTHRU_TIMEOUT_MS) {
+        // the ground station has gone away, device locks stay as set
+        _serial_passthru.stream = NULL;
+        return;
+    }
+    while (send_serial_control_reply(_serial_passthru.stream, _serial_passthru.device,
+                                     SERIAL_CONTROL_FLAG_REPLY | SERIAL_CONTROL_FLAG_MULTI)) {
+    }
+}
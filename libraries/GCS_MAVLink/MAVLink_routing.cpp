@@ -27,7 +27,14 @@ extern const AP_HAL::HAL& hal;
 #define ROUTING_DEBUG 0
 
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) :
+    num_routes(0),
+    all_channels(0),
+    last_expire_ms(0)
+{
+    memset(routes, 0, sizeof(routes));
+    memset(systems, 0, sizeof(systems));
+}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -135,32 +142,18 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
     }
 
     // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-            if (in_channel != routes[i].channel && !sent_to_chan[routes[i].channel]) {
-                if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg->len) +
-                    GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
-#if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg->msgid,
-                             (unsigned)in_channel,
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
-#endif
-                    _mavlink_resend_uart(routes[i].channel, msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
-        }
+    uint8_t mask;
+    if (broadcast_system) {
+        mask = all_channels;
+    } else if (match_system && !broadcast_component) {
+        // another component of our own system
+        const struct route *r = find_route(target_system, target_component);
+        mask = r ? r->channels : 0;
+    } else {
+        // any component of the target system
+        mask = system_channels(target_system);
     }
+    bool forwarded = forward_on_channels(in_channel, mask, msg);
     if (!forwarded && match_system) {
         process_locally = true;
     }
@@ -168,6 +161,36 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
     return process_locally;
 }
 
+/*
+  forward a message on each channel in mask other than in_channel.
+  Returns true if there was any such channel, even if it had no room
+  for the message
+ */
+bool MAVLink_routing::forward_on_channels(mavlink_channel_t in_channel, uint8_t mask, const mavlink_message_t* msg)
+{
+    mask &= ~(1U<<(in_channel-MAVLINK_COMM_0));
+    if (mask == 0) {
+        return false;
+    }
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(mask & (1U<<i))) {
+            continue;
+        }
+        mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) >= ((uint16_t)msg->len) +
+            GCS_MAVLINK::packet_overhead_chan(channel)) {
+#if ROUTING_DEBUG
+            ::printf("fwd msg %u from chan %u on chan %u\n",
+                     msg->msgid,
+                     (unsigned)in_channel,
+                     (unsigned)channel);
+#endif
+            _mavlink_resend_uart(channel, msg);
+        }
+    }
+    return true;
+}
+
 /*
   send a MAVLink message to all components with this vehicle's system id
 
@@ -175,24 +198,20 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
 */
 void MAVLink_routing::send_to_components(const mavlink_message_t* msg)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if ((routes[i].sysid == mavlink_system.sysid) && !sent_to_chan[routes[i].channel]) {
-            if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg->len) +
-                GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+    const uint8_t mask = system_channels(mavlink_system.sysid);
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if (!(mask & (1U<<i))) {
+            continue;
+        }
+        mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) >= ((uint16_t)msg->len) +
+            GCS_MAVLINK::packet_overhead_chan(channel)) {
 #if ROUTING_DEBUG
-                ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
-                         msg->msgid,
-                         (unsigned)routes[i].channel,
-                         (unsigned)routes[i].sysid,
-                         (unsigned)routes[i].compid);
+            ::printf("send msg %u on chan %u\n",
+                     msg->msgid,
+                     (unsigned)channel);
 #endif
-                _mavlink_resend_uart(routes[i].channel, msg);
-                sent_to_chan[routes[i].channel] = true;
-            }
+            _mavlink_resend_uart(channel, msg);
         }
     }
 }
@@ -204,11 +223,12 @@ void MAVLink_routing::send_to_components(const mavlink_message_t* msg)
 bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel)
 {
     // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].mavtype == mavtype) {
+    for (uint8_t i=0; i<MAVLINK_ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid != 0 && routes[i].mavtype == mavtype) {
             sysid = routes[i].sysid;
             compid = routes[i].compid;
-            channel = routes[i].channel;
+            // report the lowest channel it was seen on
+            channel = (mavlink_channel_t)(MAVLINK_COMM_0 + __builtin_ctz(routes[i].channels));
             return true;
         }
     }
@@ -217,35 +237,136 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
     return false;
 }
 
+/*
+  find the learned route for a sysid/compid pair
+ */
+const struct MAVLink_routing::route *MAVLink_routing::find_route(uint8_t sysid, uint8_t compid) const
+{
+    uint8_t i = route_hash(sysid, compid);
+    // the table is never full, so an empty slot ends the search
+    while (routes[i].sysid != 0) {
+        if (routes[i].sysid == sysid && routes[i].compid == compid) {
+            return &routes[i];
+        }
+        i = (i + 1) & (MAVLINK_ROUTE_TABLE_SIZE-1);
+    }
+    return nullptr;
+}
+
+/*
+  return the mask of channels any component of sysid was seen on
+ */
+uint8_t MAVLink_routing::system_channels(uint8_t sysid) const
+{
+    uint8_t i = route_hash(sysid, 0);
+    while (systems[i].sysid != 0) {
+        if (systems[i].sysid == sysid) {
+            return systems[i].channels;
+        }
+        i = (i + 1) & (MAVLINK_ROUTE_TABLE_SIZE-1);
+    }
+    return 0;
+}
+
+void MAVLink_routing::add_system_channel(uint8_t sysid, uint8_t channel_bit)
+{
+    uint8_t i = route_hash(sysid, 0);
+    while (systems[i].sysid != 0 && systems[i].sysid != sysid) {
+        i = (i + 1) & (MAVLINK_ROUTE_TABLE_SIZE-1);
+    }
+    systems[i].sysid = sysid;
+    systems[i].channels |= channel_bit;
+    all_channels |= channel_bit;
+}
+
+/*
+  forget routes which have not been heard from for
+  MAVLINK_ROUTE_TIMEOUT_MS. Entries are removed by shifting later
+  members of the probe sequence back, so no tombstones are needed
+ */
+void MAVLink_routing::expire_routes(uint32_t now_ms)
+{
+    last_expire_ms = now_ms;
+
+    bool expired = false;
+    for (uint8_t i=0; i<MAVLINK_ROUTE_TABLE_SIZE; i++) {
+        while (routes[i].sysid != 0 &&
+               now_ms - routes[i].last_ms > MAVLINK_ROUTE_TIMEOUT_MS) {
+#if ROUTING_DEBUG
+            ::printf("expired route %u %u\n",
+                     (unsigned)routes[i].sysid,
+                     (unsigned)routes[i].compid);
+#endif
+            uint8_t hole = i;
+            uint8_t j = i;
+            while (true) {
+                j = (j + 1) & (MAVLINK_ROUTE_TABLE_SIZE-1);
+                if (routes[j].sysid == 0) {
+                    break;
+                }
+                const uint8_t home = route_hash(routes[j].sysid, routes[j].compid);
+                // entries whose home slot lies cyclically in (hole, j]
+                // are still reachable and stay where they are
+                const bool stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+                if (!stays) {
+                    routes[hole] = routes[j];
+                    hole = j;
+                }
+            }
+            memset(&routes[hole], 0, sizeof(routes[hole]));
+            num_routes--;
+            expired = true;
+        }
+    }
+    if (!expired) {
+        return;
+    }
+
+    // rebuild the per-system table from the remaining routes
+    memset(systems, 0, sizeof(systems));
+    all_channels = 0;
+    for (uint8_t i=0; i<MAVLINK_ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].sysid != 0) {
+            add_system_channel(routes[i].sysid, routes[i].channels);
+        }
+    }
+}
+
 /*
   see if the message is for a new route and learn it
 */
 void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_message_t* msg)
 {
-    uint8_t i;
     if (msg->sysid == 0 || 
         (msg->sysid == mavlink_system.sysid && 
          msg->compid == mavlink_system.compid)) {
         return;
     }
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg->sysid && 
-            routes[i].compid == msg->compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(msg);
-            }
-            break;
-        }
+
+    const uint32_t now = AP_HAL::millis();
+    if (now - last_expire_ms > 1000) {
+        expire_routes(now);
+    }
+
+    uint8_t i = route_hash(msg->sysid, msg->compid);
+    while (routes[i].sysid != 0 &&
+           (routes[i].sysid != msg->sysid || routes[i].compid != msg->compid)) {
+        i = (i + 1) & (MAVLINK_ROUTE_TABLE_SIZE-1);
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg->sysid;
-        routes[i].compid = msg->compid;
-        routes[i].channel = in_channel;
-        if (msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(msg);
+    struct route &r = routes[i];
+    if (r.sysid == 0) {
+        if (num_routes >= MAVLINK_MAX_ROUTES) {
+            // table is full
+            return;
         }
+        r.sysid = msg->sysid;
+        r.compid = msg->compid;
         num_routes++;
+    }
+    const uint8_t channel_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+    if (!(r.channels & channel_bit)) {
+        r.channels |= channel_bit;
+        add_system_channel(r.sysid, channel_bit);
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
                  (unsigned)msg->sysid, 
@@ -253,6 +374,10 @@ void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_me
                  (unsigned)in_channel);
 #endif
     }
+    if (r.mavtype == 0 && msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r.mavtype = mavlink_msg_heartbeat_get_type(msg);
+    }
+    r.last_ms = now;
 }
 
 
@@ -273,10 +398,9 @@ void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavli
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg->sysid && routes[i].compid == msg->compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
+    const struct route *r = find_route(msg->sysid, msg->compid);
+    if (r != nullptr) {
+        mask &= ~r->channels;
     }
 
     if (mask == 0) {
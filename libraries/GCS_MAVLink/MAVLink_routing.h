@@ -6,9 +6,15 @@
 #include <AP_Common/AP_Common.h>
 #include "GCS_MAVLink.h"
 
-// 20 routes should be enough for now. This may need to increase as
-// we make more extensive use of MAVLink forwarding
-#define MAVLINK_MAX_ROUTES 20
+// maximum number of sysid/compid pairs we will learn routes for
+#define MAVLINK_MAX_ROUTES 32
+
+// size of the route hash tables. Must be a power of 2, and at least
+// twice MAVLINK_MAX_ROUTES to keep probe sequences short
+#define MAVLINK_ROUTE_TABLE_SIZE 64
+
+// routes not heard from for this long are forgotten
+#define MAVLINK_ROUTE_TIMEOUT_MS 30000
 
 /*
   object to handle MAVLink packet routing
@@ -42,16 +48,54 @@ public:
     bool find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel);
 
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    /*
+      open-addressed hash table of learned routes keyed on
+      sysid/compid, using linear probing. A sysid of zero marks an
+      empty slot, as we never learn routes for sysid 0. A component
+      seen on several channels has one entry with a bit per channel
+     */
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
-        mavlink_channel_t channel;
+        uint8_t channels;
         uint8_t mavtype;
-    } routes[MAVLINK_MAX_ROUTES];
-    
+        uint32_t last_ms;
+    } routes[MAVLINK_ROUTE_TABLE_SIZE];
+
+    // channels reachable per sysid, for messages targeted at a
+    // system rather than a component. Same layout as routes
+    struct system_route {
+        uint8_t sysid;
+        uint8_t channels;
+    } systems[MAVLINK_ROUTE_TABLE_SIZE];
+
+    // union of all route channels, for broadcasts
+    uint8_t all_channels;
+
+    // time of the last check for routes to expire
+    uint32_t last_expire_ms;
+
+    static uint8_t route_hash(uint8_t sysid, uint8_t compid) {
+        return (uint8_t)((sysid * 131U + compid * 29U) & (MAVLINK_ROUTE_TABLE_SIZE-1));
+    }
+
+    // find the route for sysid/compid, or nullptr
+    const struct route *find_route(uint8_t sysid, uint8_t compid) const;
+
+    // return mask of channels we have seen sysid on
+    uint8_t system_channels(uint8_t sysid) const;
+
+    // add a channel to the per-system table
+    void add_system_channel(uint8_t sysid, uint8_t channel_bit);
+
+    // forget routes we have not heard from recently
+    void expire_routes(uint32_t now_ms);
+
+    // forward msg on each channel in mask except in_channel;
+    // returns true if there was at least one such channel
+    bool forward_on_channels(mavlink_channel_t in_channel, uint8_t mask, const mavlink_message_t* msg);
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
     
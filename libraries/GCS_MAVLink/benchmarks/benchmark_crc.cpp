@@ -0,0 +1,59 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <GCS_MAVLink/GCS.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+/*
+  measure the cost of the frame CRC and of signing a frame, the two
+  per-byte costs of every message sent or received
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const AP_Param::GroupInfo GCS_MAVLINK::var_info[] = {
+    AP_GROUPEND
+};
+
+// CRC over a payload of the given length
+static void BM_FrameCRC(benchmark::State& state)
+{
+    uint8_t buf[MAVLINK_MAX_PAYLOAD_LEN];
+    const uint16_t len = state.range(0);
+    for (uint16_t i=0; i<len; i++) {
+        buf[i] = i * 7;
+    }
+
+    while (state.KeepRunning()) {
+        uint16_t crc = crc_calculate(buf, len);
+        gbenchmark_escape(&crc);
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+
+// signature of a frame with a payload of the given length
+static void BM_FrameSign(benchmark::State& state)
+{
+    mavlink_signing_t signing {};
+    signing.flags = MAVLINK_SIGNING_FLAG_SIGN_OUTGOING;
+    for (uint8_t i=0; i<sizeof(signing.secret_key); i++) {
+        signing.secret_key[i] = i;
+    }
+    uint8_t header[MAVLINK_CORE_HEADER_LEN+1] {};
+    uint8_t payload[MAVLINK_MAX_PAYLOAD_LEN] {};
+    const uint8_t crc[2] {};
+    uint8_t signature[MAVLINK_SIGNATURE_BLOCK_LEN];
+    const uint8_t len = state.range(0);
+
+    while (state.KeepRunning()) {
+        mavlink_sign_packet(&signing, signature, header, sizeof(header),
+                            payload, len, crc);
+        gbenchmark_escape(signature);
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+
+BENCHMARK(BM_FrameCRC)->Arg(9)->Arg(28)->Arg(255);
+BENCHMARK(BM_FrameSign)->Arg(9)->Arg(28)->Arg(255);
+
+BENCHMARK_MAIN()
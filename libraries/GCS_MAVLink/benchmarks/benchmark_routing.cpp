@@ -0,0 +1,68 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <GCS_MAVLink/GCS.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+/*
+  measure the cost of routing a packet as the number of learned
+  components grows. No ports are open, so this times the routing
+  decision rather than the UART writes
+ */
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const AP_Param::GroupInfo GCS_MAVLINK::var_info[] = {
+    AP_GROUPEND
+};
+
+// learn count components spread over four systems and all channels
+static void learn_components(MAVLink_routing &routing, uint8_t count)
+{
+    mavlink_message_t msg;
+    mavlink_heartbeat_t heartbeat {};
+    for (uint8_t i=0; i<count; i++) {
+        mavlink_msg_heartbeat_encode(10 + (i % 4), 100 + i, &msg, &heartbeat);
+        routing.check_and_forward((mavlink_channel_t)(MAVLINK_COMM_0 + (i % MAVLINK_COMM_NUM_BUFFERS)), &msg);
+    }
+}
+
+// messages from a GCS targeted at one component
+static void BM_RouteTargeted(benchmark::State& state)
+{
+    MAVLink_routing routing;
+    const uint8_t count = state.range(0);
+    learn_components(routing, count);
+
+    mavlink_message_t msg;
+    mavlink_param_set_t param_set {};
+    param_set.target_system = 10;
+    param_set.target_component = 100 + count - 1;
+    mavlink_msg_param_set_encode(255, 190, &msg, &param_set);
+
+    while (state.KeepRunning()) {
+        bool local = routing.check_and_forward(MAVLINK_COMM_0, &msg);
+        gbenchmark_escape(&local);
+    }
+}
+
+// broadcast messages, forwarded on every channel with a route
+static void BM_RouteBroadcast(benchmark::State& state)
+{
+    MAVLink_routing routing;
+    learn_components(routing, state.range(0));
+
+    mavlink_message_t msg;
+    mavlink_attitude_t attitude {};
+    mavlink_msg_attitude_encode(255, 190, &msg, &attitude);
+
+    while (state.KeepRunning()) {
+        bool local = routing.check_and_forward(MAVLINK_COMM_0, &msg);
+        gbenchmark_escape(&local);
+    }
+}
+
+BENCHMARK(BM_RouteTargeted)->Arg(2)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK(BM_RouteBroadcast)->Arg(2)->Arg(8)->Arg(16)->Arg(32);
+
+BENCHMARK_MAIN()
@@ -192,14 +192,19 @@ RC_Channel::set_pwm(int16_t pwm)
 }
 
 /*
-  call read() and set_pwm() on all channels
+  read all channels from the RCInput in one call, then call set_pwm()
+  on each of them. Call this once per new RC frame
  */
 void
 RC_Channel::set_pwm_all(void)
 {
+    // not every HAL fills in the channels past the count it returns
+    uint16_t periods[RC_MAX_CHANNELS] {};
+    hal.rcin->read(periods, RC_MAX_CHANNELS);
+
     for (uint8_t i=0; i<RC_MAX_CHANNELS; i++) {
         if (_rc_ch[i] != NULL) {
-            _rc_ch[i]->set_pwm(_rc_ch[i]->read());
+            _rc_ch[i]->set_pwm(periods[i]);
         }
     }
 }
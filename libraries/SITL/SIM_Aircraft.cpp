@@ -17,6 +17,8 @@
 */
 
 #include "SIM_Aircraft.h"
+#include "SIM_Noise.h"
+#include "SIM_SRTM.h"
 
 #include <stdio.h>
 #include <sys/time.h>
@@ -122,7 +124,12 @@ bool Aircraft::parse_home(const char *home_str, Location &loc, float &yaw_degree
 bool Aircraft::on_ground(const Vector3f &pos)
 {
     float h1, h2;
-    if (sitl->terrain_enable && terrain &&
+    if (sitl->terrain_enable &&
+        SRTM::height_amsl(home.lat, home.lng, h1) &&
+        SRTM::height_amsl(location.lat, location.lng, h2)) {
+        // simulator terrain, independent of what the vehicle has loaded
+        ground_height_difference = h2 - h1;
+    } else if (sitl->terrain_enable && terrain &&
         terrain->height_amsl(home, h1, false) &&
         terrain->height_amsl(location, h2, false)) {
         ground_height_difference = h2 - h1;
@@ -130,6 +137,35 @@ bool Aircraft::on_ground(const Vector3f &pos)
     return (-pos.z) + home.alt*0.01f <= ground_level + frame_height + ground_height_difference;
 }
 
+void Aircraft::get_snapshot(struct snapshot &s) const
+{
+    s.time_now_us = time_now_us;
+    s.location = location;
+    s.position = position;
+    s.velocity_ef = velocity_ef;
+    s.dcm = dcm;
+    s.gyro = gyro;
+    s.accel_body = accel_body;
+}
+
+void Aircraft::set_snapshot(const struct snapshot &s, bool restore_clock)
+{
+    if (restore_clock) {
+        time_now_us = s.time_now_us;
+        last_time_us = time_now_us;
+        // start the sensor smoothing again from the new state
+        smoothing.last_update_us = 0;
+    }
+    location = s.location;
+    position = s.position;
+    velocity_ef = s.velocity_ef;
+    dcm = s.dcm;
+    gyro = s.gyro;
+    accel_body = s.accel_body;
+    velocity_air_ef = velocity_ef - wind_ef;
+    velocity_air_bf = dcm.transposed() * velocity_air_ef;
+}
+
 /*
    update location from position
 */
@@ -271,39 +307,11 @@ void Aircraft::add_noise(float throttle)
 }
 
 /*
-  normal distribution random numbers
-  See
-  http://en.literateprograms.org/index.php?title=Special:DownloadCode/Box-Muller_transform_%28C%29&oldid=7011
+  normal distribution random numbers, from the shared noise tables
 */
 double Aircraft::rand_normal(double mean, double stddev)
 {
-    static double n2 = 0.0;
-    static int n2_cached = 0;
-    if (!n2_cached)
-    {
-        double x, y, r;
-        do
-        {
-            x = 2.0*rand()/RAND_MAX - 1;
-            y = 2.0*rand()/RAND_MAX - 1;
-
-            r = x*x + y*y;
-        }
-        while (is_zero(r) || r > 1.0);
-        {
-            double d = sqrt(-2.0*log(r)/r);
-            double n1 = x*d;
-            n2 = y*d;
-            double result = n1*stddev + mean;
-            n2_cached = 1;
-            return result;
-        }
-    }
-    else
-    {
-        n2_cached = 0;
-        return n2*stddev + mean;
-    }
+    return Noise::rand_normal()*stddev + mean;
 }
 
 
@@ -399,8 +407,11 @@ void Aircraft::set_speedup(float speedup)
  */
 void Aircraft::update_dynamics(const Vector3f &rot_accel)
 {
-    float delta_time = frame_time_us * 1.0e-6f;
-    
+    update_dynamics(rot_accel, frame_time_us * 1.0e-6f);
+}
+
+void Aircraft::update_dynamics(const Vector3f &rot_accel, float delta_time)
+{
     // update rotational rates in body frame
     gyro += rot_accel * delta_time;
 
@@ -493,6 +504,16 @@ void Aircraft::update_dynamics(const Vector3f &rot_accel)
     }
 }
 
+/*
+  number of physics steps per frame. Models that support it step
+  their forces and dynamics this many times per frame, so the physics
+  can run faster than the rate the sensors are sampled at
+ */
+uint8_t Aircraft::get_physics_steps(void) const
+{
+    return constrain_int16(sitl->physics_steps, 1, 50);
+}
+
 /*
   update wind vector
 */
@@ -502,6 +523,16 @@ void Aircraft::update_wind(const struct sitl_input &input)
     wind_ef = Vector3f(cosf(radians(input.wind.direction)), sinf(radians(input.wind.direction)), 0) * input.wind.speed;
 }
 
+/*
+  interpolate between the SW, SE, NE and NW corners of a grid cell
+ */
+static float bilinear(const float data[4], float lat_frac, float lon_frac)
+{
+    const float data_min = lon_frac * (data[1] - data[0]) + data[0];
+    const float data_max = lon_frac * (data[2] - data[3]) + data[3];
+    return lat_frac * (data_max - data_min) + data_min;
+}
+
 /*
  calculate magnetic field intensity and orientation
 */
@@ -538,51 +569,30 @@ bool Aircraft::get_mag_field_ef(float latitude_deg, float longitude_deg, float &
         valid_input_data = false;
     }
 
-    /* find index of nearest low sampling point */
-    unsigned min_lat_index = (-(SAMPLING_MIN_LAT) + min_lat)  / SAMPLING_RES;
-    unsigned min_lon_index = (-(SAMPLING_MIN_LON) + min_lon) / SAMPLING_RES;
-
-    /* calculate intensity */
-
-    float data_sw = intensity_table[min_lat_index][min_lon_index];
-    float data_se = intensity_table[min_lat_index][min_lon_index + 1];;
-    float data_ne = intensity_table[min_lat_index + 1][min_lon_index + 1];
-    float data_nw = intensity_table[min_lat_index + 1][min_lon_index];
-
-    /* perform bilinear interpolation on the four grid corners */
-
-    float data_min = ((longitude_deg - min_lon) / SAMPLING_RES) * (data_se - data_sw) + data_sw;
-    float data_max = ((longitude_deg - min_lon) / SAMPLING_RES) * (data_ne - data_nw) + data_nw;
-
-    intensity_gauss = ((latitude_deg - min_lat) / SAMPLING_RES) * (data_max - data_min) + data_min;
-
-    /* calculate declination */
-
-    data_sw = declination_table[min_lat_index][min_lon_index];
-    data_se = declination_table[min_lat_index][min_lon_index + 1];;
-    data_ne = declination_table[min_lat_index + 1][min_lon_index + 1];
-    data_nw = declination_table[min_lat_index + 1][min_lon_index];
-
-    /* perform bilinear interpolation on the four grid corners */
-
-    data_min = ((longitude_deg - min_lon) / SAMPLING_RES) * (data_se - data_sw) + data_sw;
-    data_max = ((longitude_deg - min_lon) / SAMPLING_RES) * (data_ne - data_nw) + data_nw;
-
-    declination_deg = ((latitude_deg - min_lat) / SAMPLING_RES) * (data_max - data_min) + data_min;
-
-    /* calculate inclination */
-
-    data_sw = inclination_table[min_lat_index][min_lon_index];
-    data_se = inclination_table[min_lat_index][min_lon_index + 1];;
-    data_ne = inclination_table[min_lat_index + 1][min_lon_index + 1];
-    data_nw = inclination_table[min_lat_index + 1][min_lon_index];
+    if (!mag_cell.loaded || min_lat != mag_cell.min_lat || min_lon != mag_cell.min_lon) {
+        /* find index of nearest low sampling point */
+        unsigned min_lat_index = (-(SAMPLING_MIN_LAT) + min_lat)  / SAMPLING_RES;
+        unsigned min_lon_index = (-(SAMPLING_MIN_LON) + min_lon) / SAMPLING_RES;
+
+        const unsigned lat_index[4] = { min_lat_index, min_lat_index, min_lat_index + 1, min_lat_index + 1 };
+        const unsigned lon_index[4] = { min_lon_index, min_lon_index + 1, min_lon_index + 1, min_lon_index };
+        for (uint8_t i=0; i<4; i++) {
+            mag_cell.intensity[i] = intensity_table[lat_index[i]][lon_index[i]];
+            mag_cell.declination[i] = declination_table[lat_index[i]][lon_index[i]];
+            mag_cell.inclination[i] = inclination_table[lat_index[i]][lon_index[i]];
+        }
+        mag_cell.min_lat = min_lat;
+        mag_cell.min_lon = min_lon;
+        mag_cell.loaded = true;
+    }
 
     /* perform bilinear interpolation on the four grid corners */
+    const float lat_frac = (latitude_deg - min_lat) / SAMPLING_RES;
+    const float lon_frac = (longitude_deg - min_lon) / SAMPLING_RES;
 
-    data_min = ((longitude_deg - min_lon) / SAMPLING_RES) * (data_se - data_sw) + data_sw;
-    data_max = ((longitude_deg - min_lon) / SAMPLING_RES) * (data_ne - data_nw) + data_nw;
-
-    inclination_deg = ((latitude_deg - min_lat) / SAMPLING_RES) * (data_max - data_min) + data_min;
+    intensity_gauss = bilinear(mag_cell.intensity, lat_frac, lon_frac);
+    declination_deg = bilinear(mag_cell.declination, lat_frac, lon_frac);
+    inclination_deg = bilinear(mag_cell.inclination, lat_frac, lon_frac);
 
     return valid_input_data;
 
@@ -50,6 +50,15 @@ public:
      */
     void set_speedup(float speedup);
 
+    /*
+      enable or disable pacing of the simulation against the wall
+      clock. With it disabled the simulation runs as fast as the CPU
+      allows, with time only advanced by physics steps
+     */
+    void set_time_sync(bool enable) {
+        use_time_sync = enable;
+    }
+
     /*
       set instance number
      */
@@ -103,6 +112,28 @@ public:
     const Vector3f &get_mag_field_bf(void) const {
         return mag_bf;
     }
+
+    /*
+      kinematic state and clock of the simulation, as saved in SITL
+      snapshot files
+     */
+    struct snapshot {
+        uint64_t time_now_us;
+        Location location;
+        Vector3f position;
+        Vector3f velocity_ef;
+        Matrix3f dcm;
+        Vector3f gyro;
+        Vector3f accel_body;
+    };
+
+    // get the current state for a snapshot
+    void get_snapshot(struct snapshot &s) const;
+
+    // move the aircraft to the state of a snapshot. The clock is only
+    // set when restore_clock is true, as it can't go backwards once
+    // the vehicle is running
+    void set_snapshot(const struct snapshot &s, bool restore_clock);
     
 protected:
     SITL *sitl;
@@ -191,6 +222,10 @@ protected:
 
     // update attitude and relative position
     void update_dynamics(const Vector3f &rot_accel);
+    void update_dynamics(const Vector3f &rot_accel, float delta_time);
+
+    // number of physics steps per frame, from SIM_PHYS_STEPS
+    uint8_t get_physics_steps(void) const;
 
     // update wind vector
     void update_wind(const struct sitl_input &input);
@@ -211,6 +246,18 @@ protected:
     float filtered_servo_range(const struct sitl_input &input, uint8_t idx);
     
 private:
+    // table values at the SW, SE, NE and NW corners of the grid cell
+    // last used by get_mag_field_ef(), reloaded when the vehicle
+    // leaves the cell
+    struct {
+        bool loaded;
+        int min_lat;
+        int min_lon;
+        float intensity[4];
+        float declination[4];
+        float inclination[4];
+    } mag_cell {};
+
     uint64_t last_time_us = 0;
     uint32_t frame_counter = 0;
     uint32_t last_ground_contact_ms;
@@ -152,6 +152,24 @@ void Frame::init(float _mass, float hover_throttle, float _terminal_velocity, fl
 
     terminal_velocity = _terminal_velocity;
     terminal_rotation_rate = _terminal_rotation_rate;
+
+    // same fudge factors as Motor::calculate_forces()
+    const float arm_scale = radians(5000);
+    const float yaw_scale = radians(400);
+
+    fixed.count = 0;
+    for (uint8_t i=0; i<num_motors; i++) {
+        const Motor &m = motors[i];
+        per_motor[i] = (i >= SITL_FRAME_MAX_MOTORS || m.roll_servo >= 0 || m.pitch_servo >= 0);
+        if (per_motor[i]) {
+            continue;
+        }
+        const uint8_t n = fixed.count++;
+        fixed.servo[n] = m.servo;
+        fixed.arm_x[n] = arm_scale * cosf(radians(m.angle));
+        fixed.arm_y[n] = arm_scale * sinf(radians(m.angle));
+        fixed.yaw[n] = m.yaw_factor * yaw_scale;
+    }
 }
 
 /*
@@ -176,7 +194,25 @@ void Frame::calculate_forces(const Aircraft &aircraft,
 {
     Vector3f thrust; // newtons
 
+    // fixed motors: gather the speeds then sum all the terms in one pass
+    for (uint8_t n=0; n<fixed.count; n++) {
+        fixed.speed[n] = constrain_float((input.servos[motor_offset+fixed.servo[n]]-1100)/900.0f, 0, 1);
+    }
+    float roll = 0, pitch = 0, yaw = 0, lift = 0;
+    for (uint8_t n=0; n<fixed.count; n++) {
+        const float s = fixed.speed[n];
+        roll  -= fixed.arm_y[n] * s;
+        pitch += fixed.arm_x[n] * s;
+        yaw   += fixed.yaw[n] * s;
+        lift  += s;
+    }
+    rot_accel += Vector3f(roll, pitch, yaw);
+    thrust.z -= lift * thrust_scale;
+
     for (uint8_t i=0; i<num_motors; i++) {
+        if (!per_motor[i]) {
+            continue;
+        }
         Vector3f mraccel, mthrust;
         motors[i].calculate_forces(input, thrust_scale, motor_offset, mraccel, mthrust);
         rot_accel += mraccel;
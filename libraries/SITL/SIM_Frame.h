@@ -21,6 +21,9 @@
 #include "SIM_Aircraft.h"
 #include "SIM_Motor.h"
 
+// most motors handled by the vectorised force model
+#define SITL_FRAME_MAX_MOTORS 12
+
 namespace SITL {
 
 /*
@@ -56,5 +59,25 @@ public:
     float thrust_scale;
     float mass;
     uint8_t motor_offset;
+
+private:
+    /*
+      model of the motors that can't tilt, as one array per term so
+      calculate_forces() sums them all in a single loop the compiler
+      can vectorise. Each motor's rotational accel per unit of motor
+      speed is (-arm_y, arm_x, yaw) and its thrust is straight up.
+      Tilting motors are left to Motor::calculate_forces()
+     */
+    struct {
+        uint8_t count;
+        uint8_t servo[SITL_FRAME_MAX_MOTORS];
+        float arm_x[SITL_FRAME_MAX_MOTORS];
+        float arm_y[SITL_FRAME_MAX_MOTORS];
+        float yaw[SITL_FRAME_MAX_MOTORS];
+        float speed[SITL_FRAME_MAX_MOTORS];
+    } fixed;
+
+    // true for motors not included in the fixed model
+    bool per_motor[SITL_FRAME_MAX_MOTORS];
 };
 }
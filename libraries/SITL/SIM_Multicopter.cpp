@@ -55,11 +55,16 @@ void MultiCopter::update(const struct sitl_input &input)
     // get wind vector setup
     update_wind(input);
 
-    Vector3f rot_accel;
+    const uint8_t steps = get_physics_steps();
+    const float delta_time = frame_time_us * 1.0e-6f / steps;
 
-    calculate_forces(input, rot_accel, accel_body);
+    for (uint8_t i=0; i<steps; i++) {
+        Vector3f rot_accel;
 
-    update_dynamics(rot_accel);
+        calculate_forces(input, rot_accel, accel_body);
+
+        update_dynamics(rot_accel, delta_time);
+    }
 
     // update lat/lon/altitude
     update_position();
@@ -0,0 +1,84 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  noise source for simulated sensors
+*/
+
+#include "SIM_Noise.h"
+
+namespace SITL {
+
+float Noise::uniform[NOISE_BLOCK_SIZE];
+uint16_t Noise::uniform_next = NOISE_BLOCK_SIZE;
+uint32_t Noise::lane_state[NOISE_LANES] = {
+    0x9E3779B9, 0x7F4A7C15, 0x85EBCA6B, 0xC2B2AE35,
+    0x27D4EB2F, 0x165667B1, 0xD3A2646C, 0xFD7046C5
+};
+float *Noise::normal_table;
+
+/*
+  generate the next block of uniform samples
+ */
+void Noise::refill_uniform(void)
+{
+    for (uint16_t i=0; i<NOISE_BLOCK_SIZE; i += NOISE_LANES) {
+        for (uint8_t k=0; k<NOISE_LANES; k++) {
+            uint32_t x = lane_state[k];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            lane_state[k] = x;
+            uniform[i+k] = (int32_t)x * (1.0f / 2147483648.0f);
+        }
+    }
+    uniform_next = 0;
+}
+
+/*
+  fill the normal table using the Box-Muller transform on the uniform
+  samples. Done once, on first use
+ */
+void Noise::fill_normal_table(void)
+{
+    normal_table = new float[NORMAL_TABLE_SIZE];
+    if (normal_table == nullptr) {
+        return;
+    }
+    for (uint16_t i=0; i<NORMAL_TABLE_SIZE; i += 2) {
+        float x, y, r;
+        do {
+            x = rand_float();
+            y = rand_float();
+            r = x*x + y*y;
+        } while (is_zero(r) || r > 1.0f);
+        const float d = sqrtf(-2.0f*logf(r)/r);
+        normal_table[i] = x*d;
+        normal_table[i+1] = y*d;
+    }
+}
+
+float Noise::rand_normal(void)
+{
+    if (normal_table == nullptr) {
+        fill_normal_table();
+        if (normal_table == nullptr) {
+            return 0;
+        }
+    }
+    const uint16_t idx = (uint32_t)((rand_float() + 1.0f) * 0.5f * NORMAL_TABLE_SIZE) & (NORMAL_TABLE_SIZE-1);
+    return normal_table[idx];
+}
+
+} // namespace SITL
@@ -0,0 +1,74 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  noise source for simulated sensors
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <AP_Math/AP_Math.h>
+
+namespace SITL {
+
+/*
+  random numbers for sensor noise, taken from blocks generated in one
+  pass rather than one library call per sample. The generator is
+  seeded with a constant, so a lockstep run sees the same noise every
+  time
+ */
+class Noise {
+public:
+    // uniform random number between -1 and 1
+    static float rand_float(void) {
+        if (uniform_next >= NOISE_BLOCK_SIZE) {
+            refill_uniform();
+        }
+        return uniform[uniform_next++];
+    }
+
+    // random vector with each element between -1 and 1
+    static Vector3f rand_vec3f(void) {
+        const float x = rand_float();
+        const float y = rand_float();
+        return Vector3f(x, y, rand_float());
+    }
+
+    // normally distributed random number with mean 0 and standard
+    // deviation 1
+    static float rand_normal(void);
+
+private:
+    static const uint16_t NOISE_BLOCK_SIZE = 1024;
+    static const uint8_t NOISE_LANES = 8;
+    static const uint16_t NORMAL_TABLE_SIZE = 4096;
+
+    static void refill_uniform(void);
+    static void fill_normal_table(void);
+
+    // next block of uniform samples
+    static float uniform[NOISE_BLOCK_SIZE];
+    static uint16_t uniform_next;
+
+    // independent xorshift generators, stepped together so the
+    // compiler can vectorise the refill
+    static uint32_t lane_state[NOISE_LANES];
+
+    // normally distributed samples, picked from at random
+    static float *normal_table;
+};
+
+} // namespace SITL
@@ -0,0 +1,217 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  flight dynamics model in a shared library, or in another process
+  through shared memory
+*/
+
+#include "SIM_Plugin.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(HAVE_LIBDL)
+#include <dlfcn.h>
+#endif
+
+#include <AP_HAL/AP_HAL.h>
+
+extern const AP_HAL::HAL& hal;
+
+namespace SITL {
+
+Plugin::Plugin(const char *home_str, const char *frame_str) :
+    Aircraft(home_str, frame_str),
+    library(nullptr),
+    plugin(nullptr),
+    handle(nullptr),
+    shm(nullptr),
+    last_fdm_time_us(0)
+{
+    if (strncmp(frame_str, "shm:", 4) == 0) {
+        open_shm(frame_str + 4);
+    } else if (strncmp(frame_str, "plugin:", 7) == 0) {
+        open_library(frame_str + 7);
+    } else {
+        AP_HAL::panic("Plugin model must be plugin:LIBRARY[:ARGS] or shm:NAME");
+    }
+}
+
+Plugin::~Plugin()
+{
+    if (plugin != nullptr && handle != nullptr) {
+        plugin->destroy(handle);
+    }
+#if defined(HAVE_LIBDL)
+    if (library != nullptr) {
+        dlclose(library);
+    }
+#endif
+    if (shm != nullptr) {
+        munmap(shm, sizeof(*shm));
+    }
+}
+
+/*
+  load LIBRARY[:ARGS] and create the model, passing it ARGS
+ */
+void Plugin::open_library(const char *spec)
+{
+#if defined(HAVE_LIBDL)
+    char path[256];
+    const char *args = strchr(spec, ':');
+    size_t len = args ? (size_t)(args - spec) : strlen(spec);
+    if (len >= sizeof(path)) {
+        AP_HAL::panic("Plugin path too long");
+    }
+    memcpy(path, spec, len);
+    path[len] = 0;
+    args = args ? args + 1 : "";
+
+    library = dlopen(path, RTLD_NOW);
+    if (library == nullptr) {
+        AP_HAL::panic("dlopen(%s) -> %s", path, dlerror());
+    }
+    sitl_plugin_get_fn get = (sitl_plugin_get_fn)dlsym(library, "sitl_plugin_get");
+    if (get == nullptr) {
+        AP_HAL::panic("%s has no sitl_plugin_get", path);
+    }
+    plugin = get();
+    if (plugin == nullptr || plugin->api_version != SITL_PLUGIN_API_VERSION) {
+        AP_HAL::panic("%s was built for a different plugin API", path);
+    }
+    handle = plugin->create(args);
+    if (handle == nullptr) {
+        AP_HAL::panic("%s failed to create model '%s'", path, args);
+    }
+    printf("Loaded FDM plugin %s\n", path);
+#else
+    AP_HAL::panic("Plugin models need libdl");
+#endif
+}
+
+/*
+  create the shared memory region a simulator process attaches to
+ */
+void Plugin::open_shm(const char *name)
+{
+    int fd = shm_open(name, O_RDWR|O_CREAT, 0600);
+    if (fd == -1) {
+        AP_HAL::panic("shm_open(%s) failed", name);
+    }
+    if (ftruncate(fd, sizeof(*shm)) != 0) {
+        AP_HAL::panic("Unable to size shared memory %s", name);
+    }
+    void *p = mmap(nullptr, sizeof(*shm), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        AP_HAL::panic("Unable to map shared memory %s", name);
+    }
+    shm = (struct sitl_plugin_shm *)p;
+    memset(shm, 0, sizeof(*shm));
+    shm->api_version = SITL_PLUGIN_API_VERSION;
+    __atomic_store_n(&shm->magic, SITL_PLUGIN_SHM_MAGIC, __ATOMIC_RELEASE);
+    printf("Waiting for FDM on shared memory %s\n", name);
+}
+
+bool Plugin::step_library(const struct sitl_plugin_input &in, struct sitl_plugin_fdm &fdm)
+{
+    return plugin->step(handle, &in, &fdm);
+}
+
+/*
+  hand the input to the simulator process and wait for its reply. The
+  reply normally comes within a few microseconds, so spin briefly
+  before giving up the CPU
+ */
+void Plugin::step_shm(const struct sitl_plugin_input &in, struct sitl_plugin_fdm &fdm)
+{
+    shm->input = in;
+    const uint32_t seq = __atomic_load_n(&shm->input_seq, __ATOMIC_RELAXED) + 1;
+    __atomic_store_n(&shm->input_seq, seq, __ATOMIC_RELEASE);
+
+    uint32_t spins = 0;
+    while (__atomic_load_n(&shm->fdm_seq, __ATOMIC_ACQUIRE) != seq) {
+        if (++spins > 1000) {
+            sched_yield();
+        }
+    }
+    fdm = shm->fdm;
+}
+
+/*
+  update the model by one time step
+ */
+void Plugin::update(const struct sitl_input &input)
+{
+    struct sitl_plugin_input in;
+    in.time_us = time_now_us;
+    memcpy(in.servos, input.servos, sizeof(in.servos));
+    in.wind_speed = input.wind.speed;
+    in.wind_direction = input.wind.direction;
+    in.wind_turbulence = input.wind.turbulence;
+
+    struct sitl_plugin_fdm fdm;
+    if (shm != nullptr) {
+        step_shm(in, fdm);
+    } else if (!step_library(in, fdm)) {
+        AP_HAL::panic("FDM plugin step failed");
+    }
+
+    accel_body = Vector3f(fdm.accel_body[0], fdm.accel_body[1], fdm.accel_body[2]);
+    gyro = Vector3f(fdm.gyro_body[0], fdm.gyro_body[1], fdm.gyro_body[2]);
+
+    Quaternion quat(fdm.quaternion[0], fdm.quaternion[1],
+                    fdm.quaternion[2], fdm.quaternion[3]);
+    quat.rotation_matrix(dcm);
+
+    velocity_ef = Vector3f(fdm.velocity_ned[0], fdm.velocity_ned[1], fdm.velocity_ned[2]);
+    position = Vector3f(fdm.position_ned[0], fdm.position_ned[1], fdm.position_ned[2]);
+
+    update_wind(input);
+    velocity_air_ef = velocity_ef - wind_ef;
+    velocity_air_bf = dcm.transposed() * velocity_air_ef;
+    if (fdm.airspeed >= 0) {
+        airspeed = fdm.airspeed;
+    } else {
+        airspeed = velocity_air_ef.length();
+    }
+    airspeed_pitot = airspeed;
+
+    rpm1 = fdm.rpm[0];
+    rpm2 = fdm.rpm[1];
+    battery_voltage = fdm.battery_voltage;
+    battery_current = fdm.battery_current;
+
+    // follow the model's clock, and its frame rate
+    if (last_fdm_time_us != 0 && fdm.time_us > last_fdm_time_us) {
+        const uint64_t deltat_us = fdm.time_us - last_fdm_time_us;
+        time_now_us += deltat_us;
+        if (deltat_us < 10000) {
+            adjust_frame_time(1.0e6f / deltat_us);
+        }
+    }
+    last_fdm_time_us = fdm.time_us;
+
+    update_position();
+
+    // update magnetic field
+    update_mag_field_bf();
+}
+
+} // namespace SITL
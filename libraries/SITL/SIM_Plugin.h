@@ -0,0 +1,63 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  flight dynamics model in a shared library, or in another process
+  through shared memory, see SIM_Plugin_API.h
+*/
+
+#pragma once
+
+#include "SIM_Aircraft.h"
+#include "SIM_Plugin_API.h"
+
+namespace SITL {
+
+/*
+  model stepped without a socket round trip. The model string is
+  either plugin:LIBRARY[:ARGS] or shm:NAME
+ */
+class Plugin : public Aircraft {
+public:
+    Plugin(const char *home_str, const char *frame_str);
+    ~Plugin();
+
+    /* update model by one time step */
+    void update(const struct sitl_input &input);
+
+    /* static object creator */
+    static Aircraft *create(const char *home_str, const char *frame_str) {
+        return new Plugin(home_str, frame_str);
+    }
+
+private:
+    void open_library(const char *spec);
+    void open_shm(const char *name);
+
+    // fill fdm from the model, false if the model failed
+    bool step_library(const struct sitl_plugin_input &in, struct sitl_plugin_fdm &fdm);
+    void step_shm(const struct sitl_plugin_input &in, struct sitl_plugin_fdm &fdm);
+
+    // shared library plugin
+    void *library;
+    const struct sitl_plugin *plugin;
+    void *handle;
+
+    // shared memory region
+    struct sitl_plugin_shm *shm;
+
+    uint64_t last_fdm_time_us;
+};
+
+} // namespace SITL
@@ -0,0 +1,102 @@
+/*
+  this defines the interface between SITL and in-process or shared
+  memory flight dynamics models.
+
+  The structures don't depend on other headers inside ArduPilot, so a
+  simulator can include this file on its own, although they do depend
+  on the general ABI of the platform.
+
+  A shared library plugin exports sitl_plugin_get(), returning a
+  struct sitl_plugin. SITL calls step() once per frame with the servo
+  outputs and the plugin fills in the new state.
+
+  An out-of-process simulator instead maps a struct sitl_plugin_shm
+  created by SITL in POSIX shared memory. SITL writes input and then
+  increments input_seq; the simulator steps, writes fdm and then sets
+  fdm_seq to input_seq. Both sequence numbers must be accessed with
+  acquire/release atomics.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SITL_PLUGIN_API_VERSION 1
+#define SITL_PLUGIN_SHM_MAGIC   0x46444D31
+
+/*
+  input to the model for one frame
+ */
+struct sitl_plugin_input {
+    // simulation time at the start of the frame in microseconds
+    uint64_t time_us;
+
+    // servo outputs in PWM microseconds
+    uint16_t servos[16];
+
+    // wind from the SIM_WIND_* parameters
+    float wind_speed;       // m/s
+    float wind_direction;   // degrees 0..360
+    float wind_turbulence;
+};
+
+/*
+  state of the model at the end of a frame. Position is relative to
+  the home location given on the SITL command line
+ */
+struct sitl_plugin_fdm {
+    // simulation time at the end of the frame in microseconds. Must
+    // advance on every step
+    uint64_t time_us;
+
+    double position_ned[3];     // m
+    double velocity_ned[3];     // m/s
+    // attitude, first element is the length scalar
+    double quaternion[4];
+    double gyro_body[3];        // rad/s
+    double accel_body[3];       // m/s/s, specific force
+    double airspeed;            // m/s, negative if not simulated
+    double rpm[2];
+    double battery_voltage;     // V, negative if not simulated
+    double battery_current;     // A
+};
+
+/*
+  shared library interface. create() is given the part of the model
+  string after the library path and returns an opaque handle, or NULL
+  on failure
+ */
+struct sitl_plugin {
+    // SITL_PLUGIN_API_VERSION the plugin was built against
+    uint32_t api_version;
+
+    void *(*create)(const char *args);
+    bool (*step)(void *handle, const struct sitl_plugin_input *input, struct sitl_plugin_fdm *fdm);
+    void (*destroy)(void *handle);
+};
+
+typedef const struct sitl_plugin *(*sitl_plugin_get_fn)(void);
+
+/*
+  shared memory interface
+ */
+struct sitl_plugin_shm {
+    // SITL_PLUGIN_SHM_MAGIC and SITL_PLUGIN_API_VERSION, set by SITL
+    uint32_t magic;
+    uint32_t api_version;
+
+    uint32_t input_seq;
+    uint32_t fdm_seq;
+
+    struct sitl_plugin_input input;
+    struct sitl_plugin_fdm fdm;
+};
+
+#ifdef __cplusplus
+}
+#endif
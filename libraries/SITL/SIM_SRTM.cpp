@@ -0,0 +1,176 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator terrain from a shared cache of SRTM tiles
+*/
+
+#include "SIM_SRTM.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace SITL;
+
+// marks a void in the SRTM data
+#define SRTM_VOID -32768
+
+struct SRTM::tile SRTM::tiles[SITL_SRTM_MAX_TILES];
+uint8_t SRTM::num_tiles;
+uint32_t SRTM::access_counter;
+
+const char *SRTM::directory(void)
+{
+    static const char *dir = getenv("SITL_SRTM_DIR");
+    return dir;
+}
+
+bool SRTM::available(void)
+{
+    return directory() != nullptr;
+}
+
+/*
+  map the tile file for t, leaving data NULL if there is none so the
+  miss is remembered rather than retried on every lookup
+ */
+void SRTM::load_tile(struct tile &t)
+{
+    t.data = nullptr;
+    t.samples = 0;
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%c%02u%c%03u.hgt",
+             directory(),
+             t.lat_degrees < 0 ? 'S' : 'N', (unsigned)abs(t.lat_degrees),
+             t.lon_degrees < 0 ? 'W' : 'E', (unsigned)abs(t.lon_degrees));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return;
+    }
+    // square tile of 16 bit samples
+    const uint16_t samples = sqrtf(st.st_size / 2);
+    if (samples < 2 || (off_t)samples * samples * 2 != st.st_size) {
+        ::printf("SRTM: bad tile size %s\n", path);
+        close(fd);
+        return;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return;
+    }
+    t.data = (const uint8_t *)p;
+    t.samples = samples;
+}
+
+/*
+  find a tile, mapping it if needed. The least recently used tile is
+  unmapped when the table is full
+ */
+const struct SRTM::tile *SRTM::find_tile(int16_t lat_degrees, int16_t lon_degrees)
+{
+    access_counter++;
+    for (uint8_t i=0; i<num_tiles; i++) {
+        if (tiles[i].lat_degrees == lat_degrees && tiles[i].lon_degrees == lon_degrees) {
+            tiles[i].last_access = access_counter;
+            return &tiles[i];
+        }
+    }
+
+    uint8_t idx = num_tiles;
+    if (num_tiles < SITL_SRTM_MAX_TILES) {
+        num_tiles++;
+    } else {
+        idx = 0;
+        for (uint8_t i=1; i<num_tiles; i++) {
+            if (tiles[i].last_access < tiles[idx].last_access) {
+                idx = i;
+            }
+        }
+        if (tiles[idx].data != nullptr) {
+            munmap((void *)tiles[idx].data, (size_t)tiles[idx].samples * tiles[idx].samples * 2);
+        }
+    }
+
+    struct tile &t = tiles[idx];
+    t.lat_degrees = lat_degrees;
+    t.lon_degrees = lon_degrees;
+    t.last_access = access_counter;
+    load_tile(t);
+    return &t;
+}
+
+bool SRTM::sample(const struct tile &t, uint16_t row, uint16_t col, float &height)
+{
+    const uint8_t *b = &t.data[((uint32_t)row * t.samples + col) * 2];
+    const int16_t v = (int16_t)((b[0] << 8) | b[1]);
+    if (v == SRTM_VOID) {
+        return false;
+    }
+    height = v;
+    return true;
+}
+
+bool SRTM::height_amsl(int32_t lat, int32_t lng, float &height)
+{
+    if (!available()) {
+        return false;
+    }
+    const double lat_deg = lat * 1.0e-7;
+    const double lon_deg = lng * 1.0e-7;
+    const int16_t lat_degrees = floor(lat_deg);
+    const int16_t lon_degrees = floor(lon_deg);
+
+    const struct tile *t = find_tile(lat_degrees, lon_degrees);
+    if (t->data == nullptr) {
+        return false;
+    }
+
+    // rows run north to south, columns west to east
+    const float y = (1.0 - (lat_deg - lat_degrees)) * (t->samples - 1);
+    const float x = (lon_deg - lon_degrees) * (t->samples - 1);
+    uint16_t row = y;
+    uint16_t col = x;
+    if (row >= t->samples - 1) {
+        row = t->samples - 2;
+    }
+    if (col >= t->samples - 1) {
+        col = t->samples - 2;
+    }
+    const float fy = y - row;
+    const float fx = x - col;
+
+    float h00, h01, h10, h11;
+    if (!sample(*t, row,   col,   h00) ||
+        !sample(*t, row,   col+1, h01) ||
+        !sample(*t, row+1, col,   h10) ||
+        !sample(*t, row+1, col+1, h11)) {
+        return false;
+    }
+    const float north = h00 + (h01 - h00) * fx;
+    const float south = h10 + (h11 - h10) * fx;
+    height = north + (south - north) * fy;
+    return true;
+}
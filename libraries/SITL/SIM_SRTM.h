@@ -0,0 +1,67 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator terrain from a shared cache of SRTM tiles
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// number of tiles kept mapped at once
+#define SITL_SRTM_MAX_TILES 16
+
+namespace SITL {
+
+/*
+  terrain heights read straight from uncompressed SRTM .hgt tiles
+  (e.g. S36E149.hgt, 3 or 1 arc-second) in the directory named by the
+  SITL_SRTM_DIR environment variable. Tiles are mapped read-only and
+  shared, so every vehicle reading the same cache shares one copy in
+  the page cache and nothing is copied or converted up front.
+
+  This backs both the simulated ground height and, through
+  AP_Terrain, the vehicle's terrain database, so SITL vehicles don't
+  need to stream terrain from the GCS. Only used from the main thread
+ */
+class SRTM {
+public:
+    // true if a tile directory has been configured
+    static bool available(void);
+
+    // terrain height in meters AMSL at a location in degrees*1e7,
+    // false if there is no tile covering it
+    static bool height_amsl(int32_t lat, int32_t lng, float &height);
+
+private:
+    struct tile {
+        int16_t lat_degrees;    // south west corner
+        int16_t lon_degrees;
+        const uint8_t *data;    // big-endian samples, north row first.  NULL if no tile
+        uint16_t samples;       // per side
+        uint32_t last_access;
+    };
+
+    static const char *directory(void);
+    static const struct tile *find_tile(int16_t lat_degrees, int16_t lon_degrees);
+    static void load_tile(struct tile &t);
+    static bool sample(const struct tile &t, uint16_t row, uint16_t col, float &height);
+
+    static struct tile tiles[SITL_SRTM_MAX_TILES];
+    static uint8_t num_tiles;
+    static uint32_t access_counter;
+};
+
+}